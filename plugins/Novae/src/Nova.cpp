@@ -52,6 +52,7 @@ Nova::Nova(const QVariantMap& map)
 	, RA(0.)
 	, Dec(0.)
 	, distance(0.)
+	, lightCurveIndex(-1)
 {
 	if (!map.contains("designation") || !map.contains("RA") || !map.contains("Dec"))
 	{
@@ -199,117 +200,9 @@ Vec3f Nova::getInfoColor(void) const
 
 float Nova::getVMagnitude(const StelCore* core) const
 {
-	// OK, start from minimal brightness
-	float vmag = minMagnitude;
-	double currentJD = core->getJDE();
-	float deltaJD = static_cast<float>(qAbs(peakJD-currentJD));
-    
-	// Fill "default" values for mX
-	int t2 = m2;
-	if (m2 < 0)
-	{
-		// m2 is unset, check type of nova
-		if (novaType.contains("NA", Qt::CaseSensitive))
-			t2 = 10; // Ok, "fast" nova
-
-		if (novaType.contains("NB", Qt::CaseSensitive))
-			t2 = 80; // Ok, "slow" nova
-
-		if (novaType.contains("NC", Qt::CaseSensitive))
-			t2 = 200; // Ok, "very slow" nova
-	}	
-
-	int t3 = m3;
-	if (m3 < 0)
-	{
-		// m3 is unset, check type of nova
-		if (novaType.contains("NA", Qt::CaseSensitive))
-			t3 = 30; // Ok, "fast" nova
-
-		if (novaType.contains("NB", Qt::CaseSensitive))
-			t3 = 160; // Ok, "slow" nova
-
-		if (novaType.contains("NC", Qt::CaseSensitive))
-			t3 = 300; // Ok, "very slow" nova
-	}	
-
-	int t6 = m6;
-	if (m6 < 0)
-	{
-		// m3 is unset, check type of nova
-		if (novaType.contains("NA", Qt::CaseSensitive))
-			t6 = 100; // Ok, "fast" nova
-
-		if (novaType.contains("NB", Qt::CaseSensitive))
-			t6 = 300; // Ok, "slow" nova
-
-		if (novaType.contains("NC", Qt::CaseSensitive))
-			t6 = 1200; // Ok, "very slow" nova
-	}	
-
-	int t9 = m9;
-	if (m9 < 0)
-	{
-		// m3 is unset, check type of nova
-		if (novaType.contains("NA", Qt::CaseSensitive))
-			t9 = 400; // Ok, "fast" nova
-
-		if (novaType.contains("NB", Qt::CaseSensitive))
-			t9 = 1000; // Ok, "slow" nova
-
-		if (novaType.contains("NC", Qt::CaseSensitive))
-			t9 = 3000; // Ok, "very slow" nova
-	}	
-
-	// Calculate light curve
-	if (peakJD<=currentJD)
-	{
-		float step;
-		float d2 = maxMagnitude+2.f;
-		float d3 = maxMagnitude+3.f;
-		float d6 = maxMagnitude+6.f;		
-
-		if (deltaJD>0 && deltaJD<=t2)
-		{
-			step = 2.f/t2;
-			vmag = maxMagnitude + step*deltaJD;
-		}
-
-		if (deltaJD>t2 && deltaJD<=t3)
-		{
-			step = 3.f/t3;
-			vmag = d2 + step*(deltaJD-t2);
-		}
-
-		if (deltaJD>t3 && deltaJD<=t6)
-		{
-			step = 6.f/t6;
-			vmag = d3 + step*(deltaJD-t3);
-		}
-
-		if (deltaJD>t6 && deltaJD<=t9)
-		{
-			step = 9.f/t9;
-			vmag = d6 + step*(deltaJD-t6);
-		}
-
-		if (deltaJD>t9)
-			vmag = minMagnitude;
-	}
-	else
-	{
-		int dt = 3;
-		if (deltaJD<=dt)
-		{
-			float step = (minMagnitude - maxMagnitude)/dt; // 3 days for outburst
-			vmag = maxMagnitude + step*deltaJD;
-		}
-	}
-
-	if (vmag>minMagnitude)
-		vmag = minMagnitude;
-
-	return vmag;
+	if (!photometry || lightCurveIndex<0)
+		return minMagnitude;
+	return photometry->getMagnitude(lightCurveIndex, core->getJDE());
 }
 
 double Nova::getAngularSize(const StelCore*) const
@@ -25,10 +25,12 @@
 #include <QFont>
 #include <QList>
 #include <QDateTime>
+#include <QSharedPointer>
 
 #include "StelObject.hpp"
 #include "StelFader.hpp"
 #include "StelProjectorType.hpp"
+#include "StelPhotometry.hpp"
 
 class StelPainter;
 
@@ -114,6 +116,9 @@ private:
 	double Dec;			//! Dec. for the nova
 	double distance;		//! Distance to nova (10^3 ly)
 
+	QSharedPointer<StelPhotometry> photometry;	//! The light curves of all the novae, evaluated once per frame by the Novae module
+	int lightCurveIndex;		//! Index of the light curve compiled from the type, the magnitudes and the decline times
+
 	LinearFader labelsFader;
 
 	QString getMaxBrightnessDate(const double JD) const;
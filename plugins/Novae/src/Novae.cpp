@@ -182,6 +182,12 @@ void Novae::init()
 	GETSTELMODULE(StelObjectMgr)->registerStelObjectMgr(this);
 }
 
+void Novae::update(double)
+{
+	if (photometry)
+		photometry->update(StelApp::getInstance().getCore()->getJDE());
+}
+
 /*
  Draw our module. This should print name of first Nova in the main window
 */
@@ -445,6 +451,7 @@ void Novae::setNovaeMap(const QVariantMap& map)
 	nova.clear();
 	novalist.clear();
 	NovaCnt=0;
+	photometry = QSharedPointer<StelPhotometry>(new StelPhotometry());
 	QVariantMap novaeMap = map.value("nova").toMap();
 	for (auto novaeKey : novaeMap.keys())
 	{
@@ -456,7 +463,11 @@ void Novae::setNovaeMap(const QVariantMap& map)
 
 		NovaP n(new Nova(novaeData));
 		if (n->initialized)
+		{
+			n->photometry = photometry;
+			n->lightCurveIndex = photometry->addNovaCurve(n->novaType, n->maxMagnitude, n->minMagnitude, n->peakJD, n->m2, n->m3, n->m6, n->m9);
 			nova.append(n);
+		}
 	}
 }
 
@@ -84,7 +84,7 @@ public:
 	///////////////////////////////////////////////////////////////////////////
 	// Methods defined in the StelModule class
 	virtual void init();
-	virtual void update(double) {;}
+	virtual void update(double deltaTime);
 	virtual void draw(StelCore* core);
 	virtual void drawPointer(StelCore* core, StelPainter& painter);
 	virtual double getCallOrder(StelModuleActionName actionName) const;
@@ -230,6 +230,9 @@ private:
 
 	StelTextureSP texPointer;
 	QList<NovaP> nova;
+	//! The light curves of the novae, evaluated once per frame. A new instance is made for each catalog,
+	//! because the novae of the previous catalog may still be referenced, e.g. as the selected object.
+	QSharedPointer<StelPhotometry> photometry;
 	QHash<QString, double> novalist;
 
 	// variables and functions for the updater
@@ -108,9 +108,9 @@ bool RemoteControl::configureGui(bool show)
 //! Determine which "layer" the plugin's drawing will happen on.
 double RemoteControl::getCallOrder(StelModuleActionName actionName) const
 {
-	// TODO: if there is any graphics, this may have to be adjusted. Else maybe even delete?
+	// The view is captured for the streams, so draw after all other modules
 	if (actionName==StelModule::ActionDraw)
-		return StelApp::getInstance().getModuleMgr().getModule("LandscapeMgr")->getCallOrder(actionName)+10.;
+		return StelApp::getInstance().getModuleMgr().getModule("LandscapeMgr")->getCallOrder(actionName)+1000.;
 	return 0;
 }
 
@@ -183,7 +183,7 @@ void RemoteControl::update(double deltaTime)
 //! Draw any parts on the screen which are for our module
 void RemoteControl::draw(StelCore* core)
 {
-	Q_UNUSED(core)
+	requestHandler->draw(core);
 }
 
 void RemoteControl::setFlagEnabled(bool b)
@@ -250,6 +250,7 @@ void RemoteControl::startServer()
 	settings.port = port;
 	settings.minThreads = minThreads;
 	settings.maxThreads = maxThreads;
+	requestHandler->startStreams();
 	httpListener = new HttpListener(settings,requestHandler);
 }
 
@@ -257,6 +258,8 @@ void RemoteControl::stopServer()
 {
 	if(httpListener)
 	{
+		//the worker threads can only finish after their streams ended
+		requestHandler->stopStreams();
 		delete httpListener;
 		httpListener = Q_NULLPTR;
 	}
@@ -28,6 +28,7 @@
 #include "ObjectService.hpp"
 #include "ScriptService.hpp"
 #include "SimbadService.hpp"
+#include "StreamController.hpp"
 #include "StelActionService.hpp"
 #include "StelPropertyService.hpp"
 #include "ViewService.hpp"
@@ -88,6 +89,7 @@ private:
 RequestHandler::RequestHandler(const StaticFileControllerSettings& settings, QObject* parent) : HttpRequestHandler(parent), usePassword(false), templateMutex(QMutex::Recursive)
 {
 	apiController = new APIController(QByteArray("/api/").size(),this);
+	streamController = new StreamController(QByteArray("/api/stream/").size(),this);
 
 	//register the services
 	//they "live" in the main thread in the QObject sense, but their service methods are actually
@@ -132,6 +134,21 @@ void RequestHandler::update(double deltaTime)
 	apiController->update(deltaTime);
 }
 
+void RequestHandler::draw(StelCore *core)
+{
+	streamController->captureFrame(core);
+}
+
+void RequestHandler::startStreams()
+{
+	streamController->start();
+}
+
+void RequestHandler::stopStreams()
+{
+	streamController->stop();
+}
+
 void RequestHandler::service(HttpRequest &request, HttpResponse &response)
 {
 #define SERVER_HEADER "Stellarium RemoteControl " REMOTECONTROL_PLUGIN_VERSION
@@ -159,7 +176,12 @@ void RequestHandler::service(HttpRequest &request, HttpResponse &response)
 	QByteArray path = request.getPath();
 	//qDebug()<<"Request path:"<<rawPath<<" decoded:"<<path;
 
-	if(path.startsWith("/api/"))
+	if(path.startsWith("/api/stream/"))
+	{
+		//streams keep this worker thread busy until the client disconnects
+		streamController->service(request,response);
+	}
+	else if(path.startsWith("/api/"))
 	{
 		//this is an API request, pass it on
 		apiController->service(request,response);
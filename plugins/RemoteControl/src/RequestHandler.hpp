@@ -24,6 +24,8 @@
 #include "httpserver/staticfilecontroller.h"
 
 class APIController;
+class StelCore;
+class StreamController;
 class StaticFileController;
 
 //! This is the main request handler for the remote control plugin, receiving and dispatching the HTTP requests.
@@ -43,12 +45,20 @@ public:
 
 	//! Called in the main thread each frame, only passed on to APIController::update
 	void update(double deltaTime);
+	//! Called in the main thread after the sky was drawn, only passed on to StreamController::captureFrame
+	void draw(StelCore* core);
+	//! Enables the streams, called before the server is started
+	void startStreams();
+	//! Ends all streams, must be called before the server is stopped. See StreamController::stop
+	void stopStreams();
 
 	//! Receives the HttpRequest from the HttpListener.
 	//! It checks the optional HTTP authentication and sets the keep-alive header if requested
 	//! by the client.
 	//!
 	//! If the authentication is correct, the request is processed according to the following rules:
+	//!  - If the request path starts with the string @c "/api/stream/", then the request is passed to
+	//! the \ref StreamController.
 	//!  - If the request path starts with the string @c "/api/", then the request is passed to
 	//! the \ref APIController without further processing.
 	//!  - If a file specified in the special \c translate_files file is requested, the cached translated version
@@ -82,6 +92,7 @@ private:
 	QString password;
 	QByteArray passwordReply;
 	APIController* apiController;
+	StreamController* streamController;
 	StaticFileController* staticFiles;
 	QMutex templateMutex;
 
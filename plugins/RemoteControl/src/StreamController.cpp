@@ -0,0 +1,458 @@
+/*
+ * Stellarium Remote Control plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StreamController.hpp"
+
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+
+#include <QBuffer>
+#include <QImageWriter>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QThread>
+#if (QT_VERSION>=QT_VERSION_CHECK(5, 6, 0))
+#include <QOpenGLExtraFunctions>
+#endif
+
+#include <cstring>
+
+//not defined in OpenGL ES 2 headers, but available at runtime with OpenGL ES 3
+#ifndef GL_READ_FRAMEBUFFER
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_WAIT_FAILED 0x911D
+#endif
+
+const int StreamController::MAX_CLIENTS = 8;
+const int StreamController::MAX_FPS = 30;
+const int StreamController::MIN_WIDTH = 16;
+const int StreamController::MAX_WIDTH = 1920;
+
+#define STREAM_BOUNDARY "stellarium-frame"
+
+StreamController::StreamController(int prefixLength, QObject* parent)
+	: HttpRequestHandler(parent)
+	, m_prefixLength(prefixLength)
+	, running(true)
+	, frameNumber(0)
+	, captureCalls(0)
+	, captureTime(0)
+	, maxCaptureTime(0)
+	, skippedFrames(0)
+	, scaledFbo(Q_NULLPTR)
+	, nextReadback(0)
+	, asyncReadback(false)
+	, glChecked(false)
+{
+}
+
+StreamController::~StreamController()
+{
+	stop();
+	releaseGLResources();
+}
+
+void StreamController::start()
+{
+	QMutexLocker locker(&mutex);
+	running = true;
+}
+
+void StreamController::stop()
+{
+	QMutexLocker locker(&mutex);
+	running = false;
+	frameAvailable.wakeAll();
+}
+
+void StreamController::service(HttpRequest &request, HttpResponse &response)
+{
+	response.setHeader("Cache-Control","no-cache");
+
+	QByteArray path = request.getRawPath();
+	QByteArray operation = path.right(path.size()-m_prefixLength);
+
+	if(operation == "mjpeg")
+		serviceStream(request,response);
+	else if(operation == "status")
+		serviceStatus(response);
+	else
+	{
+		response.setStatus(404,"not found");
+		response.setHeader("Content-Type","text/plain");
+		response.write("Unknown stream operation: "+operation,true);
+	}
+}
+
+void StreamController::serviceStatus(HttpResponse &response)
+{
+	QJsonObject obj;
+	{
+		QMutexLocker locker(&mutex);
+		obj.insert("clients",clients.size());
+		obj.insert("frames",static_cast<double>(frameNumber));
+		obj.insert("skippedFrames",static_cast<double>(skippedFrames));
+		obj.insert("captureCalls",static_cast<double>(captureCalls));
+		//times in milliseconds
+		obj.insert("captureTime",captureTime/1.0e6);
+		obj.insert("maxCaptureTime",maxCaptureTime/1.0e6);
+		obj.insert("asyncReadback",asyncReadback);
+	}
+	response.setHeader("Content-Type","application/json; charset=utf-8");
+	response.write(QJsonDocument(obj).toJson(QJsonDocument::Compact),true);
+}
+
+void StreamController::serviceStream(HttpRequest &request, HttpResponse &response)
+{
+	bool ok;
+	Client client;
+	client.fps = request.getParameter("fps").toInt(&ok);
+	if(!ok)
+		client.fps = 10;
+	client.fps = qBound(1, client.fps, MAX_FPS);
+	client.width = request.getParameter("width").toInt(&ok);
+	if(!ok)
+		client.width = 640;
+	client.width = qBound(MIN_WIDTH, client.width, MAX_WIDTH);
+	int quality = request.getParameter("quality").toInt(&ok);
+	if(!ok)
+		quality = 75;
+	quality = qBound(0, quality, 100);
+	QByteArray format = request.getParameter("format").toLower();
+	if(format.isEmpty())
+		format = "jpeg";
+	if(format != "jpeg" && format != "png")
+	{
+		response.setStatus(400,"Bad Request");
+		response.setHeader("Content-Type","text/plain");
+		response.write("Unsupported stream format: "+format,true);
+		return;
+	}
+
+	{
+		QMutexLocker locker(&mutex);
+		if(!running || clients.size() >= MAX_CLIENTS)
+		{
+			locker.unlock();
+			response.setStatus(503,"Service Unavailable");
+			response.setHeader("Content-Type","text/plain");
+			response.write("Too many streams",true);
+			return;
+		}
+		clients.insert(&response,client);
+	}
+
+	//the stream only ends when the connection is closed, so it is not sent in chunked mode
+	response.setHeader("Connection","close");
+	response.setHeader("Content-Type","multipart/x-mixed-replace; boundary=" STREAM_BOUNDARY);
+	//send the headers right away
+	response.write(QByteArray(),false);
+	response.flush();
+
+	const QByteArray partHeader = "--" STREAM_BOUNDARY "\r\nContent-Type: image/" + format + "\r\nContent-Length: ";
+	const qint64 interval = 1000 / client.fps;
+	quint64 lastFrame = 0;
+	QElapsedTimer sendTimer;
+	forever
+	{
+		//limit the frame rate of this client, the frames captured in the meantime are skipped
+		if(sendTimer.isValid())
+		{
+			const qint64 remaining = interval - sendTimer.elapsed();
+			if(remaining > 0)
+				QThread::msleep(static_cast<unsigned long>(remaining));
+		}
+
+		QImage frame;
+		quint64 number;
+		{
+			QMutexLocker locker(&mutex);
+			//wake up regularly to find out if the stream was stopped
+			while(running && frameNumber == lastFrame && response.isConnected())
+				frameAvailable.wait(&mutex,1000);
+			if(!running || !response.isConnected())
+				break;
+			frame = currentFrame;
+			number = frameNumber;
+		}
+		sendTimer.start();
+		lastFrame = number;
+
+		const QByteArray data = getEncodedFrame(frame,number,client.width,format,quality);
+		if(data.isEmpty())
+			continue;
+		response.write(partHeader + QByteArray::number(data.size()) + "\r\n\r\n" + data + "\r\n",false);
+		response.flush();
+	}
+
+	{
+		QMutexLocker locker(&mutex);
+		clients.remove(&response);
+	}
+	if(response.isConnected())
+		response.write("--" STREAM_BOUNDARY "--\r\n",true);
+}
+
+QByteArray StreamController::getEncodedFrame(const QImage &frame, quint64 number, int width, const QByteArray &format, int quality)
+{
+	const QByteArray key = format + '/' + QByteArray::number(width) + '/' + QByteArray::number(quality);
+	{
+		QMutexLocker locker(&mutex);
+		if(number == frameNumber && encodedFrames.contains(key))
+			return encodedFrames.value(key);
+	}
+
+	//the frame is stored bottom-up, and its alpha channel is meaningless
+	QImage image = frame.mirrored().convertToFormat(QImage::Format_RGB32);
+	if(image.width() > width)
+		image = image.scaledToWidth(width,Qt::SmoothTransformation);
+
+	QByteArray data;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+	QImageWriter writer(&buffer,format);
+	writer.setQuality(quality);
+	if(!writer.write(image))
+	{
+		qWarning()<<"[RemoteControl] Could not encode stream frame:"<<writer.errorString();
+		return QByteArray();
+	}
+
+	QMutexLocker locker(&mutex);
+	if(number == frameNumber)
+		encodedFrames.insert(key,data);
+	return data;
+}
+
+void StreamController::publishFrame(const QImage &image)
+{
+	QMutexLocker locker(&mutex);
+	currentFrame = image;
+	++frameNumber;
+	encodedFrames.clear();
+	frameAvailable.wakeAll();
+}
+
+void StreamController::captureFrame(StelCore *core)
+{
+	int maxFps = 0;
+	int maxWidth = 0;
+	{
+		QMutexLocker locker(&mutex);
+		for (const auto& client : clients)
+		{
+			maxFps = qMax(maxFps, client.fps);
+			maxWidth = qMax(maxWidth, client.width);
+		}
+	}
+	if(maxFps == 0)
+	{
+		if(scaledFbo)
+			releaseGLResources();
+		return;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	if(!glChecked)
+	{
+		//asynchronous readback needs framebuffer blits, pixel buffer objects and fences
+		const QSurfaceFormat glFormat = QOpenGLContext::currentContext()->format();
+#if (QT_VERSION>=QT_VERSION_CHECK(5, 6, 0))
+		if(QOpenGLContext::currentContext()->isOpenGLES())
+			asyncReadback = glFormat.majorVersion() >= 3;
+		else
+			asyncReadback = glFormat.version() >= qMakePair(3,2);
+#endif
+		if(!asyncReadback)
+			qWarning()<<"[RemoteControl] OpenGL"<<QString("%1.%2").arg(glFormat.majorVersion()).arg(glFormat.minorVersion())<<"does not allow asynchronous readback, streaming will slow down rendering";
+		glChecked = true;
+	}
+
+	if(asyncReadback)
+		collectReadbacks();
+
+	bool skipped = false;
+	//the render loop does not exactly keep the frame rate, so allow some tolerance
+	if(!lastCapture.isValid() || lastCapture.elapsed() >= 900 / maxFps)
+	{
+		const StelProjector::StelProjectorParams params = core->getCurrentStelProjectorParams();
+		const double dppp = params.devicePixelsPerPixel;
+		const QRect sourceRect(qRound(params.viewportXywh[0]*dppp), qRound(params.viewportXywh[1]*dppp),
+				       qRound(params.viewportXywh[2]*dppp), qRound(params.viewportXywh[3]*dppp));
+		if(sourceRect.isEmpty())
+			return;
+
+		if(asyncReadback)
+		{
+			const int width = qMin(maxWidth, sourceRect.width());
+			const QSize size(width, qMax(1, qRound(static_cast<double>(width)*sourceRect.height()/sourceRect.width())));
+			skipped = !startReadback(sourceRect,size);
+		}
+		else
+			captureSynchronously(sourceRect);
+		if(!skipped)
+			lastCapture.start();
+	}
+
+	const qint64 elapsed = timer.nsecsElapsed();
+	QMutexLocker locker(&mutex);
+	++captureCalls;
+	captureTime += elapsed;
+	maxCaptureTime = qMax(maxCaptureTime, elapsed);
+	if(skipped)
+		++skippedFrames;
+}
+
+bool StreamController::startReadback(const QRect &sourceRect, const QSize &size)
+{
+#if (QT_VERSION>=QT_VERSION_CHECK(5, 6, 0))
+	Readback& readback = readbacks[nextReadback];
+	//the GPU did not yet finish the older readbacks, skip this frame rather than waiting
+	if(readback.pending)
+		return false;
+
+	QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+	if(!scaledFbo || scaledFbo->size() != size)
+	{
+		delete scaledFbo;
+		scaledFbo = new QOpenGLFramebufferObject(size);
+	}
+
+	//downscale on the GPU, so that only the streamed resolution is read back
+	const GLuint defaultFbo = StelApp::getInstance().getDefaultFBO();
+	gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, defaultFbo);
+	gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, scaledFbo->handle());
+	gl->glBlitFramebuffer(sourceRect.x(), sourceRect.y(), sourceRect.x()+sourceRect.width(), sourceRect.y()+sourceRect.height(),
+			      0, 0, size.width(), size.height(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+	if(!readback.buffer)
+	{
+		readback.buffer = new QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+		readback.buffer->setUsagePattern(QOpenGLBuffer::StreamRead);
+		readback.buffer->create();
+	}
+	readback.buffer->bind();
+	if(readback.size != size)
+	{
+		readback.buffer->allocate(size.width()*size.height()*4);
+		readback.size = size;
+	}
+
+	//with a bound pixel pack buffer, glReadPixels returns immediately
+	gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, scaledFbo->handle());
+	gl->glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, Q_NULLPTR);
+	readback.fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.pending = true;
+	readback.buffer->release();
+	nextReadback = (nextReadback + 1) % 2;
+
+	//restore the framebuffer used for drawing
+	gl->glBindFramebuffer(GL_FRAMEBUFFER, defaultFbo);
+	return true;
+#else
+	Q_UNUSED(sourceRect)
+	Q_UNUSED(size)
+	return false;
+#endif
+}
+
+void StreamController::collectReadbacks()
+{
+#if (QT_VERSION>=QT_VERSION_CHECK(5, 6, 0))
+	QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+	//the buffers are used in turn, so the oldest one is the next to be used
+	for (int i=0; i<2; ++i)
+	{
+		Readback& readback = readbacks[(nextReadback + i) % 2];
+		if(!readback.pending)
+			continue;
+
+		GLsync fence = static_cast<GLsync>(readback.fence);
+		const GLenum status = gl->glClientWaitSync(fence, 0, 0);
+		//the newer readbacks can not be finished either
+		if(status == GL_TIMEOUT_EXPIRED)
+			break;
+		gl->glDeleteSync(fence);
+		readback.fence = Q_NULLPTR;
+		readback.pending = false;
+		if(status == GL_WAIT_FAILED)
+			continue;
+
+		const int byteCount = readback.size.width()*readback.size.height()*4;
+		readback.buffer->bind();
+		const void* data = gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, byteCount, GL_MAP_READ_BIT);
+		if(data)
+		{
+			//RGBA scanlines are always 32 bit aligned, as in QImage
+			QImage image(readback.size, QImage::Format_RGBA8888);
+			std::memcpy(image.bits(), data, static_cast<size_t>(byteCount));
+			gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			publishFrame(image);
+		}
+		readback.buffer->release();
+	}
+#endif
+}
+
+void StreamController::captureSynchronously(const QRect &sourceRect)
+{
+	//the full viewport is read back here, scaling is done when encoding
+	QOpenGLFunctions* gl = QOpenGLContext::currentContext()->functions();
+	QImage image(sourceRect.size(), QImage::Format_RGBA8888);
+	gl->glReadPixels(sourceRect.x(), sourceRect.y(), sourceRect.width(), sourceRect.height(), GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+	publishFrame(image);
+}
+
+void StreamController::releaseGLResources()
+{
+#if (QT_VERSION>=QT_VERSION_CHECK(5, 6, 0))
+	QOpenGLContext* context = QOpenGLContext::currentContext();
+#endif
+	for (auto& readback : readbacks)
+	{
+#if (QT_VERSION>=QT_VERSION_CHECK(5, 6, 0))
+		if(readback.fence && context)
+			context->extraFunctions()->glDeleteSync(static_cast<GLsync>(readback.fence));
+#endif
+		readback.fence = Q_NULLPTR;
+		readback.pending = false;
+		readback.size = QSize();
+		delete readback.buffer;
+		readback.buffer = Q_NULLPTR;
+	}
+	delete scaledFbo;
+	scaledFbo = Q_NULLPTR;
+	nextReadback = 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Stellarium Remote Control plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STREAMCONTROLLER_HPP
+#define STREAMCONTROLLER_HPP
+
+#include "httpserver/httprequesthandler.h"
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+
+class StelCore;
+class QOpenGLBuffer;
+class QOpenGLFramebufferObject;
+
+//! @ingroup remoteControl
+//! Streams the rendered view to HTTP clients as a MJPEG stream (a \c multipart/x-mixed-replace response),
+//! which can directly be shown by browsers in an \c img element.
+//!
+//! The view is captured in the main thread by captureFrame(), at the highest frame rate and resolution requested
+//! by the connected clients and only while there are any. The framebuffer is downscaled on the GPU and read back
+//! asynchronously into pixel buffer objects, which are only mapped once their fence was signaled, so the render loop
+//! never waits for the GPU. Without OpenGL (ES) 3 support, the view is read back synchronously instead.
+//! The frames are encoded in the HTTP worker thread of each client, so that the encoding cost does not affect the
+//! render loop either. Clients requesting the same format share the encoded frames.
+//!
+//! The following requests are handled:
+//!  - \c /api/stream/mjpeg starts a stream. Optional parameters are \c fps (default 10, at most 30), \c width
+//! (default 640, between 16 and 1920 pixels), \c format (\c jpeg or \c png) and \c quality (0-100, default 75).
+//! If too many streams are open, the request fails with HTTP 503.
+//!  - \c /api/stream/status returns a JSON object with the number of clients, the captured frames and the time
+//! spent capturing in the main thread, e.g. to measure the render loop overhead (see \c util/streamClient).
+class StreamController : public HttpRequestHandler
+{
+	Q_OBJECT
+public:
+	//! Constructs a StreamController
+	//! @param prefixLength Determines how many characters to strip from the front of the request path
+	//! @param parent passed on to QObject constructor
+	StreamController(int prefixLength, QObject* parent = Q_NULLPTR);
+	virtual ~StreamController();
+
+	//! Captures the current view if any client is waiting for a frame. Must be called in the main thread
+	//! after the sky has been drawn, with the GL context current.
+	void captureFrame(StelCore* core);
+
+	//! Allows new streams to be started. Streams are enabled after construction.
+	void start();
+	//! Ends all running streams and rejects new ones. Must be called before the HttpListener is deleted,
+	//! because the worker threads can not be stopped while they are streaming.
+	void stop();
+
+	//! Handles a stream request. A stream blocks the HTTP worker thread until the client disconnects or stop() is called.
+	//! @note This method runs in an HTTP worker thread, not in the Stellarium main thread.
+	virtual void service(HttpRequest& request, HttpResponse& response) Q_DECL_OVERRIDE;
+
+	//! The maximal number of simultaneous streams
+	static const int MAX_CLIENTS;
+	//! The maximal frame rate of a stream
+	static const int MAX_FPS;
+	//! The minimal and maximal width of the streamed images
+	static const int MIN_WIDTH;
+	static const int MAX_WIDTH;
+
+private:
+	struct Client
+	{
+		int fps;
+		int width;
+	};
+
+	//! A pending asynchronous readback
+	struct Readback
+	{
+		Readback() : buffer(Q_NULLPTR), fence(Q_NULLPTR), pending(false) {}
+		QOpenGLBuffer* buffer;
+		void* fence;
+		QSize size;
+		bool pending;
+	};
+
+	void serviceStream(HttpRequest& request, HttpResponse& response);
+	void serviceStatus(HttpResponse& response);
+
+	//! Returns the encoded current frame for the given parameters, encoding it if no other client did already.
+	QByteArray getEncodedFrame(const QImage& frame, quint64 frameNumber, int width, const QByteArray& format, int quality);
+	//! Publishes a new frame to the clients. The image is stored bottom-up, as read from GL.
+	void publishFrame(const QImage& image);
+
+	void collectReadbacks();
+	bool startReadback(const QRect& sourceRect, const QSize& size);
+	void captureSynchronously(const QRect& sourceRect);
+	void releaseGLResources();
+
+	int m_prefixLength;
+
+	//! Protects all the members below which are shared with the worker threads
+	QMutex mutex;
+	QWaitCondition frameAvailable;
+	bool running;
+	QMap<HttpResponse*, Client> clients;
+	QImage currentFrame;
+	quint64 frameNumber;
+	//! Encoded versions of currentFrame, by format, width and quality
+	QMap<QByteArray, QByteArray> encodedFrames;
+	//! Statistics of captureFrame()
+	quint64 captureCalls;
+	qint64 captureTime;
+	qint64 maxCaptureTime;
+	quint64 skippedFrames;
+
+	//! Used only in the main thread
+	QElapsedTimer lastCapture;
+	QOpenGLFramebufferObject* scaledFbo;
+	Readback readbacks[2];
+	int nextReadback;
+	bool asyncReadback;
+	bool glChecked;
+};
+
+#endif
@@ -61,6 +61,8 @@ int Satellite::orbitLineSegments = 90;
 int Satellite::orbitLineFadeSegments = 4;
 int Satellite::orbitLineSegmentDuration = 20;
 bool Satellite::orbitLinesFlag = true;
+QVector<Vec2f> Satellite::orbitBatchVertices;
+QVector<Vec4f> Satellite::orbitBatchColors;
 bool Satellite::realisticModeFlag = false;
 bool Satellite::hideInvisibleSatellitesFlag = false;
 Vec3f Satellite::invisibleSatelliteColor = Vec3f(0.2f,0.2f,0.2f);
@@ -92,8 +94,8 @@ Satellite::Satellite(const QString& identifier, const QVariantMap& map)
 	, pSatWrapper(Q_NULLPTR)
 	, visibility(gSatWrapper::UNKNOWN)
 	, phaseAngle(0.)
-	, lastEpochCompForOrbit(0.)
 	, epochTime(0.)
+	, orbitFirstSlot(0)
 {
 	// return initialized if the mandatory fields are not present
 	if (identifier.isEmpty())
@@ -778,8 +780,7 @@ void Satellite::setNewTleElements(const QString& tle1, const QString& tle2)
 	tleElements.second.append(tle2);
 
 	pSatWrapper = new gSatWrapper(id, tle1, tle2);
-	orbitPoints.clear();
-	visibilityPoints.clear();
+	recalculateOrbitLines();
 	
 	parseInternationalDesignator(tle1);
 }
@@ -816,9 +817,7 @@ void Satellite::update(double)
 		pSatWrapper->getSlantRange(range, rangeRate);
 		visibility = pSatWrapper->getVisibilityPredict();
 		phaseAngle = pSatWrapper->getPhaseAngle();
-
-		// Compute orbit points to draw orbit line.
-		if (orbitDisplayed) computeOrbitPoints();
+		// Orbit line points are computed for all satellites at once by Satellites::updateOrbitLines().
 	}
 }
 
@@ -834,6 +833,7 @@ void Satellite::recalculateOrbitLines(void)
 {
 	orbitPoints.clear();
 	visibilityPoints.clear();
+	orbitSlots.clear();
 }
 
 SatFlags Satellite::getFlags() const
@@ -904,16 +904,28 @@ bool Satellite::operator <(const Satellite& another) const
 		return false;
 }
 
-void Satellite::draw(StelCore* core, StelPainter& painter)
+bool Satellite::isDrawn(const StelCore* core) const
 {
 	// Separated because first test should be very fast.
-	if (!displayed)
-		return;
+	if (!initialized || !displayed)
+		return false;
 
 	// 1) Do not show satellites before Space Era begins!
 	// 2) Do not show satellites when time rate is over limit (JD/sec)!
 	if (core->getJD()<jdLaunchYearJan1 || qAbs(core->getTimeRate())>=timeRateLimit)
-		return;
+		return false;
+
+	// Invisible satellites are only hidden outside the realistic mode, which draws their labels.
+	if (!realisticModeFlag && hideInvisibleSatellitesFlag && visibility != gSatWrapper::VISIBLE)
+		return false;
+
+	return true;
+}
+
+bool Satellite::draw(StelCore* core, StelPainter& painter)
+{
+	if (!isDrawn(core))
+		return false;
 
 	XYZ = getJ2000EquatorialPos(core);
 	// NOTE: Should we use the real angular size of ISS here (we do not have linear size of ISS within catalog for calculation the angular size)?
@@ -967,60 +979,80 @@ void Satellite::draw(StelCore* core, StelPainter& painter)
 		}
 		else
 		{
-			bool visible = true;
-			if (hideInvisibleSatellitesFlag && visibility != gSatWrapper::VISIBLE)
-				visible = false;
-
-			if (visible)
-			{
-				Vec3f drawColor = (visibility == gSatWrapper::VISIBLE) ? hintColor : invisibleSatelliteColor; // Use hintColor for visible satellites only
-				painter.setColor(drawColor[0], drawColor[1], drawColor[2], hintBrightness);
-
-				if (showLabels)
-					painter.drawText(XYZ, name, 0, 10, 10, false);
+			Vec3f drawColor = (visibility == gSatWrapper::VISIBLE) ? hintColor : invisibleSatelliteColor; // Use hintColor for visible satellites only
+			painter.setColor(drawColor[0], drawColor[1], drawColor[2], hintBrightness);
 
-				painter.setBlending(true, GL_ONE, GL_ONE);
-				hintTexture->bind();
-				painter.drawSprite2dMode(XYZ, 11);
-			}
+			painter.setBlending(true, GL_ONE, GL_ONE);
+			hintTexture->bind();
+			painter.drawSprite2dMode(XYZ, 11);
+			return showLabels;
 		}
 	}
+	return false;
+}
 
-	if (orbitDisplayed && Satellite::orbitLinesFlag && orbitValid)
-		drawOrbit(core, painter);
+void Satellite::drawLabel(StelPainter& painter) const
+{
+	Vec3f drawColor = (visibility == gSatWrapper::VISIBLE) ? hintColor : invisibleSatelliteColor; // Use hintColor for visible satellites only
+	painter.setColor(drawColor[0], drawColor[1], drawColor[2], hintBrightness);
+	painter.drawText(XYZ, name, 0, 10, 10, false);
 }
 
 
-void Satellite::drawOrbit(StelCore *core, StelPainter& painter)
+void Satellite::drawOrbit(const StelProjectorP& prj)
 {
-	Vec3d position, onscreen;
-	Vec3f drawColor;
-	int size = orbitPoints.size();
-
-	QVector<Vec3d> vertexArray;
-	QVector<Vec4f> colorArray;
-	StelProjectorP prj = painter.getProjector();
+	if (orbitSlots.isEmpty())
+		return;
 
-	vertexArray.resize(size);
-	colorArray.resize(size);
+	Vec3d position, onscreen, prevPosition, prevOnscreen;
+	Vec4f color, prevColor;
+	bool prevVisible = false;
 
-	//Rest of points
-	for (int i=1; i<size; i++)
+	// The batch is drawn as independent line segments, so that the orbit lines of all satellites can go in one draw call.
+	for (int i=1; i<=orbitLineSegments; i++)
 	{
-		position = core->altAzToJ2000(orbitPoints[i].toVec3d());
+		const qint64 slot = orbitFirstSlot + i;
+		if (!hasOrbitPoint(slot))
+		{
+			prevVisible = false;
+			continue;
+		}
+		const int index = static_cast<int>(slot % orbitSlots.size());
+		position = orbitPoints.at(index);
 		position.normalize();
+		const Vec3f drawColor = (visibilityPoints.at(index) == gSatWrapper::VISIBLE) ? orbitColor : invisibleSatelliteColor;
+		color.set(drawColor[0], drawColor[1], drawColor[2], hintBrightness * calculateOrbitSegmentIntensity(i));
 
-		if (prj->project(position, onscreen)) // check position on the screen
+		const bool visible = prj->project(position, onscreen); // check position on the screen
+		if (visible && prevVisible && !prj->intersectViewportDiscontinuity(prevPosition, position))
 		{
-			vertexArray.append(position);
-			drawColor = (visibilityPoints[i] == gSatWrapper::VISIBLE) ? orbitColor : invisibleSatelliteColor;
-			colorArray.append(Vec4f(drawColor[0], drawColor[1], drawColor[2], hintBrightness * calculateOrbitSegmentIntensity(i)));
+			orbitBatchVertices << Vec2f(static_cast<float>(prevOnscreen[0]), static_cast<float>(prevOnscreen[1]))
+					   << Vec2f(static_cast<float>(onscreen[0]), static_cast<float>(onscreen[1]));
+			orbitBatchColors << prevColor << color;
 		}
+		prevVisible = visible;
+		prevPosition = position;
+		prevOnscreen = onscreen;
+		prevColor = color;
 	}
-	painter.drawPath(vertexArray, colorArray); // (does client state switching as needed internally)
 }
 
+void Satellite::drawOrbitBatch(StelPainter& painter)
+{
+	if (orbitBatchVertices.isEmpty())
+		return;
 
+	painter.setBlending(true);
+	painter.enableClientStates(true, false, true);
+	painter.setVertexPointer(2, GL_FLOAT, orbitBatchVertices.constData());
+	painter.setColorPointer(4, GL_FLOAT, orbitBatchColors.constData());
+	painter.drawFromArray(StelPainter::Lines, orbitBatchVertices.size(), 0, false);
+	painter.enableClientStates(false);
+
+	// Keep the allocated memory for the next frame.
+	orbitBatchVertices.resize(0);
+	orbitBatchColors.resize(0);
+}
 
 float Satellite::calculateOrbitSegmentIntensity(int segNum)
 {
@@ -1035,94 +1067,31 @@ float Satellite::calculateOrbitSegmentIntensity(int segNum)
 	}
 }
 
-void Satellite::computeOrbitPoints()
+void Satellite::setOrbitFirstSlot(qint64 slot)
 {
-	gTimeSpan computeInterval(0, 0, 0, orbitLineSegmentDuration);
-	gTimeSpan orbitSpan(0, 0, 0, orbitLineSegments*orbitLineSegmentDuration/2);
-	gTime epochTm;
-	gTime epoch(epochTime);
-	gTime lastEpochComp(lastEpochCompForOrbit);
-	Vec3d elAzVector;
-	int diffSlots;
-
-
-	if (orbitPoints.isEmpty())//Setup orbitPoins
+	const int size = orbitLineSegments+1;
+	if (orbitSlots.size()!=size)
 	{
-		epochTm  = epoch - orbitSpan;
-
-		for (int i=0; i<=orbitLineSegments; i++)
-		{
-			pSatWrapper->setEpoch(epochTm.getGmtTm());
-			elAzVector  = pSatWrapper->getAltAz();
-			orbitPoints.append(elAzVector);
-			visibilityPoints.append(pSatWrapper->getVisibilityPredict());
-			epochTm    += computeInterval;
-		}
-		lastEpochCompForOrbit = epochTime;
+		orbitPoints.fill(Vec3d(0.), size);
+		visibilityPoints.fill(gSatWrapper::UNKNOWN, size);
+		orbitSlots.fill(-1, size);
 	}
-	else if (epochTime > lastEpochCompForOrbit)
-	{
-		// compute next orbit point when clock runs forward
-		gTimeSpan diffTime = epoch - lastEpochComp;
-		diffSlots          = static_cast<int>(diffTime.getDblSeconds()/orbitLineSegmentDuration);
-
-		if (diffSlots > 0)
-		{
-			if (diffSlots > orbitLineSegments)
-			{
-				diffSlots = orbitLineSegments + 1;
-				epochTm  = epoch - orbitSpan;
-			}
-			else
-			{
-				epochTm   = lastEpochComp + orbitSpan + computeInterval;
-			}
-
-			for (int i=0; i<diffSlots; i++)
-			{
-				//remove points at beginning of list and add points at end.
-				orbitPoints.removeFirst();
-				visibilityPoints.removeFirst();
-				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
-				orbitPoints.append(elAzVector);
-				visibilityPoints.append(pSatWrapper->getVisibilityPredict());
-				epochTm    += computeInterval;
-			}
+	orbitFirstSlot = slot;
+}
 
-			lastEpochCompForOrbit = epochTime;
-		}
-	}
-	else if (epochTime < lastEpochCompForOrbit)
-	{
-		// compute next orbit point when clock runs backward
-		gTimeSpan diffTime = lastEpochComp - epoch;
-		diffSlots          = static_cast<int>(diffTime.getDblSeconds()/orbitLineSegmentDuration);
+bool Satellite::hasOrbitPoint(qint64 slot) const
+{
+	return !orbitSlots.isEmpty() && orbitSlots.at(static_cast<int>(slot % orbitSlots.size()))==slot;
+}
 
-		if (diffSlots > 0)
-		{
-			if (diffSlots > orbitLineSegments)
-			{
-				diffSlots = orbitLineSegments + 1;
-				epochTm   = epoch + orbitSpan;
-			}
-			else
-			{
-				epochTm   = epoch - orbitSpan - computeInterval;
-			}
-			for (int i=0; i<diffSlots; i++)
-			{ //remove points at end of list and add points at beginning.
-				orbitPoints.removeLast();
-				visibilityPoints.removeLast();
-				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
-				orbitPoints.push_front(elAzVector);
-				visibilityPoints.push_front(pSatWrapper->getVisibilityPredict());
-				epochTm -= computeInterval;
-			}
-			lastEpochCompForOrbit = epochTime;
-		}
-	}
+void Satellite::computeOrbitPoint(qint64 slot, double jd)
+{
+	Q_ASSERT(!orbitSlots.isEmpty());
+	const int index = static_cast<int>(slot % orbitSlots.size());
+	pSatWrapper->setEpoch(jd);
+	orbitPoints[index] = pSatWrapper->getAltAz();
+	visibilityPoints[index] = pSatWrapper->getVisibilityPredict();
+	orbitSlots[index] = slot;
 }
 
 
@@ -26,6 +26,7 @@
 #include <QSharedPointer>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 #include <QVariant>
 
 #include "StelObject.hpp"
@@ -93,6 +94,7 @@ class Satellite : public StelObject
 	friend class Satellites;
 	friend class SatellitesDialog;
 	friend class SatellitesListModel;
+	friend class TestSatellites;
 
 	Q_ENUMS(OptStatus)
 public:
@@ -212,8 +214,18 @@ public:
 
 private:
 	//draw orbits methods
-	void computeOrbitPoints();
-	void drawOrbit(StelCore* core, StelPainter& painter);
+	//! Set the first time slot of the displayed orbit line, which covers orbitLineSegments+1 slots.
+	//! Slot k is sampled at time k*orbitLineSegmentDuration. Points of slots already computed are kept.
+	void setOrbitFirstSlot(qint64 slot);
+	//! @return true if the orbit line point of this time slot has been computed.
+	bool hasOrbitPoint(qint64 slot) const;
+	//! Compute the orbit line point of a time slot.
+	//! @param jd the time of the slot (UTC)
+	void computeOrbitPoint(qint64 slot, double jd);
+	//! Add the orbit line to the orbit batch, projected with the (unrefracted) alt-azimuthal projector prj.
+	void drawOrbit(const StelProjectorP& prj);
+	//! Draw the orbit lines of all satellites collected by drawOrbit() in one call.
+	static void drawOrbitBatch(StelPainter& painter);
 	//! returns 0 - 1.0 for the DRAWORBIT_FADE_NUMBER segments at
 	//! each end of an orbit, with 1 in the middle.
 	float calculateOrbitSegmentIntensity(int segNum);
@@ -277,6 +289,9 @@ private:
 	static int   orbitLineFadeSegments;
 	static int   orbitLineSegmentDuration; //measured in seconds
 	static bool  orbitLinesFlag;
+	//! Projected vertices and colors of the orbit line segments waiting for drawOrbitBatch().
+	static QVector<Vec2f> orbitBatchVertices;
+	static QVector<Vec4f> orbitBatchColors;
 	static bool  realisticModeFlag;
 	static bool  hideInvisibleSatellitesFlag;
 	//! Mask controlling which info display flags should be honored.
@@ -285,7 +300,15 @@ private:
 
 	static double timeRateLimit;
 
-	void draw(StelCore *core, StelPainter& painter);
+	//! @return true if the satellite passes the display filters (displayed flag, launch date, time rate
+	//! and hidden invisible satellites), i.e. if its hint and its orbit line may be drawn.
+	bool isDrawn(const StelCore* core) const;
+	//! Draw the satellite. Outside the realistic mode the label is not drawn here: drawing text would flush the
+	//! batch of hints, so the caller draws it with drawLabel() after the batch.
+	//! @return true if the label of the satellite must be drawn by drawLabel()
+	bool draw(StelCore *core, StelPainter& painter);
+	//! Draw the label of a satellite whose hint was drawn by draw() outside the realistic mode.
+	void drawLabel(StelPainter& painter) const;
 
 	//Satellite Orbit Position calculation
 	gSatWrapper *pSatWrapper;
@@ -305,10 +328,12 @@ private:
 
 	//Satellite Orbit Draw
 	Vec3f    orbitColor;
-	double    lastEpochCompForOrbit; //measured in Julian Days
 	double    epochTime;  //measured in Julian Days
-	QList<Vec3d> orbitPoints; //orbit points represented by ElAzPos vectors
-	QList<gSatWrapper::Visibility> visibilityPoints; //orbit visibility points
+	qint64    orbitFirstSlot; //first time slot of the displayed orbit line
+	// Ring buffers of the orbit line: the point of slot k is stored at index k modulo their size.
+	QVector<Vec3d> orbitPoints; //orbit points represented by ElAzPos vectors
+	QVector<gSatWrapper::Visibility> visibilityPoints; //orbit visibility points
+	QVector<qint64> orbitSlots; //time slot of each orbit point, -1 if not computed
 };
 
 typedef QSharedPointer<Satellite> SatelliteP;
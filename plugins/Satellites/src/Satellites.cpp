@@ -1742,6 +1742,39 @@ void Satellites::update(double deltaTime)
 		if (sat->initialized && sat->displayed)
 			sat->update(deltaTime);
 	}
+
+	updateOrbitLines(core);
+}
+
+void Satellites::updateOrbitLines(StelCore* core)
+{
+	if (!Satellite::orbitLinesFlag)
+		return;
+
+	// All orbit lines are sampled on a common grid of time slots. Computing them slot by slot for all satellites
+	// keeps the observer and Sun positions cached in gSatWrapper valid, and only slots entering the window are computed.
+	const double slotDuration = Satellite::orbitLineSegmentDuration/86400.; // days
+	const qint64 firstSlot = qRound64(core->getJD()/slotDuration) - Satellite::orbitLineSegments/2;
+	const qint64 lastSlot = firstSlot + Satellite::orbitLineSegments;
+
+	QVector<Satellite*> orbitSatellites;
+	for (const auto& sat : satellites)
+	{
+		if (sat->orbitDisplayed && sat->orbitValid && sat->isDrawn(core))
+		{
+			sat->setOrbitFirstSlot(firstSlot);
+			orbitSatellites.append(sat.data());
+		}
+	}
+
+	for (qint64 slot=firstSlot; slot<=lastSlot; ++slot)
+	{
+		for (auto* sat : orbitSatellites)
+		{
+			if (!sat->hasOrbitPoint(slot))
+				sat->computeOrbitPoint(slot, slot*slotDuration);
+		}
+	}
 }
 
 void Satellites::draw(StelCore* core)
@@ -1764,10 +1797,29 @@ void Satellites::draw(StelCore* core)
 	painter.setBlending(true);
 	Satellite::hintTexture->bind();
 	Satellite::viewportHalfspace = painter.getProjector()->getBoundingCap();
+	// The hints are drawn in one call, unless the sky drawer is used for the realistic mode
+	painter.setBatching(!Satellite::realisticModeFlag);
+	// Drawing text flushes the batch, so the labels are drawn after all the hints
+	QVector<const Satellite*> labelled;
 	for (const auto& sat : satellites)
 	{
-		if (sat && sat->initialized && sat->displayed)
-			sat->draw(core, painter);
+		if (sat && sat->isDrawn(core) && sat->draw(core, painter))
+			labelled.append(sat.data());
+	}
+	painter.setBatching(false);
+	for (const auto* sat : labelled)
+		sat->drawLabel(painter);
+
+	if (Satellite::orbitLinesFlag)
+	{
+		// Orbit points are given in alt-azimuthal coordinates, without refraction.
+		const StelProjectorP altAzPrj = core->getProjection(StelCore::FrameAltAz, StelCore::RefractionOff);
+		for (const auto& sat : satellites)
+		{
+			if (sat && sat->orbitDisplayed && sat->orbitValid && sat->isDrawn(core))
+				sat->drawOrbit(altAzPrj);
+		}
+		Satellite::drawOrbitBatch(painter);
 	}
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
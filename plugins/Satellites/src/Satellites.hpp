@@ -519,6 +519,9 @@ private:
 	//! Checks valid range dates of life of satellites
 	bool isValidRangeDates(const StelCore* core) const;
 
+	//! Compute the missing orbit line points of all satellites with displayed orbits in one pass.
+	void updateOrbitLines(StelCore* core);
+
 	//! Save a structure representing a satellite catalog to a JSON file.
 	//! If no path is specified, catalogPath is used.
 	//! @see createDataMap()
@@ -17,7 +17,16 @@
  */
 
 #include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QSharedPointer>
+#include <QVariantMap>
 #include "testSatellites.hpp"
+#include "Satellite.hpp"
+#include "StelProjectorClasses.hpp"
+#include "gsatellite/gSatTEME.hpp"
+
+#include <cmath>
 
 QTEST_GUILESS_MAIN(TestSatellites)
 
@@ -46,4 +55,93 @@ void TestSatellites::testNoSatDuplication()
     QVERIFY(dutA == dutB);
 }
 
+void TestSatellites::benchmarkOrbitLineWindow()
+{
+    // Synthetic catalogue: the ISS elements spread out over the ascending node and the mean anomaly.
+    const QByteArray line1 = "1 25544U 98067A   08264.51782528 -.00002182  00000-0 -11606-4 0  2927";
+    const QByteArray line2 = "2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563537";
+    const int satCount = 20000;
+    const int segments = 90;
+    const double slotDuration = 20./86400.; // days
+    QVector<QSharedPointer<gSatTEME> > sats;
+    for (int i=0; i<satCount; ++i)
+    {
+        QByteArray tle1(line1), tle2(line2);
+        tle2.replace(17, 8, QByteArray::number(std::fmod(i*0.37, 360.), 'f', 4).rightJustified(8, ' '));
+        tle2.replace(43, 8, QByteArray::number(std::fmod(i*7.3, 360.), 'f', 4).rightJustified(8, ' '));
+        sats.append(QSharedPointer<gSatTEME>(new gSatTEME("SYNTHETIC", tle1.data(), tle2.data())));
+    }
+
+    // Fill the orbit line ring buffers of all satellites for a full window, slot by slot as Satellites::updateOrbitLines() does.
+    QVector<Vec3d> orbitPoints(satCount*(segments+1));
+    const qint64 firstSlot = qRound64(2454730.0178/slotDuration) - segments/2;
+    QBENCHMARK_ONCE
+    {
+        for (qint64 slot=firstSlot; slot<=firstSlot+segments; ++slot)
+        {
+            const int index = static_cast<int>(slot % (segments+1));
+            for (int i=0; i<satCount; ++i)
+            {
+                sats[i]->setEpoch(slot*slotDuration);
+                orbitPoints[i*(segments+1)+index] = sats[i]->getPos();
+            }
+        }
+    }
+
+    for (int i=0; i<orbitPoints.size(); i+=997)
+        QVERIFY(orbitPoints.at(i).length() > 6378.);
+}
+
+void TestSatellites::benchmarkOrbitLineDrawing()
+{
+    // Synthetic orbit lines: circles of 60 degrees around the zenith, one per satellite, with varying node.
+    // A map without TLE gives an uninitialized satellite, which does not need the solar system.
+    const int satCount = 20000;
+    const int segments = Satellite::orbitLineSegments;
+    const qint64 firstSlot = 1000;
+    QVariantMap map;
+    map.insert("name", "SYNTHETIC");
+    QVector<QSharedPointer<Satellite> > sats;
+    for (int i=0; i<satCount; ++i)
+    {
+        QSharedPointer<Satellite> sat(new Satellite(QString::number(i), map));
+        sat->setOrbitFirstSlot(firstSlot);
+        const double node = i*0.37*M_PI/180.;
+        for (qint64 slot=firstSlot; slot<=firstSlot+segments; ++slot)
+        {
+            const int index = static_cast<int>(slot % sat->orbitSlots.size());
+            const double anomaly = slot*M_PI/segments;
+            sat->orbitPoints[index] = Vec3d(std::cos(node)*std::cos(anomaly) - std::sin(node)*std::sin(anomaly)*0.5,
+                                            std::sin(node)*std::cos(anomaly) + std::cos(node)*std::sin(anomaly)*0.5,
+                                            0.866*std::sin(anomaly)+0.5);
+            sat->visibilityPoints[index] = (i%2) ? gSatWrapper::VISIBLE : gSatWrapper::RADAR_SUN;
+            sat->orbitSlots[index] = slot;
+        }
+        sats.append(sat);
+    }
+
+    // Full HD view of the zenith region, as the alt-azimuthal projector of Satellites::draw() would give.
+    StelProjector::StelProjectorParams params;
+    params.viewportXywh.set(0, 0, 1920, 1080);
+    params.viewportCenter.set(960., 540.);
+    params.viewportFovDiameter = 1080.;
+    params.fov = 120.f;
+    StelProjectorP prj(new StelProjectorStereographic(StelProjector::ModelViewTranformP(new StelProjector::Mat4dTransform(Mat4d::identity()))));
+    prj->init(params);
 
+    // Project all orbit lines into the shared segment batch, i.e. everything Satellites::draw() does
+    // for the orbit lines except for the single GL draw call of Satellite::drawOrbitBatch().
+    int batchSize = 0;
+    QBENCHMARK
+    {
+        for (const auto& sat : sats)
+            sat->drawOrbit(prj);
+        batchSize = Satellite::orbitBatchVertices.size();
+        Satellite::orbitBatchVertices.resize(0);
+        Satellite::orbitBatchColors.resize(0);
+    }
+
+    QVERIFY(batchSize > 0);
+    QVERIFY(batchSize % 2 == 0);
+    QVERIFY(batchSize <= satCount*segments*2);
+}
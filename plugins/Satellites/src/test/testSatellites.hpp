@@ -30,6 +30,8 @@ private slots:
     void testCelestrackFormattedLine2();
     void testSpaceTrackFormattedLine2();
     void testNoSatDuplication();
+    void benchmarkOrbitLineWindow();
+    void benchmarkOrbitLineDrawing();
 };
 
 #endif // TESTSATELLITES_HPP
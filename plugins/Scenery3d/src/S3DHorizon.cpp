@@ -0,0 +1,143 @@
+/*
+ * Stellarium Scenery3d Plug-in
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "S3DHorizon.hpp"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Number of triangles processed by one task
+static const int HORIZON_CHUNK_TRIANGLES = 16384;
+
+QVector<float> S3DHorizon::compute(const MeshList &meshes, const Vec3f &eye)
+{
+	//the scene uses the alt-azimuthal frame, where North is -x and East is +y
+	QVector<Vec2f> directions(SAMPLE_COUNT);
+	for(int i=0;i<SAMPLE_COUNT;++i)
+	{
+		const double az = 2.0 * M_PI * i / SAMPLE_COUNT;
+		directions[i].set(static_cast<float>(-std::cos(az)), static_cast<float>(std::sin(az)));
+	}
+
+	QVector<Chunk> chunks;
+	for(const auto& mesh : meshes)
+	{
+		for(int first=0;first<mesh.indexCount;first+=HORIZON_CHUNK_TRIANGLES*3)
+		{
+			Chunk chunk;
+			chunk.mesh = &mesh;
+			chunk.firstIndex = first;
+			chunk.indexCount = std::min(HORIZON_CHUNK_TRIANGLES*3, mesh.indexCount - first);
+			chunk.eye = eye;
+			chunk.directions = directions.constData();
+			chunks.append(chunk);
+		}
+	}
+
+	QVector<float> slopes = QtConcurrent::blockingMappedReduced<QVector<float> >(chunks, &S3DHorizon::computeChunk, &S3DHorizon::mergeChunk,
+											     QtConcurrent::UnorderedReduce);
+
+	QVector<float> altitudes(SAMPLE_COUNT, static_cast<float>(-M_PI_2));
+	for(int i=0;i<slopes.size();++i)
+	{
+		if(slopes.at(i) > -FLT_MAX)
+			altitudes[i] = std::atan(slopes.at(i));
+	}
+	return altitudes;
+}
+
+QVector<float> S3DHorizon::computeChunk(const Chunk &chunk)
+{
+	static const float TWO_PI = static_cast<float>(2.0 * M_PI);
+	static const float SAMPLES_PER_RADIAN = SAMPLE_COUNT / TWO_PI;
+
+	//the altitude is stored as slope until the end, which avoids an atan per intersection
+	QVector<float> slopes(SAMPLE_COUNT, -FLT_MAX);
+	const Mesh& mesh = *chunk.mesh;
+	const unsigned int* idx = mesh.indices + chunk.firstIndex;
+	for(int t=0;t<chunk.indexCount;t+=3)
+	{
+		Vec3f d[3];
+		float az[3];
+		for(int k=0;k<3;++k)
+		{
+			const float* p = mesh.positions + static_cast<size_t>(idx[t+k]) * static_cast<size_t>(mesh.stride);
+			d[k].set(p[0] - chunk.eye[0], p[1] - chunk.eye[1], p[2] - chunk.eye[2]);
+			az[k] = static_cast<float>(M_PI) - std::atan2(d[k][1], d[k][0]);
+		}
+
+		//the azimuth range of the triangle is the complement of the largest gap between its vertices
+		float sorted[3] = { az[0], az[1], az[2] };
+		std::sort(sorted, sorted+3);
+		const float gaps[3] = { sorted[1] - sorted[0], sorted[2] - sorted[1], sorted[0] + TWO_PI - sorted[2] };
+		const int largest = static_cast<int>(std::max_element(gaps, gaps+3) - gaps);
+		int first, last;
+		if(gaps[largest] <= static_cast<float>(M_PI))
+		{
+			//the vertical line of the viewer passes through the triangle
+			first = 0;
+			last = SAMPLE_COUNT - 1;
+		}
+		else
+		{
+			const float start = sorted[(largest+1)%3];
+			const float end = start + TWO_PI - gaps[largest];
+			first = static_cast<int>(std::ceil(start * SAMPLES_PER_RADIAN));
+			last = static_cast<int>(std::floor(end * SAMPLES_PER_RADIAN));
+		}
+
+		for(int j=first;j<=last;++j)
+		{
+			const int i = j % SAMPLE_COUNT;
+			const Vec2f& h = chunk.directions[i];
+			//signed distances to the vertical plane of the sample
+			float s[3];
+			for(int k=0;k<3;++k)
+				s[k] = h[0] * d[k][1] - h[1] * d[k][0];
+
+			float& best = slopes[i];
+			for(int k=0;k<3;++k)
+			{
+				const int l = (k+1)%3;
+				if((s[k] >= 0.0f) == (s[l] >= 0.0f))
+					continue;
+				const float f = s[k] / (s[k] - s[l]);
+				const Vec3f q = d[k] + (d[l] - d[k]) * f;
+				//only the half-plane in the direction of the sample
+				const float dist = h[0] * q[0] + h[1] * q[1];
+				if(dist > 0.0f)
+					best = std::max(best, q[2] / dist);
+			}
+		}
+	}
+	return slopes;
+}
+
+void S3DHorizon::mergeChunk(QVector<float> &result, const QVector<float> &chunkResult)
+{
+	if(result.isEmpty())
+	{
+		result = chunkResult;
+		return;
+	}
+	for(int i=0;i<result.size();++i)
+		result[i] = std::max(result.at(i), chunkResult.at(i));
+}
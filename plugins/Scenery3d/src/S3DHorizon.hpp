@@ -0,0 +1,71 @@
+/*
+ * Stellarium Scenery3d Plug-in
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef S3DHORIZON_HPP
+#define S3DHORIZON_HPP
+
+#include "VecMath.hpp"
+
+#include <QVector>
+
+//! Computes the horizon profile of a 3D scene seen from the viewer position, i.e. the highest altitude covered
+//! by the scene geometry at each azimuth.
+//!
+//! Instead of casting rays at all altitudes, the vertical half-plane of each azimuth sample is intersected with the
+//! triangles: the altitude along the intersection segment is monotonic, so the highest covered altitude is found
+//! exactly at one of its end points. The triangles are split into chunks which are processed in parallel.
+class S3DHorizon
+{
+public:
+	//! A triangle mesh contributing to the profile, in the coordinate system of the scene
+	struct Mesh
+	{
+		//! The position of the first vertex
+		const float* positions;
+		//! The distance between two positions in floats
+		int stride;
+		const unsigned int* indices;
+		int indexCount;
+	};
+	typedef QVector<Mesh> MeshList;
+
+	//! The number of azimuth samples of the profile, for a resolution of 0.1°
+	static const int SAMPLE_COUNT = 3600;
+
+	//! Computes the profile seen from the eye position. Blocks until all chunks are processed.
+	//! @return the altitudes in radians, the first sample is North and the following are counted eastwards
+	//! (like in LandscapeMgr::setOcclusionHorizon()). Azimuths without geometry get -pi/2.
+	static QVector<float> compute(const MeshList& meshes, const Vec3f& eye);
+
+private:
+	struct Chunk
+	{
+		const Mesh* mesh;
+		int firstIndex;
+		int indexCount;
+		Vec3f eye;
+		//! The horizontal direction of each sample
+		const Vec2f* directions;
+	};
+
+	//! Returns the highest slope (z / horizontal distance) covered by the triangles of the chunk for each sample
+	static QVector<float> computeChunk(const Chunk& chunk);
+	static void mergeChunk(QVector<float>& result, const QVector<float>& chunkResult);
+};
+
+#endif // S3DHORIZON_HPP
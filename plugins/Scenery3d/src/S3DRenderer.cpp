@@ -40,6 +40,7 @@
 #include <QSettings>
 #include <stdexcept>
 #include <cmath>
+#include <algorithm>
 #include <QOpenGLShaderProgram>
 #include <QLoggingCategory>
 
@@ -77,7 +78,7 @@ S3DRenderer::S3DRenderer(QObject *parent)
       cubemapSize(1024),shadowmapSize(1024),wasMovedInLastDrawCall(false),
       core(Q_NULLPTR), landscapeMgr(Q_NULLPTR),
       backfaceCullState(true), blendEnabled(false), lastMaterial(Q_NULLPTR), curShader(Q_NULLPTR),
-      drawnTriangles(0), drawnModels(0), materialSwitches(0), shaderSwitches(0),
+      drawnTriangles(0), drawnModels(0), materialSwitches(0), shaderSwitches(0), culledModels(0),
       requiresCubemap(false), cubemappingUsedLastFrame(false),
       lazyDrawing(false), updateOnlyDominantOnMoving(true), updateSecondDominantOnMoving(true), needsMovementEndUpdate(false),
       needsCubemapUpdate(true), needsMovementUpdate(false), lazyInterval(2.0), lastCubemapUpdate(0.0), lastCubemapUpdateRealTime(0), lastMovementEndRealTime(0),
@@ -312,47 +313,81 @@ bool S3DRenderer::drawArrays(bool shading, bool blendAlphaAdditive)
 	transparentGroups.clear();
 	bool success = true;
 
-	//TODO optimize: clump models with same material together when first loading to minimize state changes
-
-	const S3DScene::ObjectList& objectList = currentScene->getObjects();
-	for(int i=0; i<objectList.size(); ++i)
+	//cull the scene BVH against the frusta of this pass
+	//in geometry shader mode, all 6 cube faces are rendered at once
+	visibleGroups.clear();
+	if(renderShaderParameters.geometryShader)
+		currentScene->cullGroups(cubeMVP,6,visibleGroups);
+	else
 	{
-		const StelOBJ::Object& obj = objectList.at(i);
-		const StelOBJ::MaterialGroupList& matGroups = obj.groups;
+		const QMatrix4x4 mvp = projectionMatrix * modelViewMatrix;
+		currentScene->cullGroups(&mvp,1,visibleGroups);
+	}
+	culledModels += currentScene->getGroupCount() - visibleGroups.size();
 
-		for(int j = 0; j < matGroups.size();++j)
-		{
-			const StelOBJ::MaterialGroup& matGroup = matGroups.at(j);
-			const S3DScene::Material* pMaterial = &currentScene->getMaterial(matGroup.materialIndex);
-			Q_ASSERT(pMaterial);
+	//collect the opaque groups, keyed by shader and material to minimize state changes
+	opaqueGroups.clear();
+	for(int i=0; i<visibleGroups.size(); ++i)
+	{
+		const StelOBJ::MaterialGroup* matGroup = visibleGroups.at(i);
+		const S3DScene::Material* pMaterial = &currentScene->getMaterial(matGroup->materialIndex);
+		Q_ASSERT(pMaterial);
 
-			if(pMaterial->traits.isFullyTransparent)
-				continue; //dont render fully invisible objects
+		if(pMaterial->traits.isFullyTransparent)
+			continue; //dont render fully invisible objects
 
-			if(shading)
-			{
-				if(pMaterial->traits.hasTransparency || pMaterial->traits.isFading)
-				{
-					//process transparent objects later, with Z sorting
-					transparentGroups.append(&matGroup);
-					continue;
-				}
-			}
-			else
+		if(shading)
+		{
+			if(pMaterial->traits.hasTransparency || pMaterial->traits.isFading)
 			{
-				//objects start casting shadows with at least 0.2 opacity
-				if(pMaterial->d * pMaterial->vis_fadeValue < 0.2f)
-					continue;
+				//process transparent objects later, with Z sorting
+				transparentGroups.append(matGroup);
+				continue;
 			}
+		}
+		else
+		{
+			//objects start casting shadows with at least 0.2 opacity
+			if(pMaterial->d * pMaterial->vis_fadeValue < 0.2f)
+				continue;
+		}
 
-			success = drawMaterialGroup(matGroup,shading,blendAlphaAdditive);
-			if(!success)
+		SortedGroup sg;
+		sg.shader = shaderManager.getShader(renderShaderParameters,pMaterial);
+		sg.group = matGroup;
+		sg.array = currentScene->getGroupArray(*matGroup);
+		opaqueGroups.append(sg);
+	}
+
+	std::sort(opaqueGroups.begin(),opaqueGroups.end(),[](const SortedGroup& a, const SortedGroup& b)
+	{
+		if(a.shader!=b.shader)
+			return a.shader<b.shader;
+		if(a.group->materialIndex!=b.group->materialIndex)
+			return a.group->materialIndex<b.group->materialIndex;
+		if(a.array!=b.array)
+			return a.array<b.array;
+		return a.group->startIndex<b.group->startIndex;
+	});
+
+	//draw opaque groups, merging consecutive index ranges of the same material into a single draw call
+	for(int i=0; i<opaqueGroups.size() && success;)
+	{
+		StelOBJ::MaterialGroup merged = *opaqueGroups.at(i).group;
+		const int array = opaqueGroups.at(i).array;
+		for(++i; i<opaqueGroups.size(); ++i)
+		{
+			const StelOBJ::MaterialGroup* next = opaqueGroups.at(i).group;
+			if(next->materialIndex!=merged.materialIndex || opaqueGroups.at(i).array!=array || next->startIndex!=merged.startIndex+merged.indexCount)
 				break;
+			merged.indexCount+=next->indexCount;
 		}
+
+		success = drawMaterialGroup(merged,shading,blendAlphaAdditive);
 	}
 
 	//sort and render transparent objects
-	if(transparentGroups.size()>0)
+	if(success && transparentGroups.size()>0)
 	{
 		zSortValue = currentScene->getEyePosition().toVec3f();
 		std::sort(transparentGroups.begin(),transparentGroups.end(),zSortFunction);
@@ -469,7 +504,7 @@ bool S3DRenderer::drawMaterialGroup(const StelOBJ::MaterialGroup &matGroup, bool
 	}
 
 
-	currentScene->glDraw(matGroup.startIndex,matGroup.indexCount);
+	currentScene->glDraw(matGroup);
 	++drawnModels;
 	drawnTriangles+=matGroup.indexCount/3;
 	return true;
@@ -1532,6 +1567,15 @@ void S3DRenderer::drawDebug()
 	str = QString("%1 mats, %2 shaders").arg(materialSwitches).arg(shaderSwitches);
 	painter.drawText(screen_x, screen_y, str);
 	screen_y -= 15.0f;
+	str = QString("%1 culled").arg(culledModels);
+	painter.drawText(screen_x, screen_y, str);
+	screen_y -= 15.0f;
+	if(currentScene->isTiled())
+	{
+		str = QString("%1 tiles, %2 MB").arg(currentScene->getResidentTileCount()).arg(currentScene->getTileMemory() / (1024.0 * 1024.0), 0, 'f', 1);
+		painter.drawText(screen_x, screen_y, str);
+		screen_y -= 15.0f;
+	}
 	str = "View Pos";
 	painter.drawText(screen_x, screen_y, str);
 	screen_y -= 15.0f;
@@ -2319,12 +2363,29 @@ void S3DRenderer::draw(StelCore* core, S3DScene &scene)
 	currentScene = &scene;
 
 	//reset render statistic
-	drawnTriangles = drawnModels = materialSwitches = shaderSwitches = 0;
+	drawnTriangles = drawnModels = materialSwitches = shaderSwitches = culledModels = 0;
 
 	requiresCubemap = core->getCurrentProjectionType() != StelCore::ProjectionPerspective;
 	//update projector from core
 	altAzProjector = core->getProjection(StelCore::FrameAltAz, StelCore::RefractionOff);
 
+	if(scene.isTiled())
+	{
+		//stream the tiles for the current position, the cube faces use a 90 degree field of view
+		const float pixelsPerRadian = requiresCubemap ? cubemapSize / 2.0f : altAzProjector->getPixelPerRadAtCenter();
+		//the cube map covers all directions, else the view cone reaches the corners of the viewport,
+		//with a margin for the viewport offset
+		float viewHalfAngle = M_PIf;
+		if(!requiresCubemap)
+		{
+			const float aspect = static_cast<float>(altAzProjector->getViewportWidth()) / static_cast<float>(altAzProjector->getViewportHeight());
+			const float tanHalfFov = std::tan(altAzProjector->getFov() / 360.0f * M_PIf);
+			viewHalfAngle = 1.2f * std::atan(tanHalfFov * std::sqrt(1.0f + aspect*aspect));
+		}
+		if(scene.updateTiles(pixelsPerRadian, scene.getViewDirection().toVec3f(), viewHalfAngle))
+			invalidateCubemap();
+	}
+
 	if(requiresCubemap)
 	{
 		if(!cubeMappingCreated || reinitCubemapping)
@@ -179,10 +179,22 @@ private:
 	QOpenGLShaderProgram* curShader;
 	QSet<QOpenGLShaderProgram*> initializedShaders;
 	QVector<const StelOBJ::MaterialGroup*> transparentGroups;
+	//! An opaque group with the shader it is drawn with, used for sorting
+	struct SortedGroup
+	{
+		QOpenGLShaderProgram* shader;
+		const StelOBJ::MaterialGroup* group;
+		int array;
+	};
+	//! Result of culling the scene BVH for the current pass
+	S3DScene::GroupList visibleGroups;
+	QVector<SortedGroup> opaqueGroups;
 
 	// debug info
 	int drawnTriangles,drawnModels;
 	int materialSwitches, shaderSwitches;
+	//! Groups rejected by BVH culling, summed over all passes
+	int culledModels;
 
 	/// ---- Cubemapping variables ----
 	bool requiresCubemap; //true if cubemapping is required (if projection is anything else than Perspective)
@@ -25,8 +25,14 @@
 #include "StelTexture.hpp"
 #include "StelTextureMgr.hpp"
 #include "StelUtils.hpp"
+#include "StelFileMgr.hpp"
 
 #include <QVector3D>
+#include <QVector4D>
+#include <QElapsedTimer>
+#include <QVarLengthArray>
+
+#include <algorithm>
 
 Q_LOGGING_CATEGORY(s3dscene, "stel.plugin.scenery3d.s3dscene")
 
@@ -201,12 +207,18 @@ bool S3DScene::Material::updateFadeInfo(double currentJD)
 
 S3DScene::S3DScene(const SceneInfo &info)
 	: glReady(false), info(info),
-	  viewDirection(1.0,0.0,0.0), position(0.0,0.0,0.0), eye_height(1.65), eyePosition(0.0,0.0,1.65)
+	  viewDirection(1.0,0.0,0.0), position(0.0,0.0,0.0), eye_height(1.65), eyePosition(0.0,0.0,1.65),
+	  activeGroupCount(0), boundTileLod(-1), tileFrame(0), tileMemory(0), tileBudgetWarned(false), groundTiles(16)
 {
 	//setup main load transform matrix
 	zRot2Grid = (info.zRotateMatrix*info.obj2gridMatrix).convertToQMatrix();
 }
 
+S3DScene::~S3DScene()
+{
+	qDeleteAll(residentLods);
+}
+
 void S3DScene::setModel(const StelOBJ &model)
 {
 	modelData = model;
@@ -227,6 +239,29 @@ void S3DScene::setModel(const StelOBJ &model)
 	//copy objects
 	objects = modelData.getObjectList();
 
+	//keep only the positions for the horizon, the full vertex data is released after the GL upload
+	const StelOBJ::VertexList& vertices = modelData.getVertexList();
+	horizonPositions.resize(vertices.size());
+	for(int i=0;i<vertices.size();++i)
+		horizonPositions[i] = Vec3f(vertices.at(i).position);
+	horizonIndices = modelData.getIndexList();
+
+	//create the BVH over all material groups, used for culling
+	QElapsedTimer timer;
+	timer.start();
+	groups.clear();
+	bvh.clear();
+	for(int i=0;i<objects.size();++i)
+		groups+=objects.at(i).groups;
+	if(!groups.isEmpty())
+		buildBVH(0,groups.size());
+	qCDebug(s3dscene)<<"Created BVH with"<<bvh.size()<<"nodes for"<<groups.size()<<"material groups in"<<timer.elapsed()<<"ms";
+
+	initFromSceneAABB();
+}
+
+void S3DScene::initFromSceneAABB()
+{
 	if(info.hasLocation())
 	{
 		if(info.altitudeFromModel)
@@ -272,6 +307,379 @@ void S3DScene::setModel(const StelOBJ &model)
 	}
 }
 
+bool S3DScene::setTiledModel(const QString &storeFile, const QByteArray &signature)
+{
+	tileLoadTimer.start();
+	if(!tileStore.open(storeFile, signature))
+		return false;
+
+	sceneAABB = tileStore.getBoundingBox();
+
+	//the textures are only loaded when a tile using the material is displayed
+	const StelOBJ::MaterialList objMats = tileStore.getMaterials(info.fullPath);
+	materials.clear();
+	materials.reserve(objMats.size());
+	for(int i=0;i<objMats.size();++i)
+		materials.append(objMats[i]);
+	textureStates.fill(TexturesNotLoaded, materials.size());
+
+	if(tileStore.hasGround() && info.groundNullHeightFromModel)
+		info.groundNullHeight = tileStore.getGroundMinZ();
+
+	initFromSceneAABB();
+	return true;
+}
+
+bool S3DScene::convertToTiles(StelOBJ &model, StelOBJ *ground, const QString &storeFile, const QByteArray &signature) const
+{
+	//the null height is taken from the untransformed ground, like in setGround
+	float groundMinZ = 0.0f;
+	if(ground)
+	{
+		groundMinZ = ground->getAABBox().min[2];
+		if(ground != &model)
+			ground->transform(zRot2Grid,true);
+	}
+	model.transform(zRot2Grid);
+
+	return S3DTileStore::convert(model, ground, groundMinZ, info.fullPath, signature, storeFile);
+}
+
+QByteArray S3DScene::getTileSignature() const
+{
+	//the scene settings which affect the conversion are all in the ini file, but the meridian convergence
+	//may also depend on the landscape, so the transformation is added too
+	QStringList files;
+	files << StelFileMgr::findFile(info.fullPath + "/scenery3d.ini");
+	files << StelFileMgr::findFile(info.fullPath + "/" + info.modelScenery);
+	if(!info.modelGround.isEmpty() && info.modelGround != "NULL")
+		files << StelFileMgr::findFile(info.fullPath + "/" + info.modelGround);
+	return S3DTileStore::computeSignature(files, QByteArray(reinterpret_cast<const char*>(zRot2Grid.constData()), 16 * sizeof(float)));
+}
+
+S3DScene::TileLod* S3DScene::findTileLod(int tile, int lod) const
+{
+	const int lodCount = static_cast<int>(tileStore.getTile(tile).lodCount);
+	//prefer coarser levels, which are usually loaded first
+	for(int l = lod; l<lodCount; ++l)
+	{
+		TileLod* res = residentLods.value(tile*256 + l, Q_NULLPTR);
+		if(res)
+			return res;
+	}
+	for(int l = lod-1; l>=0; --l)
+	{
+		TileLod* res = residentLods.value(tile*256 + l, Q_NULLPTR);
+		if(res)
+			return res;
+	}
+	return Q_NULLPTR;
+}
+
+S3DScene::TileLod* S3DScene::loadTileLod(int tile, int lod)
+{
+	const S3DTileStore::Lod& data = tileStore.getLod(tileStore.getTile(tile), lod);
+
+	TileLod* res = new TileLod();
+	res->tile = tile;
+	res->lod = lod;
+	res->lastUsedFrame = tileFrame;
+	res->memory = 0;
+	//on errors the level is kept without groups, so that it is not loaded again
+	residentLods.insert(tile*256 + lod, res);
+
+	const int vertexCount = static_cast<int>(data.vertexCount);
+	const int indexCount = static_cast<int>(data.indexCount);
+	if(!res->array.load(tileStore.getVertices(data), vertexCount, tileStore.getIndices(data), indexCount))
+	{
+		qCWarning(s3dscene)<<"Could not load level"<<lod<<"of tile"<<tile;
+		return res;
+	}
+	res->memory = sizeof(StelOBJ::Vertex) * static_cast<size_t>(vertexCount) + res->array.getIndexBufferTypeSize() * static_cast<size_t>(indexCount);
+	tileMemory += res->memory;
+
+	const S3DTileStore::Group* tileGroups = tileStore.getGroups(data);
+	res->groups.resize(static_cast<int>(data.groupCount));
+	for(int i=0;i<res->groups.size();++i)
+	{
+		const S3DTileStore::Group& src = tileGroups[i];
+		StelOBJ::MaterialGroup& grp = res->groups[i];
+		grp.startIndex = static_cast<int>(src.startIndex);
+		grp.indexCount = static_cast<int>(src.indexCount);
+		grp.materialIndex = src.materialIndex;
+		grp.centroid = Vec3f(src.centroid[0], src.centroid[1], src.centroid[2]);
+		grp.boundingbox = AABBox(Vec3f(src.bboxMin[0], src.bboxMin[1], src.bboxMin[2]), Vec3f(src.bboxMax[0], src.bboxMax[1], src.bboxMax[2]));
+		updateMaterialTextures(grp.materialIndex);
+	}
+	return res;
+}
+
+void S3DScene::updateMaterialTextures(int materialIndex)
+{
+	Material& mat = materials[materialIndex];
+	TextureState& state = textureStates[materialIndex];
+	if(state == TexturesNotLoaded)
+	{
+		mat.loadTexturesAsync();
+		state = TexturesLoading;
+	}
+	if(state == TexturesLoading)
+	{
+		const StelTextureSP textures[] = { mat.tex_Kd, mat.tex_Ke, mat.tex_bump, mat.tex_height };
+		for(const auto& tex : textures)
+		{
+			//bind() uploads the texture once its image is loaded, without blocking
+			if(tex && !tex->bind() && !tex->hasError())
+				return;
+		}
+
+		//all textures finished loading, this does not block anymore
+		finalizeTexture(mat.tex_Kd);
+		finalizeTexture(mat.tex_Ke);
+		finalizeTexture(mat.tex_bump);
+		finalizeTexture(mat.tex_height);
+		mat.fixup();
+		if(mat.traits.hasTimeFade)
+			mat.updateFadeInfo(StelApp::getInstance().getCore()->getJD());
+		state = TexturesReady;
+	}
+}
+
+S3DHorizon::MeshList S3DScene::getHorizonMeshes(const Vec3f &eye) const
+{
+	S3DHorizon::MeshList meshes;
+	if(!isTiled())
+	{
+		if(!horizonIndices.isEmpty())
+		{
+			S3DHorizon::Mesh mesh;
+			mesh.positions = horizonPositions.constData()->v;
+			mesh.stride = 3;
+			mesh.indices = horizonIndices.constData();
+			mesh.indexCount = horizonIndices.size();
+			meshes.append(mesh);
+		}
+		return meshes;
+	}
+
+	//the angular error of the simplified levels should stay below one sample of the profile
+	const float maxAngle = static_cast<float>(2.0 * M_PI / S3DHorizon::SAMPLE_COUNT);
+	for(int t=0;t<tileStore.getTileCount();++t)
+	{
+		const S3DTileStore::Tile& tile = tileStore.getTile(t);
+		if(tile.lodCount == 0)
+			continue;
+
+		float distSq = 0.0f;
+		for(int i=0;i<3;++i)
+		{
+			const float d = std::max(std::max(tile.bboxMin[i] - eye[i], eye[i] - tile.bboxMax[i]), 0.0f);
+			distSq += d*d;
+		}
+		const float dist = std::sqrt(distSq);
+		int lod = 0;
+		for(int l = static_cast<int>(tile.lodCount) - 1; l>0; --l)
+		{
+			if(tileStore.getLod(tile, l).geometricError <= maxAngle * dist)
+			{
+				lod = l;
+				break;
+			}
+		}
+
+		const S3DTileStore::Lod& data = tileStore.getLod(tile, lod);
+		S3DHorizon::Mesh mesh;
+		mesh.positions = tileStore.getVertices(data)->position;
+		mesh.stride = static_cast<int>(sizeof(StelOBJ::Vertex) / sizeof(float));
+		mesh.indices = tileStore.getIndices(data);
+		mesh.indexCount = static_cast<int>(data.indexCount);
+		meshes.append(mesh);
+	}
+	return meshes;
+}
+
+bool S3DScene::updateTiles(float pixelsPerRadian, const Vec3f& viewDir, float viewHalfAngle)
+{
+	if(!isTiled())
+		return false;
+
+	// Maximal number of tile levels loaded into GL per frame, to keep the frame rate while streaming
+	static const int MAX_UPLOADS_PER_FRAME = 4;
+
+	++tileFrame;
+	bool changed = false;
+	const Vec3f eye = eyePosition.toVec3f();
+	const size_t budget = static_cast<size_t>(info.tileMemoryBudget) * 1024 * 1024;
+
+	//select the wanted level of each tile in range
+	struct TileRequest
+	{
+		int tile;
+		int lod;
+		float distance;
+		bool visible;
+	};
+	QVector<TileRequest> requests;
+	for(int t=0;t<tileStore.getTileCount();++t)
+	{
+		const S3DTileStore::Tile& tile = tileStore.getTile(t);
+		if(tile.lodCount == 0)
+			continue;
+
+		//distance from the eye to the tile box
+		float distSq = 0.0f;
+		for(int i=0;i<3;++i)
+		{
+			const float d = std::max(std::max(tile.bboxMin[i] - eye[i], eye[i] - tile.bboxMax[i]), 0.0f);
+			distSq += d*d;
+		}
+		const float dist = std::sqrt(distSq);
+		if(dist > info.camFarZ)
+			continue;
+
+		//the bounding sphere of the tile against the view cone
+		bool visible = true;
+		if(viewHalfAngle < M_PIf)
+		{
+			const Vec3f center((tile.bboxMin[0] + tile.bboxMax[0]) * 0.5f, (tile.bboxMin[1] + tile.bboxMax[1]) * 0.5f, (tile.bboxMin[2] + tile.bboxMax[2]) * 0.5f);
+			const float radius = 0.5f * std::sqrt((tile.bboxMax[0] - tile.bboxMin[0]) * (tile.bboxMax[0] - tile.bboxMin[0]) +
+							      (tile.bboxMax[1] - tile.bboxMin[1]) * (tile.bboxMax[1] - tile.bboxMin[1]) +
+							      (tile.bboxMax[2] - tile.bboxMin[2]) * (tile.bboxMax[2] - tile.bboxMin[2]));
+			Vec3f toCenter = center - eye;
+			const float centerDist = toCenter.length();
+			if(centerDist > radius)
+			{
+				toCenter /= centerDist;
+				const float angle = std::acos(qBound(-1.0f, toCenter.dot(viewDir), 1.0f));
+				visible = angle - std::asin(radius / centerDist) <= viewHalfAngle;
+			}
+		}
+
+		//the coarsest level whose geometric error projects to less than the allowed screen-space error.
+		//The tiles outside of the view only need their coarsest level, for the shadows and for turning around
+		const float allowedError = info.lodMaxError * std::max(dist, info.camNearZ) / pixelsPerRadian;
+		int lod = static_cast<int>(tile.lodCount) - 1;
+		if(visible)
+		{
+			lod = 0;
+			for(int l = static_cast<int>(tile.lodCount) - 1; l>0; --l)
+			{
+				if(tileStore.getLod(tile, l).geometricError <= allowedError)
+				{
+					lod = l;
+					break;
+				}
+			}
+		}
+		requests.append({t, lod, dist, visible});
+	}
+	//the visible tiles first, the nearest first
+	std::sort(requests.begin(), requests.end(), [](const TileRequest& a, const TileRequest& b) {
+		return a.visible != b.visible ? a.visible : a.distance < b.distance;
+	});
+
+	//the levels which are currently displayed must not be released for loading others
+	for(const auto& req : requests)
+	{
+		TileLod* tl = findTileLod(req.tile, req.lod);
+		if(tl)
+			tl->lastUsedFrame = tileFrame;
+	}
+
+	//first make sure each tile has some level loaded, beginning with the nearest tiles, then refine them.
+	//A level is only loaded when it fits into the memory budget, after releasing the unused levels
+	int uploads = 0;
+	bool overBudget = false;
+	auto load = [this, budget, &uploads, &overBudget](int tile, int lod)
+	{
+		const S3DTileStore::Lod& data = tileStore.getLod(tileStore.getTile(tile), lod);
+		const size_t memory = sizeof(StelOBJ::Vertex) * data.vertexCount + sizeof(unsigned int) * data.indexCount;
+		if(tileMemory + memory > budget && !releaseTileLods(budget - std::min(memory, budget)))
+		{
+			overBudget = true;
+			return;
+		}
+		loadTileLod(tile, lod)->lastUsedFrame = tileFrame;
+		++uploads;
+	};
+	for(int i=0;i<requests.size() && uploads<MAX_UPLOADS_PER_FRAME;++i)
+	{
+		const TileRequest& req = requests.at(i);
+		if(!findTileLod(req.tile, req.lod))
+			load(req.tile, static_cast<int>(tileStore.getTile(req.tile).lodCount) - 1);
+	}
+	for(int i=0;i<requests.size() && uploads<MAX_UPLOADS_PER_FRAME;++i)
+	{
+		const TileRequest& req = requests.at(i);
+		if(!residentLods.contains(req.tile*256 + req.lod))
+			load(req.tile, req.lod);
+	}
+	changed = uploads>0;
+	if(overBudget && !tileBudgetWarned)
+	{
+		qCWarning(s3dscene)<<"The tile memory budget of"<<info.tileMemoryBudget<<"MB is too small for this view, increase tile_memory_budget";
+		tileBudgetWarned = true;
+	}
+
+	//find the levels to draw
+	activeLods.clear();
+	activeGroupCount = 0;
+	for(const auto& req : requests)
+	{
+		TileLod* tl = findTileLod(req.tile, req.lod);
+		if(!tl)
+			continue;
+		tl->lastUsedFrame = tileFrame;
+		for(int i=0;i<tl->groups.size();++i)
+		{
+			StelOBJ::MaterialGroup& grp = tl->groups[i];
+			grp.objectIndex = activeLods.size();
+			if(textureStates.at(grp.materialIndex) != TexturesReady)
+			{
+				updateMaterialTextures(grp.materialIndex);
+				changed = changed || textureStates.at(grp.materialIndex) == TexturesReady;
+			}
+		}
+		activeGroupCount += tl->groups.size();
+		activeLods.append(tl);
+	}
+
+	if(tileLoadTimer.isValid() && !activeLods.isEmpty())
+	{
+		qCDebug(s3dscene)<<"First tiles displayed"<<tileLoadTimer.elapsed()<<"ms after opening the tile file";
+		tileLoadTimer.invalidate();
+	}
+
+	//the budget may have been lowered
+	if(tileMemory > budget)
+		releaseTileLods(budget);
+
+	return changed;
+}
+
+bool S3DScene::releaseTileLods(size_t maxMemory)
+{
+	if(tileMemory <= maxMemory)
+		return true;
+
+	//release the least recently used levels, which are not displayed
+	QVector<TileLod*> unused;
+	for(auto* tl : residentLods)
+	{
+		if(tl->lastUsedFrame != tileFrame)
+			unused.append(tl);
+	}
+	std::sort(unused.begin(), unused.end(), [](const TileLod* a, const TileLod* b) { return a->lastUsedFrame < b->lastUsedFrame; });
+	for(int i=0;i<unused.size() && tileMemory>maxMemory;++i)
+	{
+		TileLod* tl = unused.at(i);
+		residentLods.remove(tl->tile*256 + tl->lod);
+		tileMemory -= tl->memory;
+		delete tl;
+	}
+	return tileMemory <= maxMemory;
+}
+
 void S3DScene::setGround(const StelOBJ &ground)
 {
 	//we only need to retain the position data for the ground
@@ -289,7 +697,7 @@ void S3DScene::setGround(const StelOBJ &ground)
 
 float S3DScene::getGroundHeightAtViewer() const
 {
-	return heightmap.getHeight(position.v[0],position.v[1]);
+	return getGroundHeight(static_cast<float>(position.v[0]),static_cast<float>(position.v[1]));
 }
 
 Vec3d S3DScene::getGridPosition() const
@@ -315,9 +723,6 @@ void S3DScene::setGridPosition(const Vec3d &gridPos)
 
 bool S3DScene::glLoad()
 {
-	bool ok = glArray.load(&modelData);
-	modelData.clear();
-
 	//set this here, to respect models without ground OBJ
 	heightmap.setNullHeight(info.groundNullHeight);
 
@@ -325,6 +730,16 @@ bool S3DScene::glLoad()
 	position[2] = getGroundHeightAtViewer();
 	recalcEyePos();
 
+	if(isTiled())
+	{
+		//the tiles and their textures are loaded in updateTiles
+		glReady = true;
+		return true;
+	}
+
+	bool ok = glArray.load(&modelData);
+	modelData.clear();
+
 	double currentJD = StelApp::getInstance().getCore()->getJD();
 
 	//make sure textures are loaded
@@ -349,6 +764,73 @@ bool S3DScene::glLoad()
 	return ok;
 }
 
+void S3DScene::glBind()
+{
+	if(isTiled())
+		boundTileLod = -1; //bound on demand in glDraw
+	else
+		glArray.bind();
+}
+
+void S3DScene::glRelease()
+{
+	if(isTiled())
+	{
+		if(boundTileLod>=0)
+			activeLods.at(boundTileLod)->array.release();
+		boundTileLod = -1;
+	}
+	else
+		glArray.release();
+}
+
+void S3DScene::glDraw(const StelOBJ::MaterialGroup &grp)
+{
+	if(isTiled())
+	{
+		if(grp.objectIndex != boundTileLod)
+		{
+			if(boundTileLod>=0)
+				activeLods.at(boundTileLod)->array.release();
+			boundTileLod = grp.objectIndex;
+			activeLods.at(boundTileLod)->array.bind();
+		}
+		activeLods.at(boundTileLod)->array.draw(grp.startIndex,grp.indexCount);
+	}
+	else
+		glArray.draw(grp.startIndex,grp.indexCount);
+}
+
+float S3DScene::getGroundHeight(float x, float y) const
+{
+	if(!isTiled())
+		return heightmap.getHeight(x,y);
+
+	const int tile = tileStore.hasGround() ? tileStore.getTileAt(x,y) : -1;
+	if(tile<0)
+		return static_cast<float>(info.groundNullHeight);
+
+	Heightmap* map = groundTiles.object(tile);
+	if(!map)
+	{
+		//create the heightmap of the tile from the mapped ground triangles
+		const S3DTileStore::Ground& ground = tileStore.getGround(tile);
+		if(ground.indexCount == 0)
+			return static_cast<float>(info.groundNullHeight);
+
+		Heightmap::PosList posList(static_cast<int>(ground.vertexCount));
+		std::copy(tileStore.getGroundPositions(ground), tileStore.getGroundPositions(ground) + ground.vertexCount, posList.begin());
+		Heightmap::IdxList idxList(static_cast<int>(ground.indexCount));
+		std::copy(tileStore.getGroundIndices(ground), tileStore.getGroundIndices(ground) + ground.indexCount, idxList.begin());
+
+		map = new Heightmap();
+		map->setMeshData(idxList, posList);
+		map->setNullHeight(static_cast<float>(info.groundNullHeight));
+		groundTiles.insert(tile, map);
+	}
+	return map->getHeight(x,y);
+}
+
 void S3DScene::moveViewer(const Vec3d &moveView)
 {
 	//get the azimuth angle of the current view vector
@@ -363,7 +845,7 @@ void S3DScene::moveViewer(const Vec3d &moveView)
 	eye_height+= moveWorld[2];
 	position[0]+= moveWorld[0];
 	position[1]+= moveWorld[1];
-	position[2] = heightmap.getHeight(position[0],position[1]);
+	position[2] = getGroundHeight(static_cast<float>(position[0]),static_cast<float>(position[1]));
 	recalcEyePos();
 }
 
@@ -375,10 +857,152 @@ void S3DScene::setViewerPosition(const Vec3d &pos)
 
 void S3DScene::setViewerPositionOnHeightmap(const Vec2d &pos)
 {
-	position = Vec3d(pos[0], pos[1], heightmap.getHeight(pos[0],pos[1]));
+	position = Vec3d(pos[0], pos[1], getGroundHeight(static_cast<float>(pos[0]),static_cast<float>(pos[1])));
 	recalcEyePos();
 }
 
+void S3DScene::buildBVH(int first, int count)
+{
+	const int nodeIdx = bvh.size();
+	BVHNode node;
+	node.firstGroup = first;
+	node.groupCount = count;
+	node.skip = nodeIdx + 1;
+	AABBox centroidBox;
+	for(int i=first;i<first+count;++i)
+	{
+		node.box.expand(groups.at(i).boundingbox);
+		centroidBox.expand(groups.at(i).centroid);
+	}
+	bvh.append(node);
+
+	//small nodes are leaves, this keeps the tree shallow for scenes made of many tiny groups
+	const int maxLeafSize = 4;
+	if(count<=maxLeafSize)
+		return;
+
+	//split at the median of the group centroids along the longest axis
+	const Vec3f extents = centroidBox.max - centroidBox.min;
+	int axis = 0;
+	if(extents[1]>extents[axis]) axis = 1;
+	if(extents[2]>extents[axis]) axis = 2;
+
+	const int half = count/2;
+	std::nth_element(groups.begin()+first, groups.begin()+first+half, groups.begin()+first+count,
+			 [axis](const StelOBJ::MaterialGroup& a, const StelOBJ::MaterialGroup& b)
+	{
+		return a.centroid[axis] < b.centroid[axis];
+	});
+
+	buildBVH(first, half);
+	buildBVH(first+half, count-half);
+	bvh[nodeIdx].skip = bvh.size();
+}
+
+namespace
+{
+	enum CullResult { Outside, Intersecting, Inside };
+
+	//! Tests the box against the frusta given by groups of 6 planes.
+	//! The box is visible if it touches any of the frusta.
+	CullResult classifyBox(const AABBox& box, const QVector4D* planes, int count)
+	{
+		CullResult result = Outside;
+		for(int f=0;f<count && result!=Inside;++f)
+		{
+			CullResult frustumResult = Inside;
+			for(int p=f*6;p<f*6+6;++p)
+			{
+				const QVector4D& pl = planes[p];
+				//the vertex furthest along the plane normal
+				const float pDist = pl.x()*(pl.x()>=0.0f?box.max[0]:box.min[0]) +
+						    pl.y()*(pl.y()>=0.0f?box.max[1]:box.min[1]) +
+						    pl.z()*(pl.z()>=0.0f?box.max[2]:box.min[2]) + pl.w();
+				if(pDist<0.0f)
+				{
+					frustumResult = Outside;
+					break;
+				}
+				//the vertex nearest along the plane normal
+				const float nDist = pl.x()*(pl.x()>=0.0f?box.min[0]:box.max[0]) +
+						    pl.y()*(pl.y()>=0.0f?box.min[1]:box.max[1]) +
+						    pl.z()*(pl.z()>=0.0f?box.min[2]:box.max[2]) + pl.w();
+				if(nDist<0.0f)
+					frustumResult = Intersecting;
+			}
+			result = std::max(result, frustumResult);
+		}
+		return result;
+	}
+}
+
+void S3DScene::cullGroups(const QMatrix4x4 *mvp, int count, GroupList &visible) const
+{
+	//extract the frustum planes from the clip space transforms (Gribb/Hartmann)
+	//the plane normals point into the frustum
+	QVarLengthArray<QVector4D,36> planes;
+	for(int i=0;i<count;++i)
+	{
+		const QVector4D r0 = mvp[i].row(0);
+		const QVector4D r1 = mvp[i].row(1);
+		const QVector4D r2 = mvp[i].row(2);
+		const QVector4D r3 = mvp[i].row(3);
+		planes.append(r3+r0);
+		planes.append(r3-r0);
+		planes.append(r3+r1);
+		planes.append(r3-r1);
+		planes.append(r3+r2);
+		planes.append(r3-r2);
+	}
+
+	if(isTiled())
+	{
+		//test the tiles, then the groups of the partially visible tiles
+		for(const auto* tl : activeLods)
+		{
+			const S3DTileStore::Tile& tile = tileStore.getTile(tl->tile);
+			const AABBox tileBox(Vec3f(tile.bboxMin[0], tile.bboxMin[1], tile.bboxMin[2]), Vec3f(tile.bboxMax[0], tile.bboxMax[1], tile.bboxMax[2]));
+			const CullResult result = classifyBox(tileBox, planes.constData(), count);
+			if(result==Outside)
+				continue;
+			for(const auto& grp : tl->groups)
+			{
+				//groups are only drawn once their textures are loaded
+				if(textureStates.at(grp.materialIndex) != TexturesReady)
+					continue;
+				if(result==Inside || classifyBox(grp.boundingbox, planes.constData(), count)!=Outside)
+					visible.append(&grp);
+			}
+		}
+		return;
+	}
+
+	int nodeIdx = 0;
+	while(nodeIdx<bvh.size())
+	{
+		const BVHNode& node = bvh.at(nodeIdx);
+		const CullResult result = classifyBox(node.box, planes.constData(), count);
+
+		if(result==Outside)
+		{
+			//skip the whole subtree
+			nodeIdx = node.skip;
+		}
+		else if(result==Inside || node.skip == nodeIdx + 1)
+		{
+			//the subtree is completely visible, or this is a leaf
+			for(int i=node.firstGroup;i<node.firstGroup+node.groupCount;++i)
+				visible.append(&groups.at(i));
+			nodeIdx = node.skip;
+		}
+		else
+		{
+			//descend into the first child
+			++nodeIdx;
+		}
+	}
+}
+
 void S3DScene::finalizeTexture(StelTextureSP &tex)
 {
 	if(tex)
@@ -26,7 +26,11 @@
 #include "StelOpenGLArray.hpp"
 #include "SceneInfo.hpp"
 #include "Heightmap.hpp"
+#include "S3DTileStore.hpp"
+#include "S3DHorizon.hpp"
 
+#include <QCache>
+#include <QElapsedTimer>
 #include <cfloat>
 
 Q_DECLARE_LOGGING_CATEGORY(s3dscene)
@@ -106,17 +110,62 @@ public:
 	typedef QVector<Material> MaterialList;
 	//for now, this does not use custom extensions...
 	typedef StelOBJ::ObjectList ObjectList;
+	typedef QVector<const StelOBJ::MaterialGroup*> GroupList;
 
 	explicit S3DScene(const SceneInfo& info);
+	~S3DScene();
 
 	void setModel(const StelOBJ& model);
 	void setGround(const StelOBJ& ground);
 
+	//! Sets up the scene from a tile file instead of setModel() and setGround().
+	//! The geometry, textures and heightmap of the tiles are then loaded on demand by updateTiles().
+	//! @param signature If not empty, the file must have been converted with this signature, see getTileSignature()
+	//! @return false if the file does not exist, is invalid or out of date
+	bool setTiledModel(const QString& storeFile, const QByteArray& signature);
+	//! Converts the model and the optional ground model (which may be the same object) into a tile file,
+	//! which can then be used with setTiledModel(). The models are transformed in place.
+	bool convertToTiles(StelOBJ& model, StelOBJ* ground, const QString& storeFile, const QByteArray& signature) const;
+	//! Returns the signature of the scene's OBJ files and settings used for converting them to tiles
+	QByteArray getTileSignature() const;
+	//! Returns true if the scene uses a tile file
+	bool isTiled() const { return tileStore.isOpen(); }
+	//! Selects the level of detail of each tile from the current eye position, and uploads or releases
+	//! the tile geometry and textures accordingly. Must be called with a valid GL context before drawing.
+	//! The tiles outside of the view cone are only loaded at their coarsest level, after the visible tiles.
+	//! The levels are only loaded while they fit into the tile memory budget of the scene.
+	//! @param pixelsPerRadian The scale of the projection at the screen center, used for the screen-space error
+	//! @param viewDir The normalized view direction, in model coordinates
+	//! @param viewHalfAngle The angle between the view direction and the view corners, in radians.
+	//! Use M_PI when all directions are visible, e.g. for cube maps.
+	//! @return true if the displayed geometry changed
+	bool updateTiles(float pixelsPerRadian, const Vec3f& viewDir, float viewHalfAngle);
+	//! Returns the number of tile levels currently loaded into GL
+	int getResidentTileCount() const { return residentLods.size(); }
+	//! Returns the GL memory used by the loaded tiles, in bytes
+	size_t getTileMemory() const { return tileMemory; }
+
 	const SceneInfo& getSceneInfo() const { return info; }
 
 	MaterialList& getMaterialList() { return materials; }
 	const Material& getMaterial(int index) const { return materials.at(index); }
 	const ObjectList& getObjects() const { return objects; }
+	//! Returns the total number of material groups in the scene (which are currently loaded, in tiled scenes)
+	inline int getGroupCount() const { return isTiled() ? activeGroupCount : groups.size(); }
+	//! Returns the GL array the group is stored in. In tiled scenes, this is the objectIndex of the group.
+	//! Groups with the same array and consecutive indices can be drawn together.
+	inline int getGroupArray(const StelOBJ::MaterialGroup& grp) const { return isTiled() ? grp.objectIndex : 0; }
+
+	//! Appends the material groups which may be visible through at least one of the given
+	//! clip space transforms (projection * modelview matrices) to the list,
+	//! using the bounding volume hierarchy created in setModel.
+	//! The returned pointers stay valid as long as the model is not changed.
+	void cullGroups(const QMatrix4x4* mvp, int count, GroupList& visible) const;
+
+	//! Returns the geometry used for computing the horizon profile seen from the eye position.
+	//! In tiled scenes, the coarsest levels of detail which are still accurate at the profile resolution are used.
+	//! The meshes point into the scene data, and stay valid as long as the scene exists.
+	S3DHorizon::MeshList getHorizonMeshes(const Vec3f& eye) const;
 
 	//! Moves the viewer according to the given move vector
 	//!  (which is specified relative to the view direction and current position)
@@ -149,14 +198,65 @@ public:
 	//! Returns true if the scene is ready for GL rendering (glLoad succeded)
 	bool isGLReady() const { return glReady; }
 	// Basic wrappers alround StelOpenGLArray
-	inline void glBind() { glArray.bind(); }
-	inline void glRelease() { glArray.release(); }
-	inline void glDraw(int offset, int count) const { glArray.draw(offset,count); }
+	void glBind();
+	void glRelease();
+	//! Draws the given group, which must have been returned by cullGroups
+	void glDraw(const StelOBJ::MaterialGroup& grp);
 
 private:
+	//! A node of the bounding volume hierarchy, stored in depth-first order
+	struct BVHNode
+	{
+		//! Bounding box of all groups in the subtree
+		AABBox box;
+		//! Index of the next node after this subtree
+		int skip;
+		//! Range of the subtree in the groups list
+		int firstGroup, groupCount;
+	};
+
+	//! A level of a tile which is loaded into GL
+	struct TileLod
+	{
+		int tile;
+		int lod;
+		StelOpenGLArray array;
+		//! The material groups, the objectIndex is set to the index in activeLods
+		QVector<StelOBJ::MaterialGroup> groups;
+		//! The GL memory used by the array
+		size_t memory;
+		//! The last updateTiles call which used this level
+		int lastUsedFrame;
+	};
+
+	//! Loading state of the textures of a material in tiled scenes
+	enum TextureState
+	{
+		TexturesNotLoaded, TexturesLoading, TexturesReady
+	};
+
 	inline void recalcEyePos() { eyePosition = position; eyePosition[2]+=eye_height; }
+	//! Recursively builds the BVH for the given range of the groups list, reordering it
+	void buildBVH(int first, int count);
+	//! Sets up the viewer position, location and shadow parameters from the scene bounding box
+	void initFromSceneAABB();
+	//! Returns the height of the ground at the given position, from the heightmap of the tile in tiled scenes
+	float getGroundHeight(float x, float y) const;
+	//! Loads the given level of a tile into GL
+	TileLod* loadTileLod(int tile, int lod);
+	//! Returns the loaded level of the tile which is nearest to the wanted level, or Q_NULLPTR
+	TileLod* findTileLod(int tile, int lod) const;
+	//! Releases the least recently used levels which are not displayed in the current frame,
+	//! until the tiles use at most the given GL memory. Returns false if this was not possible.
+	bool releaseTileLods(size_t maxMemory);
+	//! Starts loading the textures of the material, or finalizes them once they are loaded
+	void updateMaterialTextures(int materialIndex);
+
 	MaterialList materials;
 	ObjectList objects;
+	//! All material groups of the objects, in the order of the BVH leaves
+	QVector<StelOBJ::MaterialGroup> groups;
+	QVector<BVHNode> bvh;
 
 
 	bool glReady;
@@ -177,9 +277,30 @@ private:
 
 	//the model data is only retained before loaded into GL
 	StelOBJ modelData;
+	//the positions and indices of the model are kept for the horizon profile
+	Heightmap::PosList horizonPositions;
+	Heightmap::IdxList horizonIndices;
 	Heightmap heightmap;
 	StelOpenGLArray glArray;
 
+	// tiled scenes
+	S3DTileStore tileStore;
+	//! Loaded tile levels, the key is tile * 256 + lod
+	QHash<int, TileLod*> residentLods;
+	//! The tile levels drawn in the current frame
+	QVector<TileLod*> activeLods;
+	int activeGroupCount;
+	int boundTileLod;
+	int tileFrame;
+	size_t tileMemory;
+	//! True once the user was warned that the tile memory budget is too small
+	bool tileBudgetWarned;
+	QVector<TextureState> textureStates;
+	//! The heightmaps of the recently used tiles
+	mutable QCache<int, Heightmap> groundTiles;
+	//! Measures the time until the first tiles are displayed
+	QElapsedTimer tileLoadTimer;
+
 	static void finalizeTexture(StelTextureSP& tex);
 };
 
@@ -0,0 +1,620 @@
+/*
+ * Stellarium Scenery3d Plug-in
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "S3DTileStore.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+Q_LOGGING_CATEGORY(s3dtilestore, "stel.plugin.scenery3d.tilestore")
+
+// Header and version of the tile file, to be incremented when the format changes
+static const quint32 S3DT_MAGIC = 0x54443353;
+static const quint32 S3DT_VERSION = 2;
+// Mean number of triangles per tile
+static const int S3DT_TILE_TRIANGLES = 32768;
+// Maximal number of tiles along each axis
+static const int S3DT_MAX_TILES = 128;
+// Maximal number of levels of each tile, including the original geometry
+static const int S3DT_MAX_LODS = 5;
+
+namespace
+{
+	quint64 align8(quint64 offset)
+	{
+		return (offset+7) & ~static_cast<quint64>(7);
+	}
+
+	//! The geometry of a level during conversion
+	struct LodData
+	{
+		StelOBJ::VertexList vertices;
+		StelOBJ::IndexList indices;
+		//! The material of each triangle, the triangles are ordered by material
+		QVector<qint32> triMaterials;
+		//! The vertices shared with other tiles, which are never moved nor merged
+		QVector<bool> pinned;
+		float geometricError;
+	};
+
+	//! Simplifies the level by clustering its vertices in a grid of the given cell size, anchored at the given origin.
+	//! Vertices of different materials are never merged, so that texture coordinates stay valid.
+	//! The pinned vertices are kept as they are, so that the borders of neighbouring tiles always match,
+	//! whatever their levels of detail.
+	LodData clusterVertices(const LodData& src, const Vec3f& origin, float cellSize)
+	{
+		LodData dst;
+		//the error of the source level adds up with the size of the clusters
+		dst.geometricError = src.geometricError + cellSize * std::sqrt(3.0f);
+
+		QHash<quint64, unsigned int> clusters;
+		QHash<unsigned int, unsigned int> pinnedVertices;
+		QVector<int> clusterCounts;
+		unsigned int tri[3];
+		for(int t = 0; t<src.triMaterials.size(); ++t)
+		{
+			const qint32 mat = src.triMaterials.at(t);
+			for(int c = 0; c<3; ++c)
+			{
+				const unsigned int srcIdx = src.indices.at(3*t+c);
+				const StelOBJ::Vertex& v = src.vertices.at(static_cast<int>(srcIdx));
+				if(src.pinned.at(static_cast<int>(srcIdx)))
+				{
+					auto it = pinnedVertices.find(srcIdx);
+					if(it == pinnedVertices.end())
+					{
+						it = pinnedVertices.insert(srcIdx, static_cast<unsigned int>(dst.vertices.size()));
+						dst.vertices.append(v);
+						dst.pinned.append(true);
+						clusterCounts.append(1);
+					}
+					tri[c] = it.value();
+					continue;
+				}
+
+				quint64 key = static_cast<quint64>(static_cast<quint16>(mat)) << 48;
+				for(int i = 0; i<3; ++i)
+				{
+					const int cell = qBound(0, static_cast<int>((v.position[i] - origin[i]) / cellSize), 65535);
+					key |= static_cast<quint64>(cell) << (16*(2-i));
+				}
+
+				auto it = clusters.find(key);
+				if(it == clusters.end())
+				{
+					//the first vertex of the cluster gives the attributes
+					it = clusters.insert(key, static_cast<unsigned int>(dst.vertices.size()));
+					dst.vertices.append(v);
+					dst.pinned.append(false);
+					clusterCounts.append(1);
+				}
+				else
+				{
+					//the position is the mean of all vertices of the cluster
+					StelOBJ::Vertex& rep = dst.vertices[static_cast<int>(it.value())];
+					const int n = ++clusterCounts[static_cast<int>(it.value())];
+					for(int i = 0; i<3; ++i)
+						rep.position[i] += (v.position[i] - rep.position[i]) / n;
+				}
+				tri[c] = it.value();
+			}
+
+			//drop the triangles which collapsed
+			if(tri[0]!=tri[1] && tri[1]!=tri[2] && tri[0]!=tri[2])
+			{
+				dst.indices.append(tri[0]);
+				dst.indices.append(tri[1]);
+				dst.indices.append(tri[2]);
+				dst.triMaterials.append(mat);
+			}
+		}
+		return dst;
+	}
+}
+
+S3DTileStore::S3DTileStore()
+	: mapped(Q_NULLPTR), header(Q_NULLPTR)
+{
+}
+
+S3DTileStore::~S3DTileStore()
+{
+	close();
+}
+
+void S3DTileStore::close()
+{
+	if(mapped)
+		file.unmap(mapped);
+	mapped = Q_NULLPTR;
+	header = Q_NULLPTR;
+	if(file.isOpen())
+		file.close();
+}
+
+QByteArray S3DTileStore::computeSignature(const QStringList &files, const QByteArray &parameters)
+{
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	for(const auto& f : files)
+	{
+		QFileInfo info(f);
+		hash.addData(f.toUtf8());
+		hash.addData(QByteArray::number(info.size()));
+		hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+	}
+	hash.addData(parameters);
+	return hash.result();
+}
+
+bool S3DTileStore::open(const QString &storeFile, const QByteArray &signature)
+{
+	close();
+
+	file.setFileName(storeFile);
+	if(!file.open(QIODevice::ReadOnly))
+		return false;
+
+	const qint64 size = file.size();
+	mapped = file.map(0, size);
+	if(!mapped || size < static_cast<qint64>(sizeof(Header)))
+	{
+		close();
+		return false;
+	}
+
+	const Header* h = reinterpret_cast<const Header*>(mapped);
+	if(h->magic != S3DT_MAGIC || h->version != S3DT_VERSION)
+	{
+		qCWarning(s3dtilestore)<<"Invalid or outdated tile file"<<QDir::toNativeSeparators(storeFile);
+		close();
+		return false;
+	}
+	if(!signature.isEmpty() && memcmp(h->signature, signature.constData(), qMin(static_cast<int>(sizeof(h->signature)), signature.size()))!=0)
+	{
+		qCDebug(s3dtilestore)<<"Tile file"<<QDir::toNativeSeparators(storeFile)<<"is out of date";
+		close();
+		return false;
+	}
+
+	const quint64 tileCount = static_cast<quint64>(h->tilesX) * static_cast<quint64>(h->tilesY);
+	if(h->tilesX<=0 || h->tilesY<=0
+	   || h->materialsOffset + h->materialsSize > static_cast<quint64>(size)
+	   || h->tilesOffset + tileCount*sizeof(Tile) > static_cast<quint64>(size)
+	   || h->lodsOffset + h->lodCount*sizeof(Lod) > static_cast<quint64>(size)
+	   || h->groupsOffset + h->groupCount*sizeof(Group) > static_cast<quint64>(size)
+	   || h->groundOffset + tileCount*sizeof(Ground) > static_cast<quint64>(size))
+	{
+		qCWarning(s3dtilestore)<<"Corrupted tile file"<<QDir::toNativeSeparators(storeFile);
+		close();
+		return false;
+	}
+
+	header = h;
+	qCDebug(s3dtilestore)<<"Mapped tile file"<<QDir::toNativeSeparators(storeFile)<<"with"<<h->tilesX<<"x"<<h->tilesY<<"tiles and"<<h->lodCount<<"levels";
+	return true;
+}
+
+AABBox S3DTileStore::getBoundingBox() const
+{
+	return AABBox(Vec3f(header->bboxMin[0], header->bboxMin[1], header->bboxMin[2]),
+		      Vec3f(header->bboxMax[0], header->bboxMax[1], header->bboxMax[2]));
+}
+
+float S3DTileStore::getGroundMinZ() const
+{
+	return header->groundMinZ;
+}
+
+bool S3DTileStore::hasGround() const
+{
+	return header->hasGround;
+}
+
+int S3DTileStore::getTilesX() const
+{
+	return header ? header->tilesX : 0;
+}
+
+int S3DTileStore::getTilesY() const
+{
+	return header ? header->tilesY : 0;
+}
+
+int S3DTileStore::getTileAt(float x, float y) const
+{
+	if(x<header->bboxMin[0] || x>header->bboxMax[0] || y<header->bboxMin[1] || y>header->bboxMax[1])
+		return -1;
+	const float dx = header->bboxMax[0] - header->bboxMin[0];
+	const float dy = header->bboxMax[1] - header->bboxMin[1];
+	//the maximum edge belongs to the last tile
+	const int tx = dx>0.0f ? std::min(static_cast<int>((x - header->bboxMin[0]) / dx * header->tilesX), header->tilesX - 1) : 0;
+	const int ty = dy>0.0f ? std::min(static_cast<int>((y - header->bboxMin[1]) / dy * header->tilesY), header->tilesY - 1) : 0;
+	return ty * header->tilesX + tx;
+}
+
+void S3DTileStore::getTileRect(int tile, Vec2f &min, Vec2f &max) const
+{
+	const float dx = (header->bboxMax[0] - header->bboxMin[0]) / header->tilesX;
+	const float dy = (header->bboxMax[1] - header->bboxMin[1]) / header->tilesY;
+	const int tx = tile % header->tilesX;
+	const int ty = tile / header->tilesX;
+	min = Vec2f(header->bboxMin[0] + tx*dx, header->bboxMin[1] + ty*dy);
+	max = Vec2f(min[0] + dx, min[1] + dy);
+}
+
+StelOBJ::MaterialList S3DTileStore::getMaterials(const QString& basePath) const
+{
+	StelOBJ::MaterialList list;
+	QDataStream in(QByteArray::fromRawData(reinterpret_cast<const char*>(mapped + header->materialsOffset), static_cast<int>(header->materialsSize)));
+	in.setVersion(QDataStream::Qt_5_2);
+
+	const QDir dir(basePath);
+	auto makeAbs = [&dir](QString& path)
+	{
+		if(!path.isEmpty())
+			path = dir.absoluteFilePath(path);
+	};
+
+	qint32 count;
+	in >> count;
+	for(int i = 0; i<count && in.status() == QDataStream::Ok; ++i)
+	{
+		StelOBJ::Material mat;
+		qint32 illum;
+		in >> mat.name >> illum >> mat.Ka >> mat.Kd >> mat.Ks >> mat.Ke >> mat.Ns >> mat.d
+		   >> mat.map_Ka >> mat.map_Kd >> mat.map_Ks >> mat.map_Ke >> mat.map_bump >> mat.map_height
+		   >> mat.additionalParams;
+		mat.illum = static_cast<StelOBJ::Material::Illum>(illum);
+		makeAbs(mat.map_Ka);
+		makeAbs(mat.map_Kd);
+		makeAbs(mat.map_Ks);
+		makeAbs(mat.map_Ke);
+		makeAbs(mat.map_bump);
+		makeAbs(mat.map_height);
+		list.append(mat);
+	}
+	return list;
+}
+
+bool S3DTileStore::convert(const StelOBJ &model, const StelOBJ *ground, float groundMinZ, const QString &basePath,
+			   const QByteArray &signature, const QString &storeFile)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QDir().mkpath(QFileInfo(storeFile).absolutePath());
+	QSaveFile out(storeFile);
+	if(!out.open(QIODevice::WriteOnly))
+	{
+		qCWarning(s3dtilestore)<<"Could not write tile file"<<QDir::toNativeSeparators(storeFile)<<out.errorString();
+		return false;
+	}
+
+	const StelOBJ::VertexList& vertices = model.getVertexList();
+	const StelOBJ::IndexList& indices = model.getIndexList();
+	const AABBox bbox = model.getAABBox();
+	const int triCount = indices.size() / 3;
+
+	Header h;
+	memset(&h, 0, sizeof(h));
+	h.magic = S3DT_MAGIC;
+	h.version = S3DT_VERSION;
+	memcpy(h.signature, signature.constData(), qMin(static_cast<int>(sizeof(h.signature)), signature.size()));
+	for(int i = 0; i<3; ++i)
+	{
+		h.bboxMin[i] = bbox.min[i];
+		h.bboxMax[i] = bbox.max[i];
+	}
+	h.groundMinZ = groundMinZ;
+
+	//choose the tile grid so that the tiles are roughly square and contain the given number of triangles on average
+	const float dx = std::max(bbox.max[0] - bbox.min[0], 0.0f);
+	const float dy = std::max(bbox.max[1] - bbox.min[1], 0.0f);
+	const float tileCountTarget = std::max(1.0f, static_cast<float>(triCount) / S3DT_TILE_TRIANGLES);
+	const float tileSize = std::sqrt(std::max(dx*dy, 1e-6f) / tileCountTarget);
+	h.tilesX = qBound(1, static_cast<int>(std::ceil(dx / tileSize)), S3DT_MAX_TILES);
+	h.tilesY = qBound(1, static_cast<int>(std::ceil(dy / tileSize)), S3DT_MAX_TILES);
+	const int tileCount = h.tilesX * h.tilesY;
+
+	auto tileOf = [&h, dx, dy](float x, float y)
+	{
+		const int tx = dx>0.0f ? qBound(0, static_cast<int>((x - h.bboxMin[0]) / dx * h.tilesX), h.tilesX - 1) : 0;
+		const int ty = dy>0.0f ? qBound(0, static_cast<int>((y - h.bboxMin[1]) / dy * h.tilesY), h.tilesY - 1) : 0;
+		return ty * h.tilesX + tx;
+	};
+
+	//the material of each triangle
+	QVector<qint32> triMaterials(triCount, 0);
+	for(const auto& obj : model.getObjectList())
+	{
+		for(const auto& grp : obj.groups)
+		{
+			for(int i = grp.startIndex / 3; i < (grp.startIndex + grp.indexCount) / 3; ++i)
+				triMaterials[i] = grp.materialIndex;
+		}
+	}
+
+	//assign each triangle to the tile containing its centroid
+	QVector<QVector<int> > tileTriangles(tileCount);
+	for(int t = 0; t<triCount; ++t)
+	{
+		float cx = 0.0f, cy = 0.0f;
+		for(int c = 0; c<3; ++c)
+		{
+			const StelOBJ::Vertex& v = vertices.at(static_cast<int>(indices.at(3*t+c)));
+			cx += v.position[0];
+			cy += v.position[1];
+		}
+		tileTriangles[tileOf(cx/3.0f, cy/3.0f)].append(t);
+	}
+
+	//the vertices used by the triangles of several tiles are on the tile borders
+	QVector<int> vertexTiles(vertices.size(), -1);
+	QVector<bool> borderVertices(vertices.size(), false);
+	for(int tileIdx = 0; tileIdx<tileCount; ++tileIdx)
+	{
+		for(int t : tileTriangles.at(tileIdx))
+		{
+			for(int c = 0; c<3; ++c)
+			{
+				const int idx = static_cast<int>(indices.at(3*t+c));
+				if(vertexTiles.at(idx) < 0)
+					vertexTiles[idx] = tileIdx;
+				else if(vertexTiles.at(idx) != tileIdx)
+					borderVertices[idx] = true;
+			}
+		}
+	}
+	vertexTiles.clear();
+
+	//the clustering grids are the same for all tiles, so that the simplified levels of neighbouring tiles are consistent
+	const float nominalTileSize = std::max(std::max(dx / h.tilesX, dy / h.tilesY), bbox.max[2] - bbox.min[2]);
+
+	qint64 written = 0;
+	bool ok = true;
+	auto write = [&out, &written, &ok](const void* d, qint64 size)
+	{
+		static const char padding[8] = {0};
+		const qint64 pad = static_cast<qint64>(align8(static_cast<quint64>(written))) - written;
+		if(pad>0)
+			written += out.write(padding, pad);
+		if(size>0)
+		{
+			const qint64 w = out.write(static_cast<const char*>(d), size);
+			ok = ok && w == size;
+			written += w;
+		}
+		return static_cast<quint64>(written - size);
+	};
+
+	//placeholder for the header, which is written last
+	write(&h, sizeof(h));
+
+	//materials, with texture paths relative to the scene
+	{
+		QByteArray matData;
+		QDataStream ms(&matData, QIODevice::WriteOnly);
+		ms.setVersion(QDataStream::Qt_5_2);
+		const QDir dir(basePath);
+		auto makeRel = [&dir](const QString& path)
+		{
+			return path.isEmpty() ? path : dir.relativeFilePath(path);
+		};
+		const StelOBJ::MaterialList& materials = model.getMaterialList();
+		ms << static_cast<qint32>(materials.size());
+		for(const auto& mat : materials)
+		{
+			ms << mat.name << static_cast<qint32>(mat.illum) << mat.Ka << mat.Kd << mat.Ks << mat.Ke << mat.Ns << mat.d
+			   << makeRel(mat.map_Ka) << makeRel(mat.map_Kd) << makeRel(mat.map_Ks) << makeRel(mat.map_Ke)
+			   << makeRel(mat.map_bump) << makeRel(mat.map_height) << mat.additionalParams;
+		}
+		h.materialsSize = static_cast<quint64>(matData.size());
+		h.materialsOffset = write(matData.constData(), matData.size());
+	}
+
+	QVector<Tile> tileTable(tileCount);
+	QVector<Lod> lodTable;
+	QVector<Group> groupTable;
+
+	//write the levels of each tile
+	for(int tileIdx = 0; tileIdx<tileCount && ok; ++tileIdx)
+	{
+		Tile& tile = tileTable[tileIdx];
+		memset(&tile, 0, sizeof(tile));
+		tile.firstLod = static_cast<quint32>(lodTable.size());
+
+		QVector<int>& tris = tileTriangles[tileIdx];
+		if(tris.isEmpty())
+			continue;
+		std::stable_sort(tris.begin(), tris.end(), [&triMaterials](int a, int b) { return triMaterials.at(a) < triMaterials.at(b); });
+
+		//the original geometry, with tile-local vertices
+		LodData lod;
+		lod.geometricError = 0.0f;
+		QHash<unsigned int, unsigned int> remap;
+		AABBox tileBox;
+		for(int t : tris)
+		{
+			for(int c = 0; c<3; ++c)
+			{
+				const unsigned int idx = indices.at(3*t+c);
+				auto it = remap.find(idx);
+				if(it == remap.end())
+				{
+					it = remap.insert(idx, static_cast<unsigned int>(lod.vertices.size()));
+					const StelOBJ::Vertex& v = vertices.at(static_cast<int>(idx));
+					lod.vertices.append(v);
+					lod.pinned.append(borderVertices.at(static_cast<int>(idx)));
+					tileBox.expand(Vec3f(v.position[0], v.position[1], v.position[2]));
+				}
+				lod.indices.append(it.value());
+			}
+			lod.triMaterials.append(triMaterials.at(t));
+		}
+		for(int i = 0; i<3; ++i)
+		{
+			tile.bboxMin[i] = tileBox.min[i];
+			tile.bboxMax[i] = tileBox.max[i];
+		}
+
+		int lodNr = 0;
+		int clusterLevel = 0;
+		while(ok)
+		{
+			Lod entry;
+			memset(&entry, 0, sizeof(entry));
+			entry.geometricError = lod.geometricError;
+			entry.vertexCount = static_cast<quint32>(lod.vertices.size());
+			entry.indexCount = static_cast<quint32>(lod.indices.size());
+			entry.vertexOffset = write(lod.vertices.constData(), lod.vertices.size() * static_cast<qint64>(sizeof(StelOBJ::Vertex)));
+			entry.indexOffset = write(lod.indices.constData(), lod.indices.size() * static_cast<qint64>(sizeof(unsigned int)));
+			entry.firstGroup = static_cast<quint32>(groupTable.size());
+
+			//material groups, the triangles are already ordered by material
+			for(int t = 0; t<lod.triMaterials.size();)
+			{
+				Group grp;
+				grp.materialIndex = lod.triMaterials.at(t);
+				grp.startIndex = static_cast<quint32>(3*t);
+				AABBox grpBox;
+				Vec3d centroid(0.0);
+				for(; t<lod.triMaterials.size() && lod.triMaterials.at(t) == grp.materialIndex; ++t)
+				{
+					for(int c = 0; c<3; ++c)
+					{
+						const float* pos = lod.vertices.at(static_cast<int>(lod.indices.at(3*t+c))).position;
+						grpBox.expand(Vec3f(pos[0], pos[1], pos[2]));
+						centroid += Vec3d(static_cast<double>(pos[0]), static_cast<double>(pos[1]), static_cast<double>(pos[2]));
+					}
+				}
+				grp.indexCount = static_cast<quint32>(3*t) - grp.startIndex;
+				centroid /= static_cast<double>(grp.indexCount);
+				for(int i = 0; i<3; ++i)
+				{
+					grp.centroid[i] = static_cast<float>(centroid[i]);
+					grp.bboxMin[i] = grpBox.min[i];
+					grp.bboxMax[i] = grpBox.max[i];
+				}
+				groupTable.append(grp);
+			}
+			entry.groupCount = static_cast<quint32>(groupTable.size()) - entry.firstGroup;
+			lodTable.append(entry);
+			++lodNr;
+
+			//find the next coarser level which removes a significant amount of triangles
+			LodData coarser;
+			bool found = false;
+			//the cells go from 1/128 of the tile size up to the whole tile
+			while(!found && clusterLevel<8)
+			{
+				++clusterLevel;
+				const float cellSize = nominalTileSize / static_cast<float>(256 >> clusterLevel);
+				if(cellSize<=0.0f)
+					break;
+				coarser = clusterVertices(lod, bbox.min, cellSize);
+				found = coarser.triMaterials.size() < lod.triMaterials.size() * 4 / 5;
+			}
+			if(!found || lodNr>=S3DT_MAX_LODS || coarser.triMaterials.isEmpty())
+				break;
+			lod = coarser;
+		}
+		tile.lodCount = static_cast<quint32>(lodTable.size()) - tile.firstLod;
+	}
+
+	//the ground triangles overlapping each tile
+	QVector<Ground> groundTable(tileCount);
+	memset(groundTable.data(), 0, static_cast<size_t>(tileCount) * sizeof(Ground));
+	if(ground)
+	{
+		h.hasGround = 1;
+		StelOBJ::V3Vec groundPositions;
+		ground->splitVertexData(&groundPositions);
+		const StelOBJ::IndexList& groundIndices = ground->getIndexList();
+
+		QVector<QVector<int> > groundTriangles(tileCount);
+		for(int t = 0; t<groundIndices.size()/3; ++t)
+		{
+			AABBox triBox;
+			for(int c = 0; c<3; ++c)
+				triBox.expand(groundPositions.at(static_cast<int>(groundIndices.at(3*t+c))));
+			const int minTile = tileOf(triBox.min[0], triBox.min[1]);
+			const int maxTile = tileOf(triBox.max[0], triBox.max[1]);
+			for(int ty = minTile / h.tilesX; ty <= maxTile / h.tilesX; ++ty)
+				for(int tx = minTile % h.tilesX; tx <= maxTile % h.tilesX; ++tx)
+					groundTriangles[ty * h.tilesX + tx].append(t);
+		}
+
+		for(int tileIdx = 0; tileIdx<tileCount && ok; ++tileIdx)
+		{
+			const QVector<int>& tris = groundTriangles.at(tileIdx);
+			if(tris.isEmpty())
+				continue;
+			StelOBJ::V3Vec positions;
+			StelOBJ::IndexList tileIndices;
+			QHash<unsigned int, unsigned int> remap;
+			for(int t : tris)
+			{
+				for(int c = 0; c<3; ++c)
+				{
+					const unsigned int idx = groundIndices.at(3*t+c);
+					auto it = remap.find(idx);
+					if(it == remap.end())
+					{
+						it = remap.insert(idx, static_cast<unsigned int>(positions.size()));
+						positions.append(groundPositions.at(static_cast<int>(idx)));
+					}
+					tileIndices.append(it.value());
+				}
+			}
+			Ground& g = groundTable[tileIdx];
+			g.vertexCount = static_cast<quint32>(positions.size());
+			g.indexCount = static_cast<quint32>(tileIndices.size());
+			g.vertexOffset = write(positions.constData(), positions.size() * static_cast<qint64>(sizeof(Vec3f)));
+			g.indexOffset = write(tileIndices.constData(), tileIndices.size() * static_cast<qint64>(sizeof(unsigned int)));
+		}
+	}
+
+	h.lodCount = static_cast<quint32>(lodTable.size());
+	h.groupCount = static_cast<quint32>(groupTable.size());
+	h.tilesOffset = write(tileTable.constData(), tileTable.size() * static_cast<qint64>(sizeof(Tile)));
+	h.lodsOffset = write(lodTable.constData(), lodTable.size() * static_cast<qint64>(sizeof(Lod)));
+	h.groupsOffset = write(groupTable.constData(), groupTable.size() * static_cast<qint64>(sizeof(Group)));
+	h.groundOffset = write(groundTable.constData(), groundTable.size() * static_cast<qint64>(sizeof(Ground)));
+
+	//now the header is complete
+	ok = ok && out.seek(0) && out.write(reinterpret_cast<const char*>(&h), sizeof(h)) == sizeof(h);
+	if(!ok || !out.commit())
+	{
+		qCWarning(s3dtilestore)<<"Could not write tile file"<<QDir::toNativeSeparators(storeFile)<<out.errorString();
+		return false;
+	}
+
+	qCDebug(s3dtilestore)<<"Converted"<<triCount<<"triangles into"<<h.tilesX<<"x"<<h.tilesY<<"tiles with"<<lodTable.size()
+			     <<"levels in"<<timer.elapsed()<<"ms, file size"<<written / (1024*1024)<<"MB";
+	return true;
+}
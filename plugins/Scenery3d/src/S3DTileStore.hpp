@@ -0,0 +1,169 @@
+/*
+ * Stellarium Scenery3d Plug-in
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef S3DTILESTORE_HPP
+#define S3DTILESTORE_HPP
+
+#include "StelOBJ.hpp"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+Q_DECLARE_LOGGING_CATEGORY(s3dtilestore)
+
+//! A tiled, multi-LOD scene file for large Scenery3d models.
+//! The model is split into a regular grid of tiles in the XY plane (in grid coordinates, after the
+//! scene transformation is applied). Each tile contains a number of levels of detail, with LOD 0 being
+//! the original geometry and the coarser levels being simplified by vertex clustering. The vertices shared with
+//! neighbouring tiles are never simplified, so tiles at different levels still fit together without cracks.
+//! Each level stores its geometric error, which allows selecting it according to the screen-space error.
+//! The triangles of the ground model overlapping each tile are stored separately, so that the heightmap can be
+//! created per tile.
+//!
+//! The file is created once from the OBJ data with convert(), and memory-mapped by open().
+//! The vertex and index data of the tiles is used directly from the mapped memory, so only the tiles that
+//! are actually displayed are loaded into RAM and GL memory.
+class S3DTileStore
+{
+public:
+	//! A tile of the scene
+	struct Tile
+	{
+		float bboxMin[3];
+		float bboxMax[3];
+		//! Index of the first level of the tile in the LOD table
+		quint32 firstLod;
+		//! The number of levels of the tile, zero for empty tiles
+		quint32 lodCount;
+	};
+
+	//! A level of detail of a tile
+	struct Lod
+	{
+		quint64 vertexOffset;
+		quint64 indexOffset;
+		quint32 vertexCount;
+		quint32 indexCount;
+		//! Index of the first material group of this level in the group table
+		quint32 firstGroup;
+		quint32 groupCount;
+		//! The maximal distance of the simplified vertices to the original ones, in model units
+		float geometricError;
+		quint32 reserved;
+	};
+
+	//! A material group of a level, the indices are relative to the level
+	struct Group
+	{
+		qint32 materialIndex;
+		quint32 startIndex;
+		quint32 indexCount;
+		float centroid[3];
+		float bboxMin[3];
+		float bboxMax[3];
+	};
+
+	//! The ground triangles of a tile
+	struct Ground
+	{
+		quint64 vertexOffset;
+		quint64 indexOffset;
+		quint32 vertexCount;
+		quint32 indexCount;
+	};
+
+	S3DTileStore();
+	~S3DTileStore();
+
+	//! Creates a tile file from the given (already transformed) model.
+	//! @param ground The ground model (also transformed), or Q_NULLPTR if there is no ground model
+	//! @param groundMinZ The minimal height of the untransformed ground model
+	//! @param basePath The scene folder, the texture paths of the materials are stored relative to it
+	//! @param signature The signature identifying the source data, see computeSignature()
+	static bool convert(const StelOBJ& model, const StelOBJ* ground, float groundMinZ, const QString& basePath,
+			    const QByteArray& signature, const QString& storeFile);
+	//! Computes a signature from the names, sizes and modification dates of the files and the given parameters
+	static QByteArray computeSignature(const QStringList& files, const QByteArray& parameters);
+
+	//! Maps the given tile file. If the signature is not empty, it must match the signature given to convert().
+	bool open(const QString& storeFile, const QByteArray& signature = QByteArray());
+	void close();
+	bool isOpen() const { return header != Q_NULLPTR; }
+
+	//! Returns the bounding box of the whole scene
+	AABBox getBoundingBox() const;
+	//! Returns the minimal height of the untransformed ground model
+	float getGroundMinZ() const;
+	//! Returns true if ground triangles are available
+	bool hasGround() const;
+	//! Returns the materials of the scene, the texture paths are resolved relative to the basePath
+	StelOBJ::MaterialList getMaterials(const QString& basePath) const;
+
+	int getTilesX() const;
+	int getTilesY() const;
+	int getTileCount() const { return getTilesX() * getTilesY(); }
+	//! Returns the index of the tile containing the XY position, or -1
+	int getTileAt(float x, float y) const;
+	//! Returns the XY rectangle of the given tile
+	void getTileRect(int tile, Vec2f& min, Vec2f& max) const;
+
+	const Tile& getTile(int tile) const { return tiles()[tile]; }
+	const Lod& getLod(const Tile& tile, int lod) const { return lods()[tile.firstLod + static_cast<quint32>(lod)]; }
+	const Group* getGroups(const Lod& lod) const { return groups() + lod.firstGroup; }
+	const StelOBJ::Vertex* getVertices(const Lod& lod) const { return reinterpret_cast<const StelOBJ::Vertex*>(mapped + lod.vertexOffset); }
+	const unsigned int* getIndices(const Lod& lod) const { return reinterpret_cast<const unsigned int*>(mapped + lod.indexOffset); }
+
+	const Ground& getGround(int tile) const { return grounds()[tile]; }
+	const Vec3f* getGroundPositions(const Ground& ground) const { return reinterpret_cast<const Vec3f*>(mapped + ground.vertexOffset); }
+	const unsigned int* getGroundIndices(const Ground& ground) const { return reinterpret_cast<const unsigned int*>(mapped + ground.indexOffset); }
+
+private:
+	struct Header
+	{
+		quint32 magic;
+		quint32 version;
+		//! See computeSignature()
+		char signature[16];
+		float bboxMin[3];
+		float bboxMax[3];
+		qint32 tilesX;
+		qint32 tilesY;
+		quint32 lodCount;
+		quint32 groupCount;
+		float groundMinZ;
+		qint32 hasGround;
+		quint64 materialsOffset;
+		quint64 materialsSize;
+		quint64 tilesOffset;
+		quint64 lodsOffset;
+		quint64 groupsOffset;
+		quint64 groundOffset;
+	};
+
+	const Tile* tiles() const { return reinterpret_cast<const Tile*>(mapped + header->tilesOffset); }
+	const Lod* lods() const { return reinterpret_cast<const Lod*>(mapped + header->lodsOffset); }
+	const Group* groups() const { return reinterpret_cast<const Group*>(mapped + header->groupsOffset); }
+	const Ground* grounds() const { return reinterpret_cast<const Ground*>(mapped + header->groundOffset); }
+
+	QFile file;
+	uchar* mapped;
+	const Header* header;
+};
+
+#endif // S3DTILESTORE_HPP
@@ -85,6 +85,11 @@ bool SceneInfo::loadByID(const QString &id,SceneInfo& info)
 	else if (!info.vertexOrder.compare("ZYX", Qt::CaseInsensitive)) info.vertexOrderEnum=StelOBJ::ZYX;
 	else qCWarning(sceneInfo)<<"Invalid vertex order statement:"<<info.vertexOrder;
 
+	//a .s3dt scenery file is an already converted tiled model
+	info.tiledModel = ini.value("tiled",false).toBool() || info.modelScenery.endsWith(".s3dt",Qt::CaseInsensitive);
+	info.lodMaxError = ini.value("lod_max_error",2.0f).toFloat();
+	info.tileMemoryBudget = ini.value("tile_memory_budget",512).toInt();
+
 	info.camNearZ = ini.value("camNearZ",0.3f).toFloat();
 	info.camFarZ = ini.value("camFarZ",10000.0f).toFloat();
 	info.shadowFarZ = ini.value("shadowDistance",info.camFarZ).toFloat();
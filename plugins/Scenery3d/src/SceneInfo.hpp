@@ -39,7 +39,8 @@ struct SceneInfo
 	SceneInfo() : isValid(false),id(),fullPath(),name(),author(),description(),copyright(),landscapeName(),modelScenery(),modelGround(),vertexOrder(),vertexOrderEnum(StelOBJ::XYZ),
 		camNearZ(0.1f),camFarZ(1000.0f),shadowFarZ(1000.0f),shadowSplitWeight(0.5f),location(),lookAt_fov(0.0f,0.0f,25.0f),eyeLevel(0.0),
 		altitudeFromModel(false),startPositionFromModel(false),groundNullHeightFromModel(false),groundNullHeight(0.0),
-		transparencyThreshold(0.0f),sceneryGenerateNormals(false),groundGenerateNormals(false)
+		transparencyThreshold(0.0f),sceneryGenerateNormals(false),groundGenerateNormals(false),
+		tiledModel(false),lodMaxError(2.0f),tileMemoryBudget(512)
 	{}
 	//! If this is a valid sceneInfo object loaded from file
 	bool isValid;
@@ -119,6 +120,14 @@ struct SceneInfo
 	//! Recalculate normals of the ground from face normals? Default false.
 	bool groundGenerateNormals;
 
+	//! If true, the model is converted to a tiled multi-LOD file (or already is one, if the scenery file has the .s3dt extension),
+	//! which is streamed in depending on the viewer position. Default false.
+	bool tiledModel;
+	//! The maximal screen-space error in pixels allowed when selecting the level of detail of tiles. Default 2.0
+	float lodMaxError;
+	//! The maximal GL memory used for the tiles, in MB. Default 512.
+	int tileMemoryBudget;
+
 	//! Returns true if the location object is valid
 	bool hasLocation() const { return !location.isNull(); }
 	//! Returns true if the lookat_fov is valid
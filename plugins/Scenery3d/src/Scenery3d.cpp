@@ -25,6 +25,7 @@
 #include <QFile>
 #include <QKeyEvent>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QOpenGLShaderProgram>
 #include <QtConcurrent>
 
@@ -63,7 +64,9 @@ Scenery3d::Scenery3d() :
 	progressBar(Q_NULLPTR),
 	currentLoadScene(),
 	currentScene(Q_NULLPTR),
-	currentLoadFuture(this)
+	currentLoadFuture(this),
+	horizonFuture(this),
+	horizonOutdated(true)
 {
 	setObjectName("Scenery3d");
 	scenery3dDialog = new Scenery3dDialog();
@@ -76,6 +79,7 @@ Scenery3d::Scenery3d() :
 	messageTimer->setSingleShot(true);
 	connect(messageTimer, &QTimer::timeout, this, &Scenery3d::clearMessage);
 	connect(&currentLoadFuture,&QFutureWatcherBase::finished, this, &Scenery3d::loadSceneCompleted);
+	connect(&horizonFuture,&QFutureWatcherBase::finished, this, &Scenery3d::horizonComputed);
 
 	connect(this, &Scenery3d::progressReport, this, &Scenery3d::progressReceive, Qt::QueuedConnection);
 
@@ -212,6 +216,8 @@ void Scenery3d::update(double deltaTime)
 			if(mat.traits.hasTimeFade)
 				mat.updateFadeInfo(curTime);
 		}
+
+		updateHorizon();
 	}
 
 	messageFader.update(static_cast<int>(deltaTime*1000));
@@ -278,6 +284,11 @@ void Scenery3d::deinit()
 		loadCancel = true;
 		currentLoadFuture.waitForFinished();
 	}
+	//the horizon computation uses the scene data
+	horizonFuture.waitForFinished();
+	LandscapeMgr* lmgr = GETSTELMODULE(LandscapeMgr);
+	if(lmgr)
+		lmgr->clearOcclusionHorizon();
 	//this is correct the place to delete all OpenGL related stuff, not the destructor
 	delete renderer;
 	renderer = Q_NULLPTR;
@@ -451,6 +462,9 @@ S3DScene* Scenery3d::loadSceneBackground(const SceneInfo& scene) const
 	if(loadCancel)
 		return Q_NULLPTR;
 
+	if(scene.tiledModel)
+		return loadTiledScene(*newScene) ? newScene.take() : Q_NULLPTR;
+
 	updateProgress(q_("Loading model..."),1,0,6);
 
 	//load model
@@ -506,6 +520,84 @@ S3DScene* Scenery3d::loadSceneBackground(const SceneInfo& scene) const
 	return newScene.take();
 }
 
+bool Scenery3d::loadTiledScene(S3DScene &newScene) const
+{
+	const SceneInfo& scene = newScene.getSceneInfo();
+	QElapsedTimer timer;
+	timer.start();
+	updateProgress(q_("Loading tiles..."),1,0,6);
+
+	QString storeFile;
+	QByteArray signature;
+	if(scene.modelScenery.endsWith(".s3dt", Qt::CaseInsensitive))
+	{
+		//an already converted scene, used as it is
+		storeFile = StelFileMgr::findFile(scene.fullPath + "/" + scene.modelScenery);
+	}
+	else
+	{
+		//the OBJ files are converted once, and the tiles kept in the cache
+		storeFile = StelFileMgr::getCacheDir() + "/scenery3d/" + scene.id + "/scenery.s3dt";
+		signature = newScene.getTileSignature();
+	}
+
+	if(!newScene.setTiledModel(storeFile, signature))
+	{
+		if(signature.isEmpty())
+		{
+			qCCritical(scenery3d)<<"Failed to load tile file"<<storeFile;
+			return false;
+		}
+
+		//convert the OBJ files, which requires loading them completely one last time
+		StelOBJ modelOBJ;
+		QString modelFile = StelFileMgr::findFile(scene.fullPath + "/" + scene.modelScenery);
+		qCDebug(scenery3d)<<"Converting scene"<<modelFile<<"to tiles";
+		if(!modelOBJ.load(modelFile, scene.vertexOrderEnum))
+		{
+			qCCritical(scenery3d)<<"Failed to load OBJ file"<<modelFile;
+			return false;
+		}
+
+		if(loadCancel)
+			return false;
+
+		StelOBJ groundOBJ;
+		StelOBJ* ground = Q_NULLPTR;
+		if(scene.modelGround.isEmpty())
+			ground = &modelOBJ;
+		else if (scene.modelGround != "NULL")
+		{
+			updateProgress(q_("Loading ground..."),2,0,6);
+			modelFile = StelFileMgr::findFile(scene.fullPath + "/" + scene.modelGround);
+			if(!groundOBJ.load(modelFile, scene.vertexOrderEnum))
+			{
+				qCCritical(scenery3d)<<"Failed to load ground model"<<modelFile;
+				return false;
+			}
+			ground = &groundOBJ;
+		}
+
+		if(loadCancel)
+			return false;
+
+		updateProgress(q_("Converting model to tiles..."),3,0,6);
+		if(!newScene.convertToTiles(modelOBJ, ground, storeFile, signature) || !newScene.setTiledModel(storeFile, signature))
+		{
+			qCCritical(scenery3d)<<"Failed to convert the scene to tiles";
+			return false;
+		}
+	}
+
+	if(loadCancel)
+		return false;
+
+	updateProgress(q_("Finalizing load..."),6,0,6);
+	qCDebug(scenery3d)<<"Tiled scene loaded in"<<timer.elapsed()<<"ms";
+
+	return true;
+}
+
 void Scenery3d::loadSceneCompleted()
 {
 	S3DScene* result = currentLoadFuture.result();
@@ -559,9 +651,12 @@ void Scenery3d::loadSceneCompleted()
 	currentLoadScene = SceneInfo();
 	emit loadingSceneIDChanged(QString());
 
-	//switch scenes
+	//switch scenes, the horizon of the previous scene must not be used until the new one is computed
+	horizonFuture.waitForFinished();
+	GETSTELMODULE(LandscapeMgr)->clearOcclusionHorizon();
 	delete currentScene;
 	currentScene = result;
+	horizonOutdated = true;
 
 	//show the scene
 	setEnableScene(true);
@@ -570,6 +665,33 @@ void Scenery3d::loadSceneCompleted()
 	emit currentSceneIDChanged(info.id);
 }
 
+void Scenery3d::updateHorizon()
+{
+	// Distance the eye has to move before the horizon profile is computed again
+	static const double HORIZON_UPDATE_DISTANCE = 0.05;
+
+	if(horizonFuture.isRunning())
+		return;
+	const Vec3d& eye = currentScene->getEyePosition();
+	if(!horizonOutdated && (eye - horizonEyePosition).length() < HORIZON_UPDATE_DISTANCE)
+		return;
+
+	//the whole profile is computed again from the meshes, there is no incremental update,
+	//so it is only done in the background and after moving a few cm
+	horizonOutdated = false;
+	horizonEyePosition = eye;
+	const Vec3f eyef = eye.toVec3f();
+	horizonFuture.setFuture(QtConcurrent::run(&S3DHorizon::compute, currentScene->getHorizonMeshes(eyef), eyef));
+}
+
+void Scenery3d::horizonComputed()
+{
+	//the scene may have been hidden or switched in the meantime
+	if(!flagEnabled || !currentScene || horizonOutdated)
+		return;
+	GETSTELMODULE(LandscapeMgr)->setOcclusionHorizon(horizonFuture.result());
+}
+
 SceneInfo Scenery3d::loadScenery3dByID(const QString& id)
 {
 	if (id.isEmpty())
@@ -656,6 +778,11 @@ void Scenery3d::setEnableScene(const bool enable)
 	if(enable!=flagEnabled)
 	{
 		flagEnabled=enable;
+		//the horizon of the landscape is used again while the scene is hidden
+		if(flagEnabled)
+			horizonOutdated = true;
+		else
+			GETSTELMODULE(LandscapeMgr)->clearOcclusionHorizon();
 		if (renderer->getCubemapSize()==0)
 		{
 			//TODO FS: remove this?
@@ -301,6 +301,8 @@ private slots:
     void loadSceneCompleted();
     void progressReceive(const QString& str, int val, int min, int max);
     void loadScene(const SceneInfo& scene);
+    //! Makes the computed horizon profile the occlusion horizon of the LandscapeMgr
+    void horizonComputed();
 
 private:
     //! Loads config values from app settings
@@ -312,6 +314,10 @@ private:
 
     //! This is run asynchronously in a background thread, performing the actual scene loading
     S3DScene *loadSceneBackground(const SceneInfo &scene) const;
+    //! Sets up a tiled scene, converting the OBJ files first if necessary. Runs in the loading thread.
+    bool loadTiledScene(S3DScene &newScene) const;
+    //! Starts computing the horizon profile in the background if the viewer moved
+    void updateHorizon();
 
     // the other "main" objects
     S3DRenderer* renderer;
@@ -341,6 +347,11 @@ private:
     SceneInfo currentLoadScene;
     S3DScene* currentScene;
     QFutureWatcher<S3DScene*> currentLoadFuture;
+
+    //horizon profile of the current scene
+    QFutureWatcher<QVector<float> > horizonFuture;
+    Vec3d horizonEyePosition;
+    bool horizonOutdated;
 };
 
 
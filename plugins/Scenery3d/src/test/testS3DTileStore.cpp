@@ -0,0 +1,210 @@
+/*
+ * Stellarium Scenery3d Plug-in
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "testS3DTileStore.hpp"
+#include "S3DTileStore.hpp"
+
+#include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestS3DTileStore)
+
+// Number of vertices along each side of the synthetic terrain
+#define GRID_SIZE 256
+
+namespace
+{
+	//! A key identifying an edge by the positions of its vertices, in any order
+	QByteArray edgeKey(const float* a, const float* b)
+	{
+		if(std::lexicographical_compare(b, b+3, a, a+3))
+			std::swap(a, b);
+		QByteArray key(reinterpret_cast<const char*>(a), 3*sizeof(float));
+		key.append(reinterpret_cast<const char*>(b), 3*sizeof(float));
+		return key;
+	}
+
+	QSet<QByteArray> lodEdges(const S3DTileStore& store, const S3DTileStore::Lod& lod)
+	{
+		QSet<QByteArray> edges;
+		const StelOBJ::Vertex* vertices = store.getVertices(lod);
+		const unsigned int* indices = store.getIndices(lod);
+		for(quint32 i = 0; i<lod.indexCount; i+=3)
+		{
+			for(int c = 0; c<3; ++c)
+				edges.insert(edgeKey(vertices[indices[i+c]].position, vertices[indices[i+(c+1)%3]].position));
+		}
+		return edges;
+	}
+}
+
+void TestS3DTileStore::initTestCase()
+{
+	QVERIFY(tempDir.isValid());
+
+	//a wavy terrain of 1 km, which needs a few tiles
+	QByteArray obj;
+	QTextStream out(&obj);
+	for(int y = 0; y<GRID_SIZE; ++y)
+		for(int x = 0; x<GRID_SIZE; ++x)
+			out<<"v "<<x*4.0<<" "<<y*4.0<<" "<<10.0*std::sin(x*0.05)*std::cos(y*0.07)<<"\n";
+	for(int y = 0; y<GRID_SIZE-1; ++y)
+	{
+		for(int x = 0; x<GRID_SIZE-1; ++x)
+		{
+			const int i = y*GRID_SIZE + x + 1;
+			out<<"f "<<i<<" "<<i+1<<" "<<i+GRID_SIZE+1<<"\n";
+			out<<"f "<<i<<" "<<i+GRID_SIZE+1<<" "<<i+GRID_SIZE<<"\n";
+		}
+	}
+	out.flush();
+
+	QBuffer buf(&obj);
+	QVERIFY(buf.open(QIODevice::ReadOnly));
+	QVERIFY(model.load(buf, tempDir.path()));
+	QCOMPARE(static_cast<int>(model.getFaceCount()), 2*(GRID_SIZE-1)*(GRID_SIZE-1));
+
+	storeFile = QDir(tempDir.path()).absoluteFilePath("cache/scene.s3dt");
+	signature = S3DTileStore::computeSignature(QStringList(), "test");
+	QElapsedTimer timer;
+	timer.start();
+	QVERIFY(S3DTileStore::convert(model, &model, -10.0f, tempDir.path(), signature, storeFile));
+	qDebug()<<"Converted"<<model.getFaceCount()<<"triangles in"<<timer.elapsed()<<"ms, file size"<<QFileInfo(storeFile).size()/1024<<"kB";
+}
+
+void TestS3DTileStore::testRoundTrip()
+{
+	S3DTileStore store;
+	QVERIFY(store.open(storeFile, signature));
+	QVERIFY(store.isOpen());
+	QVERIFY(store.getTileCount()>1);
+
+	const AABBox box = store.getBoundingBox();
+	for(int i = 0; i<3; ++i)
+	{
+		QCOMPARE(box.min[i], model.getAABBox().min[i]);
+		QCOMPARE(box.max[i], model.getAABBox().max[i]);
+	}
+	QCOMPARE(store.getGroundMinZ(), -10.0f);
+	QVERIFY(store.hasGround());
+	QCOMPARE(store.getMaterials(tempDir.path()).size(), model.getMaterialList().size());
+
+	//the full levels contain each triangle of the model exactly once, with the original vertices
+	QSet<QByteArray> modelEdges;
+	const StelOBJ::VertexList& vertices = model.getVertexList();
+	const StelOBJ::IndexList& indices = model.getIndexList();
+	for(int i = 0; i<indices.size(); i+=3)
+		for(int c = 0; c<3; ++c)
+			modelEdges.insert(edgeKey(vertices.at(static_cast<int>(indices.at(i+c))).position, vertices.at(static_cast<int>(indices.at(i+(c+1)%3))).position));
+	quint32 triangles = 0;
+	quint32 groundTriangles = 0;
+	for(int t = 0; t<store.getTileCount(); ++t)
+	{
+		const S3DTileStore::Tile& tile = store.getTile(t);
+		QVERIFY(tile.lodCount>0);
+		const S3DTileStore::Lod& lod = store.getLod(tile, 0);
+		QCOMPARE(lod.geometricError, 0.0f);
+		triangles += lod.indexCount / 3;
+		for(const auto& edge : lodEdges(store, lod))
+			QVERIFY(modelEdges.contains(edge));
+
+		//the tile contains its triangles, and each ground triangle overlaps its tile
+		Vec2f min, max;
+		store.getTileRect(t, min, max);
+		const StelOBJ::Vertex* v = store.getVertices(lod);
+		for(quint32 i = 0; i<lod.vertexCount; ++i)
+			for(int k = 0; k<3; ++k)
+				QVERIFY(v[i].position[k]>=tile.bboxMin[k] && v[i].position[k]<=tile.bboxMax[k]);
+		const S3DTileStore::Ground& ground = store.getGround(t);
+		QVERIFY(ground.indexCount>0);
+		groundTriangles += ground.indexCount / 3;
+		QVERIFY(store.getTileAt((min[0]+max[0])/2, (min[1]+max[1])/2) == t);
+	}
+	QCOMPARE(triangles, model.getFaceCount());
+	QVERIFY(groundTriangles>=model.getFaceCount());
+}
+
+void TestS3DTileStore::testLevels()
+{
+	S3DTileStore store;
+	QVERIFY(store.open(storeFile, signature));
+	for(int t = 0; t<store.getTileCount(); ++t)
+	{
+		const S3DTileStore::Tile& tile = store.getTile(t);
+		QVERIFY(tile.lodCount>1);
+		for(int l = 1; l<static_cast<int>(tile.lodCount); ++l)
+		{
+			const S3DTileStore::Lod& finer = store.getLod(tile, l-1);
+			const S3DTileStore::Lod& coarser = store.getLod(tile, l);
+			QVERIFY(coarser.geometricError>finer.geometricError);
+			QVERIFY(coarser.indexCount<finer.indexCount);
+			QVERIFY(coarser.groupCount>0);
+			const S3DTileStore::Group* groups = store.getGroups(coarser);
+			quint32 count = 0;
+			for(quint32 g = 0; g<coarser.groupCount; ++g)
+				count += groups[g].indexCount;
+			QCOMPARE(count, coarser.indexCount);
+		}
+	}
+}
+
+void TestS3DTileStore::testTileBorders()
+{
+	S3DTileStore store;
+	QVERIFY(store.open(storeFile, signature));
+
+	//the edges shared by the full levels of two tiles are on the borders
+	QVector<QSet<QByteArray> > fullEdges;
+	for(int t = 0; t<store.getTileCount(); ++t)
+		fullEdges.append(lodEdges(store, store.getLod(store.getTile(t), 0)));
+	for(int t = 0; t<store.getTileCount(); ++t)
+	{
+		QSet<QByteArray> border;
+		for(int o = 0; o<store.getTileCount(); ++o)
+		{
+			if(o != t)
+				border.unite(QSet<QByteArray>(fullEdges.at(t)).intersect(fullEdges.at(o)));
+		}
+		QVERIFY(!border.isEmpty());
+
+		//the borders are kept at all levels, so that neighbouring tiles always fit together
+		const S3DTileStore::Tile& tile = store.getTile(t);
+		for(int l = 1; l<static_cast<int>(tile.lodCount); ++l)
+		{
+			const QSet<QByteArray> edges = lodEdges(store, store.getLod(tile, l));
+			for(const auto& edge : border)
+				QVERIFY(edges.contains(edge));
+		}
+	}
+}
+
+void TestS3DTileStore::testSignature()
+{
+	S3DTileStore store;
+	QVERIFY(store.open(storeFile));
+	QVERIFY(!store.open(storeFile, S3DTileStore::computeSignature(QStringList(), "other")));
+	QVERIFY(!store.isOpen());
+	QVERIFY(!store.open(QDir(tempDir.path()).absoluteFilePath("missing.s3dt")));
+}
@@ -48,6 +48,7 @@ Supernova::Supernova(const QVariantMap& map)
 	, snde(0.)
 	, note("")
 	, distance(0.)
+	, lightCurveIndex(-1)
 {
 	if (!map.contains("designation") || !map.contains("alpha") || !map.contains("delta"))
 	{
@@ -188,59 +189,10 @@ Vec3f Supernova::getInfoColor(void) const
 
 float Supernova::getVMagnitude(const StelCore* core) const
 {
-	double vmag = 20;
-	const double currentJD = core->getJDE(); // GZ JDfix for 0.14. I hope the JD in the list is JDE? (Usually difference should be negligible)
-	const double deltaJD = qAbs(peakJD-currentJD);
-
 	// Use supernova light curve model from here - http://www.astronet.ru/db/msg/1188703
-
-	if (sntype.contains("II", Qt::CaseSensitive))
-	{
-		// Type II
-		if (peakJD<=currentJD)
-		{
-			vmag = maxMagnitude;
-			if (deltaJD>0 && deltaJD<=30)
-				vmag = maxMagnitude + 0.05 * deltaJD;
-
-			if (deltaJD>30 && deltaJD<=80)
-				vmag = maxMagnitude + 0.013 * (deltaJD - 30) + 1.5;
-
-			if (deltaJD>80 && deltaJD<=100)
-				vmag = maxMagnitude + 0.075 * (deltaJD - 80) + 2.15;
-
-			if (deltaJD>100)
-				vmag = maxMagnitude + 0.025 * (deltaJD - 100) + 3.65;
-		}
-		else
-		{
-			if (deltaJD<=20)
-				vmag = maxMagnitude + 0.75 * deltaJD;
-		}
-	}
-	else
-	{
-		// Type I
-		if (peakJD<=currentJD)
-		{
-			vmag = maxMagnitude;
-			if (deltaJD>0 && deltaJD<=25)
-				vmag = maxMagnitude + 0.1 * deltaJD;
-
-			if (deltaJD>25)
-				vmag = maxMagnitude + 0.016 * (deltaJD - 25) + 2.5;
-		}
-		else
-		{
-			if (deltaJD<=15)
-				vmag = maxMagnitude + 1.13 * deltaJD;
-		}
-	}
-
-	if (vmag<maxMagnitude)
-		vmag = maxMagnitude;
-
-	return static_cast<float>(vmag);
+	if (!photometry || lightCurveIndex<0)
+		return 20.f;
+	return photometry->getMagnitude(lightCurveIndex, core->getJDE());
 }
 
 double Supernova::getAngularSize(const StelCore*) const
@@ -25,10 +25,12 @@
 #include <QFont>
 #include <QList>
 #include <QDateTime>
+#include <QSharedPointer>
 
 #include "StelObject.hpp"
 #include "StelTextureTypes.hpp"
 #include "StelFader.hpp"
+#include "StelPhotometry.hpp"
 
 class StelPainter;
 
@@ -113,6 +115,8 @@ private:
 	double snde;			   //! Dec. for the supernova
 	QString note;			   //! Notes for the supernova
 	double distance;		   //! Distance to supernova (10^3 ly)
+	QSharedPointer<StelPhotometry> photometry; //! The light curves of all the supernovae, evaluated once per frame by the Supernovae module
+	int lightCurveIndex;		   //! Index of the light curve compiled from the type and the maximal magnitude
 
 	LinearFader labelsFader;
 
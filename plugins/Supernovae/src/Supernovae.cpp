@@ -188,6 +188,12 @@ void Supernovae::init()
 	GETSTELMODULE(StelObjectMgr)->registerStelObjectMgr(this);
 }
 
+void Supernovae::update(double)
+{
+	if (photometry)
+		photometry->update(StelApp::getInstance().getCore()->getJDE());
+}
+
 /*
  Draw our module. This should print name of first SNe in the main window
 */
@@ -404,6 +410,7 @@ void Supernovae::setSNeMap(const QVariantMap& map)
 	snstar.clear();
 	snlist.clear();
 	SNCount = 0;
+	photometry = QSharedPointer<StelPhotometry>(new StelPhotometry());
 	QVariantMap sneMap = map.value("supernova").toMap();
 	for (auto sneKey : sneMap.keys())
 	{
@@ -415,7 +422,11 @@ void Supernovae::setSNeMap(const QVariantMap& map)
 
 		SupernovaP sn(new Supernova(sneData));
 		if (sn->initialized)
+		{
+			sn->photometry = photometry;
+			sn->lightCurveIndex = photometry->addSupernovaCurve(sn->sntype, static_cast<float>(sn->maxMagnitude), sn->peakJD);
 			snstar.append(sn);
+		}
 	}
 }
 
@@ -86,7 +86,7 @@ public:
 	// Methods defined in the StelModule class
 	virtual void init();
 	virtual void deinit();
-	virtual void update(double) {;}
+	virtual void update(double deltaTime);
 	virtual void draw(StelCore* core);
 	virtual void drawPointer(StelCore* core, StelPainter& painter);
 	virtual double getCallOrder(StelModuleActionName actionName) const;
@@ -227,6 +227,9 @@ private:
 
 	StelTextureSP texPointer;
 	QList<SupernovaP> snstar;
+	//! The light curves of the supernovae, evaluated once per frame. A new instance is made for each catalog,
+	//! because the supernovae of the previous catalog may still be referenced, e.g. as the selected object.
+	QSharedPointer<StelPhotometry> photometry;
 	QHash<QString, double> snlist;
 
 	// variables and functions for the updater
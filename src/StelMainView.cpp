@@ -33,7 +33,12 @@
 #include "StelOpenGLArray.hpp"
 #include "StelProjector.hpp"
 #include "StelMovementMgr.hpp"
+#include "StelPropertyMgr.hpp"
+#include "StelSkyDrawer.hpp"
+#include "StelToneReproducer.hpp"
+#include "LandscapeMgr.hpp"
 
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #ifdef USE_OLD_QGLWIDGET
@@ -49,6 +54,7 @@
 #include <QGraphicsWidget>
 #include <QGraphicsEffect>
 #include <QFileInfo>
+#include <QFontMetrics>
 #include <QIcon>
 #include <QImageWriter>
 #include <QMoveEvent>
@@ -62,6 +68,7 @@
 #include <QWindow>
 #include <QMessageBox>
 #include <QStandardPaths>
+#include <QtConcurrent>
 #ifdef Q_OS_WIN
 	#include <QPinchGesture>
 #endif
@@ -76,7 +83,10 @@
 
 Q_LOGGING_CATEGORY(mainview, "stel.MainView")
 
+#include <climits>
 #include <clocale>
+#include <cmath>
+#include <cstring>
 
 // Initialize static variables
 StelMainView* StelMainView::singleton = Q_NULLPTR;
@@ -346,6 +356,12 @@ public:
 		rect.setSize(size);
 	}
 
+	//! Make the next paint use a null time step, e.g. to render several tiles of a screenshot at the same instant.
+	void resetPaintTime()
+	{
+		previousPaintTime = StelApp::getTotalRunTime();
+	}
+
 	//! Set the sky background color. Everything else than black creates a work of art!
 	void setSkyBackgroundColor(Vec3f color) { skyBackgroundColor=color; }
 
@@ -710,6 +726,8 @@ void StelMainView::focusSky() {
 
 StelMainView::~StelMainView()
 {
+	// finish writing the last screenshot
+	screenshotWriter.waitForFinished();
 	//delete the night view graphic effect here while GL context is still valid
 	rootItem->setGraphicsEffect(Q_NULLPTR);
 	StelApp::deinitStatic();
@@ -1396,6 +1414,17 @@ void StelMainView::moveEvent(QMoveEvent * event)
 		stelApp->setDevicePixelsPerPixel(win->devicePixelRatio());
 }
 
+void StelMainView::changeEvent(QEvent* event)
+{
+	if (event->type()==QEvent::WindowStateChange)
+	{
+		const bool wasFullScreen = static_cast<QWindowStateChangeEvent*>(event)->oldState() & Qt::WindowFullScreen;
+		if (wasFullScreen!=isFullScreen())
+			emit fullScreenChanged(isFullScreen());
+	}
+	QGraphicsView::changeEvent(event);
+}
+
 void StelMainView::closeEvent(QCloseEvent* event)
 {
 	Q_UNUSED(event);
@@ -1445,9 +1474,69 @@ void StelMainView::saveScreenShot(const QString& filePrefix, const QString& save
 	emit(screenshotRequested());
 }
 
+#ifndef USE_OLD_QGLWIDGET
+// Maximal size of the tiles for large screenshots [pixels], to limit the GPU memory used
+static const int SCREENSHOT_MAX_TILE_SIZE = 4096;
+// Minimal margin rendered around each tile, so that the labels anchored just outside of it are also drawn in it [pixels]
+static const int SCREENSHOT_TILE_MARGIN = 256;
+// Number of characters of the longest sky labels which must fit in the tile margin
+static const int SCREENSHOT_LABEL_LENGTH = 40;
+
+//! Return the margin to render around each screenshot tile [pixels]. The projector culls the labels anchored outside of the
+//! viewport, so the margin must be as wide as the longest labels drawn with the largest sky font.
+static int screenshotTileMargin(int maxTileSize)
+{
+	StelPropertyMgr* propMgr = StelApp::getInstance().getStelPropertyManager();
+	float fontSize = StelApp::getInstance().getScreenFontSize();
+	fontSize = qMax(fontSize, propMgr->getStelPropertyValue("ConstellationMgr.fontSize", true).toFloat());
+	fontSize = qMax(fontSize, propMgr->getStelPropertyValue("AsterismMgr.fontSize", true).toFloat());
+	QFont font(QGuiApplication::font());
+	font.setPixelSize(qMax(1, qRound(fontSize)));
+	const int labelExtent = QFontMetrics(font).averageCharWidth()*SCREENSHOT_LABEL_LENGTH;
+	// A multiple of 4, so that the tiles still join exactly on HiDPI screens
+	return qBound(SCREENSHOT_TILE_MARGIN, labelExtent, maxTileSize/4) & ~3;
+}
+#endif
+
+//! Apply the color changes to the screenshot image and write it. This runs in a worker thread.
+static bool writeScreenshot(QImage im, const QString& filePath, const QString& format, bool nightMode, bool invertColors)
+{
+	if (nightMode)
+	{
+		for (int row=0; row<im.height(); ++row)
+			for (int col=0; col<im.width(); ++col)
+			{
+				QRgb rgb=im.pixel(col, row);
+				int gray=qGray(rgb);
+				im.setPixel(col, row, qRgb(gray, 0, 0));
+			}
+	}
+	if (invertColors)
+		im.invertPixels();
+
+	QImageWriter imageWriter(filePath);
+	if (format=="tif")
+		imageWriter.setCompression(1); // use LZW
+	if (format=="jpg")
+	{
+		imageWriter.setQuality(75); // This is actually default
+	}
+	if (format=="jpeg")
+	{
+		imageWriter.setQuality(100);
+	}
+	if (!imageWriter.write(im))
+	{
+		qWarning() << "WARNING failed to write screenshot to: " << QDir::toNativeSeparators(filePath);
+		return false;
+	}
+	return true;
+}
+
 void StelMainView::doScreenshot(void)
 {
 	QFileInfo shotDir;
+	bool nightModeWasEnabled=nightModeEffect->isEnabled();
 #ifdef USE_OLD_QGLWIDGET
 	QImage im = glWidget->grabFrameBuffer();
 #else
@@ -1460,7 +1549,7 @@ void StelMainView::doScreenshot(void)
 	float pixelRatio = QOpenGLContext::currentContext()->screen()->devicePixelRatio();
 	int imgWidth =stelScene->width();
 	int imgHeight=stelScene->height();
-	bool nightModeWasEnabled=nightModeEffect->isEnabled();
+	int maxTileSize=qMax(imgWidth, imgHeight);
 	nightModeEffect->setEnabled(false);
 	if (flagUseCustomScreenshotSize)
 	{
@@ -1476,12 +1565,12 @@ void StelMainView::doScreenshot(void)
 #ifdef GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX
 			GLint freeGLmemory;
 			context->functions()->glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &freeGLmemory);
-			qCDebug(mainview)<<"Free GPU memory:" << freeGLmemory << "kB -- we ask for " << customScreenshotWidth*customScreenshotHeight*8 / 1024 <<"kB";
+			qCDebug(mainview)<<"Free GPU memory:" << freeGLmemory << "kB -- we ask for " << SCREENSHOT_MAX_TILE_SIZE*SCREENSHOT_MAX_TILE_SIZE*8 / 1024 <<"kB";
 #endif
 #ifdef GL_RENDERBUFFER_FREE_MEMORY_ATI
 			GLint freeGLmemoryAMD[4];
 			context->functions()->glGetIntegerv(GL_RENDERBUFFER_FREE_MEMORY_ATI, freeGLmemoryAMD);
-			qCDebug(mainview)<<"Free GPU memory (AMD version):" << (uint)freeGLmemoryAMD[1]/1024 << "+" << (uint)freeGLmemoryAMD[3]/1024 << " of " << (uint)freeGLmemoryAMD[0]/1024 << "+" << (uint)freeGLmemoryAMD[2]/1024 << "kB -- we ask for " << customScreenshotWidth*customScreenshotHeight*8 / 1024 <<"kB";
+			qCDebug(mainview)<<"Free GPU memory (AMD version):" << (uint)freeGLmemoryAMD[1]/1024 << "+" << (uint)freeGLmemoryAMD[3]/1024 << " of " << (uint)freeGLmemoryAMD[0]/1024 << "+" << (uint)freeGLmemoryAMD[2]/1024 << "kB -- we ask for " << SCREENSHOT_MAX_TILE_SIZE*SCREENSHOT_MAX_TILE_SIZE*8 / 1024 <<"kB";
 #endif
 #endif
 			GLint texSize,viewportSize[2],rbSize;
@@ -1494,12 +1583,26 @@ void StelMainView::doScreenshot(void)
 			int maximumFramebufferSize = qMin(texSize,qMin(rbSize,qMin(viewportSize[0],viewportSize[1])));
 			qCDebug(mainview)<<"Maximum framebuffer size:"<<maximumFramebufferSize;
 
-			imgWidth =qMin(maximumFramebufferSize, customScreenshotWidth);
-			imgHeight=qMin(maximumFramebufferSize, customScreenshotHeight);
+			// Larger images are rendered in tiles. Their size is a multiple of 4, so that the tiles join exactly on HiDPI screens.
+			maxTileSize = qMin(SCREENSHOT_MAX_TILE_SIZE, static_cast<int>(maximumFramebufferSize/pixelRatio)) & ~3;
+			imgWidth =customScreenshotWidth;
+			imgHeight=customScreenshotHeight;
+			// A QImage holds at most INT_MAX bytes: reduce larger sizes, keeping the aspect ratio
+			const double imageBytes = 4.0*imgWidth*imgHeight*pixelRatio*pixelRatio;
+			if (imageBytes > INT_MAX)
+			{
+				const double scale = std::sqrt(INT_MAX/imageBytes);
+				const int width = static_cast<int>(imgWidth*scale) & ~3;
+				const int height = static_cast<int>(imgHeight*scale) & ~3;
+				qCWarning(mainview) << "Screenshot size" << imgWidth << "x" << imgHeight << "exceeds the maximum image size, reduced to" << width << "x" << height;
+				imgWidth = width;
+				imgHeight = height;
+			}
 		}
 		else
 		{
 			qCWarning(mainview) << "No GL context for screenshot! Aborting.";
+			nightModeEffect->setEnabled(nightModeWasEnabled);
 			return;
 		}
 	}
@@ -1509,77 +1612,152 @@ void StelMainView::doScreenshot(void)
 	QOpenGLFramebufferObjectFormat fbFormat;
 	fbFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
 	fbFormat.setInternalTextureFormat(isGLES ? GL_RGBA : GL_RGB); // try to avoid transparent background!
-	QOpenGLFramebufferObject * fbObj = new QOpenGLFramebufferObject(imgWidth * pixelRatio, imgHeight * pixelRatio, fbFormat);
-	fbObj->bind();
-	// Now the painter has to be convinced to paint to the potentially larger image frame.
-	QOpenGLPaintDevice fbObjPaintDev(imgWidth, imgHeight);
-	fbObjPaintDev.setDevicePixelRatio(pixelRatio);
+
+	// An image larger than the maximum framebuffer size is rendered in tiles. Each tile is rendered with the full image
+	// projection, only shifting the projection center relative to the tile viewport (off-axis rendering), so that
+	// the tiles join exactly. Each tile is rendered with a margin, because the projector culls the labels anchored
+	// outside of the viewport, even when they would overlap it.
+	const bool tiled = imgWidth>maxTileSize || imgHeight>maxTileSize;
+	const int tileMargin = tiled ? screenshotTileMargin(maxTileSize) : 0;
+	const int tileSize = tiled ? qMax(4, maxTileSize-2*tileMargin) : maxTileSize;
+	if (tiled)
+		qCDebug(mainview) << "Rendering screenshot of" << imgWidth << "x" << imgHeight << "in tiles of" << tileSize;
 
 	// It seems the projector has its own knowledge about image size. We must adjust fov and image size, but reset afterwards.
-	StelProjector::StelProjectorParams pParams=StelApp::getInstance().getCore()->getCurrentStelProjectorParams();
+	StelCore* core = StelApp::getInstance().getCore();
+	StelProjector::StelProjectorParams pParams=core->getCurrentStelProjectorParams();
 	StelProjector::StelProjectorParams sParams=pParams;
 	//qCDebug(mainview) << "Screenshot Viewport: x" << pParams.viewportXywh[0] << "/y" << pParams.viewportXywh[1] << "/w" << pParams.viewportXywh[2] << "/h" << pParams.viewportXywh[3];
 	sParams.viewportXywh[2]=imgWidth;
 	sParams.viewportXywh[3]=imgHeight;
+	sParams.viewportCenter.set(0.0+(0.5+pParams.viewportCenterOffset.v[0])*imgWidth, 0.0+(0.5+pParams.viewportCenterOffset.v[1])*imgHeight);
+	sParams.viewportFovDiameter = qMin(imgWidth,imgHeight);
 
 	// Configure a helper value to allow some modules to tweak their output sizes. Currently used by StarMgr, maybe solve font issues?
 	customScreenshotMagnification=(float)imgHeight/QApplication::desktop()->screenGeometry().height();
 
-	sParams.viewportCenter.set(0.0+(0.5+pParams.viewportCenterOffset.v[0])*imgWidth, 0.0+(0.5+pParams.viewportCenterOffset.v[1])*imgHeight);
-	sParams.viewportFovDiameter = qMin(imgWidth,imgHeight);
-	StelApp::getInstance().getCore()->setCurrentStelProjectorParams(sParams);
-
-	QPainter painter;
-	painter.begin(&fbObjPaintDev);
-	// next line was above begin(), but caused a complaint. Maybe use after begin()?
-	painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
 	stelScene->setSceneRect(0, 0, imgWidth, imgHeight);
-
 	// push the button bars back to the sides where they belong, and fix root item clipping its children.
 	dynamic_cast<StelGui*>(gui)->getSkyGui()->setGeometry(0, 0, imgWidth, imgHeight);
 	rootItem->setSize(QSize(imgWidth, imgHeight));
 	dynamic_cast<StelGui*>(gui)->forceRefreshGui(); // refresh bar position.
 
-	stelScene->render(&painter, QRectF(), QRectF(0,0,imgWidth,imgHeight) , Qt::KeepAspectRatio);
-	painter.end();
+	// All the tiles must show the same instant, so the time is set back before each tile and resumed at the end.
+	const double startJD = core->getJD();
+	const qint64 startMSecs = QDateTime::currentMSecsSinceEpoch();
+
+	// Each tile runs a full update, where the atmosphere brightness and the eye adaptation would follow the part of the sky
+	// in the tile, giving each tile another exposure. Freeze them at the values of the last frame, which shows the same view.
+	StelSkyDrawer* skyDrawer = core->getSkyDrawer();
+	LandscapeMgr* landscapeMgr = GETSTELMODULE(LandscapeMgr);
+	const bool atmosphereLuminanceFrozen = landscapeMgr->getFlagAtmosphereAverageLuminanceOverride();
+	const bool eyeAdaptationFrozen = skyDrawer->getWorldAdaptationLuminanceOverride()>=0.f;
+	// The additional cameras are drawn at fixed places of the framebuffer of the main view, or into their own framebuffer:
+	// they do not belong to the tiles and would be redrawn for each of them.
+	const bool drawCameras = core->getFlagDrawCameras();
+	if (tiled)
+	{
+		core->setFlagDrawCameras(false);
+		if (!atmosphereLuminanceFrozen)
+			landscapeMgr->setAtmosphereAverageLuminance(landscapeMgr->getAtmosphereAverageLuminance());
+		if (!eyeAdaptationFrozen)
+			skyDrawer->setWorldAdaptationLuminanceOverride(core->getToneReproducer()->getWorldAdaptationLuminance());
+	}
 
 	QImage im;
-	if (isGLES)
+	for (int tileY=0; tileY<imgHeight; tileY+=tileSize)
 	{
-		// We have RGBA texture with possibly empty spots when atmosphere was off.
-		// See toImage() help entry why to create wrapper here.
-		QImage fboImage(fbObj->toImage());
-		//qDebug() << "FBOimage format:" << fboImage.format(); // returns Format_RGBA8888_Premultiplied
-		QImage im2(fboImage.constBits(), fboImage.width(), fboImage.height(), QImage::Format_RGBX8888);
-		im=im2.copy();
+		for (int tileX=0; tileX<imgWidth; tileX+=tileSize)
+		{
+			const QRect tileRect(tileX, tileY, qMin(tileSize, imgWidth-tileX), qMin(tileSize, imgHeight-tileY));
+			const QRect renderRect = tileRect.adjusted(-tileMargin, -tileMargin, tileMargin, tileMargin);
+			if (tiled)
+			{
+				core->setJD(startJD);
+				rootItem->resetPaintTime();
+			}
+
+			QOpenGLFramebufferObject * fbObj = new QOpenGLFramebufferObject(renderRect.width() * pixelRatio, renderRect.height() * pixelRatio, fbFormat);
+			fbObj->bind();
+			// Now the painter has to be convinced to paint to the potentially larger image frame.
+			QOpenGLPaintDevice fbObjPaintDev(renderRect.width(), renderRect.height());
+			fbObjPaintDev.setDevicePixelRatio(pixelRatio);
+
+			core->setCurrentStelProjectorParams(sParams.getTileParams(renderRect.x(), renderRect.y(), renderRect.width(), renderRect.height()));
+
+			QPainter painter;
+			painter.begin(&fbObjPaintDev);
+			// next line was above begin(), but caused a complaint. Maybe use after begin()?
+			painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+			stelScene->render(&painter, QRectF(), QRectF(renderRect), Qt::KeepAspectRatio);
+			painter.end();
+
+			QImage tileImage;
+			if (isGLES)
+			{
+				// We have RGBA texture with possibly empty spots when atmosphere was off.
+				// See toImage() help entry why to create wrapper here.
+				QImage fboImage(fbObj->toImage());
+				//qDebug() << "FBOimage format:" << fboImage.format(); // returns Format_RGBA8888_Premultiplied
+				QImage im2(fboImage.constBits(), fboImage.width(), fboImage.height(), QImage::Format_RGBX8888);
+				tileImage=im2.copy();
+			}
+			else
+				tileImage=fbObj->toImage();
+			fbObj->release();
+			delete fbObj;
+
+			if (!tiled)
+			{
+				im=tileImage;
+				continue;
+			}
+
+			// Copy the tile without its margin into the full image
+			if (im.isNull())
+			{
+				im=QImage(qRound(imgWidth*pixelRatio), qRound(imgHeight*pixelRatio), tileImage.format());
+				if (im.isNull())
+				{
+					qCWarning(mainview) << "Cannot allocate a screenshot image of" << imgWidth << "x" << imgHeight << "pixels! Aborting.";
+					tileY=imgHeight;
+					break;
+				}
+			}
+			const int bytesPerPixel = tileImage.depth()/8;
+			const int srcOffset = qRound(tileMargin*pixelRatio);
+			const int dstX = qRound(tileRect.left()*pixelRatio);
+			const int dstY = qRound(tileRect.top()*pixelRatio);
+			const int width = qMin(qRound(tileRect.width()*pixelRatio), im.width()-dstX);
+			const int height = qMin(qRound(tileRect.height()*pixelRatio), im.height()-dstY);
+			for (int row=0; row<height; ++row)
+			{
+				memcpy(im.scanLine(dstY+row) + dstX*bytesPerPixel, tileImage.constScanLine(srcOffset+row) + srcOffset*bytesPerPixel, static_cast<size_t>(width*bytesPerPixel));
+			}
+		}
 	}
-	else
-		im=fbObj->toImage();
-	fbObj->release();
-	delete fbObj;
-	// reset viewport and GUI
-	StelApp::getInstance().getCore()->setCurrentStelProjectorParams(pParams);
+
+	// reset viewport, time, exposure and GUI
+	if (tiled)
+	{
+		core->setFlagDrawCameras(drawCameras);
+		core->setJD(startJD + (QDateTime::currentMSecsSinceEpoch()-startMSecs)/1000.*core->getTimeRate());
+		if (!atmosphereLuminanceFrozen)
+			landscapeMgr->setAtmosphereAverageLuminance(-1.f);
+		if (!eyeAdaptationFrozen)
+			skyDrawer->setWorldAdaptationLuminanceOverride(-1.f);
+	}
+	core->setCurrentStelProjectorParams(pParams);
 	customScreenshotMagnification=1.0f;
 	nightModeEffect->setEnabled(nightModeWasEnabled);
 	stelScene->setSceneRect(0, 0, pParams.viewportXywh[2], pParams.viewportXywh[3]);
 	rootItem->setSize(QSize(pParams.viewportXywh[2], pParams.viewportXywh[3]));
 	dynamic_cast<StelGui*>(gui)->getSkyGui()->setGeometry(0, 0, pParams.viewportXywh[2], pParams.viewportXywh[3]);
 	dynamic_cast<StelGui*>(gui)->forceRefreshGui();
+	if (im.isNull())
+		return;
 #endif
 
-	if (nightModeWasEnabled)
-	{
-		for (int row=0; row<im.height(); ++row)
-			for (int col=0; col<im.width(); ++col)
-			{
-				QRgb rgb=im.pixel(col, row);
-				int gray=qGray(rgb);
-				im.setPixel(col, row, qRgb(gray, 0, 0));
-			}
-	}
-	if (flagInvertScreenShotColors)
-		im.invertPixels();
-
 	if (StelFileMgr::getScreenshotDir().isEmpty())
 	{
 		qWarning() << "Oops, the directory for screenshots is not set! Let's try create and set it...";
@@ -1618,6 +1796,9 @@ void StelMainView::doScreenshot(void)
 		return;
 	}
 
+	// The previous screenshot must be written before looking for a free file name
+	screenshotWriter.waitForFinished();
+
 	QFileInfo shotPath;
 	if (flagOverwriteScreenshots)
 	{
@@ -1633,21 +1814,8 @@ void StelMainView::doScreenshot(void)
 		}
 	}
 	qDebug() << "INFO Saving screenshot in file: " << QDir::toNativeSeparators(shotPath.filePath());
-	QImageWriter imageWriter(shotPath.filePath());
-	if (screenShotFormat=="tif")
-		imageWriter.setCompression(1); // use LZW
-	if (screenShotFormat=="jpg")
-	{
-		imageWriter.setQuality(75); // This is actually default
-	}
-	if (screenShotFormat=="jpeg")
-	{
-		imageWriter.setQuality(100);
-	}
-	if (!imageWriter.write(im))
-	{
-		qWarning() << "WARNING failed to write screenshot to: " << QDir::toNativeSeparators(shotPath.filePath());
-	}
+	// The color changes and the encoding, which can take seconds for large images, are done in a worker thread
+	screenshotWriter = QtConcurrent::run(&writeScreenshot, im, shotPath.filePath(), screenShotFormat, nightModeWasEnabled, flagInvertScreenShotColors);
 }
 
 QPoint StelMainView::getMousePos() const
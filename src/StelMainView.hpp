@@ -23,6 +23,7 @@
 #include <QCoreApplication>
 #include <QGraphicsView>
 #include <QEventLoop>
+#include <QFuture>
 #include <QOpenGLContext>
 #include <QTimer>
 #ifdef OPENGL_DEBUG_LOGGING
@@ -209,6 +210,8 @@ protected:
 	virtual void resizeEvent(QResizeEvent* event) Q_DECL_OVERRIDE;
 	//! Wake up mouse cursor (if it was hidden)
 	virtual void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
+	//! Notify the full screen changes made by the window manager, so that the GUI doesn't need to poll them
+	virtual void changeEvent(QEvent* event) Q_DECL_OVERRIDE;
 signals:
 	//! emitted when saveScreenShot is requested with saveScreenShot().
 	//! doScreenshot() does the actual work (it has to do it in the main
@@ -293,6 +296,8 @@ private:
 	QString screenShotPrefix;
 	QString screenShotFormat; //! file type like "png" or "jpg".
 	QString screenShotDir;
+	//! The writing of the last screenshot, which is done in a worker thread.
+	QFuture<bool> screenshotWriter;
 
 	bool flagCursorTimeout;
 	//! Timer that triggers with the cursor timeout.
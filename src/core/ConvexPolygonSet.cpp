@@ -0,0 +1,520 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "ConvexPolygonSet.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Vertices closer than this to a great circle [radians] are considered to lay on it
+static const double CLIP_EPSILON = 1e-14;
+// Pieces smaller than this [steradians] are slivers resulting from the clipping along common sides
+static const double MIN_PIECE_AREA = 1e-13;
+
+// Signed area of a spherical triangle, positive for the orientation of the pieces.
+// Uses the formula of Van Oosterom and Strackee, which stays accurate for very thin triangles.
+static double orientedTriangleArea(const Vec3d& a, const Vec3d& b, const Vec3d& c)
+{
+	return 2.*std::atan2((b^a)*c, 1. + a*b + b*c + c*a);
+}
+
+// Inward normal of the side i of a piece contour
+static Vec3d sideNormal(const QVector<Vec3d>& contour, int i)
+{
+	Vec3d n = contour.at((i+1)%contour.size())^contour.at(i);
+	n.normalize();
+	return n;
+}
+
+// Return whether all the points are outside or on the border of one of the sides of the convex contour
+static bool areAllPointsOutsideOneSide(const QVector<Vec3d>& contour, const QVector<Vec3d>& points)
+{
+	for (int i=0;i<contour.size();++i)
+	{
+		const Vec3d n = sideNormal(contour, i);
+		bool allOutside = true;
+		for (const auto& p : points)
+		{
+			if (p*n>CLIP_EPSILON)
+			{
+				allOutside = false;
+				break;
+			}
+		}
+		if (allOutside)
+			return true;
+	}
+	return false;
+}
+
+ConvexPolygonSet::ConvexPolygonSet(const OctahedronPolygon& octPoly) : complement(false)
+{
+	const StelVertexArray va = octPoly.getFillVertexArray();
+	Q_ASSERT(va.primitiveType==StelVertexArray::Triangles);
+	const QVector<Vec3d>& trianglesArray = va.vertex;
+	pieces.reserve(trianglesArray.size()/3);
+	for (int i=0;i<trianglesArray.size()/3;++i)
+	{
+		QVector<Vec3d> contour;
+		contour << trianglesArray.at(i*3) << trianglesArray.at(i*3+1) << trianglesArray.at(i*3+2);
+		Piece piece;
+		if (makePiece(contour, piece))
+			pieces.append(piece);
+	}
+}
+
+ConvexPolygonSet::ConvexPolygonSet(const QVector<Vec3d>& convexContour) : complement(false)
+{
+	QVector<Vec3d> contour(convexContour);
+	Piece piece;
+	if (makePiece(contour, piece))
+		pieces.append(piece);
+}
+
+ConvexPolygonSet::ConvexPolygonSet(const QVector<QVector<Vec3d> >& disjointConvexContours) : complement(false)
+{
+	pieces.reserve(disjointConvexContours.size());
+	for (const auto& convexContour : disjointConvexContours)
+	{
+		QVector<Vec3d> contour(convexContour);
+		Piece piece;
+		if (makePiece(contour, piece))
+			pieces.append(piece);
+	}
+}
+
+ConvexPolygonSet ConvexPolygonSet::allSky()
+{
+	ConvexPolygonSet res;
+	res.complement = true;
+	return res;
+}
+
+QVector<ConvexPolygonSet::Piece> ConvexPolygonSet::allSkyPieces()
+{
+	// The 8 sides of the octahedron
+	QVector<Piece> res;
+	for (int i=0;i<8;++i)
+	{
+		QVector<Vec3d> contour;
+		contour << Vec3d((i&1) ? -1. : 1., 0., 0.) << Vec3d(0., (i&2) ? -1. : 1., 0.) << Vec3d(0., 0., (i&4) ? -1. : 1.);
+		Piece piece;
+		if (makePiece(contour, piece))
+			res.append(piece);
+	}
+	return res;
+}
+
+bool ConvexPolygonSet::makePiece(QVector<Vec3d>& contour, Piece& piece)
+{
+	// Remove the duplicated vertices
+	int n=0;
+	for (int i=0;i<contour.size();++i)
+	{
+		const Vec3d v = contour.at(i);
+		if (n>0 && (v-contour.at(n-1)).lengthSquared()<CLIP_EPSILON*CLIP_EPSILON)
+			continue;
+		contour[n++] = v;
+	}
+	while (n>1 && (contour.at(n-1)-contour.at(0)).lengthSquared()<CLIP_EPSILON*CLIP_EPSILON)
+		--n;
+	if (n<3)
+		return false;
+	contour.resize(n);
+
+	double area = 0.;
+	for (int i=1;i<n-1;++i)
+		area += orientedTriangleArea(contour.at(0), contour.at(i), contour.at(i+1));
+	if (area<0.)
+	{
+		std::reverse(contour.begin(), contour.end());
+		area = -area;
+	}
+	if (area<MIN_PIECE_AREA)
+		return false;
+
+	piece.contour = contour;
+	piece.area = area;
+	piece.capN.set(0.,0.,0.);
+	for (const auto& v : contour)
+		piece.capN += v;
+	piece.capN.normalize();
+	piece.capD = 1.;
+	for (const auto& v : contour)
+		piece.capD = qMin(piece.capD, piece.capN*v);
+	// The cap is only exact if the contour lies in the hemisphere of its center
+	piece.capD = piece.capD>0. ? piece.capD*0.9999999 : -1.;
+	return true;
+}
+
+void ConvexPolygonSet::clipContour(const QVector<Vec3d>& contour, const Vec3d& n, QVector<Vec3d>& result)
+{
+	result.clear();
+	const int size = contour.size();
+	for (int i=0;i<size;++i)
+	{
+		const Vec3d& cur = contour.at(i);
+		const Vec3d& next = contour.at((i+1)%size);
+		const double dc = cur*n;
+		const double dn = next*n;
+		if (dc>=-CLIP_EPSILON)
+			result.append(cur);
+		if ((dc>CLIP_EPSILON && dn<-CLIP_EPSILON) || (dc<-CLIP_EPSILON && dn>CLIP_EPSILON))
+		{
+			// Intersection of the side with the great circle, on the minor arc between both vertices
+			Vec3d v = (next*dc - cur*dn)/(dc-dn);
+			v.normalize();
+			result.append(v);
+		}
+	}
+}
+
+bool ConvexPolygonSet::capsIntersect(const Piece& p1, const Piece& p2)
+{
+	return capsIntersect(p1.capN, p1.capD, p2.capN, p2.capD);
+}
+
+bool ConvexPolygonSet::capsIntersect(const Vec3d& n1, double d1, const Vec3d& n2, double d2)
+{
+	// Same as SphericalCap::intersects()
+	if (d1>1. || d2>1.)
+		return false;
+	const double a = d1*d2 - n1*n2;
+	return d1+d2<=0. || a<=0. || (a<=1. && a*a <= (1.-d1*d1)*(1.-d2*d2));
+}
+
+void ConvexPolygonSet::piecesBoundingCap(const QVector<Piece>& pieces, Vec3d& n, double& d)
+{
+	if (pieces.isEmpty())
+	{
+		n.set(1.,0.,0.);
+		d = 2.;
+		return;
+	}
+	n.set(0.,0.,0.);
+	for (const auto& p : pieces)
+		n += p.capN*p.area;
+	if (n.lengthSquared()<1e-20)
+	{
+		n.set(1.,0.,0.);
+		d = -2.;
+		return;
+	}
+	n.normalize();
+	double aperture = 0.;
+	for (const auto& p : pieces)
+	{
+		aperture = qMax(aperture, n.angleNormalized(p.capN) + (p.capD<=-1. ? M_PI : std::acos(p.capD)));
+		if (aperture>=M_PI)
+		{
+			d = -2.;
+			return;
+		}
+	}
+	d = std::cos(aperture);
+}
+
+bool ConvexPolygonSet::pieceContains(const Piece& piece, const Vec3d& p)
+{
+	if (p*piece.capN<piece.capD)
+		return false;
+	const QVector<Vec3d>& contour = piece.contour;
+	for (int i=0;i<contour.size();++i)
+	{
+		if ((contour.at((i+1)%contour.size())^contour.at(i))*p<-1e-17)
+			return false;
+	}
+	return true;
+}
+
+QVector<ConvexPolygonSet::Piece> ConvexPolygonSet::intersectPieces(const QVector<Piece>& a, const QVector<Piece>& b)
+{
+	QVector<Piece> res;
+	QVector<Vec3d> rest, part;
+	Vec3d bCapN;
+	double bCapD;
+	piecesBoundingCap(b, bCapN, bCapD);
+	for (const auto& pa : a)
+	{
+		if (!capsIntersect(pa.capN, pa.capD, bCapN, bCapD))
+			continue;
+		for (const auto& pb : b)
+		{
+			if (!capsIntersect(pa, pb))
+				continue;
+			if (areAllPointsOutsideOneSide(pa.contour, pb.contour) || areAllPointsOutsideOneSide(pb.contour, pa.contour))
+				continue;
+			rest = pa.contour;
+			for (int i=0;i<pb.contour.size() && rest.size()>=3;++i)
+			{
+				clipContour(rest, sideNormal(pb.contour, i), part);
+				rest.swap(part);
+			}
+			Piece piece;
+			if (makePiece(rest, piece))
+				res.append(piece);
+		}
+	}
+	return res;
+}
+
+QVector<ConvexPolygonSet::Piece> ConvexPolygonSet::subtractPieces(const QVector<Piece>& a, const QVector<Piece>& b)
+{
+	// The pieces of a outside of the bounding cap of b are kept as they are,
+	// and the pieces of b outside of the bounding cap of a are ignored.
+	Vec3d bCapN, aCapN;
+	double bCapD, aCapD;
+	piecesBoundingCap(b, bCapN, bCapD);
+	QVector<Piece> untouched, res;
+	for (const auto& pa : a)
+	{
+		if (capsIntersect(pa.capN, pa.capD, bCapN, bCapD))
+			res.append(pa);
+		else
+			untouched.append(pa);
+	}
+	piecesBoundingCap(res, aCapN, aCapD);
+
+	QVector<Piece> tmp;
+	QVector<Vec3d> rest, part;
+	for (const auto& pb : b)
+	{
+		if (res.isEmpty())
+			break;
+		if (!capsIntersect(pb.capN, pb.capD, aCapN, aCapD))
+			continue;
+		tmp.clear();
+		for (const auto& pa : res)
+		{
+			if (!capsIntersect(pa, pb) || areAllPointsOutsideOneSide(pa.contour, pb.contour) || areAllPointsOutsideOneSide(pb.contour, pa.contour))
+			{
+				tmp.append(pa);
+				continue;
+			}
+			// Split pa in the parts outside of each side of pb, the remaining part is inside pb
+			rest = pa.contour;
+			for (int i=0;i<pb.contour.size() && rest.size()>=3;++i)
+			{
+				const Vec3d n = sideNormal(pb.contour, i);
+				clipContour(rest, -n, part);
+				Piece piece;
+				if (makePiece(part, piece))
+					tmp.append(piece);
+				clipContour(rest, n, part);
+				rest.swap(part);
+			}
+		}
+		res.swap(tmp);
+	}
+	return untouched.isEmpty() ? res : untouched + res;
+}
+
+QVector<ConvexPolygonSet::Piece> ConvexPolygonSet::unitePieces(const QVector<Piece>& a, const QVector<Piece>& b)
+{
+	if (a.isEmpty())
+		return b;
+	// Keep the pieces disjoint
+	return a + subtractPieces(b, a);
+}
+
+double ConvexPolygonSet::sumArea(const QVector<Piece>& a)
+{
+	double area = 0.;
+	for (const auto& p : a)
+		area += p.area;
+	return area;
+}
+
+double ConvexPolygonSet::getArea() const
+{
+	return complement ? 4.*M_PI - sumArea(pieces) : sumArea(pieces);
+}
+
+bool ConvexPolygonSet::isEmpty() const
+{
+	return complement ? getArea()<MIN_PIECE_AREA : pieces.isEmpty();
+}
+
+Vec3d ConvexPolygonSet::getPointInside() const
+{
+	const QVector<Piece> p = getPieces();
+	Q_ASSERT(!p.isEmpty());
+	int largest = 0;
+	for (int i=1;i<p.size();++i)
+	{
+		if (p.at(i).area>p.at(largest).area)
+			largest = i;
+	}
+	Vec3d res(0.);
+	for (const auto& v : p.at(largest).contour)
+		res += v;
+	res.normalize();
+	return res;
+}
+
+void ConvexPolygonSet::getBoundingCap(Vec3d& n, double& d) const
+{
+	if (complement)
+	{
+		n.set(1.,0.,0.);
+		d = -2.;
+		return;
+	}
+	piecesBoundingCap(pieces, n, d);
+}
+
+bool ConvexPolygonSet::contains(const Vec3d& p) const
+{
+	for (const auto& piece : pieces)
+	{
+		if (pieceContains(piece, p))
+			return !complement;
+	}
+	return complement;
+}
+
+bool ConvexPolygonSet::contains(const ConvexPolygonSet& other) const
+{
+	ConvexPolygonSet res(other);
+	res.inPlaceSubtraction(*this);
+	return res.isEmpty();
+}
+
+bool ConvexPolygonSet::intersects(const ConvexPolygonSet& other) const
+{
+	if (!complement && !other.complement)
+	{
+		// Stop at the first intersecting pair
+		QVector<Piece> b(1);
+		for (const auto& pb : other.pieces)
+		{
+			b[0] = pb;
+			if (!intersectPieces(pieces, b).isEmpty())
+				return true;
+		}
+		return false;
+	}
+	ConvexPolygonSet res(*this);
+	res.inPlaceIntersection(other);
+	return !res.isEmpty();
+}
+
+void ConvexPolygonSet::inPlaceIntersection(const ConvexPolygonSet& other)
+{
+	if (!complement && !other.complement)
+		pieces = intersectPieces(pieces, other.pieces);
+	else if (!complement)
+		pieces = subtractPieces(pieces, other.pieces);
+	else if (!other.complement)
+	{
+		pieces = subtractPieces(other.pieces, pieces);
+		complement = false;
+	}
+	else
+		pieces = unitePieces(pieces, other.pieces);
+}
+
+void ConvexPolygonSet::inPlaceUnion(const ConvexPolygonSet& other)
+{
+	if (!complement && !other.complement)
+		pieces = unitePieces(pieces, other.pieces);
+	else if (!complement)
+	{
+		pieces = subtractPieces(other.pieces, pieces);
+		complement = true;
+	}
+	else if (!other.complement)
+		pieces = subtractPieces(pieces, other.pieces);
+	else
+		pieces = intersectPieces(pieces, other.pieces);
+}
+
+void ConvexPolygonSet::inPlaceSubtraction(const ConvexPolygonSet& other)
+{
+	ConvexPolygonSet inverted(other);
+	inverted.inPlaceComplement();
+	inPlaceIntersection(inverted);
+}
+
+QVector<ConvexPolygonSet::Piece> ConvexPolygonSet::getPieces() const
+{
+	return complement ? subtractPieces(allSkyPieces(), pieces) : pieces;
+}
+
+StelVertexArray ConvexPolygonSet::getFillVertexArray() const
+{
+	StelVertexArray res(StelVertexArray::Triangles);
+	for (const auto& p : getPieces())
+	{
+		for (int i=1;i<p.contour.size()-1;++i)
+			res.vertex << p.contour.at(0) << p.contour.at(i) << p.contour.at(i+1);
+	}
+	return res;
+}
+
+OctahedronPolygon ConvexPolygonSet::toOctahedronPolygon() const
+{
+	QVector<QVector<Vec3d> > contours;
+	contours.reserve(pieces.size());
+	for (const auto& p : pieces)
+		contours << p.contour;
+	// The pieces are disjoint, so that the positive winding rule gives their union
+	OctahedronPolygon res = contours.isEmpty() ? OctahedronPolygon::getEmptyOctahedronPolygon() : OctahedronPolygon(contours);
+	if (complement)
+	{
+		OctahedronPolygon allSkyPoly(OctahedronPolygon::getAllSkyOctahedronPolygon());
+		allSkyPoly.inPlaceSubtraction(res);
+		return allSkyPoly;
+	}
+	return res;
+}
+
+StelVertexArray ConvexPolygonSet::getOutlineVertexArray() const
+{
+	if (pieces.isEmpty())
+		return StelVertexArray(StelVertexArray::Lines);
+	QVector<QVector<Vec3d> > contours;
+	contours.reserve(pieces.size());
+	for (const auto& p : pieces)
+		contours << p.contour;
+	return OctahedronPolygon(contours).getOutlineVertexArray();
+}
+
+bool ConvexPolygonSet::isConvexContour(const QVector<Vec3d>& contour)
+{
+	if (contour.size()<3)
+		return false;
+	// All the vertices must be on the inner side of each side. A contour with the opposite orientation stands
+	// for the rest of the sphere, and contours wider than a hemisphere have vertices on both sides of a side.
+	for (int i=0;i<contour.size();++i)
+	{
+		const Vec3d n = contour.at((i+1)%contour.size())^contour.at(i);
+		if (n.lengthSquared()<CLIP_EPSILON*CLIP_EPSILON)
+			return false;
+		for (const auto& v : contour)
+		{
+			if (n*v<-CLIP_EPSILON)
+				return false;
+		}
+	}
+	// The sum of the vertices must be inside, which fails for a contour going around a great circle.
+	Vec3d center(0.);
+	for (const auto& v : contour)
+		center += v;
+	return center.lengthSquared()>1e-20;
+}
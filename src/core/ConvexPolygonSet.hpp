@@ -0,0 +1,122 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef CONVEXPOLYGONSET_HPP
+#define CONVEXPOLYGONSET_HPP
+
+#include "OctahedronPolygon.hpp"
+#include "StelVertexArray.hpp"
+#include "VecMath.hpp"
+
+#include <QVector>
+
+//! @class ConvexPolygonSet
+//! Manage a region of the sphere as a set of disjoint convex spherical polygons, each one lying within one hemisphere.
+//! Boolean operations are computed natively by clipping the convex pieces against the great circles of the other
+//! region's pieces, so that no tesselation is needed:
+//! - the intersection of two convex pieces is a convex piece,
+//! - the subtraction of a convex piece from another one is split in at most one convex piece per side of the subtracted one,
+//! - the union of A and B is A plus the pieces of B minus A.
+//! A region can also be stored as the complement of its pieces, so that subtracting a region from the full sky
+//! (e.g. for landscape horizons) costs nothing. The triangles needed for drawing are fans of the pieces, and the
+//! OctahedronPolygon, whose tesselation provides the outline, is only computed on demand.
+class ConvexPolygonSet
+{
+public:
+	//! @struct Piece
+	//! A convex spherical polygon. A point p is inside if (contour[i+1]^contour[i])*p>=0 for all the sides,
+	//! i.e. the same orientation as for SphericalConvexPolygon.
+	struct Piece
+	{
+		QVector<Vec3d> contour;
+		//! Bounding cap, defined by its direction and the cosine of its aperture.
+		Vec3d capN;
+		double capD;
+		double area;
+	};
+
+	//! Create an empty set.
+	ConvexPolygonSet() : complement(false) {;}
+	//! Create the set from the triangles resulting from the tesselation of the OctahedronPolygon.
+	explicit ConvexPolygonSet(const OctahedronPolygon& octPoly);
+	//! Create the set from a convex contour which must lie within one hemisphere.
+	explicit ConvexPolygonSet(const QVector<Vec3d>& convexContour);
+	//! Create the set from disjoint convex contours, e.g. the cells of a HEALPix map.
+	explicit ConvexPolygonSet(const QVector<QVector<Vec3d> >& disjointConvexContours);
+
+	//! Return the set covering the full sphere.
+	static ConvexPolygonSet allSky();
+
+	double getArea() const;
+	bool isEmpty() const;
+	Vec3d getPointInside() const;
+	void getBoundingCap(Vec3d& n, double& d) const;
+
+	bool contains(const Vec3d& p) const;
+	bool contains(const ConvexPolygonSet& other) const;
+	bool intersects(const ConvexPolygonSet& other) const;
+
+	//! Set this ConvexPolygonSet as the intersection of itself with the given one.
+	void inPlaceIntersection(const ConvexPolygonSet& other);
+	//! Set this ConvexPolygonSet as the union of itself with the given one.
+	void inPlaceUnion(const ConvexPolygonSet& other);
+	//! Set this ConvexPolygonSet as the subtraction of the given one from itself.
+	void inPlaceSubtraction(const ConvexPolygonSet& other);
+	//! Set this ConvexPolygonSet as its complement on the sphere. This is a constant time operation.
+	void inPlaceComplement() {complement=!complement;}
+
+	//! Return the list of disjoint convex pieces covering the region.
+	//! For a complemented set, the pieces are computed by subtracting the stored pieces from the full sky.
+	QVector<Piece> getPieces() const;
+	//! Return the triangles of the pieces, to be used for drawing.
+	StelVertexArray getFillVertexArray() const;
+	//! Compute the equivalent OctahedronPolygon. This needs a tesselation, so it should only be used when the outline is needed.
+	OctahedronPolygon toOctahedronPolygon() const;
+	//! Return the outline of the region. A region and its complement have the same outline, so that only
+	//! the stored pieces are tesselated, without subtracting them from the full sky.
+	StelVertexArray getOutlineVertexArray() const;
+
+	//! Return whether the contour is convex, lies within one hemisphere and has the orientation of the pieces,
+	//! i.e. whether it describes the same region as a piece and as a contour of an OctahedronPolygon.
+	static bool isConvexContour(const QVector<Vec3d>& contour);
+
+private:
+	//! Pieces of the set, or of its complement if complement is true.
+	QVector<Piece> pieces;
+	bool complement;
+
+	//! Compute the bounding cap and area of a piece, and return false if it is degenerated.
+	static bool makePiece(QVector<Vec3d>& contour, Piece& piece);
+	//! Keep the part of a convex contour where v*n>=0.
+	static void clipContour(const QVector<Vec3d>& contour, const Vec3d& n, QVector<Vec3d>& result);
+	static bool capsIntersect(const Piece& p1, const Piece& p2);
+	static bool capsIntersect(const Vec3d& n1, double d1, const Vec3d& n2, double d2);
+	//! Compute a cap containing all the pieces. d is -2 if it is the full sphere, 2 if there are no pieces.
+	static void piecesBoundingCap(const QVector<Piece>& pieces, Vec3d& n, double& d);
+	static bool pieceContains(const Piece& piece, const Vec3d& p);
+
+	static QVector<Piece> allSkyPieces();
+	static QVector<Piece> intersectPieces(const QVector<Piece>& a, const QVector<Piece>& b);
+	static QVector<Piece> subtractPieces(const QVector<Piece>& a, const QVector<Piece>& b);
+	static QVector<Piece> unitePieces(const QVector<Piece>& a, const QVector<Piece>& b);
+	static double sumArea(const QVector<Piece>& a);
+};
+
+Q_DECLARE_TYPEINFO(ConvexPolygonSet::Piece, Q_MOVABLE_TYPE);
+
+#endif // CONVEXPOLYGONSET_HPP
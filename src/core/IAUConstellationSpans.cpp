@@ -0,0 +1,199 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "IAUConstellationSpans.hpp"
+#include "StelUtils.hpp"
+
+#include <QDebug>
+#include <QFile>
+#include <QRegExp>
+#include <QTextStream>
+
+// Grid resolution: 4 minutes of right ascension by half a degree of declination
+static const int GRID_RA = 360;
+static const int GRID_DEC = 360;
+// Margin on the cell borders, so that rounding of the cell index can never drop a candidate span
+static const double GRID_EPSILON = 1e-9;
+
+IAUConstellationSpans::IAUConstellationSpans(const QString& fileName)
+	: useGrid(false)
+{
+	if (load(fileName))
+		buildGrid();
+}
+
+// File constellations_spans.dat is converted from file data.dat from ADC catalog VI/42.
+// We converted back to HH:MM:SS format to avoid the inherent rounding errors present in that file (Bug LP:#1690615).
+bool IAUConstellationSpans::load(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning() << "IAU constellation line data file data/constellations_spans.dat not found.";
+		return false;
+	}
+
+	QRegExp emptyLine("^\\s*$");
+	QTextStream in(&file);
+	while (!in.atEnd())
+	{
+		// Build list of entries. The checks can certainly become more robust. Actually the file must have 4-part lines.
+		QString line = in.readLine();
+		if (line.length()==0) continue;
+		if (emptyLine.exactMatch((line))) continue;
+		if (line.at(0)=='#') continue; // skip comment lines.
+		QStringList list = line.trimmed().split(QRegExp("\\s+"));
+		if (list.count() != 4)
+		{
+			qWarning() << "IAU constellation file constellations_spans.dat has bad line:" << line << "with" << list.count() << "elements";
+			continue;
+		}
+		Span span;
+		QStringList numList=list.at(0).split(QRegExp(":"));
+		span.RAlow= atof(numList.at(0).toLatin1()) + atof(numList.at(1).toLatin1())/60. + atof(numList.at(2).toLatin1())/3600.;
+		numList=list.at(1).split(QRegExp(":"));
+		span.RAhigh=atof(numList.at(0).toLatin1()) + atof(numList.at(1).toLatin1())/60. + atof(numList.at(2).toLatin1())/3600.;
+		numList=list.at(2).split(QRegExp(":"));
+		span.decLow=atof(numList.at(0).toLatin1());
+		if (numList.at(0).startsWith('-')) // also for -00:mm
+			span.decLow -= atof(numList.at(1).toLatin1())/60.;
+		else
+			span.decLow += atof(numList.at(1).toLatin1())/60.;
+		span.constellation=constellations.indexOf(list.at(3));
+		if (span.constellation<0)
+		{
+			span.constellation=constellations.size();
+			constellations << list.at(3);
+		}
+		spans.append(span);
+	}
+	file.close();
+	return !spans.isEmpty();
+}
+
+void IAUConstellationSpans::buildGrid()
+{
+	// The first span below a position is only the first one in the list if the list is sorted by declination
+	for (int i=1; i<spans.size(); ++i)
+	{
+		if (spans.at(i).decLow > spans.at(i-1).decLow)
+		{
+			qWarning() << "IAU constellation spans are not sorted by declination, the lookup grid is disabled.";
+			return;
+		}
+	}
+
+	cellStart.reserve(GRID_RA*GRID_DEC+1);
+	for (int j=0; j<GRID_DEC; ++j)
+	{
+		const double dec0 = -90. + 180.*j/GRID_DEC - GRID_EPSILON;
+		const double dec1 = -90. + 180.*(j+1)/GRID_DEC + GRID_EPSILON;
+		for (int i=0; i<GRID_RA; ++i)
+		{
+			const double RA0 = 24.*i/GRID_RA - GRID_EPSILON;
+			const double RA1 = 24.*(i+1)/GRID_RA + GRID_EPSILON;
+			cellStart << cellSpans.size();
+			for (int s=0; s<spans.size(); ++s)
+			{
+				const Span& span = spans.at(s);
+				// Keep every span which may contain a position of the cell...
+				if (span.decLow<=dec1 && span.RAlow<=RA1 && span.RAhigh>=RA0)
+					cellSpans << s;
+				// ...until one contains all of them: the following ones are never reached.
+				if (span.decLow<=dec0 && span.RAlow<RA0 && span.RAhigh>RA1)
+					break;
+			}
+		}
+	}
+	cellStart << cellSpans.size();
+	cellSpans.squeeze();
+	useGrid = true;
+	qDebug() << "IAU constellation lookup grid:" << spans.size() << "spans," << cellSpans.size() << "cell entries";
+}
+
+int IAUConstellationSpans::cellIndex(double RA1875, double dec1875) const
+{
+	const int i = qBound(0, static_cast<int>(RA1875*(GRID_RA/24.)), GRID_RA-1);
+	const int j = qBound(0, static_cast<int>((dec1875+90.)*(GRID_DEC/180.)), GRID_DEC-1);
+	return j*GRID_RA+i;
+}
+
+QString IAUConstellationSpans::find(double RA1875, double dec1875) const
+{
+	if (!useGrid)
+		return findLinear(RA1875, dec1875);
+
+	const int cell = cellIndex(RA1875, dec1875);
+	for (int k=cellStart.at(cell); k<cellStart.at(cell+1); ++k)
+	{
+		const Span& span = spans.at(cellSpans.at(k));
+		if (span.decLow<=dec1875 && span.RAlow<RA1875 && span.RAhigh>RA1875)
+			return constellations.at(span.constellation);
+	}
+	qDebug() << "getIAUconstellation error: Cannot determine, algorithm failed.";
+	return "(?)";
+}
+
+QString IAUConstellationSpans::find(const Vec3d& pos1875) const
+{
+	double RA1875, dec1875;
+	toRADec(pos1875, RA1875, dec1875);
+	return find(RA1875, dec1875);
+}
+
+QStringList IAUConstellationSpans::find(const QVector<Vec3d>& positions1875) const
+{
+	QStringList result;
+	result.reserve(positions1875.size());
+	for (const auto& pos : positions1875)
+		result << find(pos);
+	return result;
+}
+
+QString IAUConstellationSpans::findLinear(double RA1875, double dec1875) const
+{
+	// iterate through vector, find entry where declination is lower.
+	int entry=0;
+	while (entry<spans.size() && spans.at(entry).decLow > dec1875)
+		entry++;
+	while (entry<spans.size())
+	{
+		while (entry<spans.size() && spans.at(entry).RAhigh <= RA1875)
+			entry++;
+		while (entry<spans.size() && spans.at(entry).RAlow >= RA1875)
+			entry++;
+		if (entry<spans.size() && spans.at(entry).RAhigh > RA1875)
+			return constellations.at(spans.at(entry).constellation);
+		else
+			entry++;
+	}
+	qDebug() << "getIAUconstellation error: Cannot determine, algorithm failed.";
+	return "(?)";
+}
+
+void IAUConstellationSpans::toRADec(const Vec3d& pos1875, double& RA1875, double& dec1875)
+{
+	StelUtils::rectToSphe(&RA1875, &dec1875, pos1875);
+	RA1875 *= 12./M_PI; // hours
+	if (RA1875 <0.) RA1875+=24.;
+	dec1875 *= M_180_PI; // degrees
+	Q_ASSERT(RA1875>=0.0);
+	Q_ASSERT(RA1875<=24.0);
+	Q_ASSERT(dec1875<=90.0);
+	Q_ASSERT(dec1875>=-90.0);
+}
@@ -0,0 +1,84 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef IAUCONSTELLATIONSPANS_HPP
+#define IAUCONSTELLATIONSPANS_HPP
+
+#include "VecMath.hpp"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//! @class IAUConstellationSpans
+//! Identification of the IAU constellation containing a position.
+//! Follows 1987PASP...99..695R: Nancy Roman: Identification of a Constellation from a Position.
+//! The spans of the data file (ADC catalog VI/42 with its amendment from 1999-12-30) are sorted
+//! by decreasing declination of their southern border, and the constellation of a position is the one
+//! of the first span below it which contains its right ascension.
+//! To avoid walking the span list for every position, the sky is divided in a grid of cells in B1875 coordinates.
+//! Each cell stores the spans which can contain one of its positions, up to the first span covering the whole cell.
+//! The result is the same as the one of the linear walk of the original algorithm.
+class IAUConstellationSpans
+{
+public:
+	//! Load the spans from the given file, usually data/constellations_spans.dat.
+	IAUConstellationSpans(const QString& fileName);
+
+	//! @return true if the span data could be loaded.
+	bool isValid() const { return !spans.isEmpty(); }
+
+	//! @return the 3-letter abbreviation of the constellation containing the position.
+	//! @param RA1875 right ascension for B1875 in hours [0..24]
+	//! @param dec1875 declination for B1875 in degrees [-90..90]
+	QString find(double RA1875, double dec1875) const;
+	//! @return the 3-letter abbreviation of the constellation containing the position.
+	//! @param pos1875 position vector in rectangular equatorial coordinates for B1875.
+	QString find(const Vec3d& pos1875) const;
+	//! @return the 3-letter abbreviations of the constellations containing the positions.
+	//! @param positions1875 position vectors in rectangular equatorial coordinates for B1875.
+	QStringList find(const QVector<Vec3d>& positions1875) const;
+
+	//! @return right ascension [hours] and declination [degrees] of a B1875 position vector.
+	static void toRADec(const Vec3d& pos1875, double& RA1875, double& dec1875);
+
+private:
+	struct Span
+	{
+		double RAlow;  // low value of 1875.0 right ascension segment, HH.dddd
+		double RAhigh; // high value of 1875.0 right ascension segment, HH.dddd
+		double decLow; // declination 1875.0 of southern border, DD.dddd
+		int constellation; // index in constellations
+	};
+
+	bool load(const QString& fileName);
+	void buildGrid();
+	int cellIndex(double RA1875, double dec1875) const;
+	//! Walk the whole span list, used when the grid cannot be built.
+	QString findLinear(double RA1875, double dec1875) const;
+
+	QVector<Span> spans;
+	QStringList constellations;
+	// Spans of the cells, the ones of cell i are cellSpans[cellStart[i]..cellStart[i+1]-1]
+	QVector<int> cellStart;
+	QVector<int> cellSpans;
+	// The grid is only valid if the spans are sorted by decreasing declination, as in the original file
+	bool useGrid;
+};
+
+#endif // IAUCONSTELLATIONSPANS_HPP
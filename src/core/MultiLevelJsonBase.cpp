@@ -30,7 +30,15 @@
 #include <QUrl>
 #include <QDir>
 #include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSaveFile>
 #include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
@@ -41,6 +49,17 @@
 
 // Init statics
 QNetworkAccessManager* MultiLevelJsonBase::networkAccessManager = Q_NULLPTR;
+QThreadPool* MultiLevelJsonBase::loaderThreadPool = Q_NULLPTR;
+
+// Header and version of the files of parsed JSON in the cache
+static const quint32 JSON_CACHE_MAGIC = 0x534a4343;
+static const quint32 JSON_CACHE_VERSION = 1;
+// Files older than this are downloaded again
+static const int JSON_CACHE_MAX_AGE_DAYS = 30;
+// Maximal size of the cache directory, the oldest files are deleted beyond it [bytes]
+static const qint64 JSON_CACHE_MAX_SIZE = 64*1024*1024;
+// The cache directory is trimmed once per session, then after this number of new files
+static const int JSON_CACHE_TRIM_INTERVAL = 256;
 
 QNetworkAccessManager& MultiLevelJsonBase::getNetworkAccessManager()
 {
@@ -58,35 +77,130 @@ QNetworkAccessManager& MultiLevelJsonBase::getNetworkAccessManager()
 	return *networkAccessManager;
 }
 
+QThreadPool* MultiLevelJsonBase::getLoaderThreadPool()
+{
+	if (loaderThreadPool==Q_NULLPTR)
+	{
+		// The files are small, a couple of threads is enough to keep up with the downloads
+		// and leaves the other cores to the texture loaders.
+		loaderThreadPool = new QThreadPool(&StelApp::getInstance());
+		loaderThreadPool->setMaxThreadCount(qMin(2, QThread::idealThreadCount()));
+	}
+	return loaderThreadPool;
+}
+
+QString MultiLevelJsonBase::getCacheFileName(const QUrl& url)
+{
+	static QString cacheDir;
+	if (cacheDir.isEmpty())
+	{
+		cacheDir = StelFileMgr::getCacheDir()+"/JSONCache/";
+		QDir().mkpath(cacheDir);
+	}
+	return cacheDir + QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1).toHex() + ".bin";
+}
+
 /*************************************************************************
-  Class used to load a JSON file in a thread
+  Methods run in the loader thread pool
  *************************************************************************/
-class JsonLoadThread : public QThread
-{
-	public:
-		JsonLoadThread(MultiLevelJsonBase* atile, QByteArray content, bool aqZcompressed=false, bool agzCompressed=false) : QThread((QObject*)atile),
-			tile(atile), data(content), qZcompressed(aqZcompressed), gzCompressed(agzCompressed){;}
-		virtual void run();
-	private:
-		MultiLevelJsonBase* tile;
-		QByteArray data;
-		const bool qZcompressed;
-		const bool gzCompressed;
-};
-
-void JsonLoadThread::run()
+MultiLevelJsonBase::JsonLoadResult MultiLevelJsonBase::loadJsonData(const QByteArray& content, bool qZcompressed, bool gzCompressed, const QString& cacheFile)
 {
+	JsonLoadResult res;
 	try
 	{
+		QByteArray data(content);
 		QBuffer buf(&data);
 		buf.open(QIODevice::ReadOnly);
-		tile->temporaryResultMap = MultiLevelJsonBase::loadFromJSON(buf, qZcompressed, gzCompressed);
+		res.map = loadFromJSON(buf, qZcompressed, gzCompressed);
 	}
 	catch (std::runtime_error& e)
 	{
-		qWarning() << "WARNING : Can't parse loaded JSON description: " << e.what();
-		tile->errorOccured = true;
+		res.error = e.what();
+		return res;
+	}
+
+	if (!cacheFile.isEmpty())
+	{
+		QSaveFile f(cacheFile);
+		if (f.open(QIODevice::WriteOnly))
+		{
+			QDataStream out(&f);
+			out.setVersion(QDataStream::Qt_5_4);
+			out << JSON_CACHE_MAGIC << JSON_CACHE_VERSION << res.map;
+			if (out.status()!=QDataStream::Ok || !f.commit())
+				qWarning() << "WARNING : Can't write JSON cache file" << QDir::toNativeSeparators(cacheFile);
+		}
+		static QAtomicInt cacheWrites;
+		if (cacheWrites.fetchAndAddRelaxed(1)%JSON_CACHE_TRIM_INTERVAL==0)
+			trimCache(QFileInfo(cacheFile).absolutePath());
+	}
+	return res;
+}
+
+void MultiLevelJsonBase::trimCache(const QString& cacheDir)
+{
+	// Only one loader thread trims at a time
+	static QMutex trimMutex;
+	if (!trimMutex.tryLock())
+		return;
+	const QDateTime now = QDateTime::currentDateTime();
+	// Newest first
+	const QFileInfoList files = QDir(cacheDir).entryInfoList(QStringList() << "*.bin", QDir::Files, QDir::Time);
+	qint64 size = 0;
+	int deleted = 0;
+	for (const auto& info : files)
+	{
+		size += info.size();
+		if (size>JSON_CACHE_MAX_SIZE || info.lastModified().daysTo(now)>JSON_CACHE_MAX_AGE_DAYS)
+		{
+			if (QFile::remove(info.absoluteFilePath()))
+				++deleted;
+			size -= info.size();
+		}
+	}
+	if (deleted>0)
+		qDebug() << "Deleted" << deleted << "files from the JSON cache," << size/1024 << "kB left";
+	trimMutex.unlock();
+}
+
+MultiLevelJsonBase::JsonLoadResult MultiLevelJsonBase::loadJsonFile(const QString& fileName)
+{
+	QFile f(fileName);
+	if (!f.open(QIODevice::ReadOnly))
+	{
+		JsonLoadResult res;
+		res.error = QString("can't open %1").arg(QDir::toNativeSeparators(fileName));
+		return res;
+	}
+	return loadJsonData(f.readAll(), fileName.endsWith(".qZ"), fileName.endsWith(".gz"), QString());
+}
+
+MultiLevelJsonBase::JsonLoadResult MultiLevelJsonBase::loadCachedJson(const QString& cacheFile)
+{
+	JsonLoadResult res;
+	res.cacheMiss = true;
+	QFileInfo info(cacheFile);
+	if (!info.exists() || info.lastModified().daysTo(QDateTime::currentDateTime())>JSON_CACHE_MAX_AGE_DAYS)
+		return res;
+
+	QFile f(cacheFile);
+	if (!f.open(QIODevice::ReadOnly))
+		return res;
+	QDataStream in(&f);
+	in.setVersion(QDataStream::Qt_5_4);
+	quint32 magic, version;
+	in >> magic >> version;
+	if (in.status()!=QDataStream::Ok || magic!=JSON_CACHE_MAGIC || version!=JSON_CACHE_VERSION)
+		return res;
+	in >> res.map;
+	if (in.status()!=QDataStream::Ok)
+	{
+		// Download the file again
+		res.map.clear();
+		return res;
 	}
+	res.cacheMiss = false;
+	return res;
 }
 
 MultiLevelJsonBase::MultiLevelJsonBase(MultiLevelJsonBase* parent) : StelSkyLayer(parent)
@@ -94,7 +208,7 @@ MultiLevelJsonBase::MultiLevelJsonBase(MultiLevelJsonBase* parent) : StelSkyLaye
 	, downloading(false)
 	, httpReply(Q_NULLPTR)
 	, deletionDelay(2.)
-	, loadThread(Q_NULLPTR)
+	, loadWatcher(Q_NULLPTR)
 	, timeWhenDeletionScheduled(-1.) // Avoid tiles to be deleted just after constructed
 	, loadingState(false)
 	, lastPercent(0)
@@ -131,6 +245,13 @@ void MultiLevelJsonBase::initFromUrl(const QString& url)
 		}
 		QFileInfo finf(fileName);
 		baseUrl = finf.absolutePath()+'/';
+		if (parent!=Q_NULLPTR)
+		{
+			// Sub levels are loaded in the thread pool to avoid freezing when zooming into a large tree
+			downloading = true;
+			startLoader(QtConcurrent::run(getLoaderThreadPool(), &MultiLevelJsonBase::loadJsonFile, fileName));
+			return;
+		}
 		QFile f(fileName);
 		if(f.open(QIODevice::ReadOnly))
 		{
@@ -165,22 +286,37 @@ void MultiLevelJsonBase::initFromUrl(const QString& url)
 			Q_ASSERT(parent->getBaseUrl().startsWith("http", Qt::CaseInsensitive));
 			qurl.setUrl(parent->getBaseUrl()+url);
 		}
-		Q_ASSERT(httpReply==Q_NULLPTR);
-		QNetworkRequest req(qurl);
-		req.setRawHeader("User-Agent", StelUtils::getUserAgentString().toLatin1());
-		httpReply = getNetworkAccessManager().get(req);
-		//qDebug() << "Started downloading " << httpReply->request().url().path();
-		Q_ASSERT(httpReply->error()==QNetworkReply::NoError);
-		//qDebug() << httpReply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool();
-		connect(httpReply, SIGNAL(finished()), this, SLOT(downloadFinished()));
-		//connect(httpReply, SIGNAL(error(QNetworkReply::NetworkError)), this, SLOT(downloadError(QNetworkReply::NetworkError)));
-		//connect(httpReply, SIGNAL(destroyed()), this, SLOT(replyDestroyed()));
+		remoteUrl = qurl;
 		downloading = true;
 		QString turl = qurl.toString();
 		baseUrl = turl.left(turl.lastIndexOf('/')+1);
+		// Try the already parsed file first, the download is started if it is not in the cache
+		startLoader(QtConcurrent::run(getLoaderThreadPool(), &MultiLevelJsonBase::loadCachedJson, getCacheFileName(remoteUrl)));
 	}
 }
 
+void MultiLevelJsonBase::startDownload()
+{
+	Q_ASSERT(httpReply==Q_NULLPTR);
+	QNetworkRequest req(remoteUrl);
+	req.setRawHeader("User-Agent", StelUtils::getUserAgentString().toLatin1());
+	httpReply = getNetworkAccessManager().get(req);
+	//qDebug() << "Started downloading " << httpReply->request().url().path();
+	Q_ASSERT(httpReply->error()==QNetworkReply::NoError);
+	//qDebug() << httpReply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool();
+	connect(httpReply, SIGNAL(finished()), this, SLOT(downloadFinished()));
+	//connect(httpReply, SIGNAL(error(QNetworkReply::NetworkError)), this, SLOT(downloadError(QNetworkReply::NetworkError)));
+	//connect(httpReply, SIGNAL(destroyed()), this, SLOT(replyDestroyed()));
+}
+
+void MultiLevelJsonBase::startLoader(const QFuture<JsonLoadResult>& future)
+{
+	Q_ASSERT(loadWatcher==Q_NULLPTR);
+	loadWatcher = new QFutureWatcher<JsonLoadResult>(this);
+	connect(loadWatcher, SIGNAL(finished()), this, SLOT(jsonLoadFinished()));
+	loadWatcher->setFuture(future);
+}
+
 // Constructor from a map used for JSON files with more than 1 level
 void MultiLevelJsonBase::initFromQVariantMap(const QVariantMap& map)
 {
@@ -217,16 +353,11 @@ MultiLevelJsonBase::~MultiLevelJsonBase()
 		//httpReply->deleteLater();
 		httpReply = Q_NULLPTR;
 	}
-	if (loadThread && loadThread->isRunning())
+	if (loadWatcher)
 	{
-		//qDebug() << "--> Abort thread " << contructorUrl;
-		disconnect(loadThread, SIGNAL(finished()), this, SLOT(jsonLoadFinished()));
-		// The thread is currently running, it needs to be properly stopped
-		if (loadThread->wait(1)==false)
-		{
-			loadThread->terminate();
-			//loadThread->wait(2000);
-		}
+		// A running job only works on its own copy of the data, its result is simply dropped
+		disconnect(loadWatcher, SIGNAL(finished()), this, SLOT(jsonLoadFinished()));
+		loadWatcher = Q_NULLPTR;
 	}
 	for (auto* tile : subTiles)
 	{
@@ -318,24 +449,32 @@ void MultiLevelJsonBase::downloadFinished()
 	httpReply->deleteLater();
 	httpReply=Q_NULLPTR;
 
-	Q_ASSERT(loadThread==Q_NULLPTR);
-	loadThread = new JsonLoadThread(this, content, qZcompressed, gzCompressed);
-	connect(loadThread, SIGNAL(finished()), this, SLOT(jsonLoadFinished()));
-	loadThread->start(QThread::LowestPriority);
+	startLoader(QtConcurrent::run(getLoaderThreadPool(), &MultiLevelJsonBase::loadJsonData, content, qZcompressed, gzCompressed, getCacheFileName(remoteUrl)));
 }
 
 // Called when the element is fully loaded from the JSON file
 void MultiLevelJsonBase::jsonLoadFinished()
 {
-	loadThread->wait();
-	delete loadThread;
-	loadThread = Q_NULLPTR;
-	downloading = false;
-	if (errorOccured)
+	const JsonLoadResult res = loadWatcher->result();
+	loadWatcher->deleteLater();
+	loadWatcher = Q_NULLPTR;
+	if (!res.error.isEmpty())
+	{
+		qWarning() << "WARNING : Can't parse loaded JSON description for" << contructorUrl << ":" << res.error;
+		errorOccured = true;
+		downloading = false;
+		return;
+	}
+	if (res.cacheMiss)
+	{
+		Q_ASSERT(remoteUrl.isValid());
+		startDownload();
 		return;
+	}
+	downloading = false;
 	try
 	{
-		loadFromQVariantMap(temporaryResultMap);
+		loadFromQVariantMap(res.map);
 	}
 	catch (std::runtime_error& e)
 	{
@@ -21,22 +21,26 @@
 
 #include "StelSkyLayer.hpp"
 
+#include <QFutureWatcher>
 #include <QList>
 #include <QString>
+#include <QUrl>
 #include <QVariantMap>
 #include <QNetworkReply>
 
 class QIODevice;
+class QThreadPool;
 class StelCore;
 
 //! Abstract base class for managing multi-level tree objects stored in JSON format.
-//! The JSON files can be stored on disk or remotely and are loaded into threads.
+//! The JSON files can be stored on disk or remotely. The files of the sub levels are read and parsed
+//! by a small shared pool of threads, so that deep trees do not block the main thread nor start a thread per file.
+//! Parsed remote files are kept in a compact binary form in the cache directory, and read from there
+//! instead of being downloaded and parsed again when the tiles are needed later.
 class MultiLevelJsonBase : public StelSkyLayer
 {
 	Q_OBJECT
 
-	friend class JsonLoadThread;
-
 public:
 	//! Default constructor.
 	MultiLevelJsonBase(MultiLevelJsonBase* parent=Q_NULLPTR);
@@ -72,7 +76,7 @@ public:
 private slots:
 	//! Called when the download for the JSON file terminated.
 	void downloadFinished();
-	//! Called when the JSON file is loaded.
+	//! Called when the JSON file is loaded and parsed by the loader thread pool.
 	void jsonLoadFinished();
 
 protected:
@@ -113,23 +117,54 @@ protected:
 	static QVariantMap loadFromJSON(QIODevice& input, bool qZcompressed=false, bool gzCompressed=false);
 
 private:
+	//! The result of a JSON file loaded in the loader thread pool
+	struct JsonLoadResult
+	{
+		JsonLoadResult() : cacheMiss(false) {}
+		//! The parsed file
+		QVariantMap map;
+		//! Set if an error occured
+		QString error;
+		//! true if the file was not found in the cache, and must be downloaded
+		bool cacheMiss;
+	};
+
 	//! Return the base URL prefixed to relative URL
 	QString getBaseUrl() const {return baseUrl;}
 
+	//! Start downloading the remote JSON file
+	void startDownload();
+	//! Start a job in the loader thread pool, jsonLoadFinished() is called when it is finished
+	void startLoader(const QFuture<JsonLoadResult>& future);
+
+	//! Parse the content of a JSON file, and save the result in the cache if cacheFile is not empty.
+	//! Those static methods are run in the loader thread pool.
+	static JsonLoadResult loadJsonData(const QByteArray& content, bool qZcompressed, bool gzCompressed, const QString& cacheFile);
+	//! Read and parse a local JSON file
+	static JsonLoadResult loadJsonFile(const QString& fileName);
+	//! Read a file previously parsed from the cache. cacheMiss is set in the result if it is not in the cache.
+	static JsonLoadResult loadCachedJson(const QString& cacheFile);
+	//! Delete the oldest files of the cache directory when it exceeds its maximal size, and the expired files.
+	static void trimCache(const QString& cacheDir);
+
+	//! Return the cache file for the parsed JSON file at the given URL
+	static QString getCacheFileName(const QUrl& url);
+
 	// Used to download remote JSON files if needed
 	class QNetworkReply* httpReply;
 
+	// The URL of the remote JSON file
+	QUrl remoteUrl;
+
 	// The delay after which a scheduled deletion will occur
 	float deletionDelay;
 
-	class JsonLoadThread* loadThread;
+	// Watch the job of the loader thread pool, if any
+	QFutureWatcher<JsonLoadResult>* loadWatcher;
 
 	// Time at which deletion was first scheduled
 	double timeWhenDeletionScheduled;
 
-	// The temporary map filled in a thread
-	QVariantMap temporaryResultMap;
-
 	bool loadingState;
 	int lastPercent;
 
@@ -137,6 +172,11 @@ private:
 	static class QNetworkAccessManager* networkAccessManager;
 
 	static QNetworkAccessManager& getNetworkAccessManager();
+
+	//! The thread pool used to load and parse the JSON files
+	static QThreadPool* loaderThreadPool;
+
+	static QThreadPool* getLoaderThreadPool();
 };
 
 #endif // MULTILEVELJSONBASE_HPP
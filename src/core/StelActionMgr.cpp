@@ -109,6 +109,8 @@ void StelAction::setChecked(bool value)
 	boolProperty->setValue(value);
 	if(!boolProperty->canNotify())
 		emit toggled(value); //if connected to a property without NOTIFY, we have to toggle the event ourselves
+	else if (isChecked()!=value)
+		emit toggled(!value); //the property refused the value (e.g. tracking without selection): return the buttons to its state
 }
 
 void StelAction::toggle()
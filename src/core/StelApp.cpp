@@ -460,7 +460,7 @@ void StelApp::init(QSettings* conf)
 	// Stel Object Data Base manager
 	SplashScreen::showMessage(q_("Initializing Object Database..."));
 	stelObjectMgr = new StelObjectMgr();
-	stelObjectMgr->init();
+	getModuleMgr().initModule(stelObjectMgr);
 	getModuleMgr().registerModule(stelObjectMgr);	
 
 	SplashScreen::showMessage(q_("Initializing locales..."));
@@ -469,25 +469,29 @@ void StelApp::init(QSettings* conf)
 	// Hips surveys
 	SplashScreen::showMessage(q_("Initializing HiPS survey..."));
 	HipsMgr* hipsMgr = new HipsMgr();
-	hipsMgr->init();
+	getModuleMgr().initModule(hipsMgr);
 	getModuleMgr().registerModule(hipsMgr);
 
+	// Create first the modules which can load their data in the background while the others are initialized
+	NomenclatureMgr* nomenclature = new NomenclatureMgr();
+	StarMgr* hip_stars = new StarMgr();
+	NebulaMgr* nebulas = new NebulaMgr();
+	getModuleMgr().startLoadingData(QList<StelModule*>() << nomenclature << hip_stars << nebulas);
+
 	// Init the solar system first
 	SplashScreen::showMessage(q_("Initializing Solar System objects..."));
 	SolarSystem* ssystem = new SolarSystem();
-	ssystem->init();
+	getModuleMgr().initModule(ssystem);
 	getModuleMgr().registerModule(ssystem);
 
 	// Init the nomenclature for Solar system bodies
 	SplashScreen::showMessage(q_("Initializing planetary nomenclature..."));
-	NomenclatureMgr* nomenclature = new NomenclatureMgr();
-	nomenclature->init();
+	getModuleMgr().initModule(nomenclature);
 	getModuleMgr().registerModule(nomenclature);
 
 	// Load stars & their names
 	SplashScreen::showMessage(q_("Initializing stars..."));
-	StarMgr* hip_stars = new StarMgr();
-	hip_stars->init();
+	getModuleMgr().initModule(hip_stars);
 	getModuleMgr().registerModule(hip_stars);
 
 	SplashScreen::showMessage(q_("Initializing core..."));
@@ -495,32 +499,31 @@ void StelApp::init(QSettings* conf)
 
 	// Init nebulas
 	SplashScreen::showMessage(q_("Initializing deep-sky objects..."));
-	NebulaMgr* nebulas = new NebulaMgr();
-	nebulas->init();
+	getModuleMgr().initModule(nebulas);
 	getModuleMgr().registerModule(nebulas);
 
 	// Init milky way
 	SplashScreen::showMessage(q_("Initializing Milky Way..."));
 	MilkyWay* milky_way = new MilkyWay();
-	milky_way->init();
+	getModuleMgr().initModule(milky_way);
 	getModuleMgr().registerModule(milky_way);
 
 	// Init zodiacal light
 	SplashScreen::showMessage(q_("Initializing zodiacal light..."));
 	ZodiacalLight* zodiacal_light = new ZodiacalLight();
-	zodiacal_light->init();
+	getModuleMgr().initModule(zodiacal_light);
 	getModuleMgr().registerModule(zodiacal_light);
 
 	// Init sky image manager
 	SplashScreen::showMessage(q_("Initializing sky image layer..."));
 	skyImageMgr = new StelSkyLayerMgr();
-	skyImageMgr->init();
+	getModuleMgr().initModule(skyImageMgr);
 	getModuleMgr().registerModule(skyImageMgr);
 
 	// Toast surveys
 	SplashScreen::showMessage(q_("Initializing TOAST surveys..."));
 	ToastMgr* toasts = new ToastMgr();
-	toasts->init();
+	getModuleMgr().initModule(toasts);
 	getModuleMgr().registerModule(toasts);
 
 	// Init audio manager
@@ -530,42 +533,42 @@ void StelApp::init(QSettings* conf)
 	// Init video manager
 	SplashScreen::showMessage(q_("Initializing video..."));
 	videoMgr = new StelVideoMgr();
-	videoMgr->init();
+	getModuleMgr().initModule(videoMgr);
 	getModuleMgr().registerModule(videoMgr);
 
 	// Constellations
 	SplashScreen::showMessage(q_("Initializing constellations..."));
 	ConstellationMgr* constellations = new ConstellationMgr(hip_stars);
-	constellations->init();
+	getModuleMgr().initModule(constellations);
 	getModuleMgr().registerModule(constellations);
 
 	// Asterisms
 	SplashScreen::showMessage(q_("Initializing asterisms..."));
 	AsterismMgr* asterisms = new AsterismMgr(hip_stars);
-	asterisms->init();
+	getModuleMgr().initModule(asterisms);
 	getModuleMgr().registerModule(asterisms);
 
 	// Landscape, atmosphere & cardinal points section
 	SplashScreen::showMessage(q_("Initializing landscape..."));
 	LandscapeMgr* landscape = new LandscapeMgr();
-	landscape->init();
+	getModuleMgr().initModule(landscape);
 	getModuleMgr().registerModule(landscape);
 
 	SplashScreen::showMessage(q_("Initializing grid lines..."));
 	GridLinesMgr* gridLines = new GridLinesMgr();
-	gridLines->init();
+	getModuleMgr().initModule(gridLines);
 	getModuleMgr().registerModule(gridLines);
 
 	// Sporadic Meteors
 	SplashScreen::showMessage(q_("Initializing sporadic meteors..."));
 	SporadicMeteorMgr* meteors = new SporadicMeteorMgr(10, 72);
-	meteors->init();
+	getModuleMgr().initModule(meteors);
 	getModuleMgr().registerModule(meteors);
 
 	// User labels
 	SplashScreen::showMessage(q_("Initializing user labels..."));
 	LabelMgr* skyLabels = new LabelMgr();
-	skyLabels->init();
+	getModuleMgr().initModule(skyLabels);
 	getModuleMgr().registerModule(skyLabels);
 
 	SplashScreen::showMessage(q_("Initializing sky cultures..."));
@@ -574,19 +577,19 @@ void StelApp::init(QSettings* conf)
 	// User markers
 	SplashScreen::showMessage(q_("Initializing user markers..."));
 	MarkerMgr* skyMarkers = new MarkerMgr();
-	skyMarkers->init();
+	getModuleMgr().initModule(skyMarkers);
 	getModuleMgr().registerModule(skyMarkers);
 
 	// Init custom objects
 	SplashScreen::showMessage(q_("Initializing custom objects..."));
 	CustomObjectMgr* custObj = new CustomObjectMgr();
-	custObj->init();
+	getModuleMgr().initModule(custObj);
 	getModuleMgr().registerModule(custObj);
 
 	// Init hightlights
 	SplashScreen::showMessage(q_("Initializing highlights..."));
 	HighlightMgr* hlMgr = new HighlightMgr();
-	hlMgr->init();
+	getModuleMgr().initModule(hlMgr);
 	getModuleMgr().registerModule(hlMgr);
 
 	//Create the script manager here, maybe some modules/plugins may want to connect to it
@@ -666,6 +669,7 @@ void StelApp::initPlugIns()
 {
 	// Load dynamically all the modules found in the modules/ directories
 	// which are configured to be loaded at startup
+	QList<QPair<StelModule*, QString> > plugins;
 	for (const auto& i : moduleMgr->getPluginsList())
 	{
 		if (i.loadAtStartup==false)
@@ -677,10 +681,22 @@ void StelApp::initPlugIns()
 			moduleMgr->registerModule(m, true);
 			//load extensions after the module is registered
 			moduleMgr->loadExtensions(i.info.id);
-			m->init();
+			plugins << qMakePair(m, q_(i.info.displayedName));
 		}
 	}
+
+	// Load the data of all the plugins in the background, and initialize them in order
+	QList<StelModule*> modules;
+	for (const auto& p : plugins)
+		modules << p.first;
+	moduleMgr->startLoadingData(modules);
+	for (const auto& p : plugins)
+	{
+		SplashScreen::showMessage(QString("%1 \"%2\"...").arg(q_("Initializing plugin"), p.second));
+		moduleMgr->initModule(p.first);
+	}
 	SplashScreen::clearMessage();
+	moduleMgr->logStartupTimes();
 }
 
 void StelApp::deinit()
@@ -786,6 +802,29 @@ void StelApp::draw()
 		module->draw(core);
 	}
 	core->postDraw();
+
+	// Draw the additional cameras. The simulation state has been updated once for all views,
+	// so only the drawing passes are repeated with the projection of each camera.
+	const quint32 mainFbo = currentFbo;
+	const int cameraCount = core->getFlagDrawCameras() ? core->getCameras().size() : 0;
+	for (int i=0; i<cameraCount; ++i)
+	{
+		const quint32 cameraFbo = core->getCameras().at(i).fbo;
+		currentFbo = cameraFbo ? cameraFbo : mainFbo;
+		GL(gl->glBindFramebuffer(GL_FRAMEBUFFER, currentFbo));
+		core->beginCamera(i);
+		for (auto* module : modules)
+		{
+			module->draw(core);
+		}
+		core->postDraw();
+		core->endCamera();
+	}
+	if (currentFbo != mainFbo)
+	{
+		currentFbo = mainFbo;
+		GL(gl->glBindFramebuffer(GL_FRAMEBUFFER, currentFbo));
+	}
 #ifdef ENABLE_SPOUT
 	// At this point, the sky scene has been drawn, but no GUI panels.
 	if(spoutSender)
@@ -40,6 +40,7 @@
 #include "StelMainView.hpp"
 #include "EphemWrapper.hpp"
 #include "NomenclatureItem.hpp"
+#include "IAUConstellationSpans.hpp"
 #include "precession.h"
 
 #include <QSettings>
@@ -76,6 +77,9 @@ StelCore::StelCore()
 	, geodesicGrid(Q_NULLPTR)
 	, currentProjectionType(ProjectionStereographic)
 	, currentDeltaTAlgorithm(EspenakMeeus)
+	, currentCamera(-1)
+	, flagDrawCameras(true)
+	, mainProjectionType(ProjectionStereographic)
 	, position(Q_NULLPTR)
 	, flagUseNutation(true)
 	, flagUseTopocentricCoordinates(true)	
@@ -495,6 +499,83 @@ void StelCore::postDraw()
 	sPainter.drawViewportShape();
 }
 
+void StelCore::beginCamera(int index)
+{
+	Q_ASSERT(currentCamera<0);
+	Q_ASSERT(index>=0 && index<cameras.size());
+	const Camera& camera = cameras.at(index);
+
+	mainProjectorParams = currentProjectorParams;
+	mainProjectionType = currentProjectionType;
+	mainMatAltAzModelView = matAltAzModelView;
+
+	currentCamera = index;
+	currentProjectorParams = camera.params;
+	currentProjectorParams.zNear = 0.000001;
+	currentProjectorParams.zFar = 500.;
+	currentProjectionType = camera.projectionType;
+	lookAtJ2000(camera.viewDirectionJ2000, camera.upJ2000);
+	// The limit magnitude and the eye input scale depend on the field of view
+	skyDrawer->beginCamera(camera.params.fov);
+
+	// Only clear the part of the framebuffer used by the camera
+	Vec3f backColor = StelMainView::getInstance().getSkyBackgroundColor();
+	QOpenGLFunctions* gl = QOpenGLContext::currentContext()->functions();
+	gl->glEnable(GL_SCISSOR_TEST);
+	gl->glScissor(camera.params.viewportXywh[0], camera.params.viewportXywh[1], camera.params.viewportXywh[2], camera.params.viewportXywh[3]);
+	gl->glClearColor(backColor[0], backColor[1], backColor[2], 0.f);
+	gl->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	gl->glDisable(GL_SCISSOR_TEST);
+}
+
+void StelCore::endCamera()
+{
+	Q_ASSERT(currentCamera>=0);
+	currentProjectorParams = mainProjectorParams;
+	currentProjectionType = mainProjectionType;
+	matAltAzModelView = mainMatAltAzModelView;
+	invertMatAltAzModelView = matAltAzModelView.inverse();
+	skyDrawer->endCamera();
+	currentCamera = -1;
+}
+
+StelCore::Camera StelCore::makeCamera(const StelProjector::StelProjectorParams& mainParams, const Vec3d& viewDirectionJ2000, float fov,
+				      const Vector4<int>& viewportXywh, ProjectionType projectionType)
+{
+	Camera camera;
+	camera.params = mainParams;
+	camera.params.viewportXywh = viewportXywh;
+	camera.params.viewportCenterOffset.set(0., 0.);
+	camera.params.viewportCenter.set(viewportXywh[0]+0.5*viewportXywh[2], viewportXywh[1]+0.5*viewportXywh[3]);
+	camera.params.viewportFovDiameter = qMin(viewportXywh[2], viewportXywh[3]);
+	camera.params.fov = fov;
+	camera.params.maskType = StelProjector::MaskNone;
+	camera.projectionType = projectionType;
+	camera.viewDirectionJ2000 = viewDirectionJ2000;
+	camera.viewDirectionJ2000.normalize();
+	// Point the up vector to the celestial north pole, or any direction orthogonal to the view at the poles
+	const Vec3d& f = camera.viewDirectionJ2000;
+	camera.upJ2000 = Vec3d(0., 0., 1.) - f*f[2];
+	if (camera.upJ2000.lengthSquared()<1e-12)
+		camera.upJ2000.set(-1., 0., 0.);
+	camera.upJ2000.normalize();
+	return camera;
+}
+
+int StelCore::addCamera(const Vec3d& viewDirectionJ2000, double fov, int x, int y, int width, int height, const QString& projectionTypeKey)
+{
+	const QMetaEnum& en = metaObject()->enumerator(metaObject()->indexOfEnumerator("ProjectionType"));
+	int type = en.keyToValue(projectionTypeKey.toLatin1().data());
+	if (type<0)
+	{
+		qWarning() << "Unknown projection type: " << projectionTypeKey << "using \"ProjectionStereographic\" for the camera";
+		type = ProjectionStereographic;
+	}
+	cameras.append(makeCamera(currentProjectorParams, viewDirectionJ2000, static_cast<float>(fov),
+				  Vector4<int>(x, y, width, height), static_cast<ProjectionType>(type)));
+	return cameras.size()-1;
+}
+
 void StelCore::updateMaximumFov()
 {
 	const float savedFov = currentProjectorParams.fov;
@@ -2548,97 +2629,47 @@ void StelCore::initEphemeridesFunctions()
 	setDe431Active(de431Available && conf->value("astro/flag_use_de431", false).toBool());
 }
 
-// Methods for finding constellation from J2000 position.
-typedef struct iau_constline{
-	double RAlow;  // low value of 1875.0 right ascension segment, HH.dddd
-	double RAhigh; // high value of 1875.0 right ascension segment, HH.dddd
-	double decLow; // declination 1875.0 of southern border, DD.dddd
-	QString constellation; // 3-letter code of constellation
-} iau_constelspan;
-
-static QVector<iau_constelspan> iau_constlineVec;
-static bool iau_constlineVecInitialized=false;
+// The span data is loaded on first use, and can then be queried from any thread.
+static const IAUConstellationSpans& getIAUConstellationSpans()
+{
+	static const IAUConstellationSpans spans(StelFileMgr::findFile("data/constellations_spans.dat"));
+	return spans;
+}
 
-// File iau_constellations_spans.dat is converted from file data.dat from ADC catalog VI/42.
-// We converted back to HH:MM:SS format to avoid the inherent rounding errors present in that file (Bug LP:#1690615).
 QString StelCore::getIAUConstellation(const Vec3d positionEqJnow) const
 {
+	const IAUConstellationSpans& spans = getIAUConstellationSpans();
+	if (!spans.isValid())
+		return "err";
+
 	// Precess positionJ2000 to 1875.0
-	const Vec3d pos1875=j2000ToJ1875(equinoxEquToJ2000(positionEqJnow, RefractionOff));
-	double RA1875;
-	double dec1875;
-	StelUtils::rectToSphe(&RA1875, &dec1875, pos1875);
-	RA1875 *= 12./M_PI; // hours
-	if (RA1875 <0.) RA1875+=24.;
-	dec1875 *= M_180_PI; // degrees
-	Q_ASSERT(RA1875>=0.0);
-	Q_ASSERT(RA1875<=24.0);
-	Q_ASSERT(dec1875<=90.0);
-	Q_ASSERT(dec1875>=-90.0);
-
-	// read file into structure.
-	if (!iau_constlineVecInitialized)
-	{
-		//struct iau_constline line;
-		QFile file(StelFileMgr::findFile("data/constellations_spans.dat"));
+	return spans.find(j2000ToJ1875(equinoxEquToJ2000(positionEqJnow, RefractionOff)));
+}
 
-		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-		{
-			qWarning() << "IAU constellation line data file data/constellations_spans.dat not found.";
-			return "err";
-		}
-		iau_constelspan span;
-		QRegExp emptyLine("^\\s*$");
-		QTextStream in(&file);
-		while (!in.atEnd())
-		{
-			// Build list of entries. The checks can certainly become more robust. Actually the file must have 4-part lines.
-			QString line = in.readLine();
-			if (line.length()==0) continue;
-			if (emptyLine.exactMatch((line))) continue;
-			if (line.at(0)=='#') continue; // skip comment lines.
-			//QStringList list = line.split(QRegExp("\\b\\s+\\b"));
-			QStringList list = line.trimmed().split(QRegExp("\\s+"));
-			if (list.count() != 4)
-			{
-				qWarning() << "IAU constellation file constellations_spans.dat has bad line:" << line << "with" << list.count() << "elements";
-				continue;
-			}
-			//qDebug() << "Creating span for decl=" << list.at(2) << " from RA=" << list.at(0) << "to" << list.at(1) << ": " << list.at(3);
-			QStringList numList=list.at(0).split(QRegExp(":"));
-			span.RAlow= atof(numList.at(0).toLatin1()) + atof(numList.at(1).toLatin1())/60. + atof(numList.at(2).toLatin1())/3600.;
-			numList=list.at(1).split(QRegExp(":"));
-			span.RAhigh=atof(numList.at(0).toLatin1()) + atof(numList.at(1).toLatin1())/60. + atof(numList.at(2).toLatin1())/3600.;
-			numList=list.at(2).split(QRegExp(":"));
-			span.decLow=atof(numList.at(0).toLatin1());
-			if (span.decLow<0.0)
-				span.decLow -= atof(numList.at(1).toLatin1())/60.;
-			else
-				span.decLow += atof(numList.at(1).toLatin1())/60.;
-			span.constellation=list.at(3);
-			iau_constlineVec.append(span);
-		}
-		file.close();
-		iau_constlineVecInitialized=true;
-	}
+QStringList StelCore::getIAUConstellations(const QVector<Vec3d>& positionsEqJnow) const
+{
+	const IAUConstellationSpans& spans = getIAUConstellationSpans();
+	if (!spans.isValid())
+		return QVector<QString>(positionsEqJnow.size(), "err").toList();
 
-	// iterate through vector, find entry where declination is lower.
-	int entry=0;
-	while (iau_constlineVec.at(entry).decLow > dec1875)
-		entry++;
-	while (entry<iau_constlineVec.size())
-	{
-		while (iau_constlineVec.at(entry).RAhigh <= RA1875)
-			entry++;
-		while (iau_constlineVec.at(entry).RAlow >= RA1875)
-			entry++;
-		if (iau_constlineVec.at(entry).RAhigh > RA1875)
-			return iau_constlineVec.at(entry).constellation;
-		else
-			entry++;
-	}
-	qDebug() << "getIAUconstellation error: Cannot determine, algorithm failed.";
-	return "(?)";
+	QStringList result;
+	result.reserve(positionsEqJnow.size());
+	for (const auto& pos : positionsEqJnow)
+		result << spans.find(matJ2000ToJ1875 * (matEquinoxEquToJ2000 * pos));
+	return result;
+}
+
+QStringList StelCore::getIAUConstellationsJ2000(const QVector<Vec3d>& positionsJ2000) const
+{
+	const IAUConstellationSpans& spans = getIAUConstellationSpans();
+	if (!spans.isValid())
+		return QVector<QString>(positionsJ2000.size(), "err").toList();
+
+	QStringList result;
+	result.reserve(positionsJ2000.size());
+	for (const auto& pos : positionsJ2000)
+		result << spans.find(matJ2000ToJ1875 * pos);
+	return result;
 }
 
 Vec3d StelCore::getMouseJ2000Pos() const
@@ -149,6 +149,25 @@ public:
 		Custom					//!< User defined coefficients for quadratic equation for DeltaT
 	};
 
+	//! @struct Camera
+	//! An additional view of the sky drawn in the same frame as the main view, e.g. a picture-in-picture,
+	//! a finder view or another channel of a multi-projector setup.
+	//! The simulation state (time, positions, module updates) is computed once per frame and shared by all views,
+	//! only the drawing passes of the modules are run again for each camera.
+	struct Camera
+	{
+		Camera() : projectionType(ProjectionStereographic), viewDirectionJ2000(1.,0.,0.), upJ2000(0.,0.,1.), fbo(0) {}
+		//! The parameters of the projector: viewport, field of view, flips...
+		StelProjector::StelProjectorParams params;
+		ProjectionType projectionType;
+		//! The viewing direction in the J2000 equatorial frame
+		Vec3d viewDirectionJ2000;
+		//! The up vector in the J2000 equatorial frame
+		Vec3d upJ2000;
+		//! The framebuffer object to draw into, or 0 to draw into the framebuffer of the main view
+		quint32 fbo;
+	};
+
 	StelCore();
 	virtual ~StelCore();
 
@@ -168,6 +187,30 @@ public:
 	//! Update core state after drawing modules.
 	void postDraw();
 
+	//! Set the additional cameras drawn after the main view in each frame.
+	void setCameras(const QList<Camera>& list) {cameras = list;}
+	//! Get the additional cameras drawn after the main view in each frame.
+	const QList<Camera>& getCameras() const {return cameras;}
+	//! Make a camera showing the sky around a direction, with north up, in a part of the framebuffer of the main view.
+	//! @param mainParams the projector parameters of the main view, giving the flips and the device pixel ratio
+	//! @param viewDirectionJ2000 the viewing direction in the J2000 equatorial frame
+	//! @param fov the field of view in degrees
+	//! @param viewportXywh the viewport of the camera in pixels, from the bottom left corner of the framebuffer
+	//! @param projectionType the projection used by the camera
+	static Camera makeCamera(const StelProjector::StelProjectorParams& mainParams, const Vec3d& viewDirectionJ2000, float fov,
+				 const Vector4<int>& viewportXywh, ProjectionType projectionType);
+	//! Set whether the additional cameras are drawn. They are not drawn e.g. in each tile of a large screenshot.
+	void setFlagDrawCameras(bool b) {flagDrawCameras = b;}
+	//! Get whether the additional cameras are drawn.
+	bool getFlagDrawCameras() const {return flagDrawCameras;}
+	//! Get the index of the camera being drawn, or -1 when the main view is drawn.
+	int getCurrentCamera() const {return currentCamera;}
+	//! Make the projections returned by getProjection() use the given camera, and clear its viewport.
+	//! The state of the main view is restored by endCamera().
+	void beginCamera(int index);
+	//! Restore the projection state of the main view after beginCamera().
+	void endCamera();
+
 	//! Get a new instance of a simple 2d projection. This projection cannot be used to project or unproject but
 	//! only for 2d painting
 	StelProjectorP getProjection2d() const;
@@ -357,6 +400,19 @@ public:
 	Vec3d getMouseJ2000Pos(void) const;
 
 public slots:
+	//! Add a camera drawn after the main view in each frame, e.g. a finder view or a picture-in-picture.
+	//! @param viewDirectionJ2000 the viewing direction in the J2000 equatorial frame
+	//! @param fov the field of view in degrees
+	//! @param x, y the position of the bottom left corner of the camera in the framebuffer of the main view in pixels
+	//! @param width, height the size of the camera in pixels
+	//! @param projectionTypeKey the name of the projection, e.g. "ProjectionStereographic"
+	//! @return the index of the new camera
+	int addCamera(const Vec3d& viewDirectionJ2000, double fov, int x, int y, int width, int height, const QString& projectionTypeKey);
+	//! Remove all the cameras added with addCamera() or setCameras().
+	void clearCameras() {cameras.clear();}
+	//! Get the number of cameras drawn after the main view.
+	int getCameraCount() const {return cameras.size();}
+
 	//! Smoothly move the observer to the given location
 	//! @param target the target location
 	//! @param duration direction of view move duration in s
@@ -729,6 +785,12 @@ public slots:
 	//! Data file from ADC catalog VI/42 with its amendment from 1999-12-30.
 	//! @param positionEqJnow position vector in rectangular equatorial coordinates of current epoch&equinox.
 	QString getIAUConstellation(const Vec3d positionEqJnow) const;
+	//! Return the 3-letter abbreviations of the IAU constellations for an array of positions.
+	//! This is faster than calling getIAUConstellation() for each position, e.g. to tag all objects of a catalog.
+	//! @param positionsEqJnow position vectors in rectangular equatorial coordinates of current epoch&equinox.
+	QStringList getIAUConstellations(const QVector<Vec3d>& positionsEqJnow) const;
+	//! Same as getIAUConstellations(), for positions in rectangular equatorial coordinates for J2000.
+	QStringList getIAUConstellationsJ2000(const QVector<Vec3d>& positionsJ2000) const;
 
 
 signals:
@@ -791,6 +853,17 @@ private:
 	// Parameters to use when creating new instances of StelProjector
 	StelProjector::StelProjectorParams currentProjectorParams;
 
+	// The additional views drawn in each frame
+	QList<Camera> cameras;
+	// The camera being drawn, -1 for the main view
+	int currentCamera;
+	// Whether the cameras are drawn
+	bool flagDrawCameras;
+	// The projection state of the main view saved by beginCamera()
+	StelProjector::StelProjectorParams mainProjectorParams;
+	ProjectionType mainProjectionType;
+	Mat4d mainMatAltAzModelView;
+
 	void updateTransformMatrices();
 	void updateTime(double deltaTime);
 	void updateMaximumFov();
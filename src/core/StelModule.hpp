@@ -21,6 +21,7 @@
 #define STELMODULE_HPP
 
 #include <QString>
+#include <QStringList>
 #include <QObject>
 
 // Predeclaration
@@ -64,6 +65,17 @@ public:
 	//! If the initialization takes significant time, the progress should be displayed on the loading bar.
 	virtual void init() = 0;
 
+	//! Load the data of the module which does not need the main thread, e.g. read and parse catalog files.
+	//! When the module is initialized by StelModuleMgr::initModule(), this is called in a worker thread before init(),
+	//! concurrently with the initialization of the other modules. It must therefore not use OpenGL, create QObjects,
+	//! connect signals or access other modules, and only prepare data for init(). The default implementation does nothing.
+	//! If it throws an exception, the error is logged and init() is still called, which usually loads the data again:
+	//! the module must then start from a clean state, e.g. by dropping the data loaded before the error.
+	virtual void loadModuleData() {;}
+
+	//! Return the names of the modules whose loadModuleData() must be finished before the one of this module is started.
+	virtual QStringList getDataDependencies() const {return QStringList();}
+
 	//! Called before the module will be delete, and before the openGL context is suppressed.
 	//! Deinitialize all openGL texture in this method.
 	virtual void deinit() {;}
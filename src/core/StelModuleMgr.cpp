@@ -21,6 +21,11 @@
 #include <QPluginLoader>
 #include <QSettings>
 #include <QDir>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <stdexcept>
 
 #include "StelModuleMgr.hpp"
 #include "StelApp.hpp"
@@ -32,8 +37,9 @@
 
 
 
-StelModuleMgr::StelModuleMgr() : callingListsToRegenerate(true), pluginDescriptorListLoaded(false)
+StelModuleMgr::StelModuleMgr() : callingListsToRegenerate(true), pluginDescriptorListLoaded(false), dataLoaderPool(Q_NULLPTR)
 {
+	startupTimer.start();
 	qRegisterMetaType<StelModule::StelModuleSelectAction>("StelModule::StelModuleSelectAction");
 	// Initialize empty call lists for each possible actions
 	callOrders[StelModule::ActionDraw]=QList<StelModule*>();
@@ -45,6 +51,9 @@ StelModuleMgr::StelModuleMgr() : callingListsToRegenerate(true), pluginDescripto
 
 StelModuleMgr::~StelModuleMgr()
 {
+	// Modules may be deleted while their data is still loading if the startup was interrupted
+	if (dataLoaderPool)
+		dataLoaderPool->waitForDone();
 }
 
 // Regenerate calling lists if necessary
@@ -76,6 +85,110 @@ void StelModuleMgr::registerModule(StelModule* m, bool fgenerateCallingLists)
 		generateCallingLists();
 }
 
+/*************************************************************************
+ Start loading the data of the modules in worker threads
+*************************************************************************/
+qint64 StelModuleMgr::loadModuleData(StelModule* m, QList<QFuture<qint64> > dependencies)
+{
+	for (auto& f : dependencies)
+		f.waitForFinished();
+
+	QElapsedTimer timer;
+	timer.start();
+	try
+	{
+		m->loadModuleData();
+	}
+	catch (std::exception& e)
+	{
+		qWarning() << "Error while loading the data of module" << m->objectName() << ":" << e.what();
+		return -1;
+	}
+	return timer.elapsed();
+}
+
+void StelModuleMgr::startLoadingData(const QList<StelModule*>& mods)
+{
+	if (dataLoaderPool==Q_NULLPTR)
+	{
+		dataLoaderPool = new QThreadPool(this);
+		dataLoaderPool->setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+	}
+
+	// The modules are started in dependency order. The pool runs the jobs in the order they are started,
+	// so the dependencies of a job are always running or finished when it waits for them and there can be no deadlock.
+	QList<StelModule*> toStart = mods;
+	while (!toStart.isEmpty())
+	{
+		StelModule* next = Q_NULLPTR;
+		for (auto* m : toStart)
+		{
+			bool ready = true;
+			for (const auto& dep : m->getDataDependencies())
+			{
+				if (!dataLoaders.contains(dep) && std::any_of(toStart.begin(), toStart.end(), [&dep](StelModule* o) {return o->objectName()==dep;}))
+				{
+					ready = false;
+					break;
+				}
+			}
+			if (ready)
+			{
+				next = m;
+				break;
+			}
+		}
+		if (next==Q_NULLPTR)
+		{
+			qWarning() << "Circular data dependencies between modules, ignoring the dependencies of" << toStart.first()->objectName();
+			next = toStart.first();
+		}
+		toStart.removeOne(next);
+
+		QList<QFuture<qint64> > dependencies;
+		for (const auto& dep : next->getDataDependencies())
+		{
+			if (dataLoaders.contains(dep))
+				dependencies << dataLoaders.value(dep);
+		}
+		dataLoaders.insert(next->objectName(), QtConcurrent::run(dataLoaderPool, &StelModuleMgr::loadModuleData, next, dependencies));
+	}
+}
+
+/*************************************************************************
+ Initialize a module in the main thread once its data is loaded
+*************************************************************************/
+void StelModuleMgr::initModule(StelModule* m)
+{
+	StartupTime& t = startupTimes[m->objectName()];
+	QElapsedTimer timer;
+	timer.start();
+	if (dataLoaders.contains(m->objectName()))
+	{
+		QFuture<qint64> loader = dataLoaders.take(m->objectName());
+		loader.waitForFinished();
+		t.data = loader.result();
+		t.wait = timer.restart();
+		// The module clears what was loaded before the error, and init() loads its data again
+		if (t.data<0)
+			qWarning() << "Loading the data of module" << m->objectName() << "again in the main thread";
+	}
+	m->init();
+	t.init = timer.elapsed();
+}
+
+void StelModuleMgr::logStartupTimes() const
+{
+	qint64 initTotal = 0;
+	qDebug() << "Startup times in ms (data loading in background, waiting for the data, initialization):";
+	for (auto i = startupTimes.constBegin(); i != startupTimes.constEnd(); ++i)
+	{
+		qDebug().noquote() << QString("  %1: %2, %3, %4").arg(i.key(), -24).arg(i.value().data).arg(i.value().wait).arg(i.value().init);
+		initTotal += i.value().wait + i.value().init;
+	}
+	qDebug() << "Modules initialized in" << initTotal << "ms, total startup time" << startupTimer.elapsed() << "ms";
+}
+
 /*************************************************************************
  Unregister and delete a StelModule.
 *************************************************************************/
@@ -21,6 +21,8 @@
 #define STELMODULEMGR_HPP
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QMap>
 #include <QList>
 #include "StelModule.hpp"
@@ -48,6 +50,18 @@ public:
 	//! The module is later referenced by its QObject name.
 	void registerModule(StelModule* m, bool generateCallingLists=false);
 
+	//! Start loading the data of the modules in worker threads, see StelModule::loadModuleData().
+	//! The data of a module is only loaded after the one of the modules listed in its StelModule::getDataDependencies(),
+	//! if they are given in the same call or in a previous one. The modules still need to be initialized with initModule().
+	void startLoadingData(const QList<StelModule*>& mods);
+
+	//! Initialize a module in the main thread: wait until its data is loaded if startLoadingData() was called for it,
+	//! then call its init(). The time spent is recorded, see logStartupTimes().
+	void initModule(StelModule* m);
+
+	//! Log the time spent loading the data and initializing each module, and the total startup time.
+	void logStartupTimes() const;
+
 	//! Unregister and delete a StelModule. The program will hang if other modules depend on the removed one
 	//! @param moduleID the unique ID of the module, by convention equal to the class name
 	//! @param alsoDelete if true also delete the StelModule instance, otherwise it has to be deleted by external code.
@@ -129,6 +143,28 @@ private:
 
 	QMap<QString, StelModuleMgr::PluginDescriptor> pluginDescriptorList;
 	bool pluginDescriptorListLoaded;
+
+	//! Time spent by a module at startup, in ms
+	struct StartupTime
+	{
+		StartupTime() : data(0), wait(0), init(0) {}
+		//! Time spent in loadModuleData() in a worker thread, -1 if it failed
+		qint64 data;
+		//! Time the main thread waited for the data
+		qint64 wait;
+		//! Time spent in init()
+		qint64 init;
+	};
+
+	//! Run in a worker thread by startLoadingData(), return the time spent in ms, or -1 if the loading failed
+	static qint64 loadModuleData(StelModule* m, QList<QFuture<qint64> > dependencies);
+
+	//! The data loaders started by startLoadingData(), by module name
+	QMap<QString, QFuture<qint64> > dataLoaders;
+	class QThreadPool* dataLoaderPool;
+	QMap<QString, StartupTime> startupTimes;
+	//! Started when the StelModuleMgr is created, i.e. at the beginning of the startup
+	QElapsedTimer startupTimer;
 };
 
 #endif // STELMODULEMGR_HPP
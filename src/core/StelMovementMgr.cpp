@@ -1261,23 +1261,16 @@ void StelMovementMgr::autoZoomOut(float moveDuration, bool full)
 // This is called when you press SPACEBAR: slowly centering&tracking object
 void StelMovementMgr::setFlagTracking(bool b)
 {
+	const bool oldFlagTracking = flagTracking;
 	if (!b || !objectMgr->getWasSelected())
-	{
-		if(b!=flagTracking)
-		{
-			flagTracking=false;
-			emit flagTrackingChanged(b);
-		}
-	}
+		flagTracking=false;
 	else
 	{
 		moveToObject(objectMgr->getSelectedObject()[0], getAutoMoveDuration());
-		if(b!=flagTracking)
-		{
-			flagTracking=true;
-			emit flagTrackingChanged(b);
-		}
+		flagTracking=true;
 	}
+	if (flagTracking!=oldFlagTracking)
+		emit flagTrackingChanged(flagTracking);
 }
 
 
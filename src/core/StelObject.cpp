@@ -134,7 +134,12 @@ bool StelObject::isAboveRealHorizon(const StelCore *core) const
 	LandscapeMgr* lmgr = GETSTELMODULE(LandscapeMgr);
 	if (lmgr->getFlagLandscape())
 	{
-		if (lmgr->getLandscapeOpacity(getAltAzPosAuto(core))>0.85f) // landscape displayed
+		if (lmgr->getLandscapeOpacity(getAltAzPosAuto(core))>0.85f) // landscape (and 3D foreground, if any) displayed
+			r = false;
+	}
+	else if (lmgr->hasOcclusionHorizon())
+	{
+		if (lmgr->getOcclusionHorizonOpacity(getAltAzPosAuto(core))>0.85f) // only 3D foreground displayed
 			r = false;
 	}
 	else
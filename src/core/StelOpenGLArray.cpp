@@ -124,6 +124,13 @@ void StelOpenGLArray::clear()
 }
 
 bool StelOpenGLArray::load(const StelOBJ* obj, bool useTangents)
+{
+	const StelOBJ::VertexList& vertices = obj->getVertexList();
+	const StelOBJ::IndexList& indices = obj->getIndexList();
+	return load(vertices.constData(), vertices.size(), indices.constData(), indices.size(), useTangents);
+}
+
+bool StelOpenGLArray::load(const StelOBJ::Vertex* vertices, int vertexCount, const unsigned int* indices, int indexCount, bool useTangents)
 {
 	clear();
 
@@ -154,12 +161,11 @@ bool StelOpenGLArray::load(const StelOBJ* obj, bool useTangents)
 		//! The data is used for static drawing
 		m_vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
 		//perform data upload
-		const StelOBJ::VertexList& vertices = obj->getVertexList();
 		if(useTangents)
 		{
 			//we can simply upload the whole vertex data in a single call
-			m_vertexBuffer.allocate(vertices.constData(), static_cast<int>(sizeof(StelOBJ::Vertex)) * vertices.size());
-			m_memoryUsage+=sizeof(StelOBJ::Vertex) * static_cast<size_t>(vertices.size());
+			m_vertexBuffer.allocate(vertices, static_cast<int>(sizeof(StelOBJ::Vertex)) * vertexCount);
+			m_memoryUsage+=sizeof(StelOBJ::Vertex) * static_cast<size_t>(vertexCount);
 
 			//setup vtx format
 			for (int i = 0;i<=ATTLOC_BITANGENT;++i)
@@ -185,12 +191,12 @@ bool StelOpenGLArray::load(const StelOBJ* obj, bool useTangents)
 			//we use the first 8 floats of each vertex
 			const int vtxSize = sizeof(GLfloat) * 8;
 			//alloc data but dont upload
-			m_vertexBuffer.allocate(vertices.size() * vtxSize);
-			m_memoryUsage+=static_cast<size_t>(vertices.size() * vtxSize);
-			for(int i =0;i<vertices.size();++i)
+			m_vertexBuffer.allocate(vertexCount * vtxSize);
+			m_memoryUsage+=static_cast<size_t>(vertexCount * vtxSize);
+			for(int i =0;i<vertexCount;++i)
 			{
 				//copy the first 8 floats from each vertex
-				m_vertexBuffer.write(i * vtxSize, &vertices.at(i), vtxSize);
+				m_vertexBuffer.write(i * vtxSize, &vertices[i], vtxSize);
 			}
 			for (int i = 0;i<=ATTLOC_NORMAL;++i)
 			{
@@ -219,11 +225,14 @@ bool StelOpenGLArray::load(const StelOBJ* obj, bool useTangents)
 	{
 		m_indexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
 		//determine the index type to use
-		if(obj->canUseShortIndices())
+		if(vertexCount < std::numeric_limits<unsigned short>::max())
 		{
 			m_indexBufferType = GL_UNSIGNED_SHORT;
 			m_indexBufferTypeSize = sizeof(GLushort);
-			const StelOBJ::ShortIndexList idxList = obj->getShortIndexList();
+			StelOBJ::ShortIndexList idxList;
+			idxList.reserve(indexCount);
+			for(int i = 0;i<indexCount;++i)
+				idxList.append(static_cast<unsigned short>(indices[i]));
 			m_indexBuffer.allocate(idxList.constData(),static_cast<int>(m_indexBufferTypeSize) * idxList.size());
 		}
 		else
@@ -239,10 +248,9 @@ bool StelOpenGLArray::load(const StelOBJ* obj, bool useTangents)
 			m_indexBufferType = GL_UNSIGNED_INT;
 			m_indexBufferTypeSize = sizeof(GLuint);
 
-			const StelOBJ::IndexList& idxList = obj->getIndexList();
-			m_indexBuffer.allocate(idxList.constData(),static_cast<int>(m_indexBufferTypeSize) * idxList.size());
+			m_indexBuffer.allocate(indices,static_cast<int>(m_indexBufferTypeSize) * indexCount);
 		}
-		m_indexCount = obj->getIndexList().size();
+		m_indexCount = indexCount;
 		m_memoryUsage+= static_cast<size_t>(m_indexCount) * m_indexBufferTypeSize;
 		m_indexBuffer.release();
 	}
@@ -21,6 +21,7 @@
 #define STELOPENGLARRAY_HPP
 
 #include "VecMath.hpp"
+#include "StelOBJ.hpp"
 
 #include <QLoggingCategory>
 #include <QOpenGLBuffer>
@@ -28,7 +29,6 @@
 #include <QOpenGLVertexArrayObject>
 #include <QVector>
 
-class StelOBJ;
 class QOpenGLFunctions;
 
 Q_DECLARE_LOGGING_CATEGORY(stelOpenGLArray)
@@ -80,6 +80,12 @@ public:
 	//! @param useTangents Whether to also load tangent/bitangent data, or skip it to save GL memory
 	//! @note Requires a valid bound GL context
 	bool load(const StelOBJ* obj, bool useTangents = true);
+	//! Loads the given vertex and index data into OpenGL buffers.
+	//! The data is copied directly from the given memory (which may for example be memory-mapped from a file),
+	//! unsigned short indices are used if possible.
+	//! @return false if the data could not be loaded into GL
+	//! @note Requires a valid bound GL context
+	bool load(const StelOBJ::Vertex* vertices, int vertexCount, const unsigned int* indices, int indexCount, bool useTangents = true);
 
 	//! Binds this array for drawing/manipulating with OpenGL
 	//! @note Requires a valid bound GL context
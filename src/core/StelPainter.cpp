@@ -23,6 +23,7 @@
 #include "StelLocaleMgr.hpp"
 #include "StelProjector.hpp"
 #include "StelProjectorClasses.hpp"
+#include "StelSphericalMOC.hpp"
 #include "StelUtils.hpp"
 #include "Dithering.hpp"
 #include "SaturationShader.hpp"
@@ -37,10 +38,14 @@
 #include <QPaintEngine>
 #include <QCache>
 #include <QOpenGLPaintDevice>
+#include <QOpenGLBuffer>
 #include <QOpenGLShader>
 #include <QOpenGLTexture>
 #include <QApplication>
 
+#include <algorithm>
+#include <cstddef>
+
 static const int TEX_CACHE_LIMIT = 7000000;
 
 #ifndef NDEBUG
@@ -56,6 +61,8 @@ StelPainter::BasicShaderVars StelPainter::basicShaderVars;
 StelPainter::TexturesShaderVars StelPainter::texturesShaderVars;
 StelPainter::BasicShaderVars StelPainter::colorShaderVars;
 StelPainter::TexturesColorShaderVars StelPainter::texturesColorShaderVars;
+QOpenGLBuffer* StelPainter::batchBuffer=Q_NULLPTR;
+GLint StelPainter::boundTexture0=-1;
 
 StelPainter::GLState::GLState(QOpenGLFunctions* gl)
 	: blend(false),
@@ -155,6 +162,8 @@ StelPainter::StelPainter(const StelProjectorP& proj) : QOpenGLFunctions(QOpenGLC
 
 void StelPainter::setProjector(const StelProjectorP& p)
 {
+	if (!batchCommands.isEmpty())
+		flushBatch();
 	prj=p;
 	// Init GL viewport to current projector values
 	glViewport(prj->viewportXywh[0], prj->viewportXywh[1], prj->viewportXywh[2], prj->viewportXywh[3]);
@@ -163,6 +172,7 @@ void StelPainter::setProjector(const StelProjectorP& p)
 
 StelPainter::~StelPainter()
 {
+	flushBatch();
 	if(bayerPatternTex)
 		glDeleteTextures(1, &bayerPatternTex);
 	//reset opengl state
@@ -216,6 +226,7 @@ void StelPainter::setBlending(bool enableBlending, GLenum blendSrc, GLenum blend
 {
 	if(enableBlending != glState.blend)
 	{
+		flushBatch();
 		glState.blend = enableBlending;
 		if(enableBlending)
 			glEnable(GL_BLEND);
@@ -226,6 +237,7 @@ void StelPainter::setBlending(bool enableBlending, GLenum blendSrc, GLenum blend
 	{
 		if(blendSrc!=glState.blendSrc||blendDst!=glState.blendDst)
 		{
+			flushBatch();
 			glState.blendSrc = blendSrc;
 			glState.blendDst = blendDst;
 			glBlendFunc(blendSrc,blendDst);
@@ -237,6 +249,7 @@ void StelPainter::setDepthTest(bool enable)
 {
 	if(glState.depthTest != enable)
 	{
+		flushBatch();
 		glState.depthTest = enable;
 		if(enable)
 			glEnable(GL_DEPTH_TEST);
@@ -249,6 +262,7 @@ void StelPainter::setDepthMask(bool enable)
 {
 	if(glState.depthMask != enable)
 	{
+		flushBatch();
 		glState.depthMask = enable;
 		if(enable)
 			glDepthMask(GL_TRUE);
@@ -261,6 +275,7 @@ void StelPainter::setCullFace(bool enable)
 {
 	if(glState.cullFace!=enable)
 	{
+		flushBatch();
 		glState.cullFace = enable;
 		if(enable)
 			glEnable(GL_CULL_FACE);
@@ -274,6 +289,7 @@ void StelPainter::setLineSmooth(bool enable)
 #ifdef GL_LINE_SMOOTH
 	if (!QOpenGLContext::currentContext()->isOpenGLES() && enable!=glState.lineSmooth)
 	{
+		flushBatch();
 		glState.lineSmooth = enable;
 		if(enable)
 			glEnable(GL_LINE_SMOOTH);
@@ -289,6 +305,7 @@ void StelPainter::setLineWidth(float width)
 {
 	if(fabs(glState.lineWidth - width) > 1.e-10f)
 	{
+		flushBatch();
 		glState.lineWidth = width;
 		glLineWidth(width);
 	}
@@ -675,6 +692,7 @@ StringTexture* StelPainter::getTexTexture(const QString& str, int pixelSize) con
 
 void StelPainter::drawText(float x, float y, const QString& str, float angleDeg, float xshift, float yshift, bool noGravity)
 {
+	flushBatch();
 	if (prj->gravityLabels && !noGravity)
 	{
 		drawTextGravity180(x, y, str, xshift, yshift);
@@ -1638,27 +1656,38 @@ void StelPainter::drawSphericalRegion(const SphericalRegion* poly, SphericalPoly
 
 	bool oldCullFace = glState.cullFace;
 
+	// Coverage maps can have millions of cells: only draw the cells in the viewport,
+	// merged up to the order where they are about 4 pixels wide (cells of order k are about 1/2^k radians wide).
+	const SphericalMOC* moc = poly->getType()==SphericalRegion::MOC ? static_cast<const SphericalMOC*>(poly) : Q_NULLPTR;
+	const int mocDrawOrder = moc ? static_cast<int>(std::ceil(std::log2(qMax(1., prj->getPixelPerRadAtCenter()/4.)))) : 0;
+
 	switch (drawMode)
 	{
 		case SphericalPolygonDrawModeBoundary:
+		{
+			const StelVertexArray outline = moc ? moc->getOutlineVertexArray(prj->getBoundingCap(), mocDrawOrder) : poly->getOutlineVertexArray();
 			if (doSubDivise || prj->intersectViewportDiscontinuity(poly->getBoundingCap()))
-				drawGreatCircleArcs(poly->getOutlineVertexArray(), clippingCap);
+				drawGreatCircleArcs(outline, clippingCap);
 			else
-				drawStelVertexArray(poly->getOutlineVertexArray(), false);
+				drawStelVertexArray(outline, false);
 			break;
+		}
 		case SphericalPolygonDrawModeFill:
 		case SphericalPolygonDrawModeTextureFill:
 		case SphericalPolygonDrawModeTextureFillColormodulated:
+		{
+			const StelVertexArray fill = moc ? moc->getFillVertexArray(prj->getBoundingCap(), mocDrawOrder) : poly->getFillVertexArray();
 			setCullFace(true);
 			// The polygon is already tesselated as triangles
 			if (doSubDivise || prj->intersectViewportDiscontinuity(poly->getBoundingCap()))
 				// flag for color-modulated textured mode (e.g. for Milky Way/extincted)
-				drawSphericalTriangles(poly->getFillVertexArray(), drawMode>=SphericalPolygonDrawModeTextureFill, drawMode==SphericalPolygonDrawModeTextureFillColormodulated, clippingCap, doSubDivise, maxSqDistortion);
+				drawSphericalTriangles(fill, drawMode>=SphericalPolygonDrawModeTextureFill, drawMode==SphericalPolygonDrawModeTextureFillColormodulated, clippingCap, doSubDivise, maxSqDistortion);
 			else
-				drawStelVertexArray(poly->getFillVertexArray(), false);
+				drawStelVertexArray(fill, false);
 
 			setCullFace(oldCullFace);
 			break;
+		}
 		default:
 			Q_ASSERT(0);
 	}
@@ -1693,6 +1722,11 @@ void StelPainter::drawCircle(float x, float y, float r)
 		dy = dx*sp+dy*cp;
 		dx = r;
 	}
+	if (batching)
+	{
+		addToBatch(LineLoop, 180, circleVertexArray[0].v, 3);
+		return;
+	}
 	enableClientStates(true);
 	setVertexPointer(3, GL_FLOAT, circleVertexArray.data());
 	drawFromArray(LineLoop, 180, 0, false);
@@ -1711,6 +1745,11 @@ void StelPainter::drawSprite2dMode(float x, float y, float radius)
 	vertexData[2]=x+radius; vertexData[3]=y-radius;
 	vertexData[4]=x-radius; vertexData[5]=y+radius;
 	vertexData[6]=x+radius; vertexData[7]=y+radius;
+	if (batching)
+	{
+		addToBatch(TriangleStrip, 4, vertexData, 2, texCoordData);
+		return;
+	}
 	enableClientStates(true, true);
 	setVertexPointer(2, GL_FLOAT, vertexData);
 	setTexCoordPointer(2, GL_FLOAT, texCoordData);
@@ -1749,6 +1788,11 @@ void StelPainter::drawSprite2dMode(float x, float y, float radius, float rotatio
 		vertexData[i+1] = y + radius * vertexBase[i] * sinr + radius * vertexBase[i+1] * cosr;
 	}
 
+	if (batching)
+	{
+		addToBatch(TriangleStrip, 4, vertexData, 2, texCoordData);
+		return;
+	}
 	enableClientStates(true, true);
 	setVertexPointer(2, GL_FLOAT, vertexData);
 	setTexCoordPointer(2, GL_FLOAT, texCoordData);
@@ -1764,6 +1808,11 @@ void StelPainter::drawRect2d(float x, float y, float width, float height, bool t
 	vertexData[2]=x+width; vertexData[3]=y;
 	vertexData[4]=x; vertexData[5]=y+height;
 	vertexData[6]=x+width; vertexData[7]=y+height;
+	if (batching)
+	{
+		addToBatch(TriangleStrip, 4, vertexData, 2, textured ? texCoordData : Q_NULLPTR);
+		return;
+	}
 	if (textured)
 	{
 		enableClientStates(true, true);
@@ -1788,6 +1837,11 @@ void StelPainter::drawPoint2d(float x, float y)
 	vertexData[0]=x;
 	vertexData[1]=y;
 
+	if (batching)
+	{
+		addToBatch(Points, 1, vertexData, 2);
+		return;
+	}
 	enableClientStates(true);
 	setVertexPointer(2, GL_FLOAT, vertexData);
 	drawFromArray(Points, 1, 0, false);
@@ -1806,6 +1860,11 @@ void StelPainter::drawLine2d(const float x1, const float y1, const float x2, con
 	vertexData[2]=x2;
 	vertexData[3]=y2;
 
+	if (batching)
+	{
+		addToBatch(Lines, 2, vertexData, 2);
+		return;
+	}
 	enableClientStates(true);
 	setVertexPointer(2, GL_FLOAT, vertexData);
 	drawFromArray(Lines, 2, 0, false);
@@ -2156,6 +2215,10 @@ void StelPainter::initGLShaders()
 	texturesColorShaderVars.bayerPattern = texturesColorShaderProgram->uniformLocation("bayerPattern");
 	texturesColorShaderVars.rgbMaxValue = texturesColorShaderProgram->uniformLocation("rgbMaxValue");
 	texturesColorShaderVars.saturation = texturesColorShaderProgram->uniformLocation("saturation");
+
+	batchBuffer = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+	batchBuffer->setUsagePattern(QOpenGLBuffer::StreamDraw);
+	batchBuffer->create();
 }
 
 
@@ -2169,6 +2232,10 @@ void StelPainter::deinitGLShaders()
 	texturesShaderProgram = Q_NULLPTR;
 	delete texturesColorShaderProgram;
 	texturesColorShaderProgram = Q_NULLPTR;
+	if (batchBuffer)
+		batchBuffer->destroy();
+	delete batchBuffer;
+	batchBuffer = Q_NULLPTR;
 	texCache.clear();
 }
 
@@ -2201,6 +2268,7 @@ void StelPainter::enableClientStates(bool vertex, bool texture, bool color, bool
 
 void StelPainter::drawFromArray(DrawingMode mode, int count, int offset, bool doProj, const unsigned short* indices)
 {
+	flushBatch();
 	ArrayDesc projectedVertexArray = vertexArray;
 	if (doProj)
 	{
@@ -2310,6 +2378,222 @@ void StelPainter::drawFromArray(DrawingMode mode, int count, int offset, bool do
 		pr->release();
 }
 
+void StelPainter::setBatching(bool enable)
+{
+	if (!enable)
+		flushBatch();
+	else if (!batching)
+	{
+		// Textures may have been bound without StelTexture::bind() before
+		boundTexture0 = -1;
+	}
+	batching = enable;
+}
+
+GLuint StelPainter::getBoundTexture0()
+{
+	if (boundTexture0<0)
+	{
+		GLint activeUnit = 0, boundTexture = 0;
+		glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+		glActiveTexture(GL_TEXTURE0);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+		glActiveTexture(static_cast<GLenum>(activeUnit));
+		boundTexture0 = boundTexture;
+	}
+	return static_cast<GLuint>(boundTexture0);
+}
+
+void StelPainter::addToBatch(DrawingMode mode, int count, const float* vertices, int vertexStride, const float* texCoords)
+{
+	// The texture used by drawFromArray() is the one bound to unit 0 at the time of the draw
+	const GLuint texture = texCoords ? getBoundTexture0() : 0;
+
+	// Convert strips and loops into independent primitives, keeping the vertex order of each triangle
+	QVarLengthArray<int, 512> order;
+	DrawingMode batchMode = mode;
+	switch (mode)
+	{
+		case TriangleStrip:
+			batchMode = Triangles;
+			for (int i=0; i+2<count; ++i)
+			{
+				order.append(i%2 ? i+1 : i);
+				order.append(i%2 ? i : i+1);
+				order.append(i+2);
+			}
+			break;
+		case LineLoop:
+		case LineStrip:
+			batchMode = Lines;
+			for (int i=0; i<(mode==LineLoop ? count : count-1); ++i)
+			{
+				order.append(i);
+				order.append((i+1)%count);
+			}
+			break;
+		case TriangleFan:
+			batchMode = Triangles;
+			for (int i=1; i+1<count; ++i)
+			{
+				order.append(0);
+				order.append(i);
+				order.append(i+1);
+			}
+			break;
+		default:
+			for (int i=0; i<count; ++i)
+				order.append(i);
+			break;
+	}
+
+	const int first = batchVertices.size();
+	batchVertices.resize(first + order.size());
+	BatchVertex* out = batchVertices.data() + first;
+	for (int i : order)
+	{
+		out->pos[0] = vertices[i*vertexStride];
+		out->pos[1] = vertices[i*vertexStride+1];
+		out->texCoord[0] = texCoords ? texCoords[i*2] : 0.f;
+		out->texCoord[1] = texCoords ? texCoords[i*2+1] : 0.f;
+		for (int c=0; c<4; ++c)
+			out->color[c] = currentColor[c];
+		++out;
+	}
+
+	if (!batchCommands.isEmpty())
+	{
+		BatchCommand& last = batchCommands.last();
+		if (last.mode==batchMode && last.textured==(texCoords!=Q_NULLPTR) && last.texture==texture)
+		{
+			last.count += order.size();
+			return;
+		}
+	}
+	const BatchCommand cmd = {batchMode, texCoords!=Q_NULLPTR, texture, first, order.size()};
+	batchCommands.append(cmd);
+}
+
+void StelPainter::flushBatch()
+{
+	if (batchCommands.isEmpty())
+		return;
+
+	// With additive blending the result does not depend on the order, so the commands are grouped by state
+	QVector<int> order(batchCommands.size());
+	for (int i=0; i<order.size(); ++i)
+		order[i] = i;
+	if (glState.blend && glState.blendDst==GL_ONE && (glState.blendSrc==GL_ONE || glState.blendSrc==GL_SRC_ALPHA) && !glState.depthTest)
+	{
+		std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+			const BatchCommand& ca = batchCommands.at(a);
+			const BatchCommand& cb = batchCommands.at(b);
+			if (ca.textured!=cb.textured)
+				return ca.textured<cb.textured;
+			if (ca.texture!=cb.texture)
+				return ca.texture<cb.texture;
+			return ca.mode<cb.mode;
+		});
+	}
+
+	// Copy the vertices in drawing order, merging the commands with the same state
+	QVector<BatchVertex> vertices;
+	vertices.reserve(batchVertices.size());
+	QVector<BatchCommand> draws;
+	for (int i : order)
+	{
+		const BatchCommand& cmd = batchCommands.at(i);
+		if (draws.isEmpty() || draws.last().mode!=cmd.mode || draws.last().textured!=cmd.textured || draws.last().texture!=cmd.texture)
+		{
+			const BatchCommand draw = {cmd.mode, cmd.textured, cmd.texture, vertices.size(), 0};
+			draws.append(draw);
+		}
+		draws.last().count += cmd.count;
+		for (int v=cmd.first; v<cmd.first+cmd.count; ++v)
+			vertices.append(batchVertices.at(v));
+	}
+	batchVertices.resize(0);
+	batchCommands.resize(0);
+
+	const GLuint boundTexture = getBoundTexture0();
+	glActiveTexture(GL_TEXTURE0);
+
+	batchBuffer->bind();
+	batchBuffer->allocate(vertices.constData(), vertices.size()*static_cast<int>(sizeof(BatchVertex)));
+
+	const Mat4f& m = getProjector()->getProjectionMatrix();
+	const QMatrix4x4 qMat(m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]);
+	const auto rgbMaxValue=calcRGBMaxValue(ditheringMode);
+	const int stride = static_cast<int>(sizeof(BatchVertex));
+
+	QOpenGLShaderProgram* pr = Q_NULLPTR;
+	auto releaseProgram = [&pr, this]()
+	{
+		if (pr==texturesColorShaderProgram)
+		{
+			pr->disableAttributeArray(texturesColorShaderVars.texCoord);
+			pr->disableAttributeArray(texturesColorShaderVars.vertex);
+			pr->disableAttributeArray(texturesColorShaderVars.color);
+		}
+		else if (pr==colorShaderProgram)
+		{
+			pr->disableAttributeArray(colorShaderVars.vertex);
+			pr->disableAttributeArray(colorShaderVars.color);
+		}
+		if (pr)
+			pr->release();
+	};
+	GLuint texture = boundTexture;
+	for (const auto& draw : draws)
+	{
+		// The per-vertex color variants of the shaders give the same result as the uniform color ones
+		QOpenGLShaderProgram* drawProgram = draw.textured ? texturesColorShaderProgram : colorShaderProgram;
+		if (drawProgram!=pr)
+		{
+			releaseProgram();
+			pr = drawProgram;
+			pr->bind();
+			if (draw.textured)
+			{
+				pr->setAttributeBuffer(texturesColorShaderVars.vertex, GL_FLOAT, offsetof(BatchVertex, pos), 2, stride);
+				pr->enableAttributeArray(texturesColorShaderVars.vertex);
+				pr->setAttributeBuffer(texturesColorShaderVars.texCoord, GL_FLOAT, offsetof(BatchVertex, texCoord), 2, stride);
+				pr->enableAttributeArray(texturesColorShaderVars.texCoord);
+				pr->setAttributeBuffer(texturesColorShaderVars.color, GL_FLOAT, offsetof(BatchVertex, color), 4, stride);
+				pr->enableAttributeArray(texturesColorShaderVars.color);
+				pr->setUniformValue(texturesColorShaderVars.projectionMatrix, qMat);
+				glActiveTexture(GL_TEXTURE1);
+				if(!bayerPatternTex)
+					bayerPatternTex=makeBayerPatternTexture(*this);
+				glBindTexture(GL_TEXTURE_2D, bayerPatternTex);
+				glActiveTexture(GL_TEXTURE0);
+				pr->setUniformValue(texturesColorShaderVars.bayerPattern, 1);
+				pr->setUniformValue(texturesColorShaderVars.rgbMaxValue, rgbMaxValue[0], rgbMaxValue[1], rgbMaxValue[2]);
+				pr->setUniformValue(texturesColorShaderVars.saturation, saturation);
+			}
+			else
+			{
+				pr->setAttributeBuffer(colorShaderVars.vertex, GL_FLOAT, offsetof(BatchVertex, pos), 2, stride);
+				pr->enableAttributeArray(colorShaderVars.vertex);
+				pr->setAttributeBuffer(colorShaderVars.color, GL_FLOAT, offsetof(BatchVertex, color), 4, stride);
+				pr->enableAttributeArray(colorShaderVars.color);
+				pr->setUniformValue(colorShaderVars.projectionMatrix, qMat);
+			}
+		}
+		if (draw.textured && draw.texture!=texture)
+		{
+			texture = draw.texture;
+			glBindTexture(GL_TEXTURE_2D, texture);
+		}
+		glDrawArrays(draw.mode, draw.first, draw.count);
+	}
+	releaseProgram();
+	batchBuffer->release();
+
+	// Restore the texture bound by the caller. Like the other drawing methods, this leaves unit 0 active.
+	if (texture!=boundTexture)
+		glBindTexture(GL_TEXTURE_2D, boundTexture);
+}
 
 StelPainter::ArrayDesc StelPainter::projectArray(const StelPainter::ArrayDesc& array, int offset, int count, const unsigned short* indices)
 {
@@ -27,9 +27,11 @@
 #include "StelProjector.hpp"
 #include <QString>
 #include <QVarLengthArray>
+#include <QVector>
 #include <QFontMetrics>
 
 class QOpenGLShaderProgram;
+class QOpenGLBuffer;
 
 //! @class StelPainter
 //! Provides functions for performing openGL drawing operations.
@@ -78,7 +80,8 @@ public:
 	//! Returns a QOpenGLFunctions object suitable for drawing directly with OpenGL while this StelPainter is active.
 	//! This is recommended to be used instead of QOpenGLContext::currentContext()->functions() when a StelPainter is available,
 	//! and you only need to call a few GL functions directly.
-	inline QOpenGLFunctions* glFuncs() { return this; }
+	//! In batch mode, the pending primitives are drawn first.
+	inline QOpenGLFunctions* glFuncs() { if (!batchCommands.isEmpty()) flushBatch(); boundTexture0 = -1; return this; }
 
 	//! Return the instance of projector associated to this painter
 	const StelProjectorP& getProjector() const {return prj;}
@@ -268,7 +271,7 @@ public:
 	void setLineWidth(float width);
 
 	//! Sets the color saturation effect value, from 0 (grayscale) to 1 (no effect).
-	void setSaturation(float v) { saturation = v; }
+	void setSaturation(float v) { if (v!=saturation && !batchCommands.isEmpty()) flushBatch(); saturation = v; }
 
 	//! Create the OpenGL shaders programs used by the StelPainter.
 	//! This method needs to be called once at init.
@@ -328,6 +331,20 @@ public:
 
 	DitheringMode getDitheringMode() const { return ditheringMode; }
 
+	//! Enable or disable the batch mode. While it is enabled, the primitives of drawSprite2dMode(), drawRect2d(),
+	//! drawPoint2d(), drawLine2d() and drawCircle() are collected with the current color and the texture bound to unit 0,
+	//! and drawn from a streaming vertex buffer with one draw call per texture and primitive type.
+	//! They are drawn when flushBatch() is called, when another drawing method or a state setter which changes the GL state
+	//! is called, and when glFuncs() is used. The drawing order is kept, except with additive blending (without depth test)
+	//! where the primitives are grouped by texture, which gives the same result.
+	//! Between the batched calls, GL calls must only be done through glFuncs() or StelTexture::bind().
+	void setBatching(bool enable);
+	bool getBatching() const { return batching; }
+	//! Draw the primitives collected in batch mode.
+	void flushBatch();
+	//! Called by StelTexture::bind(), so that the batch mode knows the bound texture without querying GL.
+	static void textureBound(uint slot, GLuint id) { if (slot==0) boundTexture0 = static_cast<GLint>(id); }
+
 private:
 	friend class StelTextureMgr;
 	friend class StelTexture;
@@ -387,6 +404,14 @@ private:
 
 	void drawTextGravity180(float x, float y, const QString& str, float xshift = 0, float yshift = 0);
 
+	//! Add a primitive to the batch. Strips and loops are converted to independent triangles and lines,
+	//! so that consecutive primitives can be drawn together.
+	//! @param vertices the 2d positions in pixels, with vertexStride floats between two vertices.
+	//! @param texCoords the texture coordinates, or Q_NULLPTR for untextured primitives.
+	void addToBatch(DrawingMode mode, int count, const float* vertices, int vertexStride, const float* texCoords=Q_NULLPTR);
+	//! Return the texture bound to unit 0, which is only queried from GL if it was not bound through StelTexture::bind().
+	GLuint getBoundTexture0();
+
 	// Used by the method below
 	static QVector<Vec3f> smallCircleVertexArray;
 	static QVector<Vec4f> smallCircleColorArray;
@@ -454,6 +479,30 @@ private:
 	ArrayDesc normalArray;
 	//! The descriptor for the current opengl color array
 	ArrayDesc colorArray;
+
+	//! A vertex of the batch
+	struct BatchVertex
+	{
+		float pos[2];
+		float texCoord[2];
+		float color[4];
+	};
+	//! Consecutive vertices of the batch using the same state
+	struct BatchCommand
+	{
+		DrawingMode mode;
+		bool textured;
+		GLuint texture;
+		int first;
+		int count;
+	};
+	bool batching = false;
+	QVector<BatchVertex> batchVertices;
+	QVector<BatchCommand> batchCommands;
+	//! The streaming vertex buffer used to draw the batches
+	static QOpenGLBuffer* batchBuffer;
+	//! The texture bound to unit 0, or -1 if it must be queried, e.g. after GL calls made through glFuncs()
+	static GLint boundTexture0;
 };
 
 Q_DECLARE_METATYPE(StelPainter::DitheringMode)
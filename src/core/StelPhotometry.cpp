@@ -0,0 +1,290 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelPhotometry.hpp"
+
+#include <QRegExp>
+#include <QStringList>
+
+#include <cfloat>
+#include <cmath>
+
+// Number of samples used to compute the mean magnitude of a periodic curve
+static const int MEAN_SAMPLES = 64;
+
+StelPhotometry::StelPhotometry()
+	: lastJDE(0.)
+{
+}
+
+int StelPhotometry::addGcvsCurve(const QString& type, float maxMag, int magFlag, float min1Mag, float min2Mag, double epoch, double period, int risingTime)
+{
+	static const QStringList pulsatingTypes = QString("ACV ACVO ACYG BCEP BCEPS BY CEP CW CWA CWB DCEP DCEPS DSCT DSCTC GDOR M PVTEL RPHS "
+							  "RR RRAB RRC RV RVA RVB SR SRA SRB SRC SRD SXARI SXPHE ZZ ZZA ZZB").split(' ');
+
+	// Missing values are stored as 99 in the catalog
+	if (period<=0. || epoch<=0. || maxMag>=99.f || min1Mag>=99.f)
+		return -1;
+
+	// Uncertain and combined types are modelled by their first component, e.g. "EA/DM" or "SRB:"
+	QString mainType = type.trimmed();
+	const int end = mainType.indexOf(QRegExp("[/+:( ]"));
+	if (end>=0)
+		mainType.truncate(end);
+
+	LightCurve curve;
+	curve.epoch = epoch;
+	curve.period = period;
+	curve.maxMag = maxMag;
+	curve.amplitude = magFlag==1 ? min1Mag : min1Mag - maxMag;
+	curve.secondaryAmplitude = 0.f;
+	if (min2Mag<99.f)
+		curve.secondaryAmplitude = magFlag==1 ? min2Mag : min2Mag - maxMag;
+	curve.meanMag = maxMag;
+	curve.brightLimit = -FLT_MAX;
+	curve.faintLimit = FLT_MAX;
+	curve.firstSegment = 0;
+	curve.segmentCount = 0;
+	if (curve.amplitude<=0.f)
+		return -1;
+
+	const float fraction = (risingTime>0 && risingTime<100) ? risingTime/100.f : 0.f;
+	if (pulsatingTypes.contains(mainType))
+	{
+		curve.model = Pulsating;
+		curve.fraction = fraction;
+		if (curve.fraction<=0.f)
+		{
+			// Typical rising times when they are not given
+			if (mainType=="RR" || mainType=="RRAB")
+				curve.fraction = 0.15f;
+			else if (mainType.contains("CEP") || mainType.startsWith("CW"))
+				curve.fraction = 0.3f;
+			else
+				curve.fraction = 0.5f;
+		}
+	}
+	else if (mainType=="EA" || (mainType=="E" && fraction>0.f))
+	{
+		curve.model = EclipsingDetached;
+		curve.fraction = fraction>0.f ? fraction : 0.1f;
+	}
+	else if (mainType=="EB" || mainType=="EW" || mainType=="E" || mainType=="ELL")
+	{
+		curve.model = EclipsingContact;
+		curve.fraction = 0.5f;
+		// Both minima have about the same depth when the secondary one is not given
+		if (curve.secondaryAmplitude<=0.f)
+			curve.secondaryAmplitude = curve.amplitude;
+	}
+	else
+		return -1;
+
+	computeMeanMagnitude(curve);
+	return appendCurve(curve);
+}
+
+int StelPhotometry::addNovaCurve(const QString& type, float maxMag, float minMag, double peakJD, int t2, int t3, int t6, int t9)
+{
+	// Fill the unset decline times from the speed class of the nova
+	int speedClass = -1;
+	if (type.contains("NC", Qt::CaseSensitive))
+		speedClass = 2; // "very slow" nova
+	else if (type.contains("NB", Qt::CaseSensitive))
+		speedClass = 1; // "slow" nova
+	else if (type.contains("NA", Qt::CaseSensitive))
+		speedClass = 0; // "fast" nova
+	if (speedClass>=0)
+	{
+		static const int times[4][3] = {{10, 80, 200}, {30, 160, 300}, {100, 300, 1200}, {400, 1000, 3000}};
+		if (t2<0) t2 = times[0][speedClass];
+		if (t3<0) t3 = times[1][speedClass];
+		if (t6<0) t6 = times[2][speedClass];
+		if (t9<0) t9 = times[3][speedClass];
+	}
+
+	LightCurve curve;
+	curve.model = Transient;
+	curve.epoch = peakJD;
+	curve.period = 0.;
+	curve.maxMag = maxMag;
+	curve.amplitude = minMag - maxMag;
+	curve.secondaryAmplitude = 0.f;
+	curve.fraction = 0.f;
+	curve.meanMag = minMag;
+	curve.brightLimit = -FLT_MAX;
+	curve.faintLimit = minMag;
+	curve.firstSegment = static_cast<quint16>(segments.size());
+
+	// The outburst takes 3 days, then the decline times are counted from maximum
+	const Segment novaSegments[] = {
+		{-3.f, 0.f, minMag, -(minMag-maxMag)/3.f},
+		{0.f, static_cast<float>(t2), maxMag, 2.f/t2},
+		{static_cast<float>(t2), static_cast<float>(t3), maxMag+2.f, 3.f/t3},
+		{static_cast<float>(t3), static_cast<float>(t6), maxMag+3.f, 6.f/t6},
+		{static_cast<float>(t6), static_cast<float>(t9), maxMag+6.f, 9.f/t9}
+	};
+	for (const auto& segment : novaSegments)
+	{
+		// Empty segments can't match any date
+		if (segment.end>segment.start)
+			segments.append(segment);
+	}
+	curve.segmentCount = static_cast<quint8>(segments.size() - curve.firstSegment);
+
+	return appendCurve(curve);
+}
+
+int StelPhotometry::addSupernovaCurve(const QString& type, float maxMag, double peakJD)
+{
+	LightCurve curve;
+	curve.model = Transient;
+	curve.epoch = peakJD;
+	curve.period = 0.;
+	curve.maxMag = maxMag;
+	curve.amplitude = 20.f - maxMag;
+	curve.secondaryAmplitude = 0.f;
+	curve.fraction = 0.f;
+	curve.meanMag = 20.f;
+	curve.brightLimit = maxMag;
+	curve.faintLimit = FLT_MAX;
+	curve.firstSegment = static_cast<quint16>(segments.size());
+
+	// Supernova light curve model from here - http://www.astronet.ru/db/msg/1188703
+	if (type.contains("II", Qt::CaseSensitive))
+	{
+		// Type II
+		segments.append({-20.f, 0.f, maxMag+15.f, -0.75f});
+		segments.append({0.f, 30.f, maxMag, 0.05f});
+		segments.append({30.f, 80.f, maxMag+1.5f, 0.013f});
+		segments.append({80.f, 100.f, maxMag+2.15f, 0.075f});
+		segments.append({100.f, FLT_MAX, maxMag+3.65f, 0.025f});
+	}
+	else
+	{
+		// Type I
+		segments.append({-15.f, 0.f, maxMag+16.95f, -1.13f});
+		segments.append({0.f, 25.f, maxMag, 0.1f});
+		segments.append({25.f, FLT_MAX, maxMag+2.5f, 0.016f});
+	}
+	curve.segmentCount = static_cast<quint8>(segments.size() - curve.firstSegment);
+
+	return appendCurve(curve);
+}
+
+int StelPhotometry::appendCurve(const LightCurve& curve)
+{
+	curves.append(curve);
+	magnitudes.append(curve.meanMag);
+	// The new curve is evaluated at the next update, even for the same date
+	lastJDE = 0.;
+	return curves.size()-1;
+}
+
+void StelPhotometry::clear()
+{
+	curves.clear();
+	segments.clear();
+	magnitudes.clear();
+	lastJDE = 0.;
+}
+
+bool StelPhotometry::update(double jde)
+{
+	if (jde==lastJDE)
+		return false;
+	lastJDE = jde;
+	for (int i=0; i<curves.size(); ++i)
+		magnitudes[i] = computeMagnitude(curves.at(i), jde);
+	return true;
+}
+
+float StelPhotometry::computeMagnitude(int index, double jde) const
+{
+	return computeMagnitude(curves.at(index), jde);
+}
+
+void StelPhotometry::computeMeanMagnitude(LightCurve& curve) const
+{
+	float sum = 0.f;
+	for (int i=0; i<MEAN_SAMPLES; ++i)
+		sum += computeMagnitude(curve, curve.epoch + curve.period*i/MEAN_SAMPLES);
+	curve.meanMag = sum/MEAN_SAMPLES;
+}
+
+float StelPhotometry::computeMagnitude(const LightCurve& curve, double jde) const
+{
+	float mag = curve.meanMag;
+	if (curve.model==Transient)
+	{
+		const float t = static_cast<float>(jde - curve.epoch);
+		const Segment* segment = segments.constData() + curve.firstSegment;
+		for (int i=0; i<curve.segmentCount; ++i, ++segment)
+		{
+			if (t>segment->start && t<=segment->end)
+				mag = segment->mag + segment->slope*(t - segment->start);
+		}
+	}
+	else
+	{
+		double cycles = (jde - curve.epoch)/curve.period;
+		float phase = static_cast<float>(cycles - std::floor(cycles));
+		switch (curve.model)
+		{
+			case Pulsating:
+			{
+				// Decline from maximum, then rise during the given fraction of the period
+				const float decline = 1.f - curve.fraction;
+				if (phase<decline)
+					mag = curve.maxMag + curve.amplitude*0.5f*(1.f - std::cos(static_cast<float>(M_PI)*phase/decline));
+				else
+					mag = curve.maxMag + curve.amplitude*0.5f*(1.f + std::cos(static_cast<float>(M_PI)*(phase-decline)/curve.fraction));
+				break;
+			}
+			case EclipsingDetached:
+			{
+				// Primary eclipse centered on phase 0, secondary eclipse on phase 0.5
+				const float halfDuration = 0.5f*curve.fraction;
+				if (phase>0.5f)
+					phase -= 1.f;
+				mag = curve.maxMag;
+				if (std::fabs(phase)<halfDuration)
+					mag += curve.amplitude*0.5f*(1.f + std::cos(static_cast<float>(M_PI)*phase/halfDuration));
+				const float secondaryPhase = phase<0.f ? phase+0.5f : phase-0.5f;
+				if (std::fabs(secondaryPhase)<halfDuration)
+					mag += curve.secondaryAmplitude*0.5f*(1.f + std::cos(static_cast<float>(M_PI)*secondaryPhase/halfDuration));
+				break;
+			}
+			case EclipsingContact:
+			{
+				// Two minima per period, the primary one at phase 0
+				const float depth = std::cos(2.f*static_cast<float>(M_PI)*phase)>=0.f ? curve.amplitude : curve.secondaryAmplitude;
+				mag = curve.maxMag + depth*0.5f*(1.f + std::cos(4.f*static_cast<float>(M_PI)*phase));
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	if (mag>curve.faintLimit)
+		mag = curve.faintLimit;
+	if (mag<curve.brightLimit)
+		mag = curve.brightLimit;
+	return mag;
+}
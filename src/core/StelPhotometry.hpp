@@ -0,0 +1,123 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELPHOTOMETRY_HPP
+#define STELPHOTOMETRY_HPP
+
+#include <QString>
+#include <QVector>
+
+//! @class StelPhotometry
+//! Computes the current magnitude of objects with a variable brightness: periodic variable stars from the GCVS,
+//! novae and supernovae.
+//!
+//! The light curve of each object is compiled once from its catalog data into a few coefficients, so that
+//! the evaluation needs neither the type strings nor the catalog. A periodic curve is described by its
+//! epoch, period, magnitude at maximum, amplitudes and shape. A transient is described by segments of
+//! linear decline around the peak. update() evaluates all the curves for a date, typically once per frame.
+class StelPhotometry
+{
+public:
+	//! The light curve models
+	enum Model
+	{
+		Pulsating,		//!< Periodic curve with a decline and a rise of different durations, from maximum light at the epoch
+		EclipsingDetached,	//!< Constant light interrupted by eclipses, from primary minimum at the epoch
+		EclipsingContact,	//!< Continuous variation with two minima per period, from primary minimum at the epoch
+		Transient		//!< Linear segments relative to the peak at the epoch
+	};
+
+	//! A linear part of the light curve of a transient
+	struct Segment
+	{
+		//! The segment covers start < t <= end, in days from the epoch
+		float start, end;
+		//! The magnitude at start
+		float mag;
+		//! The decline in magnitude per day
+		float slope;
+	};
+
+	//! The compiled light curve of an object
+	struct LightCurve
+	{
+		//! Epoch (JDE)
+		double epoch;
+		//! Period (days) of the periodic models
+		double period;
+		//! Magnitude at maximum light
+		float maxMag;
+		//! Depth of the primary and the secondary minimum (mag)
+		float amplitude, secondaryAmplitude;
+		//! Fraction of the period: rising time of pulsating curves, duration of the eclipses of detached binaries
+		float fraction;
+		//! Mean magnitude over a period, or the magnitude of a transient out of its segments
+		float meanMag;
+		//! The magnitude is clamped to [brightLimit, faintLimit]
+		float brightLimit, faintLimit;
+		quint16 firstSegment;
+		quint8 segmentCount;
+		quint8 model;
+	};
+
+	StelPhotometry();
+
+	//! Add the light curve of a GCVS variable star.
+	//! @param type the GCVS variability type, e.g. "M", "EA/DM" or "SRB:".
+	//! @param magFlag 1 when min1Mag and min2Mag are amplitudes instead of magnitudes.
+	//! @param epoch the epoch of maximum light (or of minimum light for eclipsing binaries), JD.
+	//! @param risingTime the rising time for pulsating stars or the eclipse duration for eclipsing binaries, in percent of the period.
+	//! @return the index of the curve, or -1 if the type is not periodic or if the data is incomplete.
+	int addGcvsCurve(const QString& type, float maxMag, int magFlag, float min1Mag, float min2Mag, double epoch, double period, int risingTime);
+	//! Add the light curve of a nova.
+	//! @param type the type of nova: NA (fast), NB (slow) or NC (very slow). It gives the decline times which are not set.
+	//! @param t2,t3,t6,t9 the times in days to decline by 2, 3, 6 and 9 magnitudes from maximum, or -1 if unknown.
+	//! @return the index of the curve.
+	int addNovaCurve(const QString& type, float maxMag, float minMag, double peakJD, int t2, int t3, int t6, int t9);
+	//! Add the light curve of a supernova.
+	//! @param type the type of supernova, the type II template is used when it contains "II", the type I one otherwise.
+	//! @return the index of the curve.
+	int addSupernovaCurve(const QString& type, float maxMag, double peakJD);
+
+	void clear();
+	int size() const {return curves.size();}
+	const LightCurve& getLightCurve(int index) const {return curves.at(index);}
+
+	//! Evaluate all the curves for the given date.
+	//! @return false if the magnitudes were already evaluated for this date.
+	bool update(double jde);
+	//! Return the magnitude of the curve computed by the last call to update().
+	float getMagnitude(int index) const {return magnitudes.at(index);}
+	//! Return the magnitude of the curve for the given date, from the last call to update() if it was made for this date.
+	float getMagnitude(int index, double jde) const {return jde==lastJDE ? magnitudes.at(index) : computeMagnitude(index, jde);}
+	//! Compute the magnitude of the curve for the given date.
+	float computeMagnitude(int index, double jde) const;
+
+private:
+	int appendCurve(const LightCurve& curve);
+	//! Set the mean magnitude of a periodic curve by sampling it over one period
+	void computeMeanMagnitude(LightCurve& curve) const;
+	float computeMagnitude(const LightCurve& curve, double jde) const;
+
+	QVector<LightCurve> curves;
+	QVector<Segment> segments;
+	QVector<float> magnitudes;
+	double lastJDE;
+};
+
+#endif // STELPHOTOMETRY_HPP
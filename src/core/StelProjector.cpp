@@ -105,6 +105,16 @@ StelProjector::StelProjectorMaskType StelProjector::stringToMaskType(const QStri
 	return MaskNone;
 }
 
+StelProjector::StelProjectorParams StelProjector::StelProjectorParams::getTileParams(int x, int y, int width, int height) const
+{
+	StelProjectorParams res(*this);
+	res.viewportXywh[2] = width;
+	res.viewportXywh[3] = height;
+	// The projection center is given in GL coordinates, i.e. from the bottom left corner
+	res.viewportCenter.set(viewportCenter[0]-x, viewportCenter[1]-(viewportXywh[3]-y-height));
+	return res;
+}
+
 void StelProjector::init(const StelProjectorParams& params)
 {
 	devicePixelsPerPixel = params.devicePixelsPerPixel;
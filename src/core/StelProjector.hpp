@@ -109,6 +109,11 @@ public:
 			, devicePixelsPerPixel(1)
 			, widthStretch(1) {;}
 
+		//! Return the parameters rendering the part of this viewport given by x, y, width and height (from its top left
+		//! corner) as a viewport of its own, with the projection of the full viewport. Only the projection center is shifted
+		//! relative to the tile (off-axis projection), so that images larger than the framebuffer can be rendered in tiles.
+		StelProjectorParams getTileParams(int x, int y, int width, int height) const;
+
 		Vector4<int> viewportXywh;       //! posX, posY, width, height
 		float fov;                       //! FOV in degrees
 		bool gravityLabels;              //! the flag to use gravity labels or not
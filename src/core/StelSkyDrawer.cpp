@@ -71,12 +71,17 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	customPlanetMagLimit(0.0),
 	bortleScaleIndex(3),
 	inScale(1.f),
+	mainEyeInputScale(1.f),
+	mainLnfovFactor(0.f),
+	mainLimitMagnitude(-100.f),
+	mainLimitLuminance(0.f),
 	starShaderProgram(Q_NULLPTR),
 	starShaderVars(StarShaderVars()),
 	nbPointSources(0),
 	maxPointSources(1000),
 	maxLum(0.f),
 	oldLum(-1.f),
+	overrideLum(-1.f),
 	flagLuminanceAdaptation(false),
 	daylightLabelThreshold(250.0),
 	big3dModelHaloRadius(150.f)
@@ -214,17 +219,6 @@ void StelSkyDrawer::init()
 
 void StelSkyDrawer::update(double)
 {
-	float fov = static_cast<float>(core->getMovementMgr()->getCurrentFov());
-	if (fov > maxAdaptFov)
-	{
-		fov = maxAdaptFov;
-	}
-	else
-	{
-		if (fov < minAdaptFov)
-			fov = minAdaptFov;
-	}
-
 	// GZ: Light pollution must take global atmosphere setting into acount!
 	// moved parts from setBortleScale() here
 	// These value have been calibrated by hand, looking at the faintest star in stellarium at around 40 deg FOV
@@ -235,6 +229,24 @@ void StelSkyDrawer::update(double)
 	else
 	    setInputScale(bortleToInScale[0]);
 
+	// Precompute
+	starLinearScale = static_cast<float>(std::pow(35.*2.0*starAbsoluteScaleF, 1.40*0.5*starRelativeScale));
+
+	updateFovDependentValues(static_cast<float>(core->getMovementMgr()->getCurrentFov()));
+}
+
+void StelSkyDrawer::updateFovDependentValues(float fov)
+{
+	if (fov > maxAdaptFov)
+	{
+		fov = maxAdaptFov;
+	}
+	else
+	{
+		if (fov < minAdaptFov)
+			fov = minAdaptFov;
+	}
+
 	// This factor is fully arbitrary. It corresponds to the collecting area x exposure time of the instrument
 	// It is based on a power law, so that it varies progressively with the FOV to smoothly switch from human
 	// vision to binocculares/telescope. Use a max of 0.7 because after that the atmosphere starts to glow too much!
@@ -245,9 +257,6 @@ void StelSkyDrawer::update(double)
 	// the division by powFactor should in principle not be here, but it doesn't look nice if removed
 	lnfovFactor = std::log(1.f/50.f*2025000.f* 60.f*60.f / (fov*fov) / (EYE_RESOLUTION*EYE_RESOLUTION)/powFactor/1.4f);
 
-	// Precompute
-	starLinearScale = static_cast<float>(std::pow(35.*2.0*starAbsoluteScaleF, 1.40*0.5*starRelativeScale));
-
 	// update limit mag
 	limitMagnitude = computeLimitMagnitude();
 
@@ -255,6 +264,23 @@ void StelSkyDrawer::update(double)
 	limitLuminance = computeLimitLuminance();
 }
 
+void StelSkyDrawer::beginCamera(float fov)
+{
+	mainEyeInputScale = eye->getInputScale();
+	mainLnfovFactor = lnfovFactor;
+	mainLimitMagnitude = limitMagnitude;
+	mainLimitLuminance = limitLuminance;
+	updateFovDependentValues(fov);
+}
+
+void StelSkyDrawer::endCamera()
+{
+	eye->setInputScale(mainEyeInputScale);
+	lnfovFactor = mainLnfovFactor;
+	limitMagnitude = mainLimitMagnitude;
+	limitLuminance = mainLimitLuminance;
+}
+
 // Compute the current limit magnitude by dichotomy
 float StelSkyDrawer::computeLimitMagnitude() const
 {
@@ -638,6 +664,9 @@ float StelSkyDrawer::findWorldLumForMag(float mag, float targetRadius)
 // Report that an object of luminance lum is currently displayed
 void StelSkyDrawer::reportLuminanceInFov(float lum, bool fastAdaptation)
 {
+	// The eye adaptation follows the main view only
+	if (core->getCurrentCamera()>=0 || overrideLum>=0.f)
+		return;
 	if (lum > maxLum)
 	{
 		if (oldLum<0)
@@ -657,12 +686,31 @@ void StelSkyDrawer::reportLuminanceInFov(float lum, bool fastAdaptation)
 
 void StelSkyDrawer::preDraw()
 {
+	if (overrideLum>=0.f)
+	{
+		eye->setWorldAdaptationLuminance(overrideLum);
+		return;
+	}
 	eye->setWorldAdaptationLuminance(maxLum);
 	// Re-initialize for next stage
 	oldLum = maxLum;
 	maxLum = 0;
 }
 
+void StelSkyDrawer::setWorldAdaptationLuminanceOverride(float lum)
+{
+	if (lum<0.f)
+	{
+		// Resume the automatic adaptation smoothly from the frozen value
+		if (overrideLum>=0.f)
+			oldLum = overrideLum;
+		overrideLum = -1.f;
+		maxLum = 0.f;
+	}
+	else
+		overrideLum = lum;
+}
+
 
 // Set the parameters so that the stars disappear at about the limit given by the bortle scale
 // See http://en.wikipedia.org/wiki/Bortle_Dark-Sky_Scale
@@ -136,6 +136,20 @@ public:
 	//! To be called before the drawing stage starts
 	void preDraw();
 
+	//! Compute the FOV dependent values (eye input scale, limit magnitude and luminance) for a camera drawn after the
+	//! main view (see StelCore::beginCamera()). The values of the main view are restored by endCamera().
+	//! @param fov the field of view of the camera in degrees
+	void beginCamera(float fov);
+	//! Restore the FOV dependent values of the main view after beginCamera().
+	void endCamera();
+
+	//! Freeze the world adaptation luminance of the eye at lum (in cd/m^2), ignoring the reported luminances.
+	//! This keeps the same exposure over several renderings, e.g. the tiles of a large screenshot.
+	//! @param lum the adaptation luminance, or any negative value to return to the automatic adaptation
+	void setWorldAdaptationLuminanceOverride(float lum);
+	//! @return the frozen world adaptation luminance, or a negative value if the adaptation is automatic
+	float getWorldAdaptationLuminanceOverride() const { return overrideLum; }
+
 	//! Compute the luminance for an extended source with the given surface brightness
 	//! @param sb surface brightness in V magnitude/arcmin^2
 	//! @return the luminance in cd/m^2
@@ -353,6 +367,10 @@ private:
 	//! Compute the current limit luminance by dichotomy
 	float computeLimitLuminance() const;
 
+	//! Update the eye input scale, the point source luminance factor and the limits for the given field of view.
+	//! @param fov the field of view in degrees, clamped to [minAdaptFov, maxAdaptFov]
+	void updateFovDependentValues(float fov);
+
 	//! Get StelSkyDrawer maximum FOV.
 	float getMaxAdaptFov(void) const {return maxAdaptFov;}
 	//! Set StelSkyDrawer maximum FOV.
@@ -458,6 +476,9 @@ private:
 	//! The scaling applied to input luminance before they are converted by the StelToneReproducer
 	float inScale;
 
+	//! The FOV dependent values of the main view saved by beginCamera()
+	float mainEyeInputScale, mainLnfovFactor, mainLimitMagnitude, mainLimitLuminance;
+
 	// Variables used for GL optimization when displaying point sources
 	//! Vertex format for a point source.
 	//! Texture pos is stored in another separately.
@@ -492,6 +513,8 @@ private:
 	float maxLum;
 	//! The previously used world luminance
 	float oldLum;
+	//! The frozen world luminance, negative if the adaptation is automatic
+	float overrideLum;
 
 	//! Big halo texture
 	StelTextureSP texBigHalo;
@@ -31,6 +31,7 @@
 #include "SolarSystem.hpp"
 #include <QDebug>
 
+#include <algorithm>
 #include <cstdio>
 
 StelSkyImageTile::StelSkyImageTile()
@@ -82,29 +83,28 @@ void StelSkyImageTile::draw(StelCore* core, StelPainter& sPainter, float)
 	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 
 	const float limitLuminance = core->getSkyDrawer()->getLimitLuminance();
-	QMultiMap<double, StelSkyImageTile*> result;
-	getTilesToDraw(result, core, prj->getViewportConvexPolygon(0, 0), limitLuminance, true);
+	const float degPerPixel = 1.f/prj->getPixelPerRadAtCenter()*M_180_PIf;
+	tilesToDraw.clear();
+	getTilesToDraw(tilesToDraw, core, prj->getViewportConvexPolygon(0, 0), limitLuminance, degPerPixel, true);
 
 	int numToBeLoaded=0;
-	for (auto* t : result)
-		if (t->isReadyToDisplay()==false)
+	for (const auto& t : tilesToDraw)
+		if (t.second->isReadyToDisplay()==false)
 			++numToBeLoaded;
-	updatePercent(result.size(), numToBeLoaded);
+	updatePercent(tilesToDraw.size(), numToBeLoaded);
 
-	// Draw in the good order
+	// Draw in the good order, i.e. from the lowest to the highest resolution. The list is in tree order,
+	// so it is already almost sorted and the sort keeps the parents before their children.
+	std::stable_sort(tilesToDraw.begin(), tilesToDraw.end(), [](const QPair<float, StelSkyImageTile*>& a, const QPair<float, StelSkyImageTile*>& b) {return a.first>b.first;});
 	sPainter.setBlending(true, GL_ONE, GL_ONE);
-	auto i = result.end();
-	while (i!=result.begin())
-	{
-		--i;
-		i.value()->drawTile(core, sPainter);
-	}
+	for (const auto& t : tilesToDraw)
+		t.second->drawTile(core, sPainter);
 
 	deleteUnusedSubTiles();
 }
 
 // Return the list of tiles which should be drawn.
-void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& result, StelCore* core, const SphericalRegionP& viewPortPoly, float limitLuminance, bool recheckIntersect)
+void StelSkyImageTile::getTilesToDraw(QVector<QPair<float, StelSkyImageTile*> >& result, StelCore* core, const SphericalRegionP& viewPortPoly, float limitLuminance, float degPerPixel, bool recheckIntersect)
 {
 #ifndef NDEBUG
 	// When this method is called, we can assume that:
@@ -115,7 +115,6 @@ void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& resu
 	if (parent!=Q_NULLPTR)
 	{
 		Q_ASSERT(isDeletionScheduled()==false);
-		const double degPerPixel = 1./core->getProjection(StelCore::FrameJ2000)->getPixelPerRadAtCenter()*M_180_PI;
 		Q_ASSERT(degPerPixel<parent->minResolution);
 
 		Q_ASSERT(parent->isDeletionScheduled()==false);
@@ -203,11 +202,10 @@ void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& resu
 		}
 
 		// The tile is in screen and has a texture: every test passed :) The tile will be displayed
-		result.insert(minResolution, this);
+		result.append(qMakePair(minResolution, this));
 	}
 
 	// Check if we reach the resolution limit
-	const float degPerPixel = 1.f/core->getProjection(StelCore::FrameJ2000)->getPixelPerRadAtCenter()*M_180_PIf;
 	if (degPerPixel < minResolution)
 	{
 		if (subTiles.isEmpty() && !subTilesUrls.isEmpty())
@@ -229,7 +227,7 @@ void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& resu
 		// Try to add the subtiles
 		for (auto* tile : subTiles)
 		{
-			qobject_cast<StelSkyImageTile*>(tile)->getTilesToDraw(result, core, viewPortPoly, limitLuminance, !fullInScreen);
+			qobject_cast<StelSkyImageTile*>(tile)->getTilesToDraw(result, core, viewPortPoly, limitLuminance, degPerPixel, !fullInScreen);
 		}
 	}
 	else
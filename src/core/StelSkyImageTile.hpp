@@ -141,8 +141,9 @@ private:
 	void initCtor();
 
 	//! Return the list of tiles which should be drawn.
-	//! @param result a map containing resolution, pointer to the tiles
-	void getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& result, StelCore* core, const SphericalRegionP& viewPortPoly, float limitLuminance, bool recheckIntersect=true);
+	//! @param result a list of pairs of resolution and pointer to the tiles, in tree order
+	//! @param degPerPixel the resolution of the view at its center
+	void getTilesToDraw(QVector<QPair<float, StelSkyImageTile*> >& result, StelCore* core, const SphericalRegionP& viewPortPoly, float limitLuminance, float degPerPixel, bool recheckIntersect=true);
 
 	//! Draw the image on the screen.
 	//! @return true if the tile was actually displayed
@@ -157,6 +158,10 @@ private:
 	// Used for smooth fade in
 	QTimeLine* texFader;
 
+	//! The tiles drawn in the last frame, kept to reuse the allocation and because
+	//! the order changes little from one frame to the next
+	QVector<QPair<float, StelSkyImageTile*> > tilesToDraw;
+
 	QString htmlDescription;
 };
 
@@ -18,6 +18,7 @@
  */
 
 #include "StelSphereGeometry.hpp"
+#include "StelSphericalMOC.hpp"
 #include "StelUtils.hpp"
 #include "StelJsonParser.hpp"
 
@@ -65,6 +66,9 @@ QDataStream& operator>>(QDataStream& in, SphericalRegionP& region)
 		case SphericalRegion::Point:
 			region = SphericalPoint::deserialize(in);
 			return in;
+		case SphericalRegion::MOC:
+			region = SphericalMOC::deserialize(in);
+			return in;
 		default:
 			Q_ASSERT(0);	// Unknown region type
 	}
@@ -117,6 +121,7 @@ bool SphericalRegion::contains(const SphericalConvexPolygon& r) const {return co
 bool SphericalRegion::contains(const SphericalCap& r) const {return containsDefault(&r);}
 bool SphericalRegion::contains(const SphericalPoint& r) const {return contains(r.n);}
 bool SphericalRegion::contains(const AllSkySphericalRegion& r) const {return containsDefault(&r);}
+bool SphericalRegion::contains(const SphericalMOC& r) const {return r.isInside(this);}
 bool SphericalRegion::contains(const SphericalRegion* r) const
 {
 	switch (r->getType())
@@ -131,6 +136,8 @@ bool SphericalRegion::contains(const SphericalRegion* r) const
 			return contains(*static_cast<const SphericalConvexPolygon*>(r));
 		case SphericalRegion::AllSky:
 			return contains(*static_cast<const AllSkySphericalRegion*>(r));
+		case SphericalRegion::MOC:
+			return contains(*static_cast<const SphericalMOC*>(r));
 		case SphericalRegion::Empty:
 			return false;
 		default:
@@ -145,6 +152,7 @@ bool SphericalRegion::intersects(const SphericalConvexPolygon& r) const {return
 bool SphericalRegion::intersects(const SphericalCap& r) const {return intersectsDefault(&r);}
 bool SphericalRegion::intersects(const SphericalPoint& r) const {return contains(r.n);}
 bool SphericalRegion::intersects(const AllSkySphericalRegion&) const {return getType()==SphericalRegion::Empty ? false : true;}
+bool SphericalRegion::intersects(const SphericalMOC& r) const {return r.intersects(this);}
 bool SphericalRegion::intersects(const SphericalRegion* r) const
 {
 	switch (r->getType())
@@ -159,6 +167,8 @@ bool SphericalRegion::intersects(const SphericalRegion* r) const
 			return intersects(*static_cast<const SphericalConvexPolygon*>(r));
 		case SphericalRegion::AllSky:
 			return intersects(*static_cast<const AllSkySphericalRegion*>(r));
+		case SphericalRegion::MOC:
+			return intersects(*static_cast<const SphericalMOC*>(r));
 		case SphericalRegion::Empty:
 			return false;
 		default:
@@ -182,6 +192,8 @@ SphericalRegionP SphericalRegion::getIntersection(const SphericalRegion* r) cons
 			return getIntersection(*static_cast<const SphericalConvexPolygon*>(r));
 		case SphericalRegion::AllSky:
 			return getIntersection(*static_cast<const AllSkySphericalRegion*>(r));
+		case SphericalRegion::MOC:
+			return getIntersection(*static_cast<const SphericalMOC*>(r));
 		case SphericalRegion::Empty:
 			return EmptySphericalRegion::staticInstance;
 		default:
@@ -195,6 +207,7 @@ SphericalRegionP SphericalRegion::getIntersection(const SphericalConvexPolygon&
 SphericalRegionP SphericalRegion::getIntersection(const SphericalCap& r) const {return getIntersectionDefault(&r);}
 SphericalRegionP SphericalRegion::getIntersection(const SphericalPoint& r) const {return getIntersectionDefault(&r);}
 SphericalRegionP SphericalRegion::getIntersection(const AllSkySphericalRegion& r) const {return getIntersectionDefault(&r);}
+SphericalRegionP SphericalRegion::getIntersection(const SphericalMOC& r) const {return r.getIntersection(this);}
 SphericalRegionP SphericalRegion::getIntersection(const EmptySphericalRegion&) const {return SphericalRegionP(new EmptySphericalRegion());}
 
 SphericalRegionP SphericalRegion::getUnion(const SphericalRegion* r) const
@@ -211,6 +224,8 @@ SphericalRegionP SphericalRegion::getUnion(const SphericalRegion* r) const
 			return getUnion(*static_cast<const SphericalConvexPolygon*>(r));
 		case SphericalRegion::AllSky:
 			return getUnion(*static_cast<const AllSkySphericalRegion*>(r));
+		case SphericalRegion::MOC:
+			return getUnion(*static_cast<const SphericalMOC*>(r));
 		case SphericalRegion::Empty:
 			return getUnion(*static_cast<const EmptySphericalRegion*>(r));
 		default:
@@ -225,6 +240,7 @@ SphericalRegionP SphericalRegion::getUnion(const SphericalCap& r) const {return
 SphericalRegionP SphericalRegion::getUnion(const SphericalPoint& r) const {return getUnionDefault(&r);}
 SphericalRegionP SphericalRegion::getUnion(const AllSkySphericalRegion&) const {return SphericalRegionP(new AllSkySphericalRegion());}
 SphericalRegionP SphericalRegion::getUnion(const EmptySphericalRegion& r) const {return getUnionDefault(&r);}
+SphericalRegionP SphericalRegion::getUnion(const SphericalMOC& r) const {return r.getUnion(this);}
 
 
 SphericalRegionP SphericalRegion::getSubtraction(const SphericalRegion* r) const
@@ -241,6 +257,8 @@ SphericalRegionP SphericalRegion::getSubtraction(const SphericalRegion* r) const
 			return getSubtraction(*static_cast<const SphericalConvexPolygon*>(r));
 		case SphericalRegion::AllSky:
 			return getSubtraction(*static_cast<const AllSkySphericalRegion*>(r));
+		case SphericalRegion::MOC:
+			return getSubtraction(*static_cast<const SphericalMOC*>(r));
 		case SphericalRegion::Empty:
 			return getSubtraction(*static_cast<const EmptySphericalRegion*>(r));
 		default:
@@ -255,13 +273,15 @@ SphericalRegionP SphericalRegion::getSubtraction(const SphericalCap& r) const {r
 SphericalRegionP SphericalRegion::getSubtraction(const SphericalPoint& r) const {return getSubtractionDefault(&r);}
 SphericalRegionP SphericalRegion::getSubtraction(const AllSkySphericalRegion&) const {return SphericalRegionP(new EmptySphericalRegion());}
 SphericalRegionP SphericalRegion::getSubtraction(const EmptySphericalRegion& r) const {return getSubtractionDefault(&r);}
+// The region is first covered by a MOC of the same order
+SphericalRegionP SphericalRegion::getSubtraction(const SphericalMOC& r) const {return SphericalMOC(this, r.getOrder()).getSubtraction(r);}
 
 // Returns whether another SphericalPolygon intersects with the SphericalPolygon.
 bool SphericalRegion::containsDefault(const SphericalRegion* r) const
 {
 	if (!getBoundingCap().contains(r->getBoundingCap()))
 		return false;
-	return getOctahedronPolygon().contains(r->getOctahedronPolygon());
+	return getConvexPolygonSet().contains(r->getConvexPolygonSet());
 }
 
 // Returns whether another SphericalPolygon intersects with the SphericalPolygon.
@@ -269,7 +289,7 @@ bool SphericalRegion::intersectsDefault(const SphericalRegion* r) const
 {
 	if (!getBoundingCap().intersects(r->getBoundingCap()))
 		return false;
-	return getOctahedronPolygon().intersects(r->getOctahedronPolygon());
+	return getConvexPolygonSet().intersects(r->getConvexPolygonSet());
 }
 
 // Return a new SphericalPolygon consisting of the intersection of this and the given SphericalPolygon.
@@ -277,25 +297,25 @@ SphericalRegionP SphericalRegion::getIntersectionDefault(const SphericalRegion*
 {
 	if (!getBoundingCap().intersects(r->getBoundingCap()))
 		return SphericalRegionP(new EmptySphericalRegion());
-	OctahedronPolygon resOct(getOctahedronPolygon());
-	resOct.inPlaceIntersection(r->getOctahedronPolygon());
-	return SphericalRegionP(new SphericalPolygon(resOct));
+	ConvexPolygonSet res(getConvexPolygonSet());
+	res.inPlaceIntersection(r->getConvexPolygonSet());
+	return SphericalRegionP(new SphericalPolygon(res));
 }
 
 // Return a new SphericalPolygon consisting of the union of this and the given SphericalPolygon.
 SphericalRegionP SphericalRegion::getUnionDefault(const SphericalRegion* r) const
 {
-	OctahedronPolygon resOct(getOctahedronPolygon());
-	resOct.inPlaceUnion(r->getOctahedronPolygon());
-	return SphericalRegionP(new SphericalPolygon(resOct));
+	ConvexPolygonSet res(getConvexPolygonSet());
+	res.inPlaceUnion(r->getConvexPolygonSet());
+	return SphericalRegionP(new SphericalPolygon(res));
 }
 
 // Return a new SphericalPolygon consisting of the subtraction of the given SphericalPolygon from this.
 SphericalRegionP SphericalRegion::getSubtractionDefault(const SphericalRegion* r) const
 {
-	OctahedronPolygon resOct(getOctahedronPolygon());
-	resOct.inPlaceSubtraction(r->getOctahedronPolygon());
-	return SphericalRegionP(new SphericalPolygon(resOct));
+	ConvexPolygonSet res(getConvexPolygonSet());
+	res.inPlaceSubtraction(r->getConvexPolygonSet());
+	return SphericalRegionP(new SphericalPolygon(res));
 }
 
 
@@ -610,6 +630,29 @@ OctahedronPolygon SphericalCap::getOctahedronPolygon() const
 	}
 }
 
+ConvexPolygonSet SphericalCap::getConvexPolygonSet() const
+{
+	if (d<0)
+	{
+		ConvexPolygonSet res(SphericalCap(-n, -d).getConvexPolygonSet());
+		res.inPlaceComplement();
+		return res;
+	}
+	// Four quarters joining the outline to the center, so that a hemisphere also gives pieces within one hemisphere
+	const QVector<Vec3d> outline = getClosedOutlineContour();
+	const int quarter = outline.size()/4;
+	QVector<QVector<Vec3d> > contours;
+	for (int i=0;i<4;++i)
+	{
+		QVector<Vec3d> contour;
+		contour << n;
+		for (int j=i*quarter;j<=(i+1)*quarter;++j)
+			contour << outline.at(j%outline.size());
+		contours << contour;
+	}
+	return ConvexPolygonSet(contours);
+}
+
 QVariantList SphericalCap::toQVariant() const
 {
 	QVariantList res;
@@ -701,10 +744,105 @@ QVariantList EmptySphericalRegion::toQVariant() const
 SphericalCap SphericalPolygon::getBoundingCap() const
 {
 	SphericalCap res;
-	octahedronPolygon.getBoundingCap(res.n, res.d);
+	convexPolygonSet.getBoundingCap(res.n, res.d);
 	return res;
 }
 
+SphericalPolygon::SphericalPolygon(const SphericalPolygon& other) : SphericalRegion()
+{
+	QMutexLocker locker(&other.cacheMutex);
+	octahedronPolygon = other.octahedronPolygon;
+	octahedronPolygonValid = other.octahedronPolygonValid;
+	convexPolygonSet = other.convexPolygonSet;
+	fillVertexArray = other.fillVertexArray;
+	fillVertexArrayValid = other.fillVertexArrayValid;
+	outlineVertexArray = other.outlineVertexArray;
+	outlineVertexArrayValid = other.outlineVertexArrayValid;
+}
+
+SphericalPolygon& SphericalPolygon::operator=(const SphericalPolygon& other)
+{
+	if (this==&other)
+		return *this;
+	// Copy under the lock of the other polygon first, so that both mutexes are never held at the same time
+	SphericalPolygon copy(other);
+	QMutexLocker locker(&cacheMutex);
+	octahedronPolygon = copy.octahedronPolygon;
+	octahedronPolygonValid = copy.octahedronPolygonValid;
+	convexPolygonSet = copy.convexPolygonSet;
+	fillVertexArray = copy.fillVertexArray;
+	fillVertexArrayValid = copy.fillVertexArrayValid;
+	outlineVertexArray = copy.outlineVertexArray;
+	outlineVertexArrayValid = copy.outlineVertexArrayValid;
+	return *this;
+}
+
+OctahedronPolygon SphericalPolygon::getOctahedronPolygon() const
+{
+	// The results of boolean operations are only tesselated when needed, e.g. for serialization
+	QMutexLocker locker(&cacheMutex);
+	if (!octahedronPolygonValid)
+	{
+		octahedronPolygon = convexPolygonSet.toOctahedronPolygon();
+		octahedronPolygonValid = true;
+	}
+	return octahedronPolygon;
+}
+
+StelVertexArray SphericalPolygon::getFillVertexArray() const
+{
+	QMutexLocker locker(&cacheMutex);
+	if (!fillVertexArrayValid)
+	{
+		fillVertexArray = convexPolygonSet.getFillVertexArray();
+		fillVertexArrayValid = true;
+	}
+	return fillVertexArray;
+}
+
+StelVertexArray SphericalPolygon::getOutlineVertexArray() const
+{
+	QMutexLocker locker(&cacheMutex);
+	if (!outlineVertexArrayValid)
+	{
+		// Use the tesselation of the contours if there is one, else only tesselate the stored convex polygons:
+		// a complemented set has the same outline, so that it is never subtracted from the full sky.
+		outlineVertexArray = octahedronPolygonValid ? octahedronPolygon.getOutlineVertexArray() : convexPolygonSet.getOutlineVertexArray();
+		outlineVertexArrayValid = true;
+	}
+	return outlineVertexArray;
+}
+
+void SphericalPolygon::setContours(const QVector<QVector<Vec3d> >& contours)
+{
+	// A single convex contour is a convex polygon: no tesselation is needed
+	if (contours.size()==1 && ConvexPolygonSet::isConvexContour(contours.at(0)))
+	{
+		QMutexLocker locker(&cacheMutex);
+		convexPolygonSet = ConvexPolygonSet(contours.at(0));
+		octahedronPolygonValid = false;
+		fillVertexArrayValid = false;
+		outlineVertexArrayValid = false;
+	}
+	else
+		setOctahedronPolygon(OctahedronPolygon(contours));
+}
+
+void SphericalPolygon::setContour(const QVector<Vec3d>& contour)
+{
+	setContours(QVector<QVector<Vec3d> >() << contour);
+}
+
+void SphericalPolygon::setOctahedronPolygon(const OctahedronPolygon& octPoly)
+{
+	QMutexLocker locker(&cacheMutex);
+	octahedronPolygon = octPoly;
+	octahedronPolygonValid = true;
+	convexPolygonSet = ConvexPolygonSet(octahedronPolygon);
+	fillVertexArrayValid = false;
+	outlineVertexArrayValid = false;
+}
+
 struct TriangleSerializer
 {
 	TriangleSerializer(const TriangleSerializer& ts) : triangleList(ts.triangleList) {}
@@ -745,7 +883,7 @@ QVariantList SphericalPolygon::toQVariant() const
 
 void SphericalPolygon::serialize(QDataStream& out) const
 {
-	out << octahedronPolygon;
+	out << getOctahedronPolygon();
 }
 
 SphericalRegionP SphericalPolygon::deserialize(QDataStream& in)
@@ -755,7 +893,7 @@ SphericalRegionP SphericalPolygon::deserialize(QDataStream& in)
 	return SphericalRegionP(new SphericalPolygon(p));
 }
 
-bool SphericalPolygon::contains(const SphericalConvexPolygon& r) const {return octahedronPolygon.contains(r.getOctahedronPolygon());}
+bool SphericalPolygon::contains(const SphericalConvexPolygon& r) const {return convexPolygonSet.contains(r.getConvexPolygonSet());}
 bool SphericalPolygon::intersects(const SphericalConvexPolygon& r) const {return r.intersects(*this);}
 
 SphericalRegionP SphericalPolygon::multiUnion(const QList<SphericalRegionP>& regions, bool optimizeByPreGrouping)
@@ -802,11 +940,11 @@ SphericalRegionP SphericalPolygon::multiUnion(const QList<SphericalRegionP>& reg
 	}
 	else
 	{
-		// Just add all contours to one polygon
-		QList<OctahedronPolygon> l;
+		// Just add all the convex polygons, without intermediate tesselation
+		ConvexPolygonSet res;
 		for (const auto& r : regions)
-			l.append(r->getOctahedronPolygon());
-		return SphericalRegionP(new SphericalPolygon(l));
+			res.inPlaceUnion(r->getConvexPolygonSet());
+		return SphericalRegionP(new SphericalPolygon(res));
 	}
 }
 
@@ -1319,6 +1457,10 @@ SphericalRegionP SphericalRegionP::loadFromQVariant(const QVariantList& l)
 	{
 		return SphericalRegionP(new SphericalConvexPolygon(singleContourFromQVariantList(l.at(1).toList())));
 	}
+	else if (code=="MOC")
+	{
+		return SphericalMOC::loadFromJsonMap(l.at(1).toMap());
+	}
 
 	Q_ASSERT(0);
 	return EmptySphericalRegion::staticInstance;
@@ -1326,6 +1468,13 @@ SphericalRegionP SphericalRegionP::loadFromQVariant(const QVariantList& l)
 
 SphericalRegionP SphericalRegionP::loadFromQVariant(const QVariantMap& map)
 {
+	// The keys of a MOC are the HEALPix orders
+	bool isMOC = false;
+	if (!map.isEmpty())
+		map.firstKey().toInt(&isMOC);
+	if (isMOC)
+		return SphericalMOC::loadFromJsonMap(map);
+
 	QVariantList contoursList = map.value("skyConvexPolygons").toList();
 	if (contoursList.empty())
 		contoursList = map.value("worldCoords").toList();
@@ -20,6 +20,7 @@
 #ifndef STELSPHEREGEOMETRY_HPP
 #define STELSPHEREGEOMETRY_HPP
 
+#include "ConvexPolygonSet.hpp"
 #include "OctahedronPolygon.hpp"
 #include "StelVertexArray.hpp"
 #include "VecMath.hpp"
@@ -27,6 +28,7 @@
 #include <QVector>
 #include <QVariant>
 #include <QDebug>
+#include <QMutex>
 #include <QSharedPointer>
 #include <QVarLengthArray>
 #include <QDataStream>
@@ -40,6 +42,7 @@ class SphericalCap;
 class SphericalPoint;
 class AllSkySphericalRegion;
 class EmptySphericalRegion;
+class SphericalMOC;
 
 //! @file StelSphereGeometry.hpp
 //! Define all SphericalGeometry primitives as well as the SphericalRegionP type.
@@ -92,6 +95,9 @@ public:
 	//! The format is used to describe textured polygons. The worldCoords part is similar to the one described above.
 	//! The textureCoords part is the addition of a list of texture coordinates in the u,v texture space (between 0 and 1).
 	//! There must be one texture coordinate for each vertex.</li>
+	//! <li>HEALPix Multi-Order Coverage map, in the IVOA MOC JSON serialization:
+	//! @code{"order": [index, index, ...], "order": [...]}@endcode
+	//! The cells are given by their index in the nested scheme for each order. See SphericalMOC.</li>
 	//! </ul>
 	//! @param in an open QIODevice ready for read.
 	//! @throws std::runtime_error when there was an error while parsing the file.
@@ -142,7 +148,8 @@ public:
 		Polygon = 3,
 		ConvexPolygon = 4,
 		Empty = 5,
-		Invalid = 6
+		MOC = 6,
+		Invalid = 7
 	};
 
 	virtual ~SphericalRegion() {;}
@@ -153,6 +160,11 @@ public:
 	//! It can be used for safe computation of intersection/union in the general case.
 	virtual OctahedronPolygon getOctahedronPolygon() const =0;
 
+	//! Return the representation of the region as a set of disjoint convex polygons.
+	//! It is used for the computation of intersection/union/subtraction without tesselation.
+	//! The default implementation splits the triangles of the OctahedronPolygon.
+	virtual ConvexPolygonSet getConvexPolygonSet() const {return ConvexPolygonSet(getOctahedronPolygon());}
+
 	//! Return the area of the region in steradians.
 	virtual double getArea() const {return getOctahedronPolygon().getArea();}
 
@@ -208,6 +220,7 @@ public:
 	virtual bool contains(const SphericalCap& r) const;
 	virtual bool contains(const SphericalPoint& r) const;
 	virtual bool contains(const AllSkySphericalRegion& r) const;
+	virtual bool contains(const SphericalMOC& r) const;
 	bool contains(const EmptySphericalRegion&) const {return false;}
 
 	//! Returns whether a SphericalRegion intersects with this region.
@@ -220,6 +233,7 @@ public:
 	virtual bool intersects(const SphericalCap& r) const;
 	virtual bool intersects(const SphericalPoint& r) const;
 	virtual bool intersects(const AllSkySphericalRegion& r) const;
+	virtual bool intersects(const SphericalMOC& r) const;
 	bool intersects(const EmptySphericalRegion&) const {return false;}
 
 	//! Return a new SphericalRegion consisting of the intersection of this and the given region.
@@ -231,6 +245,7 @@ public:
 	virtual SphericalRegionP getIntersection(const SphericalCap& r) const;
 	virtual SphericalRegionP getIntersection(const SphericalPoint& r) const;
 	virtual SphericalRegionP getIntersection(const AllSkySphericalRegion& r) const;
+	virtual SphericalRegionP getIntersection(const SphericalMOC& r) const;
 	SphericalRegionP getIntersection(const EmptySphericalRegion& r) const;
 
 	//! Return a new SphericalRegion consisting of the union of this and the given region.
@@ -243,6 +258,7 @@ public:
 	virtual SphericalRegionP getUnion(const SphericalPoint& r) const;
 	SphericalRegionP getUnion(const AllSkySphericalRegion& r) const;
 	virtual SphericalRegionP getUnion(const EmptySphericalRegion& r) const;
+	virtual SphericalRegionP getUnion(const SphericalMOC& r) const;
 
 	//! Return a new SphericalRegion consisting of the subtraction of the given region from this.
 	//! A default potentially very slow implementation is provided for each cases.
@@ -254,6 +270,7 @@ public:
 	virtual SphericalRegionP getSubtraction(const SphericalPoint& r) const;
 	SphericalRegionP getSubtraction(const AllSkySphericalRegion& r) const;
 	virtual SphericalRegionP getSubtraction(const EmptySphericalRegion& r) const;
+	virtual SphericalRegionP getSubtraction(const SphericalMOC& r) const;
 
 private:
 	bool containsDefault(const SphericalRegion* r) const;
@@ -299,6 +316,8 @@ public:
 
 	virtual SphericalRegionType getType() const {return SphericalRegion::Cap;}
 	virtual OctahedronPolygon getOctahedronPolygon() const;
+	//! The cap is approximated by the polygon of its outline, or by the complement of the opposite cap if it is larger than a hemisphere.
+	virtual ConvexPolygonSet getConvexPolygonSet() const;
 
 	//! Get the area of the intersection of the halfspace on the sphere in steradian.
 	virtual double getArea() const {return 2.*M_PI*(1.-d);}
@@ -474,6 +493,7 @@ public:
 
 	virtual SphericalRegionType getType() const {return SphericalRegion::AllSky;}
 	virtual OctahedronPolygon getOctahedronPolygon() const {return OctahedronPolygon::getAllSkyOctahedronPolygon();}
+	virtual ConvexPolygonSet getConvexPolygonSet() const {return ConvexPolygonSet::allSky();}
 	virtual double getArea() const {return 4.*M_PI;}
 	virtual bool isEmpty() const {return false;}
 	virtual Vec3d getPointInside() const {return Vec3d(1,0,0);}
@@ -516,6 +536,7 @@ public:
 
 	virtual SphericalRegionType getType() const {return SphericalRegion::Empty;}
 	virtual OctahedronPolygon getOctahedronPolygon() const {return OctahedronPolygon::getEmptyOctahedronPolygon();}
+	virtual ConvexPolygonSet getConvexPolygonSet() const {return ConvexPolygonSet();}
 	virtual double getArea() const {return 0.;}
 	virtual bool isEmpty() const {return true;}
 	virtual Vec3d getPointInside() const {return Vec3d(1,0,0);}
@@ -544,7 +565,10 @@ public:
 
 //! @class SphericalPolygon
 //! Class defining default implementations for some spherical geometry methods.
-//! All methods are reentrant.
+//! The polygon is stored as a set of disjoint convex polygons (ConvexPolygonSet), on which the boolean operations are computed.
+//! A single convex contour is used as it is. Other contours are tesselated once in an OctahedronPolygon when the polygon
+//! is created, and the results of boolean operations are only tesselated on demand, for the outline and for serialization.
+//! All methods are reentrant, and const methods are thread safe: the lazily computed data are guarded by a mutex.
 class SphericalPolygon : public SphericalRegion
 {
 public:
@@ -555,16 +579,29 @@ public:
 	using SphericalRegion::getUnion;
 	using SphericalRegion::getSubtraction;
 
-	SphericalPolygon() {;}
+	SphericalPolygon() : octahedronPolygonValid(true), fillVertexArrayValid(false), outlineVertexArrayValid(false) {;}
 	//! Constructor from a list of contours.
-	SphericalPolygon(const QVector<QVector<Vec3d> >& contours) : octahedronPolygon(contours) {;}
+	SphericalPolygon(const QVector<QVector<Vec3d> >& contours) : octahedronPolygonValid(false), fillVertexArrayValid(false), outlineVertexArrayValid(false) {setContours(contours);}
 	//! Constructor from one contour.
-	SphericalPolygon(const QVector<Vec3d>& contour) : octahedronPolygon(contour) {;}
-	SphericalPolygon(const OctahedronPolygon& octContour) : octahedronPolygon(octContour) {;}
-	SphericalPolygon(const QList<OctahedronPolygon>& octContours) : octahedronPolygon(octContours) {;}
+	SphericalPolygon(const QVector<Vec3d>& contour) : octahedronPolygonValid(false), fillVertexArrayValid(false), outlineVertexArrayValid(false) {setContour(contour);}
+	SphericalPolygon(const OctahedronPolygon& octContour) : octahedronPolygon(octContour), octahedronPolygonValid(true), convexPolygonSet(octahedronPolygon), fillVertexArrayValid(false), outlineVertexArrayValid(false) {;}
+	SphericalPolygon(const QList<OctahedronPolygon>& octContours) : octahedronPolygon(octContours), octahedronPolygonValid(true), convexPolygonSet(octahedronPolygon), fillVertexArrayValid(false), outlineVertexArrayValid(false) {;}
+	//! Constructor from the result of boolean operations. The OctahedronPolygon is computed only if needed.
+	SphericalPolygon(const ConvexPolygonSet& polySet) : octahedronPolygonValid(false), convexPolygonSet(polySet), fillVertexArrayValid(false), outlineVertexArrayValid(false) {;}
+	SphericalPolygon(const SphericalPolygon& other);
+	SphericalPolygon& operator=(const SphericalPolygon& other);
 
 	virtual SphericalRegionType getType() const {return SphericalRegion::Polygon;}
-	virtual OctahedronPolygon getOctahedronPolygon() const {return octahedronPolygon;}
+	virtual OctahedronPolygon getOctahedronPolygon() const;
+	virtual ConvexPolygonSet getConvexPolygonSet() const {return convexPolygonSet;}
+
+	virtual double getArea() const {return convexPolygonSet.getArea();}
+	virtual bool isEmpty() const {return convexPolygonSet.isEmpty();}
+	virtual Vec3d getPointInside() const {return convexPolygonSet.getPointInside();}
+	//! Return the triangles of the convex polygons, computed on first use.
+	virtual StelVertexArray getFillVertexArray() const;
+	//! Return the outline of the polygon. For the results of boolean operations, the convex polygons are tesselated on first use.
+	virtual StelVertexArray getOutlineVertexArray() const;
 
 	//! Serialize the region into a QVariant map matching the JSON format.
 	//! The format is:
@@ -575,38 +612,38 @@ public:
 
 	virtual SphericalCap getBoundingCap() const;
 
-	virtual bool contains(const Vec3d& p) const {return octahedronPolygon.contains(p);}
-	virtual bool contains(const SphericalPolygon& r) const {return octahedronPolygon.contains(r.octahedronPolygon);}
+	virtual bool contains(const Vec3d& p) const {return convexPolygonSet.contains(p);}
+	virtual bool contains(const SphericalPolygon& r) const {return convexPolygonSet.contains(r.convexPolygonSet);}
 	virtual bool contains(const SphericalConvexPolygon& r) const;
-	virtual bool contains(const SphericalCap& r) const {return octahedronPolygon.contains(r.getOctahedronPolygon());}
-	virtual bool contains(const SphericalPoint& r) const {return octahedronPolygon.contains(r.n);}
-	virtual bool contains(const AllSkySphericalRegion& r) const {return octahedronPolygon.contains(r.getOctahedronPolygon());}
+	virtual bool contains(const SphericalCap& r) const {return convexPolygonSet.contains(r.getConvexPolygonSet());}
+	virtual bool contains(const SphericalPoint& r) const {return convexPolygonSet.contains(r.n);}
+	virtual bool contains(const AllSkySphericalRegion& r) const {return convexPolygonSet.contains(r.getConvexPolygonSet());}
 
-	virtual bool intersects(const SphericalPolygon& r) const {return octahedronPolygon.intersects(r.octahedronPolygon);}
+	virtual bool intersects(const SphericalPolygon& r) const {return convexPolygonSet.intersects(r.convexPolygonSet);}
 	virtual bool intersects(const SphericalConvexPolygon& r) const;
 	virtual bool intersects(const SphericalCap& r) const {return r.intersects(*this);}
-	virtual bool intersects(const SphericalPoint& r) const {return octahedronPolygon.contains(r.n);}
+	virtual bool intersects(const SphericalPoint& r) const {return convexPolygonSet.contains(r.n);}
 	virtual bool intersects(const AllSkySphericalRegion&) const {return !isEmpty();}
 
 	virtual SphericalRegionP getIntersection(const SphericalPoint& r) const {return contains(r.n) ? SphericalRegionP(new SphericalPoint(r)) : EmptySphericalRegion::staticInstance;}
-	virtual SphericalRegionP getIntersection(const AllSkySphericalRegion& ) const {return SphericalRegionP(new SphericalPolygon(octahedronPolygon));}
+	virtual SphericalRegionP getIntersection(const AllSkySphericalRegion& ) const {return SphericalRegionP(new SphericalPolygon(*this));}
 
-	virtual SphericalRegionP getUnion(const SphericalPoint&) const {return SphericalRegionP(new SphericalPolygon(octahedronPolygon));}
-	virtual SphericalRegionP getUnion(const EmptySphericalRegion&) const {return SphericalRegionP(new SphericalPolygon(octahedronPolygon));}
+	virtual SphericalRegionP getUnion(const SphericalPoint&) const {return SphericalRegionP(new SphericalPolygon(*this));}
+	virtual SphericalRegionP getUnion(const EmptySphericalRegion&) const {return SphericalRegionP(new SphericalPolygon(*this));}
 
-	virtual SphericalRegionP getSubtraction(const SphericalPoint&) const {return SphericalRegionP(new SphericalPolygon(octahedronPolygon));}
-	virtual SphericalRegionP getSubtraction(const EmptySphericalRegion&) const {return SphericalRegionP(new SphericalPolygon(octahedronPolygon));}
+	virtual SphericalRegionP getSubtraction(const SphericalPoint&) const {return SphericalRegionP(new SphericalPolygon(*this));}
+	virtual SphericalRegionP getSubtraction(const EmptySphericalRegion&) const {return SphericalRegionP(new SphericalPolygon(*this));}
 
 	////////////////////////////////////////////////////////////////////
 	// Methods specific to SphericalPolygon
 	//! Set the contours defining the SphericalPolygon.
 	//! @param contours the list of contours defining the polygon area. The contours are combined using
 	//! the positive winding rule, meaning that the polygon is the union of the positive contours minus the negative ones.
-	void setContours(const QVector<QVector<Vec3d> >& contours) {octahedronPolygon = OctahedronPolygon(contours);}
+	void setContours(const QVector<QVector<Vec3d> >& contours);
 
 	//! Set a single contour defining the SphericalPolygon.
 	//! @param contour a contour defining the polygon area.
-	void setContour(const QVector<Vec3d>& contour) {octahedronPolygon = OctahedronPolygon(contour);}
+	void setContour(const QVector<Vec3d>& contour);
 
 	//! Return the list of closed contours defining the polygon boundaries.
 	QVector<QVector<Vec3d> > getClosedOutlineContours() const {Q_ASSERT(0); return QVector<QVector<Vec3d> >();}
@@ -621,7 +658,18 @@ public:
 	static SphericalRegionP multiIntersection(const QList<SphericalRegionP>& regions);
 
 private:
-	OctahedronPolygon octahedronPolygon;
+	void setOctahedronPolygon(const OctahedronPolygon& octPoly);
+
+	// Guards the lazily computed members below, as polygons are shared between threads
+	mutable QMutex cacheMutex;
+	// Only valid if octahedronPolygonValid is true, else computed from convexPolygonSet on demand
+	mutable OctahedronPolygon octahedronPolygon;
+	mutable bool octahedronPolygonValid;
+	ConvexPolygonSet convexPolygonSet;
+	mutable StelVertexArray fillVertexArray;
+	mutable bool fillVertexArrayValid;
+	mutable StelVertexArray outlineVertexArray;
+	mutable bool outlineVertexArrayValid;
 };
 
 
@@ -648,6 +696,7 @@ public:
 
 	virtual SphericalRegionType getType() const {return SphericalRegion::ConvexPolygon;}
 	virtual OctahedronPolygon getOctahedronPolygon() const {return OctahedronPolygon(contour);}
+	virtual ConvexPolygonSet getConvexPolygonSet() const {return ConvexPolygonSet(contour);}
 	virtual StelVertexArray getFillVertexArray() const {return StelVertexArray(contour, StelVertexArray::TriangleFan);}
 	virtual StelVertexArray getOutlineVertexArray() const {return StelVertexArray(contour, StelVertexArray::LineLoop);}
 	virtual double getArea() const;
@@ -20,7 +20,7 @@
 #include "StelSphericalIndex.hpp"
 #include <QVector>
 
-StelSphericalIndex::StelSphericalIndex(int maxObjPerNode, int maxLevel) : maxObjectsPerNode(maxObjPerNode)
+StelSphericalIndex::StelSphericalIndex(int maxObjPerNode, int maxLevel) : maxObjectsPerNode(maxObjPerNode), lock(QReadWriteLock::Recursive)
 {
 	rootNode = new RootNode(maxObjectsPerNode, maxLevel);
 }
@@ -33,7 +33,31 @@ StelSphericalIndex::~StelSphericalIndex()
 void StelSphericalIndex::insert(StelRegionObjectP regObj)
 {
 	NodeElem el(regObj);
+	QWriteLocker locker(&lock);
 	rootNode->insert(el, 0);
 }
 
+void StelSphericalIndex::insert(const QVector<StelRegionObjectP>& objs)
+{
+	// The bounding caps are computed before locking, so that queries are blocked as short as possible
+	QVector<NodeElem> els;
+	els.reserve(objs.size());
+	for (const auto& obj : objs)
+		els.append(NodeElem(obj));
+	QWriteLocker locker(&lock);
+	rootNode->insert(els);
+}
+
+bool StelSphericalIndex::remove(const StelRegionObjectP& regObj)
+{
+	QWriteLocker locker(&lock);
+	return rootNode->remove(regObj.data());
+}
+
+bool StelSphericalIndex::update(const StelRegionObjectP& regObj)
+{
+	QWriteLocker locker(&lock);
+	return rootNode->update(regObj);
+}
+
 
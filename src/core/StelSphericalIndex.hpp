@@ -22,8 +22,21 @@
 
 #include "StelRegionObject.hpp"
 
+#include <QHash>
+#include <QReadWriteLock>
+#include <QVarLengthArray>
+
+#include <cmath>
+#include <queue>
+
 //! @class StelSphericalIndex
 //! Container allowing to store and query SphericalRegion.
+//! Objects can be removed or moved after their insertion, so that the index can also be used for moving objects
+//! like minor bodies or satellites. The location of each object in the tree is remembered, so these operations
+//! don't need to search the tree. An object should therefore be inserted only once in a given index.
+//! All the query methods can be called concurrently from several threads, e.g. during rendering, while the
+//! modifications are serialized with them by an internal read/write lock. The function objects passed to the
+//! process methods must not modify the index.
 class StelSphericalIndex
 {
 public:
@@ -33,39 +46,87 @@ public:
 	//! Insert the given object in the StelSphericalIndex.
 	void insert(StelRegionObjectP obj);
 
+	//! Insert all the given objects in the StelSphericalIndex.
+	//! This is much faster than inserting them one by one for large arrays, because the tree is built top-down
+	//! with each object going down the tree only once, instead of being re-inserted each time a node is split.
+	void insert(const QVector<StelRegionObjectP>& objs);
+
+	//! Remove the given object from the StelSphericalIndex.
+	//! The nodes which have become almost empty are merged back into their parent.
+	//! @return false if the object was not in the index.
+	bool remove(const StelRegionObjectP& obj);
+
+	//! Update the location of the given object in the StelSphericalIndex after its region has changed.
+	//! If the new region still fits in the same node, only the cached bounding cap is updated.
+	//! @return false if the object was not in the index.
+	bool update(const StelRegionObjectP& obj);
+
+	//! Return whether the given object is stored in the StelSphericalIndex.
+	bool contains(const StelRegionObjectP& obj) const
+	{
+		QReadLocker locker(&lock);
+		return rootNode->contains(obj.data());
+	}
+
 	//! Process all the objects intersecting the given region using the passed function object.
 	template<class FuncObject> void processIntersectingRegions(const SphericalRegion* region, FuncObject& func) const
 	{
+		QReadLocker locker(&lock);
 		rootNode->processIntersectingRegions(region, func);
 	}
 
 	//! Process all the objects intersecting the given region using the passed function object.
 	template<class FuncObject> void processIntersectingPointInRegions(const SphericalRegion* region, FuncObject& func) const
 	{
+		QReadLocker locker(&lock);
 		rootNode->processIntersectingPointInRegions(region, func);
 	}
 	
 	//! Process all the objects intersecting the given region using the passed function object.
 	template<class FuncObject> void processBoundingCapIntersectingRegions(const SphericalCap& cap, FuncObject& func) const
 	{
+		QReadLocker locker(&lock);
 		rootNode->processBoundingCapIntersectingRegions(cap, func);
 	}
 	
 	//! Process all the objects contained in the given region using the passed function object.
 	template<class FuncObject> void processContainedRegions(const SphericalRegion* region, FuncObject& func) const
 	{
+		QReadLocker locker(&lock);
 		rootNode->processContainedRegions(region, func);
 	}
 
+	//! Process all the objects whose point in region lies within the given angular distance of a point.
+	//! @param p the normalized center of the search.
+	//! @param radius the maximum angular distance in radian.
+	template<class FuncObject> void processWithinRadius(const Vec3d& p, double radius, FuncObject& func) const
+	{
+		const SphericalCap cap(p, std::cos(radius));
+		processIntersectingPointInRegions(&cap, func);
+	}
+
+	//! Return the k objects whose point in region is the nearest to the given point, sorted by increasing distance.
+	//! The tree is traversed best-first, so that only the nodes which may contain one of the nearest objects are visited.
+	//! @param p the normalized point to search from.
+	//! @param k the maximum number of returned objects.
+	//! @param maxRadius the maximum angular distance in radian of the returned objects.
+	QVector<StelRegionObjectP> findNearest(const Vec3d& p, int k, double maxRadius=M_PI) const
+	{
+		QReadLocker locker(&lock);
+		return rootNode->findNearest(p, k, maxRadius);
+	}
+
 	//! Process all the objects intersecting the given region using the passed function object.
 	template<class FuncObject> void processAll(FuncObject& func) const
 	{
+		QReadLocker locker(&lock);
 		rootNode->processAll(func);
 	}
 
 	//! Remove all the elements in the container.
 	void clear()
 	{
+		QWriteLocker locker(&lock);
 		rootNode->clear();
 	}
 
@@ -144,6 +205,16 @@ private:
 		}
 	};
 
+	//! The location of an element in the tree: the index of the child at each level, on 3 bits per level.
+	struct ElemLocation
+	{
+		ElemLocation(quint64 apath=0, int alevel=0) : path(apath), level(alevel) {;}
+		quint64 path;
+		int level;
+		int childIndex(int l) const {return static_cast<int>((path >> (3*l)) & 7);}
+		ElemLocation child(int i) const {return ElemLocation(path | (static_cast<quint64>(i) << (3*level)), level+1);}
+	};
+
 	//! @class RootNode
 	//! The first Node of a tree. It has a special subdivision of the sphere in an octahedron.
 	class RootNode : public Node
@@ -151,6 +222,8 @@ private:
 		public:
 			RootNode(int amaxObjectsPerNode, int amaxLevel) : maxObjectsPerNode(amaxObjectsPerNode), maxLevel(amaxLevel)
 			{
+				// The location path must fit in 64 bits
+				Q_ASSERT(maxLevel<=21);
 			}
 
 			virtual ~RootNode() {}
@@ -181,7 +254,135 @@ private:
 			//! Insert the given element in the StelSphericalIndex.
 			void insert(const NodeElem& el, int level)
 			{
-				insert(*this, el, level);
+				insert(*this, el, level, ElemLocation());
+			}
+
+			//! Insert the given elements in the StelSphericalIndex, building the tree top-down.
+			void insert(const QVector<NodeElem>& els)
+			{
+				locations.reserve(locations.size() + els.size());
+				bulkInsert(*this, els, ElemLocation());
+			}
+
+			//! Remove the element of the given object from the StelSphericalIndex.
+			bool remove(const StelRegionObject* obj)
+			{
+				if (!locations.contains(obj))
+					return false;
+				const ElemLocation loc = locations.take(obj);
+
+				QVarLengthArray<Node*, 16> nodes;
+				findNodes(loc, nodes);
+				Node* node = nodes.last();
+				for (int i=0;i<node->elements.size();++i)
+				{
+					if (node->elements.at(i).obj.data()==obj)
+					{
+						node->elements.remove(i);
+						break;
+					}
+				}
+
+				// Merge the nodes which became almost empty, going up the tree
+				ElemLocation parentLoc = loc;
+				for (int l=loc.level-1;l>=0;--l)
+				{
+					parentLoc.level = l;
+					parentLoc.path &= (static_cast<quint64>(1) << (3*l)) - 1;
+					if (!merge(*nodes[l], parentLoc))
+						break;
+				}
+				return true;
+			}
+
+			//! Update the element of the given object after its region has changed.
+			bool update(const StelRegionObjectP& obj)
+			{
+				const auto iter = locations.constFind(obj.data());
+				if (iter==locations.constEnd())
+					return false;
+
+				QVarLengthArray<Node*, 16> nodes;
+				findNodes(iter.value(), nodes);
+				Node* node = nodes.last();
+				const SphericalRegionP region = obj->getRegion();
+				// The element can stay in its node if the node still contains it and none of its children does
+				bool stay = node==this || ((SphericalRegion*)&(node->triangle))->contains(region.data());
+				for (int i=0;stay && i<node->children.size();++i)
+					stay = !((SphericalRegion*)&(node->children.at(i).triangle))->contains(region.data());
+				if (stay)
+				{
+					for (auto& el : node->elements)
+					{
+						if (el.obj.data()==obj.data())
+						{
+							el.cap = region->getBoundingCap();
+							break;
+						}
+					}
+					return true;
+				}
+
+				remove(obj.data());
+				insert(NodeElem(obj), 0);
+				return true;
+			}
+
+			//! Return whether the given object is stored in the StelSphericalIndex.
+			bool contains(const StelRegionObject* obj) const
+			{
+				return locations.contains(obj);
+			}
+
+			//! Suppress everything
+			void clear()
+			{
+				Node::clear();
+				locations.clear();
+			}
+
+			//! Return the k nearest objects, searching the nodes by increasing lower bound of their distance.
+			QVector<StelRegionObjectP> findNearest(const Vec3d& p, int k, double maxRadius) const
+			{
+				struct Candidate
+				{
+					double distance;
+					const Node* node;
+					const NodeElem* el;
+					// Reversed, so that the priority queue returns the nearest candidate first
+					bool operator<(const Candidate& other) const {return distance>other.distance;}
+				};
+
+				QVector<StelRegionObjectP> result;
+				std::priority_queue<Candidate> queue;
+				queue.push(Candidate{0., this, Q_NULLPTR});
+				while (!queue.empty() && result.size()<k)
+				{
+					const Candidate c = queue.top();
+					queue.pop();
+					if (c.el)
+					{
+						result.append(c.el->obj);
+						continue;
+					}
+					for (const auto& el : c.node->elements)
+					{
+						const double d = p.angle(el.obj->getPointInRegion());
+						if (d<=maxRadius)
+							queue.push(Candidate{d, Q_NULLPTR, &el});
+					}
+					for (const auto& child : c.node->children)
+					{
+						if (child.elements.isEmpty() && child.children.isEmpty())
+							continue;
+						// The points in the elements of a child are inside its triangle, so inside its bounding cap
+						const SphericalCap& cap = child.triangle.getBoundingCap();
+						const double d = qMax(0., p.angle(cap.n) - cap.getRadius());
+						if (d<=maxRadius)
+							queue.push(Candidate{d, &child, Q_NULLPTR});
+					}
+				}
+				return result;
 			}
 
 			//! Process all the objects intersecting the given region using the passed function object.
@@ -215,11 +416,12 @@ private:
 
 		private:
 			//! Insert the given element in the given node.
-			void insert(Node& node, const NodeElem& el, int level)
+			void insert(Node& node, const NodeElem& el, int level, const ElemLocation& loc)
 			{
 				if (node.children.isEmpty())
 				{
 					node.elements.append(el);
+					locations.insert(el.obj.data(), loc);
 					// If we have too many objects in the node, we split it.
 					if (level<maxLevel && node.elements.size() > maxObjectsPerNode)
 					{
@@ -229,23 +431,100 @@ private:
 						// Re-insert the elements
 						for (QVector<NodeElem>::ConstIterator iter = nodeElems.constBegin();iter != nodeElems.constEnd(); ++iter)
 						{
-							insert(node, *iter, level);
+							insert(node, *iter, level, loc);
 						}
 					}
 					return;
 				}
 
 				// If we have children and one of them contains the element, store it in a sub-level
-				for (auto& child : node.children)
+				for (int i=0;i<node.children.size();++i)
 				{
-					if (((SphericalRegion*)&(child.triangle))->contains(el.obj->getRegion().data()))
+					if (((SphericalRegion*)&(node.children[i].triangle))->contains(el.obj->getRegion().data()))
 					{
-						insert(child, el, level + 1);
+						insert(node.children[i], el, level + 1, loc.child(i));
 						return;
 					}
 				}
 				// Else store it here
 				node.elements.append(el);
+				locations.insert(el.obj.data(), loc);
+			}
+
+			//! Insert the given elements in the given node, splitting it at most once.
+			void bulkInsert(Node& node, QVector<NodeElem> els, const ElemLocation& loc)
+			{
+				if (node.children.isEmpty())
+				{
+					if (loc.level>=maxLevel || node.elements.size() + els.size() <= maxObjectsPerNode)
+					{
+						for (const auto& el : els)
+						{
+							node.elements.append(el);
+							locations.insert(el.obj.data(), loc);
+						}
+						return;
+					}
+					node.split();
+					els += node.elements;
+					node.elements.clear();
+				}
+
+				// Dispatch the elements in the children containing them, and keep the others here
+				QVector<QVector<NodeElem> > childElems(node.children.size());
+				for (const auto& el : els)
+				{
+					const SphericalRegionP region = el.obj->getRegion();
+					int i=0;
+					while (i<node.children.size() && !((SphericalRegion*)&(node.children.at(i).triangle))->contains(region.data()))
+						++i;
+					if (i<node.children.size())
+						childElems[i].append(el);
+					else
+					{
+						node.elements.append(el);
+						locations.insert(el.obj.data(), loc);
+					}
+				}
+				for (int i=0;i<node.children.size();++i)
+				{
+					if (!childElems.at(i).isEmpty())
+						bulkInsert(node.children[i], childElems.at(i), loc.child(i));
+				}
+			}
+
+			//! Fill nodes with the nodes from the root to the node at the given location.
+			void findNodes(const ElemLocation& loc, QVarLengthArray<Node*, 16>& nodes)
+			{
+				nodes.append(this);
+				for (int l=0;l<loc.level;++l)
+					nodes.append(&(nodes.last()->children[loc.childIndex(l)]));
+			}
+
+			//! Move the elements of the children of the given node back into it if they are few enough.
+			//! Half the split threshold is used, so that objects moving around a node boundary don't split and merge it repeatedly.
+			//! @return true if the node was merged.
+			bool merge(Node& node, const ElemLocation& loc)
+			{
+				int nb = node.elements.size();
+				for (const auto& child : node.children)
+				{
+					if (!child.children.isEmpty())
+						return false;
+					nb += child.elements.size();
+				}
+				if (nb > maxObjectsPerNode/2)
+					return false;
+				for (const auto& child : node.children)
+				{
+					for (const auto& el : child.elements)
+					{
+						node.elements.append(el);
+						locations.insert(el.obj.data(), loc);
+					}
+				}
+				node.children.clear();
+				return true;
 			}
 
 			//! Process all the objects intersecting the given region using the passed function object.
@@ -328,12 +607,18 @@ private:
 			int maxObjectsPerNode;
 			//! The maximum level of the grid. Prevents grid split into too small triangles if unecessary.
 			int maxLevel;
+			//! The location in the tree of the element of each object.
+			QHash<const StelRegionObject*, ElemLocation> locations;
 	};
 
 	//! The maximum allowed number of object per node.
 	int maxObjectsPerNode;
 
 	RootNode* rootNode;
+
+	//! Protect the tree, so that it can be queried from several threads while being modified.
+	//! It is recursive so that a query can be made from the function object of another one.
+	mutable QReadWriteLock lock;
 };
 
 #endif // STELSPHERICALINDEX_HPP
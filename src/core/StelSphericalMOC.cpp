@@ -0,0 +1,961 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelSphericalMOC.hpp"
+
+#include <QDebug>
+#include <QIODevice>
+#include <QMap>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Declare functions defined in healpix.c
+extern "C" {
+	void healpix_xy2vec(const double xy[2], double out[3]);
+	void healpix_xyf2xy(int nside, double ix, double iy, int face_num, double out[2]);
+	void healpix_vec2xyf(int nside, const double vec[3], int *ix, int *iy, int *face_num);
+}
+
+const int SphericalMOC::MAX_ORDER;
+const int SphericalMOC::DEFAULT_DRAW_ORDER;
+
+// Number of cells of order 29 on the sphere
+static const quint64 NB_CELLS_MAX_ORDER = Q_UINT64_C(12) << (2*SphericalMOC::MAX_ORDER);
+// The cells of lower order are split before being approximated by the polygon of their corners
+static const int MIN_SHAPE_ORDER = 3;
+// Size of a FITS block [bytes]
+static const int FITS_BLOCK_SIZE = 2880;
+
+// Shift from the cell indices of an order to the indices at MAX_ORDER
+static inline int orderShift(int order)
+{
+	return 2*(SphericalMOC::MAX_ORDER-order);
+}
+
+// Interleave the bits of x with zeros: bit i of x becomes bit 2i of the result
+static inline quint64 spreadBits(quint64 x)
+{
+	x &= Q_UINT64_C(0x00000000FFFFFFFF);
+	x = (x | (x << 16)) & Q_UINT64_C(0x0000FFFF0000FFFF);
+	x = (x | (x << 8)) & Q_UINT64_C(0x00FF00FF00FF00FF);
+	x = (x | (x << 4)) & Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+	x = (x | (x << 2)) & Q_UINT64_C(0x3333333333333333);
+	x = (x | (x << 1)) & Q_UINT64_C(0x5555555555555555);
+	return x;
+}
+
+// Inverse of spreadBits(), the odd bits are ignored
+static inline int compactBits(quint64 x)
+{
+	x &= Q_UINT64_C(0x5555555555555555);
+	x = (x | (x >> 1)) & Q_UINT64_C(0x3333333333333333);
+	x = (x | (x >> 2)) & Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+	x = (x | (x >> 4)) & Q_UINT64_C(0x00FF00FF00FF00FF);
+	x = (x | (x >> 8)) & Q_UINT64_C(0x0000FFFF0000FFFF);
+	x = (x | (x >> 16)) & Q_UINT64_C(0x00000000FFFFFFFF);
+	return static_cast<int>(x);
+}
+
+// Return the point at position (ix+dx, iy+dy) in the face, e.g. dx=dy=0 is the south corner of the cell (ix, iy)
+static Vec3d facePoint(int order, int ix, int iy, int face, double dx, double dy)
+{
+	double xy[2];
+	Vec3d v;
+	healpix_xyf2xy(1 << order, ix+dx, iy+dy, face, xy);
+	healpix_xy2vec(xy, v.v);
+	return v;
+}
+
+static void cellToXyf(int order, quint64 index, int& ix, int& iy, int& face)
+{
+	face = static_cast<int>(index >> (2*order));
+	const quint64 pix = index & ((Q_UINT64_C(1) << (2*order)) - 1);
+	ix = compactBits(pix);
+	iy = compactBits(pix >> 1);
+}
+
+// Return the 4 corners of a cell, in the orientation of SphericalConvexPolygon: south, west, north, east.
+static QVector<Vec3d> cellCorners(int order, quint64 index)
+{
+	int ix, iy, face;
+	cellToXyf(order, index, ix, iy, face);
+	QVector<Vec3d> corners;
+	corners.reserve(4);
+	corners << facePoint(order, ix, iy, face, 0., 0.) << facePoint(order, ix, iy, face, 0., 1.)
+		<< facePoint(order, ix, iy, face, 1., 1.) << facePoint(order, ix, iy, face, 1., 0.);
+	return corners;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Construction
+///////////////////////////////////////////////////////////////////////////////
+SphericalMOC::SphericalMOC(int aorder, const QVector<Range>& aranges)
+	: ranges(aranges), order(qBound(0, aorder, MAX_ORDER)), boundingCapValid(false), fillVertexArrayValid(false), outlineVertexArrayValid(false)
+{
+	normalize();
+}
+
+SphericalMOC::SphericalMOC(const SphericalMOC& other) : SphericalRegion()
+{
+	QMutexLocker locker(&other.cacheMutex);
+	ranges = other.ranges;
+	order = other.order;
+	boundingCap = other.boundingCap;
+	boundingCapValid = other.boundingCapValid;
+	fillVertexArray = other.fillVertexArray;
+	fillVertexArrayValid = other.fillVertexArrayValid;
+	outlineVertexArray = other.outlineVertexArray;
+	outlineVertexArrayValid = other.outlineVertexArrayValid;
+}
+
+SphericalMOC& SphericalMOC::operator=(const SphericalMOC& other)
+{
+	if (this==&other)
+		return *this;
+	// Copy under the lock of the other MOC first, so that both mutexes are never held at the same time
+	SphericalMOC copy(other);
+	QMutexLocker locker(&cacheMutex);
+	ranges = copy.ranges;
+	order = copy.order;
+	boundingCap = copy.boundingCap;
+	boundingCapValid = copy.boundingCapValid;
+	fillVertexArray = copy.fillVertexArray;
+	fillVertexArrayValid = copy.fillVertexArrayValid;
+	outlineVertexArray = copy.outlineVertexArray;
+	outlineVertexArrayValid = copy.outlineVertexArrayValid;
+	return *this;
+}
+
+SphericalMOC::SphericalMOC(const SphericalRegion* region, int aorder, bool inner)
+	: order(qBound(0, aorder, MAX_ORDER)), boundingCapValid(false), fillVertexArrayValid(false), outlineVertexArrayValid(false)
+{
+	switch (region->getType())
+	{
+		case SphericalRegion::Empty:
+			return;
+		case SphericalRegion::AllSky:
+			ranges << Range(0, NB_CELLS_MAX_ORDER);
+			return;
+		case SphericalRegion::MOC:
+		{
+			ranges = static_cast<const SphericalMOC*>(region)->ranges;
+			if (inner)
+			{
+				// Only keep the cells of the new order fully covered by the ranges
+				const quint64 mask = (Q_UINT64_C(1) << orderShift(order)) - 1;
+				for (auto& r : ranges)
+				{
+					r.first = (r.first + mask) & ~mask;
+					r.second = qMax(r.first, r.second & ~mask);
+				}
+			}
+			normalize();
+			return;
+		}
+		default:
+			break;
+	}
+
+	if (region->isEmpty())
+		return;
+	for (quint64 i=0;i<12;++i)
+		addRegionCells(region, 0, i, inner);
+	normalize();
+}
+
+SphericalMOC SphericalMOC::fromNestedCells(int order, const QVector<quint64>& cells)
+{
+	const int shift = orderShift(qBound(0, order, MAX_ORDER));
+	QVector<Range> ranges;
+	ranges.reserve(cells.size());
+	for (auto cell : cells)
+		ranges << Range(cell << shift, (cell+1) << shift);
+	return SphericalMOC(order, ranges);
+}
+
+SphericalMOC SphericalMOC::fromUniqCells(const QVector<quint64>& uniqCells, int order)
+{
+	QVector<Range> ranges;
+	ranges.reserve(uniqCells.size());
+	int maxOrder = 0;
+	for (auto uniq : uniqCells)
+	{
+		// uniq = 4*4^order + index, with index < 12*4^order
+		int cellOrder = 0;
+		while (cellOrder<=MAX_ORDER && uniq>=(Q_UINT64_C(16) << (2*cellOrder)))
+			++cellOrder;
+		if (uniq<4 || cellOrder>MAX_ORDER)
+		{
+			qWarning() << "Invalid MOC cell:" << uniq;
+			continue;
+		}
+		const quint64 index = uniq - (Q_UINT64_C(4) << (2*cellOrder));
+		const int shift = orderShift(cellOrder);
+		ranges << Range(index << shift, (index+1) << shift);
+		maxOrder = qMax(maxOrder, cellOrder);
+	}
+	return SphericalMOC(order<0 ? maxOrder : order, ranges);
+}
+
+void SphericalMOC::normalize()
+{
+	const quint64 mask = (Q_UINT64_C(1) << orderShift(order)) - 1;
+	for (auto& r : ranges)
+	{
+		r.first &= ~mask;
+		r.second = qMin((r.second + mask) & ~mask, NB_CELLS_MAX_ORDER);
+	}
+	std::sort(ranges.begin(), ranges.end());
+
+	int n = 0;
+	for (const auto& r : ranges)
+	{
+		if (r.first>=r.second)
+			continue;
+		if (n>0 && r.first<=ranges.at(n-1).second)
+			ranges[n-1].second = qMax(ranges.at(n-1).second, r.second);
+		else
+			ranges[n++] = r;
+	}
+	ranges.resize(n);
+
+	boundingCapValid = false;
+	fillVertexArrayValid = false;
+	outlineVertexArrayValid = false;
+}
+
+void SphericalMOC::addRegionCells(const SphericalRegion* region, int cellOrder, quint64 index, bool inner)
+{
+	const int shift = orderShift(cellOrder);
+	if (cellOrder>=order)
+	{
+		const CellCoverage coverage = getRegionCellCoverage(region, cellOrder, index);
+		if (coverage==CellInside || (coverage==CellPartial && !inner))
+			ranges << Range(index << shift, (index+1) << shift);
+		return;
+	}
+
+	if (!region->intersects(cellBoundingCap(cellOrder, index)))
+		return;
+	if (cellOrder>=MIN_SHAPE_ORDER)
+	{
+		const SphericalConvexPolygon cell = cellPolygon(cellOrder, index);
+		if (region->contains(cell))
+		{
+			ranges << Range(index << shift, (index+1) << shift);
+			return;
+		}
+		if (!region->intersects(cell))
+			return;
+	}
+	for (quint64 i=0;i<4;++i)
+		addRegionCells(region, cellOrder+1, index*4+i, inner);
+}
+
+SphericalMOC::CellCoverage SphericalMOC::getRegionCellCoverage(const SphericalRegion* region, int cellOrder, quint64 index)
+{
+	if (!region->intersects(cellBoundingCap(cellOrder, index)))
+		return CellOutside;
+	if (cellOrder>=MIN_SHAPE_ORDER)
+	{
+		const SphericalConvexPolygon cell = cellPolygon(cellOrder, index);
+		if (region->contains(cell))
+			return CellInside;
+		return region->intersects(cell) ? CellPartial : CellOutside;
+	}
+
+	// Low order cells are evaluated from their sub-cells
+	int nbInside = 0;
+	int nbOutside = 0;
+	for (quint64 i=0;i<4;++i)
+	{
+		const CellCoverage coverage = getRegionCellCoverage(region, cellOrder+1, index*4+i);
+		if (coverage==CellInside)
+			++nbInside;
+		else if (coverage==CellOutside)
+			++nbOutside;
+	}
+	if (nbInside==4)
+		return CellInside;
+	return nbOutside==4 ? CellOutside : CellPartial;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HEALPix cells
+///////////////////////////////////////////////////////////////////////////////
+quint64 SphericalMOC::cellIndex(int cellOrder, const Vec3d& p)
+{
+	int ix, iy, face;
+	healpix_vec2xyf(1 << cellOrder, p.v, &ix, &iy, &face);
+	return (static_cast<quint64>(face) << (2*cellOrder)) | spreadBits(static_cast<quint64>(ix)) | (spreadBits(static_cast<quint64>(iy)) << 1);
+}
+
+Vec3d SphericalMOC::cellCenter(int cellOrder, quint64 index)
+{
+	int ix, iy, face;
+	cellToXyf(cellOrder, index, ix, iy, face);
+	return facePoint(cellOrder, ix, iy, face, 0.5, 0.5);
+}
+
+SphericalConvexPolygon SphericalMOC::cellPolygon(int cellOrder, quint64 index)
+{
+	return SphericalConvexPolygon(cellCorners(cellOrder, index));
+}
+
+SphericalCap SphericalMOC::cellBoundingCap(int cellOrder, quint64 index)
+{
+	// The corners are the farthest points of a cell from its center, a small margin covers the rounding errors
+	const Vec3d center = cellCenter(cellOrder, index);
+	double d = 1.;
+	for (const auto& corner : cellCorners(cellOrder, index))
+		d = qMin(d, center*corner);
+	return SphericalCap(center, std::cos(qMin(M_PI, std::acos(qBound(-1., d, 1.))*1.01)));
+}
+
+SphericalMOC::CellCoverage SphericalMOC::getCellCoverage(int cellOrder, quint64 index) const
+{
+	const int shift = orderShift(cellOrder);
+	const quint64 first = index << shift;
+	const quint64 last = (index+1) << shift;
+	// First range ending after the start of the cell
+	const auto iter = std::upper_bound(ranges.constBegin(), ranges.constEnd(), first, [](quint64 v, const Range& r) {return v<r.second;});
+	if (iter==ranges.constEnd() || iter->first>=last)
+		return CellOutside;
+	if (iter->first<=first && iter->second>=last)
+		return CellInside;
+	return CellPartial;
+}
+
+QVector<QPair<int, quint64> > SphericalMOC::getCells(const SphericalCap* viewportCap, int maxOrder) const
+{
+	QVector<QPair<int, quint64> > cells;
+	for (quint64 i=0;i<12;++i)
+		getCells(viewportCap, qBound(0, maxOrder, MAX_ORDER), 0, i, cells);
+	return cells;
+}
+
+void SphericalMOC::getCells(const SphericalCap* viewportCap, int maxOrder, int cellOrder, quint64 index, QVector<QPair<int, quint64> >& cells) const
+{
+	const CellCoverage coverage = getCellCoverage(cellOrder, index);
+	if (coverage==CellOutside)
+		return;
+	if (viewportCap && !viewportCap->intersects(cellBoundingCap(cellOrder, index)))
+		return;
+	if (cellOrder>=MIN_SHAPE_ORDER && (coverage==CellInside || cellOrder>=maxOrder))
+	{
+		cells << qMakePair(cellOrder, index);
+		return;
+	}
+	for (quint64 i=0;i<4;++i)
+		getCells(viewportCap, maxOrder, cellOrder+1, index*4+i, cells);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SphericalRegion interface
+///////////////////////////////////////////////////////////////////////////////
+ConvexPolygonSet SphericalMOC::getConvexPolygonSet() const
+{
+	QVector<QVector<Vec3d> > contours;
+	for (const auto& cell : getCells(Q_NULLPTR, order))
+		contours << cellCorners(cell.first, cell.second);
+	return ConvexPolygonSet(contours);
+}
+
+double SphericalMOC::getArea() const
+{
+	// All the cells of an order have the same area
+	quint64 nbCells = 0;
+	for (const auto& r : ranges)
+		nbCells += r.second - r.first;
+	return 4.*M_PI*static_cast<double>(nbCells)/static_cast<double>(NB_CELLS_MAX_ORDER);
+}
+
+Vec3d SphericalMOC::getPointInside() const
+{
+	if (ranges.isEmpty())
+		return Vec3d(1,0,0);
+	return cellCenter(order, ranges.first().first >> orderShift(order));
+}
+
+SphericalCap SphericalMOC::getBoundingCap() const
+{
+	QMutexLocker locker(&cacheMutex);
+	if (boundingCapValid)
+		return boundingCap;
+	boundingCapValid = true;
+	if (ranges.isEmpty())
+	{
+		boundingCap = SphericalCap(Vec3d(1,0,0), 2);
+		return boundingCap;
+	}
+
+	// Use the cells up to order 6 (about 1 deg): the cap is slightly larger than the smallest one, but fast to compute
+	const QVector<QPair<int, quint64> > cells = getCells(Q_NULLPTR, 6);
+	Vec3d n(0.);
+	for (const auto& cell : cells)
+		n += cellCenter(cell.first, cell.second)*std::ldexp(1., -2*cell.first);
+	if (n.lengthSquared()<1e-20)
+	{
+		boundingCap = SphericalCap(Vec3d(1,0,0), -1.);
+		return boundingCap;
+	}
+	n.normalize();
+	double radius = 0.;
+	for (const auto& cell : cells)
+	{
+		const SphericalCap cellCap = cellBoundingCap(cell.first, cell.second);
+		radius = qMax(radius, n.angle(cellCap.n)+std::acos(qBound(-1., cellCap.d, 1.)));
+	}
+	boundingCap = SphericalCap(n, radius>=M_PI ? -1. : std::cos(radius));
+	return boundingCap;
+}
+
+StelVertexArray SphericalMOC::getFillVertexArray() const
+{
+	QMutexLocker locker(&cacheMutex);
+	if (!fillVertexArrayValid)
+	{
+		fillVertexArray = computeFillVertexArray(getCells(Q_NULLPTR, qMin(order, DEFAULT_DRAW_ORDER)));
+		fillVertexArrayValid = true;
+	}
+	return fillVertexArray;
+}
+
+StelVertexArray SphericalMOC::getOutlineVertexArray() const
+{
+	QMutexLocker locker(&cacheMutex);
+	if (!outlineVertexArrayValid)
+	{
+		const int drawOrder = qMin(order, DEFAULT_DRAW_ORDER);
+		outlineVertexArray = computeOutlineVertexArray(getCells(Q_NULLPTR, drawOrder), drawOrder);
+		outlineVertexArrayValid = true;
+	}
+	return outlineVertexArray;
+}
+
+StelVertexArray SphericalMOC::getFillVertexArray(const SphericalCap& viewportCap, int drawOrder) const
+{
+	drawOrder = qMin(order, drawOrder);
+	return computeFillVertexArray(getCells(&viewportCap, drawOrder));
+}
+
+StelVertexArray SphericalMOC::getOutlineVertexArray(const SphericalCap& viewportCap, int drawOrder) const
+{
+	drawOrder = qMin(order, drawOrder);
+	return computeOutlineVertexArray(getCells(&viewportCap, drawOrder), drawOrder);
+}
+
+StelVertexArray SphericalMOC::computeFillVertexArray(const QVector<QPair<int, quint64> >& cells) const
+{
+	StelVertexArray res(StelVertexArray::Triangles);
+	res.vertex.reserve(cells.size()*6);
+	for (const auto& cell : cells)
+	{
+		const QVector<Vec3d> c = cellCorners(cell.first, cell.second);
+		res.vertex << c.at(0) << c.at(1) << c.at(2) << c.at(0) << c.at(2) << c.at(3);
+	}
+	return res;
+}
+
+StelVertexArray SphericalMOC::computeOutlineVertexArray(const QVector<QPair<int, quint64> >& cells, int maxOrder) const
+{
+	// The sides of the drawn cells whose neighbour is not drawn, i.e. not covered by the MOC degraded to the draw order
+	const SphericalMOC degraded = getDegraded(maxOrder);
+	StelVertexArray res(StelVertexArray::Lines);
+	for (const auto& cell : cells)
+	{
+		const QVector<Vec3d> c = cellCorners(cell.first, cell.second);
+		const Vec3d center = cellCenter(cell.first, cell.second);
+		for (int i=0;i<4;++i)
+		{
+			const Vec3d& v1 = c.at(i);
+			const Vec3d& v2 = c.at((i+1)%4);
+			Vec3d middle = v1+v2;
+			middle.normalize();
+			Vec3d outside = middle + (middle-center)*0.05;
+			outside.normalize();
+			if (!degraded.contains(outside))
+				res.vertex << v1 << v2;
+		}
+	}
+	return res;
+}
+
+QVariantList SphericalMOC::toQVariant() const
+{
+	QVariantList res;
+	res << "MOC" << toJsonMap();
+	return res;
+}
+
+bool SphericalMOC::contains(const Vec3d& p) const
+{
+	if (ranges.isEmpty())
+		return false;
+	const quint64 index = cellIndex(MAX_ORDER, p);
+	const auto iter = std::upper_bound(ranges.constBegin(), ranges.constEnd(), index, [](quint64 v, const Range& r) {return v<r.second;});
+	return iter!=ranges.constEnd() && iter->first<=index;
+}
+
+bool SphericalMOC::contains(const AllSkySphericalRegion&) const
+{
+	return ranges.size()==1 && ranges.first().first==0 && ranges.first().second==NB_CELLS_MAX_ORDER;
+}
+
+bool SphericalMOC::contains(const SphericalMOC& r) const
+{
+	if (r.isEmpty())
+		return false;
+	for (const auto& range : r.ranges)
+	{
+		const auto iter = std::upper_bound(ranges.constBegin(), ranges.constEnd(), range.first, [](quint64 v, const Range& rr) {return v<rr.second;});
+		if (iter==ranges.constEnd() || iter->first>range.first || iter->second<range.second)
+			return false;
+	}
+	return true;
+}
+
+bool SphericalMOC::intersects(const SphericalMOC& r) const
+{
+	int i=0, j=0;
+	while (i<ranges.size() && j<r.ranges.size())
+	{
+		if (qMax(ranges.at(i).first, r.ranges.at(j).first)<qMin(ranges.at(i).second, r.ranges.at(j).second))
+			return true;
+		if (ranges.at(i).second<r.ranges.at(j).second)
+			++i;
+		else
+			++j;
+	}
+	return false;
+}
+
+bool SphericalMOC::containsRegion(const SphericalRegion* region) const
+{
+	if (ranges.isEmpty() || region->isEmpty())
+		return false;
+	if (!getBoundingCap().intersects(region->getBoundingCap()))
+		return false;
+	for (quint64 i=0;i<12;++i)
+	{
+		if (!containsRegion(region, 0, i))
+			return false;
+	}
+	return true;
+}
+
+bool SphericalMOC::containsRegion(const SphericalRegion* region, int cellOrder, quint64 index) const
+{
+	const CellCoverage coverage = getCellCoverage(cellOrder, index);
+	if (coverage==CellInside)
+		return true;
+	if (!region->intersects(cellBoundingCap(cellOrder, index)))
+		return true;
+	if (coverage==CellOutside && cellOrder>=MIN_SHAPE_ORDER)
+		return !region->intersects(cellPolygon(cellOrder, index));
+	for (quint64 i=0;i<4;++i)
+	{
+		if (!containsRegion(region, cellOrder+1, index*4+i))
+			return false;
+	}
+	return true;
+}
+
+bool SphericalMOC::intersectsRegion(const SphericalRegion* region) const
+{
+	if (ranges.isEmpty() || region->isEmpty())
+		return false;
+	if (!getBoundingCap().intersects(region->getBoundingCap()))
+		return false;
+	for (quint64 i=0;i<12;++i)
+	{
+		if (intersectsRegion(region, 0, i))
+			return true;
+	}
+	return false;
+}
+
+bool SphericalMOC::intersectsRegion(const SphericalRegion* region, int cellOrder, quint64 index) const
+{
+	const CellCoverage coverage = getCellCoverage(cellOrder, index);
+	if (coverage==CellOutside)
+		return false;
+	if (!region->intersects(cellBoundingCap(cellOrder, index)))
+		return false;
+	if (coverage==CellInside && cellOrder>=MIN_SHAPE_ORDER)
+		return region->intersects(cellPolygon(cellOrder, index));
+	for (quint64 i=0;i<4;++i)
+	{
+		if (intersectsRegion(region, cellOrder+1, index*4+i))
+			return true;
+	}
+	return false;
+}
+
+bool SphericalMOC::isInside(const SphericalRegion* region) const
+{
+	if (ranges.isEmpty())
+		return false;
+	const SphericalCap& cap = getBoundingCap();
+	if (region->contains(cap))
+		return true;
+	if (!region->intersects(cap))
+		return false;
+	for (const auto& cell : getCells(Q_NULLPTR, order))
+	{
+		if (!region->contains(cellPolygon(cell.first, cell.second)))
+			return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Boolean operations
+///////////////////////////////////////////////////////////////////////////////
+SphericalRegionP SphericalMOC::getIntersection(const SphericalPoint& r) const
+{
+	if (contains(r.n))
+		return SphericalRegionP(new SphericalPoint(r));
+	return EmptySphericalRegion::staticInstance;
+}
+
+SphericalRegionP SphericalMOC::getIntersection(const SphericalMOC& r) const
+{
+	QVector<Range> res;
+	int i=0, j=0;
+	while (i<ranges.size() && j<r.ranges.size())
+	{
+		const quint64 first = qMax(ranges.at(i).first, r.ranges.at(j).first);
+		const quint64 last = qMin(ranges.at(i).second, r.ranges.at(j).second);
+		if (first<last)
+			res << Range(first, last);
+		if (ranges.at(i).second<r.ranges.at(j).second)
+			++i;
+		else
+			++j;
+	}
+	return SphericalRegionP(new SphericalMOC(qMax(order, r.order), res));
+}
+
+SphericalRegionP SphericalMOC::getUnion(const SphericalMOC& r) const
+{
+	return SphericalRegionP(new SphericalMOC(qMax(order, r.order), ranges + r.ranges));
+}
+
+SphericalRegionP SphericalMOC::getSubtraction(const SphericalMOC& r) const
+{
+	QVector<Range> res;
+	int j=0;
+	for (const auto& range : ranges)
+	{
+		quint64 first = range.first;
+		while (j<r.ranges.size() && r.ranges.at(j).second<=first)
+			++j;
+		for (int k=j;k<r.ranges.size() && r.ranges.at(k).first<range.second;++k)
+		{
+			if (r.ranges.at(k).first>first)
+				res << Range(first, r.ranges.at(k).first);
+			first = qMax(first, r.ranges.at(k).second);
+		}
+		if (first<range.second)
+			res << Range(first, range.second);
+	}
+	return SphericalRegionP(new SphericalMOC(qMax(order, r.order), res));
+}
+
+SphericalMOC SphericalMOC::getComplement() const
+{
+	QVector<Range> res;
+	quint64 first = 0;
+	for (const auto& range : ranges)
+	{
+		if (range.first>first)
+			res << Range(first, range.first);
+		first = range.second;
+	}
+	if (first<NB_CELLS_MAX_ORDER)
+		res << Range(first, NB_CELLS_MAX_ORDER);
+	return SphericalMOC(order, res);
+}
+
+SphericalMOC SphericalMOC::getDegraded(int newOrder) const
+{
+	if (newOrder>=order)
+		return *this;
+	return SphericalMOC(newOrder, ranges);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Cells lists
+///////////////////////////////////////////////////////////////////////////////
+quint64 SphericalMOC::getCellsCount(int cellsOrder) const
+{
+	const int shift = orderShift(qBound(0, cellsOrder, MAX_ORDER));
+	quint64 count = 0;
+	quint64 lastCell = 0;
+	bool hasLastCell = false;
+	for (const auto& r : ranges)
+	{
+		quint64 firstCell = r.first >> shift;
+		if (hasLastCell && firstCell==lastCell)
+			++firstCell;
+		lastCell = (r.second-1) >> shift;
+		hasLastCell = true;
+		if (lastCell>=firstCell)
+			count += lastCell-firstCell+1;
+	}
+	return count;
+}
+
+QVector<quint64> SphericalMOC::getUniqCells() const
+{
+	QVector<quint64> res;
+	for (const auto& r : ranges)
+	{
+		quint64 first = r.first;
+		while (first<r.second)
+		{
+			// Largest cell starting at first and fitting in the range
+			int cellOrder = 0;
+			while (cellOrder<MAX_ORDER)
+			{
+				const quint64 size = Q_UINT64_C(1) << orderShift(cellOrder);
+				if ((first & (size-1))==0 && first+size<=r.second)
+					break;
+				++cellOrder;
+			}
+			res << (Q_UINT64_C(4) << (2*cellOrder)) + (first >> orderShift(cellOrder));
+			first += Q_UINT64_C(1) << orderShift(cellOrder);
+		}
+	}
+	std::sort(res.begin(), res.end());
+	return res;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Serialization
+///////////////////////////////////////////////////////////////////////////////
+SphericalRegionP SphericalMOC::deserialize(QDataStream& in)
+{
+	qint32 order;
+	QVector<Range> ranges;
+	in >> order >> ranges;
+	return SphericalRegionP(new SphericalMOC(order, ranges));
+}
+
+QVariantMap SphericalMOC::toJsonMap() const
+{
+	QMap<int, QVariantList> cellsPerOrder;
+	for (auto uniq : getUniqCells())
+	{
+		int cellOrder = 0;
+		while (uniq>=(Q_UINT64_C(16) << (2*cellOrder)))
+			++cellOrder;
+		cellsPerOrder[cellOrder] << uniq - (Q_UINT64_C(4) << (2*cellOrder));
+	}
+	// An empty list for the order of the MOC, if it has no cell of this order
+	if (!cellsPerOrder.contains(order))
+		cellsPerOrder[order] = QVariantList();
+
+	QVariantMap res;
+	for (auto iter=cellsPerOrder.constBegin();iter!=cellsPerOrder.constEnd();++iter)
+		res.insert(QString::number(iter.key()), iter.value());
+	return res;
+}
+
+SphericalRegionP SphericalMOC::loadFromJsonMap(const QVariantMap& map)
+{
+	QVector<Range> ranges;
+	int maxOrder = 0;
+	bool ok;
+	for (auto iter=map.constBegin();iter!=map.constEnd();++iter)
+	{
+		const int cellOrder = iter.key().toInt(&ok);
+		if (!ok || cellOrder<0 || cellOrder>MAX_ORDER)
+			throw std::runtime_error(qPrintable(QString("invalid MOC order: \"%1\" (expect an integer between 0 and %2)").arg(iter.key()).arg(MAX_ORDER)));
+		maxOrder = qMax(maxOrder, cellOrder);
+		const int shift = orderShift(cellOrder);
+		for (const auto& v : iter.value().toList())
+		{
+			const quint64 index = v.toULongLong(&ok);
+			if (!ok || index>=(Q_UINT64_C(12) << (2*cellOrder)))
+				throw std::runtime_error(qPrintable(QString("invalid MOC cell index: \"%1\" for order %2").arg(v.toString()).arg(cellOrder)));
+			ranges << Range(index << shift, (index+1) << shift);
+		}
+	}
+	return SphericalRegionP(new SphericalMOC(maxOrder, ranges));
+}
+
+// Return a FITS header card, the value being already formatted
+static QByteArray fitsCard(const char* key, const QString& value)
+{
+	return QString("%1= %2").arg(QString(key), -8).arg(value).leftJustified(80, ' ', true).toLatin1();
+}
+
+static QByteArray fitsCard(const char* key, qint64 value)
+{
+	return fitsCard(key, QString::number(value).rightJustified(20));
+}
+
+static QByteArray fitsStringCard(const char* key, const QString& value)
+{
+	return fitsCard(key, QString("'%1'").arg(value, -8));
+}
+
+// Pad the data to a multiple of the FITS block size
+static void fitsPad(QByteArray& data, char c)
+{
+	if (data.size()%FITS_BLOCK_SIZE)
+		data.append(QByteArray(FITS_BLOCK_SIZE-data.size()%FITS_BLOCK_SIZE, c));
+}
+
+// Read a FITS header and return its keywords and values, without the quotes and the comments
+static QMap<QString, QString> readFitsHeader(QIODevice* in)
+{
+	QMap<QString, QString> res;
+	while (true)
+	{
+		const QByteArray block = in->read(FITS_BLOCK_SIZE);
+		if (block.size()!=FITS_BLOCK_SIZE)
+			throw std::runtime_error("unexpected end of the FITS file");
+		for (int i=0;i<FITS_BLOCK_SIZE;i+=80)
+		{
+			const QString card = QString::fromLatin1(block.mid(i, 80));
+			const QString key = card.left(8).trimmed();
+			if (key=="END")
+				return res;
+			if (card.mid(8, 2)!="= ")
+				continue;
+			QString value = card.mid(10).trimmed();
+			if (value.startsWith('\''))
+				value = value.mid(1, value.indexOf('\'', 1)-1).trimmed();
+			else
+				value = value.section('/', 0, 0).trimmed();
+			res.insert(key, value);
+		}
+	}
+}
+
+SphericalRegionP SphericalMOC::loadFromFits(QIODevice* in)
+{
+	// Primary HDU, normally without data
+	QMap<QString, QString> header = readFitsHeader(in);
+	if (header.value("SIMPLE")!="T")
+		throw std::runtime_error("not a FITS file");
+	qint64 dataSize = 0;
+	const int naxis = header.value("NAXIS").toInt();
+	if (naxis>0)
+	{
+		dataSize = std::abs(header.value("BITPIX").toInt())/8;
+		for (int i=1;i<=naxis;++i)
+			dataSize *= header.value(QString("NAXIS%1").arg(i)).toLongLong();
+		dataSize = (dataSize+FITS_BLOCK_SIZE-1)/FITS_BLOCK_SIZE*FITS_BLOCK_SIZE;
+		if (in->read(dataSize).size()!=dataSize)
+			throw std::runtime_error("unexpected end of the FITS file");
+	}
+
+	// Binary table of the cells
+	header = readFitsHeader(in);
+	if (header.value("XTENSION")!="BINTABLE")
+		throw std::runtime_error("the MOC must be stored in a FITS binary table");
+	const QString ordering = header.value("ORDERING", "NUNIQ");
+	if (ordering!="NUNIQ" && ordering!="RANGE")
+		throw std::runtime_error(qPrintable(QString("unsupported MOC ordering: %1 (expect NUNIQ or RANGE)").arg(ordering)));
+	const QString form = header.value("TFORM1");
+	const int valueSize = form.endsWith('K') ? 8 : (form.endsWith('J') ? 4 : 0);
+	const int rowSize = header.value("NAXIS1").toInt();
+	const qint64 nbRows = header.value("NAXIS2").toLongLong();
+	if (valueSize==0 || rowSize<valueSize || nbRows<0)
+		throw std::runtime_error(qPrintable(QString("unsupported MOC column format: %1 (expect J or K)").arg(form)));
+	int order = -1;
+	if (header.contains("MOCORDER"))
+		order = header.value("MOCORDER").toInt();
+	else if (header.contains("MOCORD_S"))
+		order = header.value("MOCORD_S").toInt();
+
+	const QByteArray data = in->read(rowSize*nbRows);
+	if (data.size()!=rowSize*nbRows)
+		throw std::runtime_error("unexpected end of the FITS file");
+	QVector<quint64> values;
+	values.reserve(static_cast<int>(nbRows));
+	for (qint64 i=0;i<nbRows;++i)
+	{
+		// Big endian values in the first column
+		const uchar* p = reinterpret_cast<const uchar*>(data.constData()) + i*rowSize;
+		quint64 v = 0;
+		for (int k=0;k<valueSize;++k)
+			v = (v << 8) | p[k];
+		values << v;
+	}
+
+	if (ordering=="NUNIQ")
+		return SphericalRegionP(new SphericalMOC(fromUniqCells(values, order)));
+
+	// Ranges of cells at order 29
+	if (values.size()%2)
+		throw std::runtime_error("odd number of values in the MOC ranges");
+	QVector<Range> ranges;
+	ranges.reserve(values.size()/2);
+	for (int i=0;i<values.size();i+=2)
+		ranges << Range(values.at(i), values.at(i+1));
+	return SphericalRegionP(new SphericalMOC(order<0 ? MAX_ORDER : order, ranges));
+}
+
+bool SphericalMOC::saveToFits(QIODevice* out) const
+{
+	QByteArray header;
+	header += fitsCard("SIMPLE", QString("T").rightJustified(20));
+	header += fitsCard("BITPIX", 8);
+	header += fitsCard("NAXIS", 0);
+	header += fitsCard("EXTEND", QString("T").rightJustified(20));
+	header += QByteArray("END").leftJustified(80);
+	fitsPad(header, ' ');
+
+	const QVector<quint64> cells = getUniqCells();
+	header += fitsStringCard("XTENSION", "BINTABLE");
+	header += fitsCard("BITPIX", 8);
+	header += fitsCard("NAXIS", 2);
+	header += fitsCard("NAXIS1", 8);
+	header += fitsCard("NAXIS2", cells.size());
+	header += fitsCard("PCOUNT", 0);
+	header += fitsCard("GCOUNT", 1);
+	header += fitsCard("TFIELDS", 1);
+	header += fitsStringCard("TTYPE1", "UNIQ");
+	header += fitsStringCard("TFORM1", "1K");
+	header += fitsStringCard("PIXTYPE", "HEALPIX");
+	header += fitsStringCard("ORDERING", "NUNIQ");
+	header += fitsStringCard("COORDSYS", "C");
+	header += fitsCard("MOCORDER", order);
+	header += fitsStringCard("MOCVERS", "1.1");
+	header += fitsStringCard("MOCTOOL", "Stellarium");
+	header += QByteArray("END").leftJustified(80);
+	fitsPad(header, ' ');
+
+	QByteArray data;
+	data.reserve(cells.size()*8+FITS_BLOCK_SIZE);
+	for (auto v : cells)
+	{
+		for (int k=7;k>=0;--k)
+			data.append(static_cast<char>((v >> (8*k)) & 0xff));
+	}
+	fitsPad(data, '\0');
+
+	return out->write(header)==header.size() && out->write(data)==data.size();
+}
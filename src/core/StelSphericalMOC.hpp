@@ -0,0 +1,229 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELSPHERICALMOC_HPP
+#define STELSPHERICALMOC_HPP
+
+#include "StelSphereGeometry.hpp"
+
+#include <QMutex>
+#include <QPair>
+#include <QVector>
+
+class QIODevice;
+
+//! @class SphericalMOC
+//! A SphericalRegion defined as a HEALPix Multi-Order Coverage map (MOC), as defined by the IVOA MOC recommendation.
+//! The region is the union of HEALPix cells of the nested scheme in the ICRS frame, at orders up to the order of the MOC.
+//! Cells are stored as sorted ranges of cell indices at the highest order (29), so that the boolean operations
+//! between MOCs are linear in the number of ranges and the point containment is a binary search, even for
+//! coverages of millions of cells such as survey footprints.
+//! Operations with the other kinds of regions first compute the coverage of the other region at the order of the MOC,
+//! by recursively testing the HEALPix cells against the region. For these tests, the cells are approximated by the
+//! convex polygons joining their 4 corners, so that the results of such operations are MOC themselves, accurate to
+//! the size of the cells.
+class SphericalMOC : public SphericalRegion
+{
+public:
+	// Avoid name hiding when overloading the virtual methods.
+	using SphericalRegion::intersects;
+	using SphericalRegion::contains;
+	using SphericalRegion::getIntersection;
+	using SphericalRegion::getUnion;
+	using SphericalRegion::getSubtraction;
+
+	//! Highest HEALPix order of a MOC, the cell indices of this order must fit in 64 bits.
+	static const int MAX_ORDER = 29;
+
+	//! Range of cell indices [first, second[ at MAX_ORDER.
+	typedef QPair<quint64, quint64> Range;
+
+	//! Create an empty MOC.
+	SphericalMOC() : order(0), boundingCapValid(false), fillVertexArrayValid(false), outlineVertexArrayValid(false) {;}
+
+	//! Create a MOC from ranges of cell indices at MAX_ORDER.
+	//! @param order the order of the MOC, the ranges are enlarged to the cells of this order.
+	//! @param ranges the ranges, which don't have to be sorted or disjoint.
+	SphericalMOC(int order, const QVector<Range>& ranges);
+
+	//! Create the MOC covering the given region.
+	//! @param region the region to cover.
+	//! @param order the order of the MOC.
+	//! @param inner if true, only the cells fully inside the region are included, else all the cells intersecting it.
+	SphericalMOC(const SphericalRegion* region, int order, bool inner=false);
+
+	SphericalMOC(const SphericalMOC& other);
+	SphericalMOC& operator=(const SphericalMOC& other);
+
+	virtual ~SphericalMOC() {;}
+
+	//! Create a MOC from a list of cells of the nested scheme, all of the same order.
+	static SphericalMOC fromNestedCells(int order, const QVector<quint64>& cells);
+
+	//! Create a MOC from a list of cells encoded in the NUNIQ scheme (uniq = 4*4^order + index).
+	//! @param order the order of the MOC, or -1 to use the highest order of the cells.
+	static SphericalMOC fromUniqCells(const QVector<quint64>& uniqCells, int order=-1);
+
+	virtual SphericalRegionType getType() const {return SphericalRegion::MOC;}
+	virtual OctahedronPolygon getOctahedronPolygon() const {return getConvexPolygonSet().toOctahedronPolygon();}
+	virtual ConvexPolygonSet getConvexPolygonSet() const;
+	virtual double getArea() const;
+	virtual bool isEmpty() const {return ranges.isEmpty();}
+	virtual Vec3d getPointInside() const;
+	virtual SphericalCap getBoundingCap() const;
+
+	//! Return the triangles of the cells, with the cells finer than the default draw order merged into their parent.
+	virtual StelVertexArray getFillVertexArray() const;
+	//! Return the outline of the cells, with the cells finer than the default draw order merged into their parent.
+	virtual StelVertexArray getOutlineVertexArray() const;
+	//! Return the triangles of the cells intersecting the given cap, with the cells finer than drawOrder merged into their parent.
+	//! It is used for the interactive display of large coverages, where the draw order depends on the field of view.
+	StelVertexArray getFillVertexArray(const SphericalCap& viewportCap, int drawOrder) const;
+	//! Return the outline of the cells intersecting the given cap, with the cells finer than drawOrder merged into their parent.
+	StelVertexArray getOutlineVertexArray(const SphericalCap& viewportCap, int drawOrder) const;
+
+	//! Serialize the region into a QVariant list matching the JSON format.
+	//! The format is ["MOC", {"order": [index, ...], ...}], where the map is the IVOA MOC JSON serialization.
+	virtual QVariantList toQVariant() const;
+	virtual void serialize(QDataStream& out) const {out << static_cast<qint32>(order) << ranges;}
+
+	// Contain and intersect
+	virtual bool contains(const Vec3d& p) const;
+	virtual bool contains(const SphericalPolygon& r) const {return containsRegion(&r);}
+	virtual bool contains(const SphericalConvexPolygon& r) const {return containsRegion(&r);}
+	virtual bool contains(const SphericalCap& r) const {return containsRegion(&r);}
+	virtual bool contains(const AllSkySphericalRegion&) const;
+	virtual bool contains(const SphericalMOC& r) const;
+	virtual bool intersects(const SphericalPolygon& r) const {return intersectsRegion(&r);}
+	virtual bool intersects(const SphericalConvexPolygon& r) const {return intersectsRegion(&r);}
+	virtual bool intersects(const SphericalCap& r) const {return intersectsRegion(&r);}
+	virtual bool intersects(const AllSkySphericalRegion&) const {return !isEmpty();}
+	virtual bool intersects(const SphericalMOC& r) const;
+
+	// Boolean operations, returning a SphericalMOC at the order of this MOC (or the highest order for two MOCs)
+	virtual SphericalRegionP getIntersection(const SphericalPolygon& r) const {return getIntersection(SphericalMOC(&r, order));}
+	virtual SphericalRegionP getIntersection(const SphericalConvexPolygon& r) const {return getIntersection(SphericalMOC(&r, order));}
+	virtual SphericalRegionP getIntersection(const SphericalCap& r) const {return getIntersection(SphericalMOC(&r, order));}
+	virtual SphericalRegionP getIntersection(const SphericalPoint& r) const;
+	virtual SphericalRegionP getIntersection(const AllSkySphericalRegion&) const {return SphericalRegionP(new SphericalMOC(*this));}
+	virtual SphericalRegionP getIntersection(const SphericalMOC& r) const;
+	virtual SphericalRegionP getUnion(const SphericalPolygon& r) const {return getUnion(SphericalMOC(&r, order));}
+	virtual SphericalRegionP getUnion(const SphericalConvexPolygon& r) const {return getUnion(SphericalMOC(&r, order));}
+	virtual SphericalRegionP getUnion(const SphericalCap& r) const {return getUnion(SphericalMOC(&r, order));}
+	virtual SphericalRegionP getUnion(const SphericalPoint& r) const {return getUnion(SphericalMOC(&r, order));}
+	virtual SphericalRegionP getUnion(const EmptySphericalRegion&) const {return SphericalRegionP(new SphericalMOC(*this));}
+	virtual SphericalRegionP getUnion(const SphericalMOC& r) const;
+	virtual SphericalRegionP getSubtraction(const SphericalPolygon& r) const {return getSubtraction(SphericalMOC(&r, order, true));}
+	virtual SphericalRegionP getSubtraction(const SphericalConvexPolygon& r) const {return getSubtraction(SphericalMOC(&r, order, true));}
+	virtual SphericalRegionP getSubtraction(const SphericalCap& r) const {return getSubtraction(SphericalMOC(&r, order, true));}
+	virtual SphericalRegionP getSubtraction(const SphericalPoint&) const {return SphericalRegionP(new SphericalMOC(*this));}
+	virtual SphericalRegionP getSubtraction(const EmptySphericalRegion&) const {return SphericalRegionP(new SphericalMOC(*this));}
+	virtual SphericalRegionP getSubtraction(const SphericalMOC& r) const;
+
+	//! Return whether all the cells of the MOC are inside the given region.
+	//! This is used by the regions of the other types to test whether they contain a MOC.
+	bool isInside(const SphericalRegion* region) const;
+
+	//! Return the order of the MOC, i.e. the order of its smallest cells.
+	int getOrder() const {return order;}
+	//! Return the sorted, disjoint ranges of cell indices at MAX_ORDER.
+	const QVector<Range>& getRanges() const {return ranges;}
+	//! Return the number of cells of the given order covered by the MOC, partially covered cells included.
+	quint64 getCellsCount(int cellsOrder) const;
+	//! Return the cells of the MOC in the NUNIQ scheme, i.e. the largest cells covering the region, sorted by order and index.
+	QVector<quint64> getUniqCells() const;
+	//! Return the MOC degraded to a lower order, i.e. with the partially covered cells of this order added.
+	SphericalMOC getDegraded(int newOrder) const;
+	//! Return the complement of the MOC on the sphere.
+	SphericalMOC getComplement() const;
+
+	//! Return the index of the cell of the given order containing the direction p.
+	static quint64 cellIndex(int cellOrder, const Vec3d& p);
+	//! Return the center of a cell.
+	static Vec3d cellCenter(int cellOrder, quint64 index);
+	//! Return the convex polygon joining the 4 corners of a cell.
+	static SphericalConvexPolygon cellPolygon(int cellOrder, quint64 index);
+	//! Return a SphericalCap bounding a cell.
+	static SphericalCap cellBoundingCap(int cellOrder, quint64 index);
+
+	//! Create a MOC from the IVOA MOC JSON serialization, i.e. a map {"order": [index, ...], ...}.
+	//! @throws std::runtime_error when the map is not a valid MOC.
+	static SphericalRegionP loadFromJsonMap(const QVariantMap& map);
+	//! Return the IVOA MOC JSON serialization of the MOC.
+	QVariantMap toJsonMap() const;
+
+	//! Create a MOC from a FITS file following the IVOA MOC recommendation.
+	//! Both the NUNIQ (MOC 1.x) and the RANGE (MOC 2.0) orderings of the binary table are supported.
+	//! @param in an open QIODevice ready for read.
+	//! @throws std::runtime_error when there was an error while parsing the file.
+	static SphericalRegionP loadFromFits(QIODevice* in);
+	//! Write the MOC into a FITS file in the NUNIQ ordering, as defined by the IVOA MOC 1.1 recommendation.
+	//! @param out an open QIODevice ready for write.
+	//! @return false if the writing failed.
+	bool saveToFits(QIODevice* out) const;
+
+	//! Deserialize the region. This method must allow as fast as possible deserialization.
+	static SphericalRegionP deserialize(QDataStream& in);
+
+	//! Default order used for the vertex arrays of the region when no viewport is given.
+	static const int DEFAULT_DRAW_ORDER = 7;
+
+private:
+	//! Coverage of a cell by the MOC.
+	enum CellCoverage
+	{
+		CellOutside,
+		CellPartial,
+		CellInside
+	};
+
+	//! Merge the overlapping and adjacent ranges after aligning them on the cells of the order.
+	void normalize();
+	//! Return the coverage of the cell by the MOC.
+	CellCoverage getCellCoverage(int cellOrder, quint64 index) const;
+	//! Add the cells covering the region to the ranges.
+	void addRegionCells(const SphericalRegion* region, int cellOrder, quint64 index, bool inner);
+	bool containsRegion(const SphericalRegion* region) const;
+	bool intersectsRegion(const SphericalRegion* region) const;
+	bool containsRegion(const SphericalRegion* region, int cellOrder, quint64 index) const;
+	bool intersectsRegion(const SphericalRegion* region, int cellOrder, quint64 index) const;
+	//! Return the coverage of the cell by the region.
+	static CellCoverage getRegionCellCoverage(const SphericalRegion* region, int cellOrder, quint64 index);
+	//! List the cells intersecting the cap (if any), with the cells finer than maxOrder merged into their parent,
+	//! and the cells of low order split so that their shape is well approximated by the polygon of their corners.
+	QVector<QPair<int, quint64> > getCells(const SphericalCap* viewportCap, int maxOrder) const;
+	void getCells(const SphericalCap* viewportCap, int maxOrder, int cellOrder, quint64 index, QVector<QPair<int, quint64> >& cells) const;
+	StelVertexArray computeFillVertexArray(const QVector<QPair<int, quint64> >& cells) const;
+	StelVertexArray computeOutlineVertexArray(const QVector<QPair<int, quint64> >& cells, int maxOrder) const;
+
+	//! Sorted, disjoint and non adjacent ranges of cell indices at MAX_ORDER.
+	QVector<Range> ranges;
+	//! Order of the smallest cells of the MOC.
+	int order;
+
+	// Caches, computed on demand. Guarded by cacheMutex, as MOCs are queried from several threads.
+	mutable QMutex cacheMutex;
+	mutable SphericalCap boundingCap;
+	mutable bool boundingCapValid;
+	mutable StelVertexArray fillVertexArray;
+	mutable bool fillVertexArrayValid;
+	mutable StelVertexArray outlineVertexArray;
+	mutable bool outlineVertexArrayValid;
+};
+
+#endif // STELSPHERICALMOC_HPP
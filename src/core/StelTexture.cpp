@@ -166,6 +166,7 @@ bool StelTexture::bind(uint slot)
 		// The texture is already fully loaded, just bind and return true;
 		gl->glActiveTexture(GL_TEXTURE0 + slot);
 		gl->glBindTexture(GL_TEXTURE_2D, id);
+		StelPainter::textureBound(slot, id);
 		return true;
 	}
 	if (errorOccured)
@@ -182,6 +183,7 @@ bool StelTexture::bind(uint slot)
 			// The texture is already fully loaded, just bind and return true;
 			gl->glActiveTexture(GL_TEXTURE0 + slot);
 			gl->glBindTexture(GL_TEXTURE_2D, id);
+			StelPainter::textureBound(slot, id);
 			return true;
 		}
 		if (errorOccured)
@@ -371,6 +373,7 @@ bool StelTexture::glLoad(const GLData& data)
 	gl->glActiveTexture(GL_TEXTURE0);
 	gl->glGenTextures(1, &id);
 	gl->glBindTexture(GL_TEXTURE_2D, id);
+	StelPainter::textureBound(0, id);
 	gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, loadParams.filtering);
 	gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, loadParams.filtering);
 
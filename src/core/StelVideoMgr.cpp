@@ -19,6 +19,11 @@
 
 #include "StelVideoMgr.hpp"
 #include "StelMainView.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelPainter.hpp"
+#include "StelSkyLayerMgr.hpp"
+#include "StelUtils.hpp"
 #include <QDebug>
 #include <QDir>
 #ifdef ENABLE_MEDIA
@@ -796,6 +801,8 @@ void StelVideoMgr::handleMetaDataChanged(const QString & key, const QVariant & v
 // update() has only to deal with the faders in all videos, and (re)set positions and sizes of video windows.
 void StelVideoMgr::update(double deltaTime)
 {
+	droppedSkyVideos.clear();
+
 	for (auto voIter = videoObjects.constBegin(); voIter != videoObjects.constEnd(); ++voIter)
 	{
 		QMediaPlayer::MediaStatus mediaStatus = (*voIter)->player->mediaStatus();
@@ -954,7 +961,7 @@ void StelVideoMgr::loadVideo(const QString& filename, const QString& id, float x
 	qWarning() << "[StelVideoMgr] This build of Stellarium does not support video - cannot load video" << QDir::toNativeSeparators(filename) << id << x << y << show << alpha;
 }
 StelVideoMgr::~StelVideoMgr() {;}
-void StelVideoMgr::update(double){;}
+void StelVideoMgr::update(double){droppedSkyVideos.clear();}
 void StelVideoMgr::playVideo(const QString&, const bool) {;}
 void StelVideoMgr::playVideoPopout(const QString&, float, float, float, float, float, float, float, bool){;}
 void StelVideoMgr::pauseVideo(const QString&) {;}
@@ -982,4 +989,115 @@ bool StelVideoMgr::isVideoPlaying(const QString& id) const
 
 #endif // ENABLE_MEDIA
 
+void StelVideoMgr::loadSkyVideo(const QString& filename, const QString& id, double startJD, double timeScale)
+{
+	if (skyVideos.contains(id))
+	{
+		qWarning() << "[StelVideoMgr] Sky video with ID" << id << "already exists, dropping it";
+		dropSkyVideo(id);
+	}
+
+	StelVideoSkyLayerP layer(new StelVideoSkyLayer(filename, startJD, timeScale));
+	if (!layer->isValid())
+	{
+		qWarning() << "[StelVideoMgr] Cannot load sky video" << QDir::toNativeSeparators(filename);
+		return;
+	}
+	QMutexLocker locker(&skyVideoMutex);
+	skyVideos.insert(id, layer);
+}
+
+void StelVideoMgr::setSkyVideoDome(const QString& id, float fov, float rotation)
+{
+	if (!skyVideos.contains(id))
+	{
+		qDebug() << "[StelVideoMgr] setSkyVideoDome()" << id << ": no such sky video";
+		return;
+	}
+	skyVideos[id]->setDome(static_cast<double>(fov)*M_PI/180., static_cast<double>(rotation)*M_PI/180.);
+}
+
+void StelVideoMgr::setSkyVideoRect(const QString& id, double ra, double dec, double width, double height, double rotation)
+{
+	if (!skyVideos.contains(id))
+	{
+		qDebug() << "[StelVideoMgr] setSkyVideoRect()" << id << ": no such sky video";
+		return;
+	}
+	Vec3d center;
+	StelUtils::spheToRect(ra*M_PI/180., dec*M_PI/180., center);
+	skyVideos[id]->setRect(center, width*M_PI/180., height*M_PI/180., rotation*M_PI/180.);
+}
+
+void StelVideoMgr::setSkyVideoAlpha(const QString& id, float alpha)
+{
+	if (!skyVideos.contains(id))
+	{
+		qDebug() << "[StelVideoMgr] setSkyVideoAlpha()" << id << ": no such sky video";
+		return;
+	}
+	skyVideos[id]->setOpacity(alpha);
+}
+
+void StelVideoMgr::showSkyVideo(const QString& id, bool show)
+{
+	if (!skyVideos.contains(id))
+	{
+		qDebug() << "[StelVideoMgr] showSkyVideo()" << id << ": no such sky video";
+		return;
+	}
+	skyVideos[id]->setVisible(show);
+}
+
+void StelVideoMgr::dropSkyVideo(const QString& id)
+{
+	if (!skyVideos.contains(id))
+	{
+		qDebug() << "[StelVideoMgr] dropSkyVideo()" << id << ": no such sky video";
+		return;
+	}
+	StelVideoSkyLayerP layer;
+	{
+		QMutexLocker locker(&skyVideoMutex);
+		layer = skyVideos.take(id);
+	}
+	qDebug() << "[StelVideoMgr] Sky video" << id << "statistics:" << layer->getStatistics();
+	droppedSkyVideos << layer;
+}
+
+QVariantMap StelVideoMgr::getSkyVideoStatistics(const QString& id) const
+{
+	StelVideoSkyLayerP layer;
+	{
+		QMutexLocker locker(&skyVideoMutex);
+		layer = skyVideos.value(id);
+	}
+	if (layer.isNull())
+		return QVariantMap();
+	return layer->getStatistics();
+}
+
+double StelVideoMgr::getCallOrder(StelModuleActionName actionName) const
+{
+	// The sky videos are drawn over the other sky layers
+	if (actionName==StelModule::ActionDraw)
+		return GETSTELMODULE(StelSkyLayerMgr)->getCallOrder(actionName)+1;
+	return 0;
+}
+
+void StelVideoMgr::draw(StelCore* core)
+{
+	if (skyVideos.isEmpty())
+		return;
+
+	StelPainter sPainter(core->getProjection(StelCore::FrameJ2000));
+	for (const auto& layer : skyVideos)
+	{
+		if (!layer->isVisible())
+			continue;
+		sPainter.setProjector(core->getProjection(layer->getFrameType()));
+		layer->draw(core, sPainter, 1.);
+	}
+}
+
 
@@ -22,6 +22,7 @@
 
 #include <QObject>
 #include <QMap>
+#include <QMutex>
 #include <QString>
 #ifdef ENABLE_MEDIA
 #include <QSize>
@@ -33,6 +34,7 @@
 #include "StelFader.hpp"
 #endif
 #include "StelModule.hpp"
+#include "StelVideoSkyLayer.hpp"
 
 class QGraphicsVideoItem;
 
@@ -110,6 +112,10 @@ public slots:
 	//! @param deltaTime the time increment in second since last call.
 	virtual void update(double deltaTime);
 
+	//! Draw the visible sky videos, see loadSkyVideo().
+	virtual void draw(StelCore* core);
+	virtual double getCallOrder(StelModuleActionName actionName) const;
+
 	//! load a video from filename, assign an id for it for later reference.
 	//! If id is already in use, replace it.
 	//! Prepare replay at upper-left corner x/ y in native resolution,
@@ -201,6 +207,32 @@ public slots:
 	//! @note If video is not found, also returns false.
 	bool isVideoPlaying(const QString& id) const;
 
+	//! Load a video or an image sequence to be shown on the sky, synchronized with the simulation time.
+	//! The frames are shown on the dome of the observer, use setSkyVideoRect() to place them in the sky instead.
+	//! Image sequences are available without media support. See StelVideoSkyLayer for the supported sources.
+	//! @param filename a video file, a directory of images or a text file listing dated images.
+	//! @param id the name used to refer to the sky video in the other methods.
+	//! @param startJD the JD at which the first frame is shown.
+	//! @param timeScale the simulated seconds per second of video, or between two images of a directory.
+	void loadSkyVideo(const QString& filename, const QString& id, double startJD, double timeScale=1.);
+	//! Show the sky video as fisheye images around the zenith, like those of an all-sky camera.
+	//! @param fov the field of view of the images in degrees.
+	//! @param rotation the azimuth of the top of the images in degrees.
+	void setSkyVideoDome(const QString& id, float fov=180.f, float rotation=0.f);
+	//! Show the sky video in a rectangle on the sky.
+	//! @param ra, dec the J2000 coordinates of the center of the rectangle in degrees.
+	//! @param width, height the angular size of the rectangle in degrees.
+	//! @param rotation the position angle of the top of the frames in degrees.
+	void setSkyVideoRect(const QString& id, double ra, double dec, double width, double height, double rotation=0.);
+	//! @param alpha opacity of the sky video (0=transparent, ... 1=fully opaque).
+	void setSkyVideoAlpha(const QString& id, float alpha);
+	//! Show or hide the sky video. The sky videos do not depend on the visibility of the other sky layers.
+	void showSkyVideo(const QString& id, bool show);
+	void dropSkyVideo(const QString& id);
+	//! Return the frame pacing statistics of the sky video, see StelVideoSkyLayer::getStatistics().
+	//! This may be called from the script thread.
+	QVariantMap getSkyVideoStatistics(const QString& id) const;
+
 #ifdef ENABLE_MEDIA
 private slots:
 	// Slots to handle QMediaPlayer signals. Never call them yourself!
@@ -229,6 +261,13 @@ private slots:
 
 
 private:
+	//! The sky videos are changed in the main thread only, through queued calls from the scripts.
+	//! skyVideoMutex protects the changes against getSkyVideoStatistics(), which is called directly by scripts.
+	QMap<QString, StelVideoSkyLayerP> skyVideos;
+	mutable QMutex skyVideoMutex;
+	//! The dropped sky videos are deleted in update(), when their textures can be released
+	QList<StelVideoSkyLayerP> droppedSkyVideos;
+
 #if 0
 	// Traces of old Qt4/Phonon:
 	typedef struct {
@@ -0,0 +1,598 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelVideoSkyLayer.hpp"
+#include "StelCore.hpp"
+#include "StelPainter.hpp"
+#include "StelProjector.hpp"
+#include "StelUtils.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QRegExp>
+#include <QTextStream>
+#include <QtConcurrent>
+#ifdef ENABLE_MEDIA
+#include <QAbstractVideoSurface>
+#include <QMediaPlayer>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+const int StelVideoSkyLayer::RING_SIZE = 4;
+
+// Tesselation of the dome
+static const unsigned int DOME_SLICES = 40;
+static const unsigned int DOME_STACKS = 20;
+
+#ifdef ENABLE_MEDIA
+// Range of playback rates used to follow the simulation time, outside of it single frames are shown
+static const double MIN_PLAYBACK_RATE = 0.25;
+static const double MAX_PLAYBACK_RATE = 4.;
+// Drift after which a playing video is resynchronized [ms]
+static const qint64 SYNC_TOLERANCE = 500;
+// Minimal interval between two seeks [ms]
+static const qint64 SEEK_INTERVAL = 100;
+
+//! Receives the frames decoded by the media player. Only frames in memory are accepted,
+//! so that they can be converted in the decoder threads.
+class StelVideoSkySurface : public QAbstractVideoSurface
+{
+public:
+	StelVideoSkySurface(StelVideoSkyLayer* layer) : layer(layer) {}
+
+	virtual QList<QVideoFrame::PixelFormat> supportedPixelFormats(QAbstractVideoBuffer::HandleType handleType) const Q_DECL_OVERRIDE
+	{
+		if (handleType!=QAbstractVideoBuffer::NoHandle)
+			return QList<QVideoFrame::PixelFormat>();
+		return QList<QVideoFrame::PixelFormat>() << QVideoFrame::Format_RGB32 << QVideoFrame::Format_ARGB32
+							 << QVideoFrame::Format_ARGB32_Premultiplied << QVideoFrame::Format_RGB24
+							 << QVideoFrame::Format_RGB565;
+	}
+
+	virtual bool present(const QVideoFrame& frame) Q_DECL_OVERRIDE
+	{
+		layer->presentVideoFrame(frame);
+		return true;
+	}
+
+private:
+	StelVideoSkyLayer* layer;
+};
+#endif
+
+StelVideoSkyLayer::StelVideoSkyLayer(const QString& source, double startJD, double timeScale)
+	: valid(false)
+	, visible(true)
+	, startJD(startJD)
+	, timeScale(timeScale)
+	, opacity(1.f)
+	, maxTextureSize(0)
+	, endJD(startJD)
+	, dome(true)
+	, domeFov(M_PI)
+	, domeRotation(0.)
+	, displayedSlot(-1)
+	, lastTarget(-1)
+	, nextSerial(1)
+#ifdef ENABLE_MEDIA
+	, player(Q_NULLPTR)
+	, surface(Q_NULLPTR)
+	, framePresented(false)
+	, lastSeek(-1)
+#endif
+	, renderedFrames(0)
+	, decodedFrames(0)
+	, lateFrames(0)
+	, droppedFrames(0)
+	, uploads(0)
+	, drawTime(0)
+	, maxDrawTime(0)
+	, uploadTime(0)
+	, maxUploadTime(0)
+	, decodeTime(0)
+	, maxDecodeTime(0)
+{
+	const QFileInfo info(source);
+	shortName = info.fileName();
+	frameSlots.resize(RING_SIZE);
+	setDome();
+
+	if (info.isDir() || info.suffix().toLower()=="txt")
+	{
+		loadSequence(source);
+		return;
+	}
+#ifdef ENABLE_MEDIA
+	surface = new StelVideoSkySurface(this);
+	player = new QMediaPlayer(Q_NULLPTR, QMediaPlayer::VideoSurface);
+	player->setMuted(true);
+	player->setVideoOutput(surface);
+	player->setMedia(QUrl::fromLocalFile(info.absoluteFilePath()));
+	valid = true;
+#else
+	qWarning() << "[StelVideoSkyLayer] Videos are not supported without media support, cannot load" << QDir::toNativeSeparators(source);
+#endif
+}
+
+StelVideoSkyLayer::~StelVideoSkyLayer()
+{
+#ifdef ENABLE_MEDIA
+	if (player)
+	{
+		player->stop();
+		delete player;
+	}
+	delete surface;
+#endif
+	QOpenGLContext* context = QOpenGLContext::currentContext();
+	for (auto& slot : frameSlots)
+	{
+		slot.decoding.waitForFinished();
+		if (slot.texture)
+		{
+			if (context)
+				context->functions()->glDeleteTextures(1, &slot.texture);
+			else
+				qWarning() << "[StelVideoSkyLayer] Cannot delete texture" << slot.texture << ", no GL context";
+		}
+	}
+}
+
+void StelVideoSkyLayer::loadSequence(const QString& source)
+{
+	QVector<QPair<double, QString> > frames;
+	const QFileInfo info(source);
+	if (info.isDir())
+	{
+		const QDir dir(source);
+		const QStringList files = dir.entryList(QStringList() << "*.png" << "*.jpg" << "*.jpeg", QDir::Files, QDir::Name);
+		for (int i=0; i<files.size(); ++i)
+			frames << qMakePair(startJD + i*timeScale/86400., dir.absoluteFilePath(files.at(i)));
+	}
+	else
+	{
+		QFile file(source);
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		{
+			qWarning() << "[StelVideoSkyLayer] Cannot open frame list" << QDir::toNativeSeparators(source);
+			return;
+		}
+		// Each line is a date, either a JD or ISO 8601 in UTC, followed by the image file name relative to the list
+		QTextStream in(&file);
+		while (!in.atEnd())
+		{
+			const QString line = in.readLine().trimmed();
+			if (line.isEmpty() || line.startsWith('#'))
+				continue;
+			const int sep = line.indexOf(QRegExp("\\s"));
+			if (sep<0)
+			{
+				qWarning() << "[StelVideoSkyLayer] Invalid line in frame list" << QDir::toNativeSeparators(source) << ":" << line;
+				continue;
+			}
+			const QString date = line.left(sep);
+			bool ok;
+			double JD = date.toDouble(&ok);
+			if (!ok)
+			{
+				QDateTime dateTime = QDateTime::fromString(date, Qt::ISODate);
+				if (dateTime.timeSpec()!=Qt::LocalTime)
+					dateTime = dateTime.toUTC();
+				ok = dateTime.isValid();
+				JD = StelUtils::qDateTimeToJd(dateTime);
+			}
+			if (!ok)
+			{
+				qWarning() << "[StelVideoSkyLayer] Invalid date in frame list" << QDir::toNativeSeparators(source) << ":" << date;
+				continue;
+			}
+			frames << qMakePair(JD, info.dir().absoluteFilePath(line.mid(sep).trimmed()));
+		}
+	}
+
+	if (frames.isEmpty())
+	{
+		qWarning() << "[StelVideoSkyLayer] No frames found in" << QDir::toNativeSeparators(source);
+		return;
+	}
+	std::sort(frames.begin(), frames.end());
+	for (const auto& frame : frames)
+	{
+		frameJDs << frame.first;
+		framePaths << frame.second;
+	}
+	// The last frame is shown as long as the previous one
+	endJD = frameJDs.last() + (frameJDs.size()>1 ? frameJDs.last()-frameJDs.at(frameJDs.size()-2) : timeScale/86400.);
+	valid = true;
+}
+
+void StelVideoSkyLayer::setRect(const Vec3d& center, double width, double height, double rotation)
+{
+	Vec3d c = center;
+	c.normalize();
+	// East and north in the tangent plane at the center
+	Vec3d east = Vec3d(0., 0., 1.)^c;
+	if (east.lengthSquared()<1e-12)
+		east.set(0., 1., 0.);
+	east.normalize();
+	const Vec3d north = c^east;
+	const Vec3d up = (north*std::cos(rotation) + east*std::sin(rotation))*std::tan(0.5*height);
+	const Vec3d left = (east*std::cos(rotation) - north*std::sin(rotation))*std::tan(0.5*width);
+
+	// The frames are flipped for OpenGL, so the first corner is the bottom left one, on the east side
+	Vec3d corners[4] = {c-up+left, c-up-left, c+up-left, c+up+left};
+	for (auto& corner : corners)
+		corner.normalize();
+	rect = SphericalRegionP(new SphericalTexturedConvexPolygon(corners[0], corners[1], corners[2], corners[3]));
+	dome = false;
+	setFrameType(StelCore::FrameJ2000);
+}
+
+void StelVideoSkyLayer::setDome(double fov, double rotation)
+{
+	dome = true;
+	domeFov = fov;
+	domeRotation = rotation;
+	setFrameType(StelCore::FrameAltAz);
+}
+
+void StelVideoSkyLayer::prepareImage(QImage& image, int maxTextureSize)
+{
+	if (image.width()>maxTextureSize || image.height()>maxTextureSize)
+		image = image.scaled(maxTextureSize, maxTextureSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	// OpenGL expects the bottom row first
+	image = image.convertToFormat(QImage::Format_RGBA8888).mirrored();
+}
+
+StelVideoSkyLayer::DecodedFrame StelVideoSkyLayer::decodeImage(const QString& path, int maxTextureSize)
+{
+	QElapsedTimer timer;
+	timer.start();
+	DecodedFrame result;
+	QImageReader reader(path);
+	result.image = reader.read();
+	if (result.image.isNull())
+		qWarning() << "[StelVideoSkyLayer] Cannot decode" << QDir::toNativeSeparators(path) << ":" << reader.errorString();
+	else
+		prepareImage(result.image, maxTextureSize);
+	result.decodeTime = timer.nsecsElapsed();
+	return result;
+}
+
+#ifdef ENABLE_MEDIA
+StelVideoSkyLayer::DecodedFrame StelVideoSkyLayer::convertVideoFrame(QVideoFrame frame, int maxTextureSize)
+{
+	QElapsedTimer timer;
+	timer.start();
+	DecodedFrame result;
+	if (frame.map(QAbstractVideoBuffer::ReadOnly))
+	{
+		const QImage::Format format = QVideoFrame::imageFormatFromPixelFormat(frame.pixelFormat());
+		if (format!=QImage::Format_Invalid)
+		{
+			// prepareImage() makes a deep copy, so the frame can be unmapped afterwards
+			result.image = QImage(frame.bits(), frame.width(), frame.height(), frame.bytesPerLine(), format);
+			prepareImage(result.image, maxTextureSize);
+		}
+		frame.unmap();
+	}
+	result.decodeTime = timer.nsecsElapsed();
+	return result;
+}
+
+void StelVideoSkyLayer::presentVideoFrame(const QVideoFrame& frame)
+{
+	QMutexLocker locker(&frameMutex);
+	// The previous frame was not converted in time
+	if (framePresented)
+		++droppedFrames;
+	presentedFrame = frame;
+	framePresented = true;
+}
+#endif
+
+int StelVideoSkyLayer::getSequenceFrame(double JD) const
+{
+	if (frameJDs.isEmpty() || JD<frameJDs.first() || JD>=endJD)
+		return -1;
+	return static_cast<int>(std::upper_bound(frameJDs.constBegin(), frameJDs.constEnd(), JD) - frameJDs.constBegin()) - 1;
+}
+
+int StelVideoSkyLayer::findSlot(qint64 frame) const
+{
+	for (int i=0; i<frameSlots.size(); ++i)
+	{
+		if (frameSlots.at(i).frame==frame)
+			return i;
+	}
+	return -1;
+}
+
+int StelVideoSkyLayer::getFreeSlot(qint64 keepFirst, qint64 keepLast) const
+{
+	for (int i=0; i<frameSlots.size(); ++i)
+	{
+		const FrameSlot& slot = frameSlots.at(i);
+		// A running decoder cannot be interrupted
+		if (i==displayedSlot || !slot.decoding.isFinished())
+			continue;
+		if (slot.frame<keepFirst || slot.frame>keepLast)
+			return i;
+	}
+	return -1;
+}
+
+int StelVideoSkyLayer::scheduleSequence(StelCore* core)
+{
+	const int target = getSequenceFrame(core->getJD());
+	if (target<0)
+		return -1;
+
+	// Decode the target frame and the following ones in the direction of time
+	const int step = core->getTimeRate()<0. ? -1 : 1;
+	const int last = qBound(0, target + step*(RING_SIZE-2), framePaths.size()-1);
+	for (int i=0; i<RING_SIZE-1; ++i)
+	{
+		const int frame = target + i*step;
+		if (frame<0 || frame>=framePaths.size())
+			break;
+		if (findSlot(frame)>=0)
+			continue;
+		const int s = getFreeSlot(qMin(target, last), qMax(target, last));
+		if (s<0)
+			break;
+		FrameSlot& slot = frameSlots[s];
+		slot.frame = frame;
+		slot.uploaded = false;
+		slot.decoding = QtConcurrent::run(&StelVideoSkyLayer::decodeImage, framePaths.at(frame), maxTextureSize);
+	}
+
+	// Show the target frame if it is ready, else keep the previous one
+	const int s = findSlot(target);
+	if (s>=0 && frameSlots.at(s).decoding.isFinished())
+	{
+		FrameSlot& slot = frameSlots[s];
+		if (slot.uploaded || upload(slot))
+			displayedSlot = s;
+	}
+	else if (target!=lastTarget)
+	{
+		QMutexLocker locker(&frameMutex);
+		++lateFrames;
+	}
+	lastTarget = target;
+	return displayedSlot;
+}
+
+#ifdef ENABLE_MEDIA
+void StelVideoSkyLayer::syncPlayer(StelCore* core, double position)
+{
+	const qint64 target = static_cast<qint64>(position);
+	// Seconds of video per real second
+	const double rate = core->getTimeRate()*86400./timeScale;
+	if (rate>=MIN_PLAYBACK_RATE && rate<=MAX_PLAYBACK_RATE)
+	{
+		if (!qFuzzyCompare(player->playbackRate(), rate))
+			player->setPlaybackRate(rate);
+		if (player->state()!=QMediaPlayer::PlayingState)
+			player->play();
+		// Seeking is slow, so only resynchronize after a time jump or a large drift
+		if (std::abs(player->position()-target)<=SYNC_TOLERANCE)
+			return;
+	}
+	else
+	{
+		// The simulation is stopped, reversed or too fast to play the video: show single frames
+		if (player->state()!=QMediaPlayer::PausedState)
+			player->pause();
+		if (target==lastSeek)
+			return;
+	}
+	if (!seekTimer.isValid() || seekTimer.elapsed()>=SEEK_INTERVAL)
+	{
+		player->setPosition(target);
+		lastSeek = target;
+		seekTimer.start();
+	}
+}
+
+int StelVideoSkyLayer::scheduleVideo(StelCore* core)
+{
+	const double position = (core->getJD()-startJD)*86400./timeScale*1000.;
+	const qint64 duration = player->duration();
+	if (position<0. || (duration>0 && position>duration))
+	{
+		if (player->state()==QMediaPlayer::PlayingState)
+			player->pause();
+		return -1;
+	}
+	syncPlayer(core, position);
+
+	// Show the latest converted frame
+	int latest = -1;
+	for (int i=0; i<frameSlots.size(); ++i)
+	{
+		const FrameSlot& slot = frameSlots.at(i);
+		if (slot.frame>=0 && slot.decoding.isFinished() && (latest<0 || slot.serial>frameSlots.at(latest).serial))
+			latest = i;
+	}
+	if (latest>=0 && latest!=displayedSlot)
+	{
+		FrameSlot& slot = frameSlots[latest];
+		if (slot.uploaded || upload(slot))
+			displayedSlot = latest;
+		else
+			slot.frame = -1;
+	}
+
+	// Convert the last frame presented by the player, all the frames but the displayed one can be reused
+	const int s = getFreeSlot(0, -1);
+	if (s>=0)
+	{
+		QMutexLocker locker(&frameMutex);
+		if (framePresented)
+		{
+			FrameSlot& slot = frameSlots[s];
+			slot.frame = qMax(Q_INT64_C(0), presentedFrame.startTime()/1000);
+			slot.serial = nextSerial++;
+			slot.uploaded = false;
+			slot.decoding = QtConcurrent::run(&StelVideoSkyLayer::convertVideoFrame, presentedFrame, maxTextureSize);
+			presentedFrame = QVideoFrame();
+			framePresented = false;
+		}
+	}
+	return displayedSlot;
+}
+#endif
+
+bool StelVideoSkyLayer::upload(FrameSlot& slot)
+{
+	// The result of a failed decoding was already released
+	if (slot.decoding.resultCount()==0)
+		return false;
+
+	QElapsedTimer timer;
+	timer.start();
+	const DecodedFrame decoded = slot.decoding.result();
+	// Release the decoded image
+	slot.decoding = QFuture<DecodedFrame>();
+	{
+		QMutexLocker locker(&frameMutex);
+		++decodedFrames;
+		decodeTime += decoded.decodeTime;
+		maxDecodeTime = qMax(maxDecodeTime, decoded.decodeTime);
+	}
+	if (decoded.image.isNull())
+		return false;
+
+	QOpenGLFunctions* gl = QOpenGLContext::currentContext()->functions();
+	if (!slot.texture)
+	{
+		gl->glGenTextures(1, &slot.texture);
+		gl->glBindTexture(GL_TEXTURE_2D, slot.texture);
+		gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	else
+		gl->glBindTexture(GL_TEXTURE_2D, slot.texture);
+
+	// RGBA rows are always 4 bytes aligned, as expected by default
+	const QImage& image = decoded.image;
+	if (slot.textureSize!=image.size())
+	{
+		gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+		slot.textureSize = image.size();
+	}
+	else
+		gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width(), image.height(), GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+	slot.uploaded = true;
+
+	const qint64 elapsed = timer.nsecsElapsed();
+	QMutexLocker locker(&frameMutex);
+	++uploads;
+	uploadTime += elapsed;
+	maxUploadTime = qMax(maxUploadTime, elapsed);
+	return true;
+}
+
+void StelVideoSkyLayer::draw(StelCore* core, StelPainter& sPainter, float layerOpacity)
+{
+	if (!valid)
+		return;
+
+	QElapsedTimer timer;
+	timer.start();
+	if (maxTextureSize==0)
+	{
+		GLint size;
+		sPainter.glFuncs()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+		maxTextureSize = qMax(64, static_cast<int>(size));
+	}
+
+	int slot;
+#ifdef ENABLE_MEDIA
+	if (player)
+		slot = scheduleVideo(core);
+	else
+#endif
+		slot = scheduleSequence(core);
+	if (slot<0)
+		return;
+
+	drawFrame(core, sPainter, layerOpacity*opacity);
+
+	const qint64 elapsed = timer.nsecsElapsed();
+	QMutexLocker locker(&frameMutex);
+	++renderedFrames;
+	drawTime += elapsed;
+	maxDrawTime = qMax(maxDrawTime, elapsed);
+}
+
+void StelVideoSkyLayer::drawFrame(StelCore* core, StelPainter& sPainter, float alpha)
+{
+	QOpenGLFunctions* gl = sPainter.glFuncs();
+	gl->glActiveTexture(GL_TEXTURE0);
+	gl->glBindTexture(GL_TEXTURE_2D, frameSlots.at(displayedSlot).texture);
+
+	// Normal transparency mode
+	sPainter.setBlending(true);
+	sPainter.setColor(1.f, 1.f, 1.f, alpha);
+	if (dome)
+	{
+		StelProjector::ModelViewTranformP transfo = core->getAltAzModelViewTransform(StelCore::RefractionOff);
+		transfo->combine(Mat4d::zrotation(-domeRotation));
+		sPainter.setProjector(core->getProjection(transfo));
+		sPainter.setCullFace(true);
+		sPainter.sSphereMap(1., DOME_SLICES, DOME_STACKS, static_cast<float>(domeFov), 1);
+		sPainter.setCullFace(false);
+	}
+	else
+		sPainter.drawSphericalRegion(rect.data(), StelPainter::SphericalPolygonDrawModeTextureFill);
+}
+
+QVariantMap StelVideoSkyLayer::getStatistics() const
+{
+	QMutexLocker locker(&frameMutex);
+	QVariantMap map;
+	map.insert("renderedFrames", renderedFrames);
+	map.insert("decodedFrames", decodedFrames);
+	map.insert("lateFrames", lateFrames);
+	map.insert("droppedFrames", droppedFrames);
+	// Times in milliseconds
+	map.insert("meanDrawTime", renderedFrames>0 ? drawTime/1.e6/renderedFrames : 0.);
+	map.insert("maxDrawTime", maxDrawTime/1.e6);
+	map.insert("meanUploadTime", uploads>0 ? uploadTime/1.e6/uploads : 0.);
+	map.insert("maxUploadTime", maxUploadTime/1.e6);
+	map.insert("meanDecodeTime", decodedFrames>0 ? decodeTime/1.e6/decodedFrames : 0.);
+	map.insert("maxDecodeTime", maxDecodeTime/1.e6);
+	return map;
+}
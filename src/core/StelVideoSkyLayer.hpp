@@ -0,0 +1,205 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STELVIDEOSKYLAYER_HPP
+#define STELVIDEOSKYLAYER_HPP
+
+#include "StelSkyLayer.hpp"
+#include "StelSphereGeometry.hpp"
+#include "StelOpenGL.hpp"
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QImage>
+#include <QMutex>
+#include <QVariantMap>
+#include <QVector>
+#ifdef ENABLE_MEDIA
+#include <QVideoFrame>
+#endif
+
+class QMediaPlayer;
+class StelVideoSkySurface;
+
+//! @class StelVideoSkyLayer
+//! A sky layer showing a video or an image sequence on the sky, synchronized with the simulation time,
+//! e.g. the time-lapse of an eclipse or the images of an all-sky camera.
+//!
+//! The source is either a directory of images (sorted by file name), a text file listing one image per line
+//! preceded by its date (ISO 8601 in UTC, or JD), or a video file if Stellarium was built with media support.
+//! The frames are decoded by worker threads into a small ring of slots, each with its own texture. Drawing never
+//! waits for a decoder: if the frame for the current simulation time is not ready, the previous one is shown again
+//! and the frame is counted as late in getStatistics().
+//!
+//! The frames are drawn either in a rectangle on the sky (see setRect()) or as fisheye images on the dome of
+//! the observer (see setDome()).
+class StelVideoSkyLayer : public StelSkyLayer
+{
+	Q_OBJECT
+public:
+	//! Create the layer.
+	//! @param source a directory, a frame list file or a video file.
+	//! @param startJD the JD at which the first frame is shown.
+	//! @param timeScale the simulated seconds per second of video. Image sequences without dates are shown
+	//! with one frame per second of video, i.e. timeScale gives the simulated seconds between frames.
+	StelVideoSkyLayer(const QString& source, double startJD, double timeScale=1.);
+	~StelVideoSkyLayer();
+
+	//! Return true if the source could be opened.
+	bool isValid() const {return valid;}
+
+	//! Draw the frame for the current simulation time.
+	virtual void draw(StelCore* core, StelPainter& sPainter, float opacity=1.) Q_DECL_OVERRIDE;
+
+	virtual QString getShortName() const Q_DECL_OVERRIDE {return shortName;}
+
+	//! Show the frames in a rectangle on the sky, in the J2000 frame.
+	//! @param center the center of the rectangle.
+	//! @param width the angular width of the rectangle in radians.
+	//! @param height the angular height of the rectangle in radians.
+	//! @param rotation the position angle of the top of the frames in radians, counted from north towards east.
+	void setRect(const Vec3d& center, double width, double height, double rotation=0.);
+
+	//! Show the frames as fisheye images of the sky around the zenith, like those of an all-sky camera.
+	//! @param fov the field of view of the fisheye images in radians.
+	//! @param rotation the azimuth of the top of the frames in radians.
+	void setDome(double fov=M_PI, double rotation=0.);
+
+	//! Set the opacity of the layer.
+	void setOpacity(float alpha) {opacity = alpha;}
+
+	//! Set whether the layer is drawn. This is independent of the other sky layers shown by StelSkyLayerMgr.
+	void setVisible(bool b) {visible = b;}
+	bool isVisible() const {return visible;}
+
+	//! Return the frame pacing statistics: number of rendered, decoded, late and dropped frames,
+	//! and mean and maximal draw, upload and decode times in milliseconds.
+	//! This may be called from any thread, e.g. by a script.
+	QVariantMap getStatistics() const;
+
+	//! Number of frame slots, i.e. decoded frames and textures, kept by the layer.
+	static const int RING_SIZE;
+
+#ifdef ENABLE_MEDIA
+	//! Called by the video surface with each frame presented by the media player, possibly in another thread.
+	void presentVideoFrame(const QVideoFrame& frame);
+#endif
+
+private:
+	friend class TestStelVideoSkyLayer;
+
+	struct DecodedFrame
+	{
+		DecodedFrame() : decodeTime(0) {}
+		//! The frame, converted to RGBA and flipped for OpenGL
+		QImage image;
+		qint64 decodeTime;
+	};
+
+	struct FrameSlot
+	{
+		FrameSlot() : frame(-1), serial(0), texture(0), uploaded(false) {}
+		//! The frame index for image sequences, or the position in ms for videos, -1 if unused
+		qint64 frame;
+		//! Increasing number, to find the latest video frame
+		quint64 serial;
+		QFuture<DecodedFrame> decoding;
+		GLuint texture;
+		QSize textureSize;
+		bool uploaded;
+	};
+
+	static DecodedFrame decodeImage(const QString& path, int maxTextureSize);
+#ifdef ENABLE_MEDIA
+	static DecodedFrame convertVideoFrame(QVideoFrame frame, int maxTextureSize);
+#endif
+	static void prepareImage(QImage& image, int maxTextureSize);
+
+	void loadSequence(const QString& source);
+	//! Return the index of the frame to show at the given JD, or -1 outside of the sequence.
+	int getSequenceFrame(double JD) const;
+	//! Select the frame to show, and schedule the decoding of the next ones.
+	int scheduleSequence(StelCore* core);
+#ifdef ENABLE_MEDIA
+	int scheduleVideo(StelCore* core);
+	void syncPlayer(StelCore* core, double position);
+#endif
+	//! Return the slot holding or decoding the given frame, or -1.
+	int findSlot(qint64 frame) const;
+	//! Return a slot which may be reused for a new frame, or -1. The frames in [keepFirst, keepLast] are kept.
+	int getFreeSlot(qint64 keepFirst, qint64 keepLast) const;
+	//! Upload the decoded frame of the slot to its texture, return false if it failed.
+	bool upload(FrameSlot& slot);
+	void drawFrame(StelCore* core, StelPainter& sPainter, float alpha);
+
+	bool valid;
+	bool visible;
+	QString shortName;
+	double startJD;
+	double timeScale;
+	float opacity;
+	int maxTextureSize;
+
+	//! Image sequence
+	QStringList framePaths;
+	QVector<double> frameJDs;
+	double endJD;
+
+	//! Geometry
+	bool dome;
+	double domeFov;
+	double domeRotation;
+	SphericalRegionP rect;
+
+	QVector<FrameSlot> frameSlots;
+	int displayedSlot;
+	qint64 lastTarget;
+	quint64 nextSerial;
+
+#ifdef ENABLE_MEDIA
+	QMediaPlayer* player;
+	StelVideoSkySurface* surface;
+	//! The last frame presented by the player, protected by frameMutex
+	QVideoFrame presentedFrame;
+	bool framePresented;
+	qint64 lastSeek;
+	QElapsedTimer seekTimer;
+#endif
+
+	//! Protects the frames presented by the player and the statistics, which are read by scripts
+	mutable QMutex frameMutex;
+
+	//! Statistics, protected by frameMutex
+	qint64 renderedFrames;
+	qint64 decodedFrames;
+	qint64 lateFrames;
+	qint64 droppedFrames;
+	qint64 uploads;
+	qint64 drawTime;
+	qint64 maxDrawTime;
+	qint64 uploadTime;
+	qint64 maxUploadTime;
+	qint64 decodeTime;
+	qint64 maxDecodeTime;
+};
+
+//! @typedef StelVideoSkyLayerP
+//! Shared pointer on a StelVideoSkyLayer instance
+typedef QSharedPointer<StelVideoSkyLayer> StelVideoSkyLayerP;
+
+#endif // STELVIDEOSKYLAYER_HPP
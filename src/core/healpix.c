@@ -144,3 +144,60 @@ void healpix_pix2ang(int nside, int pix, double *theta, double *phi)
     xy[1] = (FACES[face][1] + (ix + iy + 1.0) / nside) * M_PI / 4;
     healpix_xy2ang(xy, theta, phi);
 }
+
+// Compute the healpix xy coordinates of the south corner of the pixel at
+// position (ix, iy) of the face. Non integer positions give points inside
+// the pixel, e.g. (ix + 0.5, iy + 0.5) is its center.
+void healpix_xyf2xy(int nside, double ix, double iy, int face_num, double out[2])
+{
+    out[0] = (FACES[face_num][0] + (ix - iy) / nside) * M_PI / 4;
+    out[1] = (FACES[face_num][1] + (ix + iy) / nside) * M_PI / 4;
+}
+
+// Compute the position (ix, iy) in its face of the pixel containing the
+// direction vec. Unlike the pixel index, the position still fits in an int
+// for the highest order (29) used by multi-order coverage maps.
+void healpix_vec2xyf(int nside, const double vec[3], int *ix, int *iy, int *face_num)
+{
+    double s = sqrt(vec[0] * vec[0] + vec[1] * vec[1]);
+    double z = vec[2] / sqrt(s * s + vec[2] * vec[2]);
+    double za = fabs(z);
+    double tt = atan2(vec[1], vec[0]) * 2 / M_PI;
+    long long jp, jm, ifp, ifm;
+    int ntt;
+    double tp, tmp;
+
+    if (tt < 0) tt += 4;
+    if (tt >= 4) tt -= 4;
+    if (za <= 2. / 3) {
+        // Equatorial region
+        double temp1 = nside * (0.5 + tt);
+        double temp2 = nside * (z * 0.75);
+        jp = (long long)(temp1 - temp2);
+        jm = (long long)(temp1 + temp2);
+        ifp = jp / nside;
+        ifm = jm / nside;
+        *face_num = (int)((ifp == ifm) ? (ifp | 4) : ((ifp < ifm) ? ifp : (ifm + 8)));
+        *ix = (int)(jm & (nside - 1));
+        *iy = (int)(nside - (jp & (nside - 1)) - 1);
+    } else {
+        // Polar caps, sqrt(3 * (1 - za)) computed without cancellation
+        ntt = (int)tt;
+        if (ntt >= 4) ntt = 3;
+        tp = tt - ntt;
+        tmp = nside * s / sqrt((s * s + vec[2] * vec[2]) * (1 + za) / 3);
+        jp = (long long)(tp * tmp);
+        jm = (long long)((1.0 - tp) * tmp);
+        if (jp >= nside) jp = nside - 1;
+        if (jm >= nside) jm = nside - 1;
+        if (z >= 0) {
+            *face_num = ntt;
+            *ix = (int)(nside - jm - 1);
+            *iy = (int)(nside - jp - 1);
+        } else {
+            *face_num = ntt + 8;
+            *ix = (int)jp;
+            *iy = (int)jm;
+        }
+    }
+}
@@ -53,41 +53,26 @@ Asterism::~Asterism()
 	asterism = Q_NULLPTR;
 }
 
-bool Asterism::read(const QString& record, StarMgr *starMgr)
+bool Asterism::read(const SkyCultureBundle::Lines& record, StarMgr *starMgr)
 {
-	abbreviation.clear();
-	numberOfSegments = 0;
-	typeOfAsterism = 1;
-	flagAsterism = true;
-
-	QString buf(record);
-	QTextStream istr(&buf, QIODevice::ReadOnly);
-	QString abb;
-	istr >> abb >> typeOfAsterism >> numberOfSegments;
-	if (istr.status()!=QTextStream::Ok)
-		return false;
-
 	// It's better to allow mixed-case abbreviations now that they can be displayed on screen. We then need toUpper() in comparisons.
-	//abbreviation = abb.toUpper();
-	abbreviation=abb;
+	abbreviation = record.abbreviation;
+	typeOfAsterism = record.type;
+	flagAsterism = true;
 
 	StelCore *core = StelApp::getInstance().getCore();
+	const int valuesPerPoint = (typeOfAsterism==2 ? 2 : 1);
+	numberOfSegments = static_cast<unsigned int>(record.points.size()/(2*valuesPerPoint));
 	asterism = new StelObjectP[numberOfSegments*2];
 	for (unsigned int i=0;i<numberOfSegments*2;++i)
 	{
+		const int idx = static_cast<int>(i)*valuesPerPoint;
 		switch (typeOfAsterism)
 		{
 			case 0: // Ray helpers
 			case 1: // A big asterism with lines by HIP stars
 			{
-				unsigned int HP = 0;
-				istr >> HP;
-				if(HP == 0)
-				{
-					// TODO: why is this delete commented?
-					// delete[] asterism;
-					return false;
-				}
+				const unsigned int HP = static_cast<unsigned int>(record.points.at(idx));
 				asterism[i]=starMgr->searchHP(static_cast<int>(HP));
 				if (!asterism[i])
 				{
@@ -98,10 +83,9 @@ bool Asterism::read(const QString& record, StarMgr *starMgr)
 			}
 			case 2: // A small asterism with lines by J2000.0 coordinates
 			{
-				double RA, DE;
+				const double RA = record.points.at(idx);
+				const double DE = record.points.at(idx+1);
 				Vec3d coords;
-
-				istr >> RA >> DE;				
 				StelUtils::spheToRect(RA*M_PI/12., DE*M_PI/180., coords);
 				QList<StelObjectP> stars = starMgr->searchAround(coords, 0.1, core);
 				StelObjectP s = Q_NULLPTR;
@@ -123,6 +107,9 @@ bool Asterism::read(const QString& record, StarMgr *starMgr)
 				}
 				break;
 			}
+			default:
+				qWarning() << "Error in Asterism " << abbreviation << ": unknown type" << typeOfAsterism;
+				return false;
 		}
 	}
 
@@ -23,6 +23,7 @@
 #include "StelObject.hpp"
 #include "StelUtils.hpp"
 #include "StelFader.hpp"
+#include "SkyCultureBundle.hpp"
 #include "StelSphereGeometry.hpp"
 #include "AsterismMgr.hpp"
 
@@ -66,14 +67,11 @@ private:
 
 	virtual double getAngularSize(const StelCore*) const {Q_ASSERT(0); return 0;} // TODO
 
-	//! @param record string containing the following whitespace
-	//! separated fields: abbreviation - a three character abbreviation
-	//! for the asterism, a number of lines (pairs), and a list of Hipparcos
-	//! catalogue numbers which, when connected pairwise, form the lines of the
-	//! asterism.
+	//! Create the asterism from a compiled lines record.
+	//! @param record the abbreviation, the type and the points of the lines of the asterism.
 	//! @param starMgr a pointer to the StarManager object.
-	//! @return false if can't parse record, else true.
-	bool read(const QString& record, StarMgr *starMgr);
+	//! @return false if a star of the record can't be found, else true.
+	bool read(const SkyCultureBundle::Lines& record, StarMgr *starMgr);
 
 	//! Draw the asterism name
 	void drawName(StelPainter& sPainter) const;
@@ -95,6 +93,11 @@ private:
 	void drawOptim(StelPainter& sPainter, const StelCore* core, const SphericalCap& viewportHalfspace) const;
 	//! Update fade levels according to time since various events.
 	void update(int deltaTime);
+	//! @return true if neither the lines nor the name of the asterism are visible anymore.
+	bool isFadedOut() const
+	{
+		return lineFader.getInterstate()==0.f && rayHelperFader.getInterstate()==0.f && nameFader.getInterstate()==0.f;
+	}
 	//! Turn on and off Asterism line rendering.
 	//! @param b new state for line drawing.
 	void setFlagLines(const bool b) { lineFader=b; }
@@ -29,7 +29,6 @@
 #include "StelSkyCultureMgr.hpp"
 #include "StelModuleMgr.hpp"
 #include "StelMovementMgr.hpp"
-#include "StelFileMgr.hpp"
 #include "StelCore.hpp"
 #include "StelPainter.hpp"
 #include "StelSkyDrawer.hpp"
@@ -37,12 +36,11 @@
 
 #include <vector>
 #include <QDebug>
-#include <QFile>
 #include <QSettings>
-#include <QRegExp>
 #include <QString>
 #include <QStringList>
 #include <QDir>
+#include <QtConcurrent>
 
 using namespace std;
 
@@ -55,6 +53,7 @@ AsterismMgr::AsterismMgr(StarMgr *_hip_stars)
 	, hasAsterism(false)
 	, asterismLineThickness(1)
 	, rayHelperThickness(1)
+	, flagAsyncLoading(true)
 {
 	setObjectName("AsterismMgr");
 	Q_ASSERT(hipStarMgr);
@@ -62,10 +61,17 @@ AsterismMgr::AsterismMgr(StarMgr *_hip_stars)
 
 AsterismMgr::~AsterismMgr()
 {
+	bundleLoader.waitForFinished();
+
 	for (auto* asterism : asterisms)
 	{
 		delete asterism;
 	}
+
+	for (auto* asterism : fadingAsterisms)
+	{
+		delete asterism;
+	}
 }
 
 void AsterismMgr::init()
@@ -80,6 +86,7 @@ void AsterismMgr::init()
 	setFlagLabels(conf->value("viewing/flag_asterism_name").toBool());
 	setAsterismLineThickness(conf->value("viewing/asterism_line_thickness", 1).toInt());
 	setRayHelperThickness(conf->value("viewing/rayhelper_line_thickness", 1).toInt());
+	flagAsyncLoading = conf->value("viewing/flag_skyculture_async_loading", true).toBool();
 
 	// Load colors from config file
 	QString defaultColor = conf->value("color/default_color").toString();
@@ -118,31 +125,54 @@ void AsterismMgr::updateSkyCulture(const QString& skyCultureDir)
 	if (!selectedObject.isEmpty()) // Unselect asterism
 		objMgr->unSelect();
 
+	// A bundle is already being loaded: the request is handled in update() when it is ready
+	if (!loadingSkyCulture.isEmpty())
+		return;
+
 	// Check if the sky culture changed since last load, if not don't load anything
 	if (lastLoadedSkyCulture == skyCultureDir)
 		return;
 
-	QString fic = StelFileMgr::findFile("skycultures/"+skyCultureDir+"/asterism_lines.fab");
-	if (fic.isEmpty())
+	// The bundle is shared with ConstellationMgr, which asks for it with the boundaries of the sky culture
+	const int boundariesIdx = StelApp::getInstance().getSkyCultureMgr().getCurrentSkyCultureBoundariesIdx();
+	if (!flagAsyncLoading || lastLoadedSkyCulture == "dummy")
 	{
-		hasAsterism = false;
-		qWarning() << "No asterisms for skyculture" << currentSkyCultureID;
+		applySkyCultureBundle(SkyCultureBundle::load(skyCultureDir, boundariesIdx));
+		return;
 	}
-	else
+
+	loadingSkyCulture = skyCultureDir;
+	bundleLoader = QtConcurrent::run(&SkyCultureBundle::load, skyCultureDir, boundariesIdx, true);
+}
+
+void AsterismMgr::applySkyCultureBundle(const SkyCultureBundle& bundle)
+{
+	StelObjectMgr* objMgr = GETSTELMODULE(StelObjectMgr);
+	if (!objMgr->getSelectedObject("Asterism").isEmpty()) // Unselect asterism, since we are going to delete it
+		objMgr->unSelect();
+
+	// The previous asterisms fade out while the new ones fade in
+	for (auto* asterism : asterisms)
 	{
-		hasAsterism = true;
-		loadLines(fic);
+		asterism->setFlagLines(false);
+		asterism->setFlagLabels(false);
+		asterism->setFlagRayHelpers(false);
+		fadingAsterisms.push_back(asterism);
 	}
+	asterisms.clear();
+
+	hasAsterism = bundle.hasAsterisms;
+	if (hasAsterism)
+		loadLines(bundle);
 
 	// load asterism names
-	fic = StelFileMgr::findFile("skycultures/" + skyCultureDir + "/asterism_names.eng.fab");
-	if (!fic.isEmpty())
-		loadNames(fic);
+	loadNames(bundle);
 
 	// Translate asterism names for the new sky culture
 	updateI18n();
 
-	lastLoadedSkyCulture = skyCultureDir;
+	lastLoadedSkyCulture = bundle.skyCultureDir;
+	emit skyCultureLoaded(lastLoadedSkyCulture);
 }
 
 void AsterismMgr::setLinesColor(const Vec3f& color)
@@ -226,44 +256,12 @@ void AsterismMgr::setRayHelperThickness(const int thickness)
 	}
 }
 
-void AsterismMgr::loadLines(const QString &fileName)
+void AsterismMgr::loadLines(const SkyCultureBundle& bundle)
 {
-	QFile in(fileName);
-	if (!in.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qWarning() << "Can't open asterism data file" << QDir::toNativeSeparators(fileName)  << "for culture" << currentSkyCultureID;
-		Q_ASSERT(0);
-	}
-
-	int totalRecords=0;
-	QString record;
-	QRegExp commentRx("^(\\s*#.*|\\s*)$");
-	while (!in.atEnd())
-	{
-		record = QString::fromUtf8(in.readLine());
-		if (!commentRx.exactMatch(record))
-			totalRecords++;
-	}
-	in.seek(0);
-
-	// delete existing data, if any
-	for (auto* asterism : asterisms)
-		delete asterism;
-
-	asterisms.clear();
-	Asterism *aster = Q_NULLPTR;
-
-	// read the file of line patterns, adding a record per non-comment line
-	int currentLineNumber = 0;	// line in file
 	int readOk = 0;			// count of records processed OK
-	while (!in.atEnd())
+	for (const auto& record : bundle.asterismLines)
 	{
-		record = QString::fromUtf8(in.readLine());
-		currentLineNumber++;
-		if (commentRx.exactMatch(record))
-			continue;
-
-		aster = new Asterism;
+		Asterism *aster = new Asterism;
 		if(aster->read(record, hipStarMgr))
 		{
 			aster->setFlagLines(linesDisplayed);
@@ -274,12 +272,11 @@ void AsterismMgr::loadLines(const QString &fileName)
 		}
 		else
 		{
-			qWarning() << "ERROR reading asterism lines record at line " << currentLineNumber << "for culture" << currentSkyCultureID;
+			qWarning() << "ERROR reading asterism lines record" << record.abbreviation << "for culture" << bundle.skyCultureDir;
 			delete aster;
 		}
 	}
-	in.close();
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "asterism records successfully for culture" << currentSkyCultureID;
+	qDebug() << "Loaded" << readOk << "/" << bundle.asterismLines.size() << "asterism records successfully for culture" << bundle.skyCultureDir;
 
 	// Set current states
 	setFlagLines(linesDisplayed);
@@ -300,7 +297,7 @@ void AsterismMgr::draw(StelCore* core)
 // Draw asterisms lines
 void AsterismMgr::drawLines(StelPainter& sPainter, const StelCore* core) const
 {
-	if (!hasAsterism)
+	if (!hasAsterism && fadingAsterisms.empty())
 		return;
 
 	sPainter.setBlending(true);
@@ -309,6 +306,11 @@ void AsterismMgr::drawLines(StelPainter& sPainter, const StelCore* core) const
 	sPainter.setLineSmooth(true);
 
 	const SphericalCap& viewportHalfspace = sPainter.getProjector()->getBoundingCap();
+	for (auto* asterism : fadingAsterisms)
+	{
+		if (asterism->isAsterism())
+			asterism->drawOptim(sPainter, core, viewportHalfspace);
+	}
 	for (auto* asterism : asterisms)
 	{
 		if (asterism->isAsterism())
@@ -322,7 +324,7 @@ void AsterismMgr::drawLines(StelPainter& sPainter, const StelCore* core) const
 // Draw asterisms lines
 void AsterismMgr::drawRayHelpers(StelPainter& sPainter, const StelCore* core) const
 {
-	if (!hasAsterism)
+	if (!hasAsterism && fadingAsterisms.empty())
 		return;
 
 	sPainter.setBlending(true);
@@ -331,6 +333,11 @@ void AsterismMgr::drawRayHelpers(StelPainter& sPainter, const StelCore* core) co
 	sPainter.setLineSmooth(true);
 
 	const SphericalCap& viewportHalfspace = sPainter.getProjector()->getBoundingCap();
+	for (auto* asterism : fadingAsterisms)
+	{
+		if (!asterism->isAsterism())
+			asterism->drawOptim(sPainter, core, viewportHalfspace);
+	}
 	for (auto* asterism : asterisms)
 	{
 		if (!asterism->isAsterism())
@@ -344,10 +351,15 @@ void AsterismMgr::drawRayHelpers(StelPainter& sPainter, const StelCore* core) co
 // Draw the names of all the asterisms
 void AsterismMgr::drawNames(StelPainter& sPainter) const
 {
-	if (!hasAsterism)
+	if (!hasAsterism && fadingAsterisms.empty())
 		return;
 
 	sPainter.setBlending(true);
+	for (auto* asterism : fadingAsterisms)
+	{
+		if (asterism->flagAsterism && sPainter.getProjector()->projectCheck(asterism->XYZname, asterism->XYname))
+			asterism->drawName(sPainter);
+	}
 	for (auto* asterism : asterisms)
 	{
 		if (!asterism->flagAsterism) continue;
@@ -386,82 +398,28 @@ QList<StelObjectP> AsterismMgr::searchAround(const Vec3d&, double, const StelCor
 	return QList<StelObjectP>();
 }
 
-void AsterismMgr::loadNames(const QString& namesFile)
+void AsterismMgr::loadNames(const SkyCultureBundle& bundle)
 {
 	// Asterism not loaded yet
 	if (asterisms.empty()) return;
 
-	// clear previous names
-	for (auto* asterism : asterisms)
-	{
-		asterism->englishName.clear();
-	}
-
-	// Open file
-	QFile commonNameFile(namesFile);
-	if (!commonNameFile.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qDebug() << "Cannot open file" << QDir::toNativeSeparators(namesFile);
-		return;
-	}
-
-	// Now parse the file
-	// lines to ignore which start with a # or are empty
-	QRegExp commentRx("^(\\s*#.*|\\s*)$");
-	QRegExp recRx("^\\s*(\\w+)\\s+_[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)\\n");
-	QRegExp ctxRx("(.*)\",\\s*\"(.*)");
-
-	// Some more variables to use in the parsing
-	Asterism *aster;
-	QString record, shortName, ctxt;
-
-	// keep track of how many records we processed.
-	int totalRecords=0;
 	int readOk=0;
-	int lineNumber=0;
-	while (!commonNameFile.atEnd())
+	for (const auto& name : bundle.asterismNames)
 	{
-		record = QString::fromUtf8(commonNameFile.readLine());
-		lineNumber++;
-
-		// Skip comments
-		if (commentRx.exactMatch(record))
-			continue;
-
-		totalRecords++;
-
-		if (!recRx.exactMatch(record))
+		Asterism *aster = findFromAbbreviation(name.abbreviation);
+		// If the asterism exists, set the English name
+		if (aster != Q_NULLPTR)
 		{
-			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in asterism names file" << QDir::toNativeSeparators(namesFile) << ":" << record;
+			aster->englishName = name.englishName;
+			aster->context = name.context;
+			readOk++;
 		}
 		else
 		{
-			shortName = recRx.capturedTexts().at(1);
-			aster = findFromAbbreviation(shortName);
-			// If the asterism exists, set the English name
-			if (aster != Q_NULLPTR)
-			{
-				ctxt = recRx.capturedTexts().at(2);
-				if (ctxRx.exactMatch(ctxt))
-				{
-					aster->englishName = ctxRx.capturedTexts().at(1);
-					aster->context = ctxRx.capturedTexts().at(2);
-				}
-				else
-				{
-					aster->englishName = ctxt;
-					aster->context = "";
-				}
-				readOk++;
-			}
-			else
-			{
-				qWarning() << "WARNING - asterism abbreviation" << shortName << "not found when loading asterism names";
-			}
+			qWarning() << "WARNING - asterism abbreviation" << name.abbreviation << "not found when loading asterism names";
 		}
 	}
-	commonNameFile.close();
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "asterism names";
+	qDebug() << "Loaded" << readOk << "/" << bundle.asterismNames.size() << "asterism names";
 }
 
 void AsterismMgr::updateI18n()
@@ -481,6 +439,43 @@ void AsterismMgr::update(double deltaTime)
 	{
 		asterism->update(delta);
 	}
+
+	// Delete the asterisms of the previous sky culture once they are invisible
+	for (auto it = fadingAsterisms.begin(); it != fadingAsterisms.end();)
+	{
+		(*it)->update(delta);
+		if ((*it)->isFadedOut())
+		{
+			delete *it;
+			it = fadingAsterisms.erase(it);
+		}
+		else
+			++it;
+	}
+
+	// Switch to the sky culture loaded in the background
+	if (!loadingSkyCulture.isEmpty() && bundleLoader.isFinished())
+		switchToLoadedSkyCulture();
+}
+
+void AsterismMgr::switchToLoadedSkyCulture()
+{
+	const QString loadedSkyCulture = loadingSkyCulture;
+	loadingSkyCulture.clear();
+	if (loadedSkyCulture == currentSkyCultureID)
+		applySkyCultureBundle(bundleLoader.result());
+	else
+		updateSkyCulture(currentSkyCultureID); // the sky culture changed again in the meantime
+}
+
+void AsterismMgr::finishSkyCultureLoading()
+{
+	// A new background load may be started if the sky culture changed in the meantime
+	while (!loadingSkyCulture.isEmpty())
+	{
+		bundleLoader.waitForFinished();
+		switchToLoadedSkyCulture();
+	}
 }
 
 void AsterismMgr::setFlagLines(const bool displayed)
@@ -23,11 +23,13 @@
 #include "StelObjectType.hpp"
 #include "StelObjectModule.hpp"
 #include "StelProjectorType.hpp"
+#include "SkyCultureBundle.hpp"
 
 #include <vector>
 #include <QString>
 #include <QStringList>
 #include <QFont>
+#include <QFuture>
 
 class StelToneReproducer;
 class StarMgr;
@@ -98,6 +100,10 @@ public:
 	//! Updates time-varying state for each asterism.
 	virtual void update(double deltaTime);
 
+	//! Wait for the sky culture being loaded in the background, if any, and install its asterisms at once.
+	//! Used where the asterisms of a new sky culture are needed right after the change, e.g. by scripts.
+	void finishSkyCultureLoading();
+
 	//! Return the value defining the order of call for the given action
 	//! @param actionName the name of the action for which we want the call order
 	//! @return the value defining the order. The closer to 0 the earlier the module's action will be called
@@ -205,6 +211,9 @@ signals:
 	void rayHelpersColorChanged(const Vec3f & color) const;
 	void rayHelpersDisplayedChanged(const bool displayed) const;
 	void rayHelperThicknessChanged(int thickness) const;
+	//! Emitted once the asterisms of a new sky culture are installed, which may happen some frames
+	//! after the sky culture change when the sky culture is loaded in the background.
+	void skyCultureLoaded(const QString& skyCultureDir) const;
 
 private slots:
 	//! Loads new asterism data and art if the SkyCulture has changed.
@@ -218,16 +227,20 @@ private slots:
 	void updateI18n();
 
 private:
-	//! Read asterism names from the given file.
-	//! @param namesFile Name of the file containing the asterism names
-	//!        in a format consisting of abbreviation and translatable english name.
-	//! @note The abbreviation must occur in the lines file loaded first in @name loadLines()!
-	void loadNames(const QString& namesFile);
+	//! Replace the loaded asterisms by the ones of a compiled sky culture bundle.
+	//! The previous asterisms are kept until they have faded out.
+	void applySkyCultureBundle(const SkyCultureBundle& bundle);
+
+	//! Install the bundle loaded in the background, or load the requested sky culture again
+	//! if it changed while the bundle was being loaded.
+	void switchToLoadedSkyCulture();
 
-	//! Load asterism line shapes from data files.
-	//! @param fileName The name of the asterism data file
-	//! @note The abbreviation used in @param filename is required for cross-identifying translatable names in @name loadNames():
-	void loadLines(const QString& fileName);
+	//! Set the asterism names.
+	//! @note The abbreviation must occur in the lines loaded first in @name loadLines()!
+	void loadNames(const SkyCultureBundle& bundle);
+
+	//! Create the asterisms from the lines of the bundle.
+	void loadLines(const SkyCultureBundle& bundle);
 
 	//! Draw the asterism lines at the epoch given by the StelCore.
 	void drawLines(StelPainter& sPainter, const StelCore* core) const;
@@ -247,6 +260,10 @@ private:
 
 	QString lastLoadedSkyCulture;	// Store the last loaded sky culture directory name
 	QString currentSkyCultureID;
+	QString loadingSkyCulture;	// Sky culture directory name of the bundle being loaded in the background, if any
+	QFuture<SkyCultureBundle> bundleLoader;
+	// Asterisms of the previous sky culture, deleted once faded out
+	std::vector<Asterism*> fadingAsterisms;
 
 	bool linesDisplayed;
 	bool rayHelpersDisplayed;
@@ -256,6 +273,8 @@ private:
 	// Store the thickness of lines of the asterisms
 	int asterismLineThickness;
 	int rayHelperThickness;
+
+	bool flagAsyncLoading;
 };
 
 #endif // ASTERISMMGR_HPP
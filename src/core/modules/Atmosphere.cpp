@@ -33,15 +33,7 @@
 
 
 Atmosphere::Atmosphere(void)
-	: viewport(0,0,0,0)
-	, skyResolutionY(44)
-	, skyResolutionX(44)
-	, posGrid(Q_NULLPTR)
-	, posGridBuffer(QOpenGLBuffer::VertexBuffer)
-	, indicesBuffer(QOpenGLBuffer::IndexBuffer)
-	, colorGrid(Q_NULLPTR)
-	, colorGridBuffer(QOpenGLBuffer::VertexBuffer)
-	, averageLuminance(0.f)
+	: averageLuminance(0.f)
 	, overrideAverageLuminance(false)
 	, eclipseFactor(1.f)
 	, lightPollutionLuminance(0)
@@ -104,84 +96,48 @@ Atmosphere::Atmosphere(void)
 }
 
 Atmosphere::~Atmosphere(void)
+{
+	qDeleteAll(grids);
+	grids.clear();
+	delete atmoShaderProgram;
+	atmoShaderProgram = Q_NULLPTR;
+}
+
+Atmosphere::Grid::Grid()
+	: viewport(0,0,0,0)
+	, skyResolutionY(44)
+	, skyResolutionX(44)
+	, posGrid(Q_NULLPTR)
+	, posGridBuffer(QOpenGLBuffer::VertexBuffer)
+	, indicesBuffer(QOpenGLBuffer::IndexBuffer)
+	, colorGrid(Q_NULLPTR)
+	, colorGridBuffer(QOpenGLBuffer::VertexBuffer)
+{
+}
+
+Atmosphere::Grid::~Grid()
 {
 	delete [] posGrid;
 	posGrid = Q_NULLPTR;
 	delete[] colorGrid;
 	colorGrid = Q_NULLPTR;
-	delete atmoShaderProgram;
-	atmoShaderProgram = Q_NULLPTR;
+}
+
+Atmosphere::Grid& Atmosphere::currentGrid(const StelCore* core)
+{
+	const int index = core->getCurrentCamera()+1;
+	// Drop the grids of removed cameras
+	const int count = core->getCameras().size()+1;
+	while (grids.size()>count)
+		delete grids.takeLast();
+	while (grids.size()<=index)
+		grids.append(new Grid());
+	return *grids[index];
 }
 
 void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moonPhase, float moonMagnitude,
 							   StelCore* core, float latitude, float altitude, float temperature, float relativeHumidity)
 {
-	const StelProjectorP prj = core->getProjection(StelCore::FrameAltAz, StelCore::RefractionOff);
-	if (viewport != prj->getViewport())
-	{
-		// The viewport changed: update the number of point of the grid
-		viewport = prj->getViewport();
-		delete[] colorGrid;
-		delete [] posGrid;
-		skyResolutionY = StelApp::getInstance().getSettings()->value("landscape/atmosphereybin", 44).toUInt();
-		skyResolutionX = static_cast<unsigned int>(floorf(0.5f+skyResolutionY*(0.5f*sqrtf(3.0f))*prj->getViewportWidth()/prj->getViewportHeight()));
-		posGrid = new Vec2f[static_cast<size_t>((1+skyResolutionX)*(1+skyResolutionY))];
-		colorGrid = new Vec4f[static_cast<size_t>((1+skyResolutionX)*(1+skyResolutionY))];
-		float stepX = static_cast<float>(prj->getViewportWidth()) / static_cast<float>(skyResolutionX-0.5f);
-		float stepY = static_cast<float>(prj->getViewportHeight()) / skyResolutionY;
-		float viewport_left = prj->getViewportPosX();
-		float viewport_bottom = prj->getViewportPosY();
-		for (unsigned int x=0; x<=skyResolutionX; ++x)
-		{
-			for(unsigned int y=0; y<=skyResolutionY; ++y)
-			{
-				Vec2f &v(posGrid[y*(1+skyResolutionX)+x]);
-				v[0] = viewport_left + ((x == 0) ? 0.f :
-						(x == skyResolutionX) ? prj->getViewportWidth() : (x-0.5f*(y&1))*stepX);
-				v[1] = viewport_bottom+y*stepY;
-			}
-		}
-		posGridBuffer.destroy();
-		//posGridBuffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-		Q_ASSERT(posGridBuffer.type()==QOpenGLBuffer::VertexBuffer);
-		posGridBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
-		posGridBuffer.create();
-		posGridBuffer.bind();
-		posGridBuffer.allocate(posGrid, (1+skyResolutionX)*(1+skyResolutionY)*8);
-		posGridBuffer.release();
-		
-		// Generate the indices used to draw the quads
-		unsigned short* indices = new unsigned short[static_cast<size_t>((skyResolutionX+1)*skyResolutionY*2)];
-		int i=0;
-		for (unsigned int y2=0; y2<skyResolutionY; ++y2)
-		{
-			unsigned short g0 = static_cast<unsigned short>(y2*(1+skyResolutionX));
-			unsigned short g1 = static_cast<unsigned short>((y2+1)*(1+skyResolutionX));
-			for (unsigned int x2=0; x2<=skyResolutionX; ++x2)
-			{
-				indices[i++]=g0++;
-				indices[i++]=g1++;
-			}
-		}
-		indicesBuffer.destroy();
-		//indicesBuffer = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
-		Q_ASSERT(indicesBuffer.type()==QOpenGLBuffer::IndexBuffer);
-		indicesBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
-		indicesBuffer.create();
-		indicesBuffer.bind();
-		indicesBuffer.allocate(indices, static_cast<int>((skyResolutionX+1)*skyResolutionY*2*2));
-		indicesBuffer.release();
-		delete[] indices;
-		indices=Q_NULLPTR;
-		
-		colorGridBuffer.destroy();
-		colorGridBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
-		colorGridBuffer.create();
-		colorGridBuffer.bind();
-		colorGridBuffer.allocate(colorGrid, static_cast<int>((1+skyResolutionX)*(1+skyResolutionY)*4*4));
-		colorGridBuffer.release();
-	}
-
 	if (qIsNaN(_sunPos.length()))
 		_sunPos.set(0.,0.,-1.*AU);
 	if (qIsNaN(moonPos.length()))
@@ -197,8 +153,8 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 	_sunPos.normalize();
 	moonPos.normalize();
 	// Calculate the atmosphere RGB for each point of the grid. We can use abbreviated numbers here.
-	Vec3f sunPosF=_sunPos.toVec3f();
-	Vec3f moonPosF=moonPos.toVec3f();
+	sunPosF=_sunPos.toVec3f();
+	moonPosF=moonPos.toVec3f();
 
 	double separation_angle = std::acos(_sunPos.dot(moonPos));  // angle between them
 	// qDebug("touch at %f\tnow at %f (%f)\n", touch_angle, separation_angle, separation_angle/touch_angle);
@@ -246,6 +202,81 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
 	skyb.setDate(year, month, moonPhase, moonMagnitude);
 
+	Grid& grid = currentGrid(core);
+	const float sum_lum = computeGridColors(grid, core->getProjection(StelCore::FrameAltAz, StelCore::RefractionOff));
+
+	// Update average luminance
+	if (!overrideAverageLuminance)
+		averageLuminance = sum_lum/((1+grid.skyResolutionX)*(1+grid.skyResolutionY));
+}
+
+float Atmosphere::computeGridColors(Grid& grid, const StelProjectorP& prj)
+{
+	if (grid.viewport != prj->getViewport())
+	{
+		// The viewport changed: update the number of point of the grid
+		grid.viewport = prj->getViewport();
+		delete[] grid.colorGrid;
+		delete [] grid.posGrid;
+		grid.skyResolutionY = StelApp::getInstance().getSettings()->value("landscape/atmosphereybin", 44).toUInt();
+		grid.skyResolutionX = static_cast<unsigned int>(floorf(0.5f+grid.skyResolutionY*(0.5f*sqrtf(3.0f))*prj->getViewportWidth()/prj->getViewportHeight()));
+		grid.posGrid = new Vec2f[static_cast<size_t>((1+grid.skyResolutionX)*(1+grid.skyResolutionY))];
+		grid.colorGrid = new Vec4f[static_cast<size_t>((1+grid.skyResolutionX)*(1+grid.skyResolutionY))];
+		float stepX = static_cast<float>(prj->getViewportWidth()) / static_cast<float>(grid.skyResolutionX-0.5f);
+		float stepY = static_cast<float>(prj->getViewportHeight()) / grid.skyResolutionY;
+		float viewport_left = prj->getViewportPosX();
+		float viewport_bottom = prj->getViewportPosY();
+		for (unsigned int x=0; x<=grid.skyResolutionX; ++x)
+		{
+			for(unsigned int y=0; y<=grid.skyResolutionY; ++y)
+			{
+				Vec2f &v(grid.posGrid[y*(1+grid.skyResolutionX)+x]);
+				v[0] = viewport_left + ((x == 0) ? 0.f :
+						(x == grid.skyResolutionX) ? prj->getViewportWidth() : (x-0.5f*(y&1))*stepX);
+				v[1] = viewport_bottom+y*stepY;
+			}
+		}
+		grid.posGridBuffer.destroy();
+		//grid.posGridBuffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+		Q_ASSERT(grid.posGridBuffer.type()==QOpenGLBuffer::VertexBuffer);
+		grid.posGridBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+		grid.posGridBuffer.create();
+		grid.posGridBuffer.bind();
+		grid.posGridBuffer.allocate(grid.posGrid, (1+grid.skyResolutionX)*(1+grid.skyResolutionY)*8);
+		grid.posGridBuffer.release();
+		
+		// Generate the indices used to draw the quads
+		unsigned short* indices = new unsigned short[static_cast<size_t>((grid.skyResolutionX+1)*grid.skyResolutionY*2)];
+		int i=0;
+		for (unsigned int y2=0; y2<grid.skyResolutionY; ++y2)
+		{
+			unsigned short g0 = static_cast<unsigned short>(y2*(1+grid.skyResolutionX));
+			unsigned short g1 = static_cast<unsigned short>((y2+1)*(1+grid.skyResolutionX));
+			for (unsigned int x2=0; x2<=grid.skyResolutionX; ++x2)
+			{
+				indices[i++]=g0++;
+				indices[i++]=g1++;
+			}
+		}
+		grid.indicesBuffer.destroy();
+		//grid.indicesBuffer = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+		Q_ASSERT(grid.indicesBuffer.type()==QOpenGLBuffer::IndexBuffer);
+		grid.indicesBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+		grid.indicesBuffer.create();
+		grid.indicesBuffer.bind();
+		grid.indicesBuffer.allocate(indices, static_cast<int>((grid.skyResolutionX+1)*grid.skyResolutionY*2*2));
+		grid.indicesBuffer.release();
+		delete[] indices;
+		indices=Q_NULLPTR;
+		
+		grid.colorGridBuffer.destroy();
+		grid.colorGridBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+		grid.colorGridBuffer.create();
+		grid.colorGridBuffer.bind();
+		grid.colorGridBuffer.allocate(grid.colorGrid, static_cast<int>((1+grid.skyResolutionX)*(1+grid.skyResolutionY)*4*4));
+		grid.colorGridBuffer.release();
+	}
+
 	// Variables used to compute the average sky luminance
 	float sum_lum = 0.f;
 
@@ -253,9 +284,9 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 	float lumi;
 
 	// Compute the sky color for every point above the ground
-	for (unsigned int i=0; i<(1+skyResolutionX)*(1+skyResolutionY); ++i)
+	for (unsigned int i=0; i<(1+grid.skyResolutionX)*(1+grid.skyResolutionY); ++i)
 	{
-		const Vec2f &v(posGrid[i]);
+		const Vec2f &v(grid.posGrid[i]);
 		prj->unProject(static_cast<double>(v[0]),static_cast<double>(v[1]),point);
 
 		Q_ASSERT(fabs(point.lengthSquared()-1.0) < 1e-10);
@@ -288,16 +319,14 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 		// Now need to compute the xy part of the color component
 		// This is done in the openGL shader
 		// Store the back projected position + luminance in the input color to the shader
-		colorGrid[i].set(pointF[0], pointF[1], pointF[2], lumi);
+		grid.colorGrid[i].set(pointF[0], pointF[1], pointF[2], lumi);
 	}
 	
-	colorGridBuffer.bind();
-	colorGridBuffer.write(0, colorGrid, static_cast<int>((1+skyResolutionX)*(1+skyResolutionY)*4*4));
-	colorGridBuffer.release();
-	
-	// Update average luminance
-	if (!overrideAverageLuminance)
-		averageLuminance = sum_lum/((1+skyResolutionX)*(1+skyResolutionY));
+	grid.colorGridBuffer.bind();
+	grid.colorGridBuffer.write(0, grid.colorGrid, static_cast<int>((1+grid.skyResolutionX)*(1+grid.skyResolutionY)*4*4));
+	grid.colorGridBuffer.release();
+
+	return sum_lum;
 }
 
 // override computable luminance. This is for special operations only, e.g. for scripting of brightness-balanced image export.
@@ -327,6 +356,11 @@ void Atmosphere::draw(StelCore* core)
 	if (!fader.getInterstate())
 		return;
 
+	// The colors of the main view are computed in computeColor(), those of the cameras are computed here
+	Grid& grid = currentGrid(core);
+	if (core->getCurrentCamera()>=0)
+		computeGridColors(grid, core->getProjection(StelCore::FrameAltAz, StelCore::RefractionOff));
+
 	StelPainter sPainter(core->getProjection2d());
 	sPainter.setBlending(true, GL_ONE, GL_ONE);
 
@@ -368,24 +402,24 @@ void Atmosphere::draw(StelCore* core)
 	gl.glBindTexture(GL_TEXTURE_2D, bayerPatternTex);
 	atmoShaderProgram->setUniformValue(shaderAttribLocations.bayerPattern, 1);
 	
-	colorGridBuffer.bind();
+	grid.colorGridBuffer.bind();
 	atmoShaderProgram->setAttributeBuffer(shaderAttribLocations.skyColor, GL_FLOAT, 0, 4, 0);
-	colorGridBuffer.release();
+	grid.colorGridBuffer.release();
 	atmoShaderProgram->enableAttributeArray(shaderAttribLocations.skyColor);
-	posGridBuffer.bind();
+	grid.posGridBuffer.bind();
 	atmoShaderProgram->setAttributeBuffer(shaderAttribLocations.skyVertex, GL_FLOAT, 0, 2, 0);
-	posGridBuffer.release();
+	grid.posGridBuffer.release();
 	atmoShaderProgram->enableAttributeArray(shaderAttribLocations.skyVertex);
 
 	// And draw everything at once
-	indicesBuffer.bind();
+	grid.indicesBuffer.bind();
 	std::size_t shift=0;
-	for (unsigned int y=0;y<skyResolutionY;++y)
+	for (unsigned int y=0;y<grid.skyResolutionY;++y)
 	{
-		sPainter.glFuncs()->glDrawElements(GL_TRIANGLE_STRIP, static_cast<int>((skyResolutionX+1)*2), GL_UNSIGNED_SHORT, reinterpret_cast<void*>(shift));
-		shift += static_cast<size_t>((skyResolutionX+1)*2*2);
+		sPainter.glFuncs()->glDrawElements(GL_TRIANGLE_STRIP, static_cast<int>((grid.skyResolutionX+1)*2), GL_UNSIGNED_SHORT, reinterpret_cast<void*>(shift));
+		shift += static_cast<size_t>((grid.skyResolutionX+1)*2*2);
 	}
-	indicesBuffer.release();
+	grid.indicesBuffer.release();
 	
 	atmoShaderProgram->disableAttributeArray(shaderAttribLocations.skyVertex);
 	atmoShaderProgram->disableAttributeArray(shaderAttribLocations.skyColor);
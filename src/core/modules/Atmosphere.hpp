@@ -26,8 +26,10 @@
 
 #include "Skybright.hpp"
 #include "StelFader.hpp"
+#include "StelProjectorType.hpp"
 
 #include <QOpenGLBuffer>
+#include <QVector>
 
 class StelProjector;
 class StelToneReproducer;
@@ -76,22 +78,41 @@ public:
 	//! override computable luminance. This is for special operations only, e.g. for scripting of brightness-balanced image export.
 	//! To return to auto-computed values, set any negative value at the end of the script.
 	void setAverageLuminance(float overrideLum);
+	//! @return true if the average luminance is frozen by setAverageLuminance()
+	bool isAverageLuminanceOverridden() const { return overrideAverageLuminance; }
 	//! Set the light pollution luminance in cd/m^2
 	void setLightPollutionLuminance(float f) { lightPollutionLuminance = f; }
 	//! Get the light pollution luminance in cd/m^2
 	float getLightPollutionLuminance() const { return lightPollutionLuminance; }
 
 private:
-	Vec4i viewport;
 	Skylight sky;
 	Skybright skyb;
-	unsigned int skyResolutionY,skyResolutionX;
 
-	Vec2f* posGrid;
-	QOpenGLBuffer posGridBuffer;
-	QOpenGLBuffer indicesBuffer;
-	Vec4f* colorGrid;
-	QOpenGLBuffer colorGridBuffer;
+	//! The grid of sky points drawn in one view
+	struct Grid
+	{
+		Grid();
+		~Grid();
+		Vec4i viewport;
+		unsigned int skyResolutionY,skyResolutionX;
+		Vec2f* posGrid;
+		QOpenGLBuffer posGridBuffer;
+		QOpenGLBuffer indicesBuffer;
+		Vec4f* colorGrid;
+		QOpenGLBuffer colorGridBuffer;
+	};
+	//! One grid for the main view and one for each camera, indexed by StelCore::getCurrentCamera()+1,
+	//! so that drawing the cameras does not reallocate the grid of the main view every frame.
+	QVector<Grid*> grids;
+	//! Get the grid of the view being drawn, creating it if needed.
+	Grid& currentGrid(const StelCore* core);
+
+	//! Update the grid for the viewport of the projector if needed, and compute the sky color at its points.
+	//! @return the sum of the luminance of the points.
+	float computeGridColors(Grid& grid, const StelProjectorP& prj);
+	//! The directions of the sun and the moon in the alt-azimuthal frame
+	Vec3f sunPosF, moonPosF;
 
 	//! The average luminance of the atmosphere in cd/m2
 	float averageLuminance;
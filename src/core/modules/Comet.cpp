@@ -567,6 +567,9 @@ void Comet::draw(StelCore* core, float maxMagLabels, const QFont& planetNameFont
 		drawOrbit(core);  // TODO - fade in here also...
 
 		labelsFader = (flagLabels && ang_dist>0.25f && maxMagLabels>getVMagnitude(core));
+		// Flush the orbit batch so that the label, the hint and the coma cover the orbit lines drawn so far
+		if (labelsFader.getInterstate()>0.f || screenSz>1.f)
+			drawOrbitBatch(core);
 		drawHints(core, planetNameFont);
 
 		draw3dModel(core,transfo,screenSz);
@@ -60,42 +60,20 @@ Constellation::~Constellation()
 	constellation = Q_NULLPTR;
 }
 
-bool Constellation::read(const QString& record, StarMgr *starMgr)
+bool Constellation::read(const SkyCultureBundle::Lines& record, StarMgr *starMgr)
 {
-	unsigned int HP;
-
-	abbreviation.clear();
-	numberOfSegments = 0;
-
-	QString buf(record);
-	QTextStream istr(&buf, QIODevice::ReadOnly);
-	QString abb;
-	istr >> abb >> numberOfSegments;
-	if (istr.status()!=QTextStream::Ok)
-		return false;
-
 	// It's better to allow mixed-case abbreviations now that they can be displayed on screen. We then need toUpper() in comparisons.
-	//abbreviation = abb.toUpper();
-	abbreviation=abb;
+	abbreviation = record.abbreviation;
+	numberOfSegments = static_cast<unsigned int>(record.points.size()/2);
 
 	constellation = new StelObjectP[numberOfSegments*2];
 	for (unsigned int i=0;i<numberOfSegments*2;++i)
 	{
-		HP = 0;
-		istr >> HP;
-		if(HP == 0)
-		{
-			// TODO: why is this delete commented?
-			// delete[] constellation;
-			return false;
-		}
-
+		const unsigned int HP = static_cast<unsigned int>(record.points.at(static_cast<int>(i)));
 		constellation[i]=starMgr->searchHP(static_cast<int>(HP));
 		if (!constellation[i])
 		{
 			qWarning() << "Error in Constellation " << abbreviation << ": can't find star HIP" << HP;
-			// TODO: why is this delete commented?
-			// delete[] constellation;
 			return false;
 		}
 	}
@@ -25,6 +25,7 @@
 #include "StelObject.hpp"
 #include "StelUtils.hpp"
 #include "StelFader.hpp"
+#include "SkyCultureBundle.hpp"
 #include "StelTextureTypes.hpp"
 #include "StelSphereGeometry.hpp"
 #include "ConstellationMgr.hpp"
@@ -74,14 +75,11 @@ private:
 
 	virtual double getAngularSize(const StelCore*) const {Q_ASSERT(0); return 0.;} // TODO
 
-	//! @param record string containing the following whitespace
-	//! separated fields: abbreviation - a three character abbreviation
-	//! for the constellation, a number of lines (pairs), and a list of Hipparcos
-	//! catalogue numbers which, when connected pairwise, form the lines of the
-	//! constellation.
+	//! Create the constellation from a compiled lines record.
+	//! @param record the abbreviation, the type and the points of the lines of the constellation.
 	//! @param starMgr a pointer to the StarManager object.
-	//! @return false if can't parse record, else true.
-	bool read(const QString& record, StarMgr *starMgr);
+	//! @return false if a star of the record can't be found, else true.
+	bool read(const SkyCultureBundle::Lines& record, StarMgr *starMgr);
 
 	//! Draw the constellation name
 	void drawName(StelPainter& sPainter, ConstellationMgr::ConstellationDisplayStyle style) const;
@@ -117,6 +115,12 @@ private:
 	void drawArtOptim(StelPainter& sPainter, const SphericalRegion& region) const;
 	//! Update fade levels according to time since various events.
 	void update(int deltaTime);
+	//! @return true if no part of the constellation is visible anymore.
+	bool isFadedOut() const
+	{
+		return lineFader.getInterstate()==0.f && nameFader.getInterstate()==0.f
+		    && artFader.getInterstate()==0.f && boundaryFader.getInterstate()==0.f;
+	}
 	//! Turn on and off Constellation line rendering.
 	//! @param b new state for line drawing.
 	void setFlagLines(const bool b) {lineFader=b;}
@@ -31,7 +31,6 @@
 #include "StelSkyCultureMgr.hpp"
 #include "StelModuleMgr.hpp"
 #include "StelMovementMgr.hpp"
-#include "StelFileMgr.hpp"
 #include "StelCore.hpp"
 #include "StelPainter.hpp"
 #include "StelSkyDrawer.hpp"
@@ -39,12 +38,11 @@
 
 #include <vector>
 #include <QDebug>
-#include <QFile>
 #include <QSettings>
-#include <QRegExp>
 #include <QString>
 #include <QStringList>
 #include <QDir>
+#include <QtConcurrent>
 
 using namespace std;
 
@@ -53,6 +51,7 @@ ConstellationMgr::ConstellationMgr(StarMgr *_hip_stars)
 	: hipStarMgr(_hip_stars),
 	  isolateSelected(false),
 	  constellationPickEnabled(false),
+	  flagAsyncLoading(true),
 	  constellationDisplayStyle(ConstellationMgr::constellationsTranslated),
 	  artFadeDuration(2.),
 	  artIntensity(0),
@@ -72,6 +71,8 @@ ConstellationMgr::ConstellationMgr(StarMgr *_hip_stars)
 
 ConstellationMgr::~ConstellationMgr()
 {
+	bundleLoader.waitForFinished();
+
 	for (auto* constellation : constellations)
 	{
 		delete constellation;
@@ -81,6 +82,16 @@ ConstellationMgr::~ConstellationMgr()
 	{
 		delete segment;
 	}
+
+	for (auto* constellation : fadingConstellations)
+	{
+		delete constellation;
+	}
+
+	for (auto* segment : fadingBoundarySegments)
+	{
+		delete segment;
+	}
 }
 
 void ConstellationMgr::init()
@@ -102,6 +113,7 @@ void ConstellationMgr::init()
 	setConstellationLineThickness(conf->value("viewing/constellation_boundaries_thickness", 1).toInt());
 	// The setting for developers
 	setFlagCheckLoadingData(conf->value("devel/check_loading_constellation_data","false").toBool());
+	flagAsyncLoading = conf->value("viewing/flag_skyculture_async_loading", true).toBool();
 
 	QString starloreDisplayStyle=conf->value("viewing/constellation_name_style", "translated").toString();
 	static const QMap<QString, ConstellationDisplayStyle>map={
@@ -159,66 +171,61 @@ void ConstellationMgr::reloadSkyCulture()
 
 void ConstellationMgr::updateSkyCulture(const QString& skyCultureDir)
 {
+	requestedSkyCulture = skyCultureDir;
+
+	// A bundle is already being loaded: the request is handled in update() when it is ready
+	if (!loadingSkyCulture.isEmpty())
+		return;
+
 	// Check if the sky culture changed since last load, if not don't load anything
 	if (lastLoadedSkyCulture == skyCultureDir)
 		return;
 
-	// Find constellation art.  If this doesn't exist, warn, but continue using ""
-	// the loadLinesAndArt function knows how to handle this (just loads lines).
-	QString conArtFile = StelFileMgr::findFile("skycultures/"+skyCultureDir+"/constellationsart.fab");
-	if (conArtFile.isEmpty())
+	const int boundariesIdx = StelApp::getInstance().getSkyCultureMgr().getCurrentSkyCultureBoundariesIdx();
+
+	// The first sky culture is loaded at once, so that the constellations are available after startup.
+	// Later switches are compiled or read from the cache in the background while the current sky culture is still drawn.
+	if (!flagAsyncLoading || constellations.empty())
 	{
-		qDebug() << "No constellationsart.fab file found for sky culture dir" << QDir::toNativeSeparators(skyCultureDir);
+		applySkyCultureBundle(SkyCultureBundle::load(skyCultureDir, boundariesIdx));
+		return;
 	}
 
+	loadingSkyCulture = skyCultureDir;
+	bundleLoader = QtConcurrent::run(&SkyCultureBundle::load, skyCultureDir, boundariesIdx, true);
+}
+
+void ConstellationMgr::applySkyCultureBundle(const SkyCultureBundle& bundle)
+{
 	// first of all, remove constellations from the list of selected objects in StelObjectMgr, since we are going to delete them
 	deselectConstellations();
 
-	QString fic = StelFileMgr::findFile("skycultures/"+skyCultureDir+"/constellationship.fab");
-	if (fic.isEmpty())
-		qWarning() << "ERROR loading constellation lines and art from file: " << fic;
-	else
-		loadLinesAndArt(fic, conArtFile, skyCultureDir);
-
-	// load constellation names
-	fic = StelFileMgr::findFile("skycultures/" + skyCultureDir + "/constellation_names.eng.fab");
-	if (fic.isEmpty())
-		qWarning() << "ERROR loading constellation names from file: " << fic;
-	else
-		loadNames(fic);
+	// The previous constellations fade out while the new ones fade in
+	for (auto* constellation : constellations)
+	{
+		constellation->setFlagArt(false);
+		constellation->setFlagLines(false);
+		constellation->setFlagLabels(false);
+		constellation->setFlagBoundaries(false);
+		fadingConstellations.push_back(constellation);
+	}
+	constellations.clear();
+	fadingBoundarySegments.insert(fadingBoundarySegments.end(), allBoundarySegments.begin(), allBoundarySegments.end());
+	allBoundarySegments.clear();
 
-	// load seasonal rules
-	loadSeasonalRules(StelFileMgr::findFile("skycultures/" + skyCultureDir + "/seasonal_rules.fab"));
+	loadLines(bundle);
+	loadArt(bundle);
+	loadNames(bundle);
+	loadSeasonalRules(bundle);
 
 	// Translate constellation names for the new sky culture
 	updateI18n();
 
 	// load constellation boundaries
-	StelApp *app = &StelApp::getInstance();
-	int idx = app->getSkyCultureMgr().getCurrentSkyCultureBoundariesIdx();
-	if (idx>=0)
-	{
-		// OK, the current sky culture has boundaries!
-		if (idx==1)
-		{
-			// boundaries = own
-			fic = StelFileMgr::findFile("skycultures/" + skyCultureDir + "/constellation_boundaries.dat");
-			if (fic.isEmpty()) // Check old file name (backward compatibility)
-				fic = StelFileMgr::findFile("skycultures/" + skyCultureDir + "/constellations_boundaries.dat");
-		}
-		else
-		{
-			// boundaries = generic
-			fic = StelFileMgr::findFile("data/constellation_boundaries.dat");
-		}
-
-		if (fic.isEmpty())
-			qWarning() << "ERROR loading constellation boundaries file: " << fic;
-		else
-			loadBoundaries(fic);
-	}
+	if (bundle.boundariesIdx>=0)
+		loadBoundaries(bundle);
 
-	lastLoadedSkyCulture = skyCultureDir;
+	lastLoadedSkyCulture = bundle.skyCultureDir;
 
 	if (getFlagCheckLoadingData())
 	{
@@ -229,6 +236,8 @@ void ConstellationMgr::updateSkyCulture(const QString& skyCultureDir)
 			i++;
 		}
 	}
+
+	emit skyCultureLoaded(lastLoadedSkyCulture);
 }
 
 void ConstellationMgr::selectedObjectChange(StelModule::StelModuleSelectAction action)
@@ -432,44 +441,12 @@ void ConstellationMgr::setConstellationBoundariesThickness(const int thickness)
 	}
 }
 
-void ConstellationMgr::loadLinesAndArt(const QString &fileName, const QString &artfileName, const QString& cultureName)
+void ConstellationMgr::loadLines(const SkyCultureBundle& bundle)
 {
-	QFile in(fileName);
-	if (!in.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qWarning() << "Can't open constellation data file" << QDir::toNativeSeparators(fileName)  << "for culture" << cultureName;
-		Q_ASSERT(0);
-	}
-
-	int totalRecords=0;
-	QString record;
-	QRegExp commentRx("^(\\s*#.*|\\s*)$");
-	while (!in.atEnd())
-	{
-		record = QString::fromUtf8(in.readLine());
-		if (!commentRx.exactMatch(record))
-			totalRecords++;
-	}
-	in.seek(0);
-
-	// delete existing data, if any
-	for (auto* constellation : constellations)
-		delete constellation;
-
-	constellations.clear();
-	Constellation *cons = Q_NULLPTR;
-
-	// read the file of line patterns, adding a record per non-comment line
-	int currentLineNumber = 0;	// line in file
 	int readOk = 0;			// count of records processed OK
-	while (!in.atEnd())
+	for (const auto& record : bundle.constellationLines)
 	{
-		record = QString::fromUtf8(in.readLine());
-		currentLineNumber++;
-		if (commentRx.exactMatch(record))
-			continue;
-
-		cons = new Constellation;
+		Constellation *cons = new Constellation;
 		if(cons->read(record, hipStarMgr))
 		{
 			cons->artOpacity = artIntensity;
@@ -483,149 +460,98 @@ void ConstellationMgr::loadLinesAndArt(const QString &fileName, const QString &a
 		}
 		else
 		{
-			qWarning() << "ERROR reading constellation lines record at line " << currentLineNumber << "for culture" << cultureName;
+			qWarning() << "ERROR reading constellation lines record" << record.abbreviation << "for culture" << bundle.skyCultureDir;
 			delete cons;
 		}
 	}
-	in.close();
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "constellation records successfully for culture" << cultureName;
+	qDebug() << "Loaded" << readOk << "/" << bundle.constellationLines.size() << "constellation records successfully for culture" << bundle.skyCultureDir;
 
 	// Set current states
 	setFlagArt(artDisplayed);
 	setFlagLines(linesDisplayed);
 	setFlagLabels(namesDisplayed);
 	setFlagBoundaries(boundariesDisplayed);
+}
 
-	// It's possible to have no art - just constellations
-	if (artfileName.isNull() || artfileName.isEmpty())
-		return;
-	QFile fic(artfileName);
-	if (!fic.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qWarning() << "Can't open constellation art file" << QDir::toNativeSeparators(fileName)  << "for culture" << cultureName;
-		return;
-	}
-
-	totalRecords=0;
-	while (!fic.atEnd())
-	{
-		record = QString::fromUtf8(fic.readLine());
-		if (!commentRx.exactMatch(record))
-			totalRecords++;
-	}
-	fic.seek(0);
-
-	// Read the constellation art file with the following format :
-	// ShortName texture_file x1 y1 hp1 x2 y2 hp2
-	// Where :
-	// shortname is the international short name (i.e "Lep" for Lepus)
-	// texture_file is the graphic file of the art texture
-	// x1 y1 are the x and y texture coordinates in pixels of the star of hipparcos number hp1
-	// x2 y2 are the x and y texture coordinates in pixels of the star of hipparcos number hp2
-	// The coordinate are taken with (0,0) at the top left corner of the image file
-	QString shortname;
-	QString texfile;
-	unsigned int x1, y1, x2, y2, x3, y3, hp1, hp2, hp3;
-
-	currentLineNumber = 0;	// line in file
-	readOk = 0;		// count of records processed OK
-
-	while (!fic.atEnd())
+void ConstellationMgr::loadArt(const SkyCultureBundle& bundle)
+{
+	int readOk = 0;		// count of records processed OK
+	StelCore* core = StelApp::getInstance().getCore();
+	for (const auto& art : bundle.constellationArt)
 	{
-		++currentLineNumber;
-		record = QString::fromUtf8(fic.readLine());
-		if (commentRx.exactMatch(record))
-			continue;
-
-		// prevent leaving zeros on numbers from being interpretted as octal numbers
-		record.replace(" 0", " ");
-		QTextStream rStr(&record);
-		rStr >> shortname >> texfile >> x1 >> y1 >> hp1 >> x2 >> y2 >> hp2 >> x3 >> y3 >> hp3;
-		if (rStr.status()!=QTextStream::Ok)
+		Constellation *cons = findFromAbbreviation(art.abbreviation);
+		if (!cons)
 		{
-			qWarning() << "ERROR parsing constellation art record at line" << currentLineNumber << "of art file for culture" << cultureName;
+			qWarning() << "ERROR in constellation art file for culture" << bundle.skyCultureDir
+				   << "constellation" << art.abbreviation << "unknown";
 			continue;
 		}
 
-		// Draw loading bar
-// 		lb.SetMessage(q_("Loading Constellation Art: %1/%2").arg(currentLineNumber).arg(totalRecords));
-// 		lb.Draw((float)(currentLineNumber)/totalRecords);
-
-		cons = Q_NULLPTR;
-		cons = findFromAbbreviation(shortname);
-		if (!cons)
+		StelObjectP star1 = hipStarMgr->searchHP(static_cast<int>(art.hp1));
+		StelObjectP star2 = hipStarMgr->searchHP(static_cast<int>(art.hp2));
+		StelObjectP star3 = hipStarMgr->searchHP(static_cast<int>(art.hp3));
+		if (!star1 || !star2 || !star3)
 		{
-			qWarning() << "ERROR in constellation art file at line" << currentLineNumber << "for culture" << cultureName
-					   << "constellation" << shortname << "unknown";
+			qWarning() << "ERROR in constellation art for culture" << bundle.skyCultureDir
+				   << "constellation" << art.abbreviation << ": can't find the reference stars";
+			continue;
 		}
-		else
+
+		// The texture is decoded in a loader thread, its size is already known from the bundle
+		if (!art.texturePath.isEmpty())
+			cons->artTexture = StelApp::getInstance().getTextureManager().createTextureThread(art.texturePath);
+
+		const int texSizeX = art.textureWidth, texSizeY = art.textureHeight;
+		Vec3d s1 = star1->getJ2000EquatorialPos(core);
+		Vec3d s2 = star2->getJ2000EquatorialPos(core);
+		Vec3d s3 = star3->getJ2000EquatorialPos(core);
+
+		// To transform from texture coordinate to 2d coordinate we need to find X with XA = B
+		// A formed of 4 points in texture coordinate, B formed with 4 points in 3d coordinate
+		// We need 3 stars and the 4th point is deduced from the other to get an normal base
+		// X = B inv(A)
+		Vec3d s4 = s1 + ((s2 - s1) ^ (s3 - s1));
+		Mat4d B(s1[0], s1[1], s1[2], 1, s2[0], s2[1], s2[2], 1, s3[0], s3[1], s3[2], 1, s4[0], s4[1], s4[2], 1);
+		Mat4d A(art.x1, texSizeY - static_cast<int>(art.y1), 0., 1., art.x2, texSizeY - static_cast<int>(art.y2), 0., 1., art.x3, texSizeY - static_cast<int>(art.y3), 0., 1., art.x1, texSizeY - static_cast<int>(art.y1), texSizeX, 1.);
+		Mat4d X = B * A.inverse();
+
+		// Tesselate on the plan assuming a tangential projection for the image
+		static const int nbPoints=5;
+		QVector<Vec2f> texCoords;
+		texCoords.reserve(nbPoints*nbPoints*6);
+		for (int j=0;j<nbPoints;++j)
 		{
-			QString texturePath = StelFileMgr::findFile("skycultures/"+cultureName+"/"+texfile);
-			if (texturePath.isEmpty())
+			for (int i=0;i<nbPoints;++i)
 			{
-				qWarning() << "ERROR: could not find texture, " << QDir::toNativeSeparators(texfile);
+				texCoords << Vec2f((static_cast<float>(i))/nbPoints, (static_cast<float>(j))/nbPoints);
+				texCoords << Vec2f((static_cast<float>(i)+1.f)/nbPoints, (static_cast<float>(j))/nbPoints);
+				texCoords << Vec2f((static_cast<float>(i))/nbPoints, (static_cast<float>(j)+1.f)/nbPoints);
+				texCoords << Vec2f((static_cast<float>(i)+1.f)/nbPoints, (static_cast<float>(j))/nbPoints);
+				texCoords << Vec2f((static_cast<float>(i)+1.f)/nbPoints, (static_cast<float>(j)+1.f)/nbPoints);
+				texCoords << Vec2f((static_cast<float>(i))/nbPoints, (static_cast<float>(j)+1.f)/nbPoints);
 			}
+		}
 
-			cons->artTexture = StelApp::getInstance().getTextureManager().createTextureThread(texturePath);
+		QVector<Vec3d> contour;
+		contour.reserve(texCoords.size());
+		for (const auto& v : texCoords)
+			contour << X * Vec3d(static_cast<double>(v[0]) * texSizeX, static_cast<double>(v[1]) * texSizeY, 0.);
 
-			int texSizeX = 0, texSizeY = 0;
-			if (cons->artTexture==Q_NULLPTR || !cons->artTexture->getDimensions(texSizeX, texSizeY))
-			{
-				qWarning() << "Texture dimension not available";
-			}
-
-			StelCore* core = StelApp::getInstance().getCore();
-			Vec3d s1 = hipStarMgr->searchHP(static_cast<int>(hp1))->getJ2000EquatorialPos(core);
-			Vec3d s2 = hipStarMgr->searchHP(static_cast<int>(hp2))->getJ2000EquatorialPos(core);
-			Vec3d s3 = hipStarMgr->searchHP(static_cast<int>(hp3))->getJ2000EquatorialPos(core);
-
-			// To transform from texture coordinate to 2d coordinate we need to find X with XA = B
-			// A formed of 4 points in texture coordinate, B formed with 4 points in 3d coordinate
-			// We need 3 stars and the 4th point is deduced from the other to get an normal base
-			// X = B inv(A)
-			Vec3d s4 = s1 + ((s2 - s1) ^ (s3 - s1));
-			Mat4d B(s1[0], s1[1], s1[2], 1, s2[0], s2[1], s2[2], 1, s3[0], s3[1], s3[2], 1, s4[0], s4[1], s4[2], 1);
-			Mat4d A(x1, texSizeY - static_cast<int>(y1), 0., 1., x2, texSizeY - static_cast<int>(y2), 0., 1., x3, texSizeY - static_cast<int>(y3), 0., 1., x1, texSizeY - static_cast<int>(y1), texSizeX, 1.);
-			Mat4d X = B * A.inverse();
-
-			// Tesselate on the plan assuming a tangential projection for the image
-			static const int nbPoints=5;
-			QVector<Vec2f> texCoords;
-			texCoords.reserve(nbPoints*nbPoints*6);
-			for (int j=0;j<nbPoints;++j)
-			{
-				for (int i=0;i<nbPoints;++i)
-				{
-					texCoords << Vec2f((static_cast<float>(i))/nbPoints, (static_cast<float>(j))/nbPoints);
-					texCoords << Vec2f((static_cast<float>(i)+1.f)/nbPoints, (static_cast<float>(j))/nbPoints);
-					texCoords << Vec2f((static_cast<float>(i))/nbPoints, (static_cast<float>(j)+1.f)/nbPoints);
-					texCoords << Vec2f((static_cast<float>(i)+1.f)/nbPoints, (static_cast<float>(j))/nbPoints);
-					texCoords << Vec2f((static_cast<float>(i)+1.f)/nbPoints, (static_cast<float>(j)+1.f)/nbPoints);
-					texCoords << Vec2f((static_cast<float>(i))/nbPoints, (static_cast<float>(j)+1.f)/nbPoints);
-				}
-			}
+		cons->artPolygon.vertex=contour;
+		cons->artPolygon.texCoords=texCoords;
+		cons->artPolygon.primitiveType=StelVertexArray::Triangles;
 
-			QVector<Vec3d> contour;
-			contour.reserve(texCoords.size());
-			for (const auto& v : texCoords)
-				contour << X * Vec3d(static_cast<double>(v[0]) * texSizeX, static_cast<double>(v[1]) * texSizeY, 0.);
-
-			cons->artPolygon.vertex=contour;
-			cons->artPolygon.texCoords=texCoords;
-			cons->artPolygon.primitiveType=StelVertexArray::Triangles;
-
-			Vec3d tmp(X * Vec3d(0.5*texSizeX, 0.5*texSizeY, 0.));
-			tmp.normalize();
-			Vec3d tmp2(X * Vec3d(0., 0., 0.));
-			tmp2.normalize();
-			cons->boundingCap.n=tmp;
-			cons->boundingCap.d=tmp*tmp2;
-			++readOk;
-		}
+		Vec3d tmp(X * Vec3d(0.5*texSizeX, 0.5*texSizeY, 0.));
+		tmp.normalize();
+		Vec3d tmp2(X * Vec3d(0., 0., 0.));
+		tmp2.normalize();
+		cons->boundingCap.n=tmp;
+		cons->boundingCap.d=tmp*tmp2;
+		++readOk;
 	}
 
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "constellation art records successfully for culture" << cultureName;
-	fic.close();
+	if (!bundle.constellationArt.isEmpty())
+		qDebug() << "Loaded" << readOk << "/" << bundle.constellationArt.size() << "constellation art records successfully for culture" << bundle.skyCultureDir;
 }
 
 void ConstellationMgr::draw(StelCore* core)
@@ -646,6 +572,10 @@ void ConstellationMgr::drawArt(StelPainter& sPainter) const
 	sPainter.setCullFace(true);
 
 	SphericalRegionP region = sPainter.getProjector()->getViewportConvexPolygon();
+	for (auto* constellation : fadingConstellations)
+	{
+		constellation->drawArtOptim(sPainter, *region);
+	}
 	for (auto* constellation : constellations)
 	{
 		constellation->drawArtOptim(sPainter, *region);
@@ -663,6 +593,10 @@ void ConstellationMgr::drawLines(StelPainter& sPainter, const StelCore* core) co
 	sPainter.setLineSmooth(true);
 
 	const SphericalCap& viewportHalfspace = sPainter.getProjector()->getBoundingCap();
+	for (auto* constellation : fadingConstellations)
+	{
+		constellation->drawOptim(sPainter, core, viewportHalfspace);
+	}
 	for (auto* constellation : constellations)
 	{
 		constellation->drawOptim(sPainter, core, viewportHalfspace);
@@ -676,6 +610,11 @@ void ConstellationMgr::drawLines(StelPainter& sPainter, const StelCore* core) co
 void ConstellationMgr::drawNames(StelPainter& sPainter) const
 {
 	sPainter.setBlending(true);
+	for (auto* constellation : fadingConstellations)
+	{
+		if (sPainter.getProjector()->projectCheck(constellation->XYZname, constellation->XYname))
+			constellation->drawName(sPainter, constellationDisplayStyle);
+	}
 	for (auto* constellation : constellations)
 	{
 		// Check if in the field of view
@@ -722,7 +661,7 @@ QList<StelObjectP> ConstellationMgr::searchAround(const Vec3d&, double, const St
 	return QList<StelObjectP>();
 }
 
-void ConstellationMgr::loadNames(const QString& namesFile)
+void ConstellationMgr::loadNames(const SkyCultureBundle& bundle)
 {
 	// Constellation not loaded yet
 	if (constellations.empty()) return;
@@ -732,84 +671,31 @@ void ConstellationMgr::loadNames(const QString& namesFile)
 	{
 		constellation->englishName.clear();
 	}
-
-	// Open file
-	QFile commonNameFile(namesFile);
-	if (!commonNameFile.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qDebug() << "Cannot open file" << QDir::toNativeSeparators(namesFile);
-		return;
-	}
-
 	constellationsEnglishNames.clear();
 
-	// Now parse the file
-	// lines to ignore which start with a # or are empty
-	QRegExp commentRx("^(\\s*#.*|\\s*)$");
-
-	// lines which look like records - we use the RE to extract the fields
-	// which will be available in recRx.capturedTexts()
-	// abbreviation is allowed to start with a dot to mark as "hidden".
-	QRegExp recRx("^\\s*(\\.?\\w+)\\s+\"(.*)\"\\s+_[(]\"(.*)\"[)]\\s*(\\w*)\\n");
-	QRegExp ctxRx("(.*)\",\\s*\"(.*)");
-
-	// Some more variables to use in the parsing
-	Constellation *aster;
-	QString record, shortName, ctxt;
-
-	// keep track of how many records we processed.
-	int totalRecords=0;
 	int readOk=0;
-	int lineNumber=0;
-	while (!commonNameFile.atEnd())
+	for (const auto& name : bundle.constellationNames)
 	{
-		record = QString::fromUtf8(commonNameFile.readLine());
-		lineNumber++;
-
-		// Skip comments
-		if (commentRx.exactMatch(record))
-			continue;
-
-		totalRecords++;
-
-		if (!recRx.exactMatch(record))
+		Constellation *aster = findFromAbbreviation(name.abbreviation);
+		// If the constellation exists, set the English name
+		if (aster != Q_NULLPTR)
 		{
-			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in constellation names file" << QDir::toNativeSeparators(namesFile) << ":" << record;
+			aster->nativeName = name.nativeName;
+			aster->englishName = name.englishName;
+			aster->context = name.context;
+			readOk++;
+			// Some skycultures already have empty nativeNames. Fill those.
+			if (aster->nativeName.isEmpty())
+				aster->nativeName=aster->englishName;
+
+			constellationsEnglishNames << aster->englishName;
 		}
 		else
 		{
-			shortName = recRx.capturedTexts().at(1);
-			aster = findFromAbbreviation(shortName);
-			// If the constellation exists, set the English name
-			if (aster != Q_NULLPTR)
-			{
-				aster->nativeName = recRx.capturedTexts().at(2);
-				ctxt = recRx.capturedTexts().at(3);
-				if (ctxRx.exactMatch(ctxt))
-				{
-					aster->englishName = ctxRx.capturedTexts().at(1);
-					aster->context = ctxRx.capturedTexts().at(2);
-				}
-				else
-				{
-					aster->englishName = ctxt;
-					aster->context = "";
-				}
-				readOk++;
-				// Some skycultures already have empty nativeNames. Fill those.
-				if (aster->nativeName.isEmpty())
-					aster->nativeName=aster->englishName;
-
-				constellationsEnglishNames << aster->englishName;
-			}
-			else
-			{
-				qWarning() << "WARNING - constellation abbreviation" << shortName << "not found when loading constellation names";
-			}
+			qWarning() << "WARNING - constellation abbreviation" << name.abbreviation << "not found when loading constellation names";
 		}
 	}
-	commonNameFile.close();
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "constellation names";
+	qDebug() << "Loaded" << readOk << "/" << bundle.constellationNames.size() << "constellation names";
 }
 
 QStringList ConstellationMgr::getConstellationsEnglishNames()
@@ -817,85 +703,39 @@ QStringList ConstellationMgr::getConstellationsEnglishNames()
 	return  constellationsEnglishNames;
 }
 
-void ConstellationMgr::loadSeasonalRules(const QString& rulesFile)
+void ConstellationMgr::loadSeasonalRules(const SkyCultureBundle& bundle)
 {
 	// Constellation not loaded yet
 	if (constellations.empty()) return;
 
-	bool flag = true;
-	if (rulesFile.isEmpty())
-		flag = false;
-
 	// clear previous rules
 	for (auto* constellation : constellations)
 	{
 		constellation->beginSeason = 1;
 		constellation->endSeason = 12;
-		constellation->seasonalRuleEnabled = flag;
+		constellation->seasonalRuleEnabled = bundle.hasSeasonalRules;
 	}
 
 	// Current starlore didn't support the seasonal rules
-	if (!flag)
-		return;
-
-	// Open file
-	QFile seasonalRulesFile(rulesFile);
-	if (!seasonalRulesFile.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qDebug() << "Cannot open file" << QDir::toNativeSeparators(rulesFile);
+	if (!bundle.hasSeasonalRules)
 		return;
-	}
 
-	// Now parse the file
-	// lines to ignore which start with a # or are empty
-	QRegExp commentRx("^(\\s*#.*|\\s*)$");
-
-	// lines which look like records - we use the RE to extract the fields
-	// which will be available in recRx.capturedTexts()
-	QRegExp recRx("^\\s*(\\w+)\\s+(\\w+)\\s+(\\w+)\\n");
-
-	// Some more variables to use in the parsing
-	Constellation *aster;
-	QString record, shortName;
-
-	// keep track of how many records we processed.
-	int totalRecords=0;
 	int readOk=0;
-	int lineNumber=0;
-	while (!seasonalRulesFile.atEnd())
+	for (const auto& rule : bundle.seasonalRules)
 	{
-		record = QString::fromUtf8(seasonalRulesFile.readLine());
-		lineNumber++;
-
-		// Skip comments
-		if (commentRx.exactMatch(record))
-			continue;
-
-		totalRecords++;
-
-		if (!recRx.exactMatch(record))
+		Constellation *aster = findFromAbbreviation(rule.abbreviation);
+		if (aster != Q_NULLPTR)
 		{
-			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in seasonal rules file" << QDir::toNativeSeparators(rulesFile);
+			aster->beginSeason = rule.beginSeason;
+			aster->endSeason = rule.endSeason;
+			readOk++;
 		}
 		else
 		{
-			shortName = recRx.capturedTexts().at(1);
-			aster = findFromAbbreviation(shortName);
-			// If the constellation exists, set the English name
-			if (aster != Q_NULLPTR)
-			{
-				aster->beginSeason = recRx.capturedTexts().at(2).toInt();
-				aster->endSeason = recRx.capturedTexts().at(3).toInt();
-				readOk++;
-			}
-			else
-			{
-				qWarning() << "WARNING - constellation abbreviation" << shortName << "not found when loading seasonal rules for constellations";
-			}
+			qWarning() << "WARNING - constellation abbreviation" << rule.abbreviation << "not found when loading seasonal rules for constellations";
 		}
 	}
-	seasonalRulesFile.close();
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "seasonal rules";
+	qDebug() << "Loaded" << readOk << "/" << bundle.seasonalRules.size() << "seasonal rules";
 }
 
 void ConstellationMgr::updateI18n()
@@ -919,6 +759,49 @@ void ConstellationMgr::update(double deltaTime)
 	{
 		constellation->update(delta);
 	}
+
+	// Delete the constellations of the previous sky culture once they are invisible
+	for (auto it = fadingConstellations.begin(); it != fadingConstellations.end();)
+	{
+		(*it)->update(delta);
+		if ((*it)->isFadedOut())
+		{
+			delete *it;
+			it = fadingConstellations.erase(it);
+		}
+		else
+			++it;
+	}
+	if (fadingConstellations.empty() && !fadingBoundarySegments.empty())
+	{
+		for (auto* segment : fadingBoundarySegments)
+			delete segment;
+		fadingBoundarySegments.clear();
+	}
+
+	// Switch to the sky culture loaded in the background
+	if (!loadingSkyCulture.isEmpty() && bundleLoader.isFinished())
+		switchToLoadedSkyCulture();
+}
+
+void ConstellationMgr::switchToLoadedSkyCulture()
+{
+	const QString loadedSkyCulture = loadingSkyCulture;
+	loadingSkyCulture.clear();
+	if (loadedSkyCulture == requestedSkyCulture)
+		applySkyCultureBundle(bundleLoader.result());
+	else
+		updateSkyCulture(requestedSkyCulture); // the sky culture changed again in the meantime
+}
+
+void ConstellationMgr::finishSkyCultureLoading()
+{
+	// A new background load may be started if the sky culture changed in the meantime
+	while (!loadingSkyCulture.isEmpty())
+	{
+		bundleLoader.waitForFinished();
+		switchToLoadedSkyCulture();
+	}
 }
 
 void ConstellationMgr::setArtIntensity(const float intensity)
@@ -1269,11 +1152,8 @@ void ConstellationMgr::unsetSelectedConst(Constellation * c)
 	}
 }
 
-bool ConstellationMgr::loadBoundaries(const QString& boundaryFile)
+void ConstellationMgr::loadBoundaries(const SkyCultureBundle& bundle)
 {
-	Constellation *cons = Q_NULLPTR;
-	unsigned int i, j;
-
 	// delete existing boundaries if any exist
 	for (auto* segment : allBoundarySegments)
 	{
@@ -1281,74 +1161,15 @@ bool ConstellationMgr::loadBoundaries(const QString& boundaryFile)
 	}
 	allBoundarySegments.clear();
 
-	qDebug() << "Loading constellation boundary data ... ";
-
-	// Modified boundary file by Torsten Bronger with permission
-	// http://pp3.sourceforge.net
-	QFile dataFile(boundaryFile);
-	if (!dataFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	for (const auto& boundary : bundle.boundaries)
 	{
-		qWarning() << "Boundary file " << QDir::toNativeSeparators(boundaryFile) << " not found";
-		return false;
-	}
-
-	double DE, RA;
-	Vec3d XYZ;
-	unsigned num, numc;
-	vector<Vec3d> *points = Q_NULLPTR;
-	QString consname, record, data = "";
-	i = 0;
-
-	// Added support of comments for constellation_boundaries.dat file
-	QRegExp commentRx("^(\\s*#.*|\\s*)$");
-	while (!dataFile.atEnd())
-	{
-		// Read the line
-		record = QString::fromUtf8(dataFile.readLine());
-
-		// Skip comments
-		if (commentRx.exactMatch(record))
-			continue;
-
-		// Append the data
-		data.append(record);
-	}
-
-	// Read and parse the data without comments
-	QTextStream istr(&data);
-	while (!istr.atEnd())
-	{
-		num = 0;
-		istr >> num;
-		if(num == 0)
-			continue; // empty line
-
-		points = new vector<Vec3d>;
-
-		for (j=0;j<num;j++)
-		{
-			istr >> RA >> DE;
-
-			RA*=M_PI/12.;     // Convert from hours to rad
-			DE*=M_PI/180.;    // Convert from deg to rad
-
-			// Calc the Cartesian coord with RA and DE
-			StelUtils::spheToRect(RA,DE,XYZ);
-			points->push_back(XYZ);
-		}
-
+		vector<Vec3d> *points = new vector<Vec3d>(boundary.points.begin(), boundary.points.end());
 		// this list is for the de-allocation
 		allBoundarySegments.push_back(points);
 
-		istr >> numc;
-		// there are 2 constellations per boundary
-
-		for (j=0;j<numc;j++)
+		Constellation *cons = Q_NULLPTR;
+		for (const auto& consname : boundary.constellations)
 		{
-			istr >> consname;
-			// not used?
-			if (consname == "SER1" || consname == "SER2") consname = "SER";
-
 			cons = findFromAbbreviation(consname);
 			if (!cons)
 				qWarning() << "ERROR while processing boundary file - cannot find constellation: " << consname;
@@ -1357,21 +1178,9 @@ bool ConstellationMgr::loadBoundaries(const QString& boundaryFile)
 		}
 
 		if (cons)
-		{
 			cons->sharedBoundarySegments.push_back(points);
-			points=Q_NULLPTR; // Avoid Coverity resource leak warning. (CID48925).
-		}
-		i++;
-	}
-	dataFile.close();
-	qDebug() << "Loaded" << i << "constellation boundary segments";
-	if (points)
-	{
-		delete points; // See if Coverity complains here? (CID48925).
-		points=Q_NULLPTR;
 	}
-
-	return true;
+	qDebug() << "Loaded" << bundle.boundaries.size() << "constellation boundary segments";
 }
 
 void ConstellationMgr::drawBoundaries(StelPainter& sPainter) const
@@ -1380,6 +1189,10 @@ void ConstellationMgr::drawBoundaries(StelPainter& sPainter) const
 	if (constellationBoundariesThickness>1)
 		sPainter.setLineWidth(constellationBoundariesThickness); // set line thickness
 	sPainter.setLineSmooth(true);
+	for (auto* constellation : fadingConstellations)
+	{
+		constellation->drawBoundaryOptim(sPainter);
+	}
 	for (auto* constellation : constellations)
 	{
 		constellation->drawBoundaryOptim(sPainter);
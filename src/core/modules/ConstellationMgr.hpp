@@ -24,11 +24,13 @@
 #include "StelObjectType.hpp"
 #include "StelObjectModule.hpp"
 #include "StelProjectorType.hpp"
+#include "SkyCultureBundle.hpp"
 
 #include <vector>
 #include <QString>
 #include <QStringList>
 #include <QFont>
+#include <QFuture>
 
 class StelToneReproducer;
 class StarMgr;
@@ -120,6 +122,10 @@ public:
 	//! Updates time-varying state for each Constellation.
 	virtual void update(double deltaTime);
 
+	//! Wait for the sky culture being loaded in the background, if any, and install its constellations at once.
+	//! Used where the constellations of a new sky culture are needed right after the change, e.g. by scripts.
+	void finishSkyCultureLoading();
+
 	//! Return the value defining the order of call for the given action
 	//! @param actionName the name of the action for which we want the call order
 	//! @return the value defining the order. The closer to 0 the earlier the module's action will be called
@@ -302,6 +308,9 @@ signals:
 	void constellationsDisplayStyleChanged(const ConstellationMgr::ConstellationDisplayStyle style) const;
 	void constellationLineThicknessChanged(int thickness) const;
 	void constellationBoundariesThicknessChanged(int thickness) const;
+	//! Emitted once the constellations of a new sky culture are installed, which may happen some frames
+	//! after the sky culture change when the sky culture is loaded in the background.
+	void skyCultureLoaded(const QString& skyCultureDir) const;
 
 private slots:
 	//! Limit the number of constellations to draw based on selected stars.
@@ -326,37 +335,31 @@ private slots:
 	bool getFlagCheckLoadingData(void) const { return checkLoadingData; }
 
 private:
-	//! Read constellation names from the given file.
-	//! @param namesFile Name of the file containing the constellation names
-	//!        in a format consisting of abbreviation, native name and translatable english name.
-	//! @note The abbreviation must occur in the lines file loaded first in @name loadLinesAndArt()!
-	void loadNames(const QString& namesFile);
-
-	//! Load constellation line shapes, art textures and boundaries shapes from data files.
-	//! @param fileName The name of the constellation data file
-	//! @param artFileName The name of the constellation art data file
-	//! @param cultureName A string ID of the current skyculture
-	//! @note The abbreviation used in @param filename is required for cross-identifying translatable names in @name loadNames():
-	void loadLinesAndArt(const QString& fileName, const QString& artfileName, const QString& cultureName);
-
-	//! Load the constellation boundary file.
-	//! This function deletes any currently loaded constellation boundaries
-	//! and loads a new set from the file passed as the parameter.  The boundary
-	//! data file consists of whitespace separated values (space, tab or newline).
-	//! Each boundary may span multiple lines, and consists of the following ordered
-	//! data items:
-	//!  - The number of vertices which make up in the boundary (integer).
-	//!  - For each vertex, two floating point numbers describing the ra and dec
-	//!    of the vertex.
-	//!  - The number of constellations which this boundary separates (always 2).
-	//!  - Two constellation abbreviations representing the constellations which
-	//!    the boundary separates.
-	//! @param conCatFile the path to the file which contains the constellation boundary data.
-	bool loadBoundaries(const QString& conCatFile);
-
-	//! Read seasonal rules for displaying constellations from the given file.
-	//! @param rulesFile Name of the file containing the seasonal rules
-	void loadSeasonalRules(const QString& rulesFile);
+	//! Replace the loaded constellations by the ones of a compiled sky culture bundle.
+	//! The previous constellations are kept until they have faded out.
+	void applySkyCultureBundle(const SkyCultureBundle& bundle);
+
+	//! Install the bundle loaded in the background, or load the requested sky culture again
+	//! if it changed while the bundle was being loaded.
+	void switchToLoadedSkyCulture();
+
+	//! Create the constellations from the lines of the bundle.
+	void loadLines(const SkyCultureBundle& bundle);
+
+	//! Set up the constellation art textures and their projection on the sky.
+	//! The textures are loaded in the background, their sizes come from the bundle.
+	void loadArt(const SkyCultureBundle& bundle);
+
+	//! Set the constellation names.
+	//! @note The abbreviation must occur in the lines loaded first in @name loadLines()!
+	void loadNames(const SkyCultureBundle& bundle);
+
+	//! Attach the constellation boundary segments to the constellations.
+	//! This function deletes any currently loaded constellation boundaries.
+	void loadBoundaries(const SkyCultureBundle& bundle);
+
+	//! Set the seasonal rules for displaying constellations.
+	void loadSeasonalRules(const SkyCultureBundle& bundle);
 
 	//! Draw the constellation lines at the epoch given by the StelCore.
 	void drawLines(StelPainter& sPainter, const StelCore* core) const;
@@ -397,6 +400,13 @@ private:
 	std::vector<std::vector<Vec3d> *> allBoundarySegments;
 
 	QString lastLoadedSkyCulture;	// Store the last loaded sky culture directory name
+	QString loadingSkyCulture;	// Sky culture directory name of the bundle being loaded in the background, if any
+	QString requestedSkyCulture;	// Last sky culture directory name requested by the sky culture manager
+	QFuture<SkyCultureBundle> bundleLoader;
+	bool flagAsyncLoading;
+	// Constellations of the previous sky culture, and their boundaries, deleted once faded out
+	std::vector<Constellation*> fadingConstellations;
+	std::vector<std::vector<Vec3d> *> fadingBoundarySegments;
 
 	QStringList constellationsEnglishNames;
 
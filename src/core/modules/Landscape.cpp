@@ -29,6 +29,7 @@
 #include "StelCore.hpp"
 #include "StelPainter.hpp"
 #include "StelLocaleMgr.hpp"
+#include "StelHips.hpp"
 
 #include <QDebug>
 #include <QSettings>
@@ -56,6 +57,8 @@ Landscape::Landscape(float _radius)
 	, defaultPressure(-2.)
 	, horizonPolygon(Q_NULLPTR)
 	, fontSize(18)
+	, labelColor(0.2f, 0.8f, 0.2f)
+	, texMemorySize(0)
 {
 }
 
@@ -146,10 +149,8 @@ void Landscape::loadCommon(const QSettings& landscapeIni, const QString& landsca
 		// This line can then be drawn in all classes with the color specified here. If not specified, don't draw it! (flagged by negative red)
 		horizonPolygonLineColor=StelUtils::strToVec3f(landscapeIni.value("landscape/horizon_line_color", "-1,0,0" ).toString());
 	}
-	// we must get label color, this is global. (No sense to make that per-landscape!)
-	QSettings *config = StelApp::getInstance().getSettings();
-	labelColor=StelUtils::strToVec3f(config->value("landscape/label_color", "0.2,0.8,0.2").toString());
-	fontSize=config->value("landscape/label_font_size", 18).toInt();
+	// Label color and font size are global (no sense to make them per-landscape!), they are set by LandscapeMgr.
+	// The application settings must not be read here, as landscapes may be loaded in a worker thread.
 	loadLabels(landscapeId);
 }
 
@@ -251,6 +252,37 @@ void Landscape::createPolygonalHorizon(const QString& lineFileName, const float
 	}
 }
 
+StelTextureSP Landscape::loadTexture(const QString& path, const StelTexture::StelTextureParams& params)
+{
+	// Decoding starts immediately in the texture loader threads, the GL upload is done later in finishLoading().
+	StelTextureSP tex = StelApp::getInstance().getTextureManager().createTextureThread(path, params, false);
+	if (tex)
+		pendingTextures.append(tex);
+	return tex;
+}
+
+bool Landscape::finishLoading(const bool wait)
+{
+	QMutableListIterator<StelTextureSP> it(pendingTextures);
+	while (it.hasNext())
+	{
+		StelTextureSP tex = it.next();
+		if (wait && !tex->canBind())
+		{
+			tex->bind(); // make sure the loader has been started
+			tex->waitForLoaded();
+		}
+		if (tex->bind() || tex->hasError())
+		{
+			if (tex->hasError())
+				qWarning() << "Landscape" << id << "failed to load texture:" << tex->getErrorMessage();
+			texMemorySize+=tex->getGlSize();
+			it.remove();
+		}
+	}
+	return pendingTextures.isEmpty();
+}
+
 #include <iostream>
 const QString Landscape::getTexturePath(const QString& basename, const QString& landscapeId)
 {
@@ -432,7 +464,7 @@ void LandscapeOldStyle::load(const QSettings& landscapeIni, const QString& lands
 		QString textureKey = QString("landscape/tex%1").arg(i);
 		QString textureName = landscapeIni.value(textureKey).toString();
 		const QString texturePath = getTexturePath(textureName, landscapeId);
-		sideTexs[i] = StelApp::getInstance().getTextureManager().createTexture(texturePath);
+		sideTexs[i] = loadTexture(texturePath);
 		// GZ: To query the textures, also keep an array of QImage*, but only
 		// if that query is not going to be prevented by the polygon that already has been loaded at that point...
 		if ( (!horizonPolygon) && calibrated ) { // for uncalibrated landscapes the texture is currently never queried, so no need to store.
@@ -450,9 +482,7 @@ void LandscapeOldStyle::load(const QSettings& landscapeIni, const QString& lands
 		if (textureName.length())
 		{
 			const QString lightTexturePath = getTexturePath(textureName, landscapeId);
-			sideTexs[nbSideTexs+i] = StelApp::getInstance().getTextureManager().createTexture(lightTexturePath);
-			if(sideTexs[nbSideTexs+i])
-				memorySize+=sideTexs[nbSideTexs+i]->getGlSize();
+			sideTexs[nbSideTexs+i] = loadTexture(lightTexturePath);
 		}
 		else
 			sideTexs[nbSideTexs+i].clear();
@@ -493,15 +523,11 @@ void LandscapeOldStyle::load(const QSettings& landscapeIni, const QString& lands
 	}
 	const QString groundTexName = landscapeIni.value("landscape/groundtex").toString();
 	const QString groundTexPath = getTexturePath(groundTexName, landscapeId);
-	groundTex = StelApp::getInstance().getTextureManager().createTexture(groundTexPath, StelTexture::StelTextureParams(true));
-	if (groundTex)
-		memorySize+=groundTex->getGlSize();
+	groundTex = loadTexture(groundTexPath, StelTexture::StelTextureParams(true));
 
 	const QString fogTexName = landscapeIni.value("landscape/fogtex").toString();
 	const QString fogTexPath = getTexturePath(fogTexName, landscapeId);
-	fogTex = StelApp::getInstance().getTextureManager().createTexture(fogTexPath, StelTexture::StelTextureParams(true, GL_LINEAR, GL_REPEAT));
-	if (fogTex)
-		memorySize+=fogTex->getGlSize();
+	fogTex = loadTexture(fogTexPath, StelTexture::StelTextureParams(true, GL_LINEAR, GL_REPEAT));
 
 	// Precompute the vertex arrays for ground display
 	// Make slices_per_side=(3<<K) so that the innermost polygon of the fandisk becomes a triangle:
@@ -961,21 +987,12 @@ void LandscapeFisheye::create(const QString _name, float _texturefov, const QStr
 		memorySize+=static_cast<uint>(mapImage->byteCount());
 #endif
 	}
-	mapTex = StelApp::getInstance().getTextureManager().createTexture(_maptex, StelTexture::StelTextureParams(true));
-	memorySize+=mapTex->getGlSize();
+	mapTex = loadTexture(_maptex, StelTexture::StelTextureParams(true));
 
 	if (_maptexIllum.length() && (!_maptexIllum.endsWith("/")))
-	{
-		mapTexIllum = StelApp::getInstance().getTextureManager().createTexture(_maptexIllum, StelTexture::StelTextureParams(true));
-		if (mapTexIllum)
-			memorySize+=mapTexIllum->getGlSize();
-	}
+		mapTexIllum = loadTexture(_maptexIllum, StelTexture::StelTextureParams(true));
 	if (_maptexFog.length() && (!_maptexFog.endsWith("/")))
-	{
-		mapTexFog = StelApp::getInstance().getTextureManager().createTexture(_maptexFog, StelTexture::StelTextureParams(true));
-		if (mapTexFog)
-			memorySize+=mapTexFog->getGlSize();
-	}
+		mapTexFog = loadTexture(_maptexFog, StelTexture::StelTextureParams(true));
 }
 
 
@@ -1146,21 +1163,12 @@ void LandscapeSpherical::create(const QString _name, const QString& _maptex, con
 		memorySize+=static_cast<uint>(mapImage->byteCount());
 #endif
 	}
-	mapTex = StelApp::getInstance().getTextureManager().createTexture(_maptex, StelTexture::StelTextureParams(true));
-	memorySize+=mapTex->getGlSize();
+	mapTex = loadTexture(_maptex, StelTexture::StelTextureParams(true));
 
 	if (_maptexIllum.length() && (!_maptexIllum.endsWith("/")))
-	{
-		mapTexIllum = StelApp::getInstance().getTextureManager().createTexture(_maptexIllum, StelTexture::StelTextureParams(true));
-		if (mapTexIllum)
-			memorySize+=mapTexIllum->getGlSize();
-	}
+		mapTexIllum = loadTexture(_maptexIllum, StelTexture::StelTextureParams(true));
 	if (_maptexFog.length() && (!_maptexFog.endsWith("/")))
-	{
-		mapTexFog = StelApp::getInstance().getTextureManager().createTexture(_maptexFog, StelTexture::StelTextureParams(true));
-		if (mapTexFog)
-			memorySize+=mapTexFog->getGlSize();
-	}	
+		mapTexFog = loadTexture(_maptexFog, StelTexture::StelTextureParams(true));	
 
 	// Add a bottom cap in case of maptex_bottom.
 	if ((mapTexBottom>-90.f*M_PI_180f) && (_bottomCapColor != Vec3f(-1.0f, 0.0f, 0.0f)))
@@ -1291,3 +1299,151 @@ float LandscapeSpherical::getOpacity(Vec3d azalt) const
 */
 	return qAlpha(pixVal)/255.0f;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////
+// LandscapeTiled
+//
+
+LandscapeTiled::LandscapeTiled(float _radius)
+	: Landscape(_radius)
+	, memorySize(sizeof(LandscapeTiled))
+{}
+
+LandscapeTiled::~LandscapeTiled()
+{
+	landscapeLabels.clear();
+}
+
+void LandscapeTiled::load(const QSettings& landscapeIni, const QString& landscapeId)
+{
+	loadCommon(landscapeIni, landscapeId);
+
+	const QString type = landscapeIni.value("landscape/type").toString();
+	if (type != "tiled")
+	{
+		qWarning() << "Landscape type mismatch for landscape "<< landscapeId << ", expected tiled, found " << type << ".  No landscape in use.\n";
+		validLandscape = false;
+		return;
+	}
+	angleRotateZ = landscapeIni.value("landscape/angle_rotatez", 0.f).toFloat()*M_PI_180f;
+
+	const QString tilesDir = StelFileMgr::findFile("landscapes/" + landscapeId + "/" + landscapeIni.value("landscape/tiles", "tiles").toString(), StelFileMgr::Directory);
+	if (tilesDir.isEmpty() || !QFileInfo(tilesDir + "/properties").exists())
+	{
+		qWarning() << "Landscape " << landscapeId << " does not contain a valid tile pyramid.  No landscape in use.\n";
+		validLandscape = false;
+		return;
+	}
+	tilesUrl = QUrl::fromLocalFile(tilesDir).toString();
+
+	if (landscapeIni.contains("landscape/tiles_illum"))
+	{
+		const QString illumDir = StelFileMgr::findFile("landscapes/" + landscapeId + "/" + landscapeIni.value("landscape/tiles_illum").toString(), StelFileMgr::Directory);
+		if (!illumDir.isEmpty())
+			tilesIllumUrl = QUrl::fromLocalFile(illumDir).toString();
+	}
+
+	// The opacity map is not needed if a horizon polygon has been given.
+	if (!horizonPolygon)
+	{
+		const QString opacityPath = getTexturePath(landscapeIni.value("landscape/opacity_map", "opacity.png").toString(), landscapeId);
+		opacityImage = QImage(opacityPath);
+		if (opacityImage.isNull())
+			qWarning() << "Landscape " << landscapeId << ": cannot read opacity map. The landscape will be assumed opaque below the mathematical horizon.";
+		else
+		{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 5, 0))
+			opacityImage = opacityImage.convertToFormat(QImage::Format_Grayscale8);
+#endif
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+			memorySize+=static_cast<uint>(opacityImage.sizeInBytes());
+#else
+			memorySize+=static_cast<uint>(opacityImage.byteCount());
+#endif
+		}
+	}
+	validLandscape = true;
+}
+
+void LandscapeTiled::draw(StelCore* core)
+{
+	if(!validLandscape) return;
+	if(landFader.getInterstate()==0.f) return;
+
+	// HipsSurvey uses the network manager of the main thread, so we create it only here.
+	if (!survey)
+	{
+		survey = HipsSurveyP(new HipsSurvey(tilesUrl));
+		survey->setVisible(true);
+		if (!tilesIllumUrl.isEmpty())
+		{
+			surveyIllum = HipsSurveyP(new HipsSurvey(tilesIllumUrl));
+			surveyIllum->setVisible(true);
+		}
+	}
+
+	StelProjector::ModelViewTranformP transfo = core->getAltAzModelViewTransform(StelCore::RefractionOff);
+	transfo->combine(Mat4d::zrotation(-static_cast<double>(angleRotateZ+angleRotateZOffset)));
+	const StelProjectorP prj = core->getProjection(transfo);
+	StelPainter sPainter(prj);
+
+	// The survey binds the tile texture (or its lower resolution parent) before calling us.
+	const float alpha = landFader.getInterstate();
+	survey->draw(&sPainter, 2.0*M_PI, [&](const QVector<Vec3d>& verts, const QVector<Vec2f>& tex, const QVector<uint16_t>& indices) {
+		sPainter.setBlending(true);
+		sPainter.setColor(landscapeBrightness, landscapeBrightness, landscapeBrightness, alpha*survey->getInterstate());
+		sPainter.setArrays(verts.constData(), tex.constData());
+		sPainter.drawFromArray(StelPainter::Triangles, indices.size(), 0, true, indices.constData());
+	});
+
+	// Self-luminous layer (Light pollution etc)
+	if (surveyIllum && (lightScapeBrightness>0.0f) && (illumFader.getInterstate()>0.0f))
+	{
+		const float illum = lightScapeBrightness*illumFader.getInterstate();
+		surveyIllum->draw(&sPainter, 2.0*M_PI, [&](const QVector<Vec3d>& verts, const QVector<Vec2f>& tex, const QVector<uint16_t>& indices) {
+			sPainter.setBlending(true, GL_SRC_ALPHA, GL_ONE);
+			sPainter.setColor(illum, illum, illum, alpha*surveyIllum->getInterstate());
+			sPainter.setArrays(verts.constData(), tex.constData());
+			sPainter.drawFromArray(StelPainter::Triangles, indices.size(), 0, true, indices.constData());
+		});
+	}
+
+	// If a horizon line also has been defined, draw it.
+	if (horizonPolygon && (horizonPolygonLineColor[0] >= 0))
+	{
+		transfo = core->getAltAzModelViewTransform(StelCore::RefractionOff);
+		transfo->combine(Mat4d::zrotation(-static_cast<double>(angleRotateZOffset)));
+		sPainter.setProjector(core->getProjection(transfo));
+		sPainter.setBlending(true);
+		sPainter.setColor(horizonPolygonLineColor[0], horizonPolygonLineColor[1], horizonPolygonLineColor[2], landFader.getInterstate());
+		sPainter.drawSphericalRegion(horizonPolygon.data(), StelPainter::SphericalPolygonDrawModeBoundary);
+	}
+	sPainter.setCullFace(false);
+	drawLabels(core, &sPainter);
+}
+
+float LandscapeTiled::getOpacity(Vec3d azalt) const
+{
+	if(!validLandscape) return (azalt[2]>0.0 ? 0.0f : 1.0f);
+
+	if (angleRotateZOffset!=0.0f)
+		azalt.transfo4d(Mat4d::zrotation(static_cast<double>(angleRotateZOffset)));
+
+	// in case we also have a horizon polygon defined, this is trivial and fast.
+	if (horizonPolygon)
+	{
+		if (horizonPolygon->contains(azalt)) return 1.0f; else return 0.0f;
+	}
+	if (opacityImage.isNull())
+		return (azalt[2]>0.0 ? 0.0f : 1.0f);
+
+	float az, alt_rad;
+	StelUtils::rectToSphe(&az, &alt_rad, azalt);
+	// The opacity map is equirectangular, North on the left edge, zenith on top.
+	az = (M_PIf-az) - angleRotateZ; // real azimuth. NESW
+	az = fmodf(az, 2.0f*M_PIf);
+	if (az<0) az+=2.0f*M_PIf;
+	const int x=qBound(0, static_cast<int>(az/(2.0f*M_PIf)*opacityImage.width()), opacityImage.width()-1);
+	const int y=qBound(0, static_cast<int>((M_PI_2f-alt_rad)/M_PIf*opacityImage.height()), opacityImage.height()-1);
+	return qGray(opacityImage.pixel(x, y))/255.0f;
+}
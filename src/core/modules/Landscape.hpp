@@ -27,6 +27,7 @@
 #include "StelFader.hpp"
 #include "StelUtils.hpp"
 #include "StelTextureTypes.hpp"
+#include "StelTexture.hpp"
 #include "StelLocation.hpp"
 #include "StelSphereGeometry.hpp"
 
@@ -39,6 +40,7 @@ class QSettings;
 class StelLocation;
 class StelCore;
 class StelPainter;
+class HipsSurvey;
 
 //! @class Landscape
 //! Store and manages the displaying of the Landscape.
@@ -73,10 +75,20 @@ public:
 	Landscape(float _radius = 2.f);
 	virtual ~Landscape();
 	//! Load landscape.
+	//! This does not require an OpenGL context and may be called from a worker thread (see LandscapeMgr).
+	//! Textures are only decoded in the background, call finishLoading() from the main thread before drawing.
 	//! @param landscapeIni A reference to an existing QSettings object which describes the landscape
 	//! @param landscapeId The name of the directory for the landscape files (e.g. "ocean")
 	virtual void load(const QSettings& landscapeIni, const QString& landscapeId) = 0;
 
+	//! Upload the textures which have been decoded in the background to OpenGL.
+	//! Must be called from the main thread. Until this returns true, the landscape should not be drawn.
+	//! @param wait true to block until all textures are available (used e.g. for the very first landscape).
+	//! @return true when all textures are ready (or have failed to load).
+	bool finishLoading(const bool wait=false);
+	//! Return true if some textures of this landscape are still being loaded.
+	bool isLoading() const {return !pendingTextures.isEmpty();}
+
 	//! Return approximate memory footprint in bytes (required for cache cost estimate in LandscapeMgr)
 	//! The returned value is only approximate, content of QStrings and other small containers like the horizon polygon are not put in in detail.
 	//! However, texture image sizes must be computed in subclasses.
@@ -125,6 +137,8 @@ public:
 	bool getFlagShowLabels() const {return static_cast<bool>(labelFader);}
 	//! change font and fontsize for landscape labels
 	void setLabelFontSize(const int size){fontSize=size;}
+	//! change color for landscape labels
+	void setLabelColor(const Vec3f& color){labelColor=color;}
 
 	//! Get landscape name
 	QString getName() const {return name;}
@@ -208,6 +222,13 @@ protected:
 	//! @param landscapeId The landscape ID (directory name) to which the texture belongs
 	//! @exception misc possibility of throwing "file not found" exceptions
 	static const QString getTexturePath(const QString& basename, const QString& landscapeId);
+
+	//! Start loading a texture in the texture loader threads. The texture is tracked until finishLoading() has uploaded it,
+	//! and its size is then added to texMemorySize. This method is safe to be called from a worker thread.
+	//! @param path full path of the image file
+	//! @param params the texture creation parameters
+	StelTextureSP loadTexture(const QString& path, const StelTexture::StelTextureParams& params=StelTexture::StelTextureParams());
+
 	double radius;
 	QString name;          //! Read from landscape.ini:[landscape]name
 	QString author;        //! Read from landscape.ini:[landscape]author
@@ -247,6 +268,9 @@ protected:
 	QList<LandscapeLabel> landscapeLabels;
 	int fontSize;     //! Used for landscape labels (optionally indicating landscape features)
 	Vec3f labelColor; //! Color for the landscape labels.
+
+	unsigned int texMemorySize;          //! Sum of GL texture sizes, known only after finishLoading() has uploaded them.
+	QList<StelTextureSP> pendingTextures; //! Textures requested by loadTexture() which are not yet uploaded to OpenGL.
 };
 
 //! @class LandscapeOldStyle
@@ -270,7 +294,7 @@ public:
 	LandscapeOldStyle(float radius = 2.0f);
 	virtual ~LandscapeOldStyle();
 	virtual void load(const QSettings& landscapeIni, const QString& landscapeId);
-	virtual unsigned int getMemorySize() const {return memorySize;}
+	virtual unsigned int getMemorySize() const {return memorySize+texMemorySize;}
 	virtual void draw(StelCore* core);
 	//void create(bool _fullpath, QMap<QString, QString> param); // still not implemented
 	virtual float getOpacity(Vec3d azalt) const;
@@ -352,7 +376,7 @@ public:
 	LandscapeFisheye(float radius = 1.f);
 	virtual ~LandscapeFisheye();
 	virtual void load(const QSettings& landscapeIni, const QString& landscapeId);
-	virtual unsigned int getMemorySize() const {return memorySize;}
+	virtual unsigned int getMemorySize() const {return memorySize+texMemorySize;}
 	virtual void draw(StelCore* core);
 	//! Sample landscape texture for transparency/opacity. May be used for visibility, sunrise etc.
 	//! @param azalt normalized direction in alt-az frame
@@ -394,7 +418,7 @@ public:
 	LandscapeSpherical(float radius = 1.f);
 	virtual ~LandscapeSpherical();
 	virtual void load(const QSettings& landscapeIni, const QString& landscapeId);
-	virtual unsigned int getMemorySize() const {return memorySize;}
+	virtual unsigned int getMemorySize() const {return memorySize+texMemorySize;}
 	virtual void draw(StelCore* core);
 	//! Sample landscape texture for transparency/opacity. May be used for visibility, sunrise etc.
 	//! @param azalt normalized direction in alt-az frame
@@ -437,4 +461,38 @@ private:
 	unsigned int memorySize;   //!< holds an approximate value of memory consumption (for cache cost estimate)
 };
 
+//////////////////////////////////////////////////////////////////////////
+//! @class LandscapeTiled
+//! This uses a tiled, multi-resolution panorama pyramid in HiPS layout (HEALPix tiles in alt-azimuthal coordinates).
+//! Only the tiles needed for the current view and field of view are loaded, so that there is no limit by
+//! texture size or memory, and even gigapixel survey panoramas can be used.
+//! The pyramid is created from the images of spherical or fisheye landscapes with the landscapeTiler tool (see util/landscapeTiler).
+//! Define it with the following names in landscape.ini:
+//! @param landscape/tiles directory (relative to the landscape directory) containing the HiPS properties file and the NorderN directories. Default: tiles
+//! @param landscape/tiles_illum optional directory for the self-luminous (light pollution) layer in the same layout.
+//! @param landscape/opacity_map small equirectangular alpha image used for getOpacity(). Left edge is North, top edge the zenith. Default: opacity.png
+//! @param landscape/angle_rotatez azimuth rotation angle, degrees. The tiler already bakes the rotation of the source landscape into the tiles.
+class LandscapeTiled : public Landscape
+{
+public:
+	LandscapeTiled(float radius = 1.f);
+	virtual ~LandscapeTiled();
+	virtual void load(const QSettings& landscapeIni, const QString& landscapeId);
+	virtual unsigned int getMemorySize() const {return memorySize+texMemorySize;}
+	virtual void draw(StelCore* core);
+	//! Sample the low-resolution opacity map. May be used for visibility, sunrise etc.
+	//! @param azalt normalized direction in alt-az frame
+	//! @retval alpha (0=fully transparent, 1=fully opaque)
+	virtual float getOpacity(Vec3d azalt) const;
+
+private:
+	QString tilesUrl;          //!< URL (file://) of the pyramid of the landscape
+	QString tilesIllumUrl;     //!< URL (file://) of the pyramid of the optional self-luminous layer
+	//! The surveys are created on first draw, because they must live in the main thread.
+	QSharedPointer<HipsSurvey> survey;
+	QSharedPointer<HipsSurvey> surveyIllum;
+	QImage opacityImage;       //!< Low resolution alpha channel (8 bit) for opacity sampling.
+	unsigned int memorySize;
+};
+
 #endif // LANDSCAPE_HPP
@@ -46,6 +46,7 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QOpenGLPaintDevice>
+#include <QtConcurrent>
 
 #include <stdexcept>
 
@@ -201,6 +202,8 @@ LandscapeMgr::LandscapeMgr()
 	, defaultMinimalBrightness(0.01)
 	, flagLandscapeSetsMinimalBrightness(false)
 	, flagEnvironmentAutoEnabling(false)
+	, flagLandscapeAsyncLoading(true)
+	, requestedChangeLocationDuration(1.0)
 {
 	setObjectName("LandscapeMgr"); // should be done by StelModule's constructor.
 
@@ -218,6 +221,17 @@ LandscapeMgr::LandscapeMgr()
 
 LandscapeMgr::~LandscapeMgr()
 {
+	// Landscapes still being constructed in the background must be waited for.
+	for (auto* loader : landscapeLoaders)
+	{
+		loader->waitForFinished();
+		delete loader->result();
+		delete loader;
+	}
+	landscapeLoaders.clear();
+	qDeleteAll(finishingLandscapes);
+	finishingLandscapes.clear();
+
 	delete atmosphere;
 	delete cardinalsPoints;
 	if (oldLandscape)
@@ -250,6 +264,9 @@ void LandscapeMgr::update(double deltaTime)
 {
 	atmosphere->update(deltaTime);
 
+	if (!landscapeLoaders.isEmpty() || !finishingLandscapes.isEmpty())
+		processLoadedLandscapes();
+
 	if (oldLandscape)
 	{
 		// This is only when transitioning to newly loaded landscape. We must draw the old one until the new one is faded in completely.
@@ -440,6 +457,7 @@ void LandscapeMgr::init()
 
 	landscapeCache.setMaxCost(conf->value("landscape/cache_size_mb", 100).toInt());
 	qDebug() << "LandscapeMgr: initialized Cache for" << landscapeCache.maxCost() << "MB.";
+	setFlagLandscapeAsyncLoading(conf->value("landscape/flag_async_loading", true).toBool());
 
 	atmosphere = new Atmosphere();
 	defaultLandscapeID = conf->value("init_location/landscape_name").toString();
@@ -497,7 +515,11 @@ bool LandscapeMgr::setCurrentLandscapeID(const QString& id, const double changeL
 
 	//prevent unnecessary changes/file access
 	if(id==currentLandscapeID)
+	{
+		// A pending switch to another landscape which is still loading is no longer wanted.
+		requestedLandscapeID.clear();
 		return false;
+	}
 
 	Landscape* newLandscape;
 
@@ -519,12 +541,30 @@ bool LandscapeMgr::setCurrentLandscapeID(const QString& id, const double changeL
 			qDebug() << ".-->LandscapeMgr::setCurrentLandscapeID(): cache contains " << landscapeCache.size() << "landscapes totalling about " << landscapeCache.totalCost() << "MB.";
 #endif
 		}
+		else if (flagLandscapeAsyncLoading && landscape)
+		{
+			// Keep drawing the current landscape. processLoadedLandscapes() switches over when the new one is ready.
+			if (StelFileMgr::findFile("landscapes/" + id + "/landscape.ini").isEmpty())
+			{
+				qWarning() << "ERROR while loading landscape " << "landscapes/" + id + "/landscape.ini";
+				return false;
+			}
+#ifndef NDEBUG
+			qDebug() << "LandscapeMgr::setCurrentLandscapeID: Loading in background:" << id ;
+#endif
+			requestedLandscapeID = id;
+			requestedChangeLocationDuration = changeLocationDuration;
+			startLoadingLandscape(id);
+			return true;
+		}
 		else
 		{
 #ifndef NDEBUG
 			qDebug() << "LandscapeMgr::setCurrentLandscapeID: Loading from file:" << id ;
 #endif
 			newLandscape = createFromFile(StelFileMgr::findFile("landscapes/" + id + "/landscape.ini"), id);
+			if (newLandscape)
+				newLandscape->finishLoading(true);
 		}
 
 		if (!newLandscape)
@@ -534,6 +574,13 @@ bool LandscapeMgr::setCurrentLandscapeID(const QString& id, const double changeL
 		}
 	}
 
+	requestedLandscapeID.clear();
+	activateLandscape(newLandscape, changeLocationDuration);
+	return true;
+}
+
+void LandscapeMgr::activateLandscape(Landscape* newLandscape, const double changeLocationDuration)
+{
 	// Keep current landscape for a while, while new landscape fades in!
 	// This prevents subhorizon sun or grid becoming briefly visible.
 	if (landscape)
@@ -558,7 +605,7 @@ bool LandscapeMgr::setCurrentLandscapeID(const QString& id, const double changeL
 		oldLandscape = landscape; // keep old while transitioning!
 	}
 	landscape=newLandscape;
-	currentLandscapeID = id;
+	currentLandscapeID = newLandscape->getId();
 
 	if (getFlagLandscapeSetsLocation() && landscape->hasLocation())
 	{
@@ -600,7 +647,72 @@ bool LandscapeMgr::setCurrentLandscapeID(const QString& id, const double changeL
 	emit currentLandscapeChanged(currentLandscapeID,getCurrentLandscapeName());
 
 	// else qDebug() << "Will not set new location; Landscape location: planet: " << landscape->getLocation().planetName << "name: " << landscape->getLocation().name;
-	return true;
+}
+
+
+void LandscapeMgr::startLoadingLandscape(const QString& id)
+{
+	if (landscapeLoaders.contains(id) || finishingLandscapes.contains(id))
+		return;
+
+	const QString landscapeFile = StelFileMgr::findFile("landscapes/" + id + "/landscape.ini");
+	// The application settings are not thread safe, so the label settings are read here and passed to the worker thread.
+	QSettings* conf = StelApp::getInstance().getSettings();
+	const int labelFontSize = conf->value("landscape/label_font_size", 15).toInt();
+	const Vec3f labelColor = StelUtils::strToVec3f(conf->value("landscape/label_color", "0.2,0.8,0.2").toString());
+	// Parsing, panorama decoding for opacity queries and horizon polygon construction are done in a worker thread.
+	// The textures themselves are decoded by the StelTextureMgr loader threads, and uploaded in processLoadedLandscapes().
+	landscapeLoaders.insert(id, new QFuture<Landscape*>(QtConcurrent::run(&LandscapeMgr::loadFromFile, landscapeFile, id, labelFontSize, labelColor)));
+}
+
+void LandscapeMgr::processLoadedLandscapes()
+{
+	QMutableMapIterator<QString, QFuture<Landscape*>*> loaderIt(landscapeLoaders);
+	while (loaderIt.hasNext())
+	{
+		loaderIt.next();
+		if (!loaderIt.value()->isFinished())
+			continue;
+		Landscape* newLandscape = loaderIt.value()->result();
+		delete loaderIt.value();
+		if (newLandscape)
+			finishingLandscapes.insert(loaderIt.key(), newLandscape);
+		else
+		{
+			qWarning() << "ERROR while loading landscape " << "landscapes/" + loaderIt.key() + "/landscape.ini";
+			if (loaderIt.key()==requestedLandscapeID)
+			{
+				requestedLandscapeID.clear();
+				emit landscapeLoadingFinished(loaderIt.key(), false);
+			}
+		}
+		loaderIt.remove();
+	}
+
+	QMutableMapIterator<QString, Landscape*> finishIt(finishingLandscapes);
+	while (finishIt.hasNext())
+	{
+		finishIt.next();
+		Landscape* newLandscape = finishIt.value();
+		// Upload the textures which are decoded by now. This is the only part which must be done in the main thread.
+		if (!newLandscape->finishLoading())
+			continue;
+		finishIt.remove();
+
+		if (newLandscape->getId()==requestedLandscapeID && newLandscape->getId()!=currentLandscapeID)
+		{
+			requestedLandscapeID.clear();
+			activateLandscape(newLandscape, requestedChangeLocationDuration);
+			emit landscapeLoadingFinished(currentLandscapeID, true);
+		}
+		else
+		{
+			landscapeCache.insert(newLandscape->getId(), newLandscape, newLandscape->getMemorySize()/(1024*1024)+1);
+#ifndef NDEBUG
+			qDebug() << "LandscapeMgr::processLoadedLandscapes(): cache contains " << landscapeCache.size() << "landscapes totalling about " << landscapeCache.totalCost() << "MB.";
+#endif
+		}
+	}
 }
 
 bool LandscapeMgr::setCurrentLandscapeName(const QString& name, const double changeLocationDuration)
@@ -623,18 +735,34 @@ bool LandscapeMgr::setCurrentLandscapeName(const QString& name, const double cha
 // Load a landscape into cache.
 // @param id the ID of a landscape
 // @param replace true if existing landscape entry should be replaced (useful during development to reload after edit)
-// @return false if landscape could not be found, or existed already and replace was false.
-bool LandscapeMgr::precacheLandscape(const QString& id, const bool replace)
+// @param background true to load the landscape in background threads
+// @return false if landscape could not be found, or existed already and replace was false, or is already being loaded.
+bool LandscapeMgr::precacheLandscape(const QString& id, const bool replace, const bool background)
 {
 	if (landscapeCache.contains(id) && (!replace))
 		return false;
 
+	if (background)
+	{
+		if (landscapeLoaders.contains(id) || finishingLandscapes.contains(id))
+			return false;
+		if (StelFileMgr::findFile("landscapes/" + id + "/landscape.ini").isEmpty())
+		{
+			qWarning() << "ERROR while preloading landscape " << "landscapes/" + id + "/landscape.ini";
+			return false;
+		}
+		// processLoadedLandscapes() adds it to the cache when it is ready
+		startLoadingLandscape(id);
+		return true;
+	}
+
 	Landscape* newLandscape = createFromFile(StelFileMgr::findFile("landscapes/" + id + "/landscape.ini"), id);
 	if (!newLandscape)
 	{
 		qWarning() << "ERROR while preloading landscape " << "landscapes/" + id + "/landscape.ini";
 		return false;
 	}
+	newLandscape->finishLoading(true);
 
 	bool res=landscapeCache.insert(id, newLandscape, newLandscape->getMemorySize()/(1024*1024)+1);
 #ifndef NDEBUG
@@ -1055,7 +1183,42 @@ void LandscapeMgr::setAtmosphereAverageLuminance(const float overrideLum)
 	atmosphere->setAverageLuminance(overrideLum);
 }
 
+bool LandscapeMgr::getFlagAtmosphereAverageLuminanceOverride() const
+{
+	return atmosphere->isAverageLuminanceOverridden();
+}
+
+float LandscapeMgr::getOcclusionHorizonOpacity(const Vec3d& azalt, const bool mathematicalHorizonFallback) const
+{
+	const int n = occlusionHorizon.size();
+	// azimuth from North eastwards, like in the landscape's horizon polygons
+	const double azimuth = M_PI - std::atan2(azalt[1], azalt[0]);
+	const double altitude = std::atan2(azalt[2], std::sqrt(azalt[0]*azalt[0]+azalt[1]*azalt[1]));
+	const double pos = StelUtils::fmodpos(azimuth, 2.*M_PI) * n / (2.*M_PI);
+	const int i = static_cast<int>(pos) % n;
+	const double f = pos - std::floor(pos);
+	float alt0 = occlusionHorizon.at(i);
+	float alt1 = occlusionHorizon.at((i+1)%n);
+	if (mathematicalHorizonFallback)
+	{
+		static const float noData = static_cast<float>(-M_PI_2);
+		if (alt0<=noData)
+			alt0 = 0.f;
+		if (alt1<=noData)
+			alt1 = 0.f;
+	}
+	const double horizonAltitude = (1.-f)*static_cast<double>(alt0) + f*static_cast<double>(alt1);
+	return altitude<horizonAltitude ? 1.0f : 0.0f;
+}
+
 Landscape* LandscapeMgr::createFromFile(const QString& landscapeFile, const QString& landscapeId)
+{
+	QSettings *conf=StelApp::getInstance().getSettings();
+	return loadFromFile(landscapeFile, landscapeId, conf->value("landscape/label_font_size", 15).toInt(),
+			    StelUtils::strToVec3f(conf->value("landscape/label_color", "0.2,0.8,0.2").toString()));
+}
+
+Landscape* LandscapeMgr::loadFromFile(const QString& landscapeFile, const QString& landscapeId, const int labelFontSize, const Vec3f& labelColor)
 {
 	QSettings landscapeIni(landscapeFile, StelIniFormat);
 	QString s;
@@ -1076,6 +1239,8 @@ Landscape* LandscapeMgr::createFromFile(const QString& landscapeFile, const QStr
 		landscape = new LandscapeFisheye();
 	else if (s=="polygonal")
 		landscape = new LandscapePolygonal();
+	else if (s=="tiled")
+		landscape = new LandscapeTiled();
 	else
 	{
 		qDebug() << "Unknown landscape type: \"" << s << "\"";
@@ -1085,9 +1250,9 @@ Landscape* LandscapeMgr::createFromFile(const QString& landscapeFile, const QStr
 		landscape = new LandscapeFisheye();
 	}
 
+	landscape->setLabelFontSize(labelFontSize);
+	landscape->setLabelColor(labelColor);
 	landscape->load(landscapeIni, landscapeId);
-	QSettings *conf=StelApp::getInstance().getSettings();
-	landscape->setLabelFontSize(conf->value("landscape/label_font_size", 15).toInt());
 	return landscape;
 }
 
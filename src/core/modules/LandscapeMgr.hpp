@@ -29,10 +29,12 @@
 #include <QMap>
 #include <QStringList>
 #include <QCache>
+#include <QVector>
 
 class Atmosphere;
 class Cardinals;
 class QSettings;
+template <class T> class QFuture;
 
 //! @class LandscapeMgr
 //! Manages all the rendering at the level of the observer's surroundings.
@@ -170,6 +172,9 @@ public:
 	//! directory in which the files (textures and so on) for the landscape reside.
 	//! @return A pointer to the newly created landscape object.
 	Landscape* createFromFile(const QString& landscapeFile, const QString& landscapeId);
+	//! Same as createFromFile(), but with the label settings given instead of read from the application settings.
+	//! This does not access shared state and may be called from a worker thread.
+	static Landscape* loadFromFile(const QString& landscapeFile, const QString& landscapeId, const int labelFontSize, const Vec3f& labelColor);
 
 	// GZ: implement StelModule's method. For test purposes only, we implement a manual transparency sampler.
 	// TODO: comment this away for final builds. Please leave it in until this feature is finished.
@@ -192,6 +197,8 @@ public slots:
 	//! For these cases, it is advisable to first center the brightest luminary (sun or moon), call getAtmosphereAverageLuminance() and then set
 	//! this value explicitly to freeze it during image export. To unfreeze, call this again with any negative value.
 	void setAtmosphereAverageLuminance(const float overrideLuminance);
+	//! @return true if the average luminance of the atmosphere is currently frozen by setAtmosphereAverageLuminance()
+	bool getFlagAtmosphereAverageLuminanceOverride() const;
 
 	//! Return a map of landscape names to landscape IDs (directory names).
 	static QMap<QString,QString> getNameToDirMap();
@@ -215,6 +222,9 @@ public slots:
 	const QString getCurrentLandscapeID() const {return currentLandscapeID;}
 	//! Change the current landscape to the landscape with the ID specified.
 	//! Emits currentLandscapeChanged() if the landscape changed (true returned)
+	//! When the landscape is loaded in the background (see setFlagLandscapeAsyncLoading()), true only means that the
+	//! change has been started: the current landscape is kept until the new one is ready, and landscapeLoadingFinished()
+	//! reports whether loading succeeded.
 	//! @param id the ID of the new landscape
 	//! @param changeLocationDuration the duration of the transition animation
 	//! @return false if the new landscape could not be set (e.g. no landscape of that ID was found).
@@ -235,8 +245,20 @@ public slots:
 	//! Preload a landscape into cache.
 	//! @param id the ID of a landscape
 	//! @param replace true if existing landscape entry should be replaced (useful during development to reload after edit)
-	//! @return false if landscape could not be found, or if it already existed in cache and replace was false.
-	bool precacheLandscape(const QString& id, const bool replace=true);
+	//! @param background true to load the landscape in background threads without blocking the program,
+	//! e.g. in scripts to prefetch the landscapes needed for the next scenes of a show.
+	//! The landscape is then added to the cache some frames later, see isLoadingLandscape().
+	//! @return false if landscape could not be found, if it already existed in cache and replace was false,
+	//! or if it is already being loaded in the background.
+	bool precacheLandscape(const QString& id, const bool replace=true, const bool background=false);
+	//! Return true while landscapes are being loaded in the background.
+	bool isLoadingLandscape() const {return !landscapeLoaders.isEmpty() || !finishingLandscapes.isEmpty();}
+	//! Set whether landscapes which are not in the cache are loaded in background threads.
+	//! The current landscape remains visible until the new one is ready, which then fades in.
+	//! Default: true, or configured as [landscape/flag_async_loading] from config.ini.
+	void setFlagLandscapeAsyncLoading(const bool b) {flagLandscapeAsyncLoading=b;}
+	//! Get whether landscapes which are not in the cache are loaded in background threads.
+	bool getFlagLandscapeAsyncLoading() const {return flagLandscapeAsyncLoading;}
 	//! Remove a landscape from the cache of landscapes.
 	//! @param id the ID of a landscape
 	//! @return false if landscape could not be found
@@ -439,18 +461,39 @@ public slots:
 	//! Set flag for auto-enable atmosphere and landscape for planets with atmospheres in location window
 	void setFlagEnvironmentAutoEnable(bool b);
 
-	//! Forward opacity query to current landscape.
+	//! Set a horizon profile which is added to the horizon of the current landscape in the opacity queries,
+	//! e.g. the horizon computed from a 3D foreground at the current viewer position.
+	//! @param altitudes the horizon altitudes in radians, sampled at equal steps of azimuth.
+	//! The first sample is North (azimuth 0), the following are counted eastwards.
+	//! Azimuths where the profile has no data are marked with -pi/2.
+	void setOcclusionHorizon(const QVector<float>& altitudes) {occlusionHorizon = altitudes;}
+	//! Restore the horizon of the current landscape for the opacity queries.
+	void clearOcclusionHorizon() {occlusionHorizon.clear();}
+	//! Return true if a horizon profile set by setOcclusionHorizon() is active.
+	bool hasOcclusionHorizon() const {return !occlusionHorizon.isEmpty();}
+	//! Return 1 if the direction is below the occlusion horizon, 0 otherwise.
 	//! @param azalt direction of view line to sample in azaltimuth coordinates.
-	float getLandscapeOpacity(Vec3d azalt) const {return landscape->getOpacity(azalt);}
+	//! @param mathematicalHorizonFallback if true, azimuths where the profile has no data use the
+	//! mathematical horizon, else they never occlude (used when combined with the landscape horizon).
+	float getOcclusionHorizonOpacity(const Vec3d& azalt, const bool mathematicalHorizonFallback=true) const;
+
+	//! Forward opacity query to current landscape, combined with the occlusion horizon if one is set.
+	//! The occlusion horizon only adds to the landscape, so that azimuths without 3D geometry keep the landscape horizon.
+	//! @param azalt direction of view line to sample in azaltimuth coordinates.
+	float getLandscapeOpacity(Vec3d azalt) const
+	{
+		const float opacity = landscape->getOpacity(azalt);
+		return occlusionHorizon.isEmpty() ? opacity : qMax(opacity, getOcclusionHorizonOpacity(azalt, false));
+	}
 	// This variant is required for scripting!
-	float getLandscapeOpacity(Vec3f azalt) const {return landscape->getOpacity(azalt.toVec3d());}
-	//! Forward opacity query to current landscape.
+	float getLandscapeOpacity(Vec3f azalt) const {return getLandscapeOpacity(azalt.toVec3d());}
+	//! Forward opacity query to current landscape, combined with the occlusion horizon if one is set.
 	//! @param azimuth in degrees
 	//! @param altitude in degrees
 	float getLandscapeOpacity(float azimuth, float altitude) const {
 		Vec3d azalt;
 		StelUtils::spheToRect((180.0f-azimuth)*M_PI_180f, altitude*M_PI_180f, azalt);
-		return landscape->getOpacity(azalt);
+		return getLandscapeOpacity(azalt);
 	}
 
 signals:
@@ -503,6 +546,11 @@ signals:
 	//! \param currentLandscapeName the name of the new landscape
 	void currentLandscapeChanged(QString currentLandscapeID,QString currentLandscapeName);
 
+	//! Emitted when a landscape requested with setCurrentLandscapeID() has finished loading in the background.
+	//! \param landscapeID the ID of the requested landscape
+	//! \param success true if the landscape has become the current landscape, false if it could not be loaded
+	void landscapeLoadingFinished(QString landscapeID, bool success);
+
 private slots:
 	//! Set the light pollution following the Bortle Scale.
 	//! This should not be called from script code, use StelMainScriptAPI::setBortleScaleIndex if you want to change the light pollution.
@@ -537,10 +585,21 @@ private:
 	//! @returns an empty string, if no such landscape was found.
 	static QString getLandscapePath(const QString landscapeID);
 
+	//! Make newLandscape the current landscape. The previous landscape is kept while the new one fades in.
+	//! Emits currentLandscapeChanged().
+	void activateLandscape(Landscape* newLandscape, const double changeLocationDuration);
+	//! Start constructing a landscape in a worker thread. Does nothing if it is already being loaded.
+	void startLoadingLandscape(const QString& id);
+	//! Collect landscapes whose background loading has finished, upload their textures,
+	//! and switch to the requested landscape when it is ready. Other landscapes go to the cache.
+	void processLoadedLandscapes();
+
 	Atmosphere* atmosphere;			// Atmosphere
 	Cardinals* cardinalsPoints;		// Cardinals points
 	Landscape* landscape;			// The landscape i.e. the fog, the ground and "decor"
 	Landscape* oldLandscape;		// Used only during transitions to newly loaded landscape.
+	//! Horizon altitudes combined with the landscape horizon in the opacity queries, see setOcclusionHorizon()
+	QVector<float> occlusionHorizon;
 
 	// Define whether the observer location is to be updated when the landscape is updated.
 	bool flagLandscapeSetsLocation;
@@ -577,6 +636,17 @@ private:
 	//! The key is just the LandscapeID.
 	QCache<QString,Landscape> landscapeCache;
 
+	//! Define whether landscapes not found in the cache are loaded in background threads.
+	bool flagLandscapeAsyncLoading;
+	//! Landscapes which are being constructed in worker threads, keyed by landscape ID.
+	QMap<QString, QFuture<Landscape*>*> landscapeLoaders;
+	//! Landscapes which are constructed, but whose textures are not yet all uploaded to OpenGL.
+	QMap<QString, Landscape*> finishingLandscapes;
+	//! ID of the landscape which becomes current as soon as its background loading has finished. Empty if none.
+	QString requestedLandscapeID;
+	//! Transition duration for the location change of the requested landscape.
+	double requestedChangeLocationDuration;
+
 	//! Core current planet name, used to react to planet change.
 	QString currentPlanetName;
 };
@@ -35,6 +35,7 @@ class QDataStream;
 class Nebula : public StelObject
 {
 friend class NebulaMgr;
+friend class NebulaStore;
 
 	//Required for the correct working of the Q_FLAGS macro (which requires a MOC pass)
 	Q_GADGET
@@ -40,6 +40,7 @@
 #include "StelPainter.hpp"
 #include "RefractionExtinction.hpp"
 #include "StelActionMgr.hpp"
+#include "StelGeodesicGrid.hpp"
 
 #include <algorithm>
 #include <vector>
@@ -50,6 +51,8 @@
 #include <QStringList>
 #include <QRegExp>
 #include <QDir>
+#include <QDataStream>
+#include <QElapsedTimer>
 
 // Define version of valid Stellarium DSO Catalog
 // This number must be incremented each time the content or file format of the stars catalogs change
@@ -142,8 +145,14 @@ NebulaMgr::NebulaMgr(void) : StelObjectModule()
 	, labelsAmount(0)
 	, flagConverter(false)
 	, flagDecimalCoordinates(true)
+	, moduleDataLoaded(false)
+	, extendedNebulae(50000)
 {
 	setObjectName("NebulaMgr");
+	// for DSO convertor (for developers!), read here because the catalog may be loaded in a worker thread
+	QSettings* conf = StelApp::getInstance().getSettings();
+	flagConverter = conf->value("devel/convert_dso_catalog", false).toBool();
+	flagDecimalCoordinates = conf->value("devel/convert_dso_decimal_coord", true).toBool();
 }
 
 NebulaMgr::~NebulaMgr()
@@ -343,10 +352,6 @@ void NebulaMgr::init()
 	setEmissionObjectColor(StelUtils::strToVec3f(conf->value("color/dso_emission_object_color", defaultStellarColor).toString()));
 	setYoungStellarObjectColor(StelUtils::strToVec3f(conf->value("color/dso_young_stellar_object_color", defaultStellarColor).toString()));
 
-	// for DSO convertor (for developers!)
-	flagConverter = conf->value("devel/convert_dso_catalog", false).toBool();
-	flagDecimalCoordinates = conf->value("devel/convert_dso_decimal_coord", true).toBool();
-
 	setFlagUseTypeFilters(conf->value("astro/flag_use_type_filter", false).toBool());
 
 	Nebula::CatalogGroup catalogFilters = Nebula::CatalogGroup(Q_NULLPTR);
@@ -447,7 +452,9 @@ void NebulaMgr::init()
 	// 3. flag in nebula_textures.fab (yuk)
 	// 4. info.ini file in each set containing a "load at startup" item
 	// For now (0.9.0), just load the default set
-	loadNebulaSet("default");
+	// The data is loaded in the background at startup, unless the module is initialized on its own
+	if (!moduleDataLoaded)
+		loadNebulaSet("default");
 
 	updateI18n();
 
@@ -495,17 +502,27 @@ struct DrawNebulaFuncObject
 		if (n->majorAxisSize>angularSizeLimit || n->majorAxisSize==0.f || mag <= maxMagHints)
 		{
 			sPainter->getProjector()->project(n->XYZ,n->XY);
-			n->drawLabel(*sPainter, maxMagLabels);
 			n->drawHints(*sPainter, maxMagHints);
 			n->drawOutlines(*sPainter, maxMagHints);
+			// The labels are drawn after all the hints, drawing text would flush the batch of hints.
+			// This is a deliberate change of the drawing order: a label overlapping the hint of another object
+			// is now always drawn over it, where it could be drawn under it before.
+			labelled.append(n);
 		}
 	}
+	//! Draw the labels of the objects whose hints were drawn
+	void drawLabels()
+	{
+		for (const auto* n : labelled)
+			n->drawLabel(*sPainter, maxMagLabels);
+	}
 	float maxMagHints;
 	float maxMagLabels;
 	StelPainter* sPainter;
 	StelCore* core;
 	float angularSizeLimit;
 	bool checkMaxMagHints;
+	QVector<Nebula*> labelled;
 };
 
 void NebulaMgr::setCatalogFilters(Nebula::CatalogGroup cflags)
@@ -678,8 +695,44 @@ void NebulaMgr::draw(StelCore* core)
 	float maxMagLabels = skyDrawer->getLimitMagnitude()-2.f+static_cast<float>(labelsAmount*1.2)-2.f;
 	sPainter.setFont(nebulaFont);
 	DrawNebulaFuncObject func(maxMagHints, maxMagLabels, &sPainter, core, hintsFader.getInterstate()<=0.f);
+	// Collect the hint sprites, so that they are drawn with a few draw calls
+	sPainter.setBatching(true);
 	nebGrid.processIntersectingPointInRegions(p.data(), func);
 
+	// Draw the objects of the extended catalog which pass the same test as the objects above. The summaries of the store
+	// are checked first, so that only these objects are read from the catalog.
+	QVector<NebulaP> drawnExtended;
+	if (extendedCatalog.isOpen() && !func.checkMaxMagHints)
+	{
+		const int level = extendedCatalog.getLevel();
+		const GeodesicSearchResult* geodesicSearchResult = core->getGeodesicGrid(level)->search(p->getBoundingSphericalCaps(), level);
+		auto drawZone = [&](int zone) {
+			int last;
+			for (int i=extendedCatalog.getZone(zone, last); i<last; ++i)
+			{
+				const NebulaStore::Entry& e = extendedCatalog.getEntry(i);
+				// The objects of a zone are ordered by magnitude, but the large objects and those without size
+				// are drawn whatever their magnitude, so the scan can't stop at the hint magnitude
+				if (!(e.size>func.angularSizeLimit || e.size==0.f || e.mag<=maxMagHints))
+					continue;
+				const NebulaP n = getExtendedNebula(i);
+				if (!n.isNull())
+				{
+					func(n.data());
+					// Keep the object until its label is drawn, it may be evicted from the cache
+					drawnExtended.append(n);
+				}
+			}
+		};
+		int zone;
+		for (GeodesicSearchInsideIterator it(*geodesicSearchResult, level); (zone = it.next()) >= 0;)
+			drawZone(zone);
+		for (GeodesicSearchBorderIterator it(*geodesicSearchResult, level); (zone = it.next()) >= 0;)
+			drawZone(zone);
+	}
+	sPainter.setBatching(false);
+	func.drawLabels();
+
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
 		drawPointer(core, sPainter);
 }
@@ -788,6 +841,13 @@ NebulaP NebulaMgr::search(const QString& name)
 	return NebulaP();
 }
 
+void NebulaMgr::loadModuleData()
+{
+	// loadNebulaSet() starts from an empty set, so it can be called again after a failure
+	loadNebulaSet("default");
+	moduleDataLoaded = true;
+}
+
 void NebulaMgr::loadNebulaSet(const QString& setName)
 {
 	QString srcCatalogPath		= StelFileMgr::findFile("nebulae/" + setName + "/catalog.txt");
@@ -797,6 +857,10 @@ void NebulaMgr::loadNebulaSet(const QString& setName)
 	dsoArray.clear();
 	dsoIndex.clear();
 	nebGrid.clear();
+	extendedCatalog.close();
+	extendedNebulae.clear();
+	extendedNebulaRefs.clear();
+	mainCatalogPGC.clear();
 
 	if (flagConverter)
 	{
@@ -816,6 +880,66 @@ void NebulaMgr::loadNebulaSet(const QString& setName)
 
 	if (!dsoOutlinesPath.isEmpty())
 		loadDSOOutlines(dsoOutlinesPath);
+
+	loadExtendedCatalog(setName);
+}
+
+void NebulaMgr::loadExtendedCatalog(const QString& setName)
+{
+	const QString extendedCatalogPath = StelFileMgr::findFile("nebulae/" + setName + "/extended.dat");
+	if (extendedCatalogPath.isEmpty())
+		return;
+
+	for (const auto& n : dsoArray)
+	{
+		if (n->PGC_nb>0)
+			mainCatalogPGC.insert(n->PGC_nb);
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	const QString storeFile = StelFileMgr::getCacheDir() + "/nebulae/" + setName + "/extended.bin";
+	if (extendedCatalog.open(storeFile, extendedCatalogPath, StellariumDSOCatalogVersion))
+		qDebug() << (extendedCatalog.wasCompiled() ? "Compiled" : "Mapped") << "extended DSO catalog with" << extendedCatalog.size()
+			 << "records in" << timer.elapsed() << "ms";
+	else
+		qWarning() << "ERROR while loading extended deep-sky catalog" << QDir::toNativeSeparators(extendedCatalogPath);
+}
+
+NebulaP NebulaMgr::getExtendedNebula(int index) const
+{
+	NebulaP* cached = extendedNebulae.object(index);
+	if (cached)
+		return *cached;
+
+	// The object may have been evicted from the cache while it is still selected or pointed
+	NebulaP n = extendedNebulaRefs.value(index).toStrongRef();
+	if (n.isNull())
+	{
+		const NebulaStore::Entry& e = extendedCatalog.getEntry(index);
+		if (e.pgc>0 && mainCatalogPGC.contains(e.pgc))
+			return NebulaP();
+
+		QDataStream in(extendedCatalog.getRecord(index));
+		in.setVersion(QDataStream::Qt_5_2);
+		n = NebulaP(new Nebula);
+		n->readDSO(in);
+
+		// Forget the objects which are not used anymore
+		if (extendedNebulaRefs.size()>=2*extendedNebulae.maxCost())
+		{
+			for (auto it = extendedNebulaRefs.begin(); it!=extendedNebulaRefs.end();)
+			{
+				if (it.value().isNull())
+					it = extendedNebulaRefs.erase(it);
+				else
+					++it;
+			}
+		}
+		extendedNebulaRefs.insert(index, n.toWeakRef());
+	}
+	extendedNebulae.insert(index, new NebulaP(n));
+	return n;
 }
 
 // Look for a nebulae by XYZ coords
@@ -841,7 +965,7 @@ NebulaP NebulaMgr::search(const Vec3d& apos)
 }
 
 
-QList<StelObjectP> NebulaMgr::searchAround(const Vec3d& av, double limitFov, const StelCore*) const
+QList<StelObjectP> NebulaMgr::searchAround(const Vec3d& av, double limitFov, const StelCore* core) const
 {
 	QList<StelObjectP> result;
 	if (!getFlagShow())
@@ -860,6 +984,31 @@ QList<StelObjectP> NebulaMgr::searchAround(const Vec3d& av, double limitFov, con
 			result.push_back(qSharedPointerCast<StelObject>(n));
 		}
 	}
+
+	if (extendedCatalog.isOpen() && core)
+	{
+		const int level = extendedCatalog.getLevel();
+		const QVector<SphericalCap> caps = {SphericalCap(v, cosLimFov)};
+		const GeodesicSearchResult* geodesicSearchResult = core->getGeodesicGrid(level)->search(caps, level);
+		auto searchZone = [&](int zone) {
+			int last;
+			for (int i=extendedCatalog.getZone(zone, last); i<last; ++i)
+			{
+				const NebulaStore::Entry& e = extendedCatalog.getEntry(i);
+				if (Vec3d(e.pos[0], e.pos[1], e.pos[2])*v >= cosLimFov)
+				{
+					const NebulaP n = getExtendedNebula(i);
+					if (!n.isNull())
+						result.push_back(qSharedPointerCast<StelObject>(n));
+				}
+			}
+		};
+		int zone;
+		for (GeodesicSearchInsideIterator it(*geodesicSearchResult, level); (zone = it.next()) >= 0;)
+			searchZone(zone);
+		for (GeodesicSearchBorderIterator it(*geodesicSearchResult, level); (zone = it.next()) >= 0;)
+			searchZone(zone);
+	}
 	return result;
 }
 
@@ -972,6 +1121,10 @@ NebulaP NebulaMgr::searchPGC(unsigned int PGC) const
 	for (const auto& n : dsoArray)
 		if (n->PGC_nb == PGC)
 			return n;
+
+	const int index = extendedCatalog.searchPGC(PGC);
+	if (index>=0)
+		return getExtendedNebula(index);
 	return NebulaP();
 }
 
@@ -1349,6 +1502,8 @@ bool NebulaMgr::loadDSOCatalog(const QString &filename)
 
 	QString version = "", edition= "";
 	int totalRecords=0;
+	// The grid is bulk loaded at the end, which is much faster than inserting the records one by one
+	QVector<StelRegionObjectP> gridObjects;
 	while (!ins.atEnd())
 	{
 		if (totalRecords==0) // Read the version of catalog
@@ -1373,13 +1528,14 @@ bool NebulaMgr::loadDSOCatalog(const QString &filename)
 			e->readDSO(ins);
 
 			dsoArray.append(e);
-			nebGrid.insert(qSharedPointerCast<StelRegionObject>(e));
+			gridObjects.append(qSharedPointerCast<StelRegionObject>(e));
 			if (e->DSO_nb!=0)
 				dsoIndex.insert(e->DSO_nb, e);
 		}
 		++totalRecords;
 	}
 	in.close();
+	nebGrid.insert(gridObjects);
 	qDebug() << "Loaded" << --totalRecords << "DSO records";
 	return true;
 }
@@ -1939,6 +2095,15 @@ QStringList NebulaMgr::listMatchingObjects(const QString& objPrefix, int maxNbIt
 			if (constws==objw)
 				result << constw;
 		}
+
+		// The extended catalog is too large to be listed, only add the exact number
+		static QRegExp pgcRx("^PGC\\s*(\\d+)$");
+		if (pgcRx.exactMatch(objw))
+		{
+			const unsigned int pgc = pgcRx.capturedTexts().at(1).toUInt();
+			if (!mainCatalogPGC.contains(pgc) && extendedCatalog.searchPGC(pgc)>=0)
+				result << QString("PGC %1").arg(pgc);
+		}
 	}
 
 	// Search by UGC object numbers (possible formats are "UGC31" or "UGC 31")
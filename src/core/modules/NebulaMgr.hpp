@@ -28,10 +28,13 @@
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "Nebula.hpp"
+#include "NebulaStore.hpp"
 
 #include <QString>
 #include <QStringList>
 #include <QFont>
+#include <QCache>
+#include <QSet>
 
 class StelTranslator;
 class StelToneReproducer;
@@ -325,6 +328,10 @@ public:
 	//!  - call updateI18n() to translate names.
 	virtual void init();
 
+	//! Read the default DSO catalog, its outlines and the extended catalog.
+	//! Called in a worker thread before init() at startup, or by init() itself.
+	virtual void loadModuleData();
+
 	//! Draws all nebula objects.
 	virtual void draw(StelCore* core);
 
@@ -969,6 +976,11 @@ private:
 	bool loadDSONames(const QString& filename);
 	// Load outlines for DSO
 	bool loadDSOOutlines(const QString& filename);
+	// Open the extended catalog of the set, compiling it if needed
+	void loadExtendedCatalog(const QString& setName);
+	//! Return the Nebula of the object of the extended catalog, creating it if needed.
+	//! Return a null pointer if the object is already in the main catalog.
+	NebulaP getExtendedNebula(int index) const;
 
 	QVector<NebulaP> dsoArray;		// The DSO list
 	QHash<unsigned int, NebulaP> dsoIndex;
@@ -992,6 +1004,18 @@ private:
 	// For DSO convertor
 	bool flagConverter;
 	bool flagDecimalCoordinates;
+	//! True once loadModuleData() succeeded
+	bool moduleDataLoaded;
+
+	//! Large catalog of the set (extended.dat), whose objects are only created when drawn, searched or selected
+	NebulaStore extendedCatalog;
+	//! The objects created from the extended catalog, by index in the store
+	mutable QCache<int, NebulaP> extendedNebulae;
+	//! The objects created from the extended catalog which may still be used outside of the cache, e.g. when
+	//! selected, so that the same instance is returned after it was evicted from the cache
+	mutable QHash<int, QWeakPointer<Nebula>> extendedNebulaRefs;
+	//! PGC numbers of the main catalog, to skip the same objects in the extended catalog
+	QSet<unsigned int> mainCatalogPGC;
 };
 
 #endif // NEBULAMGR_HPP
@@ -0,0 +1,436 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "NebulaStore.hpp"
+#include "Nebula.hpp"
+#include "StelGeodesicGrid.hpp"
+#include "StelUtils.hpp"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+// Header and version of the compiled file, to be incremented when the format changes
+static const quint32 NEBULA_STORE_MAGIC = 0x4e425354;
+static const quint32 NEBULA_STORE_VERSION = 2;
+// Maximal mean number of objects per zone of the geodesic grid
+static const int NEBULA_STORE_ZONE_SIZE = 64;
+
+static quint64 align8(quint64 offset)
+{
+	return (offset+7) & ~static_cast<quint64>(7);
+}
+
+//! Sequential device inflating a gzip or zlib compressed device chunk by chunk, so that a large catalog can be
+//! read with a QDataStream without uncompressing it into memory. The bytes read since the last call to
+//! takeRead() are kept, to copy the records as they are read.
+class InflatingDevice : public QIODevice
+{
+public:
+	InflatingDevice(QIODevice& source)
+		: source(source)
+		, input(CHUNK, 0)
+		, pendingPos(0)
+		, finished(false)
+		, failed(false)
+	{
+		memset(&strm, 0, sizeof(strm));
+		// 15 + 32 for gzip automatic header detection
+		failed = finished = inflateInit2(&strm, 15 + 32)!=Z_OK;
+	}
+	~InflatingDevice() Q_DECL_OVERRIDE
+	{
+		inflateEnd(&strm);
+	}
+
+	bool isSequential() const Q_DECL_OVERRIDE {return true;}
+	qint64 bytesAvailable() const Q_DECL_OVERRIDE
+	{
+		const_cast<InflatingDevice*>(this)->fill();
+		return pending.size()-pendingPos + QIODevice::bytesAvailable();
+	}
+	//! Return true if the compressed data is corrupted
+	bool hasFailed() const {return failed;}
+	//! Return the bytes read since the last call
+	QByteArray takeRead()
+	{
+		QByteArray r;
+		r.swap(consumed);
+		return r;
+	}
+
+protected:
+	qint64 readData(char* d, qint64 maxSize) Q_DECL_OVERRIDE
+	{
+		qint64 total = 0;
+		while (total<maxSize && fill())
+		{
+			const int n = static_cast<int>(qMin(maxSize-total, static_cast<qint64>(pending.size()-pendingPos)));
+			memcpy(d+total, pending.constData()+pendingPos, static_cast<size_t>(n));
+			consumed.append(pending.constData()+pendingPos, n);
+			pendingPos += n;
+			total += n;
+		}
+		return total;
+	}
+	qint64 writeData(const char*, qint64) Q_DECL_OVERRIDE {return -1;}
+
+private:
+	static const int CHUNK = 262144;
+
+	//! Inflate the next chunk if all the inflated data was read, return false at the end of the stream
+	bool fill()
+	{
+		if (pendingPos<pending.size())
+			return true;
+		pending.resize(CHUNK);
+		pendingPos = 0;
+		int produced = 0;
+		while (!finished && produced==0)
+		{
+			if (strm.avail_in==0)
+			{
+				const qint64 read = source.read(input.data(), CHUNK);
+				if (read<=0)
+				{
+					finished = true;
+					break;
+				}
+				strm.next_in = reinterpret_cast<Bytef*>(input.data());
+				strm.avail_in = static_cast<uInt>(read);
+			}
+			strm.next_out = reinterpret_cast<Bytef*>(pending.data());
+			strm.avail_out = CHUNK;
+			const int ret = inflate(&strm, Z_NO_FLUSH);
+			if (ret==Z_STREAM_END)
+				finished = true;
+			else if (ret!=Z_OK && ret!=Z_BUF_ERROR)
+			{
+				qWarning() << "zlib error (" << ret << "), can't uncompress";
+				failed = finished = true;
+			}
+			produced = CHUNK-static_cast<int>(strm.avail_out);
+		}
+		pending.resize(produced);
+		return produced>0;
+	}
+
+	QIODevice& source;
+	z_stream strm;
+	QByteArray input;
+	QByteArray pending;
+	int pendingPos;
+	QByteArray consumed;
+	bool finished;
+	bool failed;
+};
+
+NebulaStore::NebulaStore()
+	: mapped(Q_NULLPTR)
+	, data(Q_NULLPTR)
+	, header(Q_NULLPTR)
+	, compiled(false)
+{
+}
+
+NebulaStore::~NebulaStore()
+{
+	close();
+}
+
+void NebulaStore::close()
+{
+	if (mapped)
+		file.unmap(mapped);
+	mapped = Q_NULLPTR;
+	if (file.isOpen())
+		file.close();
+	buffer.clear();
+	data = Q_NULLPTR;
+	header = Q_NULLPTR;
+}
+
+int NebulaStore::getLevel() const
+{
+	return header ? header->level : 0;
+}
+
+int NebulaStore::size() const
+{
+	return header ? static_cast<int>(header->entryCount) : 0;
+}
+
+int NebulaStore::getZone(int zone, int& last) const
+{
+	if (!header || zone<0 || zone>=StelGeodesicGrid::nrOfZones(header->level))
+	{
+		last = 0;
+		return 0;
+	}
+	last = static_cast<int>(zones()[zone+1]);
+	return static_cast<int>(zones()[zone]);
+}
+
+QByteArray NebulaStore::getRecord(int index) const
+{
+	const Entry& e = entries()[index];
+	return QByteArray::fromRawData(reinterpret_cast<const char*>(data + header->dataOffset + e.dataOffset), static_cast<int>(e.dataSize));
+}
+
+int NebulaStore::searchPGC(unsigned int pgc) const
+{
+	if (!header || pgc==0)
+		return -1;
+	const PgcEntry* begin = pgcIndex();
+	const PgcEntry* end = begin + header->pgcCount;
+	const PgcEntry* it = std::lower_bound(begin, end, static_cast<quint32>(pgc), [](const PgcEntry& e, quint32 p) {return e.pgc<p;});
+	return (it!=end && it->pgc==pgc) ? static_cast<int>(it->index) : -1;
+}
+
+QByteArray NebulaStore::computeSignature(const QString& catalogFile)
+{
+	QFileInfo info(catalogFile);
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	hash.addData(catalogFile.toUtf8());
+	hash.addData(QByteArray::number(info.size()));
+	hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+	return hash.result();
+}
+
+bool NebulaStore::open(const QString& storeFile, const QString& catalogFile, const QString& catalogVersion)
+{
+	close();
+	compiled = false;
+	const QByteArray signature = computeSignature(catalogFile);
+
+	// Map the compiled file if it is up to date
+	file.setFileName(storeFile);
+	if (file.open(QIODevice::ReadOnly))
+	{
+		mapped = file.map(0, file.size());
+		if (mapped && setData(mapped, file.size(), signature))
+			return true;
+		close();
+	}
+
+	compiled = true;
+	QDir().mkpath(QFileInfo(storeFile).absolutePath());
+	QSaveFile out(storeFile);
+	if (out.open(QIODevice::WriteOnly))
+	{
+		if (!compile(catalogFile, catalogVersion, signature, out))
+			return false;
+		if (out.commit())
+		{
+			file.setFileName(storeFile);
+			if (file.open(QIODevice::ReadOnly))
+			{
+				mapped = file.map(0, file.size());
+				if (mapped && setData(mapped, file.size(), signature))
+					return true;
+				close();
+			}
+		}
+	}
+
+	qWarning() << "WARNING - could not write DSO store" << QDir::toNativeSeparators(storeFile) << ", keeping it in memory";
+	QBuffer out2(&buffer);
+	out2.open(QIODevice::WriteOnly);
+	if (!compile(catalogFile, catalogVersion, signature, out2))
+		return false;
+	out2.close();
+	return setData(reinterpret_cast<const uchar*>(buffer.constData()), buffer.size(), signature);
+}
+
+bool NebulaStore::setData(const uchar* d, qint64 size, const QByteArray& signature)
+{
+	if (size<static_cast<qint64>(sizeof(Header)))
+		return false;
+	const Header* h = reinterpret_cast<const Header*>(d);
+	if (h->magic!=NEBULA_STORE_MAGIC || h->version!=NEBULA_STORE_VERSION || memcmp(h->signature, signature.constData(), sizeof(h->signature))!=0)
+		return false;
+	if (h->level<0 || h->level>7
+	    || h->zonesOffset+(StelGeodesicGrid::nrOfZones(h->level)+1)*sizeof(quint32)>static_cast<quint64>(size)
+	    || h->entriesOffset+static_cast<quint64>(h->entryCount)*sizeof(Entry)>static_cast<quint64>(size)
+	    || h->pgcOffset+static_cast<quint64>(h->pgcCount)*sizeof(PgcEntry)>static_cast<quint64>(size)
+	    || h->dataOffset+h->dataSize>static_cast<quint64>(size))
+	{
+		qWarning() << "WARNING - corrupted DSO store";
+		return false;
+	}
+	data = d;
+	header = h;
+	return true;
+}
+
+bool NebulaStore::compile(const QString& catalogFile, const QString& catalogVersion, const QByteArray& signature, QIODevice& out)
+{
+	QFile in(catalogFile);
+	if (!in.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "WARNING - could not open" << QDir::toNativeSeparators(catalogFile);
+		return false;
+	}
+	qDebug() << "Compiling DSO catalog" << QDir::toNativeSeparators(catalogFile) << "...";
+	// The catalog is inflated while it is read and its records are copied as they come, so the uncompressed
+	// catalog is never held in memory: only the summaries of the objects are kept to order them.
+	InflatingDevice inflater(in);
+	inflater.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+	QDataStream ins(&inflater);
+	ins.setVersion(QDataStream::Qt_5_2);
+	QString version, edition;
+	ins >> version >> edition;
+	inflater.takeRead();
+	if (version.isEmpty())
+		version = "3.1"; // The first version of extended edition of the catalog
+	if (StelUtils::compareVersions(version, catalogVersion)!=0)
+	{
+		qWarning() << "WARNING: Mismatch the version of catalog" << QDir::toNativeSeparators(catalogFile)
+			   << "! The expected version of catalog is" << catalogVersion;
+		return false;
+	}
+
+	qint64 written = 0;
+	bool ok = true;
+	auto write = [&out, &written, &ok](quint64 offset, const void* d, qint64 size) {
+		static const char padding[8] = {0};
+		if (offset>static_cast<quint64>(written))
+			written += out.write(padding, static_cast<qint64>(offset)-written);
+		if (size>0)
+		{
+			const qint64 w = out.write(static_cast<const char*>(d), size);
+			ok = ok && w==size;
+			written += w;
+		}
+	};
+
+	// The header is written again at the end, when the sections are known
+	Header h;
+	memset(&h, 0, sizeof(h));
+	write(0, &h, sizeof(h));
+	h.dataOffset = align8(sizeof(Header));
+	write(h.dataOffset, Q_NULLPTR, 0);
+
+	// Copy the records in the order of the catalog, and read their summaries
+	QVector<Entry> items;
+	Nebula n;
+	quint64 dataSize = 0;
+	while (ok && !ins.atEnd())
+	{
+		n.readDSO(ins);
+		const QByteArray record = inflater.takeRead();
+		if (ins.status()!=QDataStream::Ok || inflater.hasFailed())
+		{
+			qWarning() << "WARNING - truncated record at the end of" << QDir::toNativeSeparators(catalogFile);
+			break;
+		}
+		if (dataSize+static_cast<quint64>(record.size())>0xffffffffu)
+		{
+			qWarning() << "WARNING - DSO catalog" << QDir::toNativeSeparators(catalogFile) << "is too large";
+			return false;
+		}
+		Entry e;
+		for (int i=0; i<3; ++i)
+			e.pos[i] = static_cast<float>(n.XYZ[i]);
+		e.mag = n.vMag<90.f ? n.vMag : n.bMag;
+		e.size = n.majorAxisSize;
+		e.pgc = n.PGC_nb;
+		e.dataOffset = static_cast<quint32>(dataSize);
+		e.dataSize = static_cast<quint32>(record.size());
+		items.append(e);
+		write(static_cast<quint64>(written), record.constData(), record.size());
+		dataSize += static_cast<quint64>(record.size());
+	}
+	in.close();
+
+	// Order the summaries by zone and by magnitude, the records stay in the order of the catalog
+	int level = 1;
+	while (level<7 && items.size()>NEBULA_STORE_ZONE_SIZE*StelGeodesicGrid::nrOfZones(level))
+		++level;
+	const int nrOfZones = StelGeodesicGrid::nrOfZones(level);
+	StelGeodesicGrid grid(level);
+	QVector<int> itemZones(items.size());
+	QVector<int> order(items.size());
+	for (int i=0; i<items.size(); ++i)
+	{
+		itemZones[i] = grid.getZoneNumberForPoint(Vec3f(items[i].pos[0], items[i].pos[1], items[i].pos[2]), level);
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&items, &itemZones](int a, int b) {
+		return itemZones[a]!=itemZones[b] ? itemZones[a]<itemZones[b] : items[a].mag<items[b].mag;
+	});
+
+	QVector<quint32> zoneTable(nrOfZones+1, 0);
+	QVector<Entry> sorted;
+	sorted.reserve(items.size());
+	QVector<PgcEntry> pgc;
+	for (int i : order)
+	{
+		++zoneTable[itemZones[i]+1];
+		if (items[i].pgc>0)
+			pgc.append({items[i].pgc, static_cast<quint32>(sorted.size())});
+		sorted.append(items[i]);
+	}
+	items.clear();
+	for (int z=0; z<nrOfZones; ++z)
+		zoneTable[z+1] += zoneTable[z];
+	// Keep the brightest object for a duplicated PGC number: the objects of a number may lie in several zones,
+	// so order them by magnitude (then by index, to keep the result deterministic) before dropping the duplicates
+	std::sort(pgc.begin(), pgc.end(), [&sorted](const PgcEntry& a, const PgcEntry& b) {
+		if (a.pgc!=b.pgc)
+			return a.pgc<b.pgc;
+		const float magA = sorted.at(static_cast<int>(a.index)).mag;
+		const float magB = sorted.at(static_cast<int>(b.index)).mag;
+		return magA!=magB ? magA<magB : a.index<b.index;
+	});
+	pgc.erase(std::unique(pgc.begin(), pgc.end(), [](const PgcEntry& a, const PgcEntry& b) {return a.pgc==b.pgc;}), pgc.end());
+
+	h.magic = NEBULA_STORE_MAGIC;
+	h.version = NEBULA_STORE_VERSION;
+	memcpy(h.signature, signature.constData(), qMin(static_cast<int>(sizeof(h.signature)), signature.size()));
+	h.level = level;
+	h.entryCount = static_cast<quint32>(sorted.size());
+	h.dataSize = dataSize;
+	h.zonesOffset = align8(h.dataOffset + dataSize);
+	h.entriesOffset = align8(h.zonesOffset + static_cast<quint64>(zoneTable.size())*sizeof(quint32));
+	h.pgcOffset = align8(h.entriesOffset + static_cast<quint64>(sorted.size())*sizeof(Entry));
+	h.pgcCount = static_cast<quint32>(pgc.size());
+
+	write(h.zonesOffset, zoneTable.constData(), zoneTable.size()*static_cast<qint64>(sizeof(quint32)));
+	write(h.entriesOffset, sorted.constData(), sorted.size()*static_cast<qint64>(sizeof(Entry)));
+	write(h.pgcOffset, pgc.constData(), pgc.size()*static_cast<qint64>(sizeof(PgcEntry)));
+	if (!ok || written!=static_cast<qint64>(h.pgcOffset + static_cast<quint64>(pgc.size())*sizeof(PgcEntry))
+	    || !out.seek(0) || out.write(reinterpret_cast<const char*>(&h), sizeof(h))!=static_cast<qint64>(sizeof(h)))
+	{
+		qWarning() << "WARNING - could not write the DSO store";
+		return false;
+	}
+
+	qDebug() << "Compiled" << sorted.size() << "DSO records in" << nrOfZones << "zones";
+	return true;
+}
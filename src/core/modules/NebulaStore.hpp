@@ -0,0 +1,120 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef NEBULASTORE_HPP
+#define NEBULASTORE_HPP
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+//! @class NebulaStore
+//! Memory-mapped store for large deep-sky catalogs (e.g. PGC/HyperLEDA galaxies), which would take too much
+//! memory and time if each object was loaded as a Nebula at startup.
+//!
+//! The catalog file uses the format of catalog.dat. It is compiled once into a binary file, typically in the
+//! cache directory, which is memory-mapped at the next startups. The binary file contains a small summary of each
+//! object, ordered by zone of the geodesic grid and by magnitude in each zone, the catalog records themselves
+//! in the order of the catalog, and an index of the PGC numbers. The catalog is read as a stream when it is
+//! compiled, only the summaries are kept in memory. NebulaMgr creates the Nebula objects from the records
+//! only when they are drawn, searched or selected.
+class NebulaStore
+{
+public:
+	//! Summary of an object, used to select the objects without reading their record
+	struct Entry
+	{
+		float pos[3];		//!< J2000 equatorial position (unit vector)
+		float mag;		//!< Visual magnitude, or blue magnitude if unknown, 99 if unknown
+		float size;		//!< Major axis size in degrees
+		quint32 pgc;		//!< PGC number, 0 if none
+		quint32 dataOffset;	//!< Offset of the record in the data section
+		quint32 dataSize;	//!< Size of the record
+	};
+
+	NebulaStore();
+	~NebulaStore();
+
+	//! Open the store, compiling it first if it does not exist or if the catalog changed.
+	//! @param storeFile the path of the compiled file.
+	//! @param catalogFile the path of the catalog, in the format of catalog.dat.
+	//! @param catalogVersion the expected version of the catalog.
+	//! @return false if the store could be neither opened nor compiled.
+	bool open(const QString& storeFile, const QString& catalogFile, const QString& catalogVersion);
+	void close();
+
+	bool isOpen() const {return header!=Q_NULLPTR;}
+	//! Return true if the store was compiled by the last call to open(), false if it was only mapped.
+	bool wasCompiled() const {return compiled;}
+
+	//! Return the level of the geodesic grid used to order the objects.
+	int getLevel() const;
+	//! Return the number of objects.
+	int size() const;
+	const Entry& getEntry(int index) const {return entries()[index];}
+	//! Return the index of the first object of the zone, and set last to the index after its last object.
+	//! The objects of a zone are ordered by magnitude, brightest first.
+	int getZone(int zone, int& last) const;
+	//! Return the record of the object, to be read with Nebula::readDSO(). The data is not copied.
+	QByteArray getRecord(int index) const;
+	//! Return the index of the object with the given PGC number, or -1.
+	int searchPGC(unsigned int pgc) const;
+
+private:
+	struct Header
+	{
+		quint32 magic;
+		quint32 version;
+		//! MD5 sum of the name, size and modification date of the catalog
+		char signature[16];
+		qint32 level;
+		quint32 entryCount;
+		quint64 zonesOffset;
+		quint64 entriesOffset;
+		quint64 pgcOffset;
+		quint32 pgcCount;
+		quint64 dataOffset;
+		quint64 dataSize;
+	};
+
+	struct PgcEntry
+	{
+		quint32 pgc;
+		quint32 index;
+	};
+
+	static QByteArray computeSignature(const QString& catalogFile);
+	//! Read the catalog and write the compiled store to the device, which must be seekable
+	static bool compile(const QString& catalogFile, const QString& catalogVersion, const QByteArray& signature, QIODevice& out);
+	//! Check the header and set the section pointers
+	bool setData(const uchar* d, qint64 size, const QByteArray& signature);
+
+	const quint32* zones() const {return reinterpret_cast<const quint32*>(data + header->zonesOffset);}
+	const Entry* entries() const {return reinterpret_cast<const Entry*>(data + header->entriesOffset);}
+	const PgcEntry* pgcIndex() const {return reinterpret_cast<const PgcEntry*>(data + header->pgcOffset);}
+
+	QFile file;
+	uchar* mapped;
+	//! The store when it can't be written
+	QByteArray buffer;
+	const uchar* data;
+	const Header* header;
+	bool compiled;
+};
+
+#endif // NEBULASTORE_HPP
@@ -38,10 +38,10 @@
 NomenclatureMgr::NomenclatureMgr() : StelObjectModule()
 {
 	setObjectName("NomenclatureMgr");
+	ssystem = Q_NULLPTR;
 	conf = StelApp::getInstance().getSettings();
 	font.setPixelSize(StelApp::getInstance().getScreenFontSize());
 	connect(&StelApp::getInstance(), SIGNAL(screenFontSizeChanged(int)), this, SLOT(setFontSize(int)));
-	ssystem = GETSTELMODULE(SolarSystem);
 }
 
 NomenclatureMgr::~NomenclatureMgr()
@@ -60,6 +60,8 @@ void NomenclatureMgr::init()
 {
 	texPointer = StelApp::getInstance().getTextureManager().createTexture(StelFileMgr::getInstallationDir()+"/textures/pointeur2.png");
 
+	ssystem = GETSTELMODULE(SolarSystem);
+
 	// Load the nomenclature
 	NomenclatureItem::createNameLists();
 	loadNomenclature();
@@ -86,6 +88,17 @@ void NomenclatureMgr::updateNomenclatureData()
 	setFlagLabels(flag);
 }
 
+void NomenclatureMgr::loadModuleData()
+{
+	// Only read and decompress the file, the items are created by init() once the planets exist
+	QFile planetSurfNamesFile(StelFileMgr::findFile("data/nomenclature.dat"));
+	if (planetSurfNamesFile.open(QIODevice::ReadOnly))
+	{
+		nomenclatureData = StelUtils::uncompress(planetSurfNamesFile);
+		planetSurfNamesFile.close();
+	}
+}
+
 void NomenclatureMgr::loadNomenclature()
 {
 	qDebug() << "Loading nomenclature for Solar system bodies ...";
@@ -114,15 +127,21 @@ void NomenclatureMgr::loadNomenclature()
 	QString surfNamesFile = StelFileMgr::findFile("data/nomenclature.dat"); // compressed version of file nomenclature.fab
 	if (!surfNamesFile.isEmpty()) // OK, the file is exist!
 	{
-		// Open file
-		QFile planetSurfNamesFile(surfNamesFile);
-		if (!planetSurfNamesFile.open(QIODevice::ReadOnly))
+		// Use the file read in the background at startup if any
+		QByteArray data = nomenclatureData;
+		nomenclatureData.clear();
+		if (data.isEmpty())
 		{
-			qDebug() << "Cannot open file" << QDir::toNativeSeparators(surfNamesFile);
-			return;
+			// Open file
+			QFile planetSurfNamesFile(surfNamesFile);
+			if (!planetSurfNamesFile.open(QIODevice::ReadOnly))
+			{
+				qDebug() << "Cannot open file" << QDir::toNativeSeparators(surfNamesFile);
+				return;
+			}
+			data = StelUtils::uncompress(planetSurfNamesFile);
+			planetSurfNamesFile.close();
 		}
-		QByteArray data = StelUtils::uncompress(planetSurfNamesFile);
-		planetSurfNamesFile.close();
 		//check if decompressing was successful
 		if(data.isEmpty())
 		{
@@ -56,6 +56,8 @@ public:
 	///////////////////////////////////////////////////////////////////////////
 	// Methods defined in the StelModule class
 	virtual void init();
+	//! Read the nomenclature file in the background at startup.
+	virtual void loadModuleData();
 	virtual void deinit();
 	virtual void update(double) {;}
 	virtual void draw(StelCore* core);
@@ -140,6 +142,9 @@ private:
 	//! Load nomenclature for solar system bodies
 	void loadNomenclature();
 
+	//! The uncompressed nomenclature file read by loadModuleData(), until it is used by loadNomenclature()
+	QByteArray nomenclatureData;
+
 	// Font used for displaying our text
 	QFont font;
 	QSettings* conf;
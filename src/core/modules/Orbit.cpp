@@ -276,6 +276,24 @@ void CometOrbit::positionAtTimevInVSOP87Coordinates(double JDE, double *v, bool
 }
 
 
+bool CometOrbit::sampleOrbit(const int nSamples, Vec3d* samples) const
+{
+	if (e >= 1.0)
+		return false;
+
+	const double a = q/(1.0-e);
+	const double h1 = q*std::sqrt((1.0+e)/(1.0-e));
+	for (int k=0; k<nSamples; ++k)
+	{
+		const double E = 2.0*M_PI*k/nSamples;
+		double p0,p1,p2, s0, s1, s2;
+		Init3D(i,Om,w,a*(cos(E)-e),h1*sin(E),p0,p1,p2, s0, s1, s2);
+		samples[k].set(rotateToVsop87[0]*p0 + rotateToVsop87[1]*p1 + rotateToVsop87[2]*p2,
+			       rotateToVsop87[3]*p0 + rotateToVsop87[4]*p1 + rotateToVsop87[5]*p2,
+			       rotateToVsop87[6]*p0 + rotateToVsop87[7]*p1 + rotateToVsop87[8]*p2);
+	}
+	return true;
+}
 
 EllipticalOrbit::EllipticalOrbit(double pericenterDistance,
                                  double eccentricity,
@@ -504,6 +522,21 @@ double EllipticalOrbit::getPeriod() const
 	return period;
 }
 
+bool EllipticalOrbit::sampleOrbit(const int nSamples, Vec3d* samples) const
+{
+	if (eccentricity >= 1.0)
+		return false;
+
+	for (int k=0; k<nSamples; ++k)
+	{
+		const Vec3d pos = positionAtE(2.0*M_PI*k/nSamples);
+		samples[k].set(rotateToVsop87[0]*pos[0] + rotateToVsop87[1]*pos[1] + rotateToVsop87[2]*pos[2],
+			       rotateToVsop87[3]*pos[0] + rotateToVsop87[4]*pos[1] + rotateToVsop87[5]*pos[2],
+			       rotateToVsop87[6]*pos[0] + rotateToVsop87[7]*pos[1] + rotateToVsop87[8]*pos[2]);
+	}
+	return true;
+}
+
 /* Found undocumented and unused in pre-0.17.
 // return apocenter distance
 double EllipticalOrbit::getBoundingRadius() const
@@ -24,6 +24,10 @@ class Orbit
 public:
     Orbit(void) {}
     virtual ~Orbit(void) {}
+    //! Sample the shape of a closed orbit with nSamples points, given in the same frame as the positions of the orbiting body.
+    //! The shape of a Keplerian orbit does not change with time, so the result can be cached for drawing.
+    //! @return false for open (parabolic or hyperbolic) orbits, which cannot be sampled this way.
+    virtual bool sampleOrbit(const int nSamples, Vec3d* samples) const { (void)nSamples; (void)samples; return false; }
 private:
     Orbit(const Orbit&);
     const Orbit &operator=(const Orbit&);
@@ -56,6 +60,8 @@ public:
 	// Original one
 	Vec3d positionAtTime(const double JDE) const;
 	double getPeriod() const;
+	//! Sample the orbit uniformly in eccentric anomaly.
+	virtual bool sampleOrbit(const int nSamples, Vec3d* samples) const;
 	// double getBoundingRadius() const; // Return apoapsis distance. UNUSED!
 	// virtual void sample(double, double, int, OrbitSampleProc&) const; //UNDOCUMENTED & UNUSED
 
@@ -102,6 +108,8 @@ public:
 	double getSemimajorAxis() const { return (e==1. ? 0. : q / (1.-e)); }
 	double getEccentricity() const { return e; }
 	bool objectDateValid(const double JDE) const { return (fabs(t0-JDE)<orbitGood); }
+	//! Sample elliptical comet orbits uniformly in eccentric anomaly.
+	virtual bool sampleOrbit(const int nSamples, Vec3d* samples) const;
 
 private:
 	const double q;  //! perihel distance
@@ -51,6 +51,7 @@
 #include <QString>
 #include <QDebug>
 #include <QVarLengthArray>
+#include <QHash>
 #include <QOpenGLBuffer>
 #include <QOpenGLContext>
 #ifdef DEBUG_SHADOWMAP
@@ -88,6 +89,8 @@ StelTextureSP Planet::hintCircleTex;
 StelTextureSP Planet::texEarthShadow;
 
 bool Planet::permanentDrawingOrbits = false;
+QVector<float> Planet::orbitBatchVertices;
+QVector<unsigned char> Planet::orbitBatchColors;
 Planet::PlanetOrbitColorStyle Planet::orbitColorStyle = Planet::ocsOneColor;
 
 bool Planet::flagCustomGrsSettings = false;
@@ -191,6 +194,9 @@ Planet::Planet(const QString& englishName,
 	  flagTranslatedName(true),
 	  deltaJDE(StelCore::JD_SECOND),
 	  deltaOrbitJDE(0.0),
+	  orbitSampled(false),
+	  orbitWindowValid(false),
+	  orbitWindow(0),
 	  closeOrbit(acloseOrbit),
 	  englishName(englishName),
 	  nameI18(englishName),
@@ -213,6 +219,9 @@ Planet::Planet(const QString& englishName,
 	  objModelLoader(Q_NULLPTR),
 	  survey(Q_NULLPTR),
 	  rings(Q_NULLPTR),
+	  sphereModelFacets(0),
+	  sphereVertexRadius(0.f),
+	  sphereVertexOneMinusOblateness(0.f),
 	  distance(0.0),
 	  sphereScale(1.),
 	  lastJDE(J2000),
@@ -837,6 +846,7 @@ void Planet::setRotationElements(float _period, float _offset, double _epoch, fl
 	re.siderealPeriod = _siderealPeriod;  // used for drawing orbit lines
 
 	deltaOrbitJDE = re.siderealPeriod/ORBIT_SEGMENTS;
+	orbitWindowValid = false;
 }
 
 Vec3d Planet::getJ2000EquatorialPos(const StelCore *core) const
@@ -1641,6 +1651,10 @@ void Planet::draw(StelCore* core, float maxMagLabels, const QFont& planetNameFon
 		{
 			labelsFader=false;
 		}
+		// Orbits are drawn in batches. Flush before drawing the label, the hint or the disk
+		// so that they cover the orbit lines drawn so far, as when each orbit was drawn at once.
+		if (labelsFader.getInterstate()>0.f || screenSz>1.f)
+			drawOrbitBatch(core);
 		drawHints(core, planetNameFont);
 
 		draw3dModel(core,transfo,screenSz);
@@ -2335,6 +2349,31 @@ void sSphere(Planet3DModel* model, const float radius, const float oneMinusOblat
 	}
 }
 
+// Unit spheroids, shared by all bodies drawn with the same facet count and oblateness.
+// As for textures, only weak references are kept: a model is released when no body uses it anymore.
+static QHash<QPair<unsigned short int, float>, QWeakPointer<Planet3DModel> > sphereModelCache;
+
+static QSharedPointer<Planet3DModel> getSphereModel(const unsigned short int facets, const float oneMinusOblateness)
+{
+	const QPair<unsigned short int, float> key(facets, oneMinusOblateness);
+	QSharedPointer<Planet3DModel> model = sphereModelCache.value(key).toStrongRef();
+	if (!model)
+	{
+		// Forget the models which are not used anymore, so that the cache does not grow with every facet count ever drawn.
+		for (auto it = sphereModelCache.begin(); it != sphereModelCache.end(); )
+		{
+			if (it.value().isNull())
+				it = sphereModelCache.erase(it);
+			else
+				++it;
+		}
+		model = QSharedPointer<Planet3DModel>(new Planet3DModel());
+		sSphere(model.data(), 1.f, oneMinusOblateness, facets, facets);
+		sphereModelCache.insert(key, model);
+	}
+	return model;
+}
+
 struct Ring3DModel
 {
 	QVector<float> vertexArr;
@@ -2485,17 +2524,30 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 	// Adapt the number of facets according with the size of the sphere for optimization
 	const unsigned short int nb_facet = static_cast<unsigned short int>(qBound(10u, static_cast<uint>(screenSz * 40.f/50.f), 100u));	// 40 facets for 1024 pixels diameter on screen
 
-	// Generates the vertice
-	Planet3DModel model;
-	sSphere(&model, static_cast<float>(equatorialRadius), static_cast<float>(oneMinusOblateness), nb_facet, nb_facet);
-	
-	QVector<float> projectedVertexArr(model.vertexArr.size());
+	// Get the vertices. They only need to be regenerated when the facet count or the shape of the body changes.
+	const float radius = static_cast<float>(equatorialRadius);
+	const float oneMinusOblatenessF = static_cast<float>(oneMinusOblateness);
+	if (!sphereModel || sphereModelFacets!=nb_facet || sphereVertexRadius!=radius || sphereVertexOneMinusOblateness!=oneMinusOblatenessF)
+	{
+		sphereModel = getSphereModel(nb_facet, oneMinusOblatenessF);
+		sphereModelFacets = nb_facet;
+		sphereVertexRadius = radius;
+		sphereVertexOneMinusOblateness = oneMinusOblatenessF;
+		sphereVertexArr = sphereModel->vertexArr;
+		for (auto& v : sphereVertexArr)
+			v *= radius;
+	}
+	const Planet3DModel& model = *sphereModel;
+
+	// The projection buffer keeps its allocation across frames.
+	projectedVertexArr.resize(sphereVertexArr.size());
 	const float sphereScaleF=static_cast<float>(sphereScale);
-	for (int i=0;i<model.vertexArr.size()/3;++i)
+	const StelProjectorP& prj = painter->getProjector();
+	for (int i=0;i<sphereVertexArr.size()/3;++i)
 	{
-		Vec3f p = *(reinterpret_cast<const Vec3f*>(model.vertexArr.constData()+i*3));
+		Vec3f p = *(reinterpret_cast<const Vec3f*>(sphereVertexArr.constData()+i*3));
 		p *= sphereScaleF;
-		painter->getProjector()->project(p, *(reinterpret_cast<Vec3f*>(projectedVertexArr.data()+i*3)));
+		prj->project(p, *(reinterpret_cast<Vec3f*>(projectedVertexArr.data()+i*3)));
 	}
 	
 	const SolarSystem* ssm = GETSTELMODULE(SolarSystem);
@@ -2586,7 +2638,7 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 
 	GL(shader->setAttributeArray(shaderVars->vertex, static_cast<const GLfloat*>(projectedVertexArr.constData()), 3));
 	GL(shader->enableAttributeArray(shaderVars->vertex));
-	GL(shader->setAttributeArray(shaderVars->unprojectedVertex, static_cast<const GLfloat*>(model.vertexArr.constData()), 3));
+	GL(shader->setAttributeArray(shaderVars->unprojectedVertex, static_cast<const GLfloat*>(sphereVertexArr.constData()), 3));
 	GL(shader->enableAttributeArray(shaderVars->unprojectedVertex));
 	GL(shader->setAttributeArray(shaderVars->texCoord, static_cast<const GLfloat*>(model.texCoordArr.constData()), 2));
 	GL(shader->enableAttributeArray(shaderVars->texCoord));
@@ -2609,8 +2661,12 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 		// Normal transparency mode
 		painter->setBlending(true);
 
-		Ring3DModel ringModel;
-		sRing(&ringModel, rings->radiusMin, rings->radiusMax, 128, 32);
+		if (!rings->model)
+		{
+			rings->model = QSharedPointer<Ring3DModel>(new Ring3DModel());
+			sRing(rings->model.data(), rings->radiusMin, rings->radiusMax, 128, 32);
+		}
+		const Ring3DModel& ringModel = *rings->model;
 		
 		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.isRing, true));
 		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.tex, 2));
@@ -2627,7 +2683,7 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 		
 		projectedVertexArr.resize(ringModel.vertexArr.size());
 		for (int i=0;i<ringModel.vertexArr.size()/3;++i)
-			painter->getProjector()->project(*(reinterpret_cast<const Vec3f*>(ringModel.vertexArr.constData()+i*3)), *(reinterpret_cast<Vec3f*>(projectedVertexArr.data()+i*3)));
+			prj->project(*(reinterpret_cast<const Vec3f*>(ringModel.vertexArr.constData()+i*3)), *(reinterpret_cast<Vec3f*>(projectedVertexArr.data()+i*3)));
 		
 		GL(ringPlanetShaderProgram->setAttributeArray(ringPlanetShaderVars.vertex, reinterpret_cast<const GLfloat*>(projectedVertexArr.constData()), 3));
 		GL(ringPlanetShaderProgram->enableAttributeArray(ringPlanetShaderVars.vertex));
@@ -3176,25 +3232,31 @@ Vec3f Planet::getCurrentOrbitColor() const
 
 void Planet::computeOrbit()
 {
-	double dateJDE = lastJDE;
-	double calc_date;
-	Vec3d parentPos;
-	if (parent)
-		parentPos = parent->getHeliocentricEclipticPos(dateJDE);
+	// The shape of a Keplerian orbit does not change: sample it only once.
+	if (orbitSampled)
+		return;
+	if (orbitPtr && closeOrbit)
+	{
+		orbitSampled = static_cast<Orbit*>(orbitPtr)->sampleOrbit(ORBIT_SEGMENTS, orbit);
+		if (orbitSampled)
+			return;
+	}
+
+	// Otherwise sample the positions around the current date. The dates are rounded to a number
+	// of deltaOrbitJDE, so the samples need an update only when this time window moves.
+	const qint64 window = qRound64(lastJDE/deltaOrbitJDE) - ORBIT_SEGMENTS/2;
+	if (orbitWindowValid && window==orbitWindow)
+		return;
 
 	for(int d = 0; d < ORBIT_SEGMENTS; d++)
 	{
-		calc_date = dateJDE + (d-ORBIT_SEGMENTS/2)*deltaOrbitJDE;
-		// Round to a number of deltaOrbitJDE to improve caching.
-		if (d != ORBIT_SEGMENTS / 2)
-		{
-			calc_date = nearbyint(calc_date / deltaOrbitJDE) * deltaOrbitJDE;
-		}
-		orbit[d] = getEclipticPos(calc_date) + parentPos;
+		orbit[d] = getEclipticPos((window+d)*deltaOrbitJDE);
 	}
+	orbitWindow = window;
+	orbitWindowValid = true;
 }
 
-// draw orbital path of Planet
+// add orbital path of Planet to the orbit batch
 void Planet::drawOrbit(const StelCore* core)
 {
 	if (!static_cast<bool>(orbitFader.getInterstate()))
@@ -3206,45 +3268,73 @@ void Planet::drawOrbit(const StelCore* core)
 	computeOrbit();
 
 	const StelProjectorP prj = core->getProjection(StelCore::FrameHeliocentricEclipticJ2000);
+	const Vec3d parentPos = parent ? parent->getHeliocentricEclipticPos() : Vec3d(0.);
 
-	StelPainter sPainter(prj);
-
-	// Normal transparency mode
-	sPainter.setBlending(true);
-
-	sPainter.setColor(getCurrentOrbitColor(), orbitFader.getInterstate());
-	Vec3d onscreen;
-	// special case - use current Planet position as center vertex so that draws
+	// special case - use current Planet position instead of the closest vertex so that draws
 	// on its orbit all the time (since segmented rather than smooth curve)
-	Vec3d savePos = orbit[ORBIT_SEGMENTS/2];
-	orbit[ORBIT_SEGMENTS/2]=getHeliocentricEclipticPos();
-	orbit[ORBIT_SEGMENTS]=orbit[0];
-	int nbIter = closeOrbit ? ORBIT_SEGMENTS : ORBIT_SEGMENTS-1;
-	QVarLengthArray<float, 1024> vertexArray;
+	int current = ORBIT_SEGMENTS/2;
+	if (orbitSampled)
+	{
+		double minDistSq = std::numeric_limits<double>::max();
+		for (int n=0; n<ORBIT_SEGMENTS; ++n)
+		{
+			const double distSq = (orbit[n]-eclipticPos).lengthSquared();
+			if (distSq<minDistSq)
+			{
+				minDistSq = distSq;
+				current = n;
+			}
+		}
+	}
 
-	sPainter.enableClientStates(true, false, false);
+	const Vec3f color = getCurrentOrbitColor();
+	const unsigned char rgba[4] = {
+		static_cast<unsigned char>(qBound(0.f, color[0], 1.f)*255.f),
+		static_cast<unsigned char>(qBound(0.f, color[1], 1.f)*255.f),
+		static_cast<unsigned char>(qBound(0.f, color[2], 1.f)*255.f),
+		static_cast<unsigned char>(qBound(0.f, orbitFader.getInterstate(), 1.f)*255.f) };
 
+	// The batch is drawn as independent line segments, so that the orbits of all bodies can go in one draw call.
+	const int nbIter = closeOrbit ? ORBIT_SEGMENTS : ORBIT_SEGMENTS-1;
+	Vec3d pos, prevPos, onscreen, prevOnscreen;
+	bool prevVisible = false;
 	for (int n=0; n<=nbIter; ++n)
 	{
-		if (prj->project(orbit[n],onscreen) && (vertexArray.size()==0 || !prj->intersectViewportDiscontinuity(orbit[n-1], orbit[n])))
-		{
-			vertexArray.append(static_cast<float>(onscreen[0]));
-			vertexArray.append(static_cast<float>(onscreen[1]));
-		}
-		else if (!vertexArray.isEmpty())
+		const int i = n % ORBIT_SEGMENTS;
+		pos = (i==current ? getHeliocentricEclipticPos() : orbit[i]+parentPos);
+		const bool visible = prj->project(pos, onscreen);
+		if (visible && prevVisible && !prj->intersectViewportDiscontinuity(prevPos, pos))
 		{
-			sPainter.setVertexPointer(2, GL_FLOAT, vertexArray.constData());
-			sPainter.drawFromArray(StelPainter::LineStrip, vertexArray.size()/2, 0, false);
-			vertexArray.clear();
+			orbitBatchVertices << static_cast<float>(prevOnscreen[0]) << static_cast<float>(prevOnscreen[1])
+					   << static_cast<float>(onscreen[0]) << static_cast<float>(onscreen[1]);
+			for (int c=0; c<8; ++c)
+				orbitBatchColors.append(rgba[c%4]);
 		}
+		prevVisible = visible;
+		prevPos = pos;
+		prevOnscreen = onscreen;
 	}
-	orbit[ORBIT_SEGMENTS/2]=savePos;
-	if (!vertexArray.isEmpty())
-	{
-		sPainter.setVertexPointer(2, GL_FLOAT, vertexArray.constData());
-		sPainter.drawFromArray(StelPainter::LineStrip, vertexArray.size()/2, 0, false);
-	}
+}
+
+void Planet::drawOrbitBatch(const StelCore* core)
+{
+	if (orbitBatchVertices.isEmpty())
+		return;
+
+	StelPainter sPainter(core->getProjection(StelCore::FrameHeliocentricEclipticJ2000));
+
+	// Normal transparency mode
+	sPainter.setBlending(true);
+
+	sPainter.enableClientStates(true, false, true);
+	sPainter.setVertexPointer(2, GL_FLOAT, orbitBatchVertices.constData());
+	sPainter.setColorPointer(4, GL_UNSIGNED_BYTE, orbitBatchColors.constData());
+	sPainter.drawFromArray(StelPainter::Lines, orbitBatchVertices.size()/2, 0, false);
 	sPainter.enableClientStates(false);
+
+	// Keep the allocated memory for the next frame.
+	orbitBatchVertices.resize(0);
+	orbitBatchColors.resize(0);
 }
 
 void Planet::update(int deltaTime)
@@ -30,6 +30,7 @@
 
 #include <QCache>
 #include <QString>
+#include <QVector>
 
 // The callback type for the external position computation function
 // arguments are JDE, position[3], velocity[3].
@@ -73,6 +74,9 @@ public:
 	double siderealPeriod;		// sidereal period (Planet year or a moon's sidereal month) [earth days]
 };
 
+struct Planet3DModel;
+struct Ring3DModel;
+
 // Class to manage rings for planets like saturn
 class Ring
 {
@@ -82,6 +86,7 @@ public:
 	const float radiusMin;
 	const float radiusMax;
 	StelTextureSP tex;
+	QSharedPointer<Ring3DModel> model; // Tessellated ring, created on first draw and then kept.
 };
 
 
@@ -356,11 +361,16 @@ public:
 	void setFlagOrbits(bool b){orbitFader = b;}
 	bool getFlagOrbits(void) const {return orbitFader;}
 	LinearFader orbitFader;
-	// draw orbital path of Planet
+	// add orbital path of Planet to the orbit batch
 	void drawOrbit(const StelCore*);
-	Vec3d orbit[ORBIT_SEGMENTS+1];  // store heliocentric coordinates for drawing the orbit
+	//! Draw all orbit lines collected by drawOrbit() since the last call in a single batch.
+	static void drawOrbitBatch(const StelCore* core);
+	Vec3d orbit[ORBIT_SEGMENTS];    // store orbit coordinates relative to the parent for drawing the orbit
 	double deltaJDE;                // time difference between positional updates.
 	double deltaOrbitJDE;
+	bool orbitSampled;              // orbit holds the fixed shape of a Keplerian orbit, which never needs an update
+	bool orbitWindowValid;          // orbit holds the samples of the time window starting at orbitWindow
+	qint64 orbitWindow;             // first sample date of the orbit, in units of deltaOrbitJDE
 	bool closeOrbit;                // whether to connect the beginning of the orbit line to
 					// the end: good for elliptical orbits, bad for parabolic
 					// and hyperbolic orbits
@@ -558,6 +568,12 @@ protected:
 	HipsSurveyP survey;
 
 	Ring* rings;                     // Planet rings
+	QSharedPointer<Planet3DModel> sphereModel; // Unit spheroid used in drawSphere(), shared with all bodies of the same facet count and oblateness.
+	unsigned short int sphereModelFacets;      // Facet count of sphereModel
+	float sphereVertexRadius;             // equatorialRadius used for sphereVertexArr
+	float sphereVertexOneMinusOblateness; // oneMinusOblateness used for sphereModel and sphereVertexArr
+	QVector<float> sphereVertexArr;  // Vertices of sphereModel scaled to equatorialRadius. Only recomputed when the facet count, radius or oblateness changes.
+	QVector<float> projectedVertexArr; // Projection buffer of drawSphere(), reused across frames.
 	double distance;                 // Temporary variable used to store the distance to a given point
 	// it is used for sorting while drawing
 	double sphereScale;              // Artificial scaling for better viewing.
@@ -589,6 +605,9 @@ protected:
 	static QMap<ApparentMagnitudeAlgorithm, QString> vMagAlgorithmMap;
 	//! If true, planet orbits will be drawn even if planet is off screen.
 	static bool permanentDrawingOrbits;
+	//! Projected vertices and colors of the orbit lines waiting for drawOrbitBatch().
+	static QVector<float> orbitBatchVertices;
+	static QVector<unsigned char> orbitBatchColors;
 
 	static bool flagCustomGrsSettings;	// Is enabled usage of custom settings for calculation of position of Great Red Spot?
 	static double customGrsJD;		// Initial JD for calculation of position of Great Red Spot
@@ -0,0 +1,592 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "SkyCultureBundle.hpp"
+#include "StelFileMgr.hpp"
+#include "StelUtils.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutex>
+#include <QRegExp>
+#include <QSaveFile>
+#include <QTextStream>
+
+static const quint32 BUNDLE_MAGIC = 0x53434231; // "SCB1"
+// Increase this whenever the layout of the cache file changes.
+static const quint32 BUNDLE_VERSION = 2;
+
+// Lines which start with a # or are empty are ignored in all sky culture files.
+static inline bool isComment(const QString& record)
+{
+	const QString trimmed = record.trimmed();
+	return trimmed.isEmpty() || trimmed.startsWith('#');
+}
+
+// ConstellationMgr and AsterismMgr both load the bundle of a new sky culture, possibly at the same time.
+// The last bundle is kept so that it is only compiled or read once.
+static QMutex lastBundleMutex;
+static SkyCultureBundle lastBundle;
+static QStringList lastBundleSources;
+static QVector<qint64> lastBundleStamps;
+static QString cacheDirectory;
+
+void SkyCultureBundle::setCacheDir(const QString& dir)
+{
+	QMutexLocker locker(&lastBundleMutex);
+	cacheDirectory = dir;
+	lastBundle = SkyCultureBundle();
+	lastBundleSources.clear();
+	lastBundleStamps.clear();
+}
+
+SkyCultureBundle SkyCultureBundle::load(const QString& skyCultureDir, int boundariesIdx, bool useCache)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	SkyCultureBundle bundle;
+	bundle.skyCultureDir = skyCultureDir;
+	bundle.boundariesIdx = boundariesIdx;
+
+	const QStringList sourceFiles = findSourceFiles(skyCultureDir, boundariesIdx);
+	QMutexLocker locker(useCache ? &lastBundleMutex : Q_NULLPTR);
+	if (useCache && lastBundleSources==sourceFiles && lastBundleStamps==sourceStamps(sourceFiles + lastBundle.artFiles()))
+		return lastBundle;
+
+	const QString cacheFile = cacheFileName(skyCultureDir);
+	if (useCache && bundle.readCache(cacheFile, sourceFiles))
+	{
+		qDebug() << "Loaded cached sky culture bundle" << skyCultureDir << "in" << timer.elapsed() << "ms";
+		lastBundle = bundle;
+		lastBundleSources = sourceFiles;
+		lastBundleStamps = sourceStamps(sourceFiles + bundle.artFiles());
+		return bundle;
+	}
+
+	if (sourceFiles.at(0).isEmpty())
+		qWarning() << "ERROR: no constellationship.fab file found for sky culture" << skyCultureDir;
+	else
+		bundle.constellationLines = readLines(sourceFiles.at(0), false);
+
+	// It's possible to have no art - just constellations
+	if (sourceFiles.at(1).isEmpty())
+		qDebug() << "No constellationsart.fab file found for sky culture dir" << QDir::toNativeSeparators(skyCultureDir);
+	else
+		bundle.constellationArt = readArt(sourceFiles.at(1), skyCultureDir);
+
+	if (sourceFiles.at(2).isEmpty())
+		qWarning() << "ERROR: no constellation_names.eng.fab file found for sky culture" << skyCultureDir;
+	else
+		bundle.constellationNames = readNames(sourceFiles.at(2), false);
+
+	bundle.hasSeasonalRules = !sourceFiles.at(3).isEmpty();
+	if (bundle.hasSeasonalRules)
+		bundle.seasonalRules = readSeasonalRules(sourceFiles.at(3));
+
+	if (boundariesIdx>=0)
+	{
+		if (sourceFiles.at(4).isEmpty())
+			qWarning() << "ERROR: no constellation boundaries file found for sky culture" << skyCultureDir;
+		else
+			bundle.boundaries = readBoundaries(sourceFiles.at(4));
+	}
+
+	bundle.hasAsterisms = !sourceFiles.at(5).isEmpty();
+	if (bundle.hasAsterisms)
+		bundle.asterismLines = readLines(sourceFiles.at(5), true);
+	else
+		qWarning() << "No asterisms for skyculture" << skyCultureDir;
+
+	if (!sourceFiles.at(6).isEmpty())
+		bundle.asterismNames = readNames(sourceFiles.at(6), true);
+
+	if (useCache)
+	{
+		bundle.writeCache(cacheFile, sourceFiles);
+		lastBundle = bundle;
+		lastBundleSources = sourceFiles;
+		lastBundleStamps = sourceStamps(sourceFiles + bundle.artFiles());
+	}
+
+	qDebug() << "Compiled sky culture bundle" << skyCultureDir << "in" << timer.elapsed() << "ms";
+	return bundle;
+}
+
+QStringList SkyCultureBundle::findSourceFiles(const QString& skyCultureDir, int boundariesIdx)
+{
+	const QString path = "skycultures/" + skyCultureDir + "/";
+	QStringList files;
+	files << StelFileMgr::findFile(path + "constellationship.fab")
+	      << StelFileMgr::findFile(path + "constellationsart.fab")
+	      << StelFileMgr::findFile(path + "constellation_names.eng.fab")
+	      << StelFileMgr::findFile(path + "seasonal_rules.fab");
+
+	QString boundaryFile;
+	if (boundariesIdx==1)
+	{
+		// boundaries = own
+		boundaryFile = StelFileMgr::findFile(path + "constellation_boundaries.dat");
+		if (boundaryFile.isEmpty()) // Check old file name (backward compatibility)
+			boundaryFile = StelFileMgr::findFile(path + "constellations_boundaries.dat");
+	}
+	else if (boundariesIdx==0)
+	{
+		// boundaries = generic
+		boundaryFile = StelFileMgr::findFile("data/constellation_boundaries.dat");
+	}
+	files << boundaryFile
+	      << StelFileMgr::findFile(path + "asterism_lines.fab")
+	      << StelFileMgr::findFile(path + "asterism_names.eng.fab");
+	return files;
+}
+
+QVector<qint64> SkyCultureBundle::sourceStamps(const QStringList& sourceFiles)
+{
+	QVector<qint64> stamps;
+	stamps.reserve(sourceFiles.size()*2);
+	for (const auto& file : sourceFiles)
+	{
+		QFileInfo info(file);
+		if (file.isEmpty() || !info.exists())
+			stamps << 0 << 0;
+		else
+			stamps << info.size() << info.lastModified().toMSecsSinceEpoch();
+	}
+	return stamps;
+}
+
+QString SkyCultureBundle::cacheFileName(const QString& skyCultureDir)
+{
+	const QString dir = cacheDirectory.isEmpty() ? StelFileMgr::getCacheDir() + "/skycultures" : cacheDirectory;
+	return dir + "/" + skyCultureDir + ".bundle";
+}
+
+QStringList SkyCultureBundle::artFiles() const
+{
+	QStringList files;
+	for (const auto& art : constellationArt)
+	{
+		if (!art.texturePath.isEmpty())
+			files << art.texturePath;
+	}
+	return files;
+}
+
+bool SkyCultureBundle::readCache(const QString& fileName, const QStringList& sourceFiles)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_5_2);
+	quint32 magic, version;
+	qint32 cachedBoundariesIdx;
+	QStringList cachedSourceFiles;
+	QVector<qint64> cachedStamps;
+	in >> magic >> version;
+	if (magic!=BUNDLE_MAGIC || version!=BUNDLE_VERSION)
+		return false;
+	in >> cachedBoundariesIdx >> cachedSourceFiles >> cachedStamps;
+	if (in.status()!=QDataStream::Ok || cachedBoundariesIdx!=boundariesIdx
+	    || cachedSourceFiles!=sourceFiles || cachedStamps!=sourceStamps(sourceFiles))
+		return false;
+
+	QVector<qint64> cachedArtStamps;
+	in >> constellationLines >> constellationArt >> constellationNames
+	   >> hasSeasonalRules >> seasonalRules >> boundaries
+	   >> hasAsterisms >> asterismLines >> asterismNames >> cachedArtStamps;
+	const bool corrupted = in.status()!=QDataStream::Ok;
+	// The texture sizes are only valid as long as the art images are unchanged.
+	if (corrupted || cachedArtStamps!=sourceStamps(artFiles()))
+	{
+		if (corrupted)
+			qWarning() << "Corrupted sky culture bundle" << QDir::toNativeSeparators(fileName) << "- it will be rebuilt";
+		SkyCultureBundle empty;
+		empty.skyCultureDir = skyCultureDir;
+		empty.boundariesIdx = boundariesIdx;
+		*this = empty;
+		return false;
+	}
+	return true;
+}
+
+void SkyCultureBundle::writeCache(const QString& fileName, const QStringList& sourceFiles) const
+{
+	if (!QDir().mkpath(QFileInfo(fileName).absolutePath()))
+	{
+		qWarning() << "Cannot create the directory for the sky culture bundle" << QDir::toNativeSeparators(fileName);
+		return;
+	}
+
+	// QSaveFile makes sure that a reader in another thread never sees a half-written bundle.
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning() << "Cannot write the sky culture bundle" << QDir::toNativeSeparators(fileName);
+		return;
+	}
+
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_5_2);
+	out << BUNDLE_MAGIC << BUNDLE_VERSION
+	    << static_cast<qint32>(boundariesIdx) << sourceFiles << sourceStamps(sourceFiles)
+	    << constellationLines << constellationArt << constellationNames
+	    << hasSeasonalRules << seasonalRules << boundaries
+	    << hasAsterisms << asterismLines << asterismNames << sourceStamps(artFiles());
+	if (out.status()!=QDataStream::Ok || !file.commit())
+		qWarning() << "Cannot write the sky culture bundle" << QDir::toNativeSeparators(fileName);
+}
+
+QVector<SkyCultureBundle::Lines> SkyCultureBundle::readLines(const QString& fileName, bool asterisms)
+{
+	QVector<Lines> result;
+	QFile in(fileName);
+	if (!in.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning() << "Can't open lines data file" << QDir::toNativeSeparators(fileName);
+		return result;
+	}
+
+	int currentLineNumber = 0;	// line in file
+	int totalRecords = 0;
+	while (!in.atEnd())
+	{
+		QString record = QString::fromUtf8(in.readLine());
+		currentLineNumber++;
+		if (isComment(record))
+			continue;
+		totalRecords++;
+
+		Lines lines;
+		lines.type = 1;
+		unsigned int numberOfSegments = 0;
+		QTextStream istr(&record, QIODevice::ReadOnly);
+		istr >> lines.abbreviation;
+		if (asterisms)
+			istr >> lines.type;
+		istr >> numberOfSegments;
+		bool ok = (istr.status()==QTextStream::Ok);
+
+		lines.points.reserve(static_cast<int>(numberOfSegments)*(lines.type==2 ? 4 : 2));
+		for (unsigned int i=0; ok && i<numberOfSegments*2; ++i)
+		{
+			if (lines.type==2)
+			{
+				// A small asterism with lines by J2000.0 coordinates
+				double RA = 0., DE = 0.;
+				istr >> RA >> DE;
+				ok = (istr.status()==QTextStream::Ok);
+				lines.points << RA << DE;
+			}
+			else
+			{
+				unsigned int HP = 0;
+				istr >> HP;
+				ok = (HP!=0);
+				lines.points << HP;
+			}
+		}
+
+		if (ok)
+			result << lines;
+		else
+			qWarning() << "ERROR reading lines record at line" << currentLineNumber << "in" << QDir::toNativeSeparators(fileName);
+	}
+	qDebug() << "Compiled" << result.size() << "/" << totalRecords << "lines records from" << QDir::toNativeSeparators(fileName);
+	return result;
+}
+
+QVector<SkyCultureBundle::Art> SkyCultureBundle::readArt(const QString& fileName, const QString& skyCultureDir)
+{
+	QVector<Art> result;
+	QFile fic(fileName);
+	if (!fic.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning() << "Can't open constellation art file" << QDir::toNativeSeparators(fileName) << "for culture" << skyCultureDir;
+		return result;
+	}
+
+	// Read the constellation art file with the following format :
+	// ShortName texture_file x1 y1 hp1 x2 y2 hp2 x3 y3 hp3
+	// Where :
+	// shortname is the international short name (i.e "Lep" for Lepus)
+	// texture_file is the graphic file of the art texture
+	// x1 y1 are the x and y texture coordinates in pixels of the star of hipparcos number hp1
+	// x2 y2 are the x and y texture coordinates in pixels of the star of hipparcos number hp2
+	// The coordinate are taken with (0,0) at the top left corner of the image file
+	int currentLineNumber = 0;	// line in file
+	int totalRecords = 0;
+	while (!fic.atEnd())
+	{
+		QString record = QString::fromUtf8(fic.readLine());
+		++currentLineNumber;
+		if (isComment(record))
+			continue;
+		totalRecords++;
+
+		// prevent leaving zeros on numbers from being interpretted as octal numbers
+		record.replace(" 0", " ");
+		QTextStream rStr(&record);
+		Art art;
+		QString texfile;
+		rStr >> art.abbreviation >> texfile >> art.x1 >> art.y1 >> art.hp1 >> art.x2 >> art.y2 >> art.hp2 >> art.x3 >> art.y3 >> art.hp3;
+		if (rStr.status()!=QTextStream::Ok)
+		{
+			qWarning() << "ERROR parsing constellation art record at line" << currentLineNumber << "of art file for culture" << skyCultureDir;
+			continue;
+		}
+
+		art.texturePath = StelFileMgr::findFile("skycultures/"+skyCultureDir+"/"+texfile);
+		// Only the image header is read here. The texture itself is decoded by the texture manager.
+		const QSize size = art.texturePath.isEmpty() ? QSize() : QImageReader(art.texturePath).size();
+		art.textureWidth = size.isValid() ? size.width() : 0;
+		art.textureHeight = size.isValid() ? size.height() : 0;
+		if (art.texturePath.isEmpty())
+			qWarning() << "ERROR: could not find texture, " << QDir::toNativeSeparators(texfile);
+		else if (!size.isValid())
+			qWarning() << "Texture dimension not available for" << QDir::toNativeSeparators(art.texturePath);
+		result << art;
+	}
+	qDebug() << "Compiled" << result.size() << "/" << totalRecords << "constellation art records for culture" << skyCultureDir;
+	return result;
+}
+
+QVector<SkyCultureBundle::Name> SkyCultureBundle::readNames(const QString& fileName, bool asterisms)
+{
+	QVector<Name> result;
+	QFile commonNameFile(fileName);
+	if (!commonNameFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qDebug() << "Cannot open file" << QDir::toNativeSeparators(fileName);
+		return result;
+	}
+
+	// lines which look like records - we use the RE to extract the fields
+	// which will be available in recRx.capturedTexts()
+	// Constellation abbreviations are allowed to start with a dot to mark them as "hidden".
+	QRegExp recRx(asterisms ? "^\\s*(\\w+)\\s+_[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)\\n"
+				: "^\\s*(\\.?\\w+)\\s+\"(.*)\"\\s+_[(]\"(.*)\"[)]\\s*(\\w*)\\n");
+	QRegExp ctxRx("(.*)\",\\s*\"(.*)");
+	const int englishNameIdx = asterisms ? 2 : 3;
+
+	int totalRecords=0;
+	int lineNumber=0;
+	while (!commonNameFile.atEnd())
+	{
+		const QString record = QString::fromUtf8(commonNameFile.readLine());
+		lineNumber++;
+		if (isComment(record))
+			continue;
+		totalRecords++;
+
+		if (!recRx.exactMatch(record))
+		{
+			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in names file" << QDir::toNativeSeparators(fileName) << ":" << record;
+			continue;
+		}
+
+		Name name;
+		name.abbreviation = recRx.capturedTexts().at(1);
+		if (!asterisms)
+			name.nativeName = recRx.capturedTexts().at(2);
+		const QString ctxt = recRx.capturedTexts().at(englishNameIdx);
+		if (ctxRx.exactMatch(ctxt))
+		{
+			name.englishName = ctxRx.capturedTexts().at(1);
+			name.context = ctxRx.capturedTexts().at(2);
+		}
+		else
+			name.englishName = ctxt;
+		result << name;
+	}
+	qDebug() << "Compiled" << result.size() << "/" << totalRecords << "names from" << QDir::toNativeSeparators(fileName);
+	return result;
+}
+
+QVector<SkyCultureBundle::SeasonalRule> SkyCultureBundle::readSeasonalRules(const QString& fileName)
+{
+	QVector<SeasonalRule> result;
+	QFile seasonalRulesFile(fileName);
+	if (!seasonalRulesFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qDebug() << "Cannot open file" << QDir::toNativeSeparators(fileName);
+		return result;
+	}
+
+	QRegExp recRx("^\\s*(\\w+)\\s+(\\w+)\\s+(\\w+)\\n");
+	int totalRecords=0;
+	int lineNumber=0;
+	while (!seasonalRulesFile.atEnd())
+	{
+		const QString record = QString::fromUtf8(seasonalRulesFile.readLine());
+		lineNumber++;
+		if (isComment(record))
+			continue;
+		totalRecords++;
+
+		if (!recRx.exactMatch(record))
+		{
+			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in seasonal rules file" << QDir::toNativeSeparators(fileName);
+			continue;
+		}
+
+		SeasonalRule rule;
+		rule.abbreviation = recRx.capturedTexts().at(1);
+		rule.beginSeason = recRx.capturedTexts().at(2).toInt();
+		rule.endSeason = recRx.capturedTexts().at(3).toInt();
+		result << rule;
+	}
+	qDebug() << "Compiled" << result.size() << "/" << totalRecords << "seasonal rules";
+	return result;
+}
+
+QVector<SkyCultureBundle::Boundary> SkyCultureBundle::readBoundaries(const QString& fileName)
+{
+	QVector<Boundary> result;
+
+	// Modified boundary file by Torsten Bronger with permission
+	// http://pp3.sourceforge.net
+	QFile dataFile(fileName);
+	if (!dataFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning() << "Boundary file " << QDir::toNativeSeparators(fileName) << " not found";
+		return result;
+	}
+
+	// Strip the comments, the data itself may span multiple lines
+	QString data;
+	while (!dataFile.atEnd())
+	{
+		const QString record = QString::fromUtf8(dataFile.readLine());
+		if (!isComment(record))
+			data.append(record);
+	}
+
+	QTextStream istr(&data);
+	while (!istr.atEnd())
+	{
+		unsigned int num = 0;
+		istr >> num;
+		if (num == 0)
+			continue; // empty line
+
+		Boundary boundary;
+		boundary.points.reserve(static_cast<int>(num));
+		for (unsigned int j=0; j<num; j++)
+		{
+			double RA, DE;
+			Vec3d XYZ;
+			istr >> RA >> DE;
+			// Calc the Cartesian coord with RA [h] and DE [deg]
+			StelUtils::spheToRect(RA*M_PI/12., DE*M_PI/180., XYZ);
+			boundary.points << XYZ;
+		}
+
+		// there are 2 constellations per boundary
+		unsigned int numc = 0;
+		istr >> numc;
+		for (unsigned int j=0; j<numc; j++)
+		{
+			QString consname;
+			istr >> consname;
+			if (consname == "SER1" || consname == "SER2") consname = "SER";
+			boundary.constellations << consname;
+		}
+		result << boundary;
+	}
+	qDebug() << "Compiled" << result.size() << "constellation boundary segments";
+	return result;
+}
+
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::Lines& lines)
+{
+	out << lines.abbreviation << static_cast<qint32>(lines.type) << lines.points;
+	return out;
+}
+
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::Lines& lines)
+{
+	qint32 type;
+	in >> lines.abbreviation >> type >> lines.points;
+	lines.type = type;
+	return in;
+}
+
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::Art& art)
+{
+	out << art.abbreviation << art.texturePath << static_cast<qint32>(art.textureWidth) << static_cast<qint32>(art.textureHeight)
+	    << art.x1 << art.y1 << art.hp1 << art.x2 << art.y2 << art.hp2 << art.x3 << art.y3 << art.hp3;
+	return out;
+}
+
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::Art& art)
+{
+	qint32 width, height;
+	in >> art.abbreviation >> art.texturePath >> width >> height
+	   >> art.x1 >> art.y1 >> art.hp1 >> art.x2 >> art.y2 >> art.hp2 >> art.x3 >> art.y3 >> art.hp3;
+	art.textureWidth = width;
+	art.textureHeight = height;
+	return in;
+}
+
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::Name& name)
+{
+	out << name.abbreviation << name.nativeName << name.englishName << name.context;
+	return out;
+}
+
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::Name& name)
+{
+	in >> name.abbreviation >> name.nativeName >> name.englishName >> name.context;
+	return in;
+}
+
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::SeasonalRule& rule)
+{
+	out << rule.abbreviation << static_cast<qint32>(rule.beginSeason) << static_cast<qint32>(rule.endSeason);
+	return out;
+}
+
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::SeasonalRule& rule)
+{
+	qint32 begin, end;
+	in >> rule.abbreviation >> begin >> end;
+	rule.beginSeason = begin;
+	rule.endSeason = end;
+	return in;
+}
+
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::Boundary& boundary)
+{
+	out << boundary.points << boundary.constellations;
+	return out;
+}
+
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::Boundary& boundary)
+{
+	in >> boundary.points >> boundary.constellations;
+	return in;
+}
@@ -0,0 +1,145 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef SKYCULTUREBUNDLE_HPP
+#define SKYCULTUREBUNDLE_HPP
+
+#include "VecMath.hpp"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QDataStream;
+
+//! @class SkyCultureBundle
+//! Compiled form of the figure data of a sky culture: constellation lines, art, names,
+//! seasonal rules and boundaries, as well as asterism lines and names.
+//! The text files of a sky culture are parsed once, and the result is cached in a binary file
+//! in the cache directory. The cache is used as long as the source files are unchanged.
+//! A bundle only contains plain data, so it can be loaded in a worker thread. The objects
+//! depending on stars and textures are created from it by ConstellationMgr and AsterismMgr.
+class SkyCultureBundle
+{
+public:
+	//! Lines of a constellation or asterism: pairs of points, given as HIP numbers for
+	//! constellations and asterisms of type 0 and 1, or as RA [h] and Dec [deg] for asterisms of type 2.
+	struct Lines
+	{
+		QString abbreviation;
+		int type;
+		QVector<double> points;
+	};
+
+	//! Constellation art: texture and texture coordinates [pixels] of three stars given by their HIP numbers.
+	struct Art
+	{
+		QString abbreviation;
+		QString texturePath;	// empty if the texture file was not found
+		int textureWidth;
+		int textureHeight;
+		unsigned int x1, y1, hp1, x2, y2, hp2, x3, y3, hp3;
+	};
+
+	struct Name
+	{
+		QString abbreviation;
+		QString nativeName;
+		QString englishName;
+		QString context;
+	};
+
+	struct SeasonalRule
+	{
+		QString abbreviation;
+		int beginSeason;
+		int endSeason;
+	};
+
+	//! A boundary segment, shared by the constellations with the given abbreviations.
+	struct Boundary
+	{
+		QVector<Vec3d> points;
+		QStringList constellations;
+	};
+
+	SkyCultureBundle() : boundariesIdx(-1), hasSeasonalRules(false), hasAsterisms(false) {}
+
+	//! Load the bundle of a sky culture, from the cache if it is still valid, else from the text files.
+	//! This can be called from a worker thread.
+	//! @param skyCultureDir the sky culture directory name, e.g. "western".
+	//! @param boundariesIdx -1 for no boundaries, 0 for the generic IAU boundaries, 1 for the sky culture's own boundaries.
+	//! @param useCache if false, the text files are always parsed and no cache is written.
+	static SkyCultureBundle load(const QString& skyCultureDir, int boundariesIdx, bool useCache=true);
+
+	//! @return true if no constellation lines could be loaded.
+	bool isEmpty() const { return constellationLines.isEmpty(); }
+
+	//! Set the directory of the cache files. An empty string selects the default,
+	//! <cache dir>/skycultures. Bundles loaded before are not reused after a change.
+	static void setCacheDir(const QString& dir);
+
+	//! Parse a constellationship.fab or asterism_lines.fab file.
+	//! @param asterisms true for asterism records, which carry a type before the number of segments.
+	static QVector<Lines> readLines(const QString& fileName, bool asterisms);
+	//! Parse a constellationsart.fab file, looking up the textures in the given sky culture directory.
+	static QVector<Art> readArt(const QString& fileName, const QString& skyCultureDir);
+	//! Parse a constellation_names.eng.fab or asterism_names.eng.fab file.
+	//! @param asterisms true for asterism records, which have no native name.
+	static QVector<Name> readNames(const QString& fileName, bool asterisms);
+	static QVector<SeasonalRule> readSeasonalRules(const QString& fileName);
+	//! Parse a constellation_boundaries.dat file.
+	static QVector<Boundary> readBoundaries(const QString& fileName);
+
+	QString skyCultureDir;
+	int boundariesIdx;
+	QVector<Lines> constellationLines;
+	QVector<Art> constellationArt;
+	QVector<Name> constellationNames;
+	bool hasSeasonalRules;
+	QVector<SeasonalRule> seasonalRules;
+	QVector<Boundary> boundaries;
+	bool hasAsterisms;
+	QVector<Lines> asterismLines;
+	QVector<Name> asterismNames;
+
+private:
+	//! Paths of the source files of a sky culture; empty strings for missing files.
+	static QStringList findSourceFiles(const QString& skyCultureDir, int boundariesIdx);
+	//! Size and modification time of the source files, used to check the validity of the cache.
+	static QVector<qint64> sourceStamps(const QStringList& sourceFiles);
+	static QString cacheFileName(const QString& skyCultureDir);
+	//! Paths of the art textures, whose sizes are stored in the bundle.
+	QStringList artFiles() const;
+
+	bool readCache(const QString& fileName, const QStringList& sourceFiles);
+	void writeCache(const QString& fileName, const QStringList& sourceFiles) const;
+};
+
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::Lines& lines);
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::Lines& lines);
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::Art& art);
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::Art& art);
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::Name& name);
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::Name& name);
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::SeasonalRule& rule);
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::SeasonalRule& rule);
+QDataStream& operator<<(QDataStream& out, const SkyCultureBundle::Boundary& boundary);
+QDataStream& operator>>(QDataStream& in, SkyCultureBundle::Boundary& boundary);
+
+#endif // SKYCULTUREBUNDLE_HPP
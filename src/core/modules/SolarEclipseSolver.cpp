@@ -0,0 +1,201 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "SolarEclipseSolver.hpp"
+#include "SolarSystem.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelUtils.hpp"
+
+#include <cmath>
+
+// Tolerance of the computed times [days], about 0.1 second
+static const double ECLIPSE_TIME_EPSILON = 1e-6;
+// Standard refraction at the horizon [radians]: 34'
+static const double HORIZON_REFRACTION = 34./60.*M_PI_180;
+
+SolarEclipseSolver::SolarEclipseSolver(StelCore* core)
+	: core(core)
+{
+	SolarSystem* solarSystem = GETSTELMODULE(SolarSystem);
+	PlanetP sun = solarSystem->getSun();
+	PlanetP moon = solarSystem->getMoon();
+	sunRadius = sun->getEquatorialRadius();
+	moonRadius = moon->getEquatorialRadius();
+
+	// Same geometry as SolarSystem::getEclipseFactor(): light time corrected Sun, topocentric observer
+	geometry = [core, solarSystem, moon](double JD) {
+		core->setJD(JD);
+		core->update(0);
+		Geometry g;
+		g.observerPos = core->getObserverHeliocentricEclipticPos();
+		g.sunPos = solarSystem->getLightTimeSunPosition();
+		g.moonPos = moon->getHeliocentricEclipticPos();
+		g.zenith = StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(core->altAzToJ2000(Vec3d(0.,0.,1.), StelCore::RefractionOff));
+		return g;
+	};
+}
+
+SolarEclipseSolver::SolarEclipseSolver(const GeometryFunc& geometry, double sunRadius, double moonRadius)
+	: core(Q_NULLPTR)
+	, geometry(geometry)
+	, sunRadius(sunRadius)
+	, moonRadius(moonRadius)
+{
+}
+
+SolarEclipseSolver::Disks SolarEclipseSolver::disksAt(double JD) const
+{
+	const Geometry g = geometry(JD);
+	const Vec3d toSun = g.sunPos - g.observerPos;
+	const Vec3d toMoon = g.moonPos - g.observerPos;
+	Vec3d sunDir = toSun;
+	sunDir.normalize();
+	Vec3d zenith = g.zenith;
+	zenith.normalize();
+
+	Disks disks;
+	disks.separation = toSun.angle(toMoon);
+	disks.sunRadius = std::asin(sunRadius / toSun.length());
+	disks.moonRadius = std::asin(moonRadius / toMoon.length());
+	disks.sunAltitude = std::asin(qBound(-1., sunDir.dot(zenith), 1.));
+	return disks;
+}
+
+double SolarEclipseSolver::findContact(double JDa, double JDb, bool outer) const
+{
+	auto f = [this, outer](double JD) {
+		const Disks disks = disksAt(JD);
+		return disks.separation - (outer ? disks.sunRadius + disks.moonRadius : std::fabs(disks.sunRadius - disks.moonRadius));
+	};
+
+	double fa = f(JDa);
+	double fb = f(JDb);
+	if (fa * fb > 0.)
+		return 0.;
+
+	// Regula falsi with the Illinois modification: the separation is nearly linear in time near the contacts
+	int side = 0;
+	double JD = JDa;
+	for (int i=0; i<50 && std::fabs(JDb - JDa) > ECLIPSE_TIME_EPSILON; ++i)
+	{
+		JD = (fb * JDa - fa * JDb) / (fb - fa);
+		const double fc = f(JD);
+		if (fc * fb > 0.)
+		{
+			JDb = JD;
+			fb = fc;
+			if (side == -1)
+				fa *= 0.5;
+			side = -1;
+		}
+		else if (fa * fc > 0.)
+		{
+			JDa = JD;
+			fa = fc;
+			if (side == 1)
+				fb *= 0.5;
+			side = 1;
+		}
+		else
+			break;
+	}
+	return JD;
+}
+
+double SolarEclipseSolver::sunAltitudeAt(double JD) const
+{
+	return JD > 0. ? disksAt(JD).sunAltitude : 0.;
+}
+
+LocalSolarEclipse SolarEclipseSolver::compute(double JD, double searchWindow) const
+{
+	LocalSolarEclipse result;
+	const double currentJD = core ? core->getJD() : 0.;
+
+	// Greatest eclipse: golden section search of the minimal separation of the centers
+	static const double invPhi = 0.5 * (std::sqrt(5.) - 1.);
+	double a = JD - searchWindow;
+	double b = JD + searchWindow;
+	double c = b - invPhi * (b - a);
+	double d = a + invPhi * (b - a);
+	double fc = disksAt(c).separation;
+	double fd = disksAt(d).separation;
+	while (b - a > ECLIPSE_TIME_EPSILON)
+	{
+		if (fc < fd)
+		{
+			b = d;
+			d = c;
+			fd = fc;
+			c = b - invPhi * (b - a);
+			fc = disksAt(c).separation;
+		}
+		else
+		{
+			a = c;
+			c = d;
+			fc = fd;
+			d = a + invPhi * (b - a);
+			fd = disksAt(d).separation;
+		}
+	}
+
+	result.JDmax = 0.5 * (a + b);
+	const Disks disks = disksAt(result.JDmax);
+	result.separation = disks.separation;
+	result.sunAltitudeMax = disks.sunAltitude;
+	result.eclipse = disks.separation < disks.sunRadius + disks.moonRadius;
+	if (result.eclipse)
+	{
+		result.central = disks.separation < std::fabs(disks.sunRadius - disks.moonRadius);
+		result.magnitude = (disks.sunRadius + disks.moonRadius - disks.separation) / (2. * disks.sunRadius);
+		// Illumination by a point-like observer, in the frame of the geometry
+		const Geometry g = geometry(result.JDmax);
+		result.obscuration = 1. - SolarSystem::computeSunIllumination(g.observerPos, g.sunPos, sunRadius, g.moonPos, moonRadius);
+
+		result.JD1 = findContact(JD - searchWindow, result.JDmax, true);
+		result.JD4 = findContact(result.JDmax, JD + searchWindow, true);
+		if (result.central)
+		{
+			result.JD2 = findContact(result.JD1 > 0. ? result.JD1 : JD - searchWindow, result.JDmax, false);
+			result.JD3 = findContact(result.JDmax, result.JD4 > 0. ? result.JD4 : JD + searchWindow, false);
+		}
+		result.sunAltitude1 = sunAltitudeAt(result.JD1);
+		result.sunAltitude2 = sunAltitudeAt(result.JD2);
+		result.sunAltitude3 = sunAltitudeAt(result.JD3);
+		result.sunAltitude4 = sunAltitudeAt(result.JD4);
+
+		// The eclipse is visible if the upper limb of the Sun is above the horizon at one of the contacts or at the maximum.
+		// An eclipse lasts a few hours at most, so the Sun cannot rise and set again between them, except near the poles.
+		const double minAltitude = -disks.sunRadius - HORIZON_REFRACTION;
+		result.visible = result.sunAltitudeMax > minAltitude
+				 || (result.JD1 > 0. && result.sunAltitude1 > minAltitude)
+				 || (result.JD2 > 0. && result.sunAltitude2 > minAltitude)
+				 || (result.JD3 > 0. && result.sunAltitude3 > minAltitude)
+				 || (result.JD4 > 0. && result.sunAltitude4 > minAltitude);
+	}
+
+	if (core)
+	{
+		core->setJD(currentJD);
+		core->update(0);
+	}
+	return result;
+}
@@ -0,0 +1,128 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef SOLARECLIPSESOLVER_HPP
+#define SOLARECLIPSESOLVER_HPP
+
+#include "Planet.hpp"
+
+#include <functional>
+
+class StelCore;
+class SolarSystem;
+
+//! @struct LocalSolarEclipse
+//! Circumstances of a solar eclipse as seen from the current observer location.
+//! Times are Julian Days (UT). The times of contacts are 0 if the contact does not occur.
+//! The Sun is considered above the horizon when its upper limb is above the mathematical horizon,
+//! with the standard refraction of 34' at the horizon. The landscape horizon is not taken into account.
+struct LocalSolarEclipse
+{
+	LocalSolarEclipse()
+		: eclipse(false), visible(false), central(false), JDmax(0.), separation(0.), magnitude(0.), obscuration(0.)
+		, JD1(0.), JD2(0.), JD3(0.), JD4(0.)
+		, sunAltitudeMax(0.), sunAltitude1(0.), sunAltitude2(0.), sunAltitude3(0.), sunAltitude4(0.) {}
+
+	//! true if the Moon covers at least part of the solar disk at the maximum, whether the Sun is above the horizon or not.
+	bool eclipse;
+	//! true if there is an eclipse and the Sun is above the horizon during at least part of it.
+	bool visible;
+	//! true if the solar disk is completely inside the lunar disk (total eclipse) or vice versa (annular eclipse).
+	bool central;
+	//! Time of greatest eclipse, i.e. of minimal separation of the centers.
+	double JDmax;
+	//! Angular separation of the centers at greatest eclipse [radians].
+	double separation;
+	//! Fraction of the solar diameter covered by the Moon at greatest eclipse.
+	double magnitude;
+	//! Fraction of the solar disk area covered by the Moon at greatest eclipse.
+	double obscuration;
+	//! First contact: begin of the partial phase.
+	double JD1;
+	//! Second contact: begin of the total or annular phase.
+	double JD2;
+	//! Third contact: end of the total or annular phase.
+	double JD3;
+	//! Fourth contact: end of the partial phase.
+	double JD4;
+	//! Geometric altitude of the center of the Sun at greatest eclipse and at the contacts [radians].
+	//! The altitudes of the contacts which do not occur are 0.
+	double sunAltitudeMax, sunAltitude1, sunAltitude2, sunAltitude3, sunAltitude4;
+};
+
+//! @class SolarEclipseSolver
+//! Computes the local circumstances of a solar eclipse around a given time, usually a conjunction of the Sun and the Moon.
+//! The time of greatest eclipse is found by a golden section search of the minimal separation of the disks,
+//! the contacts by regula falsi on the separation minus the sum or difference of the angular radii.
+//! This needs a few dozen evaluations of the planet positions instead of stepping through the eclipse.
+//! By default, the positions come from the solar system: the solver changes the time of the core, which is restored
+//! after each computation. Other sources of positions can be given as a Geometry function.
+class SolarEclipseSolver
+{
+public:
+	//! Positions of the observer, the Sun and the Moon in a common frame [AU], and the direction of the observer's zenith.
+	//! The Sun position includes the light time and aberration corrections, as SolarSystem::getLightTimeSunPosition().
+	struct Geometry
+	{
+		Vec3d observerPos;
+		Vec3d sunPos;
+		Vec3d moonPos;
+		Vec3d zenith;
+	};
+	//! Function returning the geometry at a given Julian Day (UT).
+	typedef std::function<Geometry(double)> GeometryFunc;
+
+	//! Solver using the planet positions and the observer location of the core.
+	SolarEclipseSolver(StelCore* core);
+	//! Solver using the given geometry.
+	//! @param sunRadius, moonRadius the radii of the Sun and the Moon [AU]
+	SolarEclipseSolver(const GeometryFunc& geometry, double sunRadius, double moonRadius);
+
+	//! Compute the circumstances of the eclipse around the given time.
+	//! @param JD time near the greatest eclipse (UT), e.g. the time of the conjunction.
+	//! @param searchWindow the greatest eclipse is searched within JD +/- searchWindow [days].
+	//! @return the circumstances; LocalSolarEclipse::eclipse is false if there is no eclipse from the observer location.
+	LocalSolarEclipse compute(double JD, double searchWindow=0.3) const;
+
+private:
+	//! Angular separation and radii of the Sun and the Moon seen by the observer, and altitude of the Sun [radians].
+	struct Disks
+	{
+		double separation;
+		double sunRadius;
+		double moonRadius;
+		double sunAltitude;
+	};
+
+	//! Compute the disks at the given time.
+	Disks disksAt(double JD) const;
+	//! Find the time between JDa and JDb where the disks are in contact.
+	//! @param outer true for the outer contacts (separation equal to the sum of the radii),
+	//! false for the inner contacts (separation equal to the difference of the radii)
+	//! @return the time of the contact, or 0 if there is no sign change within the interval.
+	double findContact(double JDa, double JDb, bool outer) const;
+	//! @return the altitude of the Sun at the given time, or 0 if JD is 0 (the contact does not occur).
+	double sunAltitudeAt(double JD) const;
+
+	StelCore* core;
+	GeometryFunc geometry;
+	double sunRadius;
+	double moonRadius;
+};
+
+#endif // SOLARECLIPSESOLVER_HPP
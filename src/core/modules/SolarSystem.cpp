@@ -99,6 +99,8 @@ SolarSystem::SolarSystem() : StelObjectModule()
 	, ephemerisSaturnMarkerColor(Vec3f(0.0f, 1.0f, 0.0f))
 	, allTrails(Q_NULLPTR)
 	, conf(StelApp::getInstance().getSettings())
+	, eclipseFactorValid(false)
+	, eclipseFactor(1.0)
 {
 	planetNameFont.setPixelSize(StelApp::getInstance().getScreenFontSize());
 	connect(&StelApp::getInstance(), SIGNAL(screenFontSizeChanged(int)), this, SLOT(setFontSize(int)));
@@ -1203,6 +1205,7 @@ void SolarSystem::computePositions(double dateJDE, PlanetP observerPlanet)
 		lightTimeSunPosition.set(0.,0.,0.);
 	}
 	computeTransMatrices(dateJDE, observerPlanet->getHeliocentricEclipticPos());
+	eclipseFactorValid = false;
 }
 
 // Compute the transformation matrix for every elements of the solar system.
@@ -1244,17 +1247,6 @@ void SolarSystem::draw(StelCore* core)
 	if (!flagShow)
 		return;
 
-	// Compute each Planet distance to the observer
-	const Vec3d obsHelioPos = core->getObserverHeliocentricEclipticPos();
-
-	for (const auto& p : systemPlanets)
-	{
-		p->computeDistance(obsHelioPos);
-	}
-
-	// And sort them from the furthest to the closest
-	sort(systemPlanets.begin(),systemPlanets.end(),biggerDistance());
-
 	if (trailFader.getInterstate()>0.0000001f)
 	{
 		StelPainter sPainter(core->getProjection2d());
@@ -1272,6 +1264,8 @@ void SolarSystem::draw(StelCore* core)
 	{
 		p->draw(core, maxMagLabel, planetNameFont);
 	}
+	// Draw the orbit lines not yet drawn in one go
+	Planet::drawOrbitBatch(core);
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer() && getFlagPointer())
 		drawPointer(core);
@@ -1839,6 +1833,17 @@ void SolarSystem::update(double deltaTime)
 	{
 		p->update(static_cast<int>(deltaTime*1000));
 	}
+
+	// Compute each Planet distance to the observer. This is done once per frame
+	// and not in draw(), which is called again for each additional camera.
+	const Vec3d obsHelioPos = StelApp::getInstance().getCore()->getObserverHeliocentricEclipticPos();
+	for (const auto& p : systemPlanets)
+	{
+		p->computeDistance(obsHelioPos);
+	}
+
+	// And sort them from the furthest to the closest
+	sort(systemPlanets.begin(),systemPlanets.end(),biggerDistance());
 }
 
 // is a lunar eclipse close at hand?
@@ -2858,68 +2863,84 @@ QString SolarSystem::getOrbitColorStyle() const
 
 double SolarSystem::getEclipseFactor(const StelCore* core) const
 {
-	Vec3d Lp = getLightTimeSunPosition();  //sun->getEclipticPos();
-	Vec3d P3 = core->getObserverHeliocentricEclipticPos();
+	const Vec3d P3 = core->getObserverHeliocentricEclipticPos();
+	// The factor is needed several times per frame (planet magnitudes and rendering, sky brightness, Scenery3d...)
+	if (eclipseFactorValid && P3==eclipseFactorObserverPos)
+		return eclipseFactor;
+
+	const Vec3d Lp = getLightTimeSunPosition();  //sun->getEclipticPos();
 	const double RS = sun->getEquatorialRadius();
+	const Vec3d toSun = Lp - P3;
+	const double L = toSun.length();
+	const Vec3d sunDir = toSun / L;
+	const Planet* observerPlanet = core->getCurrentPlanet().data();
 
 	double final_illumination = 1.0;
-
 	for (const auto& planet : systemPlanets)
 	{
-		if(planet == sun || planet == core->getCurrentPlanet())
+		if(planet == sun || planet.data() == observerPlanet)
 			continue;
 
-		Mat4d trans;
-		planet->computeModelMatrix(trans);
+		// Only bodies between the observer and the Sun can occult it.
+		// The model matrix is not needed, the center of the body is its heliocentric position.
+		const Vec3d C = planet->getHeliocentricEclipticPos();
+		const double t = (C - P3) * sunDir;
+		if (t <= 0. || t >= L)
+			continue;
 
-		const Vec3d C = trans * Vec3d(0., 0., 0.);
-		const double radius = planet->getEquatorialRadius();
+		const double illumination = computeSunIllumination(P3, Lp, RS, C, planet->getEquatorialRadius());
+		if(illumination < final_illumination)
+			final_illumination = illumination;
+	}
 
-		Vec3d v1 = Lp - P3;
-		Vec3d v2 = C - P3;
+	eclipseFactor = final_illumination;
+	eclipseFactorObserverPos = P3;
+	eclipseFactorValid = true;
+	return final_illumination;
+}
 
-		const double L = v1.length();
-		const double l = v2.length();
+double SolarSystem::computeSunIllumination(const Vec3d& observerPos, const Vec3d& sunPos, double sunRadius, const Vec3d& bodyPos, double bodyRadius)
+{
+	Vec3d v1 = sunPos - observerPos;
+	Vec3d v2 = bodyPos - observerPos;
 
-		v1 = v1 / L;
-		v2 = v2 / l;
+	const double L = v1.length();
+	const double l = v2.length();
 
-		const double R = RS / L;
-		const double r = radius / l;
-		const double d = ( v1 - v2 ).length();
-		double illumination;
+	v1 = v1 / L;
+	v2 = v2 / l;
 
-		if(d >= R + r) // distance too far
-		{
-			illumination = 1.0;
-		}
-		else if(d <= r - R) // umbra
-		{
-			illumination = 0.0;
-		}
-		else if(d <= R - r) // penumbra completely inside
-		{
-			illumination = 1.0 - r * r / (R * R);
-		}
-		else // penumbra partially inside
-		{
-			const double x = (R * R + d * d - r * r) / (2.0 * d);
+	const double R = sunRadius / L;
+	const double r = bodyRadius / l;
+	const double d = ( v1 - v2 ).length();
+	double illumination;
 
-			const double alpha = std::acos(x / R);
-			const double beta = std::acos((d - x) / r);
+	if(d >= R + r) // distance too far
+	{
+		illumination = 1.0;
+	}
+	else if(d <= r - R) // umbra
+	{
+		illumination = 0.0;
+	}
+	else if(d <= R - r) // penumbra completely inside
+	{
+		illumination = 1.0 - r * r / (R * R);
+	}
+	else // penumbra partially inside
+	{
+		const double x = (R * R + d * d - r * r) / (2.0 * d);
 
-			const double AR = R * R * (alpha - 0.5 * std::sin(2.0 * alpha));
-			const double Ar = r * r * (beta - 0.5 * std::sin(2.0 * beta));
-			const double AS = R * R * 2.0 * std::asin(1.0);
+		const double alpha = std::acos(x / R);
+		const double beta = std::acos((d - x) / r);
 
-			illumination = 1.0 - (AR + Ar) / AS;
-		}
+		const double AR = R * R * (alpha - 0.5 * std::sin(2.0 * alpha));
+		const double Ar = r * r * (beta - 0.5 * std::sin(2.0 * beta));
+		const double AS = R * R * 2.0 * std::asin(1.0);
 
-		if(illumination < final_illumination)
-			final_illumination = illumination;
+		illumination = 1.0 - (AR + Ar) / AS;
 	}
-
-	return final_illumination;
+	return illumination;
 }
 
 bool SolarSystem::removeMinorPlanet(QString name)
@@ -2936,6 +2957,7 @@ bool SolarSystem::removeMinorPlanet(QString name)
 	systemPlanets.removeOne(candidate);
 	systemMinorBodies.removeOne(candidate);
 	candidate.clear();
+	eclipseFactorValid = false;
 	return true;
 }
 
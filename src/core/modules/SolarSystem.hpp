@@ -1002,8 +1002,19 @@ public:
 	bool removeMinorPlanet(QString name);
 
 	//! Determines relative amount of sun visible from the observer's position.
+	//! The result is computed once per frame, i.e. as long as the positions and the observer are unchanged.
 	double getEclipseFactor(const StelCore *core) const;
 
+	//! Determines relative amount of the solar disk visible from an observer when a body passes in front of it.
+	//! All positions are heliocentric ecliptic, in AU.
+	//! @param observerPos position of the observer
+	//! @param sunPos position of the Sun, possibly corrected for light time
+	//! @param sunRadius radius of the Sun
+	//! @param bodyPos position of the occulting body
+	//! @param bodyRadius radius of the occulting body
+	//! @return 1 if the Sun is not occulted at all, 0 for a total eclipse.
+	static double computeSunIllumination(const Vec3d& observerPos, const Vec3d& sunPos, double sunRadius, const Vec3d& bodyPos, double bodyRadius);
+
 	//! Compute the position and transform matrix for every element of the solar system.
 	//! @param dateJDE the Julian Day in JDE (Ephemeris Time or equivalent)	
 	//! @param observerPlanet planet of the observer (Required for light travel time or aberration computation).
@@ -1202,6 +1213,11 @@ private:
 
 	Vec3d lightTimeSunPosition;			// when observing a solar eclipse, we need solar position 8 minutes ago.
 							// Direct shift caused problems (LP:#1699648), circumvented with this construction.
+
+	// Eclipse factor of the current frame, valid as long as the positions and the observer are unchanged
+	mutable bool eclipseFactorValid;
+	mutable double eclipseFactor;
+	mutable Vec3d eclipseFactorObserverPos;
 	// 0.16pre observation GZ: this list contains pointers to all orbit objects,
 	// while the planets don't own their orbit objects.
 	// Would it not be better to hand over the orbit object ownership to the Planet object?
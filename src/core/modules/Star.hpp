@@ -215,6 +215,7 @@ public:
 	QString getNameI18n(void) const {return QString();}
 	int hasComponentID(void) const {return 0;}
 	bool hasName() const {return false;}
+	int getHip() const {return 0;}
 	void print(void) const;
 };
 static_assert(sizeof(Star2) == 10, "Size of Star2 must be 10 bytes");
@@ -273,6 +274,7 @@ public:
 	QString getNameI18n() const {return QString();}
 	int hasComponentID() const {return 0;}
 	bool hasName() const {return false;}
+	int getHip() const {return 0;}
 	void print();
 };
 static_assert(sizeof(Star3) == 6, "Size of Star3 must be 6 bytes");
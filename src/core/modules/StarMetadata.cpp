@@ -0,0 +1,549 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StarMetadata.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QSaveFile>
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+
+// Header and version of the compiled file, to be incremented when the format changes
+static const quint32 STAR_METADATA_MAGIC = 0x53544d44;
+static const quint32 STAR_METADATA_VERSION = 1;
+
+namespace
+{
+	//! Read a text file and return its lines, with the comments and empty lines replaced by empty strings
+	//! to keep the line numbers.
+	QStringList readRecords(const QString& fileName, const char* description)
+	{
+		if (fileName.isEmpty())
+			return QStringList();
+		qDebug() << "Loading" << description << "from" << QDir::toNativeSeparators(fileName);
+		QFile f(fileName);
+		if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
+		{
+			qWarning() << "WARNING - could not open" << QDir::toNativeSeparators(fileName);
+			return QStringList();
+		}
+		QStringList records = QString::fromUtf8(f.readAll()).split('\n');
+		for (auto& record : records)
+		{
+			// skip comments and empty lines
+			if (record.startsWith("//") || record.startsWith("#"))
+				record.clear();
+		}
+		return records;
+	}
+
+	//! Pool of null terminated UTF-8 strings, offset 0 is the empty string
+	class StringPool
+	{
+	public:
+		StringPool() : data(1, '\0') {}
+		quint32 add(const QString& s)
+		{
+			if (s.isEmpty())
+				return 0;
+			auto it = offsets.constFind(s);
+			if (it!=offsets.constEnd())
+				return it.value();
+			const quint32 offset = static_cast<quint32>(data.size());
+			data.append(s.toUtf8());
+			data.append('\0');
+			offsets.insert(s, offset);
+			return offset;
+		}
+		QByteArray data;
+	private:
+		QHash<QString, quint32> offsets;
+	};
+}
+
+StarMetadata::StarMetadata()
+	: mapped(Q_NULLPTR)
+	, data(Q_NULLPTR)
+	, header(Q_NULLPTR)
+	, compiled(false)
+{
+}
+
+StarMetadata::~StarMetadata()
+{
+	close();
+}
+
+void StarMetadata::close()
+{
+	if (mapped)
+		file.unmap(mapped);
+	mapped = Q_NULLPTR;
+	if (file.isOpen())
+		file.close();
+	buffer.clear();
+	data = Q_NULLPTR;
+	header = Q_NULLPTR;
+}
+
+quint32 StarMetadata::packComponent(const QString& component)
+{
+	const QByteArray c = component.trimmed().toLatin1().left(4);
+	quint32 packed = 0;
+	for (int i=0; i<c.size(); ++i)
+		packed |= static_cast<quint32>(static_cast<uchar>(c.at(i))) << (24-8*i);
+	return packed;
+}
+
+QByteArray StarMetadata::computeSignature(const QStringList& files)
+{
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	for (const auto& f : files)
+	{
+		QFileInfo info(f);
+		hash.addData(f.toUtf8());
+		hash.addData(QByteArray::number(info.exists() ? info.size() : -1));
+		hash.addData(QByteArray::number(info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0));
+	}
+	return hash.result();
+}
+
+bool StarMetadata::open(const QString& storeFile, const QString& gcvsFile, const QString& wdsFile, const QString& crossIdFile, const QString& plxErrFile)
+{
+	close();
+	compiled = false;
+	const QByteArray signature = computeSignature(QStringList() << gcvsFile << wdsFile << crossIdFile << plxErrFile);
+
+	// Map the compiled file if it is up to date
+	file.setFileName(storeFile);
+	if (file.open(QIODevice::ReadOnly))
+	{
+		mapped = file.map(0, file.size());
+		if (mapped && setData(mapped, file.size(), signature))
+			return true;
+		close();
+	}
+
+	buffer = compile(signature, gcvsFile, wdsFile, crossIdFile, plxErrFile);
+	compiled = true;
+
+	QDir().mkpath(QFileInfo(storeFile).absolutePath());
+	QSaveFile out(storeFile);
+	if (out.open(QIODevice::WriteOnly) && out.write(buffer)==buffer.size() && out.commit())
+	{
+		// Use the file rather than the buffer, so that the pages can be shared and dropped by the OS
+		file.setFileName(storeFile);
+		if (file.open(QIODevice::ReadOnly))
+		{
+			mapped = file.map(0, file.size());
+			if (mapped && setData(mapped, file.size(), signature))
+			{
+				buffer.clear();
+				return true;
+			}
+			if (mapped)
+				file.unmap(mapped);
+			mapped = Q_NULLPTR;
+			file.close();
+		}
+	}
+	else
+		qWarning() << "WARNING - could not write star metadata file" << QDir::toNativeSeparators(storeFile) << ", keeping it in memory";
+
+	return setData(reinterpret_cast<const uchar*>(buffer.constData()), buffer.size(), signature);
+}
+
+bool StarMetadata::setData(const uchar* d, qint64 size, const QByteArray& signature)
+{
+	static const int recordSizes[SectionCount] = {
+		sizeof(GcvsRecord), sizeof(IndexEntry), sizeof(WdsRecord), sizeof(IndexEntry), sizeof(CrossIdRecord),
+		sizeof(IndexEntry), sizeof(IndexEntry), sizeof(IndexEntry), sizeof(PlxErrorRecord), 1 };
+
+	if (size<static_cast<qint64>(sizeof(Header)))
+		return false;
+	const Header* h = reinterpret_cast<const Header*>(d);
+	if (h->magic!=STAR_METADATA_MAGIC || h->version!=STAR_METADATA_VERSION || memcmp(h->signature, signature.constData(), sizeof(h->signature))!=0)
+		return false;
+	for (int s=0; s<SectionCount; ++s)
+	{
+		if (h->offsets[s]%8!=0 || static_cast<qint64>(h->offsets[s])+static_cast<qint64>(h->counts[s])*recordSizes[s]>size)
+		{
+			qWarning() << "WARNING - corrupted star metadata file";
+			return false;
+		}
+	}
+	data = d;
+	header = h;
+	return true;
+}
+
+QByteArray StarMetadata::compile(const QByteArray& signature, const QString& gcvsFile, const QString& wdsFile, const QString& crossIdFile, const QString& plxErrFile)
+{
+	StringPool strings;
+	int lineNumber, readOk, totalRecords;
+
+	// GCVS, record structure is delimited with a tab character.
+	QMap<quint32, GcvsRecord> gcvs;
+	QMap<QString, int> gcvsNames;
+	lineNumber = readOk = totalRecords = 0;
+	for (const auto& record : readRecords(gcvsFile, "variable stars"))
+	{
+		++lineNumber;
+		if (record.isEmpty())
+			continue;
+		++totalRecords;
+		const QStringList& fields = record.split('\t');
+		bool ok;
+		const int hip = fields.at(0).toInt(&ok);
+		if (!ok || fields.size()<12)
+		{
+			qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(gcvsFile)
+				   << " - record does not match record pattern";
+			continue;
+		}
+
+		// Don't set the star if it's already set
+		if (gcvs.contains(hip))
+			continue;
+
+		GcvsRecord vs;
+		vs.hip = hip;
+		const QString designation = fields.at(1).trimmed();
+		vs.designation = strings.add(designation);
+		vs.vtype = strings.add(fields.at(2).trimmed());
+		vs.maxmag = fields.at(3).isEmpty() ? 99.f : fields.at(3).toFloat();
+		vs.mflag = fields.at(4).toInt();
+		vs.min1mag = fields.at(5).isEmpty() ? 99.f : fields.at(5).toFloat();
+		vs.min2mag = fields.at(6).isEmpty() ? 99.f : fields.at(6).toFloat();
+		vs.photosys = strings.add(fields.at(7).trimmed());
+		vs.epoch = fields.at(8).toDouble();
+		vs.period = fields.at(9).toDouble();
+		vs.Mm = fields.at(10).toInt();
+		vs.stype = strings.add(fields.at(11).trimmed());
+		gcvs.insert(hip, vs);
+		gcvsNames[designation.toUpper()] = hip;
+		++readOk;
+	}
+	if (totalRecords>0)
+		qDebug() << "Loaded" << readOk << "/" << totalRecords << "variable stars";
+
+	// WDS, record structure is delimited with a tab character.
+	QMap<quint32, WdsRecord> wds;
+	QMap<QString, int> wdsNames;
+	lineNumber = readOk = totalRecords = 0;
+	for (const auto& record : readRecords(wdsFile, "double stars"))
+	{
+		++lineNumber;
+		if (record.isEmpty())
+			continue;
+		++totalRecords;
+		const QStringList& fields = record.split('\t');
+		bool ok;
+		const int hip = fields.at(0).toInt(&ok);
+		if (!ok || fields.size()<5)
+		{
+			qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(wdsFile)
+				   << " - record does not match record pattern";
+			continue;
+		}
+
+		// Don't set the star if it's already set
+		if (wds.contains(hip))
+			continue;
+
+		WdsRecord ds;
+		ds.hip = hip;
+		const QString designation = fields.at(1).trimmed();
+		ds.designation = strings.add(designation);
+		ds.observation = fields.at(2).toInt();
+		ds.positionAngle = fields.at(3).toFloat();
+		ds.separation = fields.at(4).toFloat();
+		wds.insert(hip, ds);
+		wdsNames[QString("WDS J%1").arg(designation.toUpper())] = hip;
+		++readOk;
+	}
+	if (totalRecords>0)
+		qDebug() << "Loaded" << readOk << "/" << totalRecords << "double stars";
+
+	// Cross-identifications, record structure is delimited with a 'tab' character. Example record strings:
+	// "1	128522	224700"
+	// "2	165988	224690"
+	QMap<quint64, CrossIdRecord> crossIds;
+	QMap<int, int> sao, hd, hr;
+	lineNumber = readOk = totalRecords = 0;
+	for (const auto& record : readRecords(crossIdFile, "cross-identification data"))
+	{
+		++lineNumber;
+		if (record.isEmpty())
+			continue;
+		++totalRecords;
+		const QStringList& fields = record.split('\t');
+		bool ok = fields.size()==5;
+		const int hip = ok ? fields.at(0).toInt(&ok) : 0;
+		if (!ok)
+		{
+			qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(crossIdFile)
+				   << " - record does not match record pattern";
+			continue;
+		}
+
+		CrossIdRecord ci;
+		ci.hip = hip;
+		ci.component = packComponent(fields.at(1));
+		ci.sao = fields.at(2).toInt();
+		ci.hd = fields.at(3).toInt();
+		ci.hr = fields.at(4).toInt();
+		crossIds[(static_cast<quint64>(ci.hip) << 32) | ci.component] = ci;
+		if (ci.sao>0)
+			sao[ci.sao] = hip;
+		if (ci.hd>0)
+			hd[ci.hd] = hip;
+		if (ci.hr>0)
+			hr[ci.hr] = hip;
+		++readOk;
+	}
+	if (totalRecords>0)
+		qDebug() << "Loaded" << readOk << "/" << totalRecords << "cross-identification data records for stars";
+
+	// Parallax errors, record structure is delimited with a 'tab' character. Example record strings:
+	// "1	0.0606"
+	// "2	0.3193"
+	QMap<quint32, float> plxErrors;
+	lineNumber = readOk = totalRecords = 0;
+	for (const auto& record : readRecords(plxErrFile, "parallax errors data"))
+	{
+		++lineNumber;
+		if (record.isEmpty())
+			continue;
+		++totalRecords;
+		const QStringList& fields = record.split('\t');
+		bool ok = fields.size()==2;
+		const int hip = ok ? fields.at(0).toInt(&ok) : 0;
+		if (!ok)
+		{
+			qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(plxErrFile)
+				   << " - record does not match record pattern";
+			continue;
+		}
+		plxErrors[hip] = fields.at(1).toFloat();
+		++readOk;
+	}
+	if (totalRecords>0)
+		qDebug() << "Loaded" << readOk << "/" << totalRecords << "parallax error data records for stars";
+
+	// Build the sections, the maps are already sorted by key
+	auto numberIndex = [](const QMap<int, int>& map) {
+		QVector<IndexEntry> index;
+		index.reserve(map.size());
+		for (auto it=map.constBegin(); it!=map.constEnd(); ++it)
+			index.append({it.key(), static_cast<quint32>(it.value())});
+		return index;
+	};
+	auto nameIndex = [&strings](const QMap<QString, int>& map) {
+		QVector<IndexEntry> index;
+		index.reserve(map.size());
+		for (auto it=map.constBegin(); it!=map.constEnd(); ++it)
+			index.append({static_cast<qint32>(strings.add(it.key())), static_cast<quint32>(it.value())});
+		return index;
+	};
+	const QVector<GcvsRecord> gcvsRecords = gcvs.values().toVector();
+	const QVector<IndexEntry> gcvsIndex = nameIndex(gcvsNames);
+	const QVector<WdsRecord> wdsRecords = wds.values().toVector();
+	const QVector<IndexEntry> wdsIndex = nameIndex(wdsNames);
+	const QVector<CrossIdRecord> crossIdRecords = crossIds.values().toVector();
+	const QVector<IndexEntry> saoIndex = numberIndex(sao);
+	const QVector<IndexEntry> hdIndex = numberIndex(hd);
+	const QVector<IndexEntry> hrIndex = numberIndex(hr);
+	QVector<PlxErrorRecord> plxRecords;
+	plxRecords.reserve(plxErrors.size());
+	for (auto it=plxErrors.constBegin(); it!=plxErrors.constEnd(); ++it)
+		plxRecords.append({it.key(), it.value()});
+
+	Header h;
+	memset(&h, 0, sizeof(h));
+	h.magic = STAR_METADATA_MAGIC;
+	h.version = STAR_METADATA_VERSION;
+	memcpy(h.signature, signature.constData(), qMin(static_cast<int>(sizeof(h.signature)), signature.size()));
+
+	QByteArray result(sizeof(Header), '\0');
+	auto appendSection = [&result, &h](Section s, const void* records, int count, int recordSize) {
+		while (result.size()%8!=0)
+			result.append('\0');
+		h.offsets[s] = static_cast<quint32>(result.size());
+		h.counts[s] = static_cast<quint32>(count);
+		result.append(static_cast<const char*>(records), count*recordSize);
+	};
+	appendSection(SectionGcvs, gcvsRecords.constData(), gcvsRecords.size(), sizeof(GcvsRecord));
+	appendSection(SectionGcvsNames, gcvsIndex.constData(), gcvsIndex.size(), sizeof(IndexEntry));
+	appendSection(SectionWds, wdsRecords.constData(), wdsRecords.size(), sizeof(WdsRecord));
+	appendSection(SectionWdsNames, wdsIndex.constData(), wdsIndex.size(), sizeof(IndexEntry));
+	appendSection(SectionCrossIds, crossIdRecords.constData(), crossIdRecords.size(), sizeof(CrossIdRecord));
+	appendSection(SectionSao, saoIndex.constData(), saoIndex.size(), sizeof(IndexEntry));
+	appendSection(SectionHd, hdIndex.constData(), hdIndex.size(), sizeof(IndexEntry));
+	appendSection(SectionHr, hrIndex.constData(), hrIndex.size(), sizeof(IndexEntry));
+	appendSection(SectionPlxErrors, plxRecords.constData(), plxRecords.size(), sizeof(PlxErrorRecord));
+	appendSection(SectionStrings, strings.data.constData(), strings.data.size(), 1);
+	memcpy(result.data(), &h, sizeof(h));
+	return result;
+}
+
+QString StarMetadata::getString(quint32 offset) const
+{
+	if (!header || offset==0 || offset>=header->counts[SectionStrings])
+		return QString();
+	return QString::fromUtf8(reinterpret_cast<const char*>(data + header->offsets[SectionStrings] + offset));
+}
+
+const StarMetadata::GcvsRecord* StarMetadata::findGcvs(int hip) const
+{
+	if (!header)
+		return Q_NULLPTR;
+	const GcvsRecord* begin = section<GcvsRecord>(SectionGcvs);
+	const GcvsRecord* end = begin + header->counts[SectionGcvs];
+	const GcvsRecord* it = std::lower_bound(begin, end, static_cast<quint32>(hip), [](const GcvsRecord& r, quint32 h) {return r.hip<h;});
+	return (it!=end && it->hip==static_cast<quint32>(hip)) ? it : Q_NULLPTR;
+}
+
+int StarMetadata::getGcvsCount() const
+{
+	return header ? static_cast<int>(header->counts[SectionGcvs]) : 0;
+}
+
+const StarMetadata::WdsRecord* StarMetadata::findWds(int hip) const
+{
+	if (!header)
+		return Q_NULLPTR;
+	const WdsRecord* begin = section<WdsRecord>(SectionWds);
+	const WdsRecord* end = begin + header->counts[SectionWds];
+	const WdsRecord* it = std::lower_bound(begin, end, static_cast<quint32>(hip), [](const WdsRecord& r, quint32 h) {return r.hip<h;});
+	return (it!=end && it->hip==static_cast<quint32>(hip)) ? it : Q_NULLPTR;
+}
+
+const StarMetadata::CrossIdRecord* StarMetadata::findCrossId(int hip, const QString& component) const
+{
+	if (!header)
+		return Q_NULLPTR;
+	const CrossIdRecord* begin = section<CrossIdRecord>(SectionCrossIds);
+	const CrossIdRecord* end = begin + header->counts[SectionCrossIds];
+	const quint64 key = (static_cast<quint64>(hip) << 32) | packComponent(component);
+	auto less = [](const CrossIdRecord& r, quint64 k) {return ((static_cast<quint64>(r.hip) << 32) | r.component)<k;};
+	const CrossIdRecord* it = std::lower_bound(begin, end, key, less);
+	if (it!=end && it->hip==static_cast<quint32>(hip) && it->component==static_cast<quint32>(key))
+		return it;
+	// Use the data of the star for its components
+	if (static_cast<quint32>(key)!=0)
+		return findCrossId(hip, QString());
+	return Q_NULLPTR;
+}
+
+float StarMetadata::getPlxError(int hip) const
+{
+	if (!header)
+		return 0.f;
+	const PlxErrorRecord* begin = section<PlxErrorRecord>(SectionPlxErrors);
+	const PlxErrorRecord* end = begin + header->counts[SectionPlxErrors];
+	const PlxErrorRecord* it = std::lower_bound(begin, end, static_cast<quint32>(hip), [](const PlxErrorRecord& r, quint32 h) {return r.hip<h;});
+	return (it!=end && it->hip==static_cast<quint32>(hip)) ? it->error : 0.f;
+}
+
+int StarMetadata::searchIndex(Section s, int key) const
+{
+	if (!header)
+		return -1;
+	const IndexEntry* begin = section<IndexEntry>(s);
+	const IndexEntry* end = begin + header->counts[s];
+	const IndexEntry* it = std::lower_bound(begin, end, key, [](const IndexEntry& e, int k) {return e.key<k;});
+	return (it!=end && it->key==key) ? static_cast<int>(it->hip) : -1;
+}
+
+int StarMetadata::searchSao(int sao) const
+{
+	return searchIndex(SectionSao, sao);
+}
+
+int StarMetadata::searchHd(int hd) const
+{
+	return searchIndex(SectionHd, hd);
+}
+
+int StarMetadata::searchHr(int hr) const
+{
+	return searchIndex(SectionHr, hr);
+}
+
+const StarMetadata::IndexEntry* StarMetadata::nameLowerBound(Section s, const QString& name) const
+{
+	// The index is sorted like QMap<QString, int>, only the compared names are converted to QString
+	const IndexEntry* begin = section<IndexEntry>(s);
+	const IndexEntry* end = begin + header->counts[s];
+	return std::lower_bound(begin, end, name, [this](const IndexEntry& e, const QString& n) {return getString(static_cast<quint32>(e.key))<n;});
+}
+
+int StarMetadata::searchNameIndex(Section s, const QString& name) const
+{
+	if (!header)
+		return -1;
+	const IndexEntry* it = nameLowerBound(s, name);
+	if (it!=section<IndexEntry>(s) + header->counts[s] && getString(static_cast<quint32>(it->key))==name)
+		return static_cast<int>(it->hip);
+	return -1;
+}
+
+QList<int> StarMetadata::listNameIndexByPrefix(Section s, const QString& prefix, int maxNbItem) const
+{
+	QList<int> result;
+	if (!header)
+		return result;
+	const IndexEntry* end = section<IndexEntry>(s) + header->counts[s];
+	for (const IndexEntry* it = nameLowerBound(s, prefix); it!=end && result.size()<maxNbItem; ++it)
+	{
+		if (!getString(static_cast<quint32>(it->key)).startsWith(prefix))
+			break;
+		result << static_cast<int>(it->hip);
+	}
+	return result;
+}
+
+int StarMetadata::searchGcvs(const QString& designation) const
+{
+	return searchNameIndex(SectionGcvsNames, designation);
+}
+
+int StarMetadata::searchWds(const QString& designation) const
+{
+	return searchNameIndex(SectionWdsNames, designation);
+}
+
+QList<int> StarMetadata::listGcvsByPrefix(const QString& prefix, int maxNbItem) const
+{
+	return listNameIndexByPrefix(SectionGcvsNames, prefix, maxNbItem);
+}
+
+QList<int> StarMetadata::listWdsByPrefix(const QString& prefix, int maxNbItem) const
+{
+	return listNameIndexByPrefix(SectionWdsNames, prefix, maxNbItem);
+}
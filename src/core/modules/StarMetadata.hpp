@@ -0,0 +1,184 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef STARMETADATA_HPP
+#define STARMETADATA_HPP
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+//! @class StarMetadata
+//! Read-only store for the metadata of the Hipparcos stars: the GCVS variable star data, the WDS double star data,
+//! the SAO, HD and HR cross-identifications and the parallax errors.
+//!
+//! The text files are compiled once into a binary file, typically in the cache directory, which is memory-mapped
+//! at the next startups instead of being parsed again. The file is compiled again when one of the text files changes.
+//! The binary file contains arrays of fixed-size records sorted by HIP number, reverse indexes sorted by catalog
+//! number or upper case designation, and a pool of UTF-8 strings. Lookups are binary searches in the mapped records,
+//! and the strings are only converted to QString when they are requested.
+class StarMetadata
+{
+public:
+	//! GCVS data of a variable star
+	struct GcvsRecord
+	{
+		double epoch;		//!< Epoch for maximum light (Julian days)
+		double period;		//!< Period of the variable star (days)
+		quint32 hip;
+		float maxmag;		//!< Magnitude at maximum brightness
+		qint32 mflag;		//!< Magnitude flag code
+		float min1mag;		//!< First minimum magnitude or amplitude
+		float min2mag;		//!< Second minimum magnitude or amplitude
+		qint32 Mm;		//!< Rising time or duration of eclipse (%)
+		quint32 designation;	//!< GCVS designation (string offset)
+		quint32 vtype;		//!< Type of variability (string offset)
+		quint32 photosys;	//!< The photometric system for magnitudes (string offset)
+		quint32 stype;		//!< Spectral type (string offset)
+	};
+
+	//! WDS data of a double star
+	struct WdsRecord
+	{
+		quint32 hip;
+		qint32 observation;	//!< Date of last satisfactory observation, yr
+		float positionAngle;	//!< Position Angle at date of last satisfactory observation, deg
+		float separation;	//!< Separation at date of last satisfactory observation, arcsec
+		quint32 designation;	//!< WDS designation (string offset)
+	};
+
+	//! Cross-identification of a star or of a component of a multiple star
+	struct CrossIdRecord
+	{
+		quint32 hip;
+		quint32 component;	//!< Component letters packed with packComponent(), 0 for the star itself
+		qint32 sao;
+		qint32 hd;
+		qint32 hr;
+	};
+
+	StarMetadata();
+	~StarMetadata();
+
+	//! Open the store, compiling it first if it does not exist or if the text files changed.
+	//! If the compiled file can not be written, the compiled data is kept in memory.
+	//! Each text file may be empty or missing, the corresponding data is then not available.
+	//! @param storeFile the path of the compiled file.
+	//! @return false if the store could be neither opened nor compiled.
+	bool open(const QString& storeFile, const QString& gcvsFile, const QString& wdsFile, const QString& crossIdFile, const QString& plxErrFile);
+	void close();
+
+	//! Return true if the store was compiled by the last call to open(), false if it was only mapped.
+	bool wasCompiled() const {return compiled;}
+
+	//! Return the GCVS data of the star or Q_NULLPTR.
+	const GcvsRecord* findGcvs(int hip) const;
+	//! Return the number of GCVS records, which are sorted by HIP number.
+	int getGcvsCount() const;
+	//! Return the GCVS record at the given position, in [0, getGcvsCount()[.
+	const GcvsRecord* getGcvs(int index) const {return section<GcvsRecord>(SectionGcvs) + index;}
+	//! Return the WDS data of the star or Q_NULLPTR.
+	const WdsRecord* findWds(int hip) const;
+	//! Return the cross-identification of the given component of the star or Q_NULLPTR.
+	const CrossIdRecord* findCrossId(int hip, const QString& component) const;
+	//! Return the parallax error of the star in mas, or 0 if unknown.
+	float getPlxError(int hip) const;
+
+	//! Return the HIP number of the star with the given SAO, HD or HR number, or -1.
+	int searchSao(int sao) const;
+	int searchHd(int hd) const;
+	int searchHr(int hr) const;
+	//! Return the HIP number of the star with the given upper case GCVS designation, or -1.
+	int searchGcvs(const QString& designation) const;
+	//! Return the HIP number of the star with the given upper case WDS designation ("WDS J..."), or -1.
+	int searchWds(const QString& designation) const;
+	//! Return the HIP numbers of the stars whose upper case GCVS or WDS designation starts with the prefix,
+	//! ordered by designation.
+	QList<int> listGcvsByPrefix(const QString& prefix, int maxNbItem) const;
+	QList<int> listWdsByPrefix(const QString& prefix, int maxNbItem) const;
+
+	//! Return the string at the given offset of the string pool.
+	QString getString(quint32 offset) const;
+
+	//! Pack component letters (at most 4 ASCII characters) into a number.
+	static quint32 packComponent(const QString& component);
+
+private:
+	enum Section
+	{
+		SectionGcvs,
+		SectionGcvsNames,
+		SectionWds,
+		SectionWdsNames,
+		SectionCrossIds,
+		SectionSao,
+		SectionHd,
+		SectionHr,
+		SectionPlxErrors,
+		SectionStrings,
+		SectionCount
+	};
+
+	struct Header
+	{
+		quint32 magic;
+		quint32 version;
+		//! MD5 sum of the names, sizes and modification dates of the text files
+		char signature[16];
+		quint32 offsets[SectionCount];
+		quint32 counts[SectionCount];
+	};
+
+	//! A reverse index entry, the key is a catalog number or a string offset
+	struct IndexEntry
+	{
+		qint32 key;
+		quint32 hip;
+	};
+
+	struct PlxErrorRecord
+	{
+		quint32 hip;
+		float error;
+	};
+
+	static QByteArray computeSignature(const QStringList& files);
+	//! Parse the text files and return the content of the store
+	static QByteArray compile(const QByteArray& signature, const QString& gcvsFile, const QString& wdsFile, const QString& crossIdFile, const QString& plxErrFile);
+	//! Check the header and set the section pointers
+	bool setData(const uchar* d, qint64 size, const QByteArray& signature);
+
+	template<class T> const T* section(Section s) const {return reinterpret_cast<const T*>(data + header->offsets[s]);}
+	int searchIndex(Section s, int key) const;
+	int searchNameIndex(Section s, const QString& name) const;
+	QList<int> listNameIndexByPrefix(Section s, const QString& prefix, int maxNbItem) const;
+	//! Return the first entry of the name index not lower than the name
+	const IndexEntry* nameLowerBound(Section s, const QString& name) const;
+
+	QFile file;
+	uchar* mapped;
+	//! The store when it can't be mapped
+	QByteArray buffer;
+	const uchar* data;
+	const Header* header;
+	bool compiled;
+};
+
+#endif // STARMETADATA_HPP
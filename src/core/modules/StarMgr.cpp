@@ -42,6 +42,7 @@
 #include "StelPainter.hpp"
 #include "StelJsonParser.hpp"
 #include "ZoneArray.hpp"
+#include "StarMetadata.hpp"
 #include "StelSkyDrawer.hpp"
 #include "RefractionExtinction.hpp"
 #include "StelModuleMgr.hpp"
@@ -56,6 +57,7 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QCryptographicHash>
+#include <QElapsedTimer>
 
 #include <cstdlib>
 
@@ -82,16 +84,10 @@ QHash<int,QString> StarMgr::sciNamesMapI18n;
 QMap<QString,int> StarMgr::sciNamesIndexI18n;
 QHash<int,QString> StarMgr::sciAdditionalNamesMapI18n;
 QMap<QString,int> StarMgr::sciAdditionalNamesIndexI18n;
-QHash<int, varstar> StarMgr::varStarsMapI18n;
-QMap<QString, int> StarMgr::varStarsIndexI18n;
-QHash<int, wds> StarMgr::wdsStarsMapI18n;
-QMap<QString, int> StarMgr::wdsStarsIndexI18n;
-QMap<QString, crossid> StarMgr::crossIdMap;
-QMap<int, int> StarMgr::saoStarsIndex;
-QMap<int, int> StarMgr::hdStarsIndex;
-QMap<int, int> StarMgr::hrStarsIndex;
+StarMetadata StarMgr::starMetadata;
+QVector<qint16> StarMgr::variableMagShifts;
+QHash<const ZoneData*, qint16> StarMgr::variableZoneShifts;
 QHash<int, QString> StarMgr::referenceMap;
-QHash<int, float> StarMgr::hipParallaxErrors;
 
 QStringList initStringListFromFile(const QString& file_name)
 {
@@ -144,7 +140,9 @@ StarMgr::StarMgr(void)
 	, gravityLabel(false)
 	, maxGeodesicGridLevel(-1)
 	, lastMaxSearchLevel(-1)
+	, moduleDataLoaded(false)
 	, hipIndex(new HipIndexStruct[NR_OF_HIP+1])
+	, variableZoneShiftsDirty(true)
 {
 	setObjectName("StarMgr");
 	objectMgr = GETSTELMODULE(StelObjectMgr);
@@ -227,31 +225,32 @@ QString StarMgr::getSciAdditionalName(int hip)
 
 QString StarMgr::getCrossIdentificationDesignations(QString hip)
 {
-	QString designations;
-	auto cr = crossIdMap.find(hip);
-	if (cr==crossIdMap.end() && hip.right(1).toUInt()==0)
-		cr = crossIdMap.find(hip.left(hip.size()-1));
+	// The argument is the HIP number followed by the component letters, if any
+	int digits = 0;
+	while (digits<hip.size() && hip.at(digits).isDigit())
+		++digits;
 
-	if (cr!=crossIdMap.end())
+	QString designations;
+	const StarMetadata::CrossIdRecord* crossIdData = starMetadata.findCrossId(hip.left(digits).toInt(), hip.mid(digits));
+	if (crossIdData)
 	{
-		crossid crossIdData = cr.value();
-		if (crossIdData.sao>0)
-			designations = QString("SAO %1").arg(crossIdData.sao);
+		if (crossIdData->sao>0)
+			designations = QString("SAO %1").arg(crossIdData->sao);
 
-		if (crossIdData.hd>0)
+		if (crossIdData->hd>0)
 		{
 			if (designations.isEmpty())
-				designations = QString("HD %1").arg(crossIdData.hd);
+				designations = QString("HD %1").arg(crossIdData->hd);
 			else
-				designations += QString(" - HD %1").arg(crossIdData.hd);
+				designations += QString(" - HD %1").arg(crossIdData->hd);
 		}
 
-		if (crossIdData.hr>0)
+		if (crossIdData->hr>0)
 		{
 			if (designations.isEmpty())
-				designations = QString("HR %1").arg(crossIdData.hr);
+				designations = QString("HR %1").arg(crossIdData->hr);
 			else
-				designations += QString(" - HR %1").arg(crossIdData.hr);
+				designations += QString(" - HR %1").arg(crossIdData->hr);
 		}
 	}
 
@@ -260,81 +259,81 @@ QString StarMgr::getCrossIdentificationDesignations(QString hip)
 
 QString StarMgr::getWdsName(int hip)
 {
-	auto it = wdsStarsMapI18n.find(hip);
-	if (it!=wdsStarsMapI18n.end())
-		return QString("WDS J%1").arg(it.value().designation);
+	const StarMetadata::WdsRecord* ds = starMetadata.findWds(hip);
+	if (ds)
+		return QString("WDS J%1").arg(starMetadata.getString(ds->designation));
 	return QString();
 }
 
 int StarMgr::getWdsLastObservation(int hip)
 {
-	auto it = wdsStarsMapI18n.find(hip);
-	if (it!=wdsStarsMapI18n.end())
-		return it.value().observation;
+	const StarMetadata::WdsRecord* ds = starMetadata.findWds(hip);
+	if (ds)
+		return ds->observation;
 	return 0;
 }
 
 float StarMgr::getWdsLastPositionAngle(int hip)
 {
-	auto it = wdsStarsMapI18n.find(hip);
-	if (it!=wdsStarsMapI18n.end())
-		return it.value().positionAngle;
+	const StarMetadata::WdsRecord* ds = starMetadata.findWds(hip);
+	if (ds)
+		return ds->positionAngle;
 	return 0;
 }
 
 float StarMgr::getWdsLastSeparation(int hip)
 {
-	auto it = wdsStarsMapI18n.find(hip);
-	if (it!=wdsStarsMapI18n.end())
-		return it.value().separation;
+	const StarMetadata::WdsRecord* ds = starMetadata.findWds(hip);
+	if (ds)
+		return ds->separation;
 	return 0.f;
 }
 
 QString StarMgr::getGcvsName(int hip)
 {
-	auto it = varStarsMapI18n.find(hip);
-	if (it!=varStarsMapI18n.end())
-		return it.value().designation;
+	const StarMetadata::GcvsRecord* vs = starMetadata.findGcvs(hip);
+	if (vs)
+		return starMetadata.getString(vs->designation);
 	return QString();
 }
 
 QString StarMgr::getGcvsVariabilityType(int hip)
 {
-	auto it = varStarsMapI18n.find(hip);
-	if (it!=varStarsMapI18n.end())
-		return it.value().vtype;
+	const StarMetadata::GcvsRecord* vs = starMetadata.findGcvs(hip);
+	if (vs)
+		return starMetadata.getString(vs->vtype);
 	return QString();
 }
 
 float StarMgr::getGcvsMaxMagnitude(int hip)
 {
-	auto it = varStarsMapI18n.find(hip);
-	if (it!=varStarsMapI18n.end())
-		return it.value().maxmag;
+	const StarMetadata::GcvsRecord* vs = starMetadata.findGcvs(hip);
+	if (vs)
+		return vs->maxmag;
 	return -99.f;
 }
 
 int StarMgr::getGcvsMagnitudeFlag(int hip)
 {
-	auto it = varStarsMapI18n.find(hip);
-	if (it!=varStarsMapI18n.end())
-		return it.value().mflag;
+	const StarMetadata::GcvsRecord* vs = starMetadata.findGcvs(hip);
+	if (vs)
+		return vs->mflag;
 	return 0;
 }
 
 
 float StarMgr::getGcvsMinMagnitude(int hip, bool firstMinimumFlag)
 {
-	auto it = varStarsMapI18n.find(hip);
-	if (it!=varStarsMapI18n.end())
+	const StarMetadata::GcvsRecord* vs = starMetadata.findGcvs(hip);
+	if (vs)
 	{
 		if (firstMinimumFlag)
 		{
-			return it.value().min1mag;
+			return vs->min1mag;
 		}
 		else
 		{
-			return it.value().min2mag;
+			return vs->min2mag;
 		}
 	}
 	return -99.f;
@@ -342,42 +341,39 @@ float StarMgr::getGcvsMinMagnitude(int hip, bool firstMinimumFlag)
 
 QString StarMgr::getGcvsPhotometricSystem(int hip)
 {
-	auto it = varStarsMapI18n.find(hip);
-	if (it!=varStarsMapI18n.end())
-		return it.value().photosys;
+	const StarMetadata::GcvsRecord* vs = starMetadata.findGcvs(hip);
+	if (vs)
+		return starMetadata.getString(vs->photosys);
 	return QString();
 }
 
 double StarMgr::getGcvsEpoch(int hip)
 {
-	auto it = varStarsMapI18n.find(hip);
-	if (it!=varStarsMapI18n.end())
-		return it.value().epoch;
+	const StarMetadata::GcvsRecord* vs = starMetadata.findGcvs(hip);
+	if (vs)
+		return vs->epoch;
 	return -99.;
 }
 
 double StarMgr::getGcvsPeriod(int hip)
 {
-	auto it = varStarsMapI18n.find(hip);
-	if (it!=varStarsMapI18n.end())
-		return it.value().period;
+	const StarMetadata::GcvsRecord* vs = starMetadata.findGcvs(hip);
+	if (vs)
+		return vs->period;
 	return -99.;
 }
 
 int StarMgr::getGcvsMM(int hip)
 {
-	auto it = varStarsMapI18n.find(hip);
-	if (it!=varStarsMapI18n.end())
-		return it.value().Mm;
+	const StarMetadata::GcvsRecord* vs = starMetadata.findGcvs(hip);
+	if (vs)
+		return vs->Mm;
 	return -99;
 }
 
 float StarMgr::getPlxError(int hip)
 {
-	auto it = hipParallaxErrors.find(hip);
-	if (it!=hipParallaxErrors.end())
-		return it.value();
-	return 0.f;
+	return starMetadata.getPlxError(hip);
 }
 
 void StarMgr::copyDefaultConfigFile()
@@ -397,10 +393,11 @@ void StarMgr::copyDefaultConfigFile()
 	}
 }
 
-void StarMgr::init()
+void StarMgr::loadModuleData()
 {
-	QSettings* conf = StelApp::getInstance().getSettings();
-	Q_ASSERT(conf);
+	// A previous loading which failed in the background may have left some catalogues loaded
+	if (maxGeodesicGridLevel>=0)
+		clearData();
 
 	starConfigFileFullPath = StelFileMgr::findFile("stars/default/starsConfig.json", StelFileMgr::Flags(StelFileMgr::Writable|StelFileMgr::File));
 	if (starConfigFileFullPath.isEmpty())
@@ -431,8 +428,19 @@ void StarMgr::init()
 	}
 
 	loadData(starSettings);
-
 	populateStarsDesignations();
+	moduleDataLoaded = true;
+}
+
+void StarMgr::init()
+{
+	QSettings* conf = StelApp::getInstance().getSettings();
+	Q_ASSERT(conf);
+
+	// The data is loaded in the background at startup, unless the module is initialized on its own
+	if (!moduleDataLoaded)
+		loadModuleData();
+
 	populateHipparcosLists();
 
 	setFontSize(StelApp::getInstance().getScreenFontSize());
@@ -620,6 +628,7 @@ void StarMgr::loadData(QVariantMap starsConfig)
 	}
 	for (auto* z : gridLevels)
 		z->updateHipIndex(hipIndex);
+	variableZoneShiftsDirty = true;
 
 	const QString cat_hip_sp_file_name = starsConfig.value("hipSpectralFile").toString();
 	if (cat_hip_sp_file_name.isEmpty())
@@ -653,6 +662,26 @@ void StarMgr::loadData(QVariantMap starsConfig)
 	qDebug() << "Finished loading star catalogue data, max_geodesic_level: " << maxGeodesicGridLevel;	
 }
 
+void StarMgr::clearData()
+{
+	for (auto* z : gridLevels)
+		delete z;
+	gridLevels.clear();
+	maxGeodesicGridLevel = -1;
+	lastMaxSearchLevel = -1;
+	catalogsDescription.clear();
+	for (int i=0; i<=NR_OF_HIP; i++)
+	{
+		hipIndex[i].a = Q_NULLPTR;
+		hipIndex[i].z = Q_NULLPTR;
+		hipIndex[i].s = Q_NULLPTR;
+	}
+	variableZoneShifts.clear();
+	variableZoneShiftsDirty = true;
+	spectral_array.clear();
+	component_array.clear();
+}
+
 void StarMgr::populateHipparcosLists()
 {
 	hipparcosStars.clear();
@@ -886,269 +915,6 @@ void StarMgr::loadSciNames(const QString& sciNameFile)
 	qDebug() << "Loaded" << readOk << "/" << totalRecords << "scientific star names";
 }
 
-// Load GCVS from file
-void StarMgr::loadGcvs(const QString& GcvsFile)
-{
-	varStarsMapI18n.clear();
-	varStarsIndexI18n.clear();
-
-	qDebug() << "Loading variable stars from" << QDir::toNativeSeparators(GcvsFile);
-	QFile vsFile(GcvsFile);
-	if (!vsFile.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qWarning() << "WARNING - could not open" << QDir::toNativeSeparators(GcvsFile);
-		return;
-	}
-	const QStringList& allRecords = QString::fromUtf8(vsFile.readAll()).split('\n');
-	vsFile.close();
-
-	int readOk=0;
-	int totalRecords=0;
-	int lineNumber=0;
-
-	// record structure is delimited with a tab character.
-	for (const auto& record : allRecords)
-	{
-		++lineNumber;
-		// skip comments and empty lines
-		if (record.startsWith("//") || record.startsWith("#") || record.isEmpty())
-			continue;
-
-		++totalRecords;
-		const QStringList& fields = record.split('\t');
-
-		bool ok;
-		int hip = fields.at(0).toInt(&ok);
-		if (!ok)
-		{
-			qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(GcvsFile)
-				   << " - failed to convert " << fields.at(0) << "to a number";
-			continue;
-		}
-
-		// Don't set the star if it's already set
-		if (varStarsMapI18n.find(hip)!=varStarsMapI18n.end())
-			continue;
-
-		varstar variableStar;
-
-		variableStar.designation = fields.at(1).trimmed();
-		variableStar.vtype = fields.at(2).trimmed();
-		if (fields.at(3).isEmpty())
-			variableStar.maxmag = 99.f;
-		else
-			variableStar.maxmag = fields.at(3).toFloat();
-		variableStar.mflag = fields.at(4).toInt();
-		if (fields.at(5).isEmpty())
-			variableStar.min1mag = 99.f;
-		else
-			variableStar.min1mag = fields.at(5).toFloat();
-		if (fields.at(6).isEmpty())
-			variableStar.min2mag = 99.f;
-		else
-			variableStar.min2mag = fields.at(6).toFloat();
-		variableStar.photosys = fields.at(7).trimmed();
-		variableStar.epoch = fields.at(8).toDouble();
-		variableStar.period = fields.at(9).toDouble();
-		variableStar.Mm = fields.at(10).toInt();
-		variableStar.stype = fields.at(11).trimmed();
-
-		varStarsMapI18n[hip] = variableStar;
-		varStarsIndexI18n[variableStar.designation.toUpper()] = hip;
-		++readOk;
-	}
-
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "variable stars";
-}
-
-// Load WDS from file
-void StarMgr::loadWds(const QString& WdsFile)
-{
-	wdsStarsMapI18n.clear();
-	wdsStarsIndexI18n.clear();
-
-	qDebug() << "Loading double stars from" << QDir::toNativeSeparators(WdsFile);
-	QFile dsFile(WdsFile);
-	if (!dsFile.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qWarning() << "WARNING - could not open" << QDir::toNativeSeparators(WdsFile);
-		return;
-	}
-	const QStringList& allRecords = QString::fromUtf8(dsFile.readAll()).split('\n');
-	dsFile.close();
-
-	int readOk=0;
-	int totalRecords=0;
-	int lineNumber=0;
-
-	// record structure is delimited with a tab character.
-	for (const auto& record : allRecords)
-	{
-		++lineNumber;
-		// skip comments and empty lines
-		if (record.startsWith("//") || record.startsWith("#") || record.isEmpty())
-			continue;
-
-		++totalRecords;
-		const QStringList& fields = record.split('\t');
-
-		bool ok;
-		int hip = fields.at(0).toInt(&ok);
-		if (!ok)
-		{
-			qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(WdsFile)
-				   << " - failed to convert " << fields.at(0) << "to a number";
-			continue;
-		}
-
-		// Don't set the star if it's already set
-		if (wdsStarsMapI18n.find(hip)!=wdsStarsMapI18n.end())
-			continue;
-
-		wds doubleStar;
-
-		doubleStar.designation = fields.at(1).trimmed();
-		doubleStar.observation = fields.at(2).toInt();
-		doubleStar.positionAngle = fields.at(3).toFloat();
-		doubleStar.separation = fields.at(4).toFloat();
-
-		wdsStarsMapI18n[hip] = doubleStar;
-		wdsStarsIndexI18n[QString("WDS J%1").arg(doubleStar.designation.toUpper())] = hip;
-		++readOk;
-	}
-
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "double stars";
-}
-
-// Load cross-identification data from file
-void StarMgr::loadCrossIdentificationData(const QString& crossIdFile)
-{
-	crossIdMap.clear();
-	saoStarsIndex.clear();	
-	hdStarsIndex.clear();	
-	hrStarsIndex.clear();
-
-	qDebug() << "Loading cross-identification data from" << QDir::toNativeSeparators(crossIdFile);
-	QFile ciFile(crossIdFile);
-	if (!ciFile.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qWarning() << "WARNING - could not open" << QDir::toNativeSeparators(crossIdFile);
-		return;
-	}
-	const QStringList& allRecords = QString::fromUtf8(ciFile.readAll()).split('\n');
-	ciFile.close();
-
-	crossid crossIdData;
-
-	int readOk=0;
-	int totalRecords=0;
-	int lineNumber=0;
-	// record structure is delimited with a 'tab' character. Example record strings:
-	// "1	128522	224700"
-	// "2	165988	224690"
-	for (const auto& record : allRecords)
-	{
-		++lineNumber;
-		// skip comments and empty lines
-		if (record.startsWith("//") || record.startsWith("#") || record.isEmpty())
-			continue;
-
-		++totalRecords;
-		const QStringList& fields = record.split('\t');
-		if (fields.size()!=5)
-		{
-			qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(crossIdFile)
-				   << " - record does not match record pattern";
-			continue;
-		}
-		else
-		{
-			// The record is the right format.  Extract the fields
-			bool ok;
-			int hip = fields.at(0).toInt(&ok);
-			if (!ok)
-			{
-				qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(crossIdFile)
-					   << " - failed to convert " << fields.at(0) << "to a number";
-				continue;
-			}
-
-			QString hipstar = QString("%1%2").arg(hip).arg(fields.at(1).trimmed());
-			crossIdData.sao = fields.at(2).toInt(&ok);
-			crossIdData.hd = fields.at(3).toInt(&ok);
-			crossIdData.hr = fields.at(4).toInt(&ok);
-
-			crossIdMap[hipstar] = crossIdData;
-			if (crossIdData.sao>0)
-				saoStarsIndex[crossIdData.sao] = hip;
-			if (crossIdData.hd>0)
-				hdStarsIndex[crossIdData.hd] = hip;
-			if (crossIdData.hr>0)
-				hrStarsIndex[crossIdData.hr] = hip;
-
-			++readOk;
-		}
-	}
-
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "cross-identification data records for stars";
-}
-
-void StarMgr::loadPlxErr(const QString& plxErrFile)
-{
-	// TODO: This is temporary solution for display parallax errors until format of stars catalogs will not be changed!
-	hipParallaxErrors.clear();
-
-	qDebug() << "Loading parallax errors data from" << QDir::toNativeSeparators(plxErrFile);
-	QFile ciFile(plxErrFile);
-	if (!ciFile.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		qWarning() << "WARNING - could not open" << QDir::toNativeSeparators(plxErrFile);
-		return;
-	}
-	const QStringList& allRecords = QString::fromUtf8(ciFile.readAll()).split('\n');
-	ciFile.close();
-
-	int readOk=0;
-	int totalRecords=0;
-	int lineNumber=0;
-	// record structure is delimited with a 'tab' character. Example record strings:
-	// "1	0.0606"
-	// "2	0.3193"
-	for (const auto& record : allRecords)
-	{
-		++lineNumber;
-		// skip comments and empty lines
-		if (record.startsWith("//") || record.startsWith("#") || record.isEmpty())
-			continue;
-
-		++totalRecords;
-		const QStringList& fields = record.split('\t');
-		if (fields.size()!=2)
-		{
-			qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(plxErrFile)
-				   << " - record does not match record pattern";
-			continue;
-		}
-		else
-		{
-			// The record is the right format.  Extract the fields
-			bool ok;
-			int hip = fields.at(0).toInt(&ok);
-			if (!ok)
-			{
-				qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(plxErrFile)
-					   << " - failed to convert " << fields.at(0) << "to a number";
-				continue;
-			}
-			hipParallaxErrors[hip] = fields.at(1).toFloat(&ok);
-
-			++readOk;
-		}
-	}
-
-	qDebug() << "Loaded" << readOk << "/" << totalRecords << "parallax error data records for stars";
-}
-
 int StarMgr::getMaxSearchLevel() const
 {
 	int rval = -1;
@@ -1383,27 +1149,27 @@ StelObjectP StarMgr::searchByNameI18n(const QString& nameI18n) const
 	QRegExp rx2("^\\s*(SAO)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx2.exactMatch(objw))
 	{
-		auto sao = saoStarsIndex.find(rx2.capturedTexts().at(2).toInt());
-		if (sao!=saoStarsIndex.end())
-			return searchHP(sao.value());
+		const int sao = starMetadata.searchSao(rx2.capturedTexts().at(2).toInt());
+		if (sao>0)
+			return searchHP(sao);
 	}
 
 	// Search by HD number if it's an HD formatted number
 	QRegExp rx3("^\\s*(HD)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx3.exactMatch(objw))
 	{
-		auto hd = hdStarsIndex.find(rx3.capturedTexts().at(2).toInt());
-		if (hd!=hdStarsIndex.end())
-			return searchHP(hd.value());
+		const int hd = starMetadata.searchHd(rx3.capturedTexts().at(2).toInt());
+		if (hd>0)
+			return searchHP(hd);
 	}
 
 	// Search by HR number if it's an HR formatted number
 	QRegExp rx4("^\\s*(HR)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx4.exactMatch(objw))
 	{
-		auto hr = hrStarsIndex.find(rx4.capturedTexts().at(2).toInt());
-		if (hr!=hrStarsIndex.end())
-			return searchHP(hr.value());
+		const int hr = starMetadata.searchHr(rx4.capturedTexts().at(2).toInt());
+		if (hr>0)
+			return searchHP(hr);
 	}
 
 	// Search by I18n common name
@@ -1440,17 +1206,17 @@ StelObjectP StarMgr::searchByNameI18n(const QString& nameI18n) const
 
 
 	// Search by GCVS name
-	auto it4 = varStarsIndexI18n.find(objw);
-	if (it4!=varStarsIndexI18n.end())
+	const int gcvsHip = starMetadata.searchGcvs(objw);
+	if (gcvsHip>0)
 	{
-		return searchHP(it4.value());
+		return searchHP(gcvsHip);
 	}
 
 	// Search by WDS name
-	auto wdsIt = wdsStarsIndexI18n.find(objw);
-	if (wdsIt!=wdsStarsIndexI18n.end())
+	const int wdsHip = starMetadata.searchWds(objw);
+	if (wdsHip>0)
 	{
-		return searchHP(wdsIt.value());
+		return searchHP(wdsHip);
 	}
 
 	return StelObjectP();
@@ -1472,27 +1238,27 @@ StelObjectP StarMgr::searchByName(const QString& name) const
 	QRegExp rx2("^\\s*(SAO)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx2.exactMatch(objw))
 	{
-		auto sao = saoStarsIndex.find(rx2.capturedTexts().at(2).toInt());
-		if (sao!=saoStarsIndex.end())
-			return searchHP(sao.value());
+		const int sao = starMetadata.searchSao(rx2.capturedTexts().at(2).toInt());
+		if (sao>0)
+			return searchHP(sao);
 	}
 
 	// Search by HD number if it's an HD formated number
 	QRegExp rx3("^\\s*(HD)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx3.exactMatch(objw))
 	{
-		auto hd = hdStarsIndex.find(rx3.capturedTexts().at(2).toInt());
-		if (hd!=hdStarsIndex.end())
-			return searchHP(hd.value());
+		const int hd = starMetadata.searchHd(rx3.capturedTexts().at(2).toInt());
+		if (hd>0)
+			return searchHP(hd);
 	}
 
 	// Search by HR number if it's an HR formated number
 	QRegExp rx4("^\\s*(HR)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx4.exactMatch(objw))
 	{
-		auto hr = hrStarsIndex.find(rx4.capturedTexts().at(2).toInt());
-		if (hr!=hrStarsIndex.end())
-			return searchHP(hr.value());
+		const int hr = starMetadata.searchHr(rx4.capturedTexts().at(2).toInt());
+		if (hr>0)
+			return searchHP(hr);
 	}
 
 	// Search by English common name
@@ -1656,17 +1422,10 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	}
 
 	// Search for sci names for var stars
-	for (auto it = varStarsIndexI18n.lowerBound(objw); it != varStarsIndexI18n.end(); ++it)
+	for (int hip : starMetadata.listGcvsByPrefix(objw, maxNbItem))
 	{
-		if (it.key().startsWith(objw))
-		{
-			if (maxNbItem<=0)
-				break;
-			result << getGcvsName(it.value());
-			--maxNbItem;
-		}
-		else
-			break;
+		result << getGcvsName(hip);
+		--maxNbItem;
 	}
 
 	// Add exact Hp catalogue numbers
@@ -1694,10 +1453,10 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	{
 		bool ok;
 		int saoNum = saoRx.capturedTexts().at(2).toInt(&ok);
-		auto sao = saoStarsIndex.find(saoNum);
-		if (sao!=saoStarsIndex.end())
+		const int sao = starMetadata.searchSao(saoNum);
+		if (sao>0)
 		{
-			StelObjectP s = searchHP(sao.value());
+			StelObjectP s = searchHP(sao);
 			if (s && maxNbItem>0)
 			{
 				result << QString("SAO%1").arg(saoNum);
@@ -1713,10 +1472,10 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	{
 		bool ok;
 		int hdNum = hdRx.capturedTexts().at(2).toInt(&ok);
-		auto hd = hdStarsIndex.find(hdNum);
-		if (hd!=hdStarsIndex.end())
+		const int hd = starMetadata.searchHd(hdNum);
+		if (hd>0)
 		{
-			StelObjectP s = searchHP(hd.value());
+			StelObjectP s = searchHP(hd);
 			if (s && maxNbItem>0)
 			{
 				result << QString("HD%1").arg(hdNum);
@@ -1732,10 +1491,10 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	{
 		bool ok;
 		int hrNum = hrRx.capturedTexts().at(2).toInt(&ok);
-		auto hr = hrStarsIndex.find(hrNum);
-		if (hr!=hrStarsIndex.end())
+		const int hr = starMetadata.searchHr(hrNum);
+		if (hr>0)
 		{
-			StelObjectP s = searchHP(hr.value());
+			StelObjectP s = searchHP(hr);
 			if (s && maxNbItem>0)
 			{
 				result << QString("HR%1").arg(hrNum);
@@ -1750,17 +1509,10 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	wdsRx.setCaseSensitivity(Qt::CaseInsensitive);
 	if (wdsRx.exactMatch(objw))
 	{
-		for (auto wds = wdsStarsIndexI18n.lowerBound(objw); wds != wdsStarsIndexI18n.end(); ++wds)
+		for (int hip : starMetadata.listWdsByPrefix(objw, maxNbItem))
 		{
-			if (wds.key().startsWith(objw))
-			{
-				if (maxNbItem==0)
-					break;
-				result << getWdsName(wds.value());
-				--maxNbItem;
-			}
-			else
-				break;
+			result << getWdsName(hip);
+			--maxNbItem;
 		}
 	}
 
@@ -1810,29 +1562,77 @@ void StarMgr::populateStarsDesignations()
 	else
 		loadSciNames(fic);
 
-	fic = StelFileMgr::findFile("stars/default/gcvs_hip_part.dat");
-	if (fic.isEmpty())
-		qWarning() << "WARNING: could not load variable stars file: stars/default/gcvs_hip_part.dat";
-	else
-		loadGcvs(fic);
+	loadStarMetadata();
+}
 
-	fic = StelFileMgr::findFile("stars/default/wds_hip_part.dat");
-	if (fic.isEmpty())
-		qWarning() << "WARNING: could not load double stars file: stars/default/wds_hip_part.dat";
+void StarMgr::loadStarMetadata()
+{
+	QStringList files;
+	static const char* fileNames[] = {"gcvs_hip_part.dat", "wds_hip_part.dat", "cross-id.dat", "hip_plx_err.dat"};
+	static const char* descriptions[] = {"variable stars", "double stars", "cross-identification data", "parallax errors data"};
+	for (int i=0; i<4; ++i)
+	{
+		const QString fileName = QString("stars/default/%1").arg(fileNames[i]);
+		const QString fic = StelFileMgr::findFile(fileName);
+		if (fic.isEmpty())
+			qWarning() << "WARNING: could not load" << descriptions[i] << "file:" << fileName;
+		files << fic;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	const QString storeFile = StelFileMgr::getCacheDir() + "/stars/starMetadata.bin";
+	if (!starMetadata.open(storeFile, files.at(0), files.at(1), files.at(2), files.at(3)))
+		qWarning() << "WARNING: could not load the star metadata";
 	else
-		loadWds(fic);
+		qDebug() << (starMetadata.wasCompiled() ? "Compiled" : "Mapped") << "star metadata" << QDir::toNativeSeparators(storeFile)
+			 << "in" << timer.elapsed() << "ms";
 
-	fic = StelFileMgr::findFile("stars/default/cross-id.dat");
-	if (fic.isEmpty())
-		qWarning() << "WARNING: could not load cross-identification data file: stars/default/cross-id.dat";
-	else
-		loadCrossIdentificationData(fic);
+	loadVariableStars();
+}
 
-	fic = StelFileMgr::findFile("stars/default/hip_plx_err.dat");
-	if (fic.isEmpty())
-		qWarning() << "WARNING: could not load parallax errors data file: stars/default/hip_plx_err.dat";
-	else
-		loadPlxErr(fic);
+void StarMgr::loadVariableStars()
+{
+	variableStars.clear();
+	variableStarsHip.clear();
+	variableMagShifts.fill(0, NR_OF_HIP+1);
+	for (int i=0; i<starMetadata.getGcvsCount(); ++i)
+	{
+		const StarMetadata::GcvsRecord* vs = starMetadata.getGcvs(i);
+		// The GCVS epochs are given as JD-2400000
+		const int index = variableStars.addGcvsCurve(starMetadata.getString(vs->vtype), vs->maxmag, vs->mflag, vs->min1mag, vs->min2mag,
+							     vs->epoch>0. ? 2400000.+vs->epoch : 0., vs->period, vs->Mm);
+		if (index>=0)
+			variableStarsHip.append(static_cast<int>(vs->hip));
+	}
+	qDebug() << "Compiled the light curves of" << variableStars.size() << "periodic variable stars";
+}
+
+void StarMgr::update(double deltaTime)
+{
+	labelsFader.update(static_cast<int>(deltaTime*1000));
+	starsFader.update(static_cast<int>(deltaTime*1000));
+
+	// The variable stars are drawn with their catalog magnitude shifted by the current variation from their mean magnitude
+	if (!variableStars.update(StelApp::getInstance().getCore()->getJDE()) && !variableZoneShiftsDirty)
+		return;
+	variableZoneShifts.clear();
+	variableZoneShiftsDirty = false;
+	for (int i=0; i<variableStars.size(); ++i)
+	{
+		const int hip = variableStarsHip.at(i);
+		if (hip<=0 || hip>NR_OF_HIP)
+			continue;
+		const float shift = variableStars.getMagnitude(i) - variableStars.getLightCurve(i).meanMag;
+		const qint16 mshift = static_cast<qint16>(qBound(-32000, qRound(shift*1000.f), 32000));
+		variableMagShifts[hip] = mshift;
+		// Keep the largest brightening of each zone, see getVariableZoneShift()
+		if (mshift<0 && hipIndex[hip].z)
+		{
+			qint16& zoneShift = variableZoneShifts[hipIndex[hip].z];
+			zoneShift = qMin(zoneShift, mshift);
+		}
+	}
 }
 
 QStringList StarMgr::listAllObjects(bool inEnglish) const
@@ -27,6 +27,7 @@
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "StelProjectorType.hpp"
+#include "StelPhotometry.hpp"
 
 class StelObject;
 class StelToneReproducer;
@@ -35,40 +36,12 @@ class StelPainter;
 class QSettings;
 
 class ZoneArray;
+class StarMetadata;
 struct HipIndexStruct;
+struct ZoneData;
 
 static const int RCMAG_TABLE_SIZE = 4096;
 
-typedef struct
-{
-	QString designation;	//! GCVS designation
-	QString vtype;		//! Type of variability
-	float maxmag;		//! Magnitude at maximum brightness
-	int mflag;		//! Magnitude flag code
-	float min1mag;		//! First minimum magnitude or amplitude
-	float min2mag;		//! Second minimum magnitude or amplitude
-	QString photosys;	//! The photometric system for magnitudes
-	double epoch;		//! Epoch for maximum light (Julian days)
-	double period;		//! Period of the variable star (days)
-	int Mm;			//! Rising time or duration of eclipse (%)
-	QString stype;		//! Spectral type
-} varstar;
-
-typedef struct
-{
-	QString designation;	//! WDS designation
-	int observation;	//! Date of last satisfactory observation, yr
-	float positionAngle;	//! Position Angle at date of last satisfactory observation, deg
-	float separation;	//! Separation at date of last satisfactory observation, arcsec
-} wds;
-
-typedef struct
-{
-	int sao;
-	int hd;
-	int hr;
-} crossid;
-
 typedef QMap<StelObjectP, float> StelACStarData;
 
 //! @class StarMgr
@@ -130,12 +103,17 @@ public:
 	//! - Sets various display flags from the ini parser object
 	virtual void init();
 
+	//! Read the star catalogues and the star names and designations files.
+	//! Called in a worker thread before init() at startup, or by init() itself.
+	virtual void loadModuleData();
+
 	//! Draw the stars and the star selection indicator if necessary.
 	virtual void draw(StelCore* core);
 
 	//! Update any time-dependent features.
-	//! Includes fading in and out stars and labels when they are turned on and off.
-	virtual void update(double deltaTime) {labelsFader.update(static_cast<int>(deltaTime*1000)); starsFader.update(static_cast<int>(deltaTime*1000));}
+	//! Includes fading in and out stars and labels when they are turned on and off,
+	//! and the current brightness of the periodic variable stars.
+	virtual void update(double deltaTime);
 
 	//! Used to determine the order in which the various StelModules are drawn.
 	virtual double getCallOrder(StelModuleActionName actionName) const;
@@ -323,6 +301,30 @@ public:
 	//! @return the rising time or duration of eclipse for variable star
 	static int getGcvsMM(int hip);
 
+	//! Get the difference between the current magnitude of a periodic variable star and its mean magnitude,
+	//! computed once per frame from its GCVS light curve.
+	//! @param hip The Hipparcos number of star
+	//! @return the magnitude to add to the catalog magnitude, 0 for the other stars
+	static float getVariableMagnitudeShift(int hip)
+	{
+		return (hip>0 && hip<variableMagShifts.size()) ? 0.001f*variableMagShifts.at(hip) : 0.f;
+	}
+
+	//! Get the current magnitude shifts of the periodic variable stars in millimagnitudes, indexed by HIP number.
+	//! @return Q_NULLPTR before the star metadata is loaded
+	static const qint16* getVariableMagShifts()
+	{
+		return variableMagShifts.isEmpty() ? Q_NULLPTR : variableMagShifts.constData();
+	}
+
+	//! Get the largest brightening of the periodic variable stars of a zone, i.e. the most negative magnitude shift.
+	//! The stars of a zone are sorted by catalog magnitude, so the magnitude cutoff must be extended by this shift.
+	//! @return the shift in millimagnitudes, 0 when no variable star of the zone is brighter than its mean magnitude
+	static int getVariableZoneShift(const ZoneData* zone)
+	{
+		return variableZoneShifts.value(zone, 0);
+	}
+
 	//! Get year of last satisfactory observation of double star with a
 	//! Hipparcos catalogue number.
 	//! @param hip The Hipparcos number of star
@@ -396,21 +398,12 @@ private:
 	//! @param the path to a file containing the scientific names for bright stars.
 	void loadSciNames(const QString& sciNameFile);
 
-	//! Loads GCVS from a file.
-	//! @param the path to a file containing the GCVS.
-	void loadGcvs(const QString& GcvsFile);
+	//! Opens the compiled store of the GCVS, WDS, cross-identification and parallax error data,
+	//! compiling it from the text files of the stars directory if needed.
+	void loadStarMetadata();
 
-	//! Loads WDS from a file.
-	//! @param the path to a file containing the WDS.
-	void loadWds(const QString& WdsFile);
-
-	//! Loads cross-identification data from a file.
-	//! @param the path to a file containing the cross-identification data.
-	void loadCrossIdentificationData(const QString& crossIdFile);
-
-	//! Loads parallax error data from a file.
-	//! @param the path to a file containing the parallax error data.
-	void loadPlxErr(const QString& plxErrFile);
+	//! Compile the light curves of the periodic variable stars of the GCVS.
+	void loadVariableStars();
 
 	//! Gets the maximum search level.
 	// TODO: add a non-lame description - what is the purpose of the max search level?
@@ -418,6 +411,8 @@ private:
 
 	//! Load all the stars from the files.
 	void loadData(QVariantMap starsConfigFile);
+	//! Delete the star catalogues loaded by loadData(), e.g. after it failed, so that it can be called again.
+	void clearData();
 
 	//! Draw a nice animated pointer around the object.
 	void drawPointer(StelPainter& sPainter, const StelCore* core);
@@ -438,6 +433,8 @@ private:
 
 	int maxGeodesicGridLevel;
 	int lastMaxSearchLevel;
+	//! True once loadModuleData() was called
+	bool moduleDataLoaded;
 	
 	// A ZoneArray per grid level
 	QVector<ZoneArray*> gridLevels;
@@ -473,18 +470,19 @@ private:
 	static QHash<int, QString> sciAdditionalNamesMapI18n;
 	static QMap<QString, int> sciAdditionalNamesIndexI18n;
 
-	static QHash<int, varstar> varStarsMapI18n;
-	static QMap<QString, int> varStarsIndexI18n;
-
-	static QHash<int, wds> wdsStarsMapI18n;
-	static QMap<QString, int> wdsStarsIndexI18n;
-
-	static QMap<QString, crossid> crossIdMap;
-	static QMap<int, int> saoStarsIndex;
-	static QMap<int, int> hdStarsIndex;
-	static QMap<int, int> hrStarsIndex;
-
-	static QHash<int, float> hipParallaxErrors;
+	//! GCVS, WDS, cross-identification and parallax error data
+	static StarMetadata starMetadata;
+
+	//! The light curves of the periodic variable stars
+	StelPhotometry variableStars;
+	//! The HIP number of the star of each light curve
+	QVector<int> variableStarsHip;
+	//! The current magnitude shift of each Hipparcos star in millimagnitudes, indexed by HIP number
+	static QVector<qint16> variableMagShifts;
+	//! The most negative magnitude shift of the variable stars of each zone in millimagnitudes
+	static QHash<const ZoneData*, qint16> variableZoneShifts;
+	//! Whether variableZoneShifts must be computed again because the catalogs changed
+	bool variableZoneShiftsDirty;
 
 	static QHash<int, QString> referenceMap;
 
@@ -87,7 +87,8 @@ protected:
 	float getVMagnitude(const StelCore* core) const
 	{
 		Q_UNUSED(core);
-		return 0.001f*a->mag_min + s->getMag()*(0.001f*a->mag_range)/a->mag_steps;
+		// Variable stars are shown with their current magnitude
+		return 0.001f*a->mag_min + s->getMag()*(0.001f*a->mag_range)/a->mag_steps + StarMgr::getVariableMagnitudeShift(s->getHip());
 	}
 	float getBV(void) const {return s->getBV();}
 	QString getEnglishName(void) const {return QString();}
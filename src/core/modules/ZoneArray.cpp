@@ -23,6 +23,7 @@
 #include "StelGeodesicGrid.hpp"
 #include "StelObject.hpp"
 #include "StelPainter.hpp"
+#include "StarMgr.hpp"
 
 #include <QDebug>
 #include <QFile>
@@ -432,20 +433,38 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 			cutoffMagStep = limitMagIndex;
 	}
 	Q_ASSERT(cutoffMagStep<RCMAG_TABLE_SIZE);
+
+	// Current magnitude shifts of the periodic variable stars, indexed by HIP number
+	const qint16* variableMagShifts = StarMgr::getVariableMagShifts();
     
 	// Go through all stars, which are sorted by magnitude (bright stars first)
 	const SpecialZoneData<Star>* zoneToDraw = getZones() + index;
 	const Star* lastStar = zoneToDraw->getStars() + zoneToDraw->size;
+
+	// The stars are sorted by catalog magnitude: a variable star currently brighter than its mean magnitude
+	// can come after the cutoff, so the sorted scan goes on by the largest brightening of the zone.
+	int catalogCutoffMagStep = cutoffMagStep;
+	if (variableMagShifts)
+		catalogCutoffMagStep += static_cast<int>(std::ceil(-0.001f*StarMgr::getVariableZoneShift(zoneToDraw)/k));
+
 	for (const Star* s=zoneToDraw->getStars();s<lastStar;++s)
 	{
 		// Artifical cutoff per magnitude
-		if (s->getMag() > cutoffMagStep)
+		if (s->getMag() > catalogCutoffMagStep)
 			break;
     
-		// Because of the test above, the star should always be visible from this point.
-		
+		// The catalog magnitude of a variable star is shifted to its current brightness
+		int magIndex = s->getMag();
+		if (variableMagShifts && s->getHip())
+		{
+			magIndex += static_cast<int>(0.001f*variableMagShifts[s->getHip()]/k);
+			magIndex = qBound(0, magIndex, RCMAG_TABLE_SIZE-1);
+		}
+		if (magIndex > cutoffMagStep)
+			continue;
+
 		// Array of 2 numbers containing radius and magnitude
-		const RCMag* tmpRcmag = &rcmag_table[s->getMag()];
+		const RCMag* tmpRcmag = &rcmag_table[magIndex];
 		
 		// Get the star position from the array
 		s->getJ2000Pos(zoneToDraw, movementFactor, vf);
@@ -468,7 +487,7 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 				continue;
 		}
 
-		int extinctedMagIndex = s->getMag();
+		int extinctedMagIndex = magIndex;
 		float twinkleFactor=1.0f; // allow height-dependent twinkle.
 		if (withExtinction)
 		{
@@ -477,7 +496,7 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 			core->j2000ToAltAzInPlaceNoRefraction(&altAz);
 			float extMagShift=0.0f;
 			extinction.forward(altAz, &extMagShift);
-			extinctedMagIndex = s->getMag() + static_cast<int>(extMagShift/k);
+			extinctedMagIndex = magIndex + static_cast<int>(extMagShift/k);
 			if (extinctedMagIndex >= cutoffMagStep || extinctedMagIndex<0) // i.e., if extincted it is dimmer than cutoff or extinctedMagIndex is negative (missing star catalog), so remove
 				continue;
 			tmpRcmag = &rcmag_table[extinctedMagIndex];
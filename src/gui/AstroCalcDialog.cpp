@@ -28,6 +28,7 @@
 #include "StelFileMgr.hpp"
 #include "AngleSpinBox.hpp"
 #include "SolarSystem.hpp"
+#include "SolarEclipseSolver.hpp"
 #include "Planet.hpp"
 #include "NebulaMgr.hpp"
 #include "Nebula.hpp"
@@ -3893,14 +3894,30 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	PlanetP earth = solarSystem->getEarth();
 	PlanetP planet = core->getCurrentPlanet();
 	bool withDecimalDegree = StelApp::getInstance().getFlagShowDecimalDegrees();
+	const bool solarEclipseCandidate = (mode==PhenomenaTypeIndex::Conjuction && planet == earth && ((object1 == moon  && object2 == sun) || (object1 == sun  && object2 == moon)));
+	SolarEclipseSolver solarEclipseSolver(core);
 	for (it = list.constBegin(); it != list.constEnd(); ++it)
 	{
-		core->setJD(it.key());
+		double JD = it.key();
+		core->setJD(JD);
 		core->update(0);
 
 		QString phenomenType = q_("Conjunction");
 		double separation = it.value();
 		bool occultation = false;
+		LocalSolarEclipse solarEclipse;
+		if (solarEclipseCandidate)
+		{
+			// Local circumstances of a possible solar eclipse: list it at the time of greatest eclipse
+			solarEclipse = solarEclipseSolver.compute(JD);
+			if (solarEclipse.eclipse)
+			{
+				JD = solarEclipse.JDmax;
+				separation = solarEclipse.separation;
+				core->setJD(JD);
+				core->update(0);
+			}
+		}
 		const double s1 = object1->getSpheroidAngularSize(core);
 		const double s2 = object2->getSpheroidAngularSize(core);
 		const double d1 = object1->getJ2000EquatorialPos(core).length();
@@ -3944,6 +3961,12 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 			else
 				phenomenType = q_("Aphelion");
 		}
+		else if (solarEclipse.eclipse)
+		{
+			// TRANSLATORS: A solar eclipse which takes place while the Sun is below the horizon
+			phenomenType = solarEclipse.visible ? q_("Eclipse") : q_("Eclipse (below horizon)");
+			occultation = solarEclipse.central;
+		}
 		else if (separation < (s2 * M_PI / 180.) || separation < (s1 * M_PI / 180.))
 		{
 			if ((d1 < d2 && s1 <= s2) || (d1 > d2 && s1 > s2))
@@ -3954,13 +3977,13 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 			else
 				phenomenType = q_("Occultation");
 
-			// Added a special case - solar eclipse
-			if (qAbs(s1 - s2) <= 0.05 && (object1 == sun || object2 == sun)) // 5% error of difference of sizes
+			// Added a special case - solar eclipse seen from another planet
+			if (!solarEclipseCandidate && qAbs(s1 - s2) <= 0.05 && (object1 == sun || object2 == sun)) // 5% error of difference of sizes
 				phenomenType = q_("Eclipse");
 
 			occultation = true;
 		}
-		else if (qAbs(separation) <= 0.0087 && ((object1 == moon  && object2 == sun) || (object1 == sun  && object2 == moon))) // Added a special case - partial solar eclipse
+		else if (!solarEclipseCandidate && qAbs(separation) <= 0.0087 && ((object1 == moon  && object2 == sun) || (object1 == sun  && object2 == moon))) // Added a special case - partial solar eclipse
 		{
 			phenomenType = q_("Eclipse");
 		}
@@ -4054,7 +4077,7 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 			separationStr = dash;
 		}
 
-		fillPhenomenaTableVis(phenomenType, it.key(), object1->getNameI18n(), object1->getVMagnitude(core), nameObj2, magnitude, separationStr, elongStr, angDistStr, elongationInfo, angularDistanceInfo);
+		fillPhenomenaTableVis(phenomenType, JD, object1->getNameI18n(), object1->getVMagnitude(core), nameObj2, magnitude, separationStr, elongStr, angDistStr, elongationInfo, angularDistanceInfo);
 	}
 }
 
@@ -378,8 +378,8 @@ void ConfigurationDialog::createDialogContent()
 	ui->customScreenshotHeightLineEdit->hide();
 #else
 	connectBoolProperty(ui->useCustomScreenshotSizeCheckBox, "MainView.flagUseCustomScreenshotSize");
-	ui->customScreenshotWidthLineEdit->setValidator(new MinMaxIntValidator(128, 16384, this));
-	ui->customScreenshotHeightLineEdit->setValidator(new MinMaxIntValidator(128, 16384, this));
+	ui->customScreenshotWidthLineEdit->setValidator(new MinMaxIntValidator(128, 32768, this));
+	ui->customScreenshotHeightLineEdit->setValidator(new MinMaxIntValidator(128, 32768, this));
 	connectIntProperty(ui->customScreenshotWidthLineEdit, "MainView.customScreenshotWidth");
 	connectIntProperty(ui->customScreenshotHeightLineEdit, "MainView.customScreenshotHeight");
 #endif
@@ -32,7 +32,8 @@
 #include <QTextDocument>
 
 InfoPanel::InfoPanel(QGraphicsItem* parent) : QGraphicsTextItem("", parent),
-	infoPixmap(Q_NULLPTR)
+	infoPixmap(Q_NULLPTR),
+	lastFontSize(0)
 {
 	QSettings* conf = StelApp::getInstance().getSettings();
 	Q_ASSERT(conf);
@@ -165,6 +166,7 @@ void InfoPanel::setTextFromObjects(const QList<StelObjectP>& selected)
 {
 	if (selected.isEmpty())
 	{
+		lastInfoText.clear();
 		if (!document()->isEmpty())
 			document()->clear();
 		if (qApp->property("text_texture")==true) // CLI option -t given?
@@ -176,8 +178,13 @@ void InfoPanel::setTextFromObjects(const QList<StelObjectP>& selected)
 		// Must set lastRTS for currently selected object here...
 		StelCore *core=StelApp::getInstance().getCore();
 		QString s = selected[0]->getInfoString(core, infoTextFilters);
+		const int fontSize = StelApp::getInstance().getScreenFontSize();
+		if (s==lastInfoText && fontSize==lastFontSize)
+			return;
+		lastInfoText = s;
+		lastFontSize = fontSize;
 		QFont font;
-		font.setPixelSize(StelApp::getInstance().getScreenFontSize());
+		font.setPixelSize(fontSize);
 		setFont(font);
 		setHtml(s);
 		if (qApp->property("text_texture")==true) // CLI option -t given?
@@ -50,6 +50,9 @@ class InfoPanel : public QGraphicsTextItem
 	private:
 		StelObject::InfoStringGroup infoTextFilters;
 		QGraphicsPixmapItem *infoPixmap; // Used when text rendering is buggy. Used when CLI option -t given.
+		//! The last displayed text and font size, to avoid laying out the document again when nothing changed.
+		QString lastInfoText;
+		int lastFontSize;
 };
 
 //! The class managing the layout for button bars, selected object info and loading bars.
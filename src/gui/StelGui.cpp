@@ -74,6 +74,12 @@
 #include <QColor>
 #include <QAction>
 #include <QKeySequence>
+#include <QTimer>
+
+// Minimal interval between two refreshes of the info panel when only the time changed [ms]
+static const int INFO_PANEL_REFRESH_INTERVAL = 100;
+// Maximal interval between two refreshes of the info panel, for the changes which are not notified [ms]
+static const int INFO_PANEL_MAX_REFRESH_INTERVAL = 1000;
 
 StelGui::StelGui()
 	: topLevelGraphicsWidget(Q_NULLPTR)
@@ -128,6 +134,9 @@ StelGui::StelGui()
 	, flagShowAsterismLabelsButton(false)
 	, btShowAsterismLabels(Q_NULLPTR)
 	, initDone(false)
+	, timeButtonsTimer(Q_NULLPTR)
+	, flagInfoPanelDirty(true)
+	, infoPanelJD(0.)
 #ifndef DISABLE_SCRIPTING
 	  // We use a QStringList to save the user-configured buttons while script is running, and restore them later.
 	, scriptSaveSpeedbuttons()
@@ -461,6 +470,22 @@ void StelGui::init(QGraphicsWidget *atopLevelGraphicsWidget)
 	StelApp *app = &StelApp::getInstance();
 	connect(app, SIGNAL(languageChanged()), this, SLOT(updateI18n()));
 	connect(app, SIGNAL(colorSchemeChanged(const QString&)), this, SLOT(setStelStyle(const QString&)));
+
+	// The buttons bound to actions follow the state of their action, and the actions follow their properties through
+	// their NOTIFY signals, so only the time buttons and the info panel need to be updated from here, on change.
+	StelCore* core = app->getCore();
+	connect(core, SIGNAL(timeRateChanged(double)), this, SLOT(updateTimeButtons()));
+	connect(core, SIGNAL(timeSyncOccurred(double)), this, SLOT(updateTimeButtons()));
+	timeButtonsTimer = new QTimer(this);
+	timeButtonsTimer->setInterval(1000);
+	connect(timeButtonsTimer, SIGNAL(timeout()), this, SLOT(updateTimeButtons()));
+	timeButtonsTimer->start();
+	updateTimeButtons();
+
+	connect(GETSTELMODULE(StelObjectMgr), SIGNAL(selectedObjectChanged(StelModule::StelModuleSelectAction)), this, SLOT(setInfoPanelDirty()));
+	connect(app, SIGNAL(languageChanged()), this, SLOT(setInfoPanelDirty()));
+	connect(core, SIGNAL(locationChanged(const StelLocation&)), this, SLOT(setInfoPanelDirty()));
+	infoPanelTimer.start();
 	initDone = true;
 }
 
@@ -532,7 +557,7 @@ void StelGui::updateI18n()
 	}
 }
 
-void StelGui::update()
+void StelGui::updateTimeButtons()
 {
 	StelCore* core = StelApp::getInstance().getCore();
 	if (core->getTimeRate()<-0.99*StelCore::JD_SECOND) {
@@ -563,60 +588,21 @@ void StelGui::update()
 	if (static_cast<bool>(buttonTimeCurrent->isChecked())!=isTimeNow) {
 		buttonTimeCurrent->setChecked(isTimeNow);
 	}
-	StelMovementMgr* mmgr = GETSTELMODULE(StelMovementMgr);
-	const bool b = mmgr->getFlagTracking();
-	if (static_cast<bool>(buttonGotoSelectedObject->isChecked())!=b) {
-		buttonGotoSelectedObject->setChecked(b);
-	}
-
-	StelPropertyMgr* propMgr = StelApp::getInstance().getStelPropertyManager();
-	bool flag;
-
-	flag = propMgr->getProperty("StelSkyLayerMgr.flagShow")->getValue().toBool();
-	if (getAction("actionShow_DSO_Textures")->isChecked() != flag)
-		getAction("actionShow_DSO_Textures")->setChecked(flag);
-
-	flag = propMgr->getProperty("HipsMgr.flagShow")->getValue().toBool();
-	if (getAction("actionShow_Hips_Surveys")->isChecked() != flag)
-		getAction("actionShow_Hips_Surveys")->setChecked(flag);
-
-	flag = propMgr->getProperty("ToastMgr.surveyDisplayed")->getValue().toBool();
-	if (getAction("actionShow_Toast_Survey")->isChecked() != flag)
-		getAction("actionShow_Toast_Survey")->setChecked(flag);
-
-	flag = propMgr->getProperty("GridLinesMgr.equatorJ2000GridDisplayed")->getValue().toBool();
-	if (getAction("actionShow_Equatorial_J2000_Grid")->isChecked() != flag)
-		getAction("actionShow_Equatorial_J2000_Grid")->setChecked(flag);
-
-	flag = propMgr->getProperty("GridLinesMgr.galacticGridDisplayed")->getValue().toBool();
-	if (getAction("actionShow_Galactic_Grid")->isChecked() != flag)
-		getAction("actionShow_Galactic_Grid")->setChecked(flag);
-
-	flag = propMgr->getProperty("GridLinesMgr.eclipticGridDisplayed")->getValue().toBool();
-	if (getAction("actionShow_Ecliptic_Grid")->isChecked() != flag)
-		getAction("actionShow_Ecliptic_Grid")->setChecked(flag);
-
-	flag = propMgr->getProperty("ConstellationMgr.boundariesDisplayed")->getValue().toBool();
-	if (getAction("actionShow_Constellation_Boundaries")->isChecked() != flag)
-		getAction("actionShow_Constellation_Boundaries")->setChecked(flag);
-
-	flag = propMgr->getProperty("AsterismMgr.linesDisplayed")->getValue().toBool();
-	if (getAction("actionShow_Asterism_Lines")->isChecked() != flag)
-		getAction("actionShow_Asterism_Lines")->setChecked(flag);
-
-	flag = propMgr->getProperty("AsterismMgr.namesDisplayed")->getValue().toBool();
-	if (getAction("actionShow_Asterism_Labels")->isChecked() != flag)
-		getAction("actionShow_Asterism_Labels")->setChecked(flag);
-
-	flag = StelApp::getInstance().getVisionModeNight();
-	if (getAction("actionShow_Night_Mode")->isChecked() != flag)
-		getAction("actionShow_Night_Mode")->setChecked(flag);
-
-	flag = StelMainView::getInstance().isFullScreen();
-	if (getAction("actionSet_Full_Screen_Global")->isChecked() != flag)
-		getAction("actionSet_Full_Screen_Global")->setChecked(flag);
+}
 
-	skyGui->infoPanel->setTextFromObjects(GETSTELMODULE(StelObjectMgr)->getSelectedObject());
+void StelGui::update()
+{
+	// The info text depends on the time, so it is refreshed when the time changed, but at most a few times per second.
+	// Other changes are either notified (selection, location, language) or caught by a slow periodic refresh.
+	const double JD = StelApp::getInstance().getCore()->getJD();
+	if (flagInfoPanelDirty || infoPanelTimer.hasExpired(INFO_PANEL_MAX_REFRESH_INTERVAL)
+	    || (JD!=infoPanelJD && infoPanelTimer.hasExpired(INFO_PANEL_REFRESH_INTERVAL)))
+	{
+		skyGui->infoPanel->setTextFromObjects(GETSTELMODULE(StelObjectMgr)->getSelectedObject());
+		flagInfoPanelDirty = false;
+		infoPanelJD = JD;
+		infoPanelTimer.start();
+	}
 
 	// Check if the progressbar window changed, if yes update the whole view
 	if (savedProgressBarSize!=skyGui->progressBarMgr->boundingRect().size())
@@ -1185,6 +1171,7 @@ bool StelGui::isCurrentlyUsed() const
 void StelGui::setInfoTextFilters(const StelObject::InfoStringGroup& aflags)
 {
 	skyGui->infoPanel->setInfoTextFilters(aflags);
+	flagInfoPanelDirty = true;
 }
 
 const StelObject::InfoStringGroup& StelGui::getInfoTextFilters() const
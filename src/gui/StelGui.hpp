@@ -28,9 +28,11 @@
 #include "StelStyle.hpp"
 
 #include <QGraphicsTextItem>
+#include <QElapsedTimer>
 
 class QGraphicsSceneMouseEvent;
 class QTimeLine;
+class QTimer;
 class StelButton;
 class BottomStelBar;
 class InfoPanel;
@@ -275,6 +277,10 @@ private slots:
 	void quit();	
 	void updateI18n();
 	void copySelectedObjectInfo(void);
+	//! Update the checked state of the time buttons from the time rate and the current time.
+	void updateTimeButtons();
+	//! Request the info panel to be refreshed at the next update.
+	void setInfoPanelDirty() {flagInfoPanelDirty=true;}
 
 private:
 	//! convenience method to find an action in the StelActionMgr.
@@ -355,6 +361,15 @@ private:
 
 	QSizeF savedProgressBarSize;
 
+	//! Periodically check whether the time is still the current time, which changes without notification.
+	QTimer* timeButtonsTimer;
+	//! True when the info panel must be refreshed at the next update, e.g. after the selection changed.
+	bool flagInfoPanelDirty;
+	//! The JD for which the info panel was last refreshed.
+	double infoPanelJD;
+	//! Time since the last refresh of the info panel.
+	QElapsedTimer infoPanelTimer;
+
 	// Currently used StelStyle
 	StelStyle currentStelStyle;
 
@@ -96,6 +96,12 @@ StelMainScriptAPI::StelMainScriptAPI(QObject *parent) : QObject(parent)
 	connect(this, SIGNAL(requestSetVideoAlpha(const QString&, float)), StelApp::getInstance().getStelVideoMgr(), SLOT(setVideoAlpha(const QString&, float)));
 	connect(this, SIGNAL(requestResizeVideo(const QString&, float, float)), StelApp::getInstance().getStelVideoMgr(), SLOT(resizeVideo(const QString&, float, float)));
 	connect(this, SIGNAL(requestShowVideo(const QString&, bool)), StelApp::getInstance().getStelVideoMgr(), SLOT(showVideo(const QString&, bool)));
+	connect(this, SIGNAL(requestLoadSkyVideo(const QString&, const QString&, double, double)), StelApp::getInstance().getStelVideoMgr(), SLOT(loadSkyVideo(const QString&, const QString&, double, double)));
+	connect(this, SIGNAL(requestSetSkyVideoDome(const QString&, float, float)), StelApp::getInstance().getStelVideoMgr(), SLOT(setSkyVideoDome(const QString&, float, float)));
+	connect(this, SIGNAL(requestSetSkyVideoRect(const QString&, double, double, double, double, double)), StelApp::getInstance().getStelVideoMgr(), SLOT(setSkyVideoRect(const QString&, double, double, double, double, double)));
+	connect(this, SIGNAL(requestSetSkyVideoAlpha(const QString&, float)), StelApp::getInstance().getStelVideoMgr(), SLOT(setSkyVideoAlpha(const QString&, float)));
+	connect(this, SIGNAL(requestShowSkyVideo(const QString&, bool)), StelApp::getInstance().getStelVideoMgr(), SLOT(showSkyVideo(const QString&, bool)));
+	connect(this, SIGNAL(requestDropSkyVideo(const QString&)), StelApp::getInstance().getStelVideoMgr(), SLOT(dropSkyVideo(const QString&)));
 
 	connect(this, SIGNAL(requestExit()), this->parent(), SLOT(stopScript()));
 	connect(this, SIGNAL(requestSetProjectionMode(QString)), StelApp::getInstance().getCore(), SLOT(setCurrentProjectionTypeKey(QString)));
@@ -375,6 +381,23 @@ void StelMainScriptAPI::setProjectionMode(const QString& id)
 	emit(requestSetProjectionMode(id));
 }
 
+void StelMainScriptAPI::addCamera(const QString& ra, const QString& dec, double fov, int x, int y, int width, int height, const QString& projection)
+{
+	Vec3d viewDirectionJ2000;
+	StelUtils::spheToRect(StelUtils::getDecAngle(ra), StelUtils::getDecAngle(dec), viewDirectionJ2000);
+	StelApp::getInstance().getCore()->addCamera(viewDirectionJ2000, fov, x, y, width, height, projection);
+}
+
+void StelMainScriptAPI::clearCameras()
+{
+	StelApp::getInstance().getCore()->clearCameras();
+}
+
+int StelMainScriptAPI::getCameraCount()
+{
+	return StelApp::getInstance().getCore()->getCameraCount();
+}
+
 QStringList StelMainScriptAPI::getAllSkyCultureIDs()
 {
 	return StelApp::getInstance().getSkyCultureMgr().getSkyCultureListIDs();
@@ -389,6 +412,10 @@ void StelMainScriptAPI::setSkyCulture(const QString& id)
 {
 	GETSTELMODULE(StelObjectMgr)->unSelect(); // mistake-proofing!
 	emit(requestSetSkyCulture(id));
+	// The figures of the new sky culture may be loaded in the background: install them
+	// now so that the next statements of the script see the new sky culture.
+	GETSTELMODULE(ConstellationMgr)->finishSkyCultureLoading();
+	GETSTELMODULE(AsterismMgr)->finishSkyCultureLoading();
 }
 
 QString StelMainScriptAPI::getSkyCultureName()
@@ -650,6 +677,48 @@ qint64 StelMainScriptAPI::getVideoPosition(const QString& id)
 	return StelApp::getInstance().getStelVideoMgr()->getVideoPosition(id);
 }
 
+void StelMainScriptAPI::loadSkyVideo(const QString& filename, const QString& id, const QString& dateStr, double timeScale, const QString& spec)
+{
+	QString path = StelFileMgr::findFile("scripts/" + filename);
+	if (path.isEmpty())
+	{
+		qWarning() << "cannot load sky video" << QDir::toNativeSeparators(filename);
+		return;
+	}
+
+	emit(requestLoadSkyVideo(path, id, jdFromDateString(dateStr, spec), timeScale));
+}
+
+void StelMainScriptAPI::setSkyVideoDome(const QString& id, float fov, float rotation)
+{
+	emit(requestSetSkyVideoDome(id, fov, rotation));
+}
+
+void StelMainScriptAPI::setSkyVideoRect(const QString& id, double ra, double dec, double width, double height, double rotation)
+{
+	emit(requestSetSkyVideoRect(id, ra, dec, width, height, rotation));
+}
+
+void StelMainScriptAPI::setSkyVideoAlpha(const QString& id, float alpha)
+{
+	emit(requestSetSkyVideoAlpha(id, alpha));
+}
+
+void StelMainScriptAPI::showSkyVideo(const QString& id, bool show)
+{
+	emit(requestShowSkyVideo(id, show));
+}
+
+void StelMainScriptAPI::dropSkyVideo(const QString& id)
+{
+	emit(requestDropSkyVideo(id));
+}
+
+QVariantMap StelMainScriptAPI::getSkyVideoStatistics(const QString& id)
+{
+	return StelApp::getInstance().getStelVideoMgr()->getSkyVideoStatistics(id);
+}
+
 int StelMainScriptAPI::getScreenWidth()
 {
 	return StelMainView::getInstance().size().width();
@@ -453,6 +453,28 @@ public slots:
 	//! - ProjectionMiller
 	void setProjectionMode(const QString& id);
 
+	//! Add a camera, i.e. another view of the sky drawn in each frame on top of the main view, e.g. a finder view.
+	//! The camera is shown with north up. Several cameras can be added, each one costs another drawing pass of the sky.
+	//! @param ra the right ascension of the center of the camera in the J2000 frame, e.g. "5h35m17s"
+	//! @param dec the declination of the center of the camera in the J2000 frame, e.g. "-5d23m28s"
+	//! @param fov the field of view of the camera in degrees
+	//! @param x the horizontal position of the bottom left corner of the camera in the view in pixels
+	//! @param y the vertical position of the bottom left corner of the camera in the view in pixels
+	//! @param width the width of the camera in pixels
+	//! @param height the height of the camera in pixels
+	//! @param projection the projection mode of the camera, see setProjectionMode() for the valid values
+	//! @code
+	//! // A 5 degrees finder view on the Orion Nebula in the lower left corner
+	//! core.addCamera("5h35m17s", "-5d23m28s", 5, 10, 10, 300, 300);
+	//! @endcode
+	static void addCamera(const QString& ra, const QString& dec, double fov, int x, int y, int width, int height, const QString& projection="ProjectionStereographic");
+
+	//! Remove all the cameras added with addCamera()
+	static void clearCameras();
+
+	//! Get the number of cameras drawn in addition to the main view
+	static int getCameraCount();
+
 	//! Get the status of the disk viewport
 	//! @return true if the disk view port is currently enabled
 	static bool getDiskViewport();
@@ -482,6 +504,7 @@ public slots:
 
 	//! Set the current sky culture
 	//! @param id the ID of the sky culture to set, e.g. western or inuit etc.
+	//! @note The constellations and asterisms of the new sky culture are available when this returns.
 	void setSkyCulture(const QString& id);
 
 	//! Find out the current sky culture and get it English name
@@ -707,6 +730,48 @@ public slots:
 	//! @param id the identifier used when loadVideo() was called
 	static qint64 getVideoPosition(const QString& id);
 
+	//! Load a video or an image sequence to be shown on the sky, synchronized with the simulation time,
+	//! e.g. the time-lapse of an eclipse or the images of an all-sky camera.
+	//! The frames are shown as fisheye images around the zenith, use setSkyVideoRect() to place them in the sky.
+	//! @param filename a video file, a directory of images sorted by name, or a text file listing
+	//! one image per line preceded by its date (ISO 8601 in UTC, or JD).
+	//! @param id a string identifier for the sky video
+	//! @param dateStr the date of the first frame, in the format accepted by setDate()
+	//! @param timeScale simulated seconds per second of video, or between two images of a directory
+	//! @param spec "local" or "utc", see setDate()
+	void loadSkyVideo(const QString& filename, const QString& id, const QString& dateStr, double timeScale=1., const QString& spec="utc");
+
+	//! Show a sky video as fisheye images around the zenith.
+	//! @param id the identifier used when loadSkyVideo() was called
+	//! @param fov the field of view of the images in degrees
+	//! @param rotation the azimuth of the top of the images in degrees
+	void setSkyVideoDome(const QString& id, float fov=180.f, float rotation=0.f);
+
+	//! Show a sky video in a rectangle on the sky.
+	//! @param id the identifier used when loadSkyVideo() was called
+	//! @param ra, dec the J2000 coordinates of the center of the rectangle in degrees
+	//! @param width, height the angular size of the rectangle in degrees
+	//! @param rotation the position angle of the top of the frames in degrees
+	void setSkyVideoRect(const QString& id, double ra, double dec, double width, double height, double rotation=0.);
+
+	//! Set the opacity of a sky video.
+	//! @param id the identifier used when loadSkyVideo() was called
+	//! @param alpha opacity (0=transparent, ... 1=fully opaque)
+	void setSkyVideoAlpha(const QString& id, float alpha);
+
+	//! Show or hide a sky video.
+	//! @param id the identifier used when loadSkyVideo() was called
+	void showSkyVideo(const QString& id, bool show=true);
+
+	//! Remove a sky video.
+	//! @param id the identifier used when loadSkyVideo() was called
+	void dropSkyVideo(const QString& id);
+
+	//! Get the frame pacing statistics of a sky video: the number of rendered, decoded,
+	//! late and dropped frames and the draw, upload and decode times in milliseconds.
+	//! @param id the identifier used when loadSkyVideo() was called
+	static QVariantMap getSkyVideoStatistics(const QString& id);
+
 	//! Get the screen width in pixels.
 	//! @return The screen width (actually, width of Stellarium main view) in pixels
 	static int getScreenWidth();
@@ -872,6 +937,12 @@ signals:
 	void requestSetVideoAlpha(const QString& id, float alpha);
 	void requestResizeVideo(const QString& id, float w, float h);
 	void requestShowVideo(const QString& id, bool show);
+	void requestLoadSkyVideo(const QString& filename, const QString& id, double startJD, double timeScale);
+	void requestSetSkyVideoDome(const QString& id, float fov, float rotation);
+	void requestSetSkyVideoRect(const QString& id, double ra, double dec, double width, double height, double rotation);
+	void requestSetSkyVideoAlpha(const QString& id, float alpha);
+	void requestShowSkyVideo(const QString& id, bool show);
+	void requestDropSkyVideo(const QString& id);
 	
 	void requestSetProjectionMode(QString id);
 	void requestSetSkyCulture(QString id);
@@ -0,0 +1,183 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testIAUConstellationSpans.hpp"
+
+#include <QObject>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+
+#include <cmath>
+
+#include "IAUConstellationSpans.hpp"
+#include "StelFileMgr.hpp"
+#include "StelUtils.hpp"
+
+QTEST_GUILESS_MAIN(TestIAUConstellationSpans)
+
+void TestIAUConstellationSpans::initTestCase()
+{
+	StelFileMgr::init();
+	const QString fileName = StelFileMgr::findFile("data/constellations_spans.dat");
+	spans = new IAUConstellationSpans(fileName);
+	QVERIFY(spans->isValid());
+
+	// Read the spans again, for the expected values of the tests
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+	QTextStream in(&file);
+	while (!in.atEnd())
+	{
+		const QString line = in.readLine().trimmed();
+		if (line.isEmpty() || line.startsWith('#'))
+			continue;
+		const QStringList list = line.split(QRegExp("\\s+"));
+		if (list.count()!=4)
+			continue;
+		FileSpan span;
+		QStringList numList=list.at(0).split(":");
+		span.RAlow = numList.at(0).toDouble() + numList.at(1).toDouble()/60. + numList.at(2).toDouble()/3600.;
+		numList=list.at(1).split(":");
+		span.RAhigh = numList.at(0).toDouble() + numList.at(1).toDouble()/60. + numList.at(2).toDouble()/3600.;
+		numList=list.at(2).split(":");
+		span.decLow = numList.at(0).toDouble();
+		span.decLow += (numList.at(0).startsWith('-') ? -1. : 1.) * numList.at(1).toDouble()/60.;
+		span.constellation = list.at(3);
+		fileSpans << span;
+		constellations.insert(span.constellation);
+	}
+	QVERIFY(!fileSpans.isEmpty());
+}
+
+void TestIAUConstellationSpans::cleanupTestCase()
+{
+	delete spans;
+}
+
+void TestIAUConstellationSpans::testKnownPositions()
+{
+	// B1875 coordinates: RA [h], Dec [deg], constellation
+	QVariantList data;
+	data << 0.0  <<  90.0 << "UMi";
+	data << 0.0  << -90.0 << "Oct";
+	data << 5.5  <<  -1.0 << "Ori";
+	data << 18.5 << -30.0 << "Sgr";
+	data << 12.5 <<  -5.0 << "Vir";
+	data << 0.7  <<  41.0 << "And";
+	// Bright stars far from the constellation borders, precessed to B1875
+	data << 6.659  << -16.588 << "CMa"; // Sirius
+	data << 18.546 <<  38.678 << "Lyr"; // Vega
+	data << 5.807  <<   7.382 << "Ori"; // Betelgeuse
+	data << 4.479  <<  16.249 << "Tau"; // Aldebaran
+	data << 16.362 << -26.153 << "Sco"; // Antares
+	data << 13.310 << -10.509 << "Vir"; // Spica
+	data << 14.163 <<  19.765 << "Boo"; // Arcturus
+	data << 20.620 <<  44.834 << "Cyg"; // Deneb
+	data << 19.746 <<   8.553 << "Aql"; // Altair
+	data << 22.847 << -30.290 << "PsA"; // Fomalhaut
+	data << 10.028 <<  12.578 << "Leo"; // Regulus
+	data << 5.125  <<  45.854 << "Aur"; // Capella
+	data << 7.544  <<   5.508 << "CMi"; // Procyon
+	data << 7.626  <<  28.324 << "Gem"; // Pollux
+	data << 1.221  <<  88.643 << "UMi"; // Polaris
+	data << 10.933 <<  62.423 << "UMa"; // Dubhe
+	data << 9.357  <<  -8.117 << "Hya"; // Alphard
+	data << 2.003  <<  22.865 << "Ari"; // Hamal
+	data << 0.557  <<  55.850 << "Cas"; // Schedar
+	data << 3.257  <<  49.413 << "Per"; // Mirfak
+	data << 17.895 <<  51.504 << "Dra"; // Eltanin
+	data << 22.976 <<  14.532 << "Peg"; // Markab
+	data << 0.622  << -18.672 << "Cet"; // Diphda
+	data << 18.792 << -26.451 << "Sgr"; // Nunki
+	data << 20.262 << -57.136 << "Pav"; // Peacock
+	data << 22.006 << -47.570 << "Gru"; // Alnair
+
+	while (data.count() >= 3)
+	{
+		const double RA = data.takeFirst().toDouble();
+		const double dec = data.takeFirst().toDouble();
+		const QString expected = data.takeFirst().toString();
+		QVERIFY2(spans->find(RA, dec).compare(expected, Qt::CaseInsensitive)==0,
+			 qPrintable(QString("RA=%1h Dec=%2: %3 expected %4").arg(RA).arg(dec).arg(spans->find(RA, dec)).arg(expected)));
+	}
+}
+
+void TestIAUConstellationSpans::testDenseSampling()
+{
+	// Sample the sky with a step which is not aligned on the grid cells: every position belongs to a constellation
+	int count=0;
+	QElapsedTimer timer;
+	timer.start();
+	for (double dec=-90.; dec<=90.; dec+=0.0937)
+	{
+		for (double RA=0.; RA<24.; RA+=0.00713)
+		{
+			const QString result = spans->find(RA, dec);
+			if (!constellations.contains(result))
+				QFAIL(qPrintable(QString("RA=%1h Dec=%2: %3").arg(RA, 0, 'f', 8).arg(dec, 0, 'f', 8).arg(result)));
+			++count;
+		}
+	}
+	qDebug() << "Looked up" << count << "positions in" << timer.elapsed() << "ms";
+}
+
+void TestIAUConstellationSpans::testSpanBorders()
+{
+	// The borders of the spans are the difficult cases, because of the strict comparisons.
+	// A span is the southern border of its constellation: the positions just above it, strictly
+	// between its right ascension limits, belong to the constellation given for the span in the data file.
+	const double RAoffsets[] = { 1e-9, 1e-6, 1e-3 };
+	const double decOffsets[] = { 0., 1e-12, 1e-6 };
+	int count=0;
+	for (const auto& span : fileSpans)
+	{
+		for (const double dRA : RAoffsets)
+		{
+			if (2.*dRA>=span.RAhigh-span.RAlow)
+				continue;
+			for (const double RA : { span.RAlow+dRA, 0.5*(span.RAlow+span.RAhigh), span.RAhigh-dRA })
+			{
+				for (const double dDec : decOffsets)
+				{
+					QVERIFY2(spans->find(RA, span.decLow+dDec)==span.constellation,
+						 qPrintable(QString("RA=%1h Dec=%2: %3 expected %4").arg(RA, 0, 'f', 12).arg(span.decLow+dDec, 0, 'f', 12)
+							    .arg(spans->find(RA, span.decLow+dDec)).arg(span.constellation)));
+					++count;
+				}
+			}
+		}
+	}
+	qDebug() << "Checked" << count << "positions along the span borders";
+}
+
+void TestIAUConstellationSpans::testBatch()
+{
+	QVector<Vec3d> positions;
+	for (int i=0; i<10000; ++i)
+	{
+		Vec3d pos;
+		StelUtils::spheToRect(i*0.0137, std::asin(2.*((i*7919)%10000)/10000.-1.), pos);
+		positions << pos;
+	}
+	const QStringList result = spans->find(positions);
+	QCOMPARE(result.size(), positions.size());
+	for (int i=0; i<positions.size(); ++i)
+		QCOMPARE(result.at(i), spans->find(positions.at(i)));
+}
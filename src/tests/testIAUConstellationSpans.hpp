@@ -0,0 +1,55 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef TESTIAUCONSTELLATIONSPANS_HPP
+#define TESTIAUCONSTELLATIONSPANS_HPP
+
+#include <QObject>
+#include <QtTest>
+#include <QSet>
+#include <QVector>
+
+class IAUConstellationSpans;
+
+class TestIAUConstellationSpans : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testKnownPositions();
+	void testDenseSampling();
+	void testSpanBorders();
+	void testBatch();
+
+private:
+	//! A span as read from the data file.
+	struct FileSpan
+	{
+		double RAlow;
+		double RAhigh;
+		double decLow;
+		QString constellation;
+	};
+
+	IAUConstellationSpans* spans;
+	QVector<FileSpan> fileSpans;
+	QSet<QString> constellations;
+};
+
+#endif // TESTIAUCONSTELLATIONSPANS_HPP
@@ -0,0 +1,241 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testNebulaStore.hpp"
+#include "NebulaStore.hpp"
+#include "StelGeodesicGrid.hpp"
+#include "StelUtils.hpp"
+
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSet>
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestNebulaStore)
+
+#define CATALOG_SIZE 2000
+#define CATALOG_VERSION "3.8"
+// The PGC numbers shared by two objects, whose brighter object is in the north or in the south
+#define DUPLICATED_PGC_NORTH 900
+#define DUPLICATED_PGC_SOUTH 901
+
+bool TestNebulaStore::writeCatalog(const QString& fileName, int count, const QString& version, QHash<int, unsigned int>* pgcs)
+{
+	QByteArray raw;
+	QDataStream out(&raw, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_2);
+	out << version << QString("test");
+
+	// Deterministic pseudo-random positions and magnitudes
+	quint32 seed = 12345;
+	auto next = [&seed]() {
+		seed = seed*1664525u + 1013904223u;
+		return static_cast<float>(seed>>8)/static_cast<float>(1<<24);
+	};
+	const QString empty;
+	for (int id=1; id<=count; ++id)
+	{
+		float ra = next()*2.f*static_cast<float>(M_PI);
+		float dec = std::asin(2.f*next()-1.f);
+		float mag = 8.f + 10.f*next();
+		// Every other object has a PGC number
+		int pgc = (id%2==1) ? 1000+id-1 : 0;
+		// The last four objects are two pairs sharing a PGC number, one near each pole so that they are in different
+		// zones. The brighter object is in the north for the first pair and in the south for the second one, so that
+		// one of the pairs has its brighter object in the zone with the higher number.
+		if (id>count-4)
+		{
+			const int k = id-(count-3);
+			pgc = k<2 ? DUPLICATED_PGC_NORTH : DUPLICATED_PGC_SOUTH;
+			ra = 0.f;
+			dec = (k%2==0 ? 80.f : -80.f)*static_cast<float>(M_PI)/180.f;
+			mag = ((k==0) || (k==3)) ? 9.f : 12.f;
+		}
+		if (pgcs)
+			pgcs->insert(id, static_cast<unsigned int>(pgc));
+		out << id << ra << dec << mag+0.5f << mag << 0u << QString("E") << 0.1f << 0.05f
+		    << 45 << 0.f << 0.f << 0.f << 0.f << 0.f << 0.f
+		    << 0 << 0 << 0 << 0 << 0 << 0 << 0 << 0 << 0 << 0 << 0 << 0 << pgc << 0
+		    << empty << 0 << 0 << empty << empty << empty << empty << empty << 0 << empty << empty << 0;
+	}
+
+	// qCompress() prepends the uncompressed size to a zlib stream
+	const QByteArray compressed = qCompress(raw).mid(4);
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+	return file.write(compressed)==compressed.size();
+}
+
+void TestNebulaStore::initTestCase()
+{
+	QVERIFY(tempDir.isValid());
+	catalogFile = QDir(tempDir.path()).absoluteFilePath("extended.dat");
+	storeFile = QDir(tempDir.path()).absoluteFilePath("cache/extended.bin");
+	QVERIFY(writeCatalog(catalogFile, CATALOG_SIZE, CATALOG_VERSION, &catalogPGC));
+}
+
+void TestNebulaStore::testCompile()
+{
+	QFile::remove(storeFile);
+	NebulaStore store;
+	QVERIFY(store.open(storeFile, catalogFile, CATALOG_VERSION));
+	QVERIFY(store.isOpen());
+	QVERIFY(store.wasCompiled());
+	QVERIFY(QFile::exists(storeFile));
+	QCOMPARE(store.size(), CATALOG_SIZE);
+
+	// Each object is in its zone, and the objects of a zone are ordered by magnitude
+	const int level = store.getLevel();
+	QVERIFY(level>=1 && level<=7);
+	StelGeodesicGrid grid(level);
+	int count = 0;
+	for (int z=0; z<StelGeodesicGrid::nrOfZones(level); ++z)
+	{
+		int last;
+		const int first = store.getZone(z, last);
+		QCOMPARE(first, count);
+		for (int i=first; i<last; ++i)
+		{
+			const NebulaStore::Entry& e = store.getEntry(i);
+			QCOMPARE(grid.getZoneNumberForPoint(Vec3f(e.pos[0], e.pos[1], e.pos[2]), level), z);
+			if (i>first)
+				QVERIFY(store.getEntry(i-1).mag<=e.mag);
+		}
+		count = last;
+	}
+	QCOMPARE(count, CATALOG_SIZE);
+}
+
+void TestNebulaStore::testRecords()
+{
+	NebulaStore store;
+	QVERIFY(store.open(storeFile, catalogFile, CATALOG_VERSION));
+	QSet<int> ids;
+	for (int i=0; i<store.size(); ++i)
+	{
+		const NebulaStore::Entry& e = store.getEntry(i);
+		QDataStream in(store.getRecord(i));
+		in.setVersion(QDataStream::Qt_5_2);
+		int id;
+		float ra, dec, bMag, vMag;
+		in >> id >> ra >> dec >> bMag >> vMag;
+		QCOMPARE(in.status(), QDataStream::Ok);
+		ids.insert(id);
+
+		// The summary matches the record
+		Vec3d pos;
+		StelUtils::spheToRect(ra, dec, pos);
+		for (int k=0; k<3; ++k)
+			QVERIFY(qAbs(static_cast<double>(e.pos[k])-pos[k])<1e-6);
+		QCOMPARE(e.mag, vMag);
+		QCOMPARE(e.pgc, catalogPGC.value(id));
+	}
+	QCOMPARE(ids.size(), CATALOG_SIZE);
+}
+
+void TestNebulaStore::testSearchPGC()
+{
+	NebulaStore store;
+	QVERIFY(store.open(storeFile, catalogFile, CATALOG_VERSION));
+	for (auto it=catalogPGC.constBegin(); it!=catalogPGC.constEnd(); ++it)
+	{
+		if (it.value()==0)
+			continue;
+		const int index = store.searchPGC(it.value());
+		QVERIFY(index>=0);
+		QCOMPARE(store.getEntry(index).pgc, it.value());
+	}
+	QCOMPARE(store.searchPGC(0), -1);
+	QCOMPARE(store.searchPGC(999), -1);
+	QCOMPARE(store.searchPGC(1000+CATALOG_SIZE+1), -1);
+
+	// The brightest object is kept for a duplicated number, whichever zone it is in
+	StelGeodesicGrid grid(store.getLevel());
+	for (unsigned int pgc : {DUPLICATED_PGC_NORTH, DUPLICATED_PGC_SOUTH})
+	{
+		QSet<int> zones;
+		for (int i=0; i<store.size(); ++i)
+		{
+			const NebulaStore::Entry& e = store.getEntry(i);
+			if (e.pgc==pgc)
+				zones.insert(grid.getZoneNumberForPoint(Vec3f(e.pos[0], e.pos[1], e.pos[2]), store.getLevel()));
+		}
+		QCOMPARE(zones.size(), 2);
+		const int index = store.searchPGC(pgc);
+		QVERIFY(index>=0);
+		QCOMPARE(store.getEntry(index).mag, 9.f);
+	}
+}
+
+void TestNebulaStore::testReopen()
+{
+	NebulaStore store;
+	QVERIFY(store.open(storeFile, catalogFile, CATALOG_VERSION));
+	QVERIFY(!store.wasCompiled());
+	QCOMPARE(store.size(), CATALOG_SIZE);
+	store.close();
+	QVERIFY(!store.isOpen());
+
+	// The store is compiled again when the catalog changes
+	const QString otherCatalog = QDir(tempDir.path()).absoluteFilePath("other.dat");
+	const QString otherStore = QDir(tempDir.path()).absoluteFilePath("cache/other.bin");
+	QVERIFY(writeCatalog(otherCatalog, 10, CATALOG_VERSION));
+	QVERIFY(store.open(otherStore, otherCatalog, CATALOG_VERSION));
+	QVERIFY(store.wasCompiled());
+	QCOMPARE(store.size(), 10);
+	store.close();
+	QVERIFY(writeCatalog(otherCatalog, 20, CATALOG_VERSION));
+	QVERIFY(store.open(otherStore, otherCatalog, CATALOG_VERSION));
+	QVERIFY(store.wasCompiled());
+	QCOMPARE(store.size(), 20);
+}
+
+void TestNebulaStore::testVersionMismatch()
+{
+	const QString oldCatalog = QDir(tempDir.path()).absoluteFilePath("old.dat");
+	QVERIFY(writeCatalog(oldCatalog, 10, "3.1"));
+	NebulaStore store;
+	QVERIFY(!store.open(QDir(tempDir.path()).absoluteFilePath("cache/old.bin"), oldCatalog, CATALOG_VERSION));
+	QVERIFY(!store.isOpen());
+}
+
+void TestNebulaStore::benchmarkCompile()
+{
+	// A catalog of the size of the PGC galaxies subset
+	const QString largeCatalog = QDir(tempDir.path()).absoluteFilePath("large.dat");
+	const QString largeStore = QDir(tempDir.path()).absoluteFilePath("cache/large.bin");
+	QVERIFY(writeCatalog(largeCatalog, 100000, CATALOG_VERSION));
+
+	NebulaStore store;
+	QBENCHMARK {
+		QFile::remove(largeStore);
+		QVERIFY(store.open(largeStore, largeCatalog, CATALOG_VERSION));
+	}
+	QCOMPARE(store.size(), 100000);
+
+	// Mapping the compiled store must be much faster than compiling it
+	QElapsedTimer timer;
+	timer.start();
+	QVERIFY(store.open(largeStore, largeCatalog, CATALOG_VERSION));
+	QVERIFY(!store.wasCompiled());
+	qDebug() << "Mapped" << store.size() << "objects in" << timer.elapsed() << "ms";
+}
@@ -0,0 +1,111 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testOrbit.hpp"
+
+#include "Orbit.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestOrbit)
+
+// Number of minor bodies whose orbits are drawn in the benchmarks
+static const int NB_ORBITS = 10000;
+// Number of samples per orbit, as ORBIT_SEGMENTS in Planet.hpp
+static const int NB_SAMPLES = 360;
+
+void TestOrbit::initTestCase()
+{
+	// A reproducible population of asteroid-like orbits
+	qsrand(1);
+	for (int i=0; i<NB_ORBITS; ++i)
+	{
+		const double q = 1.5 + 2.0*qrand()/RAND_MAX;
+		const double e = 0.3*qrand()/RAND_MAX;
+		const double a = q/(1.0-e);
+		orbits.append(new EllipticalOrbit(q, e, 0.5*qrand()/RAND_MAX, 2.0*M_PI*qrand()/RAND_MAX, 2.0*M_PI*qrand()/RAND_MAX,
+						  2.0*M_PI*qrand()/RAND_MAX, 365.25*std::pow(a, 1.5), 2451545.0, 0.0, 0.0, 0.0));
+	}
+}
+
+void TestOrbit::cleanupTestCase()
+{
+	qDeleteAll(orbits);
+	orbits.clear();
+}
+
+void TestOrbit::testSampleOrbit()
+{
+	// Pericenter passage at the epoch
+	const double period = 1000.;
+	EllipticalOrbit orbit(1.0, 0.5, 0.2, 1.0, 2.0, 0.0, period, 2451545.0, 0.0, 0.0, 0.0);
+	Vec3d samples[NB_SAMPLES];
+	QVERIFY(orbit.sampleOrbit(NB_SAMPLES, samples));
+
+	// The first sample is the pericenter, the middle one the apocenter (eccentric and mean anomaly are both 0 and pi there).
+	double pos[3];
+	orbit.positionAtTimevInVSOP87Coordinates(2451545.0, pos);
+	QVERIFY((samples[0]-Vec3d(pos[0], pos[1], pos[2])).length() < 1e-12);
+	orbit.positionAtTimevInVSOP87Coordinates(2451545.0+0.5*period, pos);
+	QVERIFY((samples[NB_SAMPLES/2]-Vec3d(pos[0], pos[1], pos[2])).length() < 1e-9);
+	QVERIFY(qAbs(samples[0].length()-1.0) < 1e-12);
+	QVERIFY(qAbs(samples[NB_SAMPLES/2].length()-3.0) < 1e-12);
+}
+
+void TestOrbit::testOpenOrbit()
+{
+	EllipticalOrbit orbit(1.0, 1.2, 0.2, 1.0, 2.0, 0.0, 1000., 2451545.0, 0.0, 0.0, 0.0);
+	Vec3d samples[NB_SAMPLES];
+	QVERIFY(!orbit.sampleOrbit(NB_SAMPLES, samples));
+}
+
+// What Planet::computeOrbit() did for every frame: evaluate the position at each sample date.
+void TestOrbit::benchmarkTimeSampling()
+{
+	QVector<Vec3d> samples(NB_SAMPLES);
+	double pos[3];
+	QBENCHMARK {
+		for (const auto* orbit : orbits)
+		{
+			const double period = orbit->getPeriod();
+			for (int k=0; k<NB_SAMPLES; ++k)
+			{
+				orbit->positionAtTimevInVSOP87Coordinates(2458000.0 + period*k/NB_SAMPLES, pos);
+				samples[k].set(pos[0], pos[1], pos[2]);
+			}
+		}
+	}
+}
+
+// What is left for every frame with cached Keplerian orbits: offset the cached samples by the parent position.
+void TestOrbit::benchmarkCachedSampling()
+{
+	QVector<QVector<Vec3d>> cache(orbits.size(), QVector<Vec3d>(NB_SAMPLES));
+	for (int i=0; i<orbits.size(); ++i)
+		orbits.at(i)->sampleOrbit(NB_SAMPLES, cache[i].data());
+
+	QVector<Vec3d> samples(NB_SAMPLES);
+	const Vec3d parentPos(0.1, -0.2, 0.01);
+	QBENCHMARK {
+		for (const auto& orbit : cache)
+		{
+			for (int k=0; k<NB_SAMPLES; ++k)
+				samples[k] = orbit.at(k) + parentPos;
+		}
+	}
+}
@@ -0,0 +1,114 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testSolarEclipseSolver.hpp"
+
+#include <QDebug>
+
+#include "EphemWrapper.hpp"
+#include "sidereal_time.h"
+#include "StelUtils.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestSolarEclipseSolver)
+
+// Delta T in August 2017 [seconds]
+static const double DELTA_T_2017 = 68.9;
+// Mean obliquity of the ecliptic at J2000.0 [radians]
+static const double OBLIQUITY_J2000 = 23.4392911*M_PI_180;
+// Geocentric latitude factor of the WGS84 ellipsoid: 1-f
+static const double EARTH_AXIS_RATIO = 0.99664719;
+static const double SUN_RADIUS = 696000./AU;
+static const double MOON_RADIUS = 1737.4/AU;
+static const double EARTH_RADIUS = 6378.137/AU;
+
+// Carbondale, Illinois, near the center line of the total solar eclipse of 2017 August 21
+static const double CARBONDALE_LATITUDE = 37.727;
+static const double CARBONDALE_LONGITUDE = -89.217;
+
+SolarEclipseSolver::Geometry TestSolarEclipseSolver::geometryAt(double JD, double latitude, double longitude)
+{
+	const double JDE = JD + DELTA_T_2017/86400.;
+	double earth[3], moon[3], velocity[3];
+	get_earth_helio_coordsv(JDE, earth, velocity, Q_NULLPTR);
+	get_lunar_parent_coordsv(JDE, moon, velocity, Q_NULLPTR);
+
+	// Observer position and zenith in equatorial coordinates, the equinox of date being neglected
+	const double phi = latitude*M_PI_180;
+	const double theta = (get_mean_sidereal_time(JD, JDE) + longitude)*M_PI_180;
+	const double u = std::atan(EARTH_AXIS_RATIO*std::tan(phi));
+	const Vec3d observerEqu(EARTH_RADIUS*std::cos(u)*std::cos(theta), EARTH_RADIUS*std::cos(u)*std::sin(theta), EARTH_RADIUS*EARTH_AXIS_RATIO*std::sin(u));
+	const Vec3d zenithEqu(std::cos(phi)*std::cos(theta), std::cos(phi)*std::sin(theta), std::sin(phi));
+	const Mat4d equToEcl = Mat4d::xrotation(-OBLIQUITY_J2000);
+
+	SolarEclipseSolver::Geometry g;
+	const Vec3d earthPos(earth[0], earth[1], earth[2]);
+	g.observerPos = earthPos + equToEcl.multiplyWithoutTranslation(observerEqu);
+	g.moonPos = earthPos + Vec3d(moon[0], moon[1], moon[2]);
+	g.zenith = equToEcl.multiplyWithoutTranslation(zenithEqu);
+	// Light time corrected Sun, as in SolarSystem::computePositions()
+	get_earth_helio_coordsv(JDE - earthPos.length()*AU/(SPEED_OF_LIGHT*86400.), earth, velocity, Q_NULLPTR);
+	g.sunPos = earthPos - Vec3d(earth[0], earth[1], earth[2]);
+	return g;
+}
+
+void TestSolarEclipseSolver::testTotalEclipse2017()
+{
+	SolarEclipseSolver solver([](double JD) { return geometryAt(JD, CARBONDALE_LATITUDE, CARBONDALE_LONGITUDE); }, SUN_RADIUS, MOON_RADIUS);
+	// New Moon at 18:30 UT
+	const LocalSolarEclipse eclipse = solver.compute(2457987.2708);
+
+	// Local circumstances from NASA (F. Espenak): C1 16:52 UT, C2 18:20, maximum 18:21:30, C3 18:23, C4 19:47,
+	// duration of totality 2m38s, Sun at 64 degrees.
+	const double minute = 1./1440.;
+	QVERIFY(eclipse.eclipse);
+	QVERIFY(eclipse.visible);
+	QVERIFY(eclipse.central);
+	QVERIFY(eclipse.magnitude > 1.);
+	QVERIFY(qFuzzyCompare(eclipse.obscuration, 1.));
+	QVERIFY2(qAbs(eclipse.JDmax - 2457987.26493) < minute, qPrintable(StelUtils::julianDayToISO8601String(eclipse.JDmax)));
+	QVERIFY2(qAbs(eclipse.JD1 - 2457987.20278) < 2*minute, qPrintable(StelUtils::julianDayToISO8601String(eclipse.JD1)));
+	QVERIFY2(qAbs(eclipse.JD4 - 2457987.32500) < 2*minute, qPrintable(StelUtils::julianDayToISO8601String(eclipse.JD4)));
+	QVERIFY(eclipse.JD1 < eclipse.JD2 && eclipse.JD2 < eclipse.JDmax && eclipse.JDmax < eclipse.JD3 && eclipse.JD3 < eclipse.JD4);
+	const double totality = (eclipse.JD3 - eclipse.JD2)*1440.;
+	QVERIFY2(totality > 2.3 && totality < 2.9, qPrintable(QString::number(totality)));
+	QVERIFY(qAbs(eclipse.sunAltitudeMax*M_180_PI - 64.) < 1.5);
+	QVERIFY(eclipse.sunAltitude1 > 0. && eclipse.sunAltitude4 > 0.);
+}
+
+void TestSolarEclipseSolver::testEclipseBelowHorizon()
+{
+	// Same eclipse, with the zenith turned upside down: the Sun is at -64 degrees during the whole eclipse.
+	SolarEclipseSolver solver([](double JD) {
+		SolarEclipseSolver::Geometry g = geometryAt(JD, CARBONDALE_LATITUDE, CARBONDALE_LONGITUDE);
+		g.zenith = -g.zenith;
+		return g;
+	}, SUN_RADIUS, MOON_RADIUS);
+	const LocalSolarEclipse eclipse = solver.compute(2457987.2708);
+
+	QVERIFY(eclipse.eclipse);
+	QVERIFY(!eclipse.visible);
+	QVERIFY(eclipse.sunAltitudeMax < 0.);
+	QVERIFY(eclipse.sunAltitude1 < 0. && eclipse.sunAltitude4 < 0.);
+
+	// No eclipse one synodic month later, at the next new Moon
+	const LocalSolarEclipse noEclipse = solver.compute(2457987.2708 + 29.53);
+	QVERIFY(!noEclipse.eclipse);
+	QVERIFY(!noEclipse.visible);
+}
@@ -0,0 +1,130 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStarMetadata.hpp"
+
+#include <QFile>
+
+#include "StarMetadata.hpp"
+
+QTEST_GUILESS_MAIN(TestStarMetadata)
+
+QString TestStarMetadata::writeFile(const QString& name, const QString& content)
+{
+	const QString path = dir.path() + "/" + name;
+	QFile f(path);
+	if (f.open(QIODevice::WriteOnly | QIODevice::Text))
+		f.write(content.toUtf8());
+	return path;
+}
+
+void TestStarMetadata::initTestCase()
+{
+	QVERIFY(dir.isValid());
+	gcvsFile = writeFile("gcvs_hip_part.dat",
+			     "# GCVS\n"
+			     "8\tAE And\tEA\t11.8\t0\t12.5\t\tV\t2440000.5\t2.5\t10\tG5\n"
+			     "8\tXX And\tEA\t1\t0\t2\t3\tV\t0\t0\t0\tA0\n"
+			     "4\tAA And\tRRAB\t10.5\t0\t11.2\t\tV\t2451000.25\t0.6\t15\tA7\n");
+	wdsFile = writeFile("wds_hip_part.dat",
+			    "4\t00022+2705\t2011\t172\t1.4\n"
+			    "12\t00048+3810\t2005\t30.5\t0.2\n");
+	crossIdFile = writeFile("cross-id.dat",
+				"4\t\t73648\t224705\t0\n"
+				"4\tB\t73649\t224706\t0\n"
+				"12\t\t1000\t20\t9110\n"
+				"bad line\n");
+	plxErrFile = writeFile("hip_plx_err.dat",
+			       "4\t0.75\n"
+			       "12\t1.5\n");
+	storeFile = dir.path() + "/cache/starMetadata.bin";
+}
+
+void TestStarMetadata::testLookups()
+{
+	StarMetadata store;
+	QVERIFY(store.open(storeFile, gcvsFile, wdsFile, crossIdFile, plxErrFile));
+	QVERIFY(store.wasCompiled());
+	QVERIFY(QFile::exists(storeFile));
+
+	// The first GCVS record of a star is kept
+	const StarMetadata::GcvsRecord* vs = store.findGcvs(8);
+	QVERIFY(vs!=Q_NULLPTR);
+	QCOMPARE(store.getString(vs->designation), QString("AE And"));
+	QCOMPARE(store.getString(vs->vtype), QString("EA"));
+	QCOMPARE(vs->maxmag, 11.8f);
+	QCOMPARE(vs->min2mag, 99.f);
+	QCOMPARE(vs->period, 2.5);
+	QCOMPARE(vs->Mm, 10);
+	QVERIFY(store.findGcvs(5)==Q_NULLPTR);
+
+	const StarMetadata::WdsRecord* ds = store.findWds(12);
+	QVERIFY(ds!=Q_NULLPTR);
+	QCOMPARE(store.getString(ds->designation), QString("00048+3810"));
+	QCOMPARE(ds->observation, 2005);
+	QCOMPARE(ds->positionAngle, 30.5f);
+
+	// Components fall back to the star itself
+	const StarMetadata::CrossIdRecord* ci = store.findCrossId(4, "B");
+	QVERIFY(ci!=Q_NULLPTR);
+	QCOMPARE(ci->sao, 73649);
+	ci = store.findCrossId(12, "A");
+	QVERIFY(ci!=Q_NULLPTR);
+	QCOMPARE(ci->hr, 9110);
+	QVERIFY(store.findCrossId(8, QString())==Q_NULLPTR);
+
+	QCOMPARE(store.getPlxError(12), 1.5f);
+	QCOMPARE(store.getPlxError(8), 0.f);
+}
+
+void TestStarMetadata::testIndexes()
+{
+	StarMetadata store;
+	QVERIFY(store.open(storeFile, gcvsFile, wdsFile, crossIdFile, plxErrFile));
+
+	QCOMPARE(store.searchSao(73649), 4);
+	QCOMPARE(store.searchHd(20), 12);
+	QCOMPARE(store.searchHr(9110), 12);
+	QCOMPARE(store.searchHr(0), -1);
+	QCOMPARE(store.searchSao(1), -1);
+
+	QCOMPARE(store.searchGcvs("AE AND"), 8);
+	QCOMPARE(store.searchGcvs("AE And"), -1);
+	QCOMPARE(store.searchWds("WDS J00022+2705"), 4);
+
+	QCOMPARE(store.listGcvsByPrefix("A", 10), QList<int>() << 4 << 8);
+	QCOMPARE(store.listGcvsByPrefix("A", 1), QList<int>() << 4);
+	QCOMPARE(store.listGcvsByPrefix("Z", 10), QList<int>());
+	QCOMPARE(store.listWdsByPrefix("WDS J0004", 10), QList<int>() << 12);
+}
+
+void TestStarMetadata::testReopen()
+{
+	StarMetadata store;
+	QVERIFY(store.open(storeFile, gcvsFile, wdsFile, crossIdFile, plxErrFile));
+	QVERIFY(!store.wasCompiled());
+	QCOMPARE(store.searchHd(224705), 4);
+
+	// A changed text file invalidates the compiled file
+	QTest::qSleep(1100);
+	writeFile("hip_plx_err.dat", "4\t0.5\n");
+	QVERIFY(store.open(storeFile, gcvsFile, wdsFile, crossIdFile, plxErrFile));
+	QVERIFY(store.wasCompiled());
+	QCOMPARE(store.getPlxError(4), 0.5f);
+	QCOMPARE(store.getPlxError(12), 0.f);
+}
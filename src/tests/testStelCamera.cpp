@@ -0,0 +1,96 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelCamera.hpp"
+
+#include <QObject>
+#include <QDebug>
+#include <cmath>
+
+#include "StelCore.hpp"
+#include "StelUtils.hpp"
+
+QTEST_GUILESS_MAIN(TestStelCamera)
+
+#define ERROR_LIMIT 1e-9
+
+void TestStelCamera::testViewport()
+{
+	StelProjector::StelProjectorParams mainParams;
+	mainParams.viewportXywh.set(0, 0, 1920, 1080);
+	mainParams.viewportCenterOffset.set(0., -0.3);
+	mainParams.maskType = StelProjector::MaskDisk;
+	const StelCore::Camera camera = StelCore::makeCamera(mainParams, Vec3d(2., 0., 0.), 5.f, Vector4<int>(10, 20, 400, 300),
+							     StelCore::ProjectionPerspective);
+
+	QVERIFY(camera.params.viewportXywh == Vector4<int>(10, 20, 400, 300));
+	QCOMPARE(camera.params.viewportCenter[0], 210.);
+	QCOMPARE(camera.params.viewportCenter[1], 170.);
+	QCOMPARE(camera.params.viewportFovDiameter, 300.);
+	QCOMPARE(camera.params.fov, 5.f);
+	QVERIFY(camera.params.maskType == StelProjector::MaskNone);
+	QCOMPARE(camera.projectionType, StelCore::ProjectionPerspective);
+	QVERIFY(std::fabs(camera.viewDirectionJ2000.length()-1.) < ERROR_LIMIT);
+	QCOMPARE(camera.fbo, 0u);
+}
+
+void TestStelCamera::testMainParams()
+{
+	StelProjector::StelProjectorParams mainParams;
+	mainParams.flipHorz = true;
+	mainParams.devicePixelsPerPixel = 2.;
+	mainParams.gravityLabels = true;
+	const StelCore::Camera camera = StelCore::makeCamera(mainParams, Vec3d(0., 1., 0.), 30.f, Vector4<int>(0, 0, 256, 256),
+							     StelCore::ProjectionStereographic);
+
+	QVERIFY(camera.params.flipHorz);
+	QVERIFY(!camera.params.flipVert);
+	QCOMPARE(camera.params.devicePixelsPerPixel, 2.);
+	QVERIFY(camera.params.gravityLabels);
+}
+
+void TestStelCamera::testUpVector()
+{
+	for (double dec=-80.; dec<=80.; dec+=20.)
+	{
+		for (double ra=0.; ra<360.; ra+=45.)
+		{
+			Vec3d dir;
+			StelUtils::spheToRect(ra*M_PI_180, dec*M_PI_180, dir);
+			const StelCore::Camera camera = StelCore::makeCamera(StelProjector::StelProjectorParams(), dir, 10.f,
+									     Vector4<int>(0, 0, 100, 100), StelCore::ProjectionStereographic);
+			const Vec3d& up = camera.upJ2000;
+			QVERIFY2(std::fabs(up.length()-1.) < ERROR_LIMIT, qPrintable(QString("ra=%1 dec=%2").arg(ra).arg(dec)));
+			QVERIFY2(std::fabs(up.dot(camera.viewDirectionJ2000)) < ERROR_LIMIT, qPrintable(QString("ra=%1 dec=%2").arg(ra).arg(dec)));
+			// North is up
+			QVERIFY2(up[2] > 0., qPrintable(QString("ra=%1 dec=%2").arg(ra).arg(dec)));
+		}
+	}
+}
+
+void TestStelCamera::testUpVectorAtPoles()
+{
+	const Vec3d poles[2] = {Vec3d(0., 0., 1.), Vec3d(0., 0., -1.)};
+	for (const auto& pole : poles)
+	{
+		const StelCore::Camera camera = StelCore::makeCamera(StelProjector::StelProjectorParams(), pole, 10.f,
+								     Vector4<int>(0, 0, 100, 100), StelCore::ProjectionStereographic);
+		QVERIFY(std::fabs(camera.upJ2000.length()-1.) < ERROR_LIMIT);
+		QVERIFY(std::fabs(camera.upJ2000.dot(pole)) < ERROR_LIMIT);
+	}
+}
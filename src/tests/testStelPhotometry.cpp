@@ -0,0 +1,144 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelPhotometry.hpp"
+
+#include "StelPhotometry.hpp"
+
+QTEST_GUILESS_MAIN(TestStelPhotometry)
+
+void TestStelPhotometry::checkMagnitude(const StelPhotometry& photometry, int index, double jde, float expected)
+{
+	const float mag = photometry.computeMagnitude(index, jde);
+	QVERIFY2(qAbs(mag - expected) <= 1e-3f, QString("JDE=%1 mag=%2 mag(expected)=%3")
+						.arg(QString::number(jde, 'f', 2))
+						.arg(QString::number(mag, 'f', 3))
+						.arg(QString::number(expected, 'f', 3))
+						.toUtf8());
+}
+
+void TestStelPhotometry::testNovaCurve()
+{
+	StelPhotometry photometry;
+	const double peak = 2450000.;
+	// A fast nova: the decline times are 10, 30, 100 and 400 days
+	const int nova = photometry.addNovaCurve("NA", 3.f, 15.f, peak, -1, -1, -1, -1);
+	QCOMPARE(nova, 0);
+	checkMagnitude(photometry, nova, peak-10., 15.f);
+	checkMagnitude(photometry, nova, peak-1.5, 9.f);
+	checkMagnitude(photometry, nova, peak, 3.f);
+	checkMagnitude(photometry, nova, peak+5., 4.f);
+	checkMagnitude(photometry, nova, peak+20., 6.f);
+	checkMagnitude(photometry, nova, peak+50., 7.2f);
+	checkMagnitude(photometry, nova, peak+500., 15.f);
+
+	// The given decline times have precedence over the type
+	const int slowNova = photometry.addNovaCurve("NA", 3.f, 15.f, peak, 20, -1, -1, -1);
+	checkMagnitude(photometry, slowNova, peak+10., 4.f);
+}
+
+void TestStelPhotometry::testSupernovaCurves()
+{
+	StelPhotometry photometry;
+	const double peak = 2450000.;
+	const int typeI = photometry.addSupernovaCurve("Ia", 5.f, peak);
+	checkMagnitude(photometry, typeI, peak-100., 20.f);
+	checkMagnitude(photometry, typeI, peak-5., 10.65f);
+	checkMagnitude(photometry, typeI, peak, 5.f);
+	checkMagnitude(photometry, typeI, peak+10., 6.f);
+	checkMagnitude(photometry, typeI, peak+125., 9.1f);
+
+	const int typeII = photometry.addSupernovaCurve("IIP", 5.f, peak);
+	checkMagnitude(photometry, typeII, peak-10., 12.5f);
+	checkMagnitude(photometry, typeII, peak+20., 6.f);
+	checkMagnitude(photometry, typeII, peak+40., 6.63f);
+	checkMagnitude(photometry, typeII, peak+90., 7.9f);
+	checkMagnitude(photometry, typeII, peak+200., 11.15f);
+}
+
+void TestStelPhotometry::testPeriodicCurves()
+{
+	StelPhotometry photometry;
+	const double epoch = 2450000.;
+	// Mira-like star with a rising time of 40% of the period
+	const int mira = photometry.addGcvsCurve("M", 5.f, 0, 10.f, 99.f, epoch, 300., 40);
+	QVERIFY(mira>=0);
+	checkMagnitude(photometry, mira, epoch, 5.f);
+	checkMagnitude(photometry, mira, epoch+180., 10.f);
+	checkMagnitude(photometry, mira, epoch+3000., 5.f);
+	checkMagnitude(photometry, mira, epoch-120., 10.f);
+	const float meanMag = photometry.getLightCurve(mira).meanMag;
+	QVERIFY(meanMag>5.f && meanMag<10.f);
+
+	// Detached eclipsing binary with an amplitude given for the primary minimum and eclipses lasting 10% of the period
+	const int algol = photometry.addGcvsCurve("EA/SD", 8.f, 1, 1.f, 99.f, epoch, 2., 10);
+	QVERIFY(algol>=0);
+	checkMagnitude(photometry, algol, epoch, 9.f);
+	checkMagnitude(photometry, algol, epoch+0.5, 8.f);
+	checkMagnitude(photometry, algol, epoch+1., 8.f);
+	checkMagnitude(photometry, algol, epoch+1.5, 8.f);
+
+	const int binary = photometry.addGcvsCurve("EA", 8.f, 0, 9.f, 8.5f, epoch, 2., 10);
+	checkMagnitude(photometry, binary, epoch+1., 8.5f);
+
+	// Contact binary with two minima per period
+	const int contact = photometry.addGcvsCurve("EW", 6.f, 0, 6.8f, 6.6f, epoch, 0.4, 0);
+	QVERIFY(contact>=0);
+	checkMagnitude(photometry, contact, epoch, 6.8f);
+	checkMagnitude(photometry, contact, epoch+0.1, 6.f);
+	checkMagnitude(photometry, contact, epoch+0.2, 6.6f);
+}
+
+void TestStelPhotometry::testRejectedCurves()
+{
+	StelPhotometry photometry;
+	const double epoch = 2450000.;
+	// Irregular and eruptive variables have no light curve
+	QCOMPARE(photometry.addGcvsCurve("LB", 5.f, 0, 6.f, 99.f, epoch, 100., 0), -1);
+	QCOMPARE(photometry.addGcvsCurve("UGSS", 5.f, 0, 6.f, 99.f, epoch, 100., 0), -1);
+	// Incomplete data
+	QCOMPARE(photometry.addGcvsCurve("M", 5.f, 0, 10.f, 99.f, 0., 300., 40), -1);
+	QCOMPARE(photometry.addGcvsCurve("M", 5.f, 0, 10.f, 99.f, epoch, 0., 40), -1);
+	QCOMPARE(photometry.addGcvsCurve("M", 5.f, 0, 99.f, 99.f, epoch, 300., 40), -1);
+	QCOMPARE(photometry.size(), 0);
+}
+
+void TestStelPhotometry::testUpdate()
+{
+	StelPhotometry photometry;
+	const double epoch = 2450000.;
+	const int mira = photometry.addGcvsCurve("M", 5.f, 0, 10.f, 99.f, epoch, 300., 40);
+	const int nova = photometry.addNovaCurve("NA", 3.f, 15.f, epoch, -1, -1, -1, -1);
+
+	QVERIFY(photometry.update(epoch+5.));
+	QCOMPARE(photometry.getMagnitude(mira), photometry.computeMagnitude(mira, epoch+5.));
+	QCOMPARE(photometry.getMagnitude(nova), photometry.computeMagnitude(nova, epoch+5.));
+	// Nothing to do for the same date
+	QVERIFY(!photometry.update(epoch+5.));
+	QVERIFY(photometry.update(epoch+180.));
+	QCOMPARE(photometry.getMagnitude(mira), 10.f);
+	// Another date is computed on demand
+	QCOMPARE(photometry.getMagnitude(mira, epoch+180.), 10.f);
+	QCOMPARE(photometry.getMagnitude(nova, epoch+10.), photometry.computeMagnitude(nova, epoch+10.));
+	// A curve added after the update is computed on demand until the next update
+	const int supernova = photometry.addSupernovaCurve("Ia", 12.f, epoch+170.);
+	QCOMPARE(photometry.getMagnitude(supernova, epoch+180.), photometry.computeMagnitude(supernova, epoch+180.));
+
+	photometry.clear();
+	QCOMPARE(photometry.size(), 0);
+}
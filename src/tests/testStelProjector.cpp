@@ -21,6 +21,8 @@
 
 #include <QObject>
 #include <QDebug>
+#include <QRect>
+#include <cmath>
 
 #include "StelProjectorClasses.hpp"
 #include "StelProjectorType.hpp"
@@ -625,3 +627,44 @@ void TestStelProjector::testStelProjectorMiller()
 	b.set(-1.,-1.,-1.);
 	QVERIFY(projection->backward(b));
 }
+
+void TestStelProjector::testTileParams()
+{
+	// The tiles of a large screenshot must join exactly: a point is projected at the same place in the full image and in a tile
+	StelProjector::StelProjectorParams params;
+	params.viewportXywh.set(0, 0, 3000, 2000);
+	params.viewportCenterOffset.set(0., 0.2);
+	params.viewportCenter.set(1500., (0.5+0.2)*2000.);
+	params.viewportFovDiameter = 2000.;
+	params.fov = 100.f;
+	StelProjector::ModelViewTranformP modelViewTransform(new StelProjector::Mat4dTransform(Mat4d::identity()));
+	StelProjectorP full(new StelProjectorStereographic(modelViewTransform));
+	full->init(params);
+
+	const QRect tile(1200, 300, 700, 500);
+	const StelProjector::StelProjectorParams tileParams = params.getTileParams(tile.x(), tile.y(), tile.width(), tile.height());
+	QCOMPARE(tileParams.viewportXywh[2], tile.width());
+	QCOMPARE(tileParams.viewportXywh[3], tile.height());
+	QCOMPARE(tileParams.viewportFovDiameter, params.viewportFovDiameter);
+	StelProjectorP tiled(new StelProjectorStereographic(modelViewTransform));
+	tiled->init(tileParams);
+
+	// GL coordinates, from the bottom left corner
+	const double tileLeft = tile.x();
+	const double tileBottom = params.viewportXywh[3]-tile.y()-tile.height();
+	for (int i=0; i<100; ++i)
+	{
+		const double ra = 0.05*i;
+		const double dec = 0.6*std::sin(0.3*i);
+		const Vec3d v(std::cos(dec)*std::cos(ra), std::cos(dec)*std::sin(ra), std::sin(dec));
+		Vec3d winFull, winTile;
+		const bool okFull = full->project(v, winFull);
+		const bool okTile = tiled->project(v, winTile);
+		QCOMPARE(okTile, okFull);
+		if (!okFull)
+			continue;
+		QVERIFY(qAbs(winTile[0]+tileLeft-winFull[0]) < 1e-6);
+		QVERIFY(qAbs(winTile[1]+tileBottom-winFull[1]) < 1e-6);
+		QVERIFY(qAbs(winTile[2]-winFull[2]) < 1e-9);
+	}
+}
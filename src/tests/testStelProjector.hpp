@@ -37,6 +37,7 @@ private slots:
 	void testStelProjectorOrthographic();
 	void testStelProjectorSinusoidal();
 	void testStelProjectorMiller();
+	void testTileParams();
 };
 
 #endif // _TESTSTELPROJECTOR_HPP
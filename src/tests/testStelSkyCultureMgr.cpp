@@ -21,12 +21,29 @@
 
 #include <QObject>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFile>
+#include <QImage>
 
 #include "StelSkyCultureMgr.hpp"
 #include "StelFileMgr.hpp"
+#include "SkyCultureBundle.hpp"
 
 QTEST_GUILESS_MAIN(TestStelSkyCultureMgr)
 
+void TestStelSkyCultureMgr::initTestCase()
+{
+	// Keep the bundles of the tests out of the user's cache directory.
+	QVERIFY(cacheDir.isValid());
+	SkyCultureBundle::setCacheDir(cacheDir.path() + "/cache");
+}
+
+void TestStelSkyCultureMgr::cleanupTestCase()
+{
+	SkyCultureBundle::setCacheDir(QString());
+}
+
 void TestStelSkyCultureMgr::testStelSkyCultureMgr()
 {
 	StelFileMgr::init();
@@ -43,3 +60,101 @@ void TestStelSkyCultureMgr::testStelSkyCultureMgr()
 	QVERIFY(scMgr.getCurrentSkyCultureClassificationIdx()==StelSkyCulture::TRADITIONAL);
 	QVERIFY(scMgr.getSkyCultureListEnglish().contains("western", Qt::CaseInsensitive));
 }
+
+void TestStelSkyCultureMgr::testSkyCultureBundles()
+{
+	StelFileMgr::init();
+
+	StelSkyCultureMgr scMgr;
+	const QMap<QString, StelSkyCulture> cultures = scMgr.getDirToNameMap();
+	QVERIFY(cultures.contains("western"));
+
+	// Parse the text files of all sky cultures
+	QMap<QString, SkyCultureBundle> compiled;
+	QElapsedTimer timer;
+	timer.start();
+	for (auto it = cultures.constBegin(); it != cultures.constEnd(); ++it)
+		compiled.insert(it.key(), SkyCultureBundle::load(it.key(), it.value().boundaries, false));
+	const qint64 compileTime = timer.elapsed();
+
+	// Make sure that the cache files are up to date
+	for (auto it = cultures.constBegin(); it != cultures.constEnd(); ++it)
+		SkyCultureBundle::load(it.key(), it.value().boundaries);
+
+	// Read all sky cultures from the cache
+	timer.restart();
+	QMap<QString, SkyCultureBundle> cached;
+	for (auto it = cultures.constBegin(); it != cultures.constEnd(); ++it)
+		cached.insert(it.key(), SkyCultureBundle::load(it.key(), it.value().boundaries));
+	const qint64 cacheTime = timer.elapsed();
+
+	qDebug() << "Loaded" << cultures.size() << "sky cultures in" << compileTime << "ms from text files and in" << cacheTime << "ms from the cache";
+
+	for (const auto& id : compiled.keys())
+	{
+		const SkyCultureBundle& a = compiled.value(id);
+		const SkyCultureBundle& b = cached.value(id);
+		QVERIFY2(a.constellationLines.size()==b.constellationLines.size(), qPrintable(id));
+		QVERIFY2(a.constellationArt.size()==b.constellationArt.size(), qPrintable(id));
+		QVERIFY2(a.constellationNames.size()==b.constellationNames.size(), qPrintable(id));
+		QVERIFY2(a.seasonalRules.size()==b.seasonalRules.size(), qPrintable(id));
+		QVERIFY2(a.boundaries.size()==b.boundaries.size(), qPrintable(id));
+		QVERIFY2(a.asterismLines.size()==b.asterismLines.size(), qPrintable(id));
+		QVERIFY2(a.asterismNames.size()==b.asterismNames.size(), qPrintable(id));
+		for (int i=0; i<a.constellationLines.size(); ++i)
+		{
+			QVERIFY(a.constellationLines.at(i).abbreviation==b.constellationLines.at(i).abbreviation);
+			QVERIFY(a.constellationLines.at(i).points==b.constellationLines.at(i).points);
+		}
+	}
+
+	const SkyCultureBundle& western = compiled.value("western");
+	QVERIFY(western.constellationLines.size()==88);
+	QVERIFY(!western.boundaries.isEmpty());
+}
+
+static bool writeTextFile(const QString& fileName, const QByteArray& contents)
+{
+	QFile file(fileName);
+	return file.open(QIODevice::WriteOnly) && file.write(contents)==contents.size();
+}
+
+void TestStelSkyCultureMgr::testSkyCultureBundleArtChange()
+{
+	StelFileMgr::init();
+
+	// A minimal sky culture in a search path of its own
+	const QString dataDir = cacheDir.path() + "/data";
+	const QString cultureDir = dataDir + "/skycultures/bundletest";
+	QVERIFY(QDir().mkpath(cultureDir));
+	QVERIFY(writeTextFile(cultureDir + "/constellationship.fab", "Ori 2 26727 27989 27989 24436\n"));
+	QVERIFY(writeTextFile(cultureDir + "/constellation_names.eng.fab", "Ori \"Orion\" _(\"Orion\")\n"));
+	QVERIFY(writeTextFile(cultureDir + "/constellationsart.fab", "Ori orion.png 10 10 26727 50 10 27989 10 50 24436\n"));
+	QImage image(64, 32, QImage::Format_ARGB32);
+	image.fill(Qt::transparent);
+	QVERIFY(image.save(cultureDir + "/orion.png"));
+
+	const QStringList searchPaths = StelFileMgr::getSearchPaths();
+	StelFileMgr::setSearchPaths(QStringList() << dataDir << searchPaths);
+
+	SkyCultureBundle bundle = SkyCultureBundle::load("bundletest", -1);
+	QCOMPARE(bundle.constellationArt.size(), 1);
+	QCOMPARE(bundle.constellationArt.at(0).textureWidth, 64);
+	QCOMPARE(bundle.constellationArt.at(0).textureHeight, 32);
+	QVERIFY(QFile::exists(cacheDir.path() + "/cache/bundletest.bundle"));
+
+	// Replacing the art image must invalidate the cached texture size, in memory and on disk.
+	image = QImage(128, 96, QImage::Format_ARGB32);
+	image.fill(Qt::transparent);
+	QVERIFY(image.save(cultureDir + "/orion.png"));
+	bundle = SkyCultureBundle::load("bundletest", -1);
+	QCOMPARE(bundle.constellationArt.at(0).textureWidth, 128);
+	QCOMPARE(bundle.constellationArt.at(0).textureHeight, 96);
+
+	SkyCultureBundle::setCacheDir(cacheDir.path() + "/cache"); // forget the last bundle, read the cache file
+	bundle = SkyCultureBundle::load("bundletest", -1);
+	QCOMPARE(bundle.constellationArt.at(0).textureWidth, 128);
+	QCOMPARE(bundle.constellationLines.size(), 1);
+
+	StelFileMgr::setSearchPaths(searchPaths);
+}
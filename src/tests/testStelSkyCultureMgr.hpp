@@ -22,6 +22,7 @@
 
 #include <QObject>
 #include <QtTest>
+#include <QTemporaryDir>
 
 class StelSkyCultureMgr;
 
@@ -30,8 +31,13 @@ class TestStelSkyCultureMgr : public QObject
 Q_OBJECT
 private slots:
 	void testStelSkyCultureMgr();
+	void initTestCase();
+	void cleanupTestCase();
+	void testSkyCultureBundles();
+	void testSkyCultureBundleArtChange();
 
 private:
+	QTemporaryDir cacheDir;
 };
 
 #endif // TESTSTELSKYCULTUREMGR_HPP
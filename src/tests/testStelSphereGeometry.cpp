@@ -23,10 +23,14 @@
 #include <QtDebug>
 #include <QBuffer>
 
+#include <algorithm>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include "StelJsonParser.hpp"
 #include "StelSphereGeometry.hpp"
+#include "StelSphericalMOC.hpp"
 #include "StelUtils.hpp"
 
 QTEST_GUILESS_MAIN(TestStelSphericalGeometry)
@@ -542,3 +546,383 @@ void TestStelSphericalGeometry::benchmarkCreatePolygon()
 		SphericalPolygon holySquare(contours);
 	}
 }
+
+static double randomUnit()
+{
+	return static_cast<double>(qrand())/RAND_MAX;
+}
+
+static Vec3d randomDirection()
+{
+	Vec3d v;
+	StelUtils::spheToRect(2.*M_PI*randomUnit(), std::asin(2.*randomUnit()-1.), v);
+	return v;
+}
+
+// Return whether the point is close to the great circle of one of the contour sides, where the containment is ambiguous
+static bool isCloseToSides(const Vec3d& p, const QVector<QVector<Vec3d> >& contours)
+{
+	for (const auto& contour : contours)
+	{
+		for (int i=0;i<contour.size();++i)
+		{
+			Vec3d n = contour.at((i+1)%contour.size())^contour.at(i);
+			n.normalize();
+			if (std::fabs(n*p)<1e-6)
+				return true;
+		}
+	}
+	return false;
+}
+
+QVector<Vec3d> TestStelSphericalGeometry::randomConvexContour()
+{
+	const Vec3d center = randomDirection();
+	Vec3d e1 = (std::fabs(center[0])<0.9 ? Vec3d(1,0,0) : Vec3d(0,1,0))^center;
+	e1.normalize();
+	const Vec3d e2 = center^e1;
+	const double radius = 0.05+1.2*randomUnit();
+	const int nbPoints = 3+qrand()%6;
+	const double phase = 2.*M_PI*randomUnit();
+	QVector<Vec3d> contour;
+	// Clockwise seen from outside, i.e. positive orientation
+	for (int i=0;i<nbPoints;++i)
+	{
+		const double t = phase-2.*M_PI*i/nbPoints;
+		contour << center*std::cos(radius) + (e1*std::cos(t)+e2*std::sin(t))*std::sin(radius);
+	}
+	return contour;
+}
+
+QVector<Vec3d> TestStelSphericalGeometry::horizonContour(int nbPoints)
+{
+	QVector<Vec3d> contour;
+	for (int i=0;i<nbPoints;++i)
+	{
+		const double az = -2.*M_PI*i/nbPoints;
+		Vec3d v;
+		StelUtils::spheToRect(az, (5.+4.*std::sin(7.*az)+std::sin(31.*az))*M_PI/180., v);
+		contour << v;
+	}
+	return contour;
+}
+
+void TestStelSphericalGeometry::testConvexPolygonSet()
+{
+	// The convex polygons cover exactly the tesselated polygon
+	QVERIFY(std::fabs(ConvexPolygonSet(holySquare.getOctahedronPolygon()).getArea()-holySquare.getOctahedronPolygon().getArea())<1e-10);
+	QVERIFY(std::fabs(ConvexPolygonSet(bigSquareConvex.getConvexContour()).getArea()-bigSquareConvex.getArea())<1e-10);
+	QCOMPARE(ConvexPolygonSet::allSky().getArea(), 4.*M_PI);
+	QVERIFY(ConvexPolygonSet().isEmpty());
+	QVERIFY(!ConvexPolygonSet::allSky().isEmpty());
+
+	// Subtraction from the full sky, as done for landscape horizons
+	const SphericalPolygon aboveHorizon(horizonContour(360));
+	const Vec3d zenith(0,0,1);
+	const Vec3d nadir(0,0,-1);
+	QVERIFY(aboveHorizon.contains(zenith));
+	SphericalRegionP horizon = AllSkySphericalRegion().getSubtraction(aboveHorizon);
+	QVERIFY(!horizon->contains(zenith));
+	QVERIFY(horizon->contains(nadir));
+	QVERIFY(std::fabs(horizon->getArea()+aboveHorizon.getArea()-4.*M_PI)<1e-10);
+	SphericalRegionP inverted = AllSkySphericalRegion().getSubtraction(horizon);
+	QVERIFY(std::fabs(inverted->getArea()-aboveHorizon.getArea())<1e-10);
+	QVERIFY(inverted->contains(zenith));
+
+	// The triangles and the octahedron polygon of a result are only computed on demand
+	const QVector<Vec3d> triangles = horizon->getFillVertexArray().vertex;
+	QVERIFY(!triangles.isEmpty());
+	QCOMPARE(triangles.size()%3, 0);
+	QVERIFY(horizon->contains(horizon->getPointInside()));
+	QVERIFY(std::fabs(horizon->getOctahedronPolygon().getArea()-horizon->getArea())<1e-6);
+	QVERIFY(!horizon->getOutlineVertexArray().vertex.isEmpty());
+
+	// Degenerated results
+	QVERIFY(bigSquare.getSubtraction(bigSquare)->isEmpty());
+	QVERIFY(bigSquare.getIntersection(opositeSquare)->isEmpty());
+	QVERIFY(bigSquare.contains(smallSquare));
+	QVERIFY(bigSquare.contains(holySquare));
+	QVERIFY(!smallSquare.contains(bigSquare));
+}
+
+void TestStelSphericalGeometry::testConvexContours()
+{
+	// A positive convex contour is used as it is, other contours go through the tesselation
+	qsrand(20260917);
+	for (int i=0;i<50;++i)
+	{
+		QVector<Vec3d> contour = randomConvexContour();
+		QVERIFY(ConvexPolygonSet::isConvexContour(contour));
+		const SphericalPolygon direct(contour);
+		const OctahedronPolygon tesselated(contour);
+		QVERIFY(std::fabs(direct.getArea()-tesselated.getArea())<1e-10);
+		QVERIFY(direct.contains(direct.getPointInside()));
+		QVERIFY(!direct.getOutlineVertexArray().vertex.isEmpty());
+
+		// The opposite orientation stands for the rest of the sphere
+		std::reverse(contour.begin(), contour.end());
+		QVERIFY(!ConvexPolygonSet::isConvexContour(contour));
+		const SphericalPolygon reversed(contour);
+		QVERIFY(std::fabs(reversed.getArea()-tesselated.getArea())>1e-6);
+	}
+
+	// Caps smaller and larger than a hemisphere
+	const SphericalCap smallCap(Vec3d(1,0,0), std::cos(0.3));
+	const SphericalCap largeCap(Vec3d(0,1,0), std::cos(2.));
+	QVERIFY(std::fabs(smallCap.getConvexPolygonSet().getArea()-smallCap.getOctahedronPolygon().getArea())<1e-10);
+	QVERIFY(std::fabs(largeCap.getConvexPolygonSet().getArea()-largeCap.getOctahedronPolygon().getArea())<1e-6);
+	QVERIFY(largeCap.getConvexPolygonSet().contains(Vec3d(0,1,0)));
+	QVERIFY(!largeCap.getConvexPolygonSet().contains(Vec3d(0,-1,0)));
+	QVERIFY(smallCap.getConvexPolygonSet().contains(Vec3d(1,0,0)));
+	const SphericalCap hemisphere(Vec3d(0,0,1), 0.);
+	QVERIFY(std::fabs(hemisphere.getConvexPolygonSet().getArea()-hemisphere.getOctahedronPolygon().getArea())<1e-6);
+
+	// Subtracting distant pieces leaves the region unchanged, whatever their number
+	QVector<QVector<Vec3d> > farContours;
+	for (int i=0;i<100;++i)
+	{
+		Vec3d center(-1., 0.001*i, 0.);
+		center.normalize();
+		farContours << SphericalCap(center, std::cos(0.0004)).getClosedOutlineContour();
+	}
+	ConvexPolygonSet set(SphericalCap(Vec3d(1,0,0), std::cos(0.5)).getClosedOutlineContour());
+	const double area = set.getArea();
+	set.inPlaceSubtraction(ConvexPolygonSet(farContours));
+	QCOMPARE(set.getPieces().size(), 1);
+	QVERIFY(std::fabs(set.getArea()-area)<1e-12);
+}
+
+void TestStelSphericalGeometry::testConcurrentCaches()
+{
+	// The lazily computed vertex arrays of a shared polygon are requested from several threads at the same time
+	qsrand(20260918);
+	for (int i=0;i<20;++i)
+	{
+		QVector<QVector<Vec3d> > contours;
+		contours << randomConvexContour() << randomConvexContour();
+		const SphericalRegionP region = AllSkySphericalRegion().getSubtraction(SphericalPolygon(contours));
+		std::vector<std::thread> threads;
+		std::vector<int> outlineSizes(4), fillSizes(4);
+		for (int t=0;t<4;++t)
+		{
+			threads.emplace_back([&, t]() {
+				outlineSizes[t] = region->getOutlineVertexArray().vertex.size();
+				fillSizes[t] = region->getFillVertexArray().vertex.size();
+				region->getOctahedronPolygon();
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		for (int t=1;t<4;++t)
+		{
+			QCOMPARE(outlineSizes[t], outlineSizes[0]);
+			QCOMPARE(fillSizes[t], fillSizes[0]);
+		}
+		QVERIFY(outlineSizes[0]>0);
+	}
+}
+
+void TestStelSphericalGeometry::testRandomBooleanOperations()
+{
+	qsrand(20190626);
+	for (int i=0;i<200;++i)
+	{
+		// Non convex polygon made of 2 overlapping contours, and a convex one
+		QVector<QVector<Vec3d> > contoursA;
+		contoursA << randomConvexContour() << randomConvexContour();
+		QVector<QVector<Vec3d> > contoursB;
+		contoursB << randomConvexContour();
+		const SphericalPolygon a(contoursA);
+		const SphericalPolygon b(contoursB);
+		const OctahedronPolygon octA = a.getOctahedronPolygon();
+		const OctahedronPolygon octB = b.getOctahedronPolygon();
+
+		// Reference results using the tesselation
+		OctahedronPolygon refIntersection(octA);
+		refIntersection.inPlaceIntersection(octB);
+		OctahedronPolygon refUnion(octA);
+		refUnion.inPlaceUnion(octB);
+		OctahedronPolygon refSubtraction(octA);
+		refSubtraction.inPlaceSubtraction(octB);
+
+		const SphericalRegionP intersection = a.getIntersection(b);
+		const SphericalRegionP unionReg = a.getUnion(b);
+		const SphericalRegionP subtraction = a.getSubtraction(b);
+		const SphericalRegionP complement = AllSkySphericalRegion().getSubtraction(a);
+
+		QVERIFY2(std::fabs(a.getArea()-octA.getArea())<1e-6, qPrintable(QString("area %1 != %2").arg(a.getArea()).arg(octA.getArea())));
+		QVERIFY2(std::fabs(intersection->getArea()-refIntersection.getArea())<1e-6, qPrintable(QString("intersection area %1 != %2").arg(intersection->getArea()).arg(refIntersection.getArea())));
+		QVERIFY2(std::fabs(unionReg->getArea()-refUnion.getArea())<1e-6, qPrintable(QString("union area %1 != %2").arg(unionReg->getArea()).arg(refUnion.getArea())));
+		QVERIFY2(std::fabs(subtraction->getArea()-refSubtraction.getArea())<1e-6, qPrintable(QString("subtraction area %1 != %2").arg(subtraction->getArea()).arg(refSubtraction.getArea())));
+		QVERIFY(std::fabs(complement->getArea()+a.getArea()-4.*M_PI)<1e-10);
+		if (refIntersection.getArea()>1e-6)
+			QVERIFY(a.intersects(b));
+
+		const QVector<QVector<Vec3d> > allContours = contoursA + contoursB;
+		for (int j=0;j<100;++j)
+		{
+			const Vec3d p = randomDirection();
+			if (isCloseToSides(p, allContours))
+				continue;
+			const bool inA = octA.contains(p);
+			const bool inB = octB.contains(p);
+			QCOMPARE(a.contains(p), inA);
+			QCOMPARE(b.contains(p), inB);
+			QCOMPARE(intersection->contains(p), inA && inB);
+			QCOMPARE(unionReg->contains(p), inA || inB);
+			QCOMPARE(subtraction->contains(p), inA && !inB);
+			QCOMPARE(complement->contains(p), !inA);
+			QCOMPARE(refIntersection.contains(p), inA && inB);
+		}
+	}
+}
+
+void TestStelSphericalGeometry::benchmarkBooleanOperations()
+{
+	const SphericalPolygon aboveHorizon(horizonContour(720));
+	const AllSkySphericalRegion allSky;
+	const Vec3d p(0.5,0.5,0.1);
+	QBENCHMARK {
+		SphericalRegionP horizon = allSky.getSubtraction(aboveHorizon);
+		SphericalRegionP visible = bigSquare.getSubtraction(horizon);
+		visible->getArea();
+		horizon->contains(p);
+	}
+}
+
+void TestStelSphericalGeometry::benchmarkOctahedronBooleanOperations()
+{
+	const OctahedronPolygon aboveHorizon(horizonContour(720));
+	const OctahedronPolygon bigSquareOct = bigSquare.getOctahedronPolygon();
+	const Vec3d p(0.5,0.5,0.1);
+	QBENCHMARK {
+		OctahedronPolygon horizon(OctahedronPolygon::getAllSkyOctahedronPolygon());
+		horizon.inPlaceSubtraction(aboveHorizon);
+		OctahedronPolygon visible(bigSquareOct);
+		visible.inPlaceSubtraction(horizon);
+		visible.getArea();
+		horizon.contains(p);
+	}
+}
+
+void TestStelSphericalGeometry::testSphericalMOC()
+{
+	// The center of a cell is inside the cell
+	for (int order=0;order<=SphericalMOC::MAX_ORDER;order+=7)
+	{
+		const QVector<quint64> indices = QVector<quint64>() << 0 << 5 << (Q_UINT64_C(12) << (2*order))-1;
+		for (auto index : indices)
+			QCOMPARE(SphericalMOC::cellIndex(order, SphericalMOC::cellCenter(order, index)), index);
+	}
+
+	// The 4 first cells of order 3 are merged in the first cell of order 2
+	const SphericalMOC cells = SphericalMOC::fromNestedCells(3, QVector<quint64>() << 10 << 0 << 1 << 2 << 3);
+	QCOMPARE(cells.getOrder(), 3);
+	QCOMPARE(cells.getCellsCount(3), Q_UINT64_C(5));
+	QCOMPARE(cells.getCellsCount(2), Q_UINT64_C(2));
+	QCOMPARE(cells.getUniqCells(), QVector<quint64>() << 4*16 << 4*64+10);
+	QVERIFY(std::fabs(cells.getArea()-5.*4.*M_PI/(12.*64.))<1e-15);
+	QCOMPARE(SphericalMOC::fromUniqCells(cells.getUniqCells()).getRanges(), cells.getRanges());
+
+	// Coverage of a cap, the cells of order 8 are about 0.23 deg wide
+	Vec3d v15, v30;
+	StelUtils::spheToRect(15.*M_PI/180., 0., v15);
+	StelUtils::spheToRect(30.*M_PI/180., 0., v30);
+	const SphericalCap cap(Vec3d(1,0,0), std::cos(10.*M_PI/180.));
+	const SphericalCap shiftedCap(v15, std::cos(10.*M_PI/180.));
+	const SphericalMOC outer(&cap, 8);
+	const SphericalMOC inner(&cap, 8, true);
+	QCOMPARE(outer.getOrder(), 8);
+	QVERIFY(outer.contains(inner));
+	QVERIFY(!inner.contains(outer));
+	QVERIFY(inner.getArea()<cap.getArea() && cap.getArea()<outer.getArea());
+	QVERIFY(outer.getArea()-inner.getArea()<0.015);
+	QVERIFY(outer.contains(Vec3d(1,0,0)));
+	QVERIFY(!outer.contains(Vec3d(-1,0,0)));
+	QVERIFY(outer.getBoundingCap().contains(cap));
+
+	// Tests with the other regions
+	QVERIFY(outer.contains(SphericalCap(Vec3d(1,0,0), std::cos(9.*M_PI/180.))));
+	QVERIFY(!outer.contains(SphericalCap(Vec3d(1,0,0), std::cos(11.*M_PI/180.))));
+	QVERIFY(outer.intersects(SphericalCap(v15, std::cos(6.*M_PI/180.))));
+	QVERIFY(!outer.intersects(SphericalCap(v30, std::cos(5.*M_PI/180.))));
+	QVERIFY(bigSquare.contains(&outer));
+	QVERIFY(bigSquare.intersects(&outer));
+	QVERIFY(outer.intersects(&bigSquare));
+	QVERIFY(!outer.contains(&bigSquare));
+	QVERIFY(SphericalCap(Vec3d(1,0,0), std::cos(11.*M_PI/180.)).contains(&outer));
+	QVERIFY(!SphericalCap(Vec3d(1,0,0), std::cos(9.*M_PI/180.)).contains(&outer));
+
+	// Boolean operations between MOCs are exact
+	const SphericalMOC shifted(&shiftedCap, 8);
+	const SphericalRegionP mocUnion = outer.getUnion(shifted);
+	const SphericalRegionP mocIntersection = outer.getIntersection(shifted);
+	const SphericalRegionP mocSubtraction = outer.getSubtraction(shifted);
+	QVERIFY(mocUnion->getType()==SphericalRegion::MOC);
+	QVERIFY(std::fabs(mocUnion->getArea()+mocIntersection->getArea()-outer.getArea()-shifted.getArea())<1e-12);
+	QVERIFY(std::fabs(mocSubtraction->getArea()+mocIntersection->getArea()-outer.getArea())<1e-12);
+	QVERIFY(!mocSubtraction->intersects(&shifted));
+	QVERIFY(mocUnion->contains(&outer) && mocUnion->contains(&shifted));
+	QVERIFY(std::fabs(outer.getComplement().getArea()+outer.getArea()-4.*M_PI)<1e-12);
+
+	// Operations with the other regions return MOCs at the order of the MOC
+	QCOMPARE(outer.getIntersection(&shiftedCap)->getArea(), mocIntersection->getArea());
+	const SphericalRegion* shiftedCapRegion = &shiftedCap;
+	QCOMPARE(shiftedCapRegion->getIntersection(&outer)->getArea(), mocIntersection->getArea());
+	QCOMPARE(shiftedCapRegion->getUnion(&outer)->getArea(), mocUnion->getArea());
+
+	// Drawing
+	QCOMPARE(outer.getFillVertexArray().vertex.size()%6, 0);
+	QVERIFY(!outer.getOutlineVertexArray().vertex.isEmpty());
+	QVERIFY(outer.getFillVertexArray(SphericalCap(v30, std::cos(5.*M_PI/180.)), 8).vertex.isEmpty());
+
+	// JSON serialization
+	SphericalRegionP reg = SphericalRegionP::loadFromQVariant(outer.toQVariant());
+	QVERIFY(reg->getType()==SphericalRegion::MOC);
+	QCOMPARE(static_cast<const SphericalMOC*>(reg.data())->getRanges(), outer.getRanges());
+	reg = SphericalRegionP::loadFromJson(StelJsonParser::write(outer.toJsonMap()));
+	QCOMPARE(static_cast<const SphericalMOC*>(reg.data())->getRanges(), outer.getRanges());
+	reg = SphericalRegionP::loadFromJson(QByteArray("{\"3\":[0,1,2,3,10],\"4\":[]}"));
+	QCOMPARE(static_cast<const SphericalMOC*>(reg.data())->getUniqCells(), cells.getUniqCells());
+	QCOMPARE(static_cast<const SphericalMOC*>(reg.data())->getOrder(), 4);
+
+	// Binary serialization
+	QByteArray ar;
+	QBuffer buf(&ar);
+	buf.open(QIODevice::WriteOnly);
+	QDataStream out(&buf);
+	out << SphericalRegionP(new SphericalMOC(outer));
+	buf.close();
+	buf.open(QIODevice::ReadOnly);
+	QDataStream in(&buf);
+	in >> reg;
+	buf.close();
+	QVERIFY(reg->getType()==SphericalRegion::MOC);
+	QCOMPARE(static_cast<const SphericalMOC*>(reg.data())->getRanges(), outer.getRanges());
+
+	// FITS serialization
+	QByteArray fits;
+	QBuffer fitsBuf(&fits);
+	fitsBuf.open(QIODevice::WriteOnly);
+	QVERIFY(outer.saveToFits(&fitsBuf));
+	fitsBuf.close();
+	QCOMPARE(fits.size()%2880, 0);
+	QVERIFY(fits.startsWith("SIMPLE  =                    T"));
+	fitsBuf.open(QIODevice::ReadOnly);
+	reg = SphericalMOC::loadFromFits(&fitsBuf);
+	fitsBuf.close();
+	QCOMPARE(static_cast<const SphericalMOC*>(reg.data())->getRanges(), outer.getRanges());
+	QCOMPARE(static_cast<const SphericalMOC*>(reg.data())->getOrder(), 8);
+}
+
+void TestStelSphericalGeometry::benchmarkSphericalMOC()
+{
+	const SphericalMOC moc(&bigSquare, 12);
+	const SphericalMOC other(&smallSquareConvex, 12);
+	const Vec3d p(0.5,0.5,0.1);
+	QBENCHMARK {
+		moc.contains(p);
+		moc.intersects(smallSquareConvex);
+		moc.getSubtraction(other)->getArea();
+	}
+}
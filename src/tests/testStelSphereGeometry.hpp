@@ -44,7 +44,20 @@ private slots:
 	void benchmarkGetIntersection();
 	void testSerialize();
 	void benchmarkCreatePolygon();
+	void testConvexPolygonSet();
+	void testConvexContours();
+	void testConcurrentCaches();
+	void testRandomBooleanOperations();
+	void benchmarkBooleanOperations();
+	void benchmarkOctahedronBooleanOperations();
+	void testSphericalMOC();
+	void benchmarkSphericalMOC();
 private:
+	//! Return a random regular polygon of angular radius up to 1.25 rad, positively oriented.
+	static QVector<Vec3d> randomConvexContour();
+	//! Return a horizon like contour around the zenith, with altitudes between 0 and 10 deg.
+	static QVector<Vec3d> horizonContour(int nbPoints);
+
 	SphericalPolygon holySquare;
 	SphericalPolygon bigSquare;
 	SphericalPolygon smallSquare;
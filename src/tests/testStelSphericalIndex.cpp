@@ -21,7 +21,10 @@
 
 #include <QObject>
 #include <QDebug>
+#include <QSet>
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 #include "StelSphereGeometry.hpp"
@@ -39,8 +42,34 @@ class TestRegionObject : public StelRegionObject
 		SphericalRegionP region;
 };
 
+class TestPointObject : public StelRegionObject
+{
+	public:
+		TestPointObject(const Vec3d& p) : point(p) {;}
+		virtual SphericalRegionP getRegion() const { return SphericalRegionP(new SphericalPoint(point)); }
+		virtual Vec3d getPointInRegion() const { return point; }
+		Vec3d point;
+};
+
+static Vec3d randomPoint()
+{
+	const double z = 2.*static_cast<double>(qrand())/RAND_MAX - 1.;
+	const double lon = 2.*M_PI*static_cast<double>(qrand())/RAND_MAX;
+	const double r = std::sqrt(1.-z*z);
+	return Vec3d(r*std::cos(lon), r*std::sin(lon), z);
+}
+
+static QVector<StelRegionObjectP> randomPointObjects(int nb)
+{
+	QVector<StelRegionObjectP> objs;
+	for (int i=0;i<nb;++i)
+		objs.append(StelRegionObjectP(new TestPointObject(randomPoint())));
+	return objs;
+}
+
 void TestStelSphericalIndex::initTestCase()
 {
+	qsrand(0);
 }
 
 struct CountFuncObject
@@ -53,6 +82,27 @@ struct CountFuncObject
 	int count;
 };
 
+struct CollectFuncObject
+{
+	void operator()(const StelRegionObject* obj)
+	{
+		objs.insert(obj);
+	}
+	QSet<const StelRegionObject*> objs;
+};
+
+// Return the objects within the given radius, computed by brute force.
+static QSet<const StelRegionObject*> objectsWithinRadius(const QVector<StelRegionObjectP>& objs, const Vec3d& p, double radius)
+{
+	QSet<const StelRegionObject*> res;
+	for (const auto& obj : objs)
+	{
+		if (obj->getPointInRegion()*p>=std::cos(radius))
+			res.insert(obj.data());
+	}
+	return res;
+}
+
 void TestStelSphericalIndex::testBase()
 {
 	StelSphericalIndex grid(10);
@@ -114,3 +164,155 @@ void TestStelSphericalIndex::testBase()
 	QVERIFY(countFunc.count==40000);
 }
 
+
+void TestStelSphericalIndex::testRemoveUpdate()
+{
+	StelSphericalIndex grid(10);
+	QVector<StelRegionObjectP> objs = randomPointObjects(2000);
+	for (const auto& obj : objs)
+		grid.insert(obj);
+	QCOMPARE(grid.count(), 2000u);
+
+	// Remove half of the objects
+	QVector<StelRegionObjectP> kept;
+	for (int i=0;i<objs.size();++i)
+	{
+		if (i%2)
+			kept.append(objs.at(i));
+		else
+			QVERIFY(grid.remove(objs.at(i)));
+	}
+	QCOMPARE(grid.count(), 1000u);
+	QVERIFY(!grid.contains(objs.at(0)));
+	QVERIFY(grid.contains(objs.at(1)));
+	QVERIFY(!grid.remove(objs.at(0)));
+	CollectFuncObject all;
+	grid.processAll(all);
+	for (const auto& obj : kept)
+		QVERIFY(all.objs.contains(obj.data()));
+
+	// Move the remaining objects, some of them only slightly so that they stay in their node
+	for (int i=0;i<kept.size();++i)
+	{
+		TestPointObject* obj = static_cast<TestPointObject*>(kept.at(i).data());
+		if (i%3)
+			obj->point = randomPoint();
+		else
+		{
+			obj->point += Vec3d(1e-7, 0., 0.);
+			obj->point.normalize();
+		}
+		QVERIFY(grid.update(kept.at(i)));
+	}
+	QVERIFY(!grid.update(objs.at(0)));
+	QCOMPARE(grid.count(), 1000u);
+	for (int i=0;i<20;++i)
+	{
+		const Vec3d p = randomPoint();
+		CollectFuncObject func;
+		grid.processWithinRadius(p, 0.3, func);
+		QCOMPARE(func.objs, objectsWithinRadius(kept, p, 0.3));
+	}
+
+	// Removing everything merges the tree back, and it can be filled again
+	for (const auto& obj : kept)
+		QVERIFY(grid.remove(obj));
+	QCOMPARE(grid.count(), 0u);
+	for (const auto& obj : objs)
+		grid.insert(obj);
+	QCOMPARE(grid.count(), 2000u);
+	grid.clear();
+	QVERIFY(!grid.contains(objs.at(1)));
+	QCOMPARE(grid.count(), 0u);
+}
+
+void TestStelSphericalIndex::testBulkInsert()
+{
+	const QVector<StelRegionObjectP> objs = randomPointObjects(5000);
+	StelSphericalIndex bulkGrid(10);
+	bulkGrid.insert(objs);
+	StelSphericalIndex grid(10);
+	for (const auto& obj : objs)
+		grid.insert(obj);
+	QCOMPARE(bulkGrid.count(), 5000u);
+
+	for (int i=0;i<20;++i)
+	{
+		const SphericalCap cap(randomPoint(), std::cos(0.2));
+		CollectFuncObject bulkFunc;
+		bulkGrid.processIntersectingRegions(&cap, bulkFunc);
+		CollectFuncObject func;
+		grid.processIntersectingRegions(&cap, func);
+		QCOMPARE(bulkFunc.objs, func.objs);
+		QCOMPARE(bulkFunc.objs, objectsWithinRadius(objs, cap.n, 0.2));
+	}
+
+	// A bulk insertion can be made in a non empty grid, and its objects removed
+	bulkGrid.insert(randomPointObjects(100));
+	QCOMPARE(bulkGrid.count(), 5100u);
+	for (const auto& obj : objs)
+		QVERIFY(bulkGrid.remove(obj));
+	QCOMPARE(bulkGrid.count(), 100u);
+}
+
+void TestStelSphericalIndex::testNearest()
+{
+	const QVector<StelRegionObjectP> objs = randomPointObjects(3000);
+	StelSphericalIndex grid(10);
+	grid.insert(objs);
+
+	for (int i=0;i<20;++i)
+	{
+		const Vec3d p = randomPoint();
+		QVector<double> distances;
+		for (const auto& obj : objs)
+			distances.append(p.angle(obj->getPointInRegion()));
+		std::sort(distances.begin(), distances.end());
+
+		const QVector<StelRegionObjectP> nearest = grid.findNearest(p, 10);
+		QCOMPARE(nearest.size(), 10);
+		for (int j=0;j<nearest.size();++j)
+			QCOMPARE(p.angle(nearest.at(j)->getPointInRegion()), distances.at(j));
+
+		// Limit the distance instead of the number of objects
+		const QVector<StelRegionObjectP> inRadius = grid.findNearest(p, objs.size(), 0.1);
+		QCOMPARE(inRadius.size(), objectsWithinRadius(objs, p, 0.1).size());
+		for (const auto& obj : inRadius)
+			QVERIFY(p.angle(obj->getPointInRegion())<=0.1);
+	}
+	QVERIFY(StelSphericalIndex().findNearest(Vec3d(1,0,0), 10).isEmpty());
+}
+
+void TestStelSphericalIndex::benchmarkChurn()
+{
+	// Typical update of moving objects: all the objects move slightly, and some of them appear or disappear
+	StelSphericalIndex grid;
+	QVector<StelRegionObjectP> objs = randomPointObjects(20000);
+	grid.insert(objs);
+	int i=0;
+	QBENCHMARK {
+		for (int j=0;j<1000;++j, ++i)
+		{
+			const StelRegionObjectP& obj = objs.at(i%objs.size());
+			Vec3d& point = static_cast<TestPointObject*>(obj.data())->point;
+			point += Vec3d(0.001, 0.002, -0.001);
+			point.normalize();
+			grid.update(obj);
+			if (j%10==0)
+			{
+				grid.remove(obj);
+				grid.insert(obj);
+			}
+		}
+	}
+	QCOMPARE(grid.count(), 20000u);
+}
+
+void TestStelSphericalIndex::benchmarkBulkInsert()
+{
+	const QVector<StelRegionObjectP> objs = randomPointObjects(20000);
+	QBENCHMARK {
+		StelSphericalIndex grid;
+		grid.insert(objs);
+	}
+}
@@ -31,6 +31,11 @@ Q_OBJECT
 private slots:
 	void initTestCase();
 	void testBase();
+	void testRemoveUpdate();
+	void testBulkInsert();
+	void testNearest();
+	void benchmarkChurn();
+	void benchmarkBulkInsert();
 private:
 };
 
@@ -0,0 +1,135 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelVideoSkyLayer.hpp"
+#include "StelVideoSkyLayer.hpp"
+
+#include <QColor>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QTextStream>
+
+QTEST_GUILESS_MAIN(TestStelVideoSkyLayer)
+
+#define ERROR_LIMIT 1e-6
+
+void TestStelVideoSkyLayer::initTestCase()
+{
+	QVERIFY(tempDir.isValid());
+	QDir dir(tempDir.path());
+	QVERIFY(dir.mkdir("sequence"));
+	sequenceDir = dir.absoluteFilePath("sequence");
+
+	// Written out of order, the frames are sorted by file name
+	const QStringList names = QStringList() << "frame_002.png" << "frame_000.png" << "frame_001.png";
+	for (const auto& name : names)
+	{
+		// The top half is red and the bottom half green
+		QImage image(64, 32, QImage::Format_RGB32);
+		image.fill(Qt::green);
+		for (int y=0; y<16; ++y)
+			for (int x=0; x<64; ++x)
+				image.setPixel(x, y, qRgb(255, 0, 0));
+		QVERIFY(image.save(QDir(sequenceDir).absoluteFilePath(name)));
+	}
+	// Ignored files
+	QFile other(QDir(sequenceDir).absoluteFilePath("readme.txt"));
+	QVERIFY(other.open(QIODevice::WriteOnly));
+	other.close();
+
+	QFile list(dir.absoluteFilePath("frames.txt"));
+	QVERIFY(list.open(QIODevice::WriteOnly | QIODevice::Text));
+	QTextStream out(&list);
+	out << "# Frames of the eclipse\n";
+	out << "2017-08-21T18:00:00Z sequence/frame_001.png\n";
+	out << "\n";
+	out << "2457987.0 sequence/frame_000.png\n";
+	out << "invalid\n";
+	out << "yesterday sequence/frame_002.png\n";
+	out << "2017-08-21T19:00:00Z sequence/frame_002.png\n";
+}
+
+void TestStelVideoSkyLayer::testDirectorySequence()
+{
+	const double startJD = 2451545.;
+	const double timeScale = 60.; // seconds between frames
+	const double step = timeScale/86400.;
+	StelVideoSkyLayer layer(sequenceDir, startJD, timeScale);
+	QVERIFY(layer.isValid());
+	QCOMPARE(layer.framePaths.size(), 3);
+	for (int i=0; i<3; ++i)
+	{
+		QCOMPARE(QFileInfo(layer.framePaths.at(i)).fileName(), QString("frame_%1.png").arg(i, 3, 10, QChar('0')));
+		QVERIFY(qAbs(layer.frameJDs.at(i)-(startJD+i*step)) < ERROR_LIMIT);
+	}
+	// The last frame is shown as long as the others
+	QVERIFY(qAbs(layer.endJD-(startJD+3*step)) < ERROR_LIMIT);
+
+	QCOMPARE(layer.getSequenceFrame(startJD-0.5*step), -1);
+	QCOMPARE(layer.getSequenceFrame(startJD), 0);
+	QCOMPARE(layer.getSequenceFrame(startJD+0.5*step), 0);
+	QCOMPARE(layer.getSequenceFrame(startJD+1.5*step), 1);
+	QCOMPARE(layer.getSequenceFrame(startJD+2.5*step), 2);
+	QCOMPARE(layer.getSequenceFrame(startJD+3.5*step), -1);
+}
+
+void TestStelVideoSkyLayer::testFrameList()
+{
+	StelVideoSkyLayer layer(QDir(tempDir.path()).absoluteFilePath("frames.txt"), 0.);
+	QVERIFY(layer.isValid());
+	// The comments, the empty and the invalid lines are skipped, the frames are sorted by date
+	QCOMPARE(layer.framePaths.size(), 3);
+	const double JDs[3] = {2457987.0, 2457987.25, 2457987.25+1./24.};
+	for (int i=0; i<3; ++i)
+	{
+		QCOMPARE(QFileInfo(layer.framePaths.at(i)).fileName(), QString("frame_%1.png").arg(i, 3, 10, QChar('0')));
+		QVERIFY(QFileInfo(layer.framePaths.at(i)).exists());
+		QVERIFY2(qAbs(layer.frameJDs.at(i)-JDs[i]) < ERROR_LIMIT, qPrintable(QString("frame %1 JD=%2 expected %3").arg(i).arg(layer.frameJDs.at(i), 0, 'f', 6).arg(JDs[i], 0, 'f', 6)));
+	}
+	// Irregular intervals: each frame is shown until the next one, the last one as long as the previous one
+	QVERIFY(qAbs(layer.endJD-(JDs[2]+1./24.)) < ERROR_LIMIT);
+	QCOMPARE(layer.getSequenceFrame(JDs[0]-0.01), -1);
+	QCOMPARE(layer.getSequenceFrame(JDs[0]+0.2), 0);
+	QCOMPARE(layer.getSequenceFrame(JDs[1]), 1);
+	QCOMPARE(layer.getSequenceFrame(JDs[2]+0.5/24.), 2);
+	QCOMPARE(layer.getSequenceFrame(JDs[2]+1.5/24.), -1);
+}
+
+void TestStelVideoSkyLayer::testEmptySequence()
+{
+	QDir dir(tempDir.path());
+	QVERIFY(dir.mkdir("empty"));
+	StelVideoSkyLayer layer(dir.absoluteFilePath("empty"), 2451545.);
+	QVERIFY(!layer.isValid());
+	QCOMPARE(layer.getSequenceFrame(2451545.), -1);
+}
+
+void TestStelVideoSkyLayer::testDecodeImage()
+{
+	// The frames are reduced to the maximal texture size and flipped for OpenGL
+	const StelVideoSkyLayer::DecodedFrame frame = StelVideoSkyLayer::decodeImage(QDir(sequenceDir).absoluteFilePath("frame_000.png"), 16);
+	QCOMPARE(frame.image.size(), QSize(16, 8));
+	QCOMPARE(frame.image.format(), QImage::Format_RGBA8888);
+	QCOMPARE(QColor(frame.image.pixel(8, 0)), QColor(Qt::green));
+	QCOMPARE(QColor(frame.image.pixel(8, 7)), QColor(Qt::red));
+
+	const StelVideoSkyLayer::DecodedFrame missing = StelVideoSkyLayer::decodeImage(QDir(sequenceDir).absoluteFilePath("missing.png"), 16);
+	QVERIFY(missing.image.isNull());
+}
@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Converter from spherical and fisheye landscapes
+# to tiled (HiPS layout) landscapes.
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = landscapeTiler
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../src/core/
+
+SOURCES += main.cpp \
+    ../../src/core/StelIniParser.cpp \
+    ../../src/core/healpix.c
+
+HEADERS += \
+    ../../src/core/StelIniParser.hpp
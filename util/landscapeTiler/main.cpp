@@ -0,0 +1,407 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+// Build the tile pyramid of a "tiled" landscape from an existing spherical or fisheye landscape.
+// Usage: landscapeTiler <sourceLandscapeDir> <outputLandscapeDir> [tileWidth=512] [maxOrder=auto]
+// The output directory receives a landscape.ini of type tiled, the tiles/ (and tiles_illum/) pyramids
+// in HiPS layout (NorderK/DirD/NpixN.png) and a small opacity.png used for opacity queries.
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QBitArray>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QSettings>
+#include <QTextStream>
+#include <QtMath>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+#include "StelIniParser.hpp"
+
+extern "C" {
+	void healpix_get_mat3(int nside, int pix, double out[3][3]);
+	void healpix_pix2vec(int nside, int pix, double out[3]);
+	void healpix_xy2vec(const double xy[2], double out[3]);
+}
+
+// Size of the equirectangular opacity map.
+static const int OPACITY_WIDTH = 1024;
+// Memory used for the decoded strips of the source image [bytes].
+static const qint64 STRIP_MEMORY = 512*1024*1024;
+
+// Maps directions in the alt-azimuthal frame to pixels of the source panorama.
+// The source image is never loaded as a whole: it is decoded in horizontal strips with QImageReader::setClipRect(),
+// so that panoramas larger than what fits in a QImage can be converted.
+class SourcePano
+{
+public:
+	enum Type { Spherical, Fisheye };
+
+	bool load(const QSettings& ini, const QString& dir, const QString& key)
+	{
+		const QString fileName = ini.value("landscape/" + key).toString();
+		if (fileName.isEmpty())
+			return false;
+		path = dir + "/" + fileName;
+		QImageReader reader(path);
+		size = reader.size();
+		if (!reader.canRead() || !size.isValid())
+		{
+			qWarning() << "Cannot read" << path << reader.errorString();
+			return false;
+		}
+		// Two strips are kept decoded, for the tiles which lie across a strip boundary.
+		stripHeight = static_cast<int>(qBound(static_cast<qint64>(16), STRIP_MEMORY/2/(4*static_cast<qint64>(size.width())), static_cast<qint64>(size.height())));
+		stripIndex[0] = stripIndex[1] = -1;
+		type = ini.value("landscape/type").toString()=="fisheye" ? Fisheye : Spherical;
+		angleRotateZ = ini.value("landscape/angle_rotatez", 0.).toDouble()*M_PI/180.;
+		texFov = ini.value("landscape/texturefov", 360.).toDouble()*M_PI/180.;
+		const QString suffix = (key=="maptex" ? "" : key.mid(6)); // maptex_illum -> _illum
+		top = ini.value("landscape/maptex" + suffix + "_top", 90.).toDouble()/90.;
+		bottom = ini.value("landscape/maptex" + suffix + "_bottom", -90.).toDouble()/90.;
+		return true;
+	}
+
+	// Angular resolution of the source image [pixels per radian]
+	double pixelsPerRadian() const
+	{
+		return type==Spherical ? size.width()/(2.*M_PI) : size.height()/texFov;
+	}
+
+	// Same mapping as used in LandscapeSpherical::getOpacity() and LandscapeFisheye::getOpacity().
+	// Returns QPoint(-1, -1) if the direction is not covered by the source image.
+	QPoint project(const double v[3]) const
+	{
+		const double lng = std::atan2(v[1], v[0]);
+		const double alt = std::asin(qBound(-1., v[2], 1.));
+		const int w = size.width(), h = size.height();
+		if (type==Spherical)
+		{
+			const double altPm1 = 2.*alt/M_PI;
+			if (altPm1>top || altPm1<bottom)
+				return QPoint(-1, -1);
+			const double yImg = (altPm1-bottom)/(top-bottom);
+			double az = (M_PI-lng)/M_PI - 0.5 - angleRotateZ/M_PI;
+			az = std::fmod(az, 2.);
+			if (az<0) az+=2.;
+			return QPoint(qBound(0, static_cast<int>(az*0.5*w), w-1), qBound(0, static_cast<int>((1.-yImg)*h), h-1));
+		}
+		if (M_PI_2-alt > texFov/2.)
+			return QPoint(-1, -1);
+		const double radius = (M_PI_2-alt)*2./texFov;
+		const double az = (M_PI-lng) - angleRotateZ;
+		return QPoint(qBound(0, static_cast<int>(h/2*(1. + radius*std::sin(az))), w-1),
+			      qBound(0, static_cast<int>(h/2*(1. + radius*std::cos(az))), h-1));
+	}
+
+	// Read the source pixels at the given positions (see project()) into out.
+	// The positions are visited from top to bottom, so that each strip is decoded at most once per call.
+	void sample(const QVector<QPoint>& pos, QRgb* out)
+	{
+		QVector<int> order(pos.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&pos](int a, int b) {return pos.at(a).y()<pos.at(b).y();});
+		for (int i : order)
+		{
+			const QPoint& p = pos.at(i);
+			if (p.y()<0)
+			{
+				out[i] = qRgba(0, 0, 0, 0);
+				continue;
+			}
+			const QImage& strip = getStrip(p.y()/stripHeight);
+			out[i] = reinterpret_cast<const QRgb*>(strip.constScanLine(p.y()%stripHeight))[p.x()];
+		}
+	}
+
+private:
+	const QImage& getStrip(int index)
+	{
+		if (stripIndex[0]!=index)
+		{
+			if (stripIndex[1]!=index)
+			{
+				const QRect rect(0, index*stripHeight, size.width(), qMin(stripHeight, size.height()-index*stripHeight));
+				QImageReader reader(path);
+				reader.setClipRect(rect);
+				strips[1] = reader.read().convertToFormat(QImage::Format_ARGB32);
+				if (strips[1].isNull())
+				{
+					qWarning() << "Cannot read rows" << rect.top() << "to" << rect.bottom() << "of" << path << reader.errorString();
+					strips[1] = QImage(rect.size(), QImage::Format_ARGB32);
+					strips[1].fill(Qt::transparent);
+				}
+				stripIndex[1] = index;
+			}
+			std::swap(strips[0], strips[1]);
+			std::swap(stripIndex[0], stripIndex[1]);
+		}
+		return strips[0];
+	}
+
+	Type type = Spherical;
+	QString path;
+	QSize size;
+	int stripHeight = 0;
+	QImage strips[2];
+	int stripIndex[2] = {-1, -1};
+	double angleRotateZ = 0.;
+	double texFov = 2.*M_PI;
+	double top = 1.;
+	double bottom = -1.;
+};
+
+static QString tilePath(const QString& outDir, int order, int pix)
+{
+	return QString("%1/Norder%2/Dir%3/Npix%4.png").arg(outDir).arg(order).arg((pix/10000)*10000).arg(pix);
+}
+
+static bool saveTile(const QImage& tile, const QString& outDir, int order, int pix)
+{
+	QDir().mkpath(QString("%1/Norder%2/Dir%3").arg(outDir).arg(order).arg((pix/10000)*10000));
+	if (!tile.save(tilePath(outDir, order, pix)))
+	{
+		qWarning() << "Cannot write tile" << order << pix;
+		return false;
+	}
+	return true;
+}
+
+static bool isTransparent(const QImage& tile)
+{
+	for (int y=0; y<tile.height(); ++y)
+	{
+		const QRgb* line = reinterpret_cast<const QRgb*>(tile.constScanLine(y));
+		for (int x=0; x<tile.width(); ++x)
+		{
+			if (qAlpha(line[x]))
+				return false;
+		}
+	}
+	return true;
+}
+
+// Build a tile from its four children of the next order, which have already been written.
+static QImage mergeChildren(const QString& outDir, int order, int pix, const QBitArray& childWritten, int tileWidth)
+{
+	const int half = tileWidth/2;
+	QImage tile(tileWidth, tileWidth, QImage::Format_ARGB32);
+	tile.fill(Qt::transparent);
+	for (int i=0; i<4; ++i)
+	{
+		const int child = 4*pix + i;
+		if (!childWritten.testBit(child))
+			continue;
+		const QImage image = QImage(tilePath(outDir, order+1, child)).scaled(half, half, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+					.convertToFormat(QImage::Format_ARGB32);
+		// In the nested scheme, bit 0 of the child number selects the half along the tile rows
+		// and bit 1 the half along the columns (see healpix_get_mat3()).
+		const int x0 = (i>>1)*half, y0 = (i&1)*half;
+		for (int y=0; y<half && y<image.height(); ++y)
+			memcpy(tile.scanLine(y0+y) + 4*x0, image.constScanLine(y), static_cast<size_t>(4*qMin(half, image.width())));
+	}
+	return tile;
+}
+
+// Write the HiPS pyramid of the given source.
+// Only the tiles of the highest order are sampled from the source image. Each lower order is built by downscaling
+// the tiles of the previous one. Fully transparent tiles are not written: all their children are transparent too,
+// and HipsSurvey does not descend below a tile which cannot be loaded.
+static bool writePyramid(SourcePano& src, const QString& outDir, const QString& title, int tileWidth, int maxOrder)
+{
+	int nside = 1 << maxOrder;
+	int nbPix = 12*nside*nside;
+
+	// Sample the tiles in the order of their position in the source image, so that each strip is decoded about once.
+	QVector<QPair<int, int>> tileRows;
+	tileRows.reserve(nbPix);
+	for (int pix=0; pix<nbPix; ++pix)
+	{
+		double v[3];
+		healpix_pix2vec(nside, pix, v);
+		tileRows.append(qMakePair(src.project(v).y(), pix));
+	}
+	std::sort(tileRows.begin(), tileRows.end());
+
+	QBitArray written(nbPix);
+	int nbWritten = 0;
+	QVector<QPoint> pos(tileWidth*tileWidth);
+	QImage tile(tileWidth, tileWidth, QImage::Format_ARGB32);
+	for (const auto& tileRow : tileRows)
+	{
+		const int pix = tileRow.second;
+		double mat[3][3];
+		healpix_get_mat3(nside, pix, mat);
+		for (int py=0; py<tileWidth; ++py)
+		{
+			for (int px=0; px<tileWidth; ++px)
+			{
+				// Inverse of HipsSurvey::fillArrays(), taking into account that textures are flipped in y on upload.
+				const double a = (py+0.5)/tileWidth, b = (px+0.5)/tileWidth;
+				const double xy[2] = { mat[0][0]*a + mat[1][0]*b + mat[2][0],
+						       mat[0][1]*a + mat[1][1]*b + mat[2][1] };
+				double v[3];
+				healpix_xy2vec(xy, v);
+				pos[py*tileWidth+px] = src.project(v);
+			}
+		}
+		// The scan lines of a 32 bit image are contiguous.
+		src.sample(pos, reinterpret_cast<QRgb*>(tile.bits()));
+		if (isTransparent(tile))
+			continue;
+		if (!saveTile(tile, outDir, maxOrder, pix))
+			return false;
+		written.setBit(pix);
+		++nbWritten;
+	}
+	printf("Order %d done (%d of %d tiles)\n", maxOrder, nbWritten, nbPix);
+
+	for (int order=maxOrder-1; order>=0; --order)
+	{
+		nside = 1 << order;
+		nbPix = 12*nside*nside;
+		QBitArray parentWritten(nbPix);
+		nbWritten = 0;
+		for (int pix=0; pix<nbPix; ++pix)
+		{
+			if (!written.testBit(4*pix) && !written.testBit(4*pix+1) && !written.testBit(4*pix+2) && !written.testBit(4*pix+3))
+				continue;
+			if (!saveTile(mergeChildren(outDir, order, pix, written, tileWidth), outDir, order, pix))
+				return false;
+			parentWritten.setBit(pix);
+			++nbWritten;
+		}
+		written = parentWritten;
+		printf("Order %d done (%d of %d tiles)\n", order, nbWritten, nbPix);
+	}
+
+	QFile properties(outDir + "/properties");
+	if (!properties.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+	QTextStream out(&properties);
+	out << "obs_title = " << title << "\n";
+	out << "dataproduct_type = image\n";
+	out << "hips_version = 1.4\n";
+	out << "hips_frame = horizontal\n";
+	out << "hips_order = " << maxOrder << "\n";
+	out << "hips_order_min = 0\n";
+	out << "hips_tile_width = " << tileWidth << "\n";
+	out << "hips_tile_format = png\n";
+	return true;
+}
+
+// Write the low resolution equirectangular alpha map used by LandscapeTiled::getOpacity().
+static bool writeOpacityMap(SourcePano& src, const QString& fileName)
+{
+	QImage map(OPACITY_WIDTH, OPACITY_WIDTH/2, QImage::Format_Grayscale8);
+	QVector<QPoint> pos(map.width()*map.height());
+	for (int py=0; py<map.height(); ++py)
+	{
+		const double alt = M_PI_2 - (py+0.5)/map.height()*M_PI;
+		for (int px=0; px<map.width(); ++px)
+		{
+			// left edge is North, azimuth counted towards East.
+			const double lng = M_PI - (px+0.5)/map.width()*2.*M_PI;
+			const double v[3] = { std::cos(alt)*std::cos(lng), std::cos(alt)*std::sin(lng), std::sin(alt) };
+			pos[py*map.width()+px] = src.project(v);
+		}
+	}
+	QVector<QRgb> pixels(pos.size());
+	src.sample(pos, pixels.data());
+	for (int py=0; py<map.height(); ++py)
+	{
+		uchar* line = map.scanLine(py);
+		for (int px=0; px<map.width(); ++px)
+			line[px] = static_cast<uchar>(qAlpha(pixels.at(py*map.width()+px)));
+	}
+	return map.save(fileName);
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	const QStringList args = app.arguments();
+	if (args.size()<3)
+	{
+		printf("Usage: landscapeTiler <sourceLandscapeDir> <outputLandscapeDir> [tileWidth=512] [maxOrder=auto]\n");
+		return 1;
+	}
+	const QString srcDir = args.at(1);
+	const QString outDir = args.at(2);
+	const int tileWidth = args.size()>3 ? args.at(3).toInt() : 512;
+	if (tileWidth<2 || tileWidth%2)
+	{
+		qWarning() << "The tile width must be even, found" << tileWidth;
+		return 1;
+	}
+
+	QSettings ini(srcDir + "/landscape.ini", StelIniFormat);
+	const QString type = ini.value("landscape/type").toString();
+	if (type!="spherical" && type!="fisheye")
+	{
+		qWarning() << "Only spherical and fisheye landscapes can be converted, found type" << type;
+		return 1;
+	}
+
+	SourcePano pano;
+	if (!pano.load(ini, srcDir, "maptex"))
+		return 1;
+	// Choose the order so that the tiles have at least the resolution of the source image.
+	int maxOrder = qMax(0, static_cast<int>(std::ceil(std::log2(pano.pixelsPerRadian()*std::sqrt(M_PI/3.)/tileWidth))));
+	if (args.size()>4)
+		maxOrder = args.at(4).toInt();
+
+	QDir().mkpath(outDir);
+	const QString name = ini.value("landscape/name").toString();
+	if (!writePyramid(pano, outDir + "/tiles", name, tileWidth, maxOrder))
+		return 1;
+	if (!writeOpacityMap(pano, outDir + "/opacity.png"))
+		return 1;
+
+	SourcePano illum;
+	const bool hasIllum = illum.load(ini, srcDir, "maptex_illum");
+	if (hasIllum && !writePyramid(illum, outDir + "/tiles_illum", name, tileWidth, maxOrder))
+		return 1;
+
+	// Write the new landscape.ini: keep everything but the image definitions. The rotation is baked into the tiles.
+	QSettings outIni(outDir + "/landscape.ini", StelIniFormat);
+	for (const auto& key : ini.allKeys())
+	{
+		if (key.startsWith("landscape/maptex") || key=="landscape/texturefov" || key=="landscape/angle_rotatez")
+			continue;
+		outIni.setValue(key, ini.value(key));
+	}
+	outIni.setValue("landscape/type", "tiled");
+	outIni.setValue("landscape/tiles", "tiles");
+	outIni.setValue("landscape/opacity_map", "opacity.png");
+	if (hasIllum)
+		outIni.setValue("landscape/tiles_illum", "tiles_illum");
+	outIni.sync();
+
+	// Optional files which are used by all landscape types.
+	for (const auto& fileName : QDir(srcDir).entryList(QStringList() << "gazetteer.*" << "*.txt", QDir::Files))
+		QFile::copy(srcDir + "/" + fileName, outDir + "/" + fileName);
+
+	printf("Tiled landscape with %d orders written to %s\n", maxOrder+1, qPrintable(outDir));
+	return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * Stellarium
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+// Open several view streams of a running Stellarium with the RemoteControl plugin enabled, and measure
+// the frame rate delivered to each client and the time spent capturing the frames in the render thread.
+// Usage: streamClient [url=http://localhost:8090] [clients=4] [seconds=10] [fps=30] [width=640] [format=jpeg]
+// The render thread overhead is computed from /api/stream/status before and after the measurement.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTextStream>
+#include <QTimer>
+#include <QUrlQuery>
+#include <QVector>
+
+// Count the parts of a multipart/x-mixed-replace stream, relying on their Content-Length headers.
+class StreamCounter : public QObject
+{
+public:
+	StreamCounter(QNetworkReply* reply) : reply(reply), frames(0), bytes(0), remaining(0)
+	{
+		connect(reply, &QNetworkReply::readyRead, this, [this]() { read(); });
+	}
+
+	QNetworkReply* reply;
+	int frames;
+	qint64 bytes;
+
+private:
+	void read()
+	{
+		buffer.append(reply->readAll());
+		forever
+		{
+			if (remaining>0)
+			{
+				const int n = static_cast<int>(qMin<qint64>(remaining, buffer.size()));
+				buffer.remove(0, n);
+				remaining -= n;
+				if (remaining>0)
+					return;
+				++frames;
+			}
+			const int headerEnd = buffer.indexOf("\r\n\r\n");
+			if (headerEnd<0)
+				return;
+			const QByteArray header = buffer.left(headerEnd).toLower();
+			buffer.remove(0, headerEnd+4);
+			const int lengthPos = header.indexOf("content-length:");
+			if (lengthPos<0)
+				continue;
+			int lineEnd = header.indexOf("\r\n", lengthPos);
+			if (lineEnd<0)
+				lineEnd = header.size();
+			remaining = header.mid(lengthPos+15, lineEnd-lengthPos-15).trimmed().toLongLong();
+			bytes += remaining;
+		}
+	}
+
+	QByteArray buffer;
+	qint64 remaining;
+};
+
+static QJsonObject getStatus(QNetworkAccessManager& manager, const QUrl& baseUrl)
+{
+	QNetworkReply* reply = manager.get(QNetworkRequest(baseUrl.resolved(QUrl("/api/stream/status"))));
+	QEventLoop loop;
+	QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+	loop.exec();
+	const QJsonObject status = QJsonDocument::fromJson(reply->readAll()).object();
+	if (reply->error()!=QNetworkReply::NoError)
+		qFatal("Could not get the stream status: %s", qPrintable(reply->errorString()));
+	reply->deleteLater();
+	return status;
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	const QStringList args = app.arguments();
+	const QUrl baseUrl(args.size()>1 ? args.at(1) : QString("http://localhost:8090"));
+	const int clientCount = args.size()>2 ? args.at(2).toInt() : 4;
+	const int seconds = args.size()>3 ? args.at(3).toInt() : 10;
+	const QString fps = args.size()>4 ? args.at(4) : QString("30");
+	const QString width = args.size()>5 ? args.at(5) : QString("640");
+	const QString format = args.size()>6 ? args.at(6) : QString("jpeg");
+	if (clientCount<1 || seconds<1)
+		qFatal("Usage: streamClient [url] [clients] [seconds] [fps] [width] [format]");
+
+	QNetworkAccessManager manager;
+	const QJsonObject before = getStatus(manager, baseUrl);
+
+	QUrl streamUrl = baseUrl.resolved(QUrl("/api/stream/mjpeg"));
+	QUrlQuery query;
+	query.addQueryItem("fps", fps);
+	query.addQueryItem("width", width);
+	query.addQueryItem("format", format);
+	streamUrl.setQuery(query);
+
+	// A QNetworkAccessManager opens at most 6 connections per host, so use one for each client
+	QVector<StreamCounter*> counters;
+	for (int i=0; i<clientCount; ++i)
+	{
+		QNetworkAccessManager* clientManager = new QNetworkAccessManager(&app);
+		counters << new StreamCounter(clientManager->get(QNetworkRequest(streamUrl)));
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	QTimer::singleShot(seconds*1000, &app, &QCoreApplication::quit);
+	app.exec();
+	const double elapsed = timer.elapsed()/1000.;
+
+	// Measure while the streams are still open, so that all the captures are accounted for
+	const QJsonObject after = getStatus(manager, baseUrl);
+
+	QTextStream out(stdout);
+	int totalFrames = 0;
+	for (int i=0; i<counters.size(); ++i)
+	{
+		const StreamCounter* counter = counters.at(i);
+		if (counter->reply->error()!=QNetworkReply::NoError)
+			out << "client " << i << ": " << counter->reply->errorString() << "\n";
+		else
+			out << "client " << i << ": " << counter->frames << " frames, " << counter->frames/elapsed << " fps, "
+			    << (counter->frames ? counter->bytes/counter->frames/1024 : 0) << " KiB/frame\n";
+		totalFrames += counter->frames;
+		counter->reply->abort();
+	}
+
+	const double captureCalls = after.value("captureCalls").toDouble()-before.value("captureCalls").toDouble();
+	const double captureTime = after.value("captureTime").toDouble()-before.value("captureTime").toDouble();
+	const double frames = after.value("frames").toDouble()-before.value("frames").toDouble();
+	out << "delivered: " << totalFrames/elapsed << " fps in total, " << totalFrames/elapsed/clientCount << " fps per client\n";
+	out << "captured: " << frames/elapsed << " fps, " << after.value("skippedFrames").toDouble()-before.value("skippedFrames").toDouble()
+	    << " skipped, " << (after.value("asyncReadback").toBool() ? "asynchronous" : "synchronous") << " readback\n";
+	out << "render thread: " << (captureCalls>0 ? captureTime/captureCalls : 0.) << " ms per rendered frame on average, "
+	    << after.value("maxCaptureTime").toDouble() << " ms at most\n";
+	out.flush();
+
+	qDeleteAll(counters);
+	return 0;
+}
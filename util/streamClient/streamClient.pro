@@ -0,0 +1,17 @@
+#-------------------------------------------------
+#
+# Test client for the RemoteControl view streams,
+# measuring the delivered frame rates.
+#
+#-------------------------------------------------
+
+QT       += core network
+QT       -= gui
+
+TARGET = streamClient
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += main.cpp